@@ -9,8 +9,10 @@
 
 #include "../core/plugin.hpp"
 #include "../core/json.hpp"
+#include "../core/shared_text.hpp"
 #include <string>
 #include <vector>
+#include <map>
 #include <functional>
 
 namespace openclaw {
@@ -25,32 +27,73 @@ enum class MessageRole {
 std::string role_to_string(MessageRole role);
 MessageRole string_to_role(const std::string& str);
 
-// A message in a conversation
+// A tool call made by the model through the provider's native tool-use API
+struct ToolUse {
+    std::string id;           // Provider-assigned, echoed back by the result
+    std::string name;
+    Json input;               // Arguments object
+};
+
+// Result sent back for one ToolUse
+struct ToolResultBlock {
+    std::string tool_use_id;
+    SharedText content;
+    bool is_error;
+    
+    ToolResultBlock() : is_error(false) {}
+    ToolResultBlock(const std::string& id, SharedText c, bool error)
+        : tool_use_id(id), content(std::move(c)), is_error(error) {}
+};
+
+// A message in a conversation. Content buffers are shared, so copying a
+// history (or a message into a request) does not copy large tool output.
 struct ConversationMessage {
     MessageRole role;
-    std::string content;
+    SharedText content;
+    
+    // Native tool use: an assistant message's calls (content holds the text
+    // part) and a user message's results (content holds a text rendering)
+    std::vector<ToolUse> tool_uses;
+    std::vector<ToolResultBlock> tool_results;
     
-    ConversationMessage() : role(MessageRole::USER) {}
-    ConversationMessage(MessageRole r, const std::string& c) : role(r), content(c) {}
+    // Cached TokenEstimator::count_text(content); recomputed when the
+    // content length no longer matches
+    mutable int token_estimate;
+    mutable size_t token_estimate_size;
     
-    static ConversationMessage system(const std::string& content) {
-        return ConversationMessage(MessageRole::SYSTEM, content);
+    ConversationMessage() : role(MessageRole::USER), token_estimate(-1), token_estimate_size(0) {}
+    ConversationMessage(MessageRole r, SharedText c)
+        : role(r), content(std::move(c)), token_estimate(-1), token_estimate_size(0) {}
+    
+    static ConversationMessage system(SharedText content) {
+        return ConversationMessage(MessageRole::SYSTEM, std::move(content));
     }
-    static ConversationMessage user(const std::string& content) {
-        return ConversationMessage(MessageRole::USER, content);
+    static ConversationMessage user(SharedText content) {
+        return ConversationMessage(MessageRole::USER, std::move(content));
     }
-    static ConversationMessage assistant(const std::string& content) {
-        return ConversationMessage(MessageRole::ASSISTANT, content);
+    static ConversationMessage assistant(SharedText content) {
+        return ConversationMessage(MessageRole::ASSISTANT, std::move(content));
     }
 };
 
+// True if the native tool blocks of messages[index] can be sent as such:
+// the tool_use message is directly followed by the matching tool_result
+// message. History trimming can break pairs; those go as plain text.
+bool tool_blocks_paired(const std::vector<ConversationMessage>& messages, size_t index);
+
+// Text-only rendering of an assistant message with tool_uses
+std::string tool_uses_as_text(const ConversationMessage& msg);
+
 // Usage stats from API response
 struct UsageStats {
     int input_tokens;
     int output_tokens;
     int total_tokens;
+    int cache_read_tokens;    // Prompt tokens served from the provider's cache
+    int cache_write_tokens;   // Prompt tokens written to the cache by this call
     
-    UsageStats() : input_tokens(0), output_tokens(0), total_tokens(0) {}
+    UsageStats() : input_tokens(0), output_tokens(0), total_tokens(0),
+                   cache_read_tokens(0), cache_write_tokens(0) {}
 };
 
 // Result of an AI completion request
@@ -60,7 +103,12 @@ struct CompletionResult {
     std::string error;        // Error message if failed
     std::string stop_reason;  // Why the model stopped (end_turn, max_tokens, etc.)
     std::string model;        // Model that was used
+    std::vector<ToolUse> tool_uses;   // Native tool calls (CompletionOptions::tools)
     UsageStats usage;
+    long http_status;         // Provider's HTTP status (0 = no response)
+    std::map<std::string, std::string> response_headers;   // For rate-limit accounting
+    
+    CompletionResult() : success(false), http_status(0) {}
     
     static CompletionResult ok(const std::string& text) {
         CompletionResult r;
@@ -77,20 +125,68 @@ struct CompletionResult {
     }
 };
 
+// Fast approximate tokenizer for context budgeting. Counts word, number,
+// punctuation and whitespace runs the way BPE vocabularies usually split
+// them; scale adapts the result to a provider's tokenizer. Errs high.
+class TokenEstimator {
+public:
+    explicit TokenEstimator(double scale = 1.0, int per_message_overhead = 4)
+        : scale_(scale), per_message_overhead_(per_message_overhead) {}
+    
+    // Provider-neutral estimate
+    static int count_text(const std::string& text);
+    
+    int count(const std::string& text) const;
+    int count(const ConversationMessage& msg) const;     // Cached on msg
+    int count(const std::vector<ConversationMessage>& messages) const;
+    
+private:
+    double scale_;
+    int per_message_overhead_;    // Role markers and separators
+};
+
 // Callback for streaming responses
 typedef std::function<void(const std::string& chunk)> StreamCallback;
 
+// Callback for asynchronous completions
+typedef std::function<void(const CompletionResult& result)> CompletionCallback;
+
+// A tool offered to the model through the provider's native tool-use API
+struct ToolSpec {
+    std::string name;
+    std::string description;
+    Json input_schema;        // JSON Schema of the arguments object
+};
+
 // AI completion options
 struct CompletionOptions {
     std::string model;           // Model to use (empty = provider default)
+    std::string tools_prompt;    // Tool instructions, sent ahead of system_prompt
     std::string system_prompt;   // System prompt/instructions
     int max_tokens;              // Max tokens to generate (0 = default)
     double temperature;          // Sampling temperature (0-1)
     bool stream;                 // Enable streaming
-    StreamCallback on_chunk;     // Called for each chunk when streaming
+    StreamCallback on_chunk;     // Called for each text delta when streaming; with
+                                 // chat_async() it runs on the HTTP engine thread
+    bool cache_prompt;           // Let the provider cache the stable prompt prefix
+    bool cache_response;         // Answer byte-identical requests from the CompletionCache
+                                 // (deterministic calls only; see completion_cache.hpp)
+    bool batch;                  // chat_async() through the provider's batch API when
+                                 // supports_batch(): cheaper and outside interactive rate
+                                 // limits, but results may take minutes (no streaming)
+    std::vector<ToolSpec> tools; // Native tool definitions (needs supports_native_tools())
     
     CompletionOptions() 
-        : max_tokens(4096), temperature(0.7), stream(false) {}
+        : max_tokens(4096), temperature(0.7), stream(false), cache_prompt(true),
+          cache_response(false), batch(false) {}
+    
+    // tools_prompt and system_prompt as one string, for providers that
+    // have no use for the split
+    std::string full_system_prompt() const {
+        if (tools_prompt.empty()) return system_prompt;
+        if (system_prompt.empty()) return tools_prompt;
+        return tools_prompt + "\n\n" + system_prompt;
+    }
 };
 
 // Abstract AI provider plugin interface
@@ -98,6 +194,9 @@ class AIPlugin : public Plugin {
 public:
     virtual ~AIPlugin() {}
     
+    // Providers work on request
+    virtual int poll_interval_ms() const { return 0; }
+    
     // Get the provider identifier (e.g., "claude", "openai")
     virtual std::string provider_id() const = 0;
     
@@ -119,9 +218,41 @@ public:
         const CompletionOptions& opts = CompletionOptions()
     ) = 0;
     
+    // Asynchronous variant of chat(). messages and opts are only read before
+    // this returns; on_done runs later, possibly on the HTTP engine thread,
+    // and must not block. The default falls back to the blocking chat().
+    virtual void chat_async(
+        const std::vector<ConversationMessage>& messages,
+        const CompletionOptions& opts,
+        CompletionCallback on_done
+    ) {
+        CompletionResult result = chat(messages, opts);
+        if (on_done) on_done(result);
+    }
+    
     // Check if the provider is properly configured
     virtual bool is_configured() const = 0;
     
+    // Context window of a model in tokens (empty = default model).
+    // 0 means unknown, which disables proactive history budgeting.
+    virtual int context_window(const std::string& model = "") const {
+        (void)model;
+        return 0;
+    }
+    
+    // Token estimator tuned to this provider's tokenizer
+    virtual TokenEstimator token_estimator() const {
+        return TokenEstimator();
+    }
+    
+    // Whether CompletionOptions::tools are sent as native tool definitions
+    // and tool calls come back in CompletionResult::tool_uses
+    virtual bool supports_native_tools() const { return false; }
+    
+    // Whether chat_async() honours CompletionOptions::batch; providers
+    // without a batch endpoint send such calls the normal way
+    virtual bool supports_batch() const { return false; }
+    
     // Handle an incoming chat message (adds to session, calls AI, returns response)
     // Returns the AI response text, or error message prefixed with error emoji
     virtual std::string handle_message(const std::string& user_text,
@@ -0,0 +1,121 @@
+/*
+ * OpenClaw C++11 - Completion Cache
+ *
+ * Exact-match response cache for deterministic AI calls. Summaries, skills
+ * and low-temperature complete() calls often send byte-identical requests;
+ * those that set CompletionOptions::cache_response are answered from here
+ * instead of the provider.
+ *
+ * Features:
+ * - Keyed by SHA-256 of provider, model, prompts, generation options,
+ *   tool definitions and the full message list
+ * - Size-bounded LRU in memory
+ * - Optional SQLite tier that survives restarts, with an entry cap; its
+ *   writes go to the thread pool's LOW lane
+ * - A TTL both tiers honor
+ * - Hit/miss counters per tier
+ * - Only successful results are stored; usage is zero on a hit
+ */
+#ifndef OPENCLAW_AI_COMPLETION_CACHE_HPP
+#define OPENCLAW_AI_COMPLETION_CACHE_HPP
+
+#include "ai.hpp"
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+struct sqlite3;
+
+namespace openclaw {
+
+class ThreadPool;
+
+class CompletionCache {
+public:
+    struct Config {
+        size_t memory_bytes;        // LRU budget (0 = no memory tier)
+        std::string db_path;        // SQLite tier (empty = none)
+        int64_t ttl_seconds;        // Entries older than this are misses (0 = forever)
+        size_t max_disk_entries;    // Oldest-used entries go beyond this
+
+        Config() : memory_bytes(16 << 20), ttl_seconds(86400), max_disk_entries(10000) {}
+    };
+
+    struct Stats {
+        uint64_t memory_hits;
+        uint64_t disk_hits;
+        uint64_t misses;
+        uint64_t stores;
+        uint64_t evictions;
+        size_t entries;
+        size_t bytes;
+
+        Stats() : memory_hits(0), disk_hits(0), misses(0), stores(0), evictions(0),
+                  entries(0), bytes(0) {}
+    };
+
+    static CompletionCache& instance();
+
+    CompletionCache();
+    ~CompletionCache();
+
+    // Apply limits and open the disk tier if configured. Disk writes run
+    // on pool's LOW lane, or on the caller without a pool.
+    bool configure(const Config& config, ThreadPool* pool = nullptr);
+    void close();
+
+    // ai->chat / chat_async / complete through the cache when
+    // opts.cache_response is set, straight to the provider otherwise
+    CompletionResult chat(AIPlugin* ai, const std::vector<ConversationMessage>& messages,
+                          const CompletionOptions& opts);
+    void chat_async(AIPlugin* ai, const std::vector<ConversationMessage>& messages,
+                    const CompletionOptions& opts, CompletionCallback on_done);
+    CompletionResult complete(AIPlugin* ai, const std::string& prompt, const CompletionOptions& opts);
+
+    // Cache key of a request
+    static std::string key(const AIPlugin& ai, const std::vector<ConversationMessage>& messages,
+                           const CompletionOptions& opts);
+
+    bool lookup(const std::string& key, CompletionResult& out);
+    void store(const std::string& key, const CompletionResult& result);
+    void clear();
+
+    Stats stats() const;
+
+private:
+    CompletionCache(const CompletionCache&);
+    CompletionCache& operator=(const CompletionCache&);
+
+    struct Entry {
+        std::string key;
+        CompletionResult result;
+        size_t bytes;
+        int64_t created;            // Unix seconds the result was first stored
+    };
+    typedef std::list<Entry> Lru;
+
+    static size_t entry_bytes(const std::string& key, const CompletionResult& result);
+    void insert_locked(const std::string& key, const CompletionResult& result, int64_t created);
+    bool disk_lookup(const std::string& key, CompletionResult& out, int64_t& created);
+    void disk_store(const std::string& key, const CompletionResult& result);
+
+    Config config_;
+    ThreadPool* pool_;
+
+    Lru lru_;                                       // Most recently used first
+    std::unordered_map<std::string, Lru::iterator> index_;
+    size_t bytes_;
+    Stats counters_;
+    mutable std::mutex mutex_;
+
+    sqlite3* db_;
+    uint64_t disk_stores_;                          // For periodic pruning
+    std::mutex db_mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_AI_COMPLETION_CACHE_HPP
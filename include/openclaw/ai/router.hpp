@@ -0,0 +1,153 @@
+/*
+ * OpenClaw C++11 - AI Provider Router
+ *
+ * An AIPlugin that spreads chat calls over the registered providers
+ * (Claude, llama.cpp, ...) by measured health instead of always using the
+ * first one. Tail latency mostly comes from an occasional stalled
+ * upstream, so a call that has not produced its first byte by the
+ * backend's p95 can be duplicated to the next backend.
+ *
+ * Features:
+ * - Per-backend EWMA latency and error rate; calls go to the best backend
+ *   whose circuit is closed and whose provider budget is not blocked
+ * - Failover to the next backend on transport errors, 5xx and 429/529
+ * - Circuit breaker: a backend failing repeatedly sits out a cooldown
+ * - Optional hedging from the timer wheel once the primary passes its
+ *   p95 time to first byte; the first answer wins
+ * - Reserves ProviderBudget tokens per backend when given a budget
+ * - Batch calls prefer batch-capable backends and skip hedging and budget
+ */
+#ifndef OPENCLAW_AI_ROUTER_HPP
+#define OPENCLAW_AI_ROUTER_HPP
+
+#include "ai.hpp"
+#include "../core/timer_wheel.hpp"
+#include "../core/snapshot.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace openclaw {
+
+class ProviderBudget;
+
+class AIRouter : public AIPlugin {
+public:
+    struct Settings {
+        bool hedge;                 // Duplicate stalled calls to a second backend
+        int64_t hedge_min_ms;       // Never hedge earlier than this
+        size_t hedge_min_samples;   // TTFB samples needed before hedging a backend
+        int failure_threshold;      // Consecutive failures that open the circuit
+        int64_t cooldown_ms;        // How long an open circuit skips the backend
+
+        Settings()
+            : hedge(true)
+            , hedge_min_ms(1500)
+            , hedge_min_samples(16)
+            , failure_threshold(3)
+            , cooldown_ms(30000) {}
+
+        // Read ai_router.* keys
+        static Settings from_config(const Config& cfg);
+    };
+
+    // Health of one backend, for /status
+    struct BackendStats {
+        std::string provider;
+        double latency_ms;          // EWMA of complete calls
+        double error_rate;          // EWMA of retryable failures (0..1)
+        int64_t p95_ttfb_ms;        // 0 = not enough samples
+        uint64_t calls;
+        uint64_t hedges;            // Calls this backend was hedged to
+        bool open;                  // Circuit open (cooling down)
+    };
+
+    AIRouter();
+    ~AIRouter();
+
+    // Backends in order of preference; ties in health go to the earlier one
+    void add_backend(AIPlugin* ai);
+    size_t backend_count() const;
+
+    // Takes effect for calls started afterwards
+    void set_settings(const Settings& settings) { settings_.set(settings); }
+    Snapshot<Settings>::Ptr settings() const { return settings_.get(); }
+
+    // Reserve provider tokens per backend call (the agent's own budget
+    // only sees the router's provider id)
+    void set_budget(ProviderBudget* budget) { budget_ = budget; }
+
+    std::vector<BackendStats> stats() const;
+
+    // Plugin
+    const char* name() const override { return "router"; }
+    const char* version() const override { return "1.0.0"; }
+    const char* description() const override { return "Routes AI calls across providers by latency and health"; }
+    bool init(const Config& cfg) override;
+    void reconfigure(const Config& cfg) override;
+    void shutdown() override;
+
+    // AIPlugin
+    std::string provider_id() const override { return "router"; }
+    std::vector<std::string> available_models() const override;
+    std::string default_model() const override;
+    CompletionResult complete(const std::string& prompt,
+                              const CompletionOptions& opts = CompletionOptions()) override;
+    CompletionResult chat(const std::vector<ConversationMessage>& messages,
+                          const CompletionOptions& opts = CompletionOptions()) override;
+    void chat_async(const std::vector<ConversationMessage>& messages,
+                    const CompletionOptions& opts,
+                    CompletionCallback on_done) override;
+    bool is_configured() const override;
+    int context_window(const std::string& model = "") const override;
+    TokenEstimator token_estimator() const override;
+    bool supports_native_tools() const override;
+    bool supports_batch() const override;
+
+private:
+    AIRouter(const AIRouter&);
+    AIRouter& operator=(const AIRouter&);
+
+    static const size_t TTFB_SAMPLES = 64;
+
+    struct Backend {
+        AIPlugin* ai;
+        double latency_ms;
+        double error_rate;
+        int failures;                   // Consecutive retryable failures
+        int64_t open_until_ms;
+        std::vector<int64_t> ttfb;      // Ring of recent times to first byte
+        size_t ttfb_next;
+        uint64_t calls;
+        uint64_t hedges;
+
+        Backend() : ai(nullptr), latency_ms(0), error_rate(0), failures(0), open_until_ms(0),
+                    ttfb_next(0), calls(0), hedges(0) {}
+    };
+
+    // One routed chat_async call (defined in router.cpp)
+    struct Call;
+    typedef std::shared_ptr<Call> CallPtr;
+
+    // Backend indexes, best first
+    std::vector<size_t> ranked() const;
+    int64_t p95_ttfb_locked(const Backend& b) const;
+    void record(size_t index, const CompletionResult& result, int64_t latency_ms, int64_t ttfb_ms);
+    static bool retryable(const CompletionResult& result);
+
+    void launch(CallPtr call);
+    void on_attempt_done(CallPtr call, size_t attempt, const CompletionResult& result);
+    void on_hedge_timer(CallPtr call);
+
+    std::vector<Backend> backends_;
+    Snapshot<Settings> settings_;
+    ProviderBudget* budget_;
+    TimerWheel& wheel_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_AI_ROUTER_HPP
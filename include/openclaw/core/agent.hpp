@@ -19,17 +19,29 @@
 
 #include "json.hpp"
 #include "logger.hpp"
+#include "trace.hpp"
+#include "shared_text.hpp"
+#include "file_view.hpp"
 #include <string>
 #include <vector>
 #include <map>
+#include <list>
+#include <memory>
 #include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 namespace openclaw {
 
 // Forward declarations
 class AIPlugin;
+class ThreadPool;
+class ProviderBudget;
 struct CompletionOptions;
+struct CompletionResult;
 struct ConversationMessage;
+struct ToolSpec;
 
 // ============================================================================
 // Tool Definition
@@ -54,6 +66,7 @@ struct AgentToolResult {
     std::string output;     // Text output to show AI
     std::string error;      // Error message if failed
     bool should_continue;   // Whether the agent should continue (default true)
+    FileSlice full;         // Set: the complete result, of which output is a preview
     
     AgentToolResult() : success(false), should_continue(true) {}
     
@@ -83,16 +96,23 @@ struct AgentToolResult {
 // Tool execution function type
 typedef std::function<AgentToolResult(const Json& params)> ToolExecutor;
 
+// Asynchronous variant: starts the work and calls done exactly once, from
+// any thread
+typedef std::function<void(const AgentToolResult& result)> ToolDoneCallback;
+typedef std::function<void(const Json& params, ToolDoneCallback done)> AsyncToolExecutor;
+
 // Tool definition
 struct AgentTool {
     std::string name;
     std::string description;
     std::vector<ToolParamSchema> params;
     ToolExecutor execute;
+    AsyncToolExecutor execute_async;    // Optional; used by the agent when set
+    bool parallel_safe;     // No side effects: may run alongside other parallel-safe calls
     
-    AgentTool() {}
+    AgentTool() : parallel_safe(false) {}
     AgentTool(const std::string& n, const std::string& d, ToolExecutor e)
-        : name(n), description(d), execute(e) {}
+        : name(n), description(d), execute(e), parallel_safe(false) {}
 };
 
 // ============================================================================
@@ -100,6 +120,7 @@ struct AgentTool {
 // ============================================================================
 
 struct ParsedToolCall {
+    std::string id;           // Provider tool_use id (native tool mode only)
     std::string tool_name;
     Json params;
     std::string raw_content;  // Raw content between <tool_call> tags
@@ -125,22 +146,69 @@ struct ChunkedContent {
     ChunkedContent() : chunk_size(8000), total_chunks(0) {}
 };
 
+// Stores oversized tool results so the model can page through them.
+// Items belong to the session (scope) that stored them and are only visible
+// from that scope. Resident content is bounded by a global memory budget;
+// least recently used items move to an mmap-backed scratch file and are
+// dropped once that is full too. File slices stay in their own mapping.
+// Thread-safe.
 class ContentChunker {
 public:
+    // Sets the scope used by store() and lookups on this thread for its
+    // lifetime (empty = unscoped, sees everything)
+    class ScopeGuard {
+    public:
+        explicit ScopeGuard(const std::string& scope);
+        ~ScopeGuard();
+    private:
+        ScopeGuard(const ScopeGuard&);
+        ScopeGuard& operator=(const ScopeGuard&);
+        const std::string* previous_;
+        std::string scope_;
+    };
+    // Scope of the calling thread; during an agent turn, its session key
+    static const std::string& current_scope();
+    
+    struct Stats {
+        size_t items;
+        size_t memory_bytes;       // Resident content and search indexes
+        size_t spilled_items;
+        size_t mapped_items;       // Slices of mapped files
+        size_t spill_bytes;        // Content in the scratch file
+        uint64_t spills;           // Items moved to the scratch file
+        uint64_t evictions;        // Items dropped
+        
+        Stats() : items(0), memory_bytes(0), spilled_items(0), mapped_items(0), spill_bytes(0),
+                  spills(0), evictions(0) {}
+    };
+    
     ContentChunker();
+    ~ContentChunker();
+    
+    // Memory budget for resident content, and the scratch file that takes
+    // what no longer fits (spill_bytes 0 = drop instead of spilling)
+    void configure(size_t memory_budget, size_t spill_bytes, const std::string& spill_dir = "/tmp");
     
     // Store content and return a unique ID
     // Returns the ID and a summary that can be shown to the AI
     std::string store(const std::string& content, const std::string& source, size_t chunk_size = 8000);
     
+    // Same for a slice of a mapped file: the item refers to the mapping and
+    // holds no copy (nor counts against the memory budget)
+    std::string store(const FileSlice& slice, const std::string& source, size_t chunk_size = 8000);
+    
     // Get a specific chunk (0-indexed)
     std::string get_chunk(const std::string& id, size_t chunk_index) const;
     
     // Get summary info about stored content
     std::string get_info(const std::string& id) const;
     
-    // Search within stored content
-    std::string search(const std::string& id, const std::string& query, size_t context_chars = 500) const;
+    // Case-insensitive search within stored content. Each word of the query
+    // is a term ("quoted phrases" stay whole); with several terms, passages
+    // where more of them occur within context_chars rank first. The item's
+    // trigram index is built by the first search and is released under
+    // memory pressure.
+    std::string search(const std::string& id, const std::string& query, size_t context_chars = 500);
     
     // Check if content exists
     bool has(const std::string& id) const;
@@ -149,11 +217,33 @@ public:
     void clear();
     void remove(const std::string& id);
     
+    // Drop everything stored by one session
+    void remove_scope(const std::string& scope);
+    
     // Get total chunks for an ID
     size_t get_total_chunks(const std::string& id) const;
     
+    Stats stats() const;
+    
 private:
-    std::map<std::string, ChunkedContent> storage_;
+    struct Item;
+    struct SpillFile;
+    struct SearchIndex;
+    typedef std::map<std::string, Item> ItemMap;
+    
+    // Lookup from the calling thread's scope; marks the item recently used
+    const Item* find(const std::string& id) const;
+    std::string content_of(const Item& item, size_t pos, size_t len) const;
+    void erase(ItemMap::iterator it);
+    void enforce_budget();
+    
+    mutable std::mutex mutex_;
+    ItemMap storage_;
+    mutable std::list<std::string> lru_;   // Front = most recently used
+    std::unique_ptr<SpillFile> spill_;
+    size_t memory_budget_;
+    size_t memory_bytes_;
+    Stats counters_;                       // spills/evictions
     int next_id_;
 };
 
@@ -168,6 +258,17 @@ struct AgentConfig {
     bool verbose_results;           // Include full tool results in response (default: false)
     size_t max_tool_result_size;    // Max chars before chunking (default: 15000)
     bool auto_chunk_large_results;  // Automatically chunk large tool results (default: true)
+    std::string session_key;        // Scopes chunked results to one session (empty: unscoped)
+    int64_t queued_at_us;           // AgentTrace::clock_us() when the turn was queued (0: unknown)
+    std::string recalled;           // Prepended to the user message in the first request only
+    
+    // Streams response text as it is generated (tool calls are held back).
+    // Runs on the provider's I/O thread and must not block.
+    std::function<void(const std::string& chunk)> on_delta;
+    
+    // Reports each tool call as it starts (result NULL) and finishes. Runs
+    // on whichever thread runs the tool and must not block.
+    std::function<void(const std::string& tool, const AgentToolResult* result)> on_tool;
     
     AgentConfig() 
         : max_iterations(10)
@@ -175,7 +276,8 @@ struct AgentConfig {
         , echo_tool_calls(false)
         , verbose_results(false)
         , max_tool_result_size(15000)
-        , auto_chunk_large_results(true) {}
+        , auto_chunk_large_results(true)
+        , queued_at_us(0) {}
 };
 
 // ============================================================================
@@ -189,10 +291,22 @@ struct AgentResult {
     int iterations;                 // Number of iterations used
     int tool_calls_made;            // Total tool calls made
     std::vector<std::string> tools_used;  // Names of tools that were called
+    AgentTrace trace;               // Where the time of the turn went
     
     AgentResult() : success(false), iterations(0), tool_calls_made(0) {}
 };
 
+// Called once when an asynchronous agent run finishes
+typedef std::function<void(const AgentResult& result)> AgentCallback;
+
+// Runs a continuation of an asynchronous agent run (response handling and
+// tool execution). An empty executor runs continuations inline, which for
+// async providers means on the HTTP engine thread.
+typedef std::function<void(std::function<void()> fn)> AgentExecutor;
+
+// Immutable prompt text shared by every turn that uses it
+typedef std::shared_ptr<const std::string> SharedPrompt;
+
 // ============================================================================
 // Agent Class
 // ============================================================================
@@ -212,28 +326,95 @@ public:
     // Build tools section for system prompt
     std::string build_tools_prompt() const;
     
+    // Tools section as built for the current tool set: rebuilt only after
+    // register_tool() changed it, so every turn sends the same bytes
+    SharedPrompt tools_prompt(bool native = false) const;
+    uint64_t tools_version() const;
+    
+    // Native tool mode: tools as JSON schema definitions, plus the usage
+    // guidance that remains useful in the system prompt
+    std::vector<ToolSpec> build_tool_specs() const;
+    std::string build_native_tools_prompt() const;
+    
     // Parse tool calls from AI response
     std::vector<ParsedToolCall> parse_tool_calls(const std::string& response) const;
     
     // Execute a single tool call
     AgentToolResult execute_tool(const ParsedToolCall& call);
     
+    // Same, through the tool's execute_async when it has one (done may run
+    // on another thread); otherwise runs it here and calls done
+    void execute_tool_async(const ParsedToolCall& call, ToolDoneCallback done);
+    
     // Format tool result for injection into conversation
     // If the result is too large, it will be chunked and a summary returned
     std::string format_tool_result(const std::string& tool_name, const AgentToolResult& result);
     
+    // Body of format_tool_result, without the <tool_result> wrapper
+    std::string format_tool_output(const std::string& tool_name, const AgentToolResult& result);
+    
     // Extract text response (content outside tool calls)
     std::string extract_response_text(const std::string& response, 
                                        const std::vector<ParsedToolCall>& calls) const;
     
-    // Run the full agentic loop
+    // Run the full agentic loop (blocks the calling thread)
     AgentResult run(
         AIPlugin* ai,
-        const std::string& user_message,
+        SharedText user_message,
         std::vector<ConversationMessage>& history,
         const std::string& system_prompt,
         const AgentConfig& config = AgentConfig()
     );
+    AgentResult run(
+        AIPlugin* ai,
+        SharedText user_message,
+        std::vector<ConversationMessage>& history,
+        SharedPrompt system_prompt,
+        const AgentConfig& config = AgentConfig()
+    );
+    
+    // Run the agentic loop as a resumable state machine. No thread is held
+    // while waiting for the AI; each step is resumed through executor.
+    // history must stay valid (and untouched by others) until on_done runs.
+    void run_async(
+        AIPlugin* ai,
+        SharedText user_message,
+        std::vector<ConversationMessage>& history,
+        const std::string& system_prompt,
+        const AgentConfig& config,
+        AgentCallback on_done,
+        AgentExecutor executor = AgentExecutor()
+    );
+    void run_async(
+        AIPlugin* ai,
+        SharedText user_message,
+        std::vector<ConversationMessage>& history,
+        SharedPrompt system_prompt,
+        const AgentConfig& config,
+        AgentCallback on_done,
+        AgentExecutor executor = AgentExecutor()
+    );
+    
+    // Workers for running parallel-safe tool calls of one iteration
+    // concurrently (default: 4, 1 = always sequential). The pool is sized
+    // on first use; later changes only switch between 1 and more.
+    void set_max_parallel_tools(size_t n) { max_parallel_tools_ = n > 0 ? n : 1; }
+    size_t max_parallel_tools() const { return max_parallel_tools_; }
+    
+    // Start parallel-safe tool calls as soon as their closing tag streams
+    // in, while the model is still generating (default: true)
+    void set_early_tool_start(bool enabled) { early_tool_start_ = enabled; }
+    bool early_tool_start() const { return early_tool_start_; }
+    
+    // Pass tools through the provider's native tool-use API instead of the
+    // <tool_call> prompt format, when the provider supports it (default: false)
+    void set_native_tools(bool enabled) { native_tools_ = enabled; }
+    bool native_tools() const { return native_tools_; }
+    
+    // Reserve provider tokens before each AI call and wait while the
+    // provider's per-minute budget is spent (null = send right away)
+    void set_budget(ProviderBudget* budget) { budget_ = budget; }
+    ProviderBudget* budget() const { return budget_; }
     
     // Configuration
     void set_config(const AgentConfig& config) { config_ = config; }
@@ -244,7 +425,51 @@ public:
     const ContentChunker& chunker() const { return chunker_; }
 
 private:
+    // State of one asynchronous run (defined in agent.cpp)
+    struct Turn;
+    typedef std::shared_ptr<Turn> TurnPtr;
+    
+    void turn_request(TurnPtr turn);
+    void turn_on_response(TurnPtr turn, const CompletionResult& ai_result, const std::string& model,
+                          int64_t queued, int64_t requested, int64_t completed, int64_t first);
+    void turn_on_completion(TurnPtr turn, const CompletionResult& ai_result);
+    void turn_finish(TurnPtr turn);
+    
+    // Tool calls of one iteration (defined in agent.cpp)
+    struct ToolBatch;
+    typedef std::shared_ptr<ToolBatch> ToolBatchPtr;
+    
+    // Tool calls started while the reply streams (defined in agent.cpp)
+    struct EarlyToolCall;
+    typedef std::shared_ptr<EarlyToolCall> EarlyToolCallPtr;
+    struct ToolScanner;
+    
+    void scan_stream(ToolScanner& scanner, const std::string& chunk);
+    void claim_early_calls(TurnPtr turn, ToolBatchPtr batch);
+    void run_tool_calls(TurnPtr turn, ToolBatchPtr batch, bool resumed);
+    void turn_on_tool_results(TurnPtr turn, ToolBatchPtr batch);
+    bool is_parallel_safe(const ParsedToolCall& call) const;
+    bool is_async(const ParsedToolCall& call) const;
+    
+    // Tool for call with its params recovered if needed; null with failure
+    // set when the call cannot run
+    const AgentTool* resolve_tool(const ParsedToolCall& call, ParsedToolCall& effective,
+                                  AgentToolResult& failure);
+    ThreadPool& tool_pool();
+    
     std::map<std::string, AgentTool> tools_;
+    std::atomic<size_t> max_parallel_tools_;    // Settable while turns run
+    std::atomic<bool> early_tool_start_;
+    bool native_tools_;
+    ProviderBudget* budget_;
+    
+    // Cached tools_prompt(), per mode (0 = <tool_call> format, 1 = native)
+    mutable std::mutex prompt_mutex_;
+    uint64_t tools_version_;
+    mutable SharedPrompt tools_prompt_cache_[2];
+    mutable uint64_t tools_prompt_version_[2];
+    std::unique_ptr<ThreadPool> tool_pool_;     // Created on first parallel batch
+    std::mutex tool_pool_mutex_;
     AgentConfig config_;
     ContentChunker chunker_;
     
@@ -256,6 +481,16 @@ private:
     
     // Attempt to recover from token limit by truncating history
     bool try_truncate_history(std::vector<ConversationMessage>& history) const;
+    
+    // Shrink a large tool result message to a short excerpt
+    static bool truncate_tool_result(ConversationMessage& msg);
+    
+    // Trim history so the estimated prompt fits the provider's context
+    // window before the request is sent. Returns the estimated prompt
+    // size in tokens (0 if the provider's window is unknown).
+    int fit_history_to_budget(AIPlugin* ai,
+                              const CompletionOptions& opts,
+                              std::vector<ConversationMessage>& history) const;
 };
 
 } // namespace openclaw
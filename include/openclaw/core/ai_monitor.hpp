@@ -8,18 +8,23 @@
  * - Thread-safe heartbeat tracking for active AI sessions
  * - Hang detection with configurable timeout
  * - Automatic typing indicator dispatch to channels
- * - Periodic health check in dedicated monitoring thread
+ * - Per-session deadlines on the shared timer wheel instead of a polling
+ *   thread; a heartbeat only stores its time
+ * - Typing indicators go out on a per-channel strand of the thread pool,
+ *   so a slow channel API holds up neither hang detection nor other channels
  */
 #ifndef OPENCLAW_CORE_AI_MONITOR_HPP
 #define OPENCLAW_CORE_AI_MONITOR_HPP
 
+#include "timer_wheel.hpp"
 #include <string>
 #include <map>
 #include <mutex>
-#include <thread>
 #include <atomic>
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <cstdint>
 
 namespace openclaw {
 
@@ -37,12 +42,20 @@ struct AISessionState {
     std::chrono::steady_clock::time_point last_heartbeat;
     int heartbeat_count;
     bool is_hung;
+    uint64_t serial;                    // Tells a restarted session's timers from stale ones
+    TimerWheel::TimerId hang_timer;
+    TimerWheel::TimerId typing_timer;
+    std::shared_ptr<std::atomic<bool> > typing_queued;   // An indicator waits on the strand
     
     AISessionState()
         : started_at(std::chrono::steady_clock::now())
         , last_heartbeat(std::chrono::steady_clock::now())
         , heartbeat_count(0)
         , is_hung(false)
+        , serial(0)
+        , hang_timer(0)
+        , typing_timer(0)
+        , typing_queued(std::make_shared<std::atomic<bool> >(false))
     {}
 };
 
@@ -56,12 +69,10 @@ public:
     struct Config {
         int hang_timeout_seconds;      // Seconds without heartbeat = hung
         int typing_interval_seconds;   // How often to send typing indicator
-        int check_interval_ms;         // Monitor thread check interval
         
         Config()
             : hang_timeout_seconds(30)
             , typing_interval_seconds(3)
-            , check_interval_ms(1000)
         {}
     };
     
@@ -74,7 +85,11 @@ public:
     bool is_running() const { return running_.load(); }
     
     // Configuration
-    void set_config(const Config& config) { config_ = config; }
+    // Running sessions pick new timeouts up at their next heartbeat
+    void set_config(const Config& config) {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        config_ = config;
+    }
     const Config& get_config() const { return config_; }
     
     // Session tracking
@@ -104,11 +119,12 @@ private:
     
     // State
     std::atomic<bool> running_;
-    std::thread monitor_thread_;
+    TimerWheel& wheel_;
     
     // Session tracking
     mutable std::mutex sessions_mutex_;
     std::map<std::string, AISessionState> active_sessions_;
+    uint64_t next_serial_;
     
     // Statistics
     std::atomic<int> total_sessions_started_;
@@ -118,11 +134,16 @@ private:
     // Callbacks
     HungSessionCallback hung_callback_;
     
-    // Monitoring thread
-    void monitor_loop();
+    // Arm a session's deadlines (sessions_mutex_ held)
+    void arm_hang_check(const std::string& session_id, AISessionState& state, int64_t delay_ms);
+    void arm_typing(const std::string& session_id, AISessionState& state, int64_t delay_ms);
     
-    // Check a single session
-    void check_session(const std::string& session_id, AISessionState& state);
+    // Timer callbacks
+    void on_hang_check(const std::string& session_id, uint64_t serial);
+    void on_typing(const std::string& session_id, uint64_t serial);
+    
+    // Queue a typing indicator on the channel's strand (sessions_mutex_ held)
+    void queue_typing(const AISessionState& state, bool typing);
     
     // Send typing indicator to channel
     void send_typing_indicator(const std::string& channel_id, 
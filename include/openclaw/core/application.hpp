@@ -8,6 +8,7 @@
 #define OPENCLAW_CORE_APPLICATION_HPP
 
 #include "config.hpp"
+#include "logger.hpp"
 #include "loader.hpp"
 #include "registry.hpp"
 #include "session.hpp"
@@ -15,6 +16,15 @@
 #include "rate_limiter.hpp"
 #include "agent.hpp"
 #include "ai_monitor.hpp"
+#include "compactor.hpp"
+#include "trace.hpp"
+#include "session_store.hpp"
+#include "cluster.hpp"
+#include "shm_limit_store.hpp"
+#include "provider_budget.hpp"
+#include "../ai/router.hpp"
+#include "message_handler.hpp"
+#include "snapshot.hpp"
 #include "../skills/manager.hpp"
 #include "../skills/types.hpp"
 
@@ -36,6 +46,52 @@ struct AppInfo {
     static const char* default_system_prompt();
 };
 
+// ============================================================================
+// Runtime Settings
+// ============================================================================
+
+// Settings that follow config reloads (SIGHUP), parsed once per load.
+// Readers take a snapshot with Application::settings() and use its fields;
+// everything else in the config applies at startup only.
+struct RuntimeSettings {
+    LogLevel log_level;
+    
+    size_t session_max_history;
+    int64_t session_timeout;            // Seconds idle before a session is dropped
+    DMScope session_dm_scope;
+    
+    size_t max_parallel_tools;
+    bool early_tool_start;
+    
+    int64_t budget_max_wait_ms;
+    int budget_max_skips;
+    
+    AIProcessMonitor::Config monitor;
+    
+    bool http2;
+    size_t http_max_idle_per_host;
+    
+    AdmissionConfig admission;
+    RecallConfig recall;
+    RoutingConfig routing;
+    
+    RuntimeSettings()
+        : log_level(LogLevel::INFO)
+        , session_max_history(20)
+        , session_timeout(3600)
+        , session_dm_scope(DMScope::MAIN)
+        , max_parallel_tools(4)
+        , early_tool_start(true)
+        , budget_max_wait_ms(60000)
+        , budget_max_skips(4)
+        , http2(true)
+        , http_max_idle_per_host(8) {}
+    
+    static RuntimeSettings from_config(const Config& cfg);
+};
+
+typedef Snapshot<RuntimeSettings>::Ptr RuntimeSettingsPtr;
+
 // ============================================================================
 // Application Class - Singleton
 // ============================================================================
@@ -51,38 +107,68 @@ public:
     
     // ==================== Accessors ====================
     
+    // The config file as loaded at startup (reloads do not change it)
     Config& config() { return config_; }
     const Config& config() const { return config_; }
     
+    // Current runtime settings; never null
+    RuntimeSettingsPtr settings() const { return settings_.get(); }
+    
     PluginLoader& loader() { return loader_; }
     PluginRegistry& registry() { return PluginRegistry::instance(); }
     SessionManager& sessions() { return SessionManager::instance(); }
+    SessionStore& session_store() { return session_store_; }
     ThreadPool& thread_pool() { return thread_pool_; }
     
+    // Session-affine routing across nodes (cluster.enabled)
+    Cluster& cluster() { return cluster_; }
+    
     SkillManager& skills() { return skill_manager_; }
     const std::vector<SkillEntry>& skill_entries() const { return skill_entries_; }
-    const std::vector<SkillCommandSpec>& skill_commands() const { return skill_command_specs_; }
+    const std::vector<SkillCommandSpec>& skill_commands() const { return skill_command_table_.specs(); }
+    const SkillCommandTable& skill_command_table() const { return skill_command_table_; }
     
     Agent& agent() { return agent_; }
     
+    // Provider requests/tokens-per-minute admission
+    ProviderBudget& provider_budget() { return provider_budget_; }
+    
+    // Latency-aware routing across AI providers (ai_router.enabled)
+    AIRouter& ai_router() { return ai_router_; }
+    
     // AI process monitor
     AIProcessMonitor& ai_monitor() { return ai_monitor_; }
     
+    // Background history summarization
+    HistoryCompactor& compactor() { return compactor_; }
+    
+    // Agent turn trace export
+    TraceExporter& tracer() { return tracer_; }
+    
     // Rate limiting
     KeyedRateLimiter& user_limiter() { return user_limiter_; }
     MessageDebouncer& debouncer() { return debouncer_; }
     TypingIndicator& typing() { return typing_; }
     
-    // System prompt (can be customized via config)
-    const std::string& system_prompt() const { return system_prompt_; }
-    void set_system_prompt(const std::string& prompt) { system_prompt_ = prompt; }
+    // System prompt (can be customized via config). Turns share one
+    // immutable snapshot; a change swaps in a new one and bumps the version.
+    SharedPrompt system_prompt() const;
+    uint64_t system_prompt_version() const;
+    void set_system_prompt(const std::string& prompt);
     void rebuild_system_prompt();
     
     // ==================== Lifecycle ====================
     
     // State
     bool is_running() const { return running_.load(); }
-    void stop() { running_.store(false); }
+    void stop();  // Async-signal-safe
+    
+    // Re-read the config file on the main loop (async-signal-safe)
+    void request_reload();
+    
+    // Re-read the config file now and apply its runtime settings, and
+    // plugin settings via Plugin::reconfigure; false if it cannot be loaded
+    bool reload_config();
     
     // Initialize the application
     bool init(int argc, char* argv[]);
@@ -100,22 +186,61 @@ private:
     // Initialization helpers
     bool parse_args(int argc, char* argv[], const char** config_file);
     void setup_logging();
-    void setup_skills();
+    // The skill catalog is scanned off the main thread during init and
+    // applied on it once joined
+    struct SkillScan {
+        std::vector<SkillEntry> entries;        // Eligible for this environment
+        SkillCommandTable command_table;
+        std::string prompt_section;
+    };
+    SkillScan scan_skills();
+    void apply_skills(SkillScan& scan);
     void setup_agent();
     void setup_plugins();
     void setup_channels();
+    void setup_metrics();
+    
+    // Push runtime settings to the components that use them
+    void apply_settings(const RuntimeSettings& settings);
+    
+    // Messages the cluster runs here: forwarded by other nodes, or
+    // arrived here for an owner that could not be reached
+    bool accept_from_cluster(const Message& msg);
+    
+    // Drop the sessions another node owns after a membership change
+    void hand_off_sessions();
+    
+    // Startup profiling (--profile-startup): wall time of each step
+    struct StartupPhase {
+        std::string name;
+        int64_t us;
+    };
+    void record_phase(const std::string& name, int64_t us);
+    void report_startup(int64_t total_us) const;
     
     // State
     std::atomic<bool> running_;
+    std::atomic<bool> reload_requested_;
+    bool profile_startup_;
+    std::vector<StartupPhase> startup_phases_;
     
     // Core components
+    std::string config_path_;
     Config config_;
+    Snapshot<RuntimeSettings> settings_;
     PluginLoader loader_;
     ThreadPool thread_pool_;
+    ProviderBudget provider_budget_;
+    AIRouter ai_router_;
     Agent agent_;
     AIProcessMonitor ai_monitor_;
+    HistoryCompactor compactor_;
+    TraceExporter tracer_;
+    SessionStore session_store_;
+    Cluster cluster_;
     
-    // Rate limiting
+    // Rate limiting (the shared store outlives its users)
+    ShmRateLimitStore limit_store_;
     KeyedRateLimiter user_limiter_;
     MessageDebouncer debouncer_;
     TypingIndicator typing_;
@@ -123,10 +248,12 @@ private:
     // Skills system
     SkillManager skill_manager_;
     std::vector<SkillEntry> skill_entries_;
-    std::vector<SkillCommandSpec> skill_command_specs_;
+    SkillCommandTable skill_command_table_;     // Rebuilt with the catalog
     
     // System prompt
-    std::string system_prompt_;
+    SharedPrompt system_prompt_;
+    uint64_t system_prompt_version_;
+    mutable std::mutex system_prompt_mutex_;
 };
 
 // ============================================================================
@@ -4,7 +4,9 @@
 #include <openclaw/core/tool.hpp>
 #include <openclaw/core/agent.hpp>
 #include <openclaw/core/http_client.hpp>
+#include <openclaw/core/web_cache.hpp>
 #include <openclaw/core/logger.hpp>
+#include <openclaw/core/snapshot.hpp>
 #include <string>
 #include <sstream>
 #include <algorithm>
@@ -30,24 +32,37 @@ public:
     std::vector<AgentTool> get_agent_tools() const;
 
     bool init(const Config& cfg);
+    void reconfigure(const Config& cfg);
     void shutdown();
 
     ToolResult execute(const std::string& action, const Json& params);
 
 private:
+    // Limits that follow config reloads
+    struct Settings {
+        size_t max_content_length;
+        size_t fetch_many_concurrency;  // Requests in flight per fetch_many call
+        size_t fetch_many_per_host;     // ... of which to one host
+
+        Settings() : max_content_length(100000), fetch_many_concurrency(8), fetch_many_per_host(2) {}
+
+        // Read browser.* keys
+        static Settings from_config(const Config& cfg);
+    };
+
     HttpClient http_;
-    size_t max_content_length_;
-    int timeout_secs_;
+    int timeout_secs_;                  // Fixed at init (the client is shared)
+    Snapshot<Settings> settings_;
 
     ToolResult do_fetch(const Json& params);
     ToolResult do_extract_text(const Json& params);
     ToolResult do_get_links(const Json& params);
+    ToolResult do_fetch_many(const Json& params);
     ToolResult do_status();
 
-    static std::string strip_html(const std::string& html);
-    static std::string normalize_whitespace(const std::string& s);
-    static std::vector<std::pair<std::string, std::string> > extract_links(
-            const std::string& html, const std::string& base_url);
+    // GET params["url"], through the WebCache unless custom headers are
+    // given; false with failure set when there is no usable page
+    bool load_page(const Json& params, WebFetchResult& fetch, ToolResult& failure);
 };
 
 } // namespace openclaw
@@ -4,7 +4,7 @@
  * Provides filesystem and shell tools for the agent:
  * - read: Read file contents
  * - write: Write content to files
- * - bash: Execute shell commands
+ * - bash: Execute shell commands (spawned and watched on the reactor)
  * - list_dir: List directory contents
  * - content_chunk: Retrieve chunks of large content
  * - content_search: Search within large content
@@ -15,13 +15,15 @@
 #include "agent.hpp"
 #include "tool.hpp"
 #include "config.hpp"
+#include "snapshot.hpp"
 #include <string>
 #include <memory>
 
 namespace openclaw {
 
-// Forward declaration
+// Forward declarations
 class ContentChunker;
+struct SubprocessOptions;
 
 // ============================================================================
 // Built-in Tools Provider
@@ -46,6 +48,7 @@ public:
     const char* version() const override { return "1.0.0"; }
     
     bool init(const Config& cfg) override;
+    void reconfigure(const Config& cfg) override;
     void shutdown() override;
     
     // ToolProvider interface
@@ -60,14 +63,29 @@ public:
     void set_chunker(ContentChunker* chunker) { chunker_ = chunker; }
     
 private:
+    // Bash limits that follow config reloads
+    struct BashLimits {
+        int timeout;                // Seconds
+        size_t max_output;          // Past this the command is killed
+        
+        BashLimits();
+        
+        // Read agent.bash_timeout / agent.bash_max_output
+        static BashLimits from_config(const Config& cfg);
+    };
+    
     std::string workspace_dir_;
-    int bash_timeout_;
+    Snapshot<BashLimits> bash_limits_;
+    std::string bash_cgroup_;       // Empty: no cgroup limits
     ContentChunker* chunker_;
     
     // Internal tool implementations
     AgentToolResult do_read(const Json& params) const;
     AgentToolResult do_write(const Json& params) const;
     AgentToolResult do_bash(const Json& params) const;
+    void do_bash_async(const Json& params, ToolDoneCallback done) const;
+    bool prepare_bash(const Json& params, const BashLimits& limits, SubprocessOptions& options,
+                      AgentToolResult& failure) const;
     AgentToolResult do_list_dir(const Json& params) const;
     AgentToolResult do_content_chunk(const Json& params) const;
     AgentToolResult do_content_search(const Json& params) const;
@@ -30,12 +30,41 @@ public:
         return send_message(to, text);
     }
     
+    // Queue a message and return at once; on_done (may be empty) gets the
+    // outcome, possibly on another thread. Channels with an outbound queue
+    // override this; by default the message is sent inline.
+    virtual void send_message_async(const std::string& to, const std::string& text,
+                                    const std::string& reply_to, SendCallback on_done) {
+        SendResult result = reply_to.empty() ? send_message(to, text)
+                                             : send_message(to, text, reply_to);
+        if (on_done) on_done(result);
+    }
+    
+    // Replace the text of a message sent earlier (only called when
+    // capabilities().supports_edit); same threading as send_message_async
+    virtual void edit_message_async(const std::string& to, const std::string& message_id,
+                                    const std::string& text, SendCallback on_done) {
+        (void)to;
+        (void)message_id;
+        (void)text;
+        if (on_done) on_done(SendResult::fail("Editing not supported by this channel"));
+    }
+    
     // Typing indicator (optional - override if channel supports it)
     virtual SendResult send_typing_action(const std::string& to) {
         (void)to;
         return SendResult::fail("Typing action not supported by this channel");
     }
     
+    // Partial AI reply text, in order, while the reply is generated (only
+    // called when capabilities().supports_streaming). The complete reply
+    // still arrives through send_message() afterwards.
+    virtual SendResult send_stream_delta(const std::string& to, const std::string& delta) {
+        (void)to;
+        (void)delta;
+        return SendResult::fail("Streaming not supported by this channel");
+    }
+    
     // Poll for new messages (call regularly in event loop)
     virtual void poll() = 0;
     
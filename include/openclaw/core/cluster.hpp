@@ -0,0 +1,157 @@
+/*
+ * OpenClaw C++11 - Cluster Routing
+ *
+ * Spreads sessions over several openclaw nodes so throughput grows with
+ * the number of boxes while each conversation stays on one of them.
+ *
+ * Features:
+ * - Every session key has one owner, picked by consistent hashing
+ *   (virtual nodes on a 64-bit ring): a membership change only moves the
+ *   sessions on the ring segments that change hands
+ * - A message arriving on any node is forwarded to its session's owner as
+ *   POST /hooks/cluster, on the gateway's HTTP server when the gateway is
+ *   loaded (the port of its WebSocket) or on cluster.port otherwise; the
+ *   owner runs the turn and replies through its own channel plugin
+ * - If the owner cannot be reached or refuses the message, the message is
+ *   handled where it arrived: an outage costs affinity, not messages. A
+ *   forward that reached the owner but got no answer (timeout) is not run
+ *   again here, since the owner may be running it; the owner drops
+ *   message IDs it already received
+ * - The owner reloads a session whose log another node appended to while
+ *   it was unreachable before running its next turn
+ * - Membership is the configured node list and follows config reloads.
+ *   Sessions hand off through the persistent session store, which the
+ *   nodes share (session.dir on a shared filesystem): the old owner
+ *   releases each session it gave up once its queued turns are done, and
+ *   the new owner holds messages for sessions it took over for
+ *   cluster.handoff_ms before reading their logs
+ */
+#ifndef OPENCLAW_CORE_CLUSTER_HPP
+#define OPENCLAW_CORE_CLUSTER_HPP
+
+#include "types.hpp"
+#include "config.hpp"
+#include "snapshot.hpp"
+#include "http_client.hpp"
+#include "webhook.hpp"
+#include "rate_limiter.hpp"
+#include <string>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <cstdint>
+
+namespace openclaw {
+
+// Consistent-hash ring of node IDs
+class HashRing {
+public:
+    HashRing() {}
+
+    // vnodes points per node; more spread the keys more evenly
+    void build(const std::vector<std::string>& nodes, int vnodes);
+
+    // Owner of key; empty when the ring has no nodes
+    const std::string& owner(const std::string& key) const;
+
+    bool empty() const { return points_.empty(); }
+    const std::vector<std::string>& nodes() const { return nodes_; }
+
+    static uint64_t hash(const std::string& text);
+
+private:
+    std::vector<std::pair<uint64_t, size_t> > points_;     // Sorted (hash, node index)
+    std::vector<std::string> nodes_;
+};
+
+class Cluster {
+public:
+    struct Node {
+        std::string id;
+        std::string url;          // Base URL; messages go to <url>/hooks/cluster
+    };
+
+    struct Settings {
+        bool enabled;
+        std::string node_id;      // This node's ID in nodes
+        std::vector<Node> nodes;
+        int vnodes;
+        std::string token;        // Shared secret sent with every forward
+        std::string bind;         // Own listener when the gateway is not loaded
+        int port;
+        int64_t handoff_ms;
+        long forward_timeout_ms;
+
+        Settings() : enabled(false), vnodes(128), bind("0.0.0.0"), port(18790),
+                     handoff_ms(3000), forward_timeout_ms(5000) {}
+
+        static Settings from_config(const Config& cfg);
+    };
+
+    // Takes a message to run on this node; false if it cannot (no such
+    // channel here, queue full). May be called from the HTTP threads, so
+    // it must only queue the work.
+    typedef std::function<bool(const Message& msg)> LocalHandler;
+
+    Cluster();
+    ~Cluster();
+
+    // Join with settings (nothing happens unless enabled). Call after the
+    // gateway initialized: without it, a listener is started on cluster.port.
+    bool start(const Settings& settings, LocalHandler local);
+    void stop();
+
+    // Apply a reloaded node list. True if the ring changed; the caller
+    // then releases the sessions this node no longer owns (see owns()).
+    bool reconfigure(const Settings& settings);
+
+    bool enabled() const;
+    const std::string& node_id() const;
+
+    // Whether this node owns the session (always true when disabled)
+    bool owns(const std::string& session_key) const;
+
+    // Pass msg on to the owner of session_key. False if this node owns it
+    // and should process it; true once it is the owner's (or, should the
+    // owner be unreachable or refuse it, the local handler's).
+    bool forward(const Message& msg, const std::string& session_key);
+
+    // Time to hold a message for a session this node took over in the
+    // last membership change, so the old owner can finish and release it
+    // (0 = go ahead)
+    int64_t handoff_wait_ms(const std::string& session_key) const;
+
+    // Wire format of a forwarded message
+    static Json message_to_json(const Message& msg);
+    static bool message_from_json(const Json& json, Message& msg);
+
+private:
+    Cluster(const Cluster&);
+    Cluster& operator=(const Cluster&);
+
+    // One membership, swapped whole on reconfigure
+    struct State {
+        Settings settings;
+        HashRing ring;
+        HashRing previous;        // Ring before the last change (empty at start)
+        int64_t changed_at_ms;
+
+        State() : changed_at_ms(0) {}
+
+        const Node* node(const std::string& id) const;
+    };
+    typedef Snapshot<State>::Ptr StatePtr;
+
+    WebhookResponse on_forward(const WebhookRequest& request);
+    void run_local(const Message& msg, const std::string& why);
+
+    Snapshot<State> state_;
+    LocalHandler local_;
+    HttpClient http_;
+    WebhookServer server_;
+    MessageDebouncer received_;   // IDs of forwarded messages taken here
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_CLUSTER_HPP
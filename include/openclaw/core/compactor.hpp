@@ -0,0 +1,95 @@
+/*
+ * OpenClaw C++11 - Background History Compaction
+ *
+ * Keeps long-running sessions within a token budget by replacing the
+ * oldest part of the history with a model-written summary.
+ *
+ * Features:
+ * - Triggered after a turn once the history passes a token threshold
+ * - Summaries run on the thread pool's LOW lane, off the request path
+ * - Optional cheaper provider/model for the summaries
+ * - Earlier summaries are folded into the next one (incremental)
+ * - The summary is swapped in on the session's strand before the next
+ *   turn, and only if the summarized messages are still unchanged
+ */
+#ifndef OPENCLAW_CORE_COMPACTOR_HPP
+#define OPENCLAW_CORE_COMPACTOR_HPP
+
+#include <openclaw/ai/ai.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace openclaw {
+
+class Session;
+class ThreadPool;
+
+class HistoryCompactor {
+public:
+    struct Config {
+        bool enabled;
+        int threshold_tokens;      // Compact above this (0 = half the context window)
+        size_t keep_recent;        // Newest messages that always stay verbatim
+        std::string provider;      // AI plugin for summaries (empty = the session's)
+        std::string model;         // Model for summaries (empty = provider default)
+        int summary_tokens;        // max_tokens of a summary
+        bool batch;                // Send summaries through the provider's batch API
+
+        Config()
+            : enabled(true)
+            , threshold_tokens(0)
+            , keep_recent(8)
+            , summary_tokens(1024)
+            , batch(false)
+        {}
+    };
+
+    struct Stats {
+        uint64_t scheduled;
+        uint64_t applied;
+        uint64_t discarded;        // History changed before the summary was ready
+        uint64_t failed;
+        size_t pending;            // Running or waiting to be applied
+
+        Stats() : scheduled(0), applied(0), discarded(0), failed(0), pending(0) {}
+    };
+
+    explicit HistoryCompactor(ThreadPool& pool);
+
+    void set_config(const Config& config) { config_ = config; }
+    const Config& get_config() const { return config_; }
+
+    // Call on the session's strand after a turn. Schedules a summary of the
+    // oldest messages once the history is over the threshold.
+    void maybe_compact(const Session& session, AIPlugin* ai);
+
+    // Call on the session's strand before a turn. Replaces the summarized
+    // messages with a finished summary; returns true if it did.
+    bool apply_pending(Session& session);
+
+    // Drop pending work for a session (history was cleared)
+    void forget(const std::string& session_key);
+
+    Stats stats() const;
+
+private:
+    struct Job;
+    typedef std::shared_ptr<Job> JobPtr;
+
+    void run(const std::string& session_key, JobPtr job, AIPlugin* ai);
+    void finish(const std::string& session_key, JobPtr job, const CompletionResult& result);
+
+    ThreadPool& pool_;
+    Config config_;
+    std::map<std::string, JobPtr> jobs_;    // At most one per session
+    Stats counters_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_COMPACTOR_HPP
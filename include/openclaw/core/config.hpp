@@ -17,7 +17,10 @@ public:
     // Load from JSON string
     bool load_string(const std::string& json_str);
     
-    // Get string value
+    // Typed lookups; keys may name nested values with dots
+    // ("gateway.auth.token"). Each call walks the tree, so code that reads
+    // settings on a hot path parses them into a struct once instead (see
+    // Snapshot).
     std::string get_string(const std::string& key, const std::string& def = "") const;
     
     int64_t get_int(const std::string& key, int64_t def = 0) const;
@@ -36,6 +39,9 @@ public:
     const Json& data() const;
 
 private:
+    // Value at a dotted key, NULL if there is none
+    const Json* find(const std::string& key) const;
+    
     Json data_;
 };
 
@@ -0,0 +1,90 @@
+/*
+ * OpenClaw C++11 - Memory-Mapped File View
+ *
+ * Read-only mapping of a file for ranged reads: the kernel pages in only
+ * what is touched, so a slice of a huge log costs the slice, not the log.
+ *
+ * Line ranges are found through a sparse index of line starts (every
+ * 64th line) that is built lazily, only as far into the file as a read
+ * has reached; later reads of the same region skip straight to it.
+ *
+ * Views are shared (std::shared_ptr) so a slice can be handed to other
+ * owners, e.g. ContentChunker, without copying. A file truncated while
+ * mapped would fault on access; intact() checks for that.
+ */
+#ifndef OPENCLAW_CORE_FILE_VIEW_HPP
+#define OPENCLAW_CORE_FILE_VIEW_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+namespace openclaw {
+
+// Visibility attribute for plugins
+#ifdef __GNUC__
+#  define FILE_VIEW_API __attribute__((visibility("default")))
+#else
+#  define FILE_VIEW_API
+#endif
+
+class FILE_VIEW_API FileView {
+public:
+    // Null with error set when the file cannot be opened or mapped
+    static std::shared_ptr<const FileView> open(const std::string& path, std::string& error);
+    ~FileView();
+
+    const std::string& path() const { return path_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Bytes of lines [first, first + count) (0-based; count 0 = to the end),
+    // without the final newline. False when first is past the last line.
+    bool line_range(size_t first, size_t count, size_t& offset, size_t& length) const;
+
+    // Number of lines (scans the rest of the file once)
+    size_t line_count() const;
+
+    // The file has not shrunk below the mapping
+    bool intact() const;
+
+    std::string substr(size_t offset, size_t length) const;
+
+private:
+    FileView();
+    FileView(const FileView&);
+    FileView& operator=(const FileView&);
+
+    // Offset where line `line` starts, or size_ when there is no such line
+    size_t line_start(size_t line) const;
+
+    std::string path_;
+    int fd_;
+    const char* data_;
+    size_t size_;
+
+    mutable std::mutex mutex_;
+    mutable std::vector<size_t> sparse_;    // Start of every 64th line
+    mutable size_t scanned_lines_;          // Lines whose start is known
+    mutable size_t scanned_to_;             // Start of line scanned_lines_
+};
+
+// A byte range of a mapped file, handed out instead of a copy
+struct FileSlice {
+    std::shared_ptr<const FileView> file;
+    size_t offset;
+    size_t length;
+
+    FileSlice() : offset(0), length(0) {}
+    FileSlice(const std::shared_ptr<const FileView>& f, size_t off, size_t len)
+        : file(f), offset(off), length(len) {}
+
+    bool empty() const { return !file || length == 0; }
+    const char* data() const { return file ? file->data() + offset : nullptr; }
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_FILE_VIEW_HPP
@@ -0,0 +1,41 @@
+/*
+ * OpenClaw C++11 - HTML to Text
+ *
+ * Single-pass converter from HTML to readable text for the browser tools.
+ * One state machine walks the document once: text runs are found with a
+ * vectorized scan for '<' and '&', entities are decoded and whitespace is
+ * collapsed as the text is written, script, style and comments are
+ * skipped, and <a href> links (with their text) are collected on the way.
+ *
+ * Text output stops at a byte budget; unless links are wanted the scan
+ * stops there too, so a short excerpt of a huge page costs the excerpt.
+ * Nothing is allocated beyond the output itself.
+ */
+#ifndef OPENCLAW_CORE_HTML_TEXT_HPP
+#define OPENCLAW_CORE_HTML_TEXT_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace openclaw {
+
+typedef std::vector<std::pair<std::string, std::string> > WebLinks;   // (url, text)
+
+namespace html_text {
+
+// Append the text of html to out, at most max_chars bytes. Links, if
+// wanted, are resolved against base_url ("/path" and "//host" forms).
+// False when the text was cut short at max_chars.
+bool extract(const std::string& html, size_t max_chars, std::string& out,
+             WebLinks* links = nullptr, const std::string& base_url = std::string());
+
+// Only the links
+WebLinks links(const std::string& html, const std::string& base_url);
+
+} // namespace html_text
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_HTML_TEXT_HPP
@@ -5,18 +5,32 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 #include <curl/curl.h>
 
 namespace openclaw {
 
+// Visibility attribute so plugins share the main binary's engine instance
+#ifdef __GNUC__
+#  define HTTP_API __attribute__((visibility("default")))
+#else
+#  define HTTP_API
+#endif
+
 // HTTP response structure
 struct HttpResponse {
     long status_code;
     std::string body;
     std::map<std::string, std::string> headers;
     std::string error;
+    bool sent;              // The request reached the server (false: no connection)
     
-    HttpResponse() : status_code(0) {}
+    HttpResponse() : status_code(0), sent(false) {}
     
     bool ok() const { return status_code >= 200 && status_code < 300; }
     
@@ -29,6 +43,27 @@ struct HttpResponse {
     }
 };
 
+// Receives response body bytes as they arrive (successful responses only;
+// error bodies are still buffered into HttpResponse::body)
+typedef std::function<void(const char* data, size_t len)> HttpDataCallback;
+
+// A request for HttpClient::perform() or the asynchronous engine
+struct HttpRequest {
+    std::string method;     // GET, POST, PUT, DELETE, PATCH
+    std::string url;
+    std::string body;
+    std::map<std::string, std::string> headers;
+    long timeout_ms;
+    HttpDataCallback on_data;   // Set to stream the body instead of buffering it
+    
+    HttpRequest() : method("GET"), timeout_ms(30000) {}
+    HttpRequest(const std::string& m, const std::string& u, const std::string& b = "")
+        : method(m), url(u), body(b), timeout_ms(30000) {}
+};
+
+// Completion callback for asynchronous requests
+typedef std::function<void(const HttpResponse&)> HttpCallback;
+
 // HTTP client using libcurl
 class HttpClient {
 public:
@@ -52,23 +87,176 @@ public:
                            const std::string& body,
                            const std::map<std::string, std::string>& extra_headers = std::map<std::string, std::string>());
     
+    // Arbitrary request; streams the body when request.on_data is set
+    HttpResponse perform(const HttpRequest& request);
+    
     // POST request with form data
     HttpResponse post_form(const std::string& url,
                            const std::map<std::string, std::string>& form_data,
                            const std::map<std::string, std::string>& extra_headers = std::map<std::string, std::string>());
+    
+    // Asynchronous counterparts, run on AsyncHttpEngine with this client's
+    // timeout. Callbacks run on the engine thread and must not block.
+    void get_async(const std::string& url,
+                   const std::map<std::string, std::string>& headers,
+                   HttpCallback on_done);
+    void post_json_async(const std::string& url,
+                         const Json& body,
+                         const std::map<std::string, std::string>& extra_headers,
+                         HttpCallback on_done);
+    std::future<HttpResponse> perform_async(const HttpRequest& request);
 
 private:
-    CURL* curl_;
+    friend class AsyncHttpEngine;
+    
     long timeout_ms_;
     
+    // Where write_callback puts body bytes
+    struct BodySink {
+        CURL* curl;
+        std::string* body;
+        const HttpDataCallback* on_data;
+        
+        BodySink() : curl(nullptr), body(nullptr), on_data(nullptr) {}
+    };
+    
+    // Shared by the blocking client and the async engine. Returns the
+    // header list the caller must free once the transfer is done.
+    static struct curl_slist* setup_handle(CURL* curl,
+                                           const std::string& method,
+                                           const std::string& url,
+                                           const std::string& body,
+                                           const std::map<std::string, std::string>& headers,
+                                           long timeout_ms,
+                                           BodySink* sink,
+                                           std::map<std::string, std::string>* response_headers);
+    static void finish_response(CURL* curl, CURLcode res, HttpResponse& resp);
+    
     HttpResponse perform_request(const std::string& method,
                                  const std::string& url,
                                  const std::string& body,
-                                 const std::map<std::string, std::string>& headers);
+                                 const std::map<std::string, std::string>& headers,
+                                 long timeout_ms,
+                                 const HttpDataCallback* on_data);
     
     static size_t write_callback(char* ptr, size_t size, size_t nmemb, void* userdata);
     static size_t header_callback(char* buffer, size_t size, size_t nitems, void* userdata);
-    static std::string url_encode(CURL* curl, const std::string& s);
+    static std::string url_encode(const std::string& s);
+};
+
+// ============================================================================
+// Connection pool
+// ============================================================================
+
+// Process-wide pool of keep-alive easy handles, grouped by host. Every
+// handle is attached to one CURLSH so DNS lookups, TLS sessions and open
+// connections are reused across HttpClient instances and the async
+// engine instead of paying a fresh handshake per request.
+class HTTP_API HttpConnectionPool {
+public:
+    struct Stats {
+        uint64_t handles_created;
+        uint64_t handles_reused;
+        uint64_t connections_opened;   // New TCP/TLS connections (CURLINFO_NUM_CONNECTS)
+        uint64_t requests;
+        size_t idle;
+        
+        Stats() : handles_created(0), handles_reused(0), connections_opened(0),
+                  requests(0), idle(0) {}
+    };
+    
+    static HttpConnectionPool& instance();
+    
+    // http2: negotiate HTTP/2 over TLS (and multiplex in the async engine)
+    // max_idle_per_host: idle handles kept per scheme://host:port
+    void configure(bool http2, size_t max_idle_per_host);
+    bool http2() const { return http2_.load(); }
+    
+    // Take a reset handle for url (never null unless curl is out of memory)
+    CURL* acquire(const std::string& url);
+    
+    // Return a handle after its transfer completed
+    void release(const std::string& url, CURL* handle);
+    
+    // Options a pooled handle needs after every curl_easy_reset()
+    void apply(CURL* handle, const std::string& url) const;
+    
+    Stats stats() const;
+    
+    // Close every idle handle (call before curl_global_cleanup)
+    void clear();
+    
+private:
+    HttpConnectionPool();
+    ~HttpConnectionPool();
+    HttpConnectionPool(const HttpConnectionPool&);
+    HttpConnectionPool& operator=(const HttpConnectionPool&);
+    
+    static std::string host_key(const std::string& url);
+    static void lock_share(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlock_share(CURL* handle, curl_lock_data data, void* userptr);
+    
+    CURLSH* share_;
+    std::mutex share_locks_[CURL_LOCK_DATA_LAST];
+    
+    mutable std::mutex mutex_;
+    std::map<std::string, std::vector<CURL*> > idle_;
+    size_t idle_count_;
+    size_t max_idle_per_host_;
+    std::atomic<bool> http2_;
+    
+    std::atomic<uint64_t> handles_created_;
+    std::atomic<uint64_t> handles_reused_;
+    std::atomic<uint64_t> connections_opened_;
+    std::atomic<uint64_t> requests_;
+};
+
+// ============================================================================
+// Asynchronous HTTP engine
+// ============================================================================
+
+// Process-wide curl multi loop on a dedicated thread: the one I/O thread
+// for channel polling, sends and provider calls. Requests are multiplexed
+// on it over the shared connection pool, so a slow upstream or a long poll
+// costs no worker. Callbacks run on the engine thread and must not block -
+// hand any real work to a thread pool.
+class HTTP_API AsyncHttpEngine {
+public:
+    static AsyncHttpEngine& instance();
+    
+    // Queue a request; on_done is always called exactly once
+    void submit(const HttpRequest& request, HttpCallback on_done);
+    
+    // Queue a request and wait on the result whenever convenient (never
+    // from a callback of this engine)
+    std::future<HttpResponse> submit(const HttpRequest& request);
+    
+    // Requests submitted but not yet completed
+    size_t in_flight() const { return in_flight_.load(); }
+    
+    // Stop the loop; outstanding requests complete with an error
+    void shutdown();
+    
+private:
+    struct Transfer;
+    
+    AsyncHttpEngine();
+    ~AsyncHttpEngine();
+    AsyncHttpEngine(const AsyncHttpEngine&);
+    AsyncHttpEngine& operator=(const AsyncHttpEngine&);
+    
+    void loop();
+    void start_submitted();
+    void reap_completed();
+    void complete(Transfer* t, CURLcode res);
+    
+    CURLM* multi_;
+    std::thread thread_;                    // Started by the first submit, under mutex_
+    std::mutex mutex_;
+    std::vector<Transfer*> submitted_;      // Waiting to be added to multi_
+    std::map<CURL*, Transfer*> active_;     // Engine thread only
+    std::atomic<bool> stop_;                // Set under mutex_
+    std::atomic<size_t> in_flight_;
 };
 
 } // namespace openclaw
@@ -19,7 +19,9 @@ namespace openclaw {
 // Type alias for nlohmann::json
 using Json = nlohmann::json;
 
-// Convenience functions for common operations (backwards compatibility)
+// Convenience functions for common operations (backwards compatibility).
+// The get_* helpers look the key up once; for whole payloads see
+// JsonReader (json_reader.hpp), which skips the tree altogether.
 namespace json_utils {
 
 // Check if JSON object has a key
@@ -29,23 +31,21 @@ inline bool has(const Json& j, const std::string& key) {
 
 // Safe string extraction with default
 inline std::string get_string(const Json& j, const std::string& key, const std::string& def = "") {
-    if (j.is_object() && j.contains(key)) {
-        const auto& val = j[key];
-        if (val.is_string()) {
-            return val.get<std::string>();
-        }
+    auto it = j.find(key);
+    if (it != j.end() && it->is_string()) {
+        return it->get<std::string>();
     }
     return def;
 }
 
 // Safe int extraction with default
 inline int64_t get_int(const Json& j, const std::string& key, int64_t def = 0) {
-    if (j.is_object() && j.contains(key)) {
-        const auto& val = j[key];
-        if (val.is_number_integer()) {
-            return val.get<int64_t>();
-        } else if (val.is_number()) {
-            return static_cast<int64_t>(val.get<double>());
+    auto it = j.find(key);
+    if (it != j.end()) {
+        if (it->is_number_integer()) {
+            return it->get<int64_t>();
+        } else if (it->is_number()) {
+            return static_cast<int64_t>(it->get<double>());
         }
     }
     return def;
@@ -53,22 +53,18 @@ inline int64_t get_int(const Json& j, const std::string& key, int64_t def = 0) {
 
 // Safe double extraction with default
 inline double get_double(const Json& j, const std::string& key, double def = 0.0) {
-    if (j.is_object() && j.contains(key)) {
-        const auto& val = j[key];
-        if (val.is_number()) {
-            return val.get<double>();
-        }
+    auto it = j.find(key);
+    if (it != j.end() && it->is_number()) {
+        return it->get<double>();
     }
     return def;
 }
 
 // Safe bool extraction with default
 inline bool get_bool(const Json& j, const std::string& key, bool def = false) {
-    if (j.is_object() && j.contains(key)) {
-        const auto& val = j[key];
-        if (val.is_boolean()) {
-            return val.get<bool>();
-        }
+    auto it = j.find(key);
+    if (it != j.end() && it->is_boolean()) {
+        return it->get<bool>();
     }
     return def;
 }
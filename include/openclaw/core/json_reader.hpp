@@ -0,0 +1,267 @@
+#ifndef OPENCLAW_CORE_JSON_READER_HPP
+#define OPENCLAW_CORE_JSON_READER_HPP
+
+/*
+ * OpenClaw streaming JSON reader
+ *
+ * Decodes a JSON text straight into the caller's structs, without building
+ * a Json tree first. Handlers are registered by path and called as the
+ * nlohmann SAX parser reaches the values; everything else is skipped.
+ *
+ * Paths join object keys with '.' and stand for any array element with
+ * '*': "content.*.text" is the text of every block of the content array.
+ * The root is "". on_begin / on_end fire around objects and arrays (e.g.
+ * to start and finish one struct per array element), and capture() turns
+ * the subtree at a path into a Json for the rare part that really is free
+ * form (tool input, say).
+ *
+ * A reader is set up once and may parse any number of texts.
+ */
+
+#include <openclaw/core/json.hpp>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+
+namespace openclaw {
+
+// One scalar, as the parser produced it
+class JsonValue {
+public:
+    enum Type { NUL, BOOLEAN, INTEGER, UNSIGNED, FLOAT, STRING };
+
+    explicit JsonValue(Type type) : type_(type), b_(false), i_(0), u_(0), d_(0.0), s_(nullptr) {}
+
+    Type type() const { return type_; }
+    bool is_null() const { return type_ == NUL; }
+    bool is_string() const { return type_ == STRING; }
+    bool is_number() const { return type_ == INTEGER || type_ == UNSIGNED || type_ == FLOAT; }
+    bool is_boolean() const { return type_ == BOOLEAN; }
+
+    std::string as_string(const std::string& def = "") const { return s_ ? *s_ : def; }
+    // Moves a string value out of the parser; def for anything else
+    std::string take_string(const std::string& def = "") { return s_ ? std::move(*s_) : def; }
+
+    int64_t as_int(int64_t def = 0) const {
+        switch (type_) {
+            case INTEGER: return i_;
+            case UNSIGNED: return static_cast<int64_t>(u_);
+            case FLOAT: return static_cast<int64_t>(d_);
+            default: return def;
+        }
+    }
+
+    double as_number(double def = 0.0) const {
+        switch (type_) {
+            case INTEGER: return static_cast<double>(i_);
+            case UNSIGNED: return static_cast<double>(u_);
+            case FLOAT: return d_;
+            default: return def;
+        }
+    }
+
+    bool as_bool(bool def = false) const { return type_ == BOOLEAN ? b_ : def; }
+
+    // As a Json, for captured scalars
+    Json to_json() const {
+        switch (type_) {
+            case BOOLEAN: return Json(b_);
+            case INTEGER: return Json(i_);
+            case UNSIGNED: return Json(u_);
+            case FLOAT: return Json(d_);
+            case STRING: return Json(*s_);
+            default: return Json();
+        }
+    }
+
+private:
+    friend class JsonReader;
+
+    Type type_;
+    bool b_;
+    int64_t i_;
+    uint64_t u_;
+    double d_;
+    std::string* s_;
+};
+
+class JsonReader {
+public:
+    typedef std::function<void(JsonValue& value)> ValueHandler;
+    typedef std::function<void()> EventHandler;
+    typedef std::function<void(Json& subtree)> CaptureHandler;
+
+    JsonReader() : capturing_(false) {}
+
+    // Scalar at path
+    void on(const std::string& path, ValueHandler handler) { values_[path] = handler; }
+
+    // Object or array at path starts / ends
+    void on_begin(const std::string& path, EventHandler handler) { begins_[path] = handler; }
+    void on_end(const std::string& path, EventHandler handler) { ends_[path] = handler; }
+
+    // Whole value at path, built as a Json
+    void capture(const std::string& path, CaptureHandler handler) { captures_[path] = handler; }
+
+    // Shorthands storing a scalar of the right type into target (which
+    // must outlive the reader); values of other types are ignored
+    void bind(const std::string& path, std::string& target) {
+        on(path, [&target](JsonValue& v) { if (v.is_string()) target = v.take_string(); });
+    }
+    void bind(const std::string& path, int64_t& target) {
+        on(path, [&target](JsonValue& v) { if (v.is_number()) target = v.as_int(); });
+    }
+    void bind(const std::string& path, int& target) {
+        on(path, [&target](JsonValue& v) { if (v.is_number()) target = static_cast<int>(v.as_int()); });
+    }
+    void bind(const std::string& path, double& target) {
+        on(path, [&target](JsonValue& v) { if (v.is_number()) target = v.as_number(); });
+    }
+    void bind(const std::string& path, bool& target) {
+        on(path, [&target](JsonValue& v) { if (v.is_boolean()) target = v.as_bool(); });
+    }
+
+    // Run the handlers over text. False (with error set) if it is not
+    // valid JSON; handlers may already have run for the part before.
+    bool parse(const std::string& text, std::string* error = nullptr) {
+        path_.clear();
+        frames_.clear();
+        capturing_ = false;
+        stack_.clear();
+        error_.clear();
+        Sax sax(*this);
+        bool ok = Json::sax_parse(text, &sax);
+        if (!ok && error) *error = error_;
+        return ok;
+    }
+
+private:
+    // The nlohmann SAX interface, forwarded to the reader
+    struct Sax {
+        JsonReader& r;
+        explicit Sax(JsonReader& reader) : r(reader) {}
+
+        bool null() { JsonValue v(JsonValue::NUL); return r.scalar(v); }
+        bool boolean(bool val) { JsonValue v(JsonValue::BOOLEAN); v.b_ = val; return r.scalar(v); }
+        bool number_integer(Json::number_integer_t val) {
+            JsonValue v(JsonValue::INTEGER); v.i_ = val; return r.scalar(v);
+        }
+        bool number_unsigned(Json::number_unsigned_t val) {
+            JsonValue v(JsonValue::UNSIGNED); v.u_ = val; return r.scalar(v);
+        }
+        bool number_float(Json::number_float_t val, const std::string&) {
+            JsonValue v(JsonValue::FLOAT); v.d_ = val; return r.scalar(v);
+        }
+        bool string(std::string& val) { JsonValue v(JsonValue::STRING); v.s_ = &val; return r.scalar(v); }
+        bool binary(Json::binary_t&) { JsonValue v(JsonValue::NUL); return r.scalar(v); }
+        bool start_object(std::size_t) { return r.begin(false); }
+        bool key(std::string& val) { return r.key(val); }
+        bool end_object() { return r.end(); }
+        bool start_array(std::size_t) { return r.begin(true); }
+        bool end_array() { return r.end(); }
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& e) {
+            r.error_ = e.what();
+            return false;
+        }
+    };
+
+    bool scalar(JsonValue& v) {
+        if (capturing_) {
+            add(v.to_json());
+            return true;
+        }
+        if (!values_.empty()) {
+            auto it = values_.find(path_);
+            if (it != values_.end()) it->second(v);
+        }
+        if (!captures_.empty()) {
+            auto it = captures_.find(path_);
+            if (it != captures_.end()) {
+                Json j = v.to_json();
+                it->second(j);
+            }
+        }
+        return true;
+    }
+
+    bool begin(bool array) {
+        if (capturing_) {
+            Json* child = add(array ? Json::array() : Json::object());
+            stack_.push_back(child);
+            return true;
+        }
+        if (!captures_.empty() && captures_.count(path_)) {
+            capturing_ = true;
+            captured_ = array ? Json::array() : Json::object();
+            stack_.push_back(&captured_);
+            return true;
+        }
+        if (!begins_.empty()) {
+            auto it = begins_.find(path_);
+            if (it != begins_.end()) it->second();
+        }
+        frames_.push_back(path_.size());
+        if (array) path_ += path_.empty() ? "*" : ".*";
+        return true;
+    }
+
+    bool key(std::string& k) {
+        if (capturing_) {
+            key_ = k;
+            return true;
+        }
+        path_.resize(frames_.back());
+        if (!path_.empty()) path_ += '.';
+        path_ += k;
+        return true;
+    }
+
+    bool end() {
+        if (capturing_) {
+            stack_.pop_back();
+            if (stack_.empty()) {
+                capturing_ = false;
+                captures_[path_](captured_);
+            }
+            return true;
+        }
+        path_.resize(frames_.back());
+        frames_.pop_back();
+        if (!ends_.empty()) {
+            auto it = ends_.find(path_);
+            if (it != ends_.end()) it->second();
+        }
+        return true;
+    }
+
+    // Add to the captured container being built; the new value
+    Json* add(const Json& value) {
+        Json& top = *stack_.back();
+        if (top.is_array()) {
+            top.push_back(value);
+            return &top.back();
+        }
+        Json& slot = top[key_];
+        slot = value;
+        return &slot;
+    }
+
+    std::unordered_map<std::string, ValueHandler> values_;
+    std::unordered_map<std::string, EventHandler> begins_;
+    std::unordered_map<std::string, EventHandler> ends_;
+    std::unordered_map<std::string, CaptureHandler> captures_;
+
+    std::string path_;                  // Of the value being parsed
+    std::vector<size_t> frames_;        // Path length at each open container
+    bool capturing_;
+    Json captured_;
+    std::vector<Json*> stack_;          // Open containers of captured_
+    std::string key_;                   // Of the next captured member
+    std::string error_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_JSON_READER_HPP
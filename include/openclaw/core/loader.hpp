@@ -36,9 +36,10 @@ struct LoadedPlugin {
     Plugin* instance;               // Plugin instance
     CreatePluginFunc create_func;
     DestroyPluginFunc destroy_func;
+    int64_t load_us;                // dlopen through instance creation
     
     LoadedPlugin() : handle(nullptr), instance(nullptr), 
-                     create_func(nullptr), destroy_func(nullptr) {}
+                     create_func(nullptr), destroy_func(nullptr), load_us(0) {}
 };
 
 // Dynamic plugin loader
@@ -1,10 +1,37 @@
 #ifndef OPENCLAW_CORE_LOGGER_HPP
 #define OPENCLAW_CORE_LOGGER_HPP
 
+/*
+ * OpenClaw logger
+ *
+ * Records are formatted on the calling thread and, once configured for
+ * it, handed to a background writer through a per-thread ring buffer:
+ * the caller never takes a lock, touches the clock beyond a coarse read
+ * or waits on I/O. The writer merges the rings in call order, stamps
+ * times from a per-second cache and writes whole batches at once, to
+ * stderr or a size-rotated file, as text or JSON lines. A full ring
+ * drops the record and counts it rather than block.
+ *
+ * Until configure() (and after shutdown()) records are written directly,
+ * still one whole line at a time.
+ *
+ * The LOG_* macros check the level before their arguments are evaluated,
+ * and levels below OPENCLAW_MIN_LOG_LEVEL (Makefile: LOG_MIN_LEVEL) are
+ * compiled out altogether.
+ */
+
 #include <string>
 #include <cstdio>
 #include <ctime>
 #include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+// Lowest level compiled in: 0 debug, 1 info, 2 warn, 3 error
+#ifndef OPENCLAW_MIN_LOG_LEVEL
+#define OPENCLAW_MIN_LOG_LEVEL 0
+#endif
 
 namespace openclaw {
 
@@ -22,13 +49,42 @@ enum class LogLevel {
     ERROR = 3
 };
 
+struct LogOptions {
+    bool async;                 // Background writer; false writes on the caller
+    std::string format;         // "text" or "json" (JSON lines)
+    std::string file;           // Empty: stderr
+    size_t max_file_bytes;      // Rotate the file past this (0 = never)
+    int max_files;              // Rotated files kept: file.1 .. file.N
+    size_t ring_bytes;          // Per-thread buffer; records beyond it are dropped
+
+    LogOptions() : async(true), format("text"), max_file_bytes(0), max_files(5),
+                   ring_bytes(256 * 1024) {}
+};
+
 class LOGGER_API Logger {
 public:
     static Logger& instance();
-    
+
     void set_level(LogLevel level);
     LogLevel level() const;
-    
+
+    // Whether records of this level are logged; one relaxed load
+    static bool enabled(LogLevel level) {
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+    }
+
+    // Switch to the given output; starts or stops the writer as needed
+    bool configure(const LogOptions& options);
+
+    // Wait until everything logged so far is written
+    void flush();
+
+    // Write out what is queued and go back to direct writes
+    void shutdown();
+
+    // Records dropped because a thread's ring was full
+    uint64_t dropped() const;
+
     void debug(const char* fmt, ...);
     void info(const char* fmt, ...);
     void warn(const char* fmt, ...);
@@ -36,19 +92,63 @@ public:
 
 private:
     Logger();
+    ~Logger();
     Logger(const Logger&);
     Logger& operator=(const Logger&);
-    
-    void log_impl(const char* level_str, const char* fmt, va_list args);
-    
-    LogLevel level_;
+
+    void log_impl(LogLevel level, const char* fmt, va_list args);
+
+    struct Backend;
+
+    static std::atomic<int> level_;
+    Backend* backend_;
+};
+
+// Session and turn stamped on the records of the current thread (JSON
+// format) while in scope; the previous ones come back afterwards
+class LOGGER_API LogContext {
+public:
+    LogContext(const std::string& session, const std::string& turn);
+    ~LogContext();
+
+private:
+    LogContext(const LogContext&);
+    LogContext& operator=(const LogContext&);
+
+    std::string session_;
+    std::string turn_;
+    const std::string* prev_session_;
+    const std::string* prev_turn_;
 };
 
-// Convenience macros
-#define LOG_DEBUG(...) openclaw::Logger::instance().debug(__VA_ARGS__)
-#define LOG_INFO(...)  openclaw::Logger::instance().info(__VA_ARGS__)
-#define LOG_WARN(...)  openclaw::Logger::instance().warn(__VA_ARGS__)
-#define LOG_ERROR(...) openclaw::Logger::instance().error(__VA_ARGS__)
+// Convenience macros. Arguments are only evaluated when the level is
+// enabled; below the compiled-in minimum the call is dead code (still
+// type-checked, so variables used only for logging stay "used").
+#define OPENCLAW_LOG_AT(level, method, ...) \
+    do { \
+        if (openclaw::Logger::enabled(level)) openclaw::Logger::instance().method(__VA_ARGS__); \
+    } while (0)
+#define OPENCLAW_LOG_OFF(method, ...) \
+    do { \
+        if (false) openclaw::Logger::instance().method(__VA_ARGS__); \
+    } while (0)
+
+#if OPENCLAW_MIN_LOG_LEVEL <= 0
+#define LOG_DEBUG(...) OPENCLAW_LOG_AT(openclaw::LogLevel::DEBUG, debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) OPENCLAW_LOG_OFF(debug, __VA_ARGS__)
+#endif
+#if OPENCLAW_MIN_LOG_LEVEL <= 1
+#define LOG_INFO(...)  OPENCLAW_LOG_AT(openclaw::LogLevel::INFO, info, __VA_ARGS__)
+#else
+#define LOG_INFO(...)  OPENCLAW_LOG_OFF(info, __VA_ARGS__)
+#endif
+#if OPENCLAW_MIN_LOG_LEVEL <= 2
+#define LOG_WARN(...)  OPENCLAW_LOG_AT(openclaw::LogLevel::WARN, warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...)  OPENCLAW_LOG_OFF(warn, __VA_ARGS__)
+#endif
+#define LOG_ERROR(...) OPENCLAW_LOG_AT(openclaw::LogLevel::ERROR, error, __VA_ARGS__)
 
 } // namespace openclaw
 
@@ -9,11 +9,96 @@
 
 #include "types.hpp"
 #include <string>
+#include <functional>
+#include <cstdint>
 
 namespace openclaw {
 
 // Forward declarations
 class Session;
+class Config;
+
+// ============================================================================
+// Admission Control
+// ============================================================================
+
+// What on_message does with an AI message once the pool is overloaded
+struct AdmissionConfig {
+    enum Policy {
+        REJECT,     // Drop the message silently (logged)
+        BUSY,       // Reply "busy, retry in N s"
+        COALESCE    // Merge into the session's queued message, else BUSY
+    };
+    
+    Policy policy;
+    size_t max_queue;           // Overloaded at this many pending tasks (0 = off)
+    int64_t max_wait_ms;        // Overloaded at this estimated wait (0 = off)
+    size_t queue_capacity;      // Hard ThreadPool capacity for all lanes (0 = unbounded)
+    int retry_hint_seconds;     // Used in BUSY replies when no estimate exists
+    
+    AdmissionConfig()
+        : policy(BUSY)
+        , max_queue(32)
+        , max_wait_ms(120000)
+        , queue_capacity(256)
+        , retry_hint_seconds(30) {}
+    
+    // Read admission.* keys
+    static AdmissionConfig from_config(const Config& cfg);
+    static Policy parse_policy(const std::string& name);
+};
+
+// ============================================================================
+// Response Routing
+// ============================================================================
+
+// Replies go to the channel the message came in on. Broadcast targets get
+// a copy of every reply as well.
+struct RoutingConfig {
+    struct Target {
+        std::string channel;
+        std::string to;             // Empty = the originating chat ID
+    };
+    
+    std::vector<Target> broadcast;
+    
+    // On channels that can edit messages, send the reply at its first
+    // token and edit it as it grows (at most once per edit_interval_ms)
+    bool stream_edits;
+    
+    RoutingConfig() : stream_edits(true) {}
+    
+    // Read routing.broadcast: channel IDs ("whatsapp") or objects
+    // ({"channel": "whatsapp", "to": "+15551234567"}); routing.stream_edits
+    static RoutingConfig from_config(const Config& cfg);
+};
+
+// ============================================================================
+// Memory Recall Prefetch
+// ============================================================================
+
+// BM25 search of the user's text that runs while the session loads; the
+// best snippets go into the first model request so that common recall
+// questions need no memory_search round-trip
+struct RecallConfig {
+    bool enabled;
+    int max_results;            // Snippets considered
+    double min_score;           // Weaker matches are left out
+    int max_tokens;             // Budget for the injected block
+    int64_t wait_ms;            // How long the turn waits for a late search
+    size_t min_chars;           // Shorter messages are not searched
+    
+    RecallConfig()
+        : enabled(false)
+        , max_results(3)
+        , min_score(0.3)
+        , max_tokens(600)
+        , wait_ms(150)
+        , min_chars(12) {}
+    
+    // Read memory_recall.* keys
+    static RecallConfig from_config(const Config& cfg);
+};
 
 // ============================================================================
 // Message Handler Functions
@@ -27,18 +112,29 @@ class Session;
  * - Skill commands (matched skill names)
  * - AI for natural conversation
  * 
- * This is called from the thread pool after rate limiting.
+ * This is called from the thread pool after rate limiting. AI turns
+ * complete asynchronously; on_done runs once the response has been sent.
+ * Taken by value so callers that are done with the message can move it in.
  */
-void process_message(const Message& msg);
+void process_message(Message msg, std::function<void()> on_done = std::function<void()>(),
+                     int64_t queued_at_us = 0);
 
 /**
  * Main message callback for channels.
  * 
- * Performs deduplication, rate limiting, and enqueues
- * the message for processing in the thread pool.
+ * Performs deduplication, forwards the message to the node owning its
+ * session in cluster mode, and otherwise hands it to accept_message().
  */
 void on_message(const Message& msg);
 
+/**
+ * Runs a message on this node: rate limiting, then the thread pool.
+ * 
+ * Entry point for messages forwarded by other nodes. Returns false if
+ * the message's channel is not loaded here.
+ */
+bool accept_message(const Message& msg);
+
 /**
  * Error callback for channels.
  */
@@ -57,6 +153,13 @@ void notify_outgoing_message(
     const std::string& reply_to = ""
 );
 
+/**
+ * Notify plugins about progress of an agent turn.
+ * 
+ * Safe from any thread; plugins must not block in the hook.
+ */
+void notify_turn_event(const TurnEvent& event);
+
 // ============================================================================
 // Internal Message Processing
 // ============================================================================
@@ -64,7 +167,7 @@ void notify_outgoing_message(
 namespace detail {
 
 /**
- * Handle a slash command (built-in or skill).
+ * Handle a built-in slash command.
  * Returns the response to send, or empty string if command not found.
  */
 std::string handle_command(
@@ -75,21 +178,30 @@ std::string handle_command(
 
 /**
  * Handle a skill command invocation.
- * Returns true if a skill was matched and handled.
+ * Returns true if a skill was matched. Its reply (or error text) then goes
+ * to on_response, once the agent loop has run asynchronously; session must
+ * stay valid until then.
  */
 bool handle_skill_command(
     const Message& msg,
     Session& session,
     const std::string& cmd_text,
-    std::string& response_out
+    std::function<void(const std::string&)> on_response
 );
 
 /**
  * Handle a regular (non-command) message via AI.
+ * Runs the agent loop asynchronously and calls on_response with the reply
+ * (or error text). session must stay valid until then. queued_at_us is the
+ * AgentTrace::clock_us() time the message was queued (0 = unknown).
+ * recalled is prefetched memory for the first request (may be empty).
  */
-std::string handle_ai_message(
+void handle_ai_message(
     const Message& msg,
-    Session& session
+    Session& session,
+    std::function<void(const std::string&)> on_response,
+    int64_t queued_at_us = 0,
+    const std::string& recalled = std::string()
 );
 
 /**
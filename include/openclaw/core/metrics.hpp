@@ -0,0 +1,269 @@
+/*
+ * OpenClaw C++11 - Runtime Metrics
+ *
+ * Process-wide counters, gauges and fixed-bucket histograms, rendered in
+ * the Prometheus text exposition format (the gateway serves it on
+ * /metrics).
+ *
+ * Features:
+ * - Recording never locks: each value is split into per-thread shards of
+ *   relaxed atomics, one cache line apart, summed when scraped
+ * - Labelled series live in a fixed-size table that is searched without
+ *   a lock; only the first use of a label set takes the registry lock
+ * - Gauges are read from callbacks at scrape time, so state that is
+ *   already tracked elsewhere (pool depth, sessions) costs nothing
+ *
+ * Hot paths keep a reference from a function-local static:
+ *   static HistogramFamily& latency = Metrics::instance().histogram_family(...);
+ *   latency.get(provider, model).observe(seconds);
+ *
+ * StageLatency keeps raw samples instead, for the exact tail percentiles
+ * a load run reports (see the loadgen plugin). It is off by default.
+ */
+#ifndef OPENCLAW_CORE_METRICS_HPP
+#define OPENCLAW_CORE_METRICS_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace openclaw {
+
+// Visibility attribute so plugins record into the main binary's registry
+#ifdef __GNUC__
+#  define METRICS_API __attribute__((visibility("default")))
+#else
+#  define METRICS_API
+#endif
+
+// Shards per value; threads are spread over them round-robin
+static const size_t METRIC_SHARDS = 16;
+
+// One relaxed atomic on its own cache line
+struct MetricCell {
+    std::atomic<uint64_t> value;
+    char pad[64 - sizeof(std::atomic<uint64_t>)];
+
+    MetricCell() : value(0) {}
+};
+
+// Monotonically increasing count
+class METRICS_API Counter {
+public:
+    void inc(uint64_t n = 1);
+    uint64_t value() const;
+
+private:
+    MetricCell cells_[METRIC_SHARDS];
+};
+
+// Observations counted into fixed buckets (upper bounds, ascending).
+// The sum is kept in millionths, which is exact enough for seconds.
+class METRICS_API Histogram {
+public:
+    explicit Histogram(const std::vector<double>& bounds);
+    ~Histogram();
+
+    void observe(double value);
+    void observe_us(int64_t us) { observe(static_cast<double>(us) / 1e6); }
+
+    const std::vector<double>& bounds() const { return bounds_; }
+    // Cumulative counts per bound then +Inf, plus the sum
+    void snapshot(std::vector<uint64_t>& cumulative, double& sum) const;
+
+private:
+    Histogram(const Histogram&);
+    Histogram& operator=(const Histogram&);
+
+    std::vector<double> bounds_;
+    size_t stride_;                     // Per shard: buckets, +Inf, sum; padded to a cache line
+    std::atomic<uint64_t>* values_;     // METRIC_SHARDS * stride_
+};
+
+// A metric name with its series, one per label value set
+class METRICS_API MetricFamily {
+public:
+    enum Type { COUNTER, GAUGE, HISTOGRAM };
+
+    MetricFamily(const std::string& name, const std::string& help, Type type,
+                 const std::vector<std::string>& label_names);
+    virtual ~MetricFamily();
+
+    const std::string& name() const { return name_; }
+    Type type() const { return type_; }
+
+    void render(std::string& out) const;
+
+protected:
+    // Series capacity; further label sets share one "other" series
+    static const size_t CAPACITY = 512;
+
+    struct Series {
+        std::vector<std::string> labels;
+        void* metric;
+    };
+
+    // Find or add the series for these label values (lock-free once added)
+    void* find(const std::string& a, const std::string& b, const std::string& c);
+
+    virtual void* create() const = 0;
+    virtual void render_series(std::string& out, const std::string& labels, const void* metric) const = 0;
+
+    std::string name_;
+    std::string help_;
+    Type type_;
+    std::vector<std::string> label_names_;
+
+private:
+    MetricFamily(const MetricFamily&);
+    MetricFamily& operator=(const MetricFamily&);
+
+    Series* insert(const std::vector<std::string>& labels, size_t hash);
+
+    std::atomic<Series*> slots_[CAPACITY];
+    std::atomic<size_t> size_;
+    Series* overflow_;
+    std::mutex insert_mutex_;
+};
+
+class METRICS_API CounterFamily : public MetricFamily {
+public:
+    CounterFamily(const std::string& name, const std::string& help,
+                  const std::vector<std::string>& label_names)
+        : MetricFamily(name, help, COUNTER, label_names) {}
+
+    Counter& get(const std::string& a = std::string(), const std::string& b = std::string(),
+                 const std::string& c = std::string()) {
+        return *static_cast<Counter*>(find(a, b, c));
+    }
+
+protected:
+    virtual void* create() const;
+    virtual void render_series(std::string& out, const std::string& labels, const void* metric) const;
+};
+
+class METRICS_API HistogramFamily : public MetricFamily {
+public:
+    HistogramFamily(const std::string& name, const std::string& help,
+                    const std::vector<std::string>& label_names, const std::vector<double>& bounds)
+        : MetricFamily(name, help, HISTOGRAM, label_names), bounds_(bounds) {}
+
+    Histogram& get(const std::string& a = std::string(), const std::string& b = std::string(),
+                   const std::string& c = std::string()) {
+        return *static_cast<Histogram*>(find(a, b, c));
+    }
+
+protected:
+    virtual void* create() const;
+    virtual void render_series(std::string& out, const std::string& labels, const void* metric) const;
+
+private:
+    std::vector<double> bounds_;
+};
+
+class METRICS_API Metrics {
+public:
+    typedef std::function<double()> GaugeReader;
+
+    static Metrics& instance();
+
+    // Latency buckets in seconds, 5ms to 2min
+    static std::vector<double> latency_buckets();
+
+    // Registration returns the existing family when the name is taken
+    CounterFamily& counter_family(const std::string& name, const std::string& help,
+                                  const std::vector<std::string>& label_names);
+    HistogramFamily& histogram_family(const std::string& name, const std::string& help,
+                                      const std::vector<std::string>& label_names,
+                                      const std::vector<double>& bounds);
+    Counter& counter(const std::string& name, const std::string& help);
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         const std::vector<double>& bounds);
+
+    // A gauge series read at scrape time; series of one name share its help
+    void gauge(const std::string& name, const std::string& help, GaugeReader read,
+               const std::vector<std::string>& label_names = std::vector<std::string>(),
+               const std::vector<std::string>& label_values = std::vector<std::string>());
+
+    // Everything, in the Prometheus text format (version 0.0.4)
+    std::string render() const;
+
+private:
+    Metrics() {}
+    ~Metrics();
+    Metrics(const Metrics&);
+    Metrics& operator=(const Metrics&);
+
+    MetricFamily* find_locked(const std::string& name) const;
+
+    struct Gauge {
+        std::string name;
+        std::string help;
+        std::string labels;     // Rendered {a="x"} or empty
+        GaugeReader read;
+    };
+
+    std::vector<MetricFamily*> families_;
+    std::vector<Gauge> gauges_;
+    mutable std::mutex mutex_;
+};
+
+// Latency samples per named stage, summarized as exact percentiles. Off
+// until enable(); while off, record() is one relaxed load. While on, each
+// sample takes a lock, which a measurement run can afford and production
+// should not (the histograms above serve it). Past max_samples a stage
+// keeps a uniform random subset, its count and max staying exact.
+class METRICS_API StageLatency {
+public:
+    struct Summary {
+        std::string stage;
+        uint64_t count;
+        double mean_us;
+        int64_t p50_us;
+        int64_t p99_us;
+        int64_t p999_us;
+        int64_t max_us;
+
+        Summary() : count(0), mean_us(0), p50_us(0), p99_us(0), p999_us(0), max_us(0) {}
+    };
+
+    static StageLatency& instance();
+
+    void enable(size_t max_samples = 1000000);
+    void disable() { enabled_.store(false, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void record(const std::string& stage, int64_t us);
+
+    // Drop all samples (e.g. after a warm-up)
+    void reset();
+
+    // One entry per stage, in the order the stages were first recorded
+    std::vector<Summary> summarize() const;
+
+private:
+    StageLatency() : enabled_(false), max_samples_(0), rng_state_(0x9E3779B97F4A7C15ULL) {}
+    StageLatency(const StageLatency&);
+    StageLatency& operator=(const StageLatency&);
+
+    struct Stage {
+        std::string name;
+        std::vector<int64_t> samples;
+        uint64_t count;
+        double sum_us;
+        int64_t max_us;
+    };
+
+    std::atomic<bool> enabled_;
+    size_t max_samples_;
+    std::vector<Stage> stages_;
+    uint64_t rng_state_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_METRICS_HPP
@@ -4,6 +4,7 @@
 #include "../core/config.hpp"
 #include "../core/types.hpp"
 #include <string>
+#include <vector>
 
 namespace openclaw {
 
@@ -17,16 +18,32 @@ public:
     virtual const char* version() const = 0;
     virtual const char* description() const { return ""; }
     
-    // Lifecycle
+    // Lifecycle. init() may run on a worker thread, concurrently with the
+    // init() of plugins it does not depend on.
     virtual bool init(const Config& cfg) = 0;
     virtual void shutdown() = 0;
     
+    // Optional: re-read the settings that can change without a restart
+    // (limits, timeouts) after the config file was reloaded. Runs on the
+    // main loop while the plugin is in use, so settings read on other
+    // threads must be swapped in whole (see Snapshot).
+    virtual void reconfigure(const Config& /* cfg */) {}
+    
+    // Optional: names (as in name()) of plugins whose init() must have
+    // finished before this one's starts. Unknown names are ignored.
+    virtual std::vector<std::string> dependencies() const { return std::vector<std::string>(); }
+    
     // Plugin state
     virtual bool is_initialized() const { return initialized_; }
     
     // Optional: plugins can override this for periodic updates
     virtual void poll() {}
     
+    // How often the main loop calls poll(), in ms; 0 = never. Event-driven
+    // plugins register file descriptors and timers with the Reactor and
+    // return 0; the default keeps polling plugins on the old 100 ms cycle.
+    virtual int poll_interval_ms() const { return 100; }
+    
     // Optional: plugins can override this to receive all incoming messages
     // (useful for gateway/logging plugins that need to see all traffic)
     virtual void on_incoming_message(const Message& /* msg */) {}
@@ -37,6 +54,11 @@ public:
                                      const std::string& /* chat_id */,
                                      bool /* typing */) {}
     
+    // Optional: plugins can override this to follow agent turns as they run
+    // (streamed text, tool calls, completion). Called on provider I/O and
+    // tool threads, so it must not block.
+    virtual void on_turn_event(const TurnEvent& /* event */) {}
+    
 protected:
     bool initialized_;
     
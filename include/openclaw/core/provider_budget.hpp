@@ -0,0 +1,126 @@
+/*
+ * OpenClaw C++11 - Provider Budget
+ *
+ * Admission control for AI provider calls. Providers throttle on requests,
+ * input tokens and output tokens per minute, not on messages per user, so
+ * every chat call reserves its estimated tokens here first and waits while
+ * the provider's minute budget is spent instead of collecting a 429.
+ *
+ * Features:
+ * - Per-provider token buckets (requests, input, output and total tokens)
+ *   refilled continuously at limit/60s
+ * - Limits and remaining budget learned from rate-limit response headers
+ *   (anthropic-ratelimit-*, x-ratelimit-*); unknown limits never block
+ * - 429/529 responses block the provider for retry-after, or back off
+ *   exponentially when the header is missing
+ * - Waiting calls are admitted in order, except that a smaller call that
+ *   fits may pass the head a bounded number of times; nothing waits longer
+ *   than max_wait
+ */
+#ifndef OPENCLAW_CORE_PROVIDER_BUDGET_HPP
+#define OPENCLAW_CORE_PROVIDER_BUDGET_HPP
+
+#include "timer_wheel.hpp"
+#include <string>
+#include <map>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+namespace openclaw {
+
+struct CompletionResult;
+
+class ProviderBudget {
+public:
+    typedef uint64_t Ticket;
+    // Called once the call may go out; pass the ticket back to release()
+    typedef std::function<void(Ticket)> AdmitCallback;
+
+    ProviderBudget();
+    ~ProviderBudget();
+
+    // Longest a call waits before it is sent regardless (default: 60s)
+    void set_max_wait(int64_t ms) { max_wait_ms_ = ms > 0 ? ms : 0; }
+    // Times a waiting head may be passed by smaller calls (default: 4)
+    void set_max_skips(int n) { max_skips_ = n > 0 ? n : 0; }
+
+    // Reserve one request and the estimated tokens. admit runs immediately
+    // on this thread when they fit, otherwise later from the timer wheel or
+    // from the release() that made room.
+    void acquire(const std::string& provider, int input_tokens, int output_tokens,
+                 AdmitCallback admit);
+
+    // Settle a reservation with the provider's answer: correct the estimate
+    // with actual usage and learn limits and throttling from the headers
+    void release(Ticket ticket, const CompletionResult& result);
+
+    // Milliseconds the provider is blocked for after a 429 (0 = not blocked)
+    int64_t blocked_for_ms(const std::string& provider) const;
+    size_t waiting() const;
+
+private:
+    ProviderBudget(const ProviderBudget&);
+    ProviderBudget& operator=(const ProviderBudget&);
+
+    enum { REQUESTS, INPUT, OUTPUT, TOKENS, DIMENSIONS };
+
+    struct Bucket {
+        double limit;       // Per minute, 0 = unknown
+        double level;       // Available now; negative after an overrun
+        int64_t reserved;   // Held by calls still in flight
+
+        Bucket() : limit(0), level(0), reserved(0) {}
+    };
+
+    struct Waiter {
+        Ticket ticket;
+        int64_t need[DIMENSIONS];
+        int64_t since_ms;
+        int skips;
+        AdmitCallback admit;
+    };
+
+    struct Provider {
+        Bucket buckets[DIMENSIONS];
+        int64_t refilled_ms;
+        int64_t blocked_until_ms;
+        int strikes;                    // 429s in a row, for backoff
+        std::deque<Waiter> waiters;
+        TimerWheel::TimerId timer;
+
+        Provider() : refilled_ms(0), blocked_until_ms(0), strikes(0), timer(0) {}
+    };
+
+    struct Reservation {
+        std::string provider;
+        int64_t need[DIMENSIONS];
+    };
+
+    typedef std::vector<std::pair<AdmitCallback, Ticket> > Admitted;
+
+    void refill_locked(Provider& p, int64_t now_ms);
+    bool fits_locked(const Provider& p, const int64_t* need, int64_t now_ms) const;
+    int64_t wait_ms_locked(const Provider& p, const int64_t* need, int64_t now_ms) const;
+    void take_locked(const std::string& name, Provider& p, const Waiter& w);
+    void learn_locked(Provider& p, const CompletionResult& result, int64_t now_ms);
+    // Admit what fits now, then arm the timer for the head
+    void pump_locked(const std::string& name, Provider& p, int64_t now_ms, Admitted& out);
+    void on_timer(const std::string& name);
+    static void run(Admitted& admitted);
+
+    std::atomic<int64_t> max_wait_ms_;     // Settable while calls wait
+    std::atomic<int> max_skips_;
+    Ticket next_ticket_;
+    std::map<std::string, Provider> providers_;
+    std::map<Ticket, Reservation> reservations_;
+    TimerWheel& wheel_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_PROVIDER_BUDGET_HPP
@@ -1,10 +1,15 @@
 #ifndef OPENCLAW_CORE_RATE_LIMITER_HPP
 #define OPENCLAW_CORE_RATE_LIMITER_HPP
 
+#include "timer_wheel.hpp"
 #include <string>
 #include <vector>
 #include <map>
 #include <deque>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <mutex>
 #include <cstdint>
 
 namespace openclaw {
@@ -88,7 +93,64 @@ private:
     std::deque<int64_t> timestamps_;
 };
 
-// Per-key rate limiter (e.g., per user, per channel)
+// Limit a KeyedRateLimiter enforces, applied to one atomic state word
+// (its own, or one in a shared RateLimitStore). Times are CLOCK_MONOTONIC,
+// which all processes on a host share.
+// - Token bucket: GCRA, i.e. the bucket kept as its next arrival time (us)
+// - Sliding window: two-window counter, the previous window's count
+//   weighted by how much of it still overlaps the sliding window; the word
+//   is window index << 32 | previous count << 16 | count
+struct RateLimitPolicy {
+    bool sliding_window;
+    int limit;                  // Bucket size / requests per window
+    int64_t interval_us;        // Token bucket: time to refill one token
+    int64_t burst_us;           // Token bucket: tolerance for limit back-to-back
+    int64_t window_ms;          // Sliding window
+    
+    RateLimitPolicy()
+        : sliding_window(false)
+        , limit(1)
+        , interval_us(1000000)
+        , burst_us(0)
+        , window_ms(1000) {}
+    
+    static RateLimitPolicy token_bucket(int limit, int refill_per_second);
+    static RateLimitPolicy token_bucket_interval(int limit, int64_t refill_interval_us);
+    static RateLimitPolicy window(int limit, int window_seconds);
+    
+    // Take n units with a CAS loop, all or nothing
+    RateLimitResult take(std::atomic<int64_t>& state, int n, int64_t now_us) const;
+    
+    // Seconds after its last use a state word is as good as a fresh one
+    int64_t idle_seconds() const;
+    
+    static int64_t now_us();
+};
+
+// Rate-limit and dedup state shared by several openclaw processes (see
+// ShmRateLimitStore). Calls may come from any thread.
+class RateLimitStore {
+public:
+    virtual ~RateLimitStore() {}
+    
+    // Take n units of key's budget under policy. Returns n, 0 when denied
+    // (result says when to retry) or -1 when the store cannot serve the key.
+    virtual int lease(const std::string& key, const RateLimitPolicy& policy, int n,
+                      RateLimitResult& result) = 0;
+    
+    // Record a message ID (MessageDebouncer::hash_id). Returns 1 if new, 0
+    // if seen within window_seconds, -1 when the store cannot serve the ID.
+    virtual int mark_seen(uint64_t id_hash, int window_seconds) = 0;
+};
+
+// Per-key rate limiter (e.g., per user, per channel). Safe to call from
+// any thread: keys live in lock-striped shards (the lock covers the hash
+// lookup only) and each key's limit is decided with a CAS on one atomic
+// word, in constant memory per key (see RateLimitPolicy).
+// With a RateLimitStore the budget is shared between processes; tokens are
+// leased from it in batches and spent locally, so most checks never touch
+// the store. Idle keys expire through the shared TimerWheel once
+// set_idle_expiry is on.
 class KeyedRateLimiter {
 public:
     enum LimiterType {
@@ -96,7 +158,10 @@ public:
         SLIDING_WINDOW
     };
     
+    // limit: bucket size / requests per window; window_or_rate: tokens
+    // refilled per second (TOKEN_BUCKET) or window seconds (SLIDING_WINDOW)
     KeyedRateLimiter(LimiterType type, int limit, int window_or_rate);
+    ~KeyedRateLimiter();
     
     // Check rate limit for a key
     RateLimitResult check(const std::string& key);
@@ -107,31 +172,67 @@ public:
     // Reset all keys
     void reset_all();
     
-    // Clean up inactive keys (older than max_age_seconds)
+    // Clean up inactive keys (older than max_age_seconds) in one full sweep
     size_t cleanup(int64_t max_age_seconds);
     
+    // Drop keys idle for max_age_seconds (0 = off); applies to keys first
+    // seen after the call
+    void set_idle_expiry(int64_t max_age_seconds);
+    
+    // Share the budget through store (not owned; null = local only). Keys
+    // are stored as prefix + key; lease_batch tokens are taken per visit.
+    // Set before use.
+    void set_store(RateLimitStore* store, const std::string& prefix, int lease_batch = 4);
+    
+    const RateLimitPolicy& policy() const { return policy_; }
+    
     // Get key count
-    size_t key_count() const;
+    size_t key_count() const { return count_.load(); }
 
 private:
-    LimiterType type_;
-    int limit_;
-    int window_or_rate_;
-    
-    // For token bucket
-    std::map<std::string, TokenBucketLimiter> token_limiters_;
+    KeyedRateLimiter(const KeyedRateLimiter&);
+    KeyedRateLimiter& operator=(const KeyedRateLimiter&);
+    
+    static const size_t SHARD_COUNT = 16;
+    
+    // Shared so check() can finish on a key that expiry erased meanwhile
+    struct KeyState {
+        std::atomic<int64_t> state;         // See RateLimitPolicy
+        std::atomic<int> leased;            // Tokens taken from the store, unspent
+        std::atomic<int64_t> last_seen;     // Seconds
+        TimerWheel::TimerId expiry;         // Shard lock; 0 = not armed
+        
+        KeyState() : state(0), leased(0), last_seen(0), expiry(0) {}
+    };
+    typedef std::shared_ptr<KeyState> KeyStatePtr;
     
-    // For sliding window
-    std::map<std::string, SlidingWindowLimiter> window_limiters_;
+    struct Shard {
+        std::unordered_map<std::string, KeyStatePtr> keys;
+        std::mutex mutex;
+    };
     
-    // Track last activity for cleanup
-    std::map<std::string, int64_t> last_activity_;
+    Shard& shard_for(const std::string& key);
+    KeyStatePtr acquire(const std::string& key);
+    RateLimitResult check_shared(const std::string& key, KeyState& state);
+    void arm_expiry_locked(const std::string& key, KeyState& state, int64_t deadline);
+    void expire(const std::string& key);
+    
+    RateLimitPolicy policy_;
+    RateLimitStore* store_;
+    std::string store_prefix_;
+    int lease_batch_;
+    std::atomic<int64_t> idle_expiry_;
+    std::atomic<size_t> count_;
+    TimerWheel& wheel_;
+    Shard shards_[SHARD_COUNT];
 };
 
-// Typing indicator manager
+// Typing indicator manager. A chat that is never stopped stops by itself
+// after the typing timeout (shared TimerWheel).
 class TypingIndicator {
 public:
     TypingIndicator();
+    ~TypingIndicator();
     
     // Start typing indicator for a chat
     void start_typing(const std::string& chat_id);
@@ -148,11 +249,27 @@ public:
     // Typing indicator interval in milliseconds (default 5000)
     void set_interval(int ms) { interval_ms_ = ms; }
     int interval() const { return interval_ms_; }
+    
+    // Longest a chat stays typing without stop_typing (default 600000)
+    void set_timeout(int64_t ms) { timeout_ms_ = ms; }
+    int64_t timeout() const { return timeout_ms_; }
 
 private:
+    struct Typing {
+        TimerWheel::TimerId timer;      // Auto-stop
+        int64_t until_ms;
+        
+        Typing() : timer(0), until_ms(0) {}
+    };
+    
+    void expire(const std::string& chat_id);
+    
     int interval_ms_;
+    int64_t timeout_ms_;
+    TimerWheel& wheel_;
+    mutable std::mutex mutex_;
     std::map<std::string, int64_t> last_typing_;  // chat_id -> last send time
-    std::map<std::string, bool> is_typing_;       // chat_id -> is typing
+    std::map<std::string, Typing> typing_;        // chat_id -> active typing
 };
 
 // Heartbeat/keep-alive manager
@@ -191,23 +308,52 @@ private:
     std::map<std::string, HeartbeatTarget> targets_;
 };
 
-// Message debouncer (prevents duplicate message handling)
+// Message debouncer (prevents duplicate message handling) in constant
+// memory. IDs are kept as 64-bit hashes in two time generations, each
+// spanning the dedup window: the current one and the one before. Each
+// generation is an exact hash set of fixed capacity plus a Bloom filter;
+// once the set is full the filter answers for the rest of that generation
+// (a false positive then drops a message, at about 0.1% for 50k IDs per
+// window). With a RateLimitStore, IDs other processes already took are
+// duplicates too.
 class MessageDebouncer {
 public:
-    MessageDebouncer(int window_seconds = 5);
+    MessageDebouncer(int window_seconds = 5, size_t exact_capacity = 8192,
+                     size_t bloom_bits = 1 << 20);
     
     // Check if message should be processed (returns false if duplicate)
     bool should_process(const std::string& message_id);
     
-    // Clean up old entries
+    // Start a new generation if the current one is past the window
     void cleanup();
     
     // Set dedup window
     void set_window(int seconds) { window_seconds_ = seconds; }
+    
+    // Deduplicate across processes (not owned; null = this process only)
+    void set_store(RateLimitStore* store) { store_ = store; }
+    
+    // Stable across processes (FNV-1a); never 0
+    static uint64_t hash_id(const std::string& message_id);
 
 private:
+    struct Generation {
+        int64_t started;                // Seconds
+        size_t count;                   // IDs in the exact set
+        bool overflowed;                // Set full: the filter answers too
+        std::vector<uint64_t> exact;    // Open addressing, 0 = empty
+        std::vector<uint64_t> bloom;
+    };
+    
+    void rotate_locked(int64_t now);
+    bool contains(const Generation& gen, uint64_t hash) const;
+    void insert(Generation& gen, uint64_t hash);
+    
     int window_seconds_;
-    std::map<std::string, int64_t> seen_messages_;
+    RateLimitStore* store_;
+    std::mutex mutex_;
+    Generation generations_[2];
+    size_t current_;
 };
 
 // Throttler for general-purpose rate limiting
@@ -0,0 +1,103 @@
+/*
+ * OpenClaw C++11 - Event Reactor
+ *
+ * The main loop: one epoll set on the main thread that plugins register
+ * file descriptors, timers and wakeups with, so the process sleeps until
+ * something is due instead of polling on a fixed period.
+ *
+ * Features:
+ * - File descriptors with an epoll event mask
+ * - One-shot and repeating timers, each on its own timerfd
+ * - post(): run a callback on the loop thread (eventfd wakeup)
+ * - wake(): interrupt run_once(); async-signal-safe
+ *
+ * Callbacks run on the thread calling run_once(), outside the reactor
+ * lock, so they may add or remove registrations themselves. They should
+ * hand real work to the thread pool. A registration removed before its
+ * callback is reached in the current turn is not called.
+ */
+#ifndef OPENCLAW_CORE_REACTOR_HPP
+#define OPENCLAW_CORE_REACTOR_HPP
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+
+namespace openclaw {
+
+// Visibility attribute so plugins register with the main binary's loop
+#ifdef __GNUC__
+#  define REACTOR_API __attribute__((visibility("default")))
+#else
+#  define REACTOR_API
+#endif
+
+class REACTOR_API Reactor {
+public:
+    typedef std::function<void(uint32_t events)> FdCallback;
+    typedef std::function<void()> Callback;
+    typedef uint64_t TimerId;
+
+    static Reactor& instance();
+
+    // Watch fd for events (EPOLLIN, EPOLLOUT, ...). The fd stays owned by
+    // the caller and must be removed before it is closed.
+    bool add_fd(int fd, uint32_t events, FdCallback cb);
+    bool modify_fd(int fd, uint32_t events);
+    void remove_fd(int fd);
+
+    // cb after delay_ms, then every interval_ms (0 = once). 0 on failure.
+    TimerId add_timer(int64_t delay_ms, int64_t interval_ms, Callback cb);
+    bool cancel_timer(TimerId id);
+
+    // Run cb on the loop thread at its next turn
+    void post(Callback cb);
+
+    // Make a blocked run_once() return
+    void wake();
+
+    // Wait up to timeout_ms (-1 = until something happens) and dispatch
+    // what is ready. Returns the number of callbacks run.
+    size_t run_once(int timeout_ms);
+
+    size_t fd_count() const;
+    size_t timer_count() const;
+
+private:
+    Reactor();
+    ~Reactor();
+    Reactor(const Reactor&);
+    Reactor& operator=(const Reactor&);
+
+    // What an epoll event's data points back to (by id, so an event of a
+    // removed source never reaches a new one on the same fd number)
+    struct Source {
+        uint64_t id;            // The TimerId for timers
+        int fd;
+        bool timer;
+        bool repeat;
+        bool cancelled;         // Removed; guarded by mutex_
+        FdCallback on_fd;
+        Callback on_timer;
+    };
+    typedef std::shared_ptr<Source> SourcePtr;
+
+    void drain_posted(std::vector<Callback>& out);
+
+    int epoll_fd_;
+    int wake_fd_;               // eventfd
+    uint64_t next_id_;
+
+    std::map<uint64_t, SourcePtr> sources_;     // By id (timers included)
+    std::map<int, uint64_t> fds_;               // Plain descriptor -> its source
+    std::map<TimerId, int> timers_;             // Timer -> its timerfd
+    std::vector<Callback> posted_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_REACTOR_HPP
@@ -12,6 +12,18 @@
 
 namespace openclaw {
 
+class ThreadPool;
+
+// How one plugin's init() went, for the startup profile
+struct PluginInitStats {
+    std::string name;
+    int64_t start_us;           // Since init_all() began
+    int64_t duration_us;
+    bool ok;
+    
+    PluginInitStats() : start_us(0), duration_us(0), ok(false) {}
+};
+
 // Visibility attribute for plugin-visible symbols
 #ifdef __GNUC__
 #  define PLUGIN_API __attribute__((visibility("default")))
@@ -77,9 +89,13 @@ public:
         return it != ai_map_.end() ? it->second : NULL;
     }
     
-    // Get first available AI provider
+    // Get the AI provider set with set_default_ai, else the first available one
     AIPlugin* get_default_ai();
     
+    // Route default AI calls through ai (e.g. the multi-provider router;
+    // NULL = first available provider)
+    void set_default_ai(AIPlugin* ai) { default_ai_ = ai; }
+    
     // Get all plugins
     const std::vector<Plugin*>& plugins() const { return plugins_; }
     
@@ -92,8 +108,16 @@ public:
     // Get all AI providers
     const std::vector<AIPlugin*>& ai_providers() const { return ai_providers_; }
     
-    // Initialize all plugins
-    bool init_all(const Config& cfg);
+    // Initialize all plugins. With a pool, each plugin's init() runs on it
+    // as soon as its dependencies are initialized, independent ones
+    // concurrently; returns once all are done. Without one, in order.
+    bool init_all(const Config& cfg, ThreadPool* pool = NULL);
+    
+    // Timings of the last init_all(), in registration order
+    const std::vector<PluginInitStats>& init_stats() const { return init_stats_; }
+    
+    // Pass a reloaded config to all initialized plugins
+    void reconfigure_all(const Config& cfg);
     
     // Shutdown all plugins
     void shutdown_all();
@@ -134,7 +158,7 @@ public:
     const std::map<std::string, CommandDef>& commands() const { return commands_; }
 
 private:
-    PluginRegistry() {}
+    PluginRegistry() : default_ai_(NULL) {}
     PluginRegistry(const PluginRegistry&);
     PluginRegistry& operator=(const PluginRegistry&);
     
@@ -147,6 +171,8 @@ private:
     std::map<std::string, ToolProvider*> tool_map_;
     std::map<std::string, AIPlugin*> ai_map_;
     std::map<std::string, CommandDef> commands_;
+    AIPlugin* default_ai_;
+    std::vector<PluginInitStats> init_stats_;
 };
 
 } // namespace openclaw
@@ -0,0 +1,150 @@
+/*
+ * OpenClaw C++11 - Outbound Send Queue
+ *
+ * Paces a channel's outgoing messages so that callers only enqueue and
+ * never wait on the platform's rate limits.
+ *
+ * Features:
+ * - One FIFO per chat; a chat has at most one send in flight, so its
+ *   messages arrive in order while different chats are sent concurrently
+ * - A token bucket per chat (the policy may differ per chat, e.g. groups)
+ *   and one for the whole channel, both GCRA (see RateLimitPolicy)
+ * - Edits share the chat's queue and bucket; a queued edit of a message
+ *   absorbs later edits of it, so only the newest text goes out
+ * - A send that comes back rate-limited is put back at the head of its
+ *   chat and retried once retry_after has passed
+ *
+ * Sends are asynchronous: the sender starts the request and reports back
+ * from whatever thread completes it. Completion callbacks run there too,
+ * outside the queue lock, and must not block.
+ */
+#ifndef OPENCLAW_CORE_SEND_QUEUE_HPP
+#define OPENCLAW_CORE_SEND_QUEUE_HPP
+
+#include "types.hpp"
+#include "rate_limiter.hpp"
+#include <string>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+namespace openclaw {
+
+struct OutboundMessage {
+    std::string to;
+    std::string text;
+    std::string reply_to;
+    std::string edit_id;    // Set: replace the text of this message instead
+    SendCallback on_done;
+    int attempts;           // Sends tried so far
+
+    OutboundMessage() : attempts(0) {}
+};
+
+// Visibility attribute for channel plugins
+#ifdef __GNUC__
+#  define SEND_QUEUE_API __attribute__((visibility("default")))
+#else
+#  define SEND_QUEUE_API
+#endif
+
+class SEND_QUEUE_API SendQueue {
+public:
+    // Reports a send: retry_after_ms > 0 means the platform refused it for
+    // rate limiting and the message should go again after that long
+    typedef std::function<void(const SendResult& result, int64_t retry_after_ms)> SendDone;
+
+    // Starts sending msg and calls done exactly once
+    typedef std::function<void(const OutboundMessage& msg, SendDone done)> Sender;
+
+    // Bucket for a chat, asked once when the chat is first seen
+    typedef std::function<RateLimitPolicy(const std::string& to)> ChatPolicy;
+
+    SendQueue(const std::string& name, Sender sender);
+    ~SendQueue();
+
+    // Set before start()
+    void set_global_limit(const RateLimitPolicy& policy) { global_policy_ = policy; }
+    void set_chat_limit(ChatPolicy policy) { chat_policy_ = policy; }
+    void set_max_attempts(int attempts) { max_attempts_ = attempts > 0 ? attempts : 1; }
+
+    void start();
+
+    // Fails everything still queued with "Channel stopped" and waits for
+    // sends in flight to complete
+    void stop();
+
+    // Queue a message; on_done (may be empty) runs once it was delivered
+    // or given up on
+    void enqueue(const std::string& to, const std::string& text,
+                 const std::string& reply_to, SendCallback on_done);
+
+    // Queue an edit of message_id (see OutboundMessage::edit_id)
+    void enqueue_edit(const std::string& to, const std::string& message_id,
+                      const std::string& text, SendCallback on_done);
+
+    // Enqueue and wait for the outcome (for callers that need the result)
+    SendResult send(const std::string& to, const std::string& text,
+                    const std::string& reply_to);
+
+    size_t pending() const;
+    uint64_t retries() const { return retries_.load(); }
+
+private:
+    SendQueue(const SendQueue&);
+    SendQueue& operator=(const SendQueue&);
+
+    struct Chat {
+        std::deque<OutboundMessage> queue;
+        RateLimitPolicy policy;
+        std::atomic<int64_t> bucket;
+        int64_t due_us;         // Earliest next send
+        bool in_flight;
+        bool scheduled;         // Has an entry in schedule_
+
+        Chat() : bucket(0), due_us(0), in_flight(false), scheduled(false) {}
+    };
+
+    void run();
+
+    // Add msg to its chat; false once stopped
+    bool push(OutboundMessage& msg);
+
+    // Put a chat with work and nothing in flight on the schedule (lock held)
+    void schedule_locked(const std::string& to, Chat& chat, int64_t due_us);
+
+    // Called by the sender's completion
+    void finish(const std::string& to, const SendResult& result, int64_t retry_after_ms);
+
+    // Drop idle chats whose bucket has refilled (lock held)
+    void prune_locked(int64_t now_us);
+
+    std::string name_;
+    Sender sender_;
+    RateLimitPolicy global_policy_;
+    ChatPolicy chat_policy_;
+    int max_attempts_;
+
+    std::unordered_map<std::string, Chat> chats_;
+    std::multimap<int64_t, std::string> schedule_;     // due_us -> chat
+    std::atomic<int64_t> global_bucket_;
+    int64_t next_prune_us_;
+    size_t pending_;
+    size_t in_flight_;
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_;
+    std::atomic<uint64_t> retries_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_SEND_QUEUE_HPP
@@ -3,9 +3,13 @@
 
 #include <openclaw/core/types.hpp>
 #include <openclaw/ai/ai.hpp>
+#include <openclaw/core/timer_wheel.hpp>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
+#include <memory>
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 
@@ -77,7 +81,8 @@ public:
     static std::string sanitize_agent_id(const std::string& agent_id);
 };
 
-// A user session with conversation history and state
+// A user session with conversation history and state. Not copyable; the
+// SessionManager hands out shared ownership through SessionHandle.
 class Session {
 public:
     Session();
@@ -112,8 +117,8 @@ public:
     // Limit history to max messages (keeps most recent)
     void limit_history(size_t max_messages);
     
-    // Last activity timestamp
-    int64_t last_activity() const { return last_activity_; }
+    // Last activity timestamp (read by the cleanup sweep without the lock)
+    int64_t last_activity() const { return last_activity_.load(); }
     void touch();
     
     // Custom data storage
@@ -128,38 +133,99 @@ private:
     std::string channel_;
     std::string peer_id_;
     std::vector<ConversationMessage> history_;
-    int64_t last_activity_;
+    std::atomic<int64_t> last_activity_;
     std::map<std::string, std::string> data_;
+    
+    friend class SessionHandle;
+    Session(const Session&);
+    Session& operator=(const Session&);
+    std::mutex mutex_;
+};
+
+typedef std::shared_ptr<Session> SessionPtr;
+
+// Exclusive access to one session: holds the session's lock and keeps it
+// alive. Work that outlives the handle (an asynchronous AI turn) keeps the
+// SessionPtr instead and relies on the session's strand for exclusion.
+class SessionHandle {
+public:
+    SessionHandle() {}
+    explicit SessionHandle(const SessionPtr& session);
+    SessionHandle(SessionHandle&& other);
+    SessionHandle& operator=(SessionHandle&& other);
+    
+    Session* operator->() const { return session_.get(); }
+    Session& operator*() const { return *session_; }
+    explicit operator bool() const { return session_ != nullptr; }
+    
+    const SessionPtr& ptr() const { return session_; }
+    
+    // Give up the lock early; the session stays alive
+    void unlock();
+    
+private:
+    SessionHandle(const SessionHandle&);
+    SessionHandle& operator=(const SessionHandle&);
+    
+    SessionPtr session_;
+    std::unique_lock<std::mutex> lock_;
+};
+
+// Durable storage behind the SessionManager (see SessionStore). Both
+// calls run with the session locked or on its strand.
+class SessionBackend {
+public:
+    virtual ~SessionBackend() {}
+    
+    // Fill a session that was just created in memory
+    virtual void load(Session& session) = 0;
+    
+    // Record the session's current history
+    virtual void persist(const Session& session) = 0;
 };
 
-// Session manager - manages all active sessions
+// Session manager - manages all active sessions. Sessions are spread over
+// lock-striped shards, so lookups for different chats rarely contend and
+// the cleanup sweep only ever blocks one shard.
 class SessionManager {
 public:
     static SessionManager& instance();
     
-    // Get or create a session by key
-    Session& get_session(const std::string& key);
+    // Get or create a session by key, locked
+    SessionHandle get_session(const std::string& key);
+    
+    // Existing session without taking its lock (null if there is none)
+    SessionPtr find_session(const std::string& key) const;
     
     // Check if session exists
     bool has_session(const std::string& key) const;
     
-    // Remove a session
+    // Remove a session (holders of a SessionPtr keep their copy)
     void remove_session(const std::string& key);
     
-    // Get session for a message
-    Session& get_session_for_message(const Message& msg, const std::string& agent_id = "");
+    // Get session for a message, locked
+    SessionHandle get_session_for_message(const Message& msg, const std::string& agent_id = "");
+    
+    // Build the session key a message routes to (without creating the session)
+    std::string session_key_for_message(const Message& msg, const std::string& agent_id = "") const;
     
     // Clear all sessions
     void clear_all();
     
-    // Clean up inactive sessions (older than max_age_seconds)
+    // Clean up inactive sessions (older than max_age_seconds) in one full
+    // sweep; sessions still referenced elsewhere are kept
     size_t cleanup_inactive(int64_t max_age_seconds);
     
+    // Expire sessions idle for max_age_seconds through the shared
+    // TimerWheel (0 = off); applies to sessions created after the call
+    void set_idle_expiry(int64_t max_age_seconds) { idle_expiry_ = max_age_seconds > 0 ? max_age_seconds : 0; }
+    int64_t idle_expiry() const { return idle_expiry_; }
+    
     // Get all session keys
     std::vector<std::string> session_keys() const;
     
     // Session count
-    size_t session_count() const { return sessions_.size(); }
+    size_t session_count() const { return count_.load(); }
     
     // DM scope setting
     DMScope dm_scope() const { return dm_scope_; }
@@ -168,16 +234,40 @@ public:
     // Max history per session
     size_t max_history() const { return max_history_; }
     void set_max_history(size_t max) { max_history_ = max; }
+    
+    // Storage that new sessions are loaded from (not owned; set before use)
+    void set_backend(SessionBackend* backend) { backend_ = backend; }
+    
+    // Save a session's history after it changed (no-op without a backend)
+    void persist(const Session& session);
 
 private:
     SessionManager();
+    ~SessionManager();
     SessionManager(const SessionManager&);
     SessionManager& operator=(const SessionManager&);
     
-    std::map<std::string, Session> sessions_;
-    mutable std::mutex mutex_;
+    static const size_t SHARD_COUNT = 32;
+    
+    struct Shard {
+        std::unordered_map<std::string, SessionPtr> sessions;
+        mutable std::mutex mutex;
+    };
+    
+    Shard& shard_for(const std::string& key) const;
+    
+    // Idle-expiry timer for one session; on firing, the session is dropped
+    // if it is still the one in the map, idle and not held elsewhere
+    void arm_expiry(const std::string& key, const SessionPtr& session, int64_t deadline);
+    void expire(const std::string& key, const std::weak_ptr<Session>& session);
+    
+    mutable Shard shards_[SHARD_COUNT];
+    std::atomic<size_t> count_;
     DMScope dm_scope_;
-    size_t max_history_;
+    std::atomic<size_t> max_history_;
+    SessionBackend* backend_;
+    std::atomic<int64_t> idle_expiry_;
+    TimerWheel& wheel_;
 };
 
 // Route resolution result
@@ -0,0 +1,147 @@
+/*
+ * OpenClaw C++11 - Persistent Session Store
+ *
+ * Keeps conversations across restarts in one append-only JSON-lines log
+ * per session, which doubles as the transcript the memory indexer reads.
+ *
+ * Features:
+ * - Appends only what changed since the last turn (new messages, a drop
+ *   of the oldest ones, or a reset)
+ * - Group commit: a writer thread batches the appends of all sessions
+ *   and syncs each touched file once per batch
+ * - Fast restart: startup only reads each file's header line into a
+ *   directory of known sessions; a session's history is parsed from an
+ *   mmap of its log when the session is first used
+ * - Logs that are mostly dead records (trimmed or summarized history)
+ *   are rewritten to the live history
+ * - Several nodes can share the directory (cluster mode): a node releases
+ *   a session it hands off, and loads logs another node created since
+ *   its startup scan
+ *
+ * Record format (one JSON object per line):
+ *   {"key":"agent:default:main","type":"session","v":1}       header
+ *   {"content":"...","role":"user","ts":1700000000}           message
+ *   {"count":2,"type":"drop"}                                 oldest messages removed
+ *   {"type":"reset"}                                          history cleared
+ */
+#ifndef OPENCLAW_CORE_SESSION_STORE_HPP
+#define OPENCLAW_CORE_SESSION_STORE_HPP
+
+#include <openclaw/core/session.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+namespace openclaw {
+
+class SessionStore : public SessionBackend {
+public:
+    struct Config {
+        std::string dir;            // One <key>.jsonl per session
+        int commit_interval_ms;     // Group-commit window
+        bool fsync;                 // fdatasync() each batch (false = leave it to the OS)
+
+        Config() : commit_interval_ms(10), fsync(true) {}
+    };
+
+    struct Stats {
+        size_t sessions;            // Known on disk or created since start
+        uint64_t loaded;            // Histories read back from disk
+        uint64_t records;           // Records appended
+        uint64_t commits;           // Writer batches
+        uint64_t syncs;             // File syncs
+        uint64_t rewrites;          // Logs rewritten to their live history
+        uint64_t bytes;             // Bytes written
+
+        Stats() : sessions(0), loaded(0), records(0), commits(0), syncs(0), rewrites(0), bytes(0) {}
+    };
+
+    SessionStore();
+    ~SessionStore();
+
+    // Create the directory, index the existing logs and start the writer
+    bool open(const Config& config);
+
+    // Write out everything queued and stop the writer
+    void close();
+
+    bool is_open() const { return running_; }
+    const Config& get_config() const { return config_; }
+
+    // SessionBackend
+    void load(Session& session) override;
+    void persist(const Session& session) override;
+
+    // Block until everything queued so far is written out. False if a
+    // write in those batches failed (the sessions involved are rewritten
+    // in full by their next persist)
+    bool flush();
+
+    bool contains(const std::string& key) const;
+    Stats stats() const;
+
+    // Write out the session's queued appends and forget what is known
+    // about its log, so the next load() reads it afresh (after another
+    // node appended to it). Call on the session's strand once it is
+    // removed from the SessionManager.
+    void release(const std::string& key);
+
+    // Whether the session's log changed on disk since this node last read
+    // or wrote it: another node ran a turn of it (cluster fallback). False
+    // while this node's own appends are still queued.
+    bool changed_elsewhere(const std::string& key) const;
+
+    // File name of a session's log: the key made filesystem-safe plus a
+    // hash of the original, so distinct keys never share a file
+    static std::string file_name(const std::string& key);
+
+private:
+    // A persisted message of the live history
+    struct Record {
+        uint64_t hash;
+        uint32_t bytes;
+    };
+
+    struct Entry {
+        std::string path;
+        uint64_t size;              // Log size including queued bytes
+        uint64_t live_offset;       // Replay starts here (last rewrite or reset)
+        bool known;                 // `live` mirrors the log
+        std::vector<Record> live;
+        uint64_t live_bytes;
+        std::string pending;        // Queued for the writer
+        bool rewrite;               // `pending` replaces the file
+        uint64_t queued_seq;        // Batch the pending bytes go out with
+        bool failed;                // A write failed: the next persist rewrites the file
+
+        Entry() : size(0), live_offset(0), known(false), live_bytes(0), rewrite(false), queued_seq(0),
+                  failed(false) {}
+    };
+
+    void scan();
+    void writer_loop();
+    void wait_for(uint64_t seq, std::unique_lock<std::mutex>& lock);
+
+    Config config_;
+    std::atomic<bool> running_;
+    std::map<std::string, Entry> entries_;
+    std::vector<std::string> dirty_;        // Keys with pending bytes
+    uint64_t queued_seq_;                   // Sequence of the batch being filled
+    uint64_t committed_seq_;                // Last batch on disk
+    uint64_t failed_seq_;                   // Last batch with a failed write
+    Stats counters_;
+    bool stop_;
+    std::thread writer_;
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_SESSION_STORE_HPP
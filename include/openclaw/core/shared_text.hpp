@@ -0,0 +1,89 @@
+/*
+ * OpenClaw C++11 - Shared Immutable Text
+ *
+ * Reference-counted, immutable string for payloads that pass through
+ * several owners (session history, agent turns, provider requests,
+ * transcripts). Copies share one buffer; assigning new text swaps in a
+ * new buffer and never edits one that others may hold.
+ */
+#ifndef OPENCLAW_CORE_SHARED_TEXT_HPP
+#define OPENCLAW_CORE_SHARED_TEXT_HPP
+
+#include "json.hpp"
+#include <string>
+#include <memory>
+#include <ostream>
+
+namespace openclaw {
+
+class SharedText {
+public:
+    SharedText() {}
+    SharedText(const std::string& text) : text_(make(text)) {}
+    SharedText(std::string&& text) : text_(make(std::move(text))) {}
+    SharedText(const char* text) : text_(make(std::string(text ? text : ""))) {}
+    explicit SharedText(const std::shared_ptr<const std::string>& text) : text_(text) {}
+
+    const std::string& str() const { return text_ ? *text_ : empty_string(); }
+    operator const std::string&() const { return str(); }
+
+    bool empty() const { return !text_ || text_->empty(); }
+    size_t size() const { return text_ ? text_->size() : 0; }
+    size_t length() const { return size(); }
+    const char* c_str() const { return str().c_str(); }
+    const char* data() const { return str().data(); }
+    char operator[](size_t i) const { return str()[i]; }
+
+    std::string::const_iterator begin() const { return str().begin(); }
+    std::string::const_iterator end() const { return str().end(); }
+
+    size_t find(const std::string& s, size_t pos = 0) const { return str().find(s, pos); }
+    size_t find(const char* s, size_t pos = 0) const { return str().find(s, pos); }
+    size_t find(char c, size_t pos = 0) const { return str().find(c, pos); }
+    std::string substr(size_t pos = 0, size_t len = std::string::npos) const { return str().substr(pos, len); }
+
+    // Owners of this buffer (0 for the empty text)
+    long use_count() const { return text_.use_count(); }
+
+private:
+    static std::shared_ptr<const std::string> make(std::string text) {
+        if (text.empty()) return std::shared_ptr<const std::string>();
+        return std::make_shared<const std::string>(std::move(text));
+    }
+    static const std::string& empty_string() {
+        static const std::string empty;
+        return empty;
+    }
+
+    std::shared_ptr<const std::string> text_;
+};
+
+// Copies of one buffer compare without looking at the text
+inline bool operator==(const SharedText& a, const SharedText& b) {
+    return (a.data() == b.data() && a.size() == b.size()) || a.str() == b.str();
+}
+inline bool operator==(const SharedText& a, const std::string& b) { return a.str() == b; }
+inline bool operator==(const std::string& a, const SharedText& b) { return a == b.str(); }
+inline bool operator==(const SharedText& a, const char* b) { return a.str() == b; }
+inline bool operator!=(const SharedText& a, const SharedText& b) { return !(a == b); }
+inline bool operator!=(const SharedText& a, const std::string& b) { return !(a == b); }
+inline bool operator!=(const std::string& a, const SharedText& b) { return !(a == b); }
+inline bool operator!=(const SharedText& a, const char* b) { return !(a == b); }
+
+inline std::string operator+(const std::string& a, const SharedText& b) { return a + b.str(); }
+inline std::string operator+(const SharedText& a, const std::string& b) { return a.str() + b; }
+inline std::string operator+(const char* a, const SharedText& b) { return a + b.str(); }
+inline std::string operator+(const SharedText& a, const char* b) { return a.str() + b; }
+
+inline std::ostream& operator<<(std::ostream& os, const SharedText& text) {
+    return os << text.str();
+}
+
+// nlohmann::json serializer (found by ADL)
+inline void to_json(Json& j, const SharedText& text) {
+    j = text.str();
+}
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_SHARED_TEXT_HPP
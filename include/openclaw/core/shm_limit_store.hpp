@@ -0,0 +1,76 @@
+/*
+ * OpenClaw C++11 - Shared-Memory Rate-Limit Store
+ *
+ * RateLimitStore for several openclaw processes on one host: rate-limit
+ * budgets and seen message IDs live in a POSIX shared-memory segment that
+ * every process maps, so a user gets one budget and a message redelivered
+ * to several instances is handled once.
+ *
+ * Features:
+ * - Fixed-size open-addressing table of 64-bit key hashes; no locks, every
+ *   update is a CAS on the slot's words
+ * - Same limiting algorithms as KeyedRateLimiter (RateLimitPolicy), on
+ *   CLOCK_MONOTONIC which all processes share
+ * - Slots unused for longer than their state matters are taken over by
+ *   new keys; when a key finds no slot, callers fall back to local limits
+ */
+#ifndef OPENCLAW_CORE_SHM_LIMIT_STORE_HPP
+#define OPENCLAW_CORE_SHM_LIMIT_STORE_HPP
+
+#include <openclaw/core/rate_limiter.hpp>
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+namespace openclaw {
+
+class ShmRateLimitStore : public RateLimitStore {
+public:
+    struct Config {
+        std::string name;           // shm_open name ("/openclaw-limits")
+        size_t slots;               // Table size when this process creates it
+
+        Config() : name("/openclaw-limits"), slots(65536) {}
+    };
+
+    ShmRateLimitStore();
+    ~ShmRateLimitStore();
+
+    // Map the segment, creating it if no process has yet
+    bool open(const Config& config);
+    void close();
+
+    bool is_open() const { return slots_ != nullptr; }
+    size_t slot_count() const { return slot_count_; }
+
+    // RateLimitStore
+    int lease(const std::string& key, const RateLimitPolicy& policy, int n,
+              RateLimitResult& result) override;
+    int mark_seen(uint64_t id_hash, int window_seconds) override;
+
+private:
+    ShmRateLimitStore(const ShmRateLimitStore&);
+    ShmRateLimitStore& operator=(const ShmRateLimitStore&);
+
+    static const size_t MAX_PROBE = 32;
+
+    // until: monotonic second up to which the owner needs the slot; 0
+    // while its creator sets it up, -1 while it is being taken over
+    struct Slot {
+        std::atomic<uint64_t> tag;          // Key hash, 0 = free
+        std::atomic<int64_t> word;          // RateLimitPolicy state
+        std::atomic<int64_t> until;
+    };
+
+    // Slot for tag (created = it was free or stale and is now ours)
+    Slot* claim(uint64_t tag, int64_t now_s, bool& created);
+
+    void* mapping_;
+    size_t mapping_size_;
+    Slot* slots_;
+    size_t slot_count_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_SHM_LIMIT_STORE_HPP
@@ -0,0 +1,45 @@
+#ifndef OPENCLAW_CORE_SNAPSHOT_HPP
+#define OPENCLAW_CORE_SNAPSHOT_HPP
+
+/*
+ * OpenClaw settings snapshot
+ *
+ * Holds an immutable T behind a shared_ptr that is swapped atomically.
+ * Components parse their config keys into a T once, at init and on each
+ * reload, and hot paths read the fields of get() instead of looking keys
+ * up. A reader keeps the snapshot it took for as long as it needs
+ * consistent values; a reload never changes it under its feet.
+ */
+
+#include <memory>
+#include <atomic>
+
+namespace openclaw {
+
+template <typename T>
+class Snapshot {
+public:
+    typedef std::shared_ptr<const T> Ptr;
+
+    Snapshot() : ptr_(std::make_shared<const T>()) {}
+    explicit Snapshot(const T& value) : ptr_(std::make_shared<const T>(value)) {}
+
+    // Current value; never null
+    Ptr get() const { return std::atomic_load(&ptr_); }
+
+    // Publish a new value to readers that call get() from now on
+    void set(const T& value) { set(std::make_shared<const T>(value)); }
+    void set(Ptr value) {
+        if (value) std::atomic_store(&ptr_, value);
+    }
+
+private:
+    Snapshot(const Snapshot&);
+    Snapshot& operator=(const Snapshot&);
+
+    Ptr ptr_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_SNAPSHOT_HPP
@@ -0,0 +1,44 @@
+#ifndef OPENCLAW_CORE_SSE_HPP
+#define OPENCLAW_CORE_SSE_HPP
+
+#include <string>
+#include <functional>
+#include <cstddef>
+
+namespace openclaw {
+
+// Incremental text/event-stream parser. Feed it body bytes as they arrive
+// (e.g. from HttpRequest::on_data); it calls the callback once per complete
+// event, however the bytes were split across network reads.
+class SseParser {
+public:
+    // event is "message" when the event had no "event:" line
+    typedef std::function<void(const std::string& event, const std::string& data)> EventCallback;
+    
+    explicit SseParser(EventCallback on_event);
+    
+    void feed(const char* data, size_t len);
+    void feed(const std::string& data) { feed(data.data(), data.size()); }
+    
+    // Dispatch a trailing event that was not terminated by a blank line
+    void finish();
+    
+    // Events dispatched so far
+    size_t events() const { return events_; }
+    
+private:
+    void process_line(const std::string& line);
+    void dispatch();
+    
+    EventCallback on_event_;
+    std::string line_;          // Partial line carried over between feeds
+    std::string event_;
+    std::string data_;
+    bool has_data_;
+    bool skip_lf_;              // Previous chunk ended in '\r'
+    size_t events_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_SSE_HPP
@@ -0,0 +1,71 @@
+/*
+ * OpenClaw C++11 - Subprocess Executor
+ *
+ * Runs shell commands without holding a thread while they run: the child
+ * is started with posix_spawn, its output pipe is non-blocking and read
+ * by the Reactor, and the timeout is a reactor timer.
+ *
+ * Features:
+ * - stdout and stderr merged into one pipe, stdin from /dev/null
+ * - The child leads its own process group; a timeout or an output cap
+ *   kills the whole group, so background jobs do not outlive the command
+ * - Optional cgroup (v2) the shell joins before running anything, so
+ *   CPU and memory limits set on it apply to everything it starts
+ *
+ * Completion callbacks run on the reactor thread and must not block.
+ */
+#ifndef OPENCLAW_CORE_SUBPROCESS_HPP
+#define OPENCLAW_CORE_SUBPROCESS_HPP
+
+#include <string>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace openclaw {
+
+struct SubprocessOptions {
+    std::string command;        // Run by /bin/sh -c
+    std::string workdir;        // Empty: inherit
+    int64_t timeout_ms;         // 0: no limit
+    size_t max_output;          // Bytes kept; past it the child is killed
+    std::string cgroup;         // cgroup v2 directory to join; empty: none
+
+    SubprocessOptions() : timeout_ms(0), max_output(1000000) {}
+};
+
+struct SubprocessResult {
+    bool started;
+    int exit_code;              // 128 + signal when killed by one
+    int term_signal;            // 0 unless killed by a signal
+    bool timed_out;
+    bool truncated;             // Output cap reached
+    std::string output;
+    std::string error;          // Why it could not be started
+    int64_t duration_ms;
+
+    SubprocessResult() : started(false), exit_code(-1), term_signal(0),
+                         timed_out(false), truncated(false), duration_ms(0) {}
+};
+
+typedef std::function<void(const SubprocessResult& result)> SubprocessCallback;
+
+class Subprocess {
+public:
+    // Start the command; on_done is called exactly once
+    static void run_async(const SubprocessOptions& options, SubprocessCallback on_done);
+
+    // Start it and wait (never from the reactor thread)
+    static SubprocessResult run(const SubprocessOptions& options);
+
+    // Create cgroup (if missing) and set memory.max (bytes) and cpu.max
+    // (percent of one CPU); 0 leaves a limit as it is
+    static bool setup_cgroup(const std::string& cgroup, int64_t memory_max, int cpu_percent);
+
+    // Commands currently running
+    static size_t running();
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_SUBPROCESS_HPP
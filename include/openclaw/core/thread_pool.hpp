@@ -5,42 +5,191 @@
 #define OPENCLAW_CORE_THREAD_POOL_HPP
 
 #include <vector>
+#include <deque>
 #include <queue>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
 #include <atomic>
+#include <memory>
+#include <map>
+#include <string>
+#include <cstdint>
 
 namespace openclaw {
 
-// Simple thread pool for processing messages asynchronously
-class ThreadPool {
+// Priority lanes. HIGH is drained before NORMAL, NORMAL before LOW, on
+// every worker.
+enum class TaskPriority {
+    HIGH = 0,     // Built-in commands, stream deltas, cluster session hand-off, plugin init
+    NORMAL = 1,   // AI turns, skill commands and memory recall
+    LOW = 2       // Background maintenance (history compaction)
+};
+
+static const size_t TASK_PRIORITY_COUNT = 3;
+
+const char* task_priority_name(TaskPriority priority);
+
+// A strand task that finishes asynchronously. It keeps the strand busy
+// until done() is called (once, from any thread).
+typedef std::function<void()> StrandDone;
+typedef std::function<void(StrandDone done)> AsyncStrandTask;
+
+// Work-stealing thread pool for processing messages asynchronously.
+// Every worker owns a deque per lane; idle workers steal the oldest task
+// from their peers. Some workers can be reserved for the HIGH lane so
+// commands are never stuck behind long-running AI turns. LOW tasks only
+// run on a few of the non-reserved workers.
+// Visibility attribute so plugins share the main binary's pools
+#ifdef __GNUC__
+#  define THREAD_POOL_API __attribute__((visibility("default")))
+#else
+#  define THREAD_POOL_API
+#endif
+
+class THREAD_POOL_API ThreadPool {
 public:
-    ThreadPool(size_t num_threads = 4);
+    // Per-lane counters (times in microseconds)
+    struct LaneStats {
+        uint64_t enqueued;
+        uint64_t completed;
+        uint64_t total_wait_us;    // Enqueue to start
+        uint64_t max_wait_us;
+        uint64_t total_run_us;     // Start to finish
+        uint64_t max_run_us;
+        size_t queued;             // Runnable, waiting for a worker
+        size_t deferred;           // Waiting behind another task in a strand
+        size_t running;
+
+        LaneStats() : enqueued(0), completed(0), total_wait_us(0), max_wait_us(0),
+                      total_run_us(0), max_run_us(0), queued(0), deferred(0), running(0) {}
+
+        double avg_wait_ms() const { return completed ? total_wait_us / 1000.0 / completed : 0.0; }
+        double avg_run_ms() const { return completed ? total_run_us / 1000.0 / completed : 0.0; }
+    };
+
+    // reserved_high: workers that never pick up NORMAL or LOW tasks
+    // low_workers: max workers running LOW tasks at once
+    ThreadPool(size_t num_threads = 4, size_t reserved_high = 1, size_t low_workers = 1);
     ~ThreadPool();
-    
+
     // Add a task to the queue
-    void enqueue(std::function<void()> task);
-    
+    void enqueue(std::function<void()> task, TaskPriority priority = TaskPriority::NORMAL);
+
+    // Add a task to the serial queue (strand) identified by key.
+    // Tasks sharing a key run one at a time in FIFO order; tasks with
+    // different keys still run in parallel across the workers.
+    void enqueue_serial(const std::string& key, std::function<void()> task,
+                        TaskPriority priority = TaskPriority::NORMAL);
+
+    // Strand task that completes asynchronously: later tasks for the key
+    // wait until the task calls done(), while the worker is released as
+    // soon as the task function returns
+    void enqueue_serial_async(const std::string& key, AsyncStrandTask task,
+                              TaskPriority priority = TaskPriority::NORMAL);
+
+    // Bounded variants: refuse the task (return false) once pending()
+    // reaches the capacity set with set_capacity()
+    bool try_enqueue(std::function<void()> task, TaskPriority priority = TaskPriority::NORMAL);
+    bool try_enqueue_serial(const std::string& key, std::function<void()> task,
+                            TaskPriority priority = TaskPriority::NORMAL);
+    bool try_enqueue_serial_async(const std::string& key, AsyncStrandTask task,
+                                  TaskPriority priority = TaskPriority::NORMAL);
+
+    // Queue capacity for the try_* variants (0 = unbounded)
+    void set_capacity(size_t capacity) { capacity_ = capacity; }
+    size_t capacity() const { return capacity_.load(); }
+
+    // Number of tasks refused by try_enqueue/try_enqueue_serial
+    uint64_t rejected() const { return rejected_.load(); }
+
+    // Get number of strands with queued or running work
+    size_t strand_count() const;
+
     // Get number of threads
     size_t size() const { return threads_.size(); }
-    
-    // Get number of pending tasks
+
+    // Get number of pending tasks (all lanes, or one lane), including
+    // tasks deferred behind a running strand task
     size_t pending() const;
-    
-    // Shutdown the pool
+    size_t pending(TaskPriority priority) const;
+
+    // Rough time a new task in this lane waits before starting, based on
+    // the lane's average run time and backlog (0 until a task completed)
+    int64_t estimated_wait_ms(TaskPriority priority) const;
+
+    // Latency/run-time counters for a lane
+    LaneStats lane_stats(TaskPriority priority) const;
+
+    // Number of tasks taken from another worker's deque
+    uint64_t steals() const { return steals_.load(); }
+
+    // Shutdown the pool: runs every runnable task, including strand tasks
+    // queued behind them, then cancels strand tasks still waiting on an
+    // async task that has not called done()
     void shutdown();
 
 private:
-    void worker();
-    
+    struct Task {
+        std::function<void()> fn;
+        TaskPriority priority;
+        int64_t enqueued_us;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> lanes[TASK_PRIORITY_COUNT];
+    };
+
+    struct LaneCounters {
+        std::atomic<uint64_t> enqueued;
+        std::atomic<uint64_t> completed;
+        std::atomic<uint64_t> total_wait_us;
+        std::atomic<uint64_t> max_wait_us;
+        std::atomic<uint64_t> total_run_us;
+        std::atomic<uint64_t> max_run_us;
+        std::atomic<size_t> queued;
+        std::atomic<size_t> deferred;
+        std::atomic<size_t> running;
+
+        LaneCounters() : enqueued(0), completed(0), total_wait_us(0), max_wait_us(0),
+                         total_run_us(0), max_run_us(0), queued(0), deferred(0), running(0) {}
+    };
+
+    struct Strand {
+        std::queue<std::pair<AsyncStrandTask, TaskPriority>> tasks;
+    };
+
+    void push(std::function<void()> task, TaskPriority priority);
+    void wake_one();
+    size_t queued() const;             // Runnable tasks, all lanes
+    void worker(size_t index);
+    bool try_pop(size_t index, Task& out);
+    bool pop_from(size_t queue_index, size_t lane, Task& out);
+    bool has_runnable() const;
+    bool claim_slot(size_t lane);
+    void run_task(Task& task);
+    void run_strand(const std::string& key);
+    void release_strand(const std::string& key);
+
     std::vector<std::thread> threads_;
-    std::queue<std::function<void()>> tasks_;
-    
-    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    LaneCounters lanes_[TASK_PRIORITY_COUNT];
+    size_t normal_limit_;              // Max workers running NORMAL and LOW tasks
+    size_t low_limit_;                 // Max workers running LOW tasks
+    std::atomic<size_t> next_queue_;   // Round-robin target for external enqueues
+    std::atomic<uint64_t> steals_;
+    std::atomic<size_t> capacity_;
+    std::atomic<uint64_t> rejected_;
+
+    mutable std::mutex mutex_;         // Guards sleeping/wakeup only
     std::condition_variable condition_;
     std::atomic<bool> stop_;
+
+    // Active strands only; a strand is erased once its queue drains
+    std::map<std::string, Strand> strands_;
+    mutable std::mutex strands_mutex_;
 };
 
 } // namespace openclaw
@@ -0,0 +1,102 @@
+/*
+ * OpenClaw C++11 - Hierarchical Timer Wheel
+ *
+ * One process-wide wheel that idle-expiry state (sessions, rate-limiter
+ * keys, the message debouncer, typing indicators) registers deadlines
+ * with, so expiring entries costs O(expired) instead of a periodic sweep
+ * over every entry.
+ *
+ * Features:
+ * - 4 levels of 64 slots; at the default 100ms tick the levels span
+ *   6.4s, 6.8min, 7.3h and 19.4 days (later deadlines are re-filed)
+ * - O(1) schedule and cancel
+ * - Callbacks run on the thread calling advance(), with the wheel unlocked,
+ *   so they may schedule or cancel timers themselves
+ */
+#ifndef OPENCLAW_CORE_TIMER_WHEEL_HPP
+#define OPENCLAW_CORE_TIMER_WHEEL_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+
+namespace openclaw {
+
+// Visibility attribute so plugins schedule on the main binary's wheel
+#ifdef __GNUC__
+#  define TIMER_WHEEL_API __attribute__((visibility("default")))
+#else
+#  define TIMER_WHEEL_API
+#endif
+
+class TIMER_WHEEL_API TimerWheel {
+public:
+    typedef uint64_t TimerId;
+    typedef std::function<void()> Callback;
+
+    static TimerWheel& instance();
+
+    explicit TimerWheel(int64_t tick_ms = 100);
+
+    // Run cb once the wheel is advanced past deadline_ms (current_timestamp_ms
+    // clock). owner tags the timer for cancel_all (may be null).
+    TimerId schedule_at(int64_t deadline_ms, Callback cb, const void* owner = nullptr);
+    TimerId schedule_in(int64_t delay_ms, Callback cb, const void* owner = nullptr);
+
+    // False if the timer already fired or was cancelled
+    bool cancel(TimerId id);
+
+    // Drop every timer registered by owner (O(pending); for destructors)
+    size_t cancel_all(const void* owner);
+
+    // Fire everything due at now_ms; returns the number of callbacks run
+    size_t advance(int64_t now_ms);
+    size_t advance();
+
+    size_t pending() const;
+    int64_t tick_ms() const { return tick_ms_; }
+
+    // When advance() next has work (current_timestamp_ms clock): the next
+    // occupied slot of the lowest level, or the next cascade. -1 when no
+    // timer is pending.
+    int64_t next_wakeup_ms();
+
+    // Called (outside the lock) when a timer is scheduled earlier than the
+    // last next_wakeup_ms() answer, so a sleeping loop can re-arm
+    void set_wakeup_hook(Callback hook);
+
+private:
+    TimerWheel(const TimerWheel&);
+    TimerWheel& operator=(const TimerWheel&);
+
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+
+    struct Timer {
+        int64_t deadline_tick;
+        Callback cb;
+        const void* owner;
+    };
+
+    // Put id into the slot matching its deadline (lock held)
+    void file_locked(TimerId id, int64_t deadline_tick);
+
+    int64_t tick_ms_;
+    int64_t current_tick_;
+    TimerId next_id_;
+    int64_t wakeup_tick_;           // Last next_wakeup_ms() answer (-1 = none)
+    Callback wakeup_hook_;
+
+    // Slots hold ids only; a cancelled id stays behind until its slot is
+    // visited and is skipped then
+    std::vector<TimerId> slots_[LEVELS][SLOTS];
+    std::unordered_map<TimerId, Timer> timers_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_TIMER_WHEEL_HPP
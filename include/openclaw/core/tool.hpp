@@ -39,6 +39,9 @@ class ToolProvider : public Plugin {
 public:
     virtual ~ToolProvider() {}
     
+    // Tools work on request
+    virtual int poll_interval_ms() const { return 0; }
+    
     // Tool metadata
     virtual const char* tool_id() const = 0;
     virtual std::vector<std::string> actions() const = 0;
@@ -0,0 +1,118 @@
+/*
+ * OpenClaw C++11 - Agent Turn Tracing
+ *
+ * Records where the time of one agent turn goes (queueing, AI calls,
+ * tools, parsing and formatting) and exports it as JSON lines or as
+ * OpenTelemetry (OTLP/JSON) spans.
+ */
+#ifndef OPENCLAW_CORE_TRACE_HPP
+#define OPENCLAW_CORE_TRACE_HPP
+
+#include <openclaw/core/json.hpp>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+namespace openclaw {
+
+class ThreadPool;
+
+// One timed step of a turn. Times are microseconds relative to the start
+// of the trace; steps before the start (queue wait) are negative.
+struct TraceSpan {
+    std::string kind;          // queue, ai, tool, parse, format
+    std::string name;          // Model, tool name, ...
+    int iteration;
+    int64_t start_us;
+    int64_t duration_us;
+    int64_t ttfb_us;           // ai: time to the first streamed chunk (-1 = not streamed)
+    int input_tokens;
+    int output_tokens;
+    int cache_read_tokens;
+    bool ok;
+    std::string error;
+
+    TraceSpan()
+        : iteration(0), start_us(0), duration_us(0), ttfb_us(-1)
+        , input_tokens(0), output_tokens(0), cache_read_tokens(0), ok(true) {}
+};
+
+// Spans of one agent turn. Not thread-safe: a turn records from one
+// continuation at a time; concurrent steps report monotonic clock_us()
+// timestamps that are added afterwards.
+class AgentTrace {
+public:
+    AgentTrace();
+
+    // Monotonic clock shared by all recorders
+    static int64_t clock_us();
+
+    // Restart the trace at the current time with a fresh trace ID
+    void start();
+
+    // Time since start
+    int64_t elapsed_us() const { return clock_us() - origin_us_; }
+
+    // Add a span from two clock_us() timestamps
+    TraceSpan& add(const std::string& kind, const std::string& name,
+                   int64_t begin_clock_us, int64_t end_clock_us);
+
+    // Freeze the total duration
+    void finish();
+
+    const std::vector<TraceSpan>& spans() const { return spans_; }
+    const std::string& trace_id() const { return trace_id_; }
+    int64_t total_us() const { return total_us_; }
+
+    // Sum of the span durations of one kind
+    int64_t total_us(const std::string& kind) const;
+
+    // One line for the log: total and per-kind totals
+    std::string summary() const;
+
+    // One JSON object per span followed by one for the whole turn
+    std::string to_json_lines(const std::string& session_key) const;
+
+    // OTLP/JSON ExportTraceServiceRequest with a root span for the turn
+    Json to_otlp(const std::string& service_name, const std::string& session_key) const;
+
+private:
+    std::string trace_id_;
+    int64_t origin_us_;        // clock_us() at start
+    int64_t origin_unix_us_;   // Wall clock at start, for OTLP
+    int64_t total_us_;
+    std::vector<TraceSpan> spans_;
+};
+
+// Ships finished traces off the request path (LOW lane)
+class TraceExporter {
+public:
+    struct Config {
+        std::string file;            // Append traces here (empty = off)
+        std::string format;          // "jsonl" or "otlp" (one request per line)
+        std::string otlp_endpoint;   // POST OTLP/JSON here, e.g. http://collector:4318/v1/traces
+        std::string service_name;
+
+        Config() : format("jsonl"), service_name("openclaw") {}
+    };
+
+    explicit TraceExporter(ThreadPool& pool);
+
+    void set_config(const Config& config) { config_ = config; }
+    const Config& get_config() const { return config_; }
+    bool enabled() const { return !config_.file.empty() || !config_.otlp_endpoint.empty(); }
+
+    void export_trace(const AgentTrace& trace, const std::string& session_key);
+
+private:
+    void write_file(const std::string& text);
+
+    ThreadPool& pool_;
+    Config config_;
+    std::mutex file_mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_TRACE_HPP
@@ -26,6 +26,21 @@ struct Message {
     Message() : timestamp(0) {}
 };
 
+// Progress of an agent turn, for plugins that mirror turns live
+// (see Plugin::on_turn_event)
+struct TurnEvent {
+    enum Kind { DELTA, TOOL_START, TOOL_FINISH, DONE };
+    
+    Kind kind;
+    std::string request_id;      // ID of the message that started the turn
+    std::string channel;
+    std::string chat_id;
+    std::string text;            // DELTA: new text; TOOL_*: tool name; DONE: reply
+    bool success;                // TOOL_FINISH and DONE
+    
+    TurnEvent() : kind(DELTA), success(false) {}
+};
+
 // Result of sending a message
 struct SendResult {
     bool success;
@@ -58,6 +73,8 @@ struct ChannelCapabilities {
     bool supports_delete;
     bool supports_threads;
     bool supports_typing;
+    bool supports_streaming;    // Renders partial replies (send_stream_delta)
+    int edit_interval_ms;       // Least time between edits of one message (supports_edit)
     
     ChannelCapabilities() 
         : supports_groups(false)
@@ -66,7 +83,9 @@ struct ChannelCapabilities {
         , supports_edit(false)
         , supports_delete(false)
         , supports_threads(false)
-        , supports_typing(false) {}
+        , supports_typing(false)
+        , supports_streaming(false)
+        , edit_interval_ms(1000) {}
 };
 
 // Channel status
@@ -83,6 +102,7 @@ const char* channel_status_str(ChannelStatus s);
 // Callback types
 using MessageCallback = std::function<void(const Message&)>;
 using ErrorCallback = std::function<void(const std::string& channel, const std::string& error)>;
+using SendCallback = std::function<void(const SendResult&)>;
 
 // Forward declarations
 class Session;
@@ -138,6 +138,10 @@ std::string sha256_hex(const std::string& data);
 // Compute MD5 hash as hex string
 std::string md5_hex(const std::string& data);
 
+// XXH64 (non-cryptographic, several GB/s); for change detection, not identity
+uint64_t xxh64(const void* data, size_t len, uint64_t seed = 0);
+std::string xxh64_hex(const std::string& data);
+
 } // namespace openclaw
 
 #endif // OPENCLAW_CORE_UTILS_HPP
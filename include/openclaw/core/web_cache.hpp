@@ -0,0 +1,183 @@
+/*
+ * OpenClaw C++11 - Web Fetch Cache
+ *
+ * HTTP cache shared by every browser tool call, so a page the model
+ * fetches again a few iterations later (or from another session) is
+ * answered locally or revalidated instead of downloaded again.
+ *
+ * Features:
+ * - Keyed by normalized URL (scheme and host lowercased, default port,
+ *   empty path and fragment dropped)
+ * - Freshness from Cache-Control max-age (less Age) or Expires, else a
+ *   heuristic: 10% of the time since Last-Modified, capped at a default
+ * - no-store and Vary: * responses are not kept; no-cache ones are kept
+ *   but always revalidated
+ * - Stale entries are revalidated with If-None-Match / If-Modified-Since;
+ *   a 304 refreshes the entry without a download
+ * - Size-bounded LRU in memory, optional SQLite tier that survives restarts
+ * - Extracted text (html_text) and links are computed once per stored
+ *   response and shared by every later reader (memory tier only)
+ *
+ * Only successful (2xx) GETs are stored.
+ */
+#ifndef OPENCLAW_CORE_WEB_CACHE_HPP
+#define OPENCLAW_CORE_WEB_CACHE_HPP
+
+#include <openclaw/core/http_client.hpp>
+#include <openclaw/core/html_text.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+struct sqlite3;
+
+namespace openclaw {
+
+// Text extracted from a page, possibly only its first part
+struct WebText {
+    std::string text;
+    bool complete;              // False: cut short at max_chars
+    size_t max_chars;           // Budget it was extracted with
+
+    WebText() : complete(false), max_chars(0) {}
+};
+
+// A fetched response. Immutable apart from its lazily derived views.
+class WebPage {
+public:
+    std::string url;                // As requested
+    long status_code;
+    std::string content_type;
+    std::string etag;
+    std::string last_modified;
+    std::string body;
+
+    WebPage() : status_code(0) {}
+
+    // Text of the body, at least its first max_chars bytes: extracted on
+    // first use and again only when a longer part is wanted
+    std::shared_ptr<const WebText> text(size_t max_chars) const;
+
+    // Links of the body, extracted on first use
+    std::shared_ptr<const WebLinks> links() const;
+
+private:
+    mutable std::mutex mutex_;
+    mutable std::shared_ptr<const WebText> text_;
+    mutable std::shared_ptr<const WebLinks> links_;
+};
+
+typedef std::shared_ptr<const WebPage> WebPagePtr;
+
+struct WebFetchResult {
+    WebPagePtr page;                // Never null; status 0 when the request failed
+    std::string cache;              // "hit", "revalidated", "miss" or "bypass"
+};
+
+typedef std::function<void(const WebFetchResult& result)> WebFetchCallback;
+
+class WebCache {
+public:
+    struct Config {
+        size_t memory_bytes;        // LRU budget (0 = no memory tier)
+        std::string db_path;        // SQLite tier (empty = none)
+        int64_t default_ttl_seconds;    // Cap of the heuristic freshness (0 = none)
+        size_t max_body_bytes;      // Larger responses are not stored
+        size_t max_disk_entries;    // Least recently used rows go beyond this
+
+        Config() : memory_bytes(32 << 20), default_ttl_seconds(300),
+                   max_body_bytes(8 << 20), max_disk_entries(5000) {}
+    };
+
+    struct Stats {
+        uint64_t memory_hits;
+        uint64_t disk_hits;
+        uint64_t revalidated;       // 304s
+        uint64_t misses;
+        uint64_t stores;
+        uint64_t evictions;
+        size_t entries;
+        size_t bytes;
+
+        Stats() : memory_hits(0), disk_hits(0), revalidated(0), misses(0), stores(0),
+                  evictions(0), entries(0), bytes(0) {}
+    };
+
+    static WebCache& instance();
+
+    WebCache();
+    ~WebCache();
+
+    // Apply limits and open the disk tier if configured
+    bool configure(const Config& config);
+    void close();
+
+    // GET url through the cache. headers go out with the request; callers
+    // that vary the response by header should not use the cache.
+    WebFetchResult get(HttpClient& http, const std::string& url,
+                       const std::map<std::string, std::string>& headers);
+
+    // Same on the async HTTP engine. A hit calls on_done at once; otherwise
+    // it runs on the engine thread (storing to the disk tier there too).
+    void get_async(HttpClient& http, const std::string& url,
+                   const std::map<std::string, std::string>& headers, WebFetchCallback on_done);
+
+    static std::string normalize_url(const std::string& url);
+
+    // Page of a response obtained without the cache
+    static std::shared_ptr<WebPage> to_page(const std::string& url, const HttpResponse& response);
+
+    void clear();
+    Stats stats() const;
+
+private:
+    WebCache(const WebCache&);
+    WebCache& operator=(const WebCache&);
+
+    struct Entry {
+        std::string key;
+        std::shared_ptr<WebPage> page;
+        int64_t fresh_until;        // Unix seconds
+        size_t bytes;
+    };
+    typedef std::list<Entry> Lru;
+
+    // Cached entry, fresh or not; false when there is none
+    bool lookup(const std::string& key, Entry& out, bool& from_disk);
+    // A fresh cached answer for key (true), else the cached entry to
+    // revalidate, if any, and the conditional headers to send
+    bool begin(const std::string& key, WebFetchResult& hit, std::shared_ptr<Entry>& cached,
+               std::map<std::string, std::string>& headers);
+    void insert_locked(const Entry& entry);
+    void set_fresh_until(const std::string& key, int64_t fresh_until);
+    // Account for a response to a request for key; cached is what was
+    // revalidated (null if nothing was)
+    WebFetchResult finish(const std::string& key, const Entry* cached,
+                          const std::string& url, const HttpResponse& response);
+
+    bool disk_lookup(const std::string& key, Entry& out);
+    void disk_store(const Entry& entry);
+    void disk_touch(const std::string& key, int64_t fresh_until);
+
+    Config config_;
+
+    Lru lru_;                                       // Most recently used first
+    std::unordered_map<std::string, Lru::iterator> index_;
+    size_t bytes_;
+    Stats counters_;
+    mutable std::mutex mutex_;
+
+    sqlite3* db_;
+    uint64_t disk_stores_;                          // For periodic pruning
+    std::mutex db_mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_WEB_CACHE_HPP
@@ -0,0 +1,106 @@
+/*
+ * OpenClaw C++11 - Webhook Routing
+ *
+ * Lets channel plugins receive HTTP callbacks (Telegram updates, ...)
+ * without each of them running a web server.
+ *
+ * Features:
+ * - WebhookRouter: plugins register a handler per name, served on
+ *   POST /hooks/<name>. The gateway mounts the router on its Crow server
+ *   when it is loaded.
+ * - WebhookServer: a small embedded HTTP/1.1 listener for when there is
+ *   no gateway; one connection at a time, Connection: close
+ *
+ * Handlers run on the server's I/O thread: they should validate, queue
+ * the body and return at once.
+ */
+#ifndef OPENCLAW_CORE_WEBHOOK_HPP
+#define OPENCLAW_CORE_WEBHOOK_HPP
+
+#include <string>
+#include <map>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+namespace openclaw {
+
+// Visibility attribute so the gateway and channels share one router
+#ifdef __GNUC__
+#  define WEBHOOK_API __attribute__((visibility("default")))
+#else
+#  define WEBHOOK_API
+#endif
+
+struct WebhookRequest {
+    std::string name;                               // <name> in /hooks/<name>
+    std::map<std::string, std::string> headers;     // Lowercased names
+    std::string body;
+
+    std::string header(const std::string& lower_name) const {
+        std::map<std::string, std::string>::const_iterator it = headers.find(lower_name);
+        return it == headers.end() ? std::string() : it->second;
+    }
+};
+
+struct WebhookResponse {
+    int status;
+    std::string body;
+
+    WebhookResponse(int s = 200, const std::string& b = "") : status(s), body(b) {}
+};
+
+class WEBHOOK_API WebhookRouter {
+public:
+    typedef std::function<WebhookResponse(const WebhookRequest&)> Handler;
+
+    static WebhookRouter& instance();
+
+    static const char* path_prefix() { return "/hooks/"; }
+
+    void add(const std::string& name, Handler handler);
+    void remove(const std::string& name);
+
+    // 404 when nothing is registered under the name
+    WebhookResponse dispatch(const WebhookRequest& request) const;
+
+    // Set by the gateway once /hooks/ is routed on its server
+    void set_mounted(bool mounted) { mounted_ = mounted; }
+    bool mounted() const { return mounted_; }
+
+private:
+    WebhookRouter() : mounted_(false) {}
+    WebhookRouter(const WebhookRouter&);
+    WebhookRouter& operator=(const WebhookRouter&);
+
+    std::map<std::string, Handler> handlers_;
+    mutable std::mutex mutex_;
+    std::atomic<bool> mounted_;
+};
+
+// Serves POST /hooks/<name> from the router on its own port
+class WEBHOOK_API WebhookServer {
+public:
+    WebhookServer();
+    ~WebhookServer();
+
+    bool start(const std::string& bind_host, int port);
+    void stop();
+    bool running() const { return thread_.joinable(); }
+
+private:
+    WebhookServer(const WebhookServer&);
+    WebhookServer& operator=(const WebhookServer&);
+
+    void run();
+    void serve(int fd);
+
+    int listen_fd_;
+    std::thread thread_;
+    std::atomic<bool> stop_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_CORE_WEBHOOK_HPP
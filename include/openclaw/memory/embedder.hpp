@@ -0,0 +1,49 @@
+/*
+ * OpenClaw C++11 - Memory Embedder
+ *
+ * Turns chunk and query text into vectors for semantic memory search.
+ * Speaks the OpenAI-style /v1/embeddings API (OpenAI, llama.cpp server,
+ * most local runtimes) and llama.cpp's native /embedding endpoint.
+ *
+ * Features:
+ * - Batched requests (EmbeddingConfig::batch_size texts per call)
+ * - Vectors are L2-normalized, so a dot product is the cosine similarity
+ */
+#ifndef OPENCLAW_MEMORY_EMBEDDER_HPP
+#define OPENCLAW_MEMORY_EMBEDDER_HPP
+
+#include "types.hpp"
+#include <string>
+#include <vector>
+
+namespace openclaw {
+
+class Embedder {
+public:
+    explicit Embedder(const EmbeddingConfig& config);
+
+    // One vector per text, in order. False (with error set) if any batch
+    // failed; out is then incomplete.
+    bool embed(const std::vector<std::string>& texts,
+               std::vector<std::vector<float> >& out,
+               std::string& error) const;
+    bool embed_one(const std::string& text, std::vector<float>& out, std::string& error) const;
+
+    // Tag stored vectors with this so a model change invalidates them
+    std::string model_tag() const;
+
+    const EmbeddingConfig& config() const { return config_; }
+
+    static void normalize(std::vector<float>& v);
+
+private:
+    EmbeddingConfig config_;
+    bool native_;       // llama.cpp /embedding instead of /v1/embeddings
+
+    bool embed_batch(const std::vector<std::string>& texts, size_t begin, size_t end,
+                     std::vector<std::vector<float> >& out, std::string& error) const;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_MEMORY_EMBEDDER_HPP
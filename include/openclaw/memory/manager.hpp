@@ -4,17 +4,31 @@
  * High-level interface for memory operations.
  * Handles file discovery, chunking, indexing, and search.
  * Supports both memory files and session transcripts.
+ * With an embedding endpoint configured, search fuses BM25 and vector
+ * rankings (reciprocal-rank fusion).
+ * With watch_enabled, a file watcher reindexes changed files as they
+ * change; the full directory walk then only runs on explicit syncs.
+ * Once a task callback is set, every pending task with a due date sits on
+ * the process timer wheel, so reminders fire at their deadline without
+ * polling the tasks table.
  */
 #ifndef OPENCLAW_MEMORY_MANAGER_HPP
 #define OPENCLAW_MEMORY_MANAGER_HPP
 
 #include "types.hpp"
 #include "store.hpp"
+#include "embedder.hpp"
+#include "vector_index.hpp"
+#include "watcher.hpp"
+#include <openclaw/core/thread_pool.hpp>
+#include <openclaw/core/timer_wheel.hpp>
 #include <string>
 #include <vector>
 #include <memory>
 #include <set>
 #include <map>
+#include <mutex>
+#include <functional>
 
 namespace openclaw {
 
@@ -61,20 +75,29 @@ public:
     // Get file content by path (legacy)
     std::string get_memory_content(const std::string& path);
     
-    // Task operations
-    std::string create_task(const std::string& content, const std::string& context = "");
+    // Task operations; channel and user_id say where its reminder goes
+    std::string create_task(const std::string& content, const std::string& context = "",
+                            const std::string& channel = "", const std::string& user_id = "");
     bool complete_task(const std::string& task_id);
     std::vector<MemoryTask> list_tasks(bool include_completed = false);
     std::vector<MemoryTask> get_pending_tasks();
     std::vector<MemoryTask> get_tasks_due_soon(int hours = 24);
     bool update_task_due(const std::string& task_id, int64_t due_at);
     
+    // Called on the timer wheel's thread when a pending task falls due
+    // (right away for ones already overdue). Keep it short; it should hand
+    // delivery off and call mark_task_notified once the reminder is out.
+    typedef std::function<void(const MemoryTask& task)> TaskCallback;
+    void set_task_callback(TaskCallback callback);
+    bool mark_task_notified(const std::string& task_id);
+    
     // Status
     struct MemoryStatus {
         std::string backend;        // "builtin"
-        std::string provider;       // "bm25" (no vectors yet)
+        std::string provider;       // "bm25", or "bm25+vector" with embeddings
         int files;
         int chunks;
+        int vectors;                // Chunks in the vector index
         bool dirty;
         bool sessions_dirty;
         std::string workspace_dir;
@@ -90,14 +113,45 @@ public:
     std::string last_error() const;
     const MemoryConfig& config() const;
     
+    // Indexing text pipeline; needs no store (also used by the benchmarks).
+    // User and assistant text of the complete JSONL lines from byte from
+    // (consumed: bytes read), and content split into chunks
+    std::string extract_session_text(const std::string& jsonl_content, size_t from, size_t& consumed);
+    std::vector<MemoryChunk> chunk_content(const std::string& content, 
+                                           const std::string& path,
+                                           MemorySource source);
+    
 private:
     MemoryConfig config_;
     std::unique_ptr<MemoryStore> store_;
+    std::unique_ptr<Embedder> embedder_;    // Null without an embedding URL
+    std::unique_ptr<ThreadPool> index_pool_;    // Created by the first large sync
+    std::unique_ptr<FileWatcher> watcher_;      // With watch_enabled, on supported platforms
+    mutable std::recursive_mutex mutex_;        // Store access: callers and the watcher thread
+    VectorIndex vectors_;
+    std::string vectors_path_;              // Index snapshot next to the database
+    bool vectors_dirty_;
+    int64_t vectors_saved_at_;
+    int64_t embed_retry_at_;                // Embedding endpoint failed; skip until then
     bool initialized_;
     bool dirty_;
     bool sessions_dirty_;
     std::string last_error_;
+    mutable std::mutex error_mutex_;            // last_error_ (searches run unlocked)
     std::set<std::string> session_warm_;  // Session keys that have been warmed
+    
+    // Due-task timers, keyed by task id (tasks_mutex_, not mutex_, so the
+    // wheel never waits on a sync)
+    struct ArmedTask {
+        TimerWheel::TimerId timer;
+        MemoryTask task;
+    };
+    std::map<std::string, ArmedTask> armed_tasks_;
+    TaskCallback task_callback_;
+    std::mutex tasks_mutex_;
+    void arm_task(const MemoryTask& task);
+    void disarm_task(const std::string& task_id);
+    void fire_task(const std::string& task_id, int64_t due_at);
     std::set<std::string> sessions_dirty_files_;  // Session files that need re-indexing
     
     // Session delta tracking
@@ -109,31 +163,68 @@ private:
     std::map<std::string, SessionDelta> session_deltas_;
     
     // File discovery
-    std::vector<MemoryFile> discover_memory_files();
+    std::vector<std::string> discover_memory_files();
     MemoryFile build_file_entry(const std::string& abs_path);
     
+    // Sync pipeline: prepare_file runs on index_pool_ workers (stat, read,
+    // hash, chunk); only the syncing thread writes the results to SQLite
+    struct PreparedFile {
+        enum State { UNCHANGED, TOUCHED, CHANGED };
+        State state;
+        MemoryFile file;
+        std::vector<MemoryChunk> chunks;    // CHANGED only
+        
+        PreparedFile() : state(UNCHANGED) {}
+    };
+    PreparedFile prepare_file(const std::string& abs_path,
+                              const std::map<std::string, MemoryFile>& stored);
+    bool write_prepared(const PreparedFile& prepared);     // True if chunks were replaced
+    
+    // Watcher: changed paths are synced one by one; a directory (or lost
+    // events) falls back to a walk
+    void start_watching();
+    void on_files_changed(const std::set<std::string>& paths, bool overflow);
+    bool sync_memory_paths(const std::vector<std::string>& abs_paths);
+    bool sync_session_paths(const std::vector<std::string>& abs_paths);
+    ThreadPool& index_pool();
+    
     // Session file operations
     std::vector<std::string> list_session_files();
     SessionFileEntry build_session_entry(const std::string& abs_path);
-    std::string extract_session_text(const std::string& jsonl_content);
     std::string normalize_session_text(const std::string& text);
     bool sync_session_files();
+    bool sync_session_file(const std::string& abs_path, std::string& rel_path);     // True if indexed
     bool should_sync_sessions(const std::string& reason, bool force);
     
     // Indexing
-    bool index_file(const MemoryFile& file);
-    bool index_session_file(const SessionFileEntry& entry);
-    std::vector<MemoryChunk> chunk_content(const std::string& content, 
-                                           const std::string& path,
-                                           MemorySource source);
+    bool index_session_file(const SessionFileEntry& entry, const std::string& content);
+    bool index_session_tail(const SessionFileEntry& entry, const MemoryFile& existing);
+    
+    // Vector helpers
+    void reconcile_vectors();
+    void embed_chunks(const std::vector<MemoryChunk>& chunks);
+    void save_vectors(bool force);
+    std::vector<MemorySearchResult> hybrid_search(const std::string& query, const MemorySearchConfig& config);
     
     // Chunking helpers
-    std::vector<std::string> split_into_paragraphs(const std::string& content);
+    struct Paragraph {
+        size_t first_line;      // 0-indexed, inclusive
+        size_t last_line;
+        size_t size;            // Chars including newlines
+        uint64_t hash;          // FNV-1a of the text; picks chunk boundaries
+    };
+    std::vector<Paragraph> split_into_paragraphs(const std::string& content,
+                                                 std::vector<std::string>& lines);
+    void emit_chunk(const std::vector<std::string>& lines, size_t first_line, size_t last_line,
+                    const std::string& path, MemorySource source, int64_t now,
+                    std::map<std::string, int>& seen, std::vector<MemoryChunk>& out);
+    static size_t overlap_start(const std::vector<std::string>& lines, size_t first_line,
+                                size_t last_line, size_t overlap_chars);
+    static bool is_blank_line(const std::string& line);
     std::string compute_hash(const std::string& content);
     std::string generate_uuid();
     
     // Text helpers
-    std::string unescape_json_string(const std::string& s);
     std::string load_file_content(const std::string& abs_path);
     
     // Path helpers
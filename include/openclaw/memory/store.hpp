@@ -2,7 +2,16 @@
  * OpenClaw C++11 - Memory SQLite Store
  * 
  * SQLite-based storage for memory indexing and search.
- * Uses FTS5 for full-text search (BM25 ranking).
+ * Uses FTS5 for full-text search (BM25 ranking) and keeps chunk
+ * embeddings keyed by text hash, so unchanged text is never re-embedded.
+ * Write statements are prepared once and reused; indexing runs inside
+ * explicit transactions (begin/commit) instead of one commit per row.
+ *
+ * Threading: searches, chunk and task lookups and get_meta run on a pool
+ * of read-only connections (WAL lets them proceed during a write) and may
+ * be called from any thread. Everything else uses the single writer
+ * connection, and callers serialize it. Without a pool (in-memory
+ * databases) reads share the writer too.
  */
 #ifndef OPENCLAW_MEMORY_STORE_HPP
 #define OPENCLAW_MEMORY_STORE_HPP
@@ -10,6 +19,10 @@
 #include "types.hpp"
 #include <string>
 #include <vector>
+#include <map>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
 #include <sqlite3.h>
 
 namespace openclaw {
@@ -19,14 +32,28 @@ public:
     MemoryStore();
     ~MemoryStore();
     
-    // Initialize database at path
-    bool open(const std::string& db_path);
+    // Initialize database at path, with this many read-only connections
+    bool open(const std::string& db_path, int read_connections = 4);
     void close();
     bool is_open() const;
+    // True when reads run on their own connections (safe from any thread)
+    bool has_read_pool() const;
     
     // Schema management
     bool ensure_schema();
     
+    // Transactions; nested calls become savepoints of the outermost one.
+    // Every write in between shares one commit (and one WAL sync).
+    bool begin();
+    bool commit();
+    void rollback();
+    
+    // Replace all chunks of a file and its record in one transaction.
+    // Chunks already stored with the same id and hash are kept in place.
+    bool replace_file(const MemoryFile& file, const std::vector<MemoryChunk>& chunks);
+    // Add chunks to a file (appended transcript text) and update its record
+    bool append_file_chunks(const MemoryFile& file, const std::vector<MemoryChunk>& chunks);
+    
     // File operations
     bool upsert_file(const MemoryFile& file);
     bool delete_file(const std::string& path, MemorySource source);
@@ -39,10 +66,24 @@ public:
     bool delete_chunks_for_file(const std::string& path, MemorySource source);
     std::vector<MemoryChunk> get_chunks_for_file(const std::string& path, MemorySource source);
     int count_chunks(MemorySource source);
+    int max_end_line(const std::string& path, MemorySource source);
+    std::vector<MemoryChunk> get_chunks(const std::vector<std::string>& ids);
+    std::vector<std::pair<std::string, std::string> > list_chunk_hashes();   // (id, hash)
     
-    // Search operations (BM25 full-text search)
+    // Embedding operations (vectors per text hash and model)
+    bool get_embedding(const std::string& hash, const std::string& model, std::vector<float>& out);
+    bool put_embedding(const std::string& hash, const std::string& model, const std::vector<float>& vec);
+    int prune_embeddings();     // Drop vectors no chunk refers to
+    
+    // Search operations (BM25 full-text search); snippets are cut by FTS5
+    // to config.snippet_tokens unless ids_only drops the text altogether
     std::vector<MemorySearchResult> search(const std::string& query, const MemorySearchConfig& config);
     
+    // Snippet of roughly `tokens` words around the first query term in
+    // text, for hits that did not come through FTS5 (0 = text unchanged)
+    static std::string excerpt(const std::string& text, const std::string& query,
+                               const MemorySearchConfig& config);
+    
     // Task operations
     bool upsert_task(const MemoryTask& task);
     bool delete_task(const std::string& id);
@@ -51,6 +92,7 @@ public:
     std::vector<MemoryTask> get_pending_tasks();
     std::vector<MemoryTask> get_tasks_due_before(int64_t timestamp);
     bool complete_task(const std::string& id);
+    bool mark_task_notified(const std::string& id, int64_t at);
     
     // Meta operations
     bool set_meta(const std::string& key, const std::string& value);
@@ -63,16 +105,56 @@ private:
     sqlite3* db_;
     std::string last_error_;
     bool fts_available_;
+    int transaction_depth_;
+    std::map<std::string, sqlite3_stmt*> statements_;
+    
+    // Cached prepared statement, reset and unbound (null on error)
+    sqlite3_stmt* statement(const char* sql);
+    
+    // Read-only connection with its own statement cache
+    struct Reader {
+        sqlite3* db;
+        std::map<std::string, sqlite3_stmt*> statements;
+    };
+    // Borrows an idle reader (waiting if all are busy), or the writer when
+    // there is no pool; statements handed out are reset on release
+    class ReadLease {
+    public:
+        explicit ReadLease(MemoryStore& store);
+        ~ReadLease();
+        sqlite3_stmt* statement(const char* sql);
+    private:
+        ReadLease(const ReadLease&);
+        ReadLease& operator=(const ReadLease&);
+        MemoryStore& store_;
+        Reader* reader_;
+        std::vector<sqlite3_stmt*> used_;
+    };
+    std::vector<Reader*> readers_;
+    std::vector<Reader*> idle_readers_;
+    mutable std::mutex readers_mutex_;
+    std::condition_variable readers_cv_;
+    mutable std::mutex error_mutex_;
+    void close_readers();
+    
+    // Step a write statement, then reset it; false (error set) unless DONE
+    bool step_done(sqlite3_stmt* stmt);
+    bool insert_chunk(const MemoryChunk& chunk);
+    bool remove_chunk(const std::string& id);
+    bool update_chunk_lines(const MemoryChunk& chunk);
+    bool list_file_chunks(const std::string& path, const std::string& source,
+                          std::map<std::string, std::string>& out);   // id -> hash
+    bool remove_file_chunks(const std::string& path, const std::string& source);
     
+    bool has_column(const std::string& table, const std::string& column);
     bool exec(const std::string& sql);
     bool exec(const std::string& sql, std::string& error);
     void set_error(const std::string& error);
     void set_error_from_db();
     
-    // FTS helpers
+    // FTS helpers (chunks_fts rows share the rowid of their chunks row)
     bool ensure_fts_table();
-    bool sync_chunk_to_fts(const MemoryChunk& chunk);
-    bool delete_chunk_from_fts(const std::string& chunk_id);
+    static std::string fts_query(const std::string& query);
 };
 
 } // namespace openclaw
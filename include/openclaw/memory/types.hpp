@@ -40,16 +40,17 @@ struct MemoryFile {
     std::string path;       // Relative path from workspace
     std::string abs_path;   // Absolute path
     MemorySource source;    // Where it came from
-    std::string hash;       // SHA256 of content
+    std::string hash;       // XXH64 of content (transcripts: of the 4 KB before size)
     int64_t mtime;          // Modification time (unix ms)
-    int64_t size;           // File size in bytes
+    int64_t size;           // File size in bytes (transcripts: bytes indexed)
+    int64_t inode;          // Inode; with mtime and size, skips rehashing
     
-    MemoryFile() : source(MemorySource::MEMORY), mtime(0), size(0) {}
+    MemoryFile() : source(MemorySource::MEMORY), mtime(0), size(0), inode(0) {}
 };
 
 // A chunk of text from a memory file (for indexing/search)
 struct MemoryChunk {
-    std::string id;         // Unique chunk ID (uuid or hash-based)
+    std::string id;         // Chunk ID, derived from path and text
     std::string path;       // File path this chunk is from
     MemorySource source;    // Source type
     int start_line;         // Starting line number (1-indexed)
@@ -63,6 +64,7 @@ struct MemoryChunk {
 
 // Result from a memory search
 struct MemorySearchResult {
+    std::string chunk_id;   // Chunk the snippet came from
     std::string path;       // File path
     int start_line;         // Starting line of snippet
     int end_line;           // Ending line of snippet
@@ -88,10 +90,11 @@ struct SessionFileEntry {
     std::string abs_path;   // Absolute path
     int64_t mtime_ms;       // Modification time (unix ms)
     int64_t size;           // File size in bytes
+    int64_t inode;          // Inode
     std::string hash;       // Hash of extracted content
     std::string content;    // Extracted conversation text
     
-    SessionFileEntry() : mtime_ms(0), size(0) {}
+    SessionFileEntry() : mtime_ms(0), size(0), inode(0) {}
 };
 
 // Citation mode for memory search results
@@ -126,8 +129,9 @@ struct MemoryTask {
     int64_t due_at;         // Due date (0 = no due date)
     bool completed;         // Whether task is done
     int64_t completed_at;   // When completed
+    int64_t notified_at;    // When the due reminder went out (0 = not yet)
     
-    MemoryTask() : created_at(0), due_at(0), completed(false), completed_at(0) {}
+    MemoryTask() : created_at(0), due_at(0), completed(false), completed_at(0), notified_at(0) {}
 };
 
 // Configuration for memory chunking
@@ -146,21 +150,43 @@ struct ChunkingConfig {
 struct MemorySearchConfig {
     int max_results;        // Maximum results to return
     double min_score;       // Minimum relevance score
-    bool hybrid_enabled;    // Use hybrid BM25 + vector search
+    bool hybrid_enabled;    // Use hybrid BM25 + vector search (needs an embedder)
     double bm25_weight;     // Weight for BM25 keyword search
     double vector_weight;   // Weight for vector similarity
+    int rrf_k;              // Reciprocal-rank fusion constant
     MemoryCitationMode citation_mode; // How to handle citations
+    int snippet_tokens;     // Snippet window around the match (0 = whole chunk, max 64)
+    std::string highlight_open;  // Wrapped around matched terms in snippets
+    std::string highlight_close;
+    bool ids_only;          // Chunk ids, paths, lines and scores; no text
     
     MemorySearchConfig() 
         : max_results(10)
         , min_score(0.1)
-        , hybrid_enabled(false)  // Vector search not implemented yet
+        , hybrid_enabled(true)
         , bm25_weight(1.0)
-        , vector_weight(0.0)
+        , vector_weight(1.0)
+        , rrf_k(60)
         , citation_mode(MemoryCitationMode::AUTO)
+        , snippet_tokens(48)
+        , ids_only(false)
     {}
 };
 
+// Configuration for chunk embeddings (vector search is off without a URL)
+struct EmbeddingConfig {
+    std::string url;        // OpenAI-style .../v1/embeddings or llama.cpp .../embedding
+    std::string model;      // Sent with OpenAI-style requests; also tags stored vectors
+    std::string api_key;    // Bearer token (optional)
+    int batch_size;         // Texts per request
+    int timeout_ms;         // Per request
+    int nprobe;             // IVF lists scanned per query
+    
+    EmbeddingConfig() : batch_size(32), timeout_ms(60000), nprobe(8) {}
+    
+    bool enabled() const { return !url.empty(); }
+};
+
 // Session sync configuration
 struct SessionSyncConfig {
     int delta_bytes;        // Trigger sync after this many new bytes
@@ -183,17 +209,20 @@ struct MemoryConfig {
     std::string agent_id;           // Agent identifier
     ChunkingConfig chunking;
     MemorySearchConfig search;
+    EmbeddingConfig embedding;
     SessionSyncConfig session_sync;
     std::vector<std::string> sources;  // "memory", "sessions"
     std::vector<std::string> extra_paths; // Additional memory paths
     bool watch_enabled;             // Watch files for changes
     int sync_interval_minutes;      // Auto-sync interval (0 = disabled)
     int watch_debounce_ms;          // Debounce time for file watch
+    int read_connections;           // Read-only SQLite connections for searches
     
     MemoryConfig() 
         : watch_enabled(false)
         , sync_interval_minutes(0)
         , watch_debounce_ms(1500)
+        , read_connections(4)
     {
         sources.push_back("memory");
     }
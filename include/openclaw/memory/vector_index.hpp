@@ -0,0 +1,83 @@
+/*
+ * OpenClaw C++11 - Memory Vector Index
+ *
+ * In-process approximate nearest-neighbour index over chunk embeddings
+ * (inverted file, IVF). Vectors are clustered around k-means centroids;
+ * a query scans only the vectors of its nprobe nearest lists.
+ *
+ * Features:
+ * - Exact scan until the index is big enough to be worth clustering
+ * - Re-clusters from a sample whenever the index has doubled
+ * - SSE dot products where available
+ * - Binary snapshot next to the SQLite database, tagged with the model
+ * - Thread-safe; searches share the lock with incremental updates
+ */
+#ifndef OPENCLAW_MEMORY_VECTOR_INDEX_HPP
+#define OPENCLAW_MEMORY_VECTOR_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <mutex>
+#include <cstdint>
+
+namespace openclaw {
+
+class VectorIndex {
+public:
+    typedef std::pair<std::string, float> Hit;     // Chunk id, cosine similarity
+
+    VectorIndex();
+
+    // Drop everything; vectors must have this many dimensions from now on
+    void reset(size_t dims);
+
+    // Vectors must be L2-normalized. Adding an existing id replaces it.
+    bool add(const std::string& id, const std::vector<float>& vec);
+    void remove(const std::string& id);
+    bool contains(const std::string& id) const;
+    std::vector<std::string> ids() const;
+
+    // Best k by cosine similarity, best first
+    std::vector<Hit> search(const std::vector<float>& query, size_t k, size_t nprobe) const;
+
+    size_t size() const;
+    size_t dims() const;
+    size_t lists() const;
+
+    // Snapshot; load() fails (leaving the index empty) on a tag mismatch
+    bool save(const std::string& path, const std::string& tag) const;
+    bool load(const std::string& path, const std::string& tag);
+
+    static float dot(const float* a, const float* b, size_t n);
+
+private:
+    VectorIndex(const VectorIndex&);
+    VectorIndex& operator=(const VectorIndex&);
+
+    static const size_t MIN_TRAIN = 1024;      // Exact scan below this size
+    static const uint32_t NO_LIST = 0xffffffffu;
+
+    const float* vec_locked(size_t slot) const { return &data_[slot * dims_]; }
+    uint32_t nearest_list_locked(const float* v) const;
+    void train_locked();
+    void reset_locked(size_t dims);
+
+    size_t dims_;
+    std::vector<float> data_;                   // Slot-major vectors
+    std::vector<std::string> ids_;              // Per slot; empty = free
+    std::vector<uint32_t> list_of_;             // Per slot
+    std::vector<size_t> free_;
+    std::unordered_map<std::string, size_t> slot_of_;
+
+    std::vector<float> centroids_;              // lists * dims
+    std::vector<std::vector<uint32_t> > lists_; // Slots per centroid
+    size_t trained_size_;                       // Size at the last clustering
+
+    mutable std::mutex mutex_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_MEMORY_VECTOR_INDEX_HPP
@@ -0,0 +1,66 @@
+/*
+ * OpenClaw C++11 - Memory File Watcher
+ *
+ * Watches a few directories (non-recursively) and reports the paths that
+ * changed, from its own thread, once the burst of events has settled.
+ * Uses inotify on Linux. Elsewhere a kqueue shim watches the directories
+ * themselves, so it reports the directory (files added, removed or
+ * renamed) rather than the file, and misses in-place content edits.
+ *
+ * Features:
+ * - Debouncing: events coalesce until debounce_ms pass without new ones
+ *   (at most 4 x debounce_ms after the first, for files written nonstop)
+ * - Directories that do not exist yet (or are recreated) are picked up
+ *   when they appear, and reported as changed
+ * - Lost events (queue overflow) are reported so callers can rescan
+ */
+#ifndef OPENCLAW_MEMORY_WATCHER_HPP
+#define OPENCLAW_MEMORY_WATCHER_HPP
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+namespace openclaw {
+
+class FileWatcher {
+public:
+    // Changed paths (files, or a directory when names are unknown) and
+    // whether events were lost since the last call
+    typedef std::function<void(const std::set<std::string>& paths, bool overflow)> Callback;
+
+    FileWatcher();
+    ~FileWatcher();
+
+    // False if the platform has no watcher or it cannot be created
+    bool start(const std::vector<std::string>& dirs, int debounce_ms, Callback callback);
+    void stop();
+    bool running() const { return thread_.joinable(); }
+
+private:
+    FileWatcher(const FileWatcher&);
+    FileWatcher& operator=(const FileWatcher&);
+
+    void run();
+    // Watch directories not watched yet; true if any newly appeared
+    bool add_missing(std::set<std::string>& changed);
+    // Wait up to timeout_ms for events; true if any were collected
+    bool wait_events(int timeout_ms, std::set<std::string>& changed, bool& overflow);
+
+    std::vector<std::string> dirs_;
+    std::vector<int> handles_;          // Per dir: watch descriptor or fd, -1 if missing
+    std::map<int, size_t> dir_of_;      // Handle -> index into dirs_
+    int fd_;                            // inotify instance or kqueue
+    int debounce_ms_;
+    Callback callback_;
+    std::thread thread_;
+    std::atomic<bool> stop_;
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_MEMORY_WATCHER_HPP
@@ -7,16 +7,28 @@
  * Config:
  *   ai.api_key    - Your Anthropic API key
  *   ai.model      - Default model (optional, defaults to claude-sonnet-4-20250514)
+ *
+ * Calls with CompletionOptions::batch are collected for batch_window_ms
+ * (or until batch_max_requests) and sent as one Message Batch, which is
+ * polled every batch_poll_seconds until its results are in. The batch
+ * settings follow config reloads.
  */
 #ifndef OPENCLAW_PLUGINS_CLAUDE_HPP
 #define OPENCLAW_PLUGINS_CLAUDE_HPP
 
 #include <openclaw/ai/ai.hpp>
 #include <openclaw/core/http_client.hpp>
+#include <openclaw/core/sse.hpp>
+#include <openclaw/core/timer_wheel.hpp>
+#include <openclaw/core/snapshot.hpp>
+#include <memory>
 #include <openclaw/core/logger.hpp>
 #include <openclaw/core/config.hpp>
 #include <sstream>
 #include <cstdlib>
+#include <vector>
+#include <map>
+#include <mutex>
 
 namespace openclaw {
 
@@ -30,6 +42,7 @@ public:
     const char* description() const;
     
     bool init(const Config& cfg);
+    void reconfigure(const Config& cfg);
     void shutdown();
     bool is_initialized() const;
     
@@ -38,6 +51,10 @@ public:
     std::vector<std::string> available_models() const;
     std::string default_model() const;
     bool is_configured() const;
+    int context_window(const std::string& model = "") const;
+    TokenEstimator token_estimator() const;
+    bool supports_native_tools() const;
+    bool supports_batch() const;
     
     // Single prompt completion
     CompletionResult complete(
@@ -51,6 +68,13 @@ public:
         const CompletionOptions& opts = CompletionOptions()
     );
     
+    // Conversation completion on the async HTTP engine
+    void chat_async(
+        const std::vector<ConversationMessage>& messages,
+        const CompletionOptions& opts,
+        CompletionCallback on_done
+    );
+    
     // Convenience method: simple question-answer
     std::string ask(const std::string& question, const std::string& system = "");
     
@@ -62,11 +86,67 @@ public:
     );
 
 private:
+    // Shared by chat() and chat_async()
+    bool build_request(const std::vector<ConversationMessage>& messages,
+                       const CompletionOptions& opts,
+                       HttpRequest& out,
+                       std::string& error) const;
+    CompletionResult parse_response(const HttpResponse& response) const;
+    
+    // Streaming (SSE) responses: deltas go to opts.on_chunk as they arrive
+    struct StreamState;
+    typedef std::shared_ptr<StreamState> StreamStatePtr;
+    StreamStatePtr attach_stream(HttpRequest& req, const CompletionOptions& opts) const;
+    CompletionResult finish_stream(StreamState& state, const HttpResponse& response) const;
+    
+    // Message Batches: requests collected for one submission, and
+    // submitted batches waiting for their results
+    struct BatchItem {
+        std::string custom_id;
+        Json params;                    // Messages API request body
+        CompletionCallback on_done;
+    };
+    struct Batch {
+        std::string id;
+        std::map<std::string, CompletionCallback> waiting;   // By custom_id
+    };
+    typedef std::shared_ptr<Batch> BatchPtr;
+    // What batch callbacks hold instead of the plugin (see claude.cpp)
+    struct CallbackGuard;
+    typedef std::shared_ptr<CallbackGuard> CallbackGuardPtr;
+    struct BatchSettings {
+        int64_t window_ms;
+        size_t max_requests;
+        int64_t poll_ms;
+        
+        BatchSettings() : window_ms(2000), max_requests(100), poll_ms(30000) {}
+        
+        // Read claude.batch_* keys
+        static BatchSettings from_config(const Config& cfg);
+    };
+    
+    HttpRequest api_request(const std::string& method, const std::string& url,
+                            const std::string& body = "") const;
+    void queue_batched(const std::vector<ConversationMessage>& messages,
+                       const CompletionOptions& opts, CompletionCallback on_done);
+    void flush_batch();
+    void submit_batch(std::vector<BatchItem> items);
+    void schedule_poll(BatchPtr batch);
+    void poll_batch(BatchPtr batch);
+    void collect_batch(BatchPtr batch, const std::string& results_url);
+    
     std::string api_key_;
     std::string default_model_;
     std::string api_url_;
     std::string api_version_;
     bool initialized_;
+    
+    Snapshot<BatchSettings> batch_settings_;
+    std::mutex batch_mutex_;
+    std::vector<BatchItem> batch_pending_;
+    TimerWheel::TimerId batch_timer_;
+    uint64_t batch_seq_;
+    CallbackGuardPtr batch_guard_;
 };
 
 } // namespace openclaw
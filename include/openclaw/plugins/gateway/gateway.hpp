@@ -2,18 +2,24 @@
 #define OPENCLAW_PLUGINS_GATEWAY_GATEWAY_HPP
 
 #include "../../core/plugin.hpp"
+#include "../../core/reactor.hpp"
 #include "../../core/types.hpp"
 #include "../../core/json.hpp"
 #include <string>
 #include <map>
 #include <vector>
 #include <set>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <cstdint>
 
 namespace openclaw {
 
 // Forward declarations
 class WebSocketServer;
 class GatewayClient;
+struct GatewaySendQueue;
 
 // Gateway Server Plugin
 // Implements a WebSocket-based gateway for remote agent control
@@ -32,7 +38,8 @@ public:
     
     virtual bool init(const Config& cfg);
     virtual void shutdown();
-    virtual void poll();  // Poll WebSocket server
+    virtual void poll();  // Start the server, flush coalesced events
+    virtual int poll_interval_ms() const { return 0; }  // Reactor-driven
     
     // Receive all incoming messages for routing to gateway clients
     virtual void on_incoming_message(const Message& msg) override;
@@ -42,6 +49,9 @@ public:
                                      const std::string& chat_id,
                                      bool typing) override;
     
+    // Stream agent turns to clients (chat.delta, chat.tool, chat.done)
+    virtual void on_turn_event(const TurnEvent& event) override;
+    
     // Gateway operations
     bool start(int port = 18789);
     void stop();
@@ -51,10 +61,11 @@ public:
     int port() const { return port_; }
     size_t client_count() const;
     
-    // Broadcast events to all connected clients
+    // Broadcast events to all connected clients. The frame is serialized
+    // once and queued per client; the Crow I/O thread writes it out.
     void broadcast(const std::string& event, const Json& payload);
     
-    // Send typing indicator event
+    // Send typing indicator event (coalesced per chat, see queue_event)
     void send_typing_event(const std::string& channel_id, 
                           const std::string& chat_id, 
                           bool typing);
@@ -65,20 +76,63 @@ public:
     // Protocol handlers (public for WebSocketServer callback)
     void handle_client_connect(GatewayClient* client);
     void handle_client_disconnect(GatewayClient* client);
-    void handle_client_message(GatewayClient* client, const std::string& msg);
+    void handle_client_message(GatewayClient* client, const std::string& msg,
+                               bool is_binary = false);
+    
+    // Frames a client may have queued before it counts as a slow consumer
+    size_t send_queue_max() const { return send_queue_max_; }
+    
+    // /metrics: served at all, and the bearer token it requires (if any)
+    bool metrics_enabled() const { return metrics_enabled_; }
+    const std::string& auth_token() const { return auth_token_; }
     
 private:
+    // Queue one frame for every client (see GatewayClient::enqueue)
+    void broadcast_frame(const std::string& event, const Json& payload,
+                         const std::string& coalesce_key, bool droppable);
+    
+    // Hold an event for the next flush; a pending event with the same
+    // coalesce key is replaced in place. Sent at once when coalescing is off.
+    void queue_event(const std::string& event, const Json& payload,
+                     const std::string& coalesce_key, bool droppable);
+    // Queue a chat.delta, appending to the last pending event when that is
+    // a delta of the same turn
+    void queue_delta(const Json& payload);
+    // Start the flush timer for the first pending event (pending_mutex_ held)
+    void arm_flush_locked();
+    // Send pending events: one "batch" frame to clients that asked for
+    // batches, the individual frames to the rest
+    void flush_events(bool force);
+    
     bool running_;
     int port_;
     std::string bind_host_;
     std::string auth_token_;
     std::string index_filename_;
+    size_t send_queue_max_;
+    bool metrics_enabled_;
     
     // WebSocket server (implementation in .cpp)
     WebSocketServer* ws_server_;
     
-    // Connected clients
+    // Connected clients (added and removed on Crow threads, broadcast to
+    // from workers)
     std::set<GatewayClient*> clients_;
+    mutable std::mutex clients_mutex_;
+    
+    // Events waiting for flush_events, in arrival order
+    struct PendingEvent {
+        std::string event;
+        Json payload;
+        std::string coalesce_key;
+        bool droppable;
+    };
+    std::vector<PendingEvent> pending_events_;
+    std::map<std::string, size_t> pending_index_;  // Coalesce key -> pending_events_ index
+    int64_t pending_since_ms_;
+    int coalesce_ms_;                               // 0: no coalescing
+    Reactor::TimerId flush_timer_;                  // Armed while events are pending
+    std::mutex pending_mutex_;
     
     // Track most recent active chat for routing outgoing messages
     std::string recent_chat_id_;
@@ -94,16 +148,34 @@ private:
 // Client connection state
 class GatewayClient {
 public:
-    GatewayClient(void* ws_connection, const std::string& conn_id);
+    // Wire encoding, negotiated in hello. Binary encodings carry the same
+    // message schema as JSON text.
+    enum Encoding {
+        JSON_TEXT = 0,
+        MSGPACK,
+        CBOR,
+        ENCODING_COUNT
+    };
+    
+    GatewayClient(void* ws_connection, const std::string& conn_id, size_t max_queued = 256);
     ~GatewayClient();
     
     const std::string& conn_id() const { return conn_id_; }
     bool is_authenticated() const { return authenticated_; }
     void set_authenticated(bool auth) { authenticated_ = auth; }
     
-    // Send message to client
+    // Send message to client (queued; written by the Crow I/O thread)
     bool send(const std::string& message);
-    bool send_json(const Json& data);
+    bool send_json(const Json& data);      // In the client's encoding
+    
+    // Queue a serialized frame without blocking. A frame with a coalesce key
+    // replaces a queued frame with the same key. When the queue is full,
+    // droppable frames are shed first; if that is not enough the client is
+    // disconnected as a slow consumer and false is returned.
+    bool enqueue(const std::shared_ptr<const std::string>& frame,
+                 const std::string& coalesce_key = std::string(),
+                 bool droppable = false,
+                 bool binary = false);
     
     // Protocol info
     int protocol_version() const { return protocol_version_; }
@@ -112,12 +184,25 @@ public:
     const std::string& client_id() const { return client_id_; }
     void set_client_id(const std::string& id) { client_id_ = id; }
     
+    // Client accepts "batch" events (hello params.batchEvents)
+    bool batch_events() const { return batch_events_; }
+    void set_batch_events(bool batch) { batch_events_ = batch; }
+    
+    Encoding encoding() const { return static_cast<Encoding>(encoding_.load()); }
+    void set_encoding(Encoding encoding) { encoding_ = encoding; }
+    
 private:
+    GatewayClient(const GatewayClient&);
+    GatewayClient& operator=(const GatewayClient&);
+    
     void* ws_connection_;  // Opaque WebSocket connection handle
     std::string conn_id_;
     std::string client_id_;
     bool authenticated_;
     int protocol_version_;
+    std::atomic<bool> batch_events_;
+    std::atomic<int> encoding_;
+    std::shared_ptr<GatewaySendQueue> queue_;  // Shared with pending drains
 };
 
 } // namespace openclaw
@@ -8,15 +8,23 @@
  *   llamacpp.url          - Server URL (default: http://localhost:8080)
  *   llamacpp.model        - Model name (optional)
  *   llamacpp.api_key      - API key if server requires authentication (optional)
+ *   llamacpp.context_size - Context window in tokens (default: read from /props)
+ *   llamacpp.endpoint     - "chat" (/v1/chat/completions, default) or "completion"
+ *                           (native /completion with a ChatML-rendered prompt)
+ *
+ * Streaming requests (opts.stream + opts.on_chunk) use SSE on either endpoint
+ * and log generation speed in tokens/sec as tokens arrive.
  */
 #ifndef OPENCLAW_PLUGINS_LLAMACPP_HPP
 #define OPENCLAW_PLUGINS_LLAMACPP_HPP
 
 #include <openclaw/ai/ai.hpp>
 #include <openclaw/core/http_client.hpp>
+#include <openclaw/core/sse.hpp>
 #include <openclaw/core/logger.hpp>
 #include <openclaw/core/config.hpp>
 #include <sstream>
+#include <memory>
 
 namespace openclaw {
 
@@ -38,6 +46,9 @@ public:
     std::vector<std::string> available_models() const;
     std::string default_model() const;
     bool is_configured() const;
+    int context_window(const std::string& model = "") const;
+    TokenEstimator token_estimator() const;
+    bool supports_native_tools() const;
     
     // Single prompt completion
     CompletionResult complete(
@@ -51,6 +62,13 @@ public:
         const CompletionOptions& opts = CompletionOptions()
     );
     
+    // Conversation completion on the async HTTP engine
+    void chat_async(
+        const std::vector<ConversationMessage>& messages,
+        const CompletionOptions& opts,
+        CompletionCallback on_done
+    );
+    
     // Convenience method: simple question-answer
     std::string ask(const std::string& question, const std::string& system = "");
     
@@ -62,9 +80,29 @@ public:
     );
 
 private:
+    // Shared by chat() and chat_async()
+    bool build_request(const std::vector<ConversationMessage>& messages,
+                       const CompletionOptions& opts,
+                       HttpRequest& out,
+                       std::string& error) const;
+    CompletionResult parse_response(const HttpResponse& response) const;
+    CompletionResult parse_native_response(const HttpResponse& response) const;
+    
+    // Streaming (SSE) responses from either endpoint
+    struct StreamState;
+    typedef std::shared_ptr<StreamState> StreamStatePtr;
+    StreamStatePtr attach_stream(HttpRequest& req, const CompletionOptions& opts) const;
+    CompletionResult finish_stream(StreamState& state, const HttpResponse& response) const;
+    
+    // Render a conversation for the native /completion endpoint
+    static std::string render_chatml(const std::vector<ConversationMessage>& messages,
+                                     const std::string& system_prompt);
+    
     std::string server_url_;
     std::string api_key_;
     std::string default_model_;
+    int context_size_;          // 0 = unknown
+    bool native_completion_;    // llamacpp.endpoint == "completion"
     bool initialized_;
 };
 
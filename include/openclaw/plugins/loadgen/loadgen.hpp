@@ -0,0 +1,134 @@
+/*
+ * OpenClaw C++11 - Load Generator Channel Plugin
+ *
+ * A synthetic channel for load tests: N chats send a configurable mix of
+ * messages through the normal message path, and every reply is matched
+ * back to the message it answers. At the end of the run it reports the
+ * throughput and the p50/p99/p999 latency of each stage: end to end as
+ * the channel sees it, plus the per-turn queue, ai, tool, parse and
+ * format totals from the agent traces (see StageLatency). Paired with the
+ * mock AI provider this measures the bot itself, without upstream APIs.
+ *
+ * Config:
+ *   loadgen.chats            - Synthetic chats (default: 10)
+ *   loadgen.chat_type        - "group" (default): one session per chat;
+ *                              "private" chats share the main DM session
+ *                              unless the DM scope separates them
+ *   loadgen.users_per_chat   - Senders taking turns in each chat; more of
+ *                              them keep a fast chat under the per-user
+ *                              rate limit (default: 1)
+ *   loadgen.rate             - Messages/sec over all chats, Poisson arrivals;
+ *                              0 = closed loop: each chat sends its next
+ *                              message once the last is answered (default: 0)
+ *   loadgen.think_ms         - Closed loop: pause after each reply (default: 0)
+ *   loadgen.duration_seconds - Sending time, warm-up included (default: 30)
+ *   loadgen.warmup_seconds   - Leading time left out of the report (default: 0)
+ *   loadgen.timeout_seconds  - A message without a reply by then is counted
+ *                              as timed out (default: 60)
+ *   loadgen.mix              - [{"text": "...", "weight": n}]; "{chat}" and
+ *                              "{n}" in a text become the chat and sequence
+ *                              number (default: chat messages plus some /status)
+ *   loadgen.report_file      - Also write the report here as JSON (optional)
+ *   loadgen.exit_when_done   - Stop the process after the report (default: true)
+ */
+#ifndef OPENCLAW_PLUGINS_LOADGEN_HPP
+#define OPENCLAW_PLUGINS_LOADGEN_HPP
+
+#include <openclaw/core/channel.hpp>
+#include <openclaw/core/config.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <cstdint>
+
+namespace openclaw {
+
+class LoadGenChannel : public ChannelPlugin {
+public:
+    LoadGenChannel();
+
+    // Plugin interface
+    const char* name() const;
+    const char* version() const;
+    const char* description() const;
+
+    // Channel interface
+    const char* channel_id() const;
+    ChannelCapabilities capabilities() const;
+
+    bool init(const Config& cfg);
+    void shutdown();
+    bool start();
+    bool stop();
+    ChannelStatus status() const;
+
+    // Replies: matched to their message by reply_to
+    SendResult send_message(const std::string& to, const std::string& text);
+    SendResult send_message(const std::string& to, const std::string& text,
+                            const std::string& reply_to);
+
+    // No-op: messages come from the generator thread
+    void poll();
+    int poll_interval_ms() const { return 0; }
+
+private:
+    struct MixEntry {
+        std::string text;
+        int weight;
+    };
+
+    // A message waiting for its reply
+    struct Pending {
+        int chat;
+        int64_t sent_us;
+    };
+
+    // Settings
+    int chats_;
+    std::string chat_type_;
+    int users_per_chat_;
+    double rate_;
+    int64_t think_us_;
+    int64_t duration_us_;
+    int64_t warmup_us_;
+    int64_t timeout_us_;
+    std::vector<MixEntry> mix_;
+    int total_weight_;
+    std::string report_file_;
+    bool exit_when_done_;
+
+    // Run state (mutex_)
+    ChannelStatus status_;
+    bool stopping_;
+    bool reported_;
+    int64_t started_us_;
+    int64_t measure_from_us_;       // End of the warm-up
+    int64_t last_reply_us_;
+    uint64_t seq_;
+    std::map<std::string, Pending> pending_;   // By message id
+    std::vector<int64_t> next_send_us_;        // Closed loop, per chat (-1 = waiting)
+    uint64_t sent_;
+    uint64_t replied_;
+    uint64_t timed_out_;
+    uint64_t unmatched_;                       // Sends that answer no pending message
+    std::mt19937_64 rng_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    void run();
+    // Build and emit one message for chat; caller holds lock, which is
+    // released around the emit
+    void send_one(int chat, int64_t now_us, std::unique_lock<std::mutex>& lock);
+    void expire_locked(int64_t now_us);
+    std::string pick_text_locked(int chat);
+    void report();
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_PLUGINS_LOADGEN_HPP
@@ -0,0 +1,134 @@
+/*
+ * OpenClaw C++11 - Mock AI Plugin
+ *
+ * A stand-in provider for load tests. Replies after a latency drawn from
+ * a configurable distribution, optionally fails a share of the calls, and
+ * can play a script of tool calls before its final answer, so the whole
+ * agent loop runs without an upstream API. chat_async() completes from a
+ * timer thread, the way a real provider completes on the HTTP engine, so
+ * no pool worker waits out the latency.
+ *
+ * Config:
+ *   mock.latency.distribution - "fixed", "uniform", "exponential" or
+ *                               "lognormal" (default: lognormal)
+ *   mock.latency.mean_ms      - Mean latency of a call (default: 500)
+ *   mock.latency.jitter_ms    - uniform: spread either side of the mean
+ *                               (default: mean / 2)
+ *   mock.latency.sigma        - lognormal: shape (default: 0.5)
+ *   mock.error_rate           - Share of calls that fail (default: 0)
+ *   mock.tool_probability     - Share of turns that play the tool script
+ *                               (default: 1 when a script is set)
+ *   mock.tool_script          - [{"name": "tool", "params": {...}}], one
+ *                               call per iteration, then the final answer
+ *   mock.reply_chars          - Pad final answers to this length (default: 0)
+ *   mock.stream_chunks        - Streamed replies arrive in this many
+ *                               deltas spread over the latency (default: 4)
+ */
+#ifndef OPENCLAW_PLUGINS_MOCK_HPP
+#define OPENCLAW_PLUGINS_MOCK_HPP
+
+#include <openclaw/ai/ai.hpp>
+#include <openclaw/core/config.hpp>
+#include <string>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <random>
+#include <cstdint>
+
+namespace openclaw {
+
+class MockAI : public AIPlugin {
+public:
+    MockAI();
+    ~MockAI();
+
+    // Plugin interface
+    const char* name() const;
+    const char* version() const;
+    const char* description() const;
+
+    bool init(const Config& cfg);
+    void shutdown();
+
+    // AIPlugin interface
+    std::string provider_id() const;
+    std::vector<std::string> available_models() const;
+    std::string default_model() const;
+    bool is_configured() const;
+    int context_window(const std::string& model = "") const;
+
+    CompletionResult complete(
+        const std::string& prompt,
+        const CompletionOptions& opts = CompletionOptions()
+    );
+
+    // Sleeps out the latency on the calling thread
+    CompletionResult chat(
+        const std::vector<ConversationMessage>& messages,
+        const CompletionOptions& opts = CompletionOptions()
+    );
+
+    // Completes from the timer thread after the latency
+    void chat_async(
+        const std::vector<ConversationMessage>& messages,
+        const CompletionOptions& opts,
+        CompletionCallback on_done
+    );
+
+private:
+    enum Distribution { FIXED, UNIFORM, EXPONENTIAL, LOGNORMAL };
+
+    struct ScriptedCall {
+        std::string name;
+        std::string params;     // JSON object text
+    };
+
+    // A deferred step, run by the timer thread once due
+    struct Timer {
+        int64_t due_us;
+        uint64_t seq;           // Keeps equal due times in order
+        std::function<void()> fn;
+
+        bool operator>(const Timer& other) const {
+            return due_us != other.due_us ? due_us > other.due_us : seq > other.seq;
+        }
+    };
+
+    // Settings
+    Distribution distribution_;
+    double mean_ms_;
+    double jitter_ms_;
+    double sigma_;
+    double error_rate_;
+    double tool_probability_;
+    std::vector<ScriptedCall> script_;
+    size_t reply_chars_;
+    int stream_chunks_;
+
+    std::mt19937_64 rng_;
+    std::mutex rng_mutex_;
+
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > timers_;
+    uint64_t timer_seq_;
+    bool stopping_;
+    std::thread timer_thread_;
+    std::mutex timer_mutex_;
+    std::condition_variable timer_cv_;
+
+    int64_t draw_latency_us();
+    bool roll(double probability);
+    // The reply for this conversation: the next scripted tool call or the
+    // final answer
+    CompletionResult respond(const std::vector<ConversationMessage>& messages);
+    void schedule(int64_t due_us, std::function<void()> fn);
+    void timer_loop();
+    void stop_timer();
+};
+
+} // namespace openclaw
+
+#endif // OPENCLAW_PLUGINS_MOCK_HPP
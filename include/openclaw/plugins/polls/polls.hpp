@@ -5,6 +5,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
 #include <cstdint>
 #include <stdexcept>
 
@@ -103,17 +106,37 @@ int normalize_poll_duration(int duration_hours, int default_hours, int max_hours
 // Returns empty string if valid, error message otherwise
 std::string validate_vote(const Poll& poll, const std::vector<int>& selected_options);
 
-// Poll manager - manages all polls in memory
+// Poll manager
+//
+// Polls are spread over shards by id, each behind its own mutex, so votes
+// on different polls from different channel threads do not contend. Each
+// poll keeps its tallies and a voter index up to date as votes arrive:
+// voting, has_voted and the counts in get_results are O(1) in the number
+// of votes already cast.
+//
+// With a log file open, every change is appended to it as one JSON line
+// and replayed on the next open; a log that is mostly records of deleted
+// polls is rewritten to the live ones.
+//
+// Record format:
+//   {"op":"create","id":"...","question":"...","options":[...],"max":1,"hours":24,"created":...,"expires":...}
+//   {"op":"vote","id":"...","voter":"...","sel":[0,2],"at":...}
+//   {"op":"close","id":"..."}
+//   {"op":"delete","id":"..."}
 class PollManager {
 public:
     static PollManager& instance();
     
-    // Create a new poll
-    Poll& create_poll(const PollInput& input, const PollNormalizeOptions& options = PollNormalizeOptions());
+    // Replay the log at path and append to it from now on (fsync: sync
+    // each record). False if it cannot be opened; polls stay in memory.
+    bool open_log(const std::string& path, bool fsync = false);
+    void close_log();
     
-    // Get poll by ID
-    Poll* get_poll(const std::string& poll_id);
-    const Poll* get_poll(const std::string& poll_id) const;
+    // Create a new poll; throws PollError on invalid input
+    Poll create_poll(const PollInput& input, const PollNormalizeOptions& options = PollNormalizeOptions());
+    
+    // Copy of a poll; false if there is none
+    bool get_poll(const std::string& poll_id, Poll& out) const;
     
     // Check if poll exists
     bool has_poll(const std::string& poll_id) const;
@@ -130,8 +153,9 @@ public:
                      const std::string& voter_id,
                      const std::vector<int>& selected_options);
     
-    // Get results for a poll
-    PollResults get_results(const std::string& poll_id) const;
+    // Get results for a poll. The per-voter map costs a copy of every
+    // vote; leave it out when only the counts are wanted.
+    PollResults get_results(const std::string& poll_id, bool include_voters = true) const;
     
     // Check if voter has already voted
     bool has_voted(const std::string& poll_id, const std::string& voter_id) const;
@@ -146,15 +170,45 @@ public:
     std::vector<std::string> active_poll_ids() const;
     
     // Poll count
-    size_t poll_count() const { return polls_.size(); }
+    size_t poll_count() const { return poll_count_.load(); }
 
 private:
-    PollManager() {}
+    PollManager();
+    ~PollManager();
     PollManager(const PollManager&);
     PollManager& operator=(const PollManager&);
     
-    std::map<std::string, Poll> polls_;
-    std::map<std::string, std::vector<PollVote> > votes_;  // poll_id -> votes
+    struct PollState {
+        Poll poll;
+        std::vector<int> counts;                                    // Per option
+        std::unordered_map<std::string, std::vector<int> > voters;  // voter_id -> selection
+    };
+    
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, PollState> polls;
+    };
+    
+    static const size_t SHARD_COUNT = 16;
+    
+    Shard& shard_for(const std::string& poll_id) const;
+    
+    // Apply one log record while replaying
+    void replay(const std::string& line);
+    // Append a record (callers hold the poll's shard lock, which keeps the
+    // records of one poll in order)
+    void append(const std::string& record);
+    // Write the live polls to path (via a temporary file and rename);
+    // records: how many lines that took
+    bool rewrite_log(const std::string& path, size_t& records);
+    
+    mutable Shard shards_[SHARD_COUNT];
+    std::atomic<size_t> poll_count_;
+    
+    std::mutex log_mutex_;      // Taken after a shard lock, never before
+    int log_fd_;
+    std::string log_path_;
+    bool log_fsync_;
 };
 
 // Format poll for display (simple text format)
@@ -174,6 +228,7 @@ public:
     
     bool init(const Config& cfg) override;
     void shutdown() override;
+    int poll_interval_ms() const override { return 0; }
 };
 
 } // namespace openclaw
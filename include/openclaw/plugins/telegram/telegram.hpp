@@ -4,12 +4,17 @@
 #include <openclaw/core/channel.hpp>
 #include <openclaw/core/http_client.hpp>
 #include <openclaw/core/logger.hpp>
+#include <openclaw/core/webhook.hpp>
+#include <openclaw/core/send_queue.hpp>
+#include <openclaw/core/reactor.hpp>
 #include <string>
 #include <sstream>
 #include <ctime>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
 
 namespace openclaw {
 
@@ -38,30 +43,65 @@ public:
     SendResult send_message(const std::string& to, const std::string& text,
                             const std::string& reply_to);
     
+    // Queued behind Telegram's rate limits; returns at once
+    void send_message_async(const std::string& to, const std::string& text,
+                            const std::string& reply_to, SendCallback on_done);
+    
+    // editMessageText, paced like sends
+    void edit_message_async(const std::string& to, const std::string& message_id,
+                            const std::string& text, SendCallback on_done);
+    
     // Send typing action
     SendResult send_typing_action(const std::string& to);
     
-    // Poll for updates (call this regularly)
+    // No-op: updates arrive on the HTTP engine or the dispatch thread
     void poll();
+    int poll_interval_ms() const { return 0; }
 
 private:
     std::string bot_token_;
     std::string api_base_;
     int64_t bot_id_;
     std::string bot_username_;
-    HttpClient http_;        // For polling
-    HttpClient http_send_;   // For sending messages (separate to avoid blocking)
+    HttpClient http_;        // For setup calls (getMe, setWebhook)
+    HttpClient http_send_;   // For typing actions (separate to avoid blocking)
+    SendQueue send_queue_;   // Paces sendMessage per chat and per bot
     ChannelStatus status_;
     int64_t last_update_id_;
     int poll_timeout_;
     
-    // Polling thread
-    std::thread poll_thread_;
+    // Polling: one getUpdates long poll at a time on the shared HTTP
+    // engine, each completion starting the next; a failed poll is retried
+    // from a reactor timer
     std::atomic<bool> should_stop_polling_;
+    bool polling_;                      // Chain still running (poll_mutex_)
+    Reactor::TimerId poll_retry_timer_;
+    std::mutex poll_mutex_;
+    std::condition_variable poll_cv_;
+    
+    // Webhook mode: bodies are queued by the HTTP handler and parsed on
+    // the dispatch thread, so Telegram gets its 200 right away
+    bool use_webhook_;
+    std::string webhook_url_;
+    std::string webhook_secret_;
+    std::string webhook_bind_;
+    int webhook_port_;
+    WebhookServer webhook_server_;   // Only when the gateway is not loaded
+    std::thread dispatch_thread_;
+    std::deque<std::string> pending_updates_;
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
     
-    void polling_loop();
-    SendResult send_message_impl(const std::string& to, const std::string& text, int64_t reply_to);
-    void process_update(const Json& update);
+    void request_updates();
+    void on_updates(const HttpResponse& resp);
+    void end_polling();
+    bool start_webhook();
+    void stop_webhook();
+    WebhookResponse on_webhook(const WebhookRequest& request);
+    void dispatch_loop();
+    void send_queued(const OutboundMessage& msg, SendQueue::SendDone done);
+    // Record update_id as seen and pass its message on (if it has text)
+    void process_update(int64_t update_id, const Message& m);
 };
 
 } // namespace openclaw
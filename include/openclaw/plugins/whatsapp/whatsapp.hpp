@@ -4,10 +4,14 @@
 #include <openclaw/core/channel.hpp>
 #include <openclaw/core/http_client.hpp>
 #include <openclaw/core/logger.hpp>
+#include <openclaw/core/webhook.hpp>
 #include <string>
 #include <sstream>
 #include <ctime>
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 namespace openclaw {
 
@@ -24,6 +28,9 @@ namespace openclaw {
  *    - Runs a local server that handles WhatsApp Web connection
  *    - Set WHATSAPP_BRIDGE_URL to the bridge endpoint
  *    - Bridge handles QR code authentication
+ *    - With whatsapp.push = "webhook" the bridge POSTs new messages to
+ *      /hooks/whatsapp (gateway server, or our own listener without it)
+ *      and GET /messages is only polled as a fallback
  * 
  * The plugin auto-detects which mode based on available config.
  */
@@ -60,8 +67,9 @@ public:
     // Send typing action
     SendResult send_typing_action(const std::string& to);
     
-    // Poll for updates
+    // Poll the bridge for messages, at its poll interval (bridge mode only)
     void poll();
+    int poll_interval_ms() const;
     
     // Get mode for external inspection
     Mode mode() const;
@@ -75,7 +83,21 @@ private:
     ChannelStatus status_;
     Mode mode_;
     int poll_interval_;
-    int64_t last_poll_time_;
+    
+    // GET /messages runs on the shared HTTP engine; one at a time
+    bool poll_in_flight_;
+    std::mutex poll_mutex_;
+    std::condition_variable poll_cv_;
+    
+    // Push mode
+    bool push_;
+    std::string webhook_url_;       // Registered with the bridge when set
+    std::string webhook_secret_;
+    std::string webhook_bind_;
+    int webhook_port_;
+    int poll_fallback_interval_;    // Seconds between polls while pushing
+    std::atomic<int64_t> last_push_time_;   // ms
+    WebhookServer webhook_server_;
     
     std::string normalize_phone(const std::string& phone);
     
@@ -89,7 +111,14 @@ private:
     SendResult send_bridge(const std::string& to, const std::string& text,
                            const std::string& reply_to = "");
     void poll_bridge();
-    void process_bridge_message(const Json& msg);
+    void on_bridge_messages(const HttpResponse& resp);
+    // Messages of a bridge body: {"messages": [...]}, or (single) one
+    // message object. False if it is not JSON.
+    bool read_bridge_messages(const std::string& body, bool single, std::vector<Message>& out);
+    void process_bridge_message(const Message& m);
+    bool start_push();
+    void stop_push();
+    WebhookResponse on_webhook(const WebhookRequest& request);
 };
 
 } // namespace openclaw
@@ -3,6 +3,9 @@
  * 
  * Loads skills from SKILL.md files in directories.
  * Parses frontmatter and builds SkillEntry objects.
+ * Only the frontmatter is read when loading (a bounded prefix read); the
+ * body, which the model reads itself through the skill's location, is
+ * read on demand with read_body().
  */
 #ifndef OPENCLAW_SKILLS_LOADER_HPP
 #define OPENCLAW_SKILLS_LOADER_HPP
@@ -39,9 +42,15 @@ public:
     // Get the content after frontmatter (the actual skill instructions)
     std::string get_content_body(const std::string& content);
     
+    // Read a loaded skill's instructions from its SKILL.md
+    std::string read_body(const Skill& skill);
+    
     // Format skill for prompt inclusion
     std::string format_skill_for_prompt(const Skill& skill);
     
+    // Names of the non-hidden subdirectories of dir
+    std::vector<std::string> list_subdirs(const std::string& dir);
+    
     // Last error message
     const std::string& last_error() const { return last_error_; }
     
@@ -57,8 +66,10 @@ private:
     // Parse requirements from JSON-like structure
     bool parse_requirements(const std::string& json_str, SkillRequirements& reqs);
     
-    // Helper: read file contents
-    std::string read_file(const std::string& path);
+    // Helper: read a file up to the end of its frontmatter (at most
+    // MAX_HEADER_BYTES); false if it cannot be read or is empty
+    static const size_t MAX_HEADER_BYTES = 65536;
+    bool read_header(const std::string& path, std::string& header, size_t& body_offset);
     
     // Helper: check if directory exists
     bool dir_exists(const std::string& path);
@@ -66,9 +77,6 @@ private:
     // Helper: check if file exists
     bool file_exists(const std::string& path);
     
-    // Helper: list subdirectories
-    std::vector<std::string> list_subdirs(const std::string& dir);
-    
     // Helper: trim whitespace
     std::string trim(const std::string& str);
     
@@ -3,6 +3,10 @@
  * 
  * Manages skills loading, filtering, and prompt generation.
  * Builds skill snapshots and prompts for AI consumption.
+ * Parsed skills are cached by directory and SKILL.md stat (mtime, size,
+ * inode), so reloading re-reads only skills that changed.
+ * Skill commands are resolved through a SkillCommandTable, a hash index
+ * built once per catalog load.
  */
 #ifndef OPENCLAW_SKILLS_MANAGER_HPP
 #define OPENCLAW_SKILLS_MANAGER_HPP
@@ -12,9 +16,32 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
 
 namespace openclaw {
 
+// Skill commands indexed by lowercased command name, and by lowercased skill
+// name where that differs and is not itself a command name. Built once from
+// the specs; a lookup hashes the name once.
+class SkillCommandTable {
+public:
+    SkillCommandTable() {}
+    explicit SkillCommandTable(const std::vector<SkillCommandSpec>& specs);
+    
+    // NULL if no command has this (lowercased) name
+    const SkillCommandSpec* find(const std::string& lower_name) const;
+    
+    const std::vector<SkillCommandSpec>& specs() const { return specs_; }
+    bool empty() const { return specs_.empty(); }
+    
+private:
+    std::vector<SkillCommandSpec> specs_;
+    std::unordered_map<std::string, size_t> index_;     // Name -> specs_ index
+};
+
 class SkillManager {
 public:
     SkillManager();
@@ -27,6 +54,7 @@ public:
     
     // Load all skills from configured directories
     // Precedence: extra < bundled < managed < workspace
+    // Unchanged directories and SKILL.md files come from the catalog cache
     std::vector<SkillEntry> load_workspace_skill_entries();
     
     // Filter entries based on config and eligibility
@@ -74,6 +102,11 @@ public:
         const std::string& user_input,
         const std::vector<SkillCommandSpec>& commands);
     
+    // Same, against a prebuilt table (no scan of the commands)
+    std::pair<const SkillCommandSpec*, std::string> resolve_skill_command_invocation(
+        const std::string& user_input,
+        const SkillCommandTable& commands);
+    
     // Get a skill entry by name
     const SkillEntry* find_skill_by_name(
         const std::string& name,
@@ -84,9 +117,15 @@ public:
         const std::vector<SkillEntry>& entries,
         bool show_eligibility = true);
     
-    // Check if binary exists
+    // Check if binary exists in $PATH (from an index of the PATH
+    // directories' names; answers are memoized until PATH or a directory
+    // changes)
     static bool has_binary(const std::string& bin);
     
+    // Re-list PATH directories whose mtime changed (one stat per directory);
+    // filter_skill_entries calls this once per pass
+    static void refresh_binary_index();
+    
     // Check if environment variable is set
     static bool has_env(const std::string& var);
     
@@ -101,10 +140,40 @@ private:
     SkillLoader loader_;
     std::string last_error_;
     
-    // Load skills from a specific directory
-    std::vector<SkillEntry> load_entries_from_dir(
+    // Catalog: a directory's skill subdirectories as of its mtime, and each
+    // skill parsed as of its SKILL.md stat
+    struct FileStamp {
+        int64_t mtime;          // Nanoseconds
+        int64_t size;
+        uint64_t inode;
+        bool exists;
+        
+        FileStamp() : mtime(0), size(0), inode(0), exists(false) {}
+        bool operator==(const FileStamp& o) const {
+            return mtime == o.mtime && size == o.size && inode == o.inode && exists == o.exists;
+        }
+    };
+    struct CachedDir {
+        FileStamp stamp;
+        std::vector<std::string> subdirs;
+    };
+    struct CachedSkill {
+        FileStamp stamp;
+        std::string source;
+        SkillEntry entry;       // empty() when SKILL.md is missing or invalid
+    };
+    std::map<std::string, CachedDir> dir_cache_;
+    std::map<std::string, CachedSkill> skill_cache_;
+    std::mutex cache_mutex_;
+    
+    static FileStamp stamp_of(const std::string& path);
+    
+    // Skills of one directory from the catalog, refreshing what changed
+    // (cache_mutex_ held; pointers are into skill_cache_)
+    void load_entries_from_dir(
         const std::string& dir,
-        const std::string& source);
+        const std::string& source,
+        std::map<std::string, const SkillEntry*>& merged);
     
     // Format skills for prompt
     std::string format_skills_for_prompt(const std::vector<Skill>& skills);
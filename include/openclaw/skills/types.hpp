@@ -93,7 +93,10 @@ struct Skill {
     std::string file_path;   // Path to SKILL.md
     std::string base_dir;    // Directory containing the skill
     std::string source;      // Source: "workspace", "managed", "bundled", "extra"
-    std::string content;     // Full content of SKILL.md
+    std::string header;      // SKILL.md through its closing frontmatter line
+    size_t body_offset;      // Where the instructions start (SkillLoader::read_body)
+    
+    Skill() : body_offset(0) {}
     
     bool empty() const { return name.empty(); }
 };
@@ -1,4 +1,6 @@
 #include <openclaw/ai/ai.hpp>
+#include <cctype>
+#include <set>
 
 namespace openclaw {
 
@@ -17,4 +19,119 @@ MessageRole string_to_role(const std::string& str) {
     return MessageRole::USER;
 }
 
+// ============ Native tool blocks ============
+
+namespace {
+
+// Neighbouring message in the conversation, skipping system messages
+const ConversationMessage* neighbour(const std::vector<ConversationMessage>& messages,
+                                     size_t index, bool forward) {
+    size_t i = index;
+    while (forward ? i + 1 < messages.size() : i > 0) {
+        i = forward ? i + 1 : i - 1;
+        if (messages[i].role != MessageRole::SYSTEM) return &messages[i];
+    }
+    return nullptr;
+}
+
+bool same_ids(const std::vector<ToolUse>& uses, const std::vector<ToolResultBlock>& results) {
+    std::set<std::string> use_ids;
+    std::set<std::string> result_ids;
+    for (size_t i = 0; i < uses.size(); ++i) use_ids.insert(uses[i].id);
+    for (size_t i = 0; i < results.size(); ++i) result_ids.insert(results[i].tool_use_id);
+    return !use_ids.empty() && use_ids == result_ids;
+}
+
+} // anonymous namespace
+
+bool tool_blocks_paired(const std::vector<ConversationMessage>& messages, size_t index) {
+    const ConversationMessage& msg = messages[index];
+    
+    if (msg.role == MessageRole::ASSISTANT && !msg.tool_uses.empty()) {
+        const ConversationMessage* next = neighbour(messages, index, true);
+        return next && next->role == MessageRole::USER && same_ids(msg.tool_uses, next->tool_results);
+    }
+    if (msg.role == MessageRole::USER && !msg.tool_results.empty()) {
+        const ConversationMessage* prev = neighbour(messages, index, false);
+        return prev && prev->role == MessageRole::ASSISTANT && same_ids(prev->tool_uses, msg.tool_results);
+    }
+    return false;
+}
+
+std::string tool_uses_as_text(const ConversationMessage& msg) {
+    std::string text = msg.content;
+    for (size_t i = 0; i < msg.tool_uses.size(); ++i) {
+        if (!text.empty()) text += "\n";
+        text += "[Called tool " + msg.tool_uses[i].name + " with " + msg.tool_uses[i].input.dump() + "]";
+    }
+    return text;
+}
+
+// ============ TokenEstimator ============
+
+int TokenEstimator::count_text(const std::string& text) {
+    size_t tokens = 0;
+    size_t i = 0;
+    size_t n = text.size();
+    
+    while (i < n) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        
+        if (c >= 0x80) {
+            // Non-ASCII: about one token per code point
+            size_t len = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : (c >= 0xC0) ? 2 : 1;
+            i += len;
+            tokens++;
+        } else if (isalpha(c)) {
+            // Words: common ones are one token, long ones split every ~5 chars
+            size_t start = i;
+            while (i < n && isalpha(static_cast<unsigned char>(text[i]))) i++;
+            tokens += (i - start + 4) / 5;
+        } else if (isdigit(c)) {
+            // Numbers are split into groups of up to three digits
+            size_t start = i;
+            while (i < n && isdigit(static_cast<unsigned char>(text[i]))) i++;
+            tokens += (i - start + 2) / 3;
+        } else if (c == ' ') {
+            // A single space merges into the next word; indentation does not
+            size_t start = i;
+            while (i < n && text[i] == ' ') i++;
+            size_t len = i - start;
+            if (len > 1) tokens += (len + 2) / 4;
+        } else if (c == '\n' || c == '\r' || c == '\t') {
+            while (i < n && (text[i] == '\n' || text[i] == '\r' || text[i] == '\t')) i++;
+            tokens++;
+        } else {
+            // Punctuation and symbols
+            i++;
+            tokens++;
+        }
+    }
+    return static_cast<int>(tokens);
+}
+
+int TokenEstimator::count(const std::string& text) const {
+    return static_cast<int>(count_text(text) * scale_ + 0.5);
+}
+
+int TokenEstimator::count(const ConversationMessage& msg) const {
+    if (msg.token_estimate < 0 || msg.token_estimate_size != msg.content.size()) {
+        msg.token_estimate = count_text(msg.content);
+        for (size_t i = 0; i < msg.tool_uses.size(); ++i) {
+            msg.token_estimate += count_text(msg.tool_uses[i].name) +
+                                  count_text(msg.tool_uses[i].input.dump());
+        }
+        msg.token_estimate_size = msg.content.size();
+    }
+    return static_cast<int>(msg.token_estimate * scale_ + 0.5) + per_message_overhead_;
+}
+
+int TokenEstimator::count(const std::vector<ConversationMessage>& messages) const {
+    int total = 0;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        total += count(messages[i]);
+    }
+    return total;
+}
+
 } // namespace openclaw
@@ -0,0 +1,434 @@
+/*
+ * OpenClaw C++11 - Completion Cache Implementation
+ */
+#include <openclaw/ai/completion_cache.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/core/thread_pool.hpp>
+#include <sqlite3.h>
+#include <cstdio>
+
+namespace openclaw {
+
+namespace {
+
+// Length-prefixed so no two field sequences serialize alike
+void put(std::string& out, const std::string& field) {
+    out += std::to_string(field.size());
+    out += ':';
+    out += field;
+}
+
+void put(std::string& out, int64_t value) {
+    put(out, std::to_string(value));
+}
+
+Json result_to_json(const CompletionResult& result) {
+    Json j;
+    j["content"] = result.content;
+    j["stop_reason"] = result.stop_reason;
+    j["model"] = result.model;
+    Json uses = Json::array();
+    for (size_t i = 0; i < result.tool_uses.size(); ++i) {
+        Json u;
+        u["id"] = result.tool_uses[i].id;
+        u["name"] = result.tool_uses[i].name;
+        u["input"] = result.tool_uses[i].input;
+        uses.push_back(u);
+    }
+    j["tool_uses"] = uses;
+    return j;
+}
+
+bool result_from_json(const std::string& text, CompletionResult& out) {
+    Json j = Json::parse(text, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) return false;
+    out = CompletionResult::ok(j.value("content", std::string()));
+    out.stop_reason = j.value("stop_reason", std::string());
+    out.model = j.value("model", std::string());
+    if (j.contains("tool_uses") && j["tool_uses"].is_array()) {
+        for (const auto& u : j["tool_uses"]) {
+            ToolUse use;
+            use.id = u.value("id", std::string());
+            use.name = u.value("name", std::string());
+            if (u.contains("input")) use.input = u["input"];
+            out.tool_uses.push_back(use);
+        }
+    }
+    return true;
+}
+
+}
+
+CompletionCache& CompletionCache::instance() {
+    static CompletionCache cache;
+    return cache;
+}
+
+CompletionCache::CompletionCache()
+    : pool_(nullptr)
+    , bytes_(0)
+    , db_(nullptr)
+    , disk_stores_(0) {}
+
+CompletionCache::~CompletionCache() {
+    close();
+}
+
+bool CompletionCache::configure(const Config& config, ThreadPool* pool) {
+    close();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_ = config;
+        pool_ = pool;
+        // Shrink to the new budget
+        while (bytes_ > config_.memory_bytes && !lru_.empty()) {
+            bytes_ -= lru_.back().bytes;
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+            counters_.evictions++;
+        }
+    }
+
+    if (config.db_path.empty()) return true;
+
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (sqlite3_open(config.db_path.c_str(), &db_) != SQLITE_OK) {
+        LOG_ERROR("[CompletionCache] Cannot open %s: %s", config.db_path.c_str(),
+                  db_ ? sqlite3_errmsg(db_) : "out of memory");
+        sqlite3_close(db_);
+        db_ = nullptr;
+        return false;
+    }
+    sqlite3_exec(db_, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    sqlite3_exec(db_, "PRAGMA synchronous=NORMAL", nullptr, nullptr, nullptr);
+    char* err = nullptr;
+    if (sqlite3_exec(db_,
+            "CREATE TABLE IF NOT EXISTS completion_cache ("
+            "  key TEXT PRIMARY KEY,"
+            "  value TEXT NOT NULL,"
+            "  created INTEGER NOT NULL,"
+            "  used INTEGER NOT NULL"
+            ");"
+            "CREATE INDEX IF NOT EXISTS idx_completion_cache_used ON completion_cache(used);",
+            nullptr, nullptr, &err) != SQLITE_OK) {
+        LOG_ERROR("[CompletionCache] Cannot create schema: %s", err ? err : "unknown");
+        sqlite3_free(err);
+        sqlite3_close(db_);
+        db_ = nullptr;
+        return false;
+    }
+
+    LOG_INFO("[CompletionCache] Disk tier at %s", config.db_path.c_str());
+    return true;
+}
+
+void CompletionCache::close() {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (db_) {
+        sqlite3_close(db_);
+        db_ = nullptr;
+    }
+}
+
+// ============================================================================
+// Keys
+// ============================================================================
+
+std::string CompletionCache::key(const AIPlugin& ai, const std::vector<ConversationMessage>& messages,
+                                 const CompletionOptions& opts) {
+    std::string data;
+    put(data, ai.provider_id());
+    put(data, opts.model.empty() ? ai.default_model() : opts.model);
+    put(data, opts.tools_prompt);
+    put(data, opts.system_prompt);
+    put(data, opts.max_tokens);
+    char temperature[32];
+    snprintf(temperature, sizeof(temperature), "%.6g", opts.temperature);
+    put(data, temperature);
+
+    put(data, static_cast<int64_t>(opts.tools.size()));
+    for (size_t i = 0; i < opts.tools.size(); ++i) {
+        put(data, opts.tools[i].name);
+        put(data, opts.tools[i].description);
+        put(data, opts.tools[i].input_schema.dump());
+    }
+
+    put(data, static_cast<int64_t>(messages.size()));
+    for (size_t i = 0; i < messages.size(); ++i) {
+        const ConversationMessage& m = messages[i];
+        put(data, role_to_string(m.role));
+        put(data, m.content.str());
+        put(data, static_cast<int64_t>(m.tool_uses.size()));
+        for (size_t k = 0; k < m.tool_uses.size(); ++k) {
+            put(data, m.tool_uses[k].id);
+            put(data, m.tool_uses[k].name);
+            put(data, m.tool_uses[k].input.dump());
+        }
+        put(data, static_cast<int64_t>(m.tool_results.size()));
+        for (size_t k = 0; k < m.tool_results.size(); ++k) {
+            put(data, m.tool_results[k].tool_use_id);
+            put(data, m.tool_results[k].content.str());
+            put(data, m.tool_results[k].is_error ? 1 : 0);
+        }
+    }
+    return sha256_hex(data);
+}
+
+// ============================================================================
+// Memory tier
+// ============================================================================
+
+size_t CompletionCache::entry_bytes(const std::string& key, const CompletionResult& result) {
+    size_t bytes = sizeof(Entry) + key.size() * 2 + result.content.size() +
+                   result.stop_reason.size() + result.model.size();
+    for (size_t i = 0; i < result.tool_uses.size(); ++i) {
+        bytes += result.tool_uses[i].id.size() + result.tool_uses[i].name.size() +
+                 result.tool_uses[i].input.dump().size();
+    }
+    return bytes;
+}
+
+void CompletionCache::insert_locked(const std::string& key, const CompletionResult& result,
+                                    int64_t created) {
+    size_t bytes = entry_bytes(key, result);
+    if (bytes > config_.memory_bytes) return;
+
+    std::unordered_map<std::string, Lru::iterator>::iterator it = index_.find(key);
+    if (it != index_.end()) {
+        bytes_ -= it->second->bytes;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.result = result;
+    entry.bytes = bytes;
+    entry.created = created;
+    lru_.push_front(entry);
+    index_[key] = lru_.begin();
+    bytes_ += bytes;
+
+    while (bytes_ > config_.memory_bytes && !lru_.empty()) {
+        bytes_ -= lru_.back().bytes;
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+        counters_.evictions++;
+    }
+}
+
+bool CompletionCache::lookup(const std::string& key, CompletionResult& out) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::unordered_map<std::string, Lru::iterator>::iterator it = index_.find(key);
+        if (it != index_.end()) {
+            Lru::iterator entry = it->second;
+            if (config_.ttl_seconds > 0 && current_timestamp() - entry->created > config_.ttl_seconds) {
+                // Expired like its disk row, which the disk lookup drops
+                bytes_ -= entry->bytes;
+                lru_.erase(entry);
+                index_.erase(it);
+            } else {
+                lru_.splice(lru_.begin(), lru_, entry);
+                out = entry->result;
+                counters_.memory_hits++;
+                return true;
+            }
+        }
+    }
+
+    int64_t created = 0;
+    if (disk_lookup(key, out, created)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counters_.disk_hits++;
+        insert_locked(key, out, created);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    counters_.misses++;
+    return false;
+}
+
+void CompletionCache::store(const std::string& key, const CompletionResult& result) {
+    if (!result.success) return;
+
+    // Provider response details do not belong to a replayed answer
+    CompletionResult kept = CompletionResult::ok(result.content);
+    kept.stop_reason = result.stop_reason;
+    kept.model = result.model;
+    kept.tool_uses = result.tool_uses;
+    ThreadPool* pool;
+    bool disk;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counters_.stores++;
+        insert_locked(key, kept, current_timestamp());
+        pool = pool_;
+        disk = !config_.db_path.empty();
+    }
+    if (!disk) return;
+
+    // Callers include the async HTTP engine thread; keep SQLite off it
+    if (pool) {
+        pool->enqueue([this, key, kept] { disk_store(key, kept); }, TaskPriority::LOW);
+    } else {
+        disk_store(key, kept);
+    }
+}
+
+void CompletionCache::clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (db_) sqlite3_exec(db_, "DELETE FROM completion_cache", nullptr, nullptr, nullptr);
+}
+
+CompletionCache::Stats CompletionCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = counters_;
+    s.entries = lru_.size();
+    s.bytes = bytes_;
+    return s;
+}
+
+// ============================================================================
+// Disk tier
+// ============================================================================
+
+bool CompletionCache::disk_lookup(const std::string& key, CompletionResult& out, int64_t& created) {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!db_) return false;
+
+    int64_t now = current_timestamp();
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "SELECT value, created FROM completion_cache WHERE key = ?",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+
+    bool found = false;
+    bool expired = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* value = sqlite3_column_text(stmt, 0);
+        created = sqlite3_column_int64(stmt, 1);
+        expired = config_.ttl_seconds > 0 && now - created > config_.ttl_seconds;
+        if (!expired && value) {
+            found = result_from_json(reinterpret_cast<const char*>(value), out);
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    const char* sql = expired ? "DELETE FROM completion_cache WHERE key = ?"
+                              : "UPDATE completion_cache SET used = ? WHERE key = ?";
+    if ((found || expired) && sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        int index = 1;
+        if (!expired) sqlite3_bind_int64(stmt, index++, now);
+        sqlite3_bind_text(stmt, index, key.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    return found;
+}
+
+void CompletionCache::disk_store(const std::string& key, const CompletionResult& result) {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!db_) return;
+
+    int64_t now = current_timestamp();
+    std::string value = result_to_json(result).dump();
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_,
+            "INSERT OR REPLACE INTO completion_cache (key, value, created, used) VALUES (?, ?, ?, ?)",
+            -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_WARN("[CompletionCache] Cannot store: %s", sqlite3_errmsg(db_));
+        return;
+    }
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, value.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 3, now);
+    sqlite3_bind_int64(stmt, 4, now);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        LOG_WARN("[CompletionCache] Cannot store: %s", sqlite3_errmsg(db_));
+    }
+    sqlite3_finalize(stmt);
+
+    // Trim expired and least recently used rows now and then, not per store
+    if (++disk_stores_ % 64 != 0) return;
+    if (config_.ttl_seconds > 0 &&
+        sqlite3_prepare_v2(db_, "DELETE FROM completion_cache WHERE created < ?", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, now - config_.ttl_seconds);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    if (config_.max_disk_entries > 0 &&
+        sqlite3_prepare_v2(db_,
+            "DELETE FROM completion_cache WHERE key IN ("
+            "  SELECT key FROM completion_cache ORDER BY used DESC LIMIT -1 OFFSET ?)",
+            -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, static_cast<int64_t>(config_.max_disk_entries));
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+}
+
+// ============================================================================
+// Cached calls
+// ============================================================================
+
+CompletionResult CompletionCache::chat(AIPlugin* ai, const std::vector<ConversationMessage>& messages,
+                                       const CompletionOptions& opts) {
+    if (!opts.cache_response) return ai->chat(messages, opts);
+
+    std::string k = key(*ai, messages, opts);
+    CompletionResult result;
+    if (lookup(k, result)) return result;
+
+    result = ai->chat(messages, opts);
+    store(k, result);
+    return result;
+}
+
+void CompletionCache::chat_async(AIPlugin* ai, const std::vector<ConversationMessage>& messages,
+                                 const CompletionOptions& opts, CompletionCallback on_done) {
+    if (!opts.cache_response) {
+        ai->chat_async(messages, opts, on_done);
+        return;
+    }
+
+    std::string k = key(*ai, messages, opts);
+    CompletionResult cached;
+    if (lookup(k, cached)) {
+        if (opts.on_chunk) opts.on_chunk(cached.content);
+        if (on_done) on_done(cached);
+        return;
+    }
+
+    ai->chat_async(messages, opts, [this, k, on_done](const CompletionResult& result) {
+        store(k, result);
+        if (on_done) on_done(result);
+    });
+}
+
+CompletionResult CompletionCache::complete(AIPlugin* ai, const std::string& prompt,
+                                           const CompletionOptions& opts) {
+    if (!opts.cache_response) return ai->complete(prompt, opts);
+
+    std::vector<ConversationMessage> messages;
+    messages.push_back(ConversationMessage::user(prompt));
+    std::string k = key(*ai, messages, opts);
+    CompletionResult result;
+    if (lookup(k, result)) return result;
+
+    result = ai->complete(prompt, opts);
+    store(k, result);
+    return result;
+}
+
+} // namespace openclaw
@@ -0,0 +1,459 @@
+/*
+ * OpenClaw C++11 - AI Provider Router Implementation
+ */
+#include <openclaw/ai/router.hpp>
+#include <openclaw/core/provider_budget.hpp>
+#include <openclaw/core/config.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/logger.hpp>
+#include <algorithm>
+#include <atomic>
+
+namespace openclaw {
+
+namespace {
+
+// Weight of the newest sample in the latency and error averages
+const double ewma_alpha = 0.2;
+
+}
+
+struct AIRouter::Call {
+    std::vector<ConversationMessage> messages;   // Kept for failover and hedging
+    CompletionOptions opts;
+    CompletionCallback on_done;
+    std::vector<size_t> candidates;             // Backend indexes, best first
+    int input_estimate;
+
+    std::mutex mutex;
+    size_t next;                    // First candidate not tried yet
+    size_t running;
+    bool done;
+    int streaming;                  // Attempt whose chunks reach opts.on_chunk (-1 = none yet)
+    bool has_spare;                 // A success from an attempt that did not stream
+    CompletionResult spare;
+    CompletionResult last_failure;
+    TimerWheel::TimerId hedge_timer;
+
+    // Per attempt, indexed by attempt number
+    std::vector<size_t> backend;
+    std::vector<int64_t> started_ms;
+    std::vector<std::shared_ptr<std::atomic<int64_t> > > first_byte_ms;
+
+    Call() : input_estimate(0), next(0), running(0), done(false), streaming(-1),
+             has_spare(false), hedge_timer(0) {}
+};
+
+AIRouter::AIRouter()
+    : budget_(nullptr)
+    , wheel_(TimerWheel::instance()) {}
+
+AIRouter::~AIRouter() {
+    wheel_.cancel_all(this);
+}
+
+AIRouter::Settings AIRouter::Settings::from_config(const Config& cfg) {
+    Settings s;
+    s.hedge = cfg.get_bool("ai_router.hedge", true);
+    s.hedge_min_ms = cfg.get_int("ai_router.hedge_min_ms", 1500);
+    s.failure_threshold = static_cast<int>(cfg.get_int("ai_router.failure_threshold", 3));
+    s.cooldown_ms = cfg.get_int("ai_router.cooldown_seconds", 30) * 1000;
+    return s;
+}
+
+bool AIRouter::init(const Config& cfg) {
+    settings_.set(Settings::from_config(cfg));
+    initialized_ = true;
+    return true;
+}
+
+void AIRouter::reconfigure(const Config& cfg) {
+    settings_.set(Settings::from_config(cfg));
+}
+
+void AIRouter::shutdown() {
+    wheel_.cancel_all(this);
+    initialized_ = false;
+}
+
+void AIRouter::add_backend(AIPlugin* ai) {
+    if (!ai || ai == this) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < backends_.size(); ++i) {
+        if (backends_[i].ai == ai) return;
+    }
+    Backend b;
+    b.ai = ai;
+    b.ttfb.reserve(TTFB_SAMPLES);
+    backends_.push_back(b);
+}
+
+size_t AIRouter::backend_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return backends_.size();
+}
+
+// ============================================================================
+// Health
+// ============================================================================
+
+bool AIRouter::retryable(const CompletionResult& result) {
+    if (result.success) return false;
+    // No response at all (timeout, connection) or the provider's fault
+    return result.http_status == 0 || result.http_status >= 500 ||
+           result.http_status == 429;
+}
+
+int64_t AIRouter::p95_ttfb_locked(const Backend& b) const {
+    if (b.ttfb.size() < settings_.get()->hedge_min_samples) return 0;
+    std::vector<int64_t> sorted(b.ttfb);
+    size_t k = (sorted.size() * 95) / 100;
+    if (k >= sorted.size()) k = sorted.size() - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    return sorted[k];
+}
+
+void AIRouter::record(size_t index, const CompletionResult& result, int64_t latency_ms, int64_t ttfb_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Backend& b = backends_[index];
+    b.calls++;
+
+    bool failed = retryable(result);
+    b.error_rate += ewma_alpha * ((failed ? 1.0 : 0.0) - b.error_rate);
+    if (failed) {
+        Snapshot<Settings>::Ptr settings = settings_.get();
+        if (++b.failures >= settings->failure_threshold) {
+            b.open_until_ms = current_timestamp_ms() + settings->cooldown_ms;
+            LOG_WARN("[Router] %s failed %d times in a row; skipping it for %lld ms",
+                     b.ai->provider_id().c_str(), b.failures,
+                     static_cast<long long>(settings->cooldown_ms));
+        }
+        return;
+    }
+
+    b.failures = 0;
+    b.open_until_ms = 0;
+    b.latency_ms = b.latency_ms > 0 ? b.latency_ms + ewma_alpha * (latency_ms - b.latency_ms)
+                                    : static_cast<double>(latency_ms);
+    if (b.ttfb.size() < TTFB_SAMPLES) {
+        b.ttfb.push_back(ttfb_ms);
+    } else {
+        b.ttfb[b.ttfb_next] = ttfb_ms;
+        b.ttfb_next = (b.ttfb_next + 1) % TTFB_SAMPLES;
+    }
+}
+
+std::vector<size_t> AIRouter::ranked() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now = current_timestamp_ms();
+
+    // Cost: 0 = healthy, then throttled by its budget, then circuit open;
+    // within a class, latency inflated by the error rate
+    std::vector<std::pair<std::pair<int, double>, size_t> > order;
+    for (size_t i = 0; i < backends_.size(); ++i) {
+        const Backend& b = backends_[i];
+        if (!b.ai->is_initialized() || !b.ai->is_configured()) continue;
+        int cls = 0;
+        if (budget_ && budget_->blocked_for_ms(b.ai->provider_id()) > 0) cls = 1;
+        if (b.open_until_ms > now) cls = 2;
+        double score = b.latency_ms * (1.0 + 4.0 * b.error_rate);
+        order.push_back(std::make_pair(std::make_pair(cls, score), i));
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const std::pair<std::pair<int, double>, size_t>& a,
+                        const std::pair<std::pair<int, double>, size_t>& b) {
+                         return a.first < b.first;
+                     });
+
+    std::vector<size_t> result;
+    for (size_t i = 0; i < order.size(); ++i) result.push_back(order[i].second);
+    return result;
+}
+
+std::vector<AIRouter::BackendStats> AIRouter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now = current_timestamp_ms();
+    std::vector<BackendStats> out;
+    for (size_t i = 0; i < backends_.size(); ++i) {
+        const Backend& b = backends_[i];
+        BackendStats s;
+        s.provider = b.ai->provider_id();
+        s.latency_ms = b.latency_ms;
+        s.error_rate = b.error_rate;
+        s.p95_ttfb_ms = p95_ttfb_locked(b);
+        s.calls = b.calls;
+        s.hedges = b.hedges;
+        s.open = b.open_until_ms > now;
+        out.push_back(s);
+    }
+    return out;
+}
+
+// ============================================================================
+// AIPlugin
+// ============================================================================
+
+bool AIRouter::is_configured() const {
+    return !ranked().empty();
+}
+
+std::vector<std::string> AIRouter::available_models() const {
+    std::vector<size_t> order = ranked();
+    std::vector<std::string> models;
+    for (size_t i = 0; i < order.size(); ++i) {
+        std::vector<std::string> m = backends_[order[i]].ai->available_models();
+        models.insert(models.end(), m.begin(), m.end());
+    }
+    return models;
+}
+
+std::string AIRouter::default_model() const {
+    std::vector<size_t> order = ranked();
+    return order.empty() ? std::string() : backends_[order[0]].ai->default_model();
+}
+
+// History is budgeted once for whichever backend ends up answering, so
+// the smallest window of the candidates applies
+int AIRouter::context_window(const std::string& model) const {
+    std::vector<size_t> order = ranked();
+    int window = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        int w = backends_[order[i]].ai->context_window(model);
+        if (w > 0 && (window == 0 || w < window)) window = w;
+    }
+    return window;
+}
+
+TokenEstimator AIRouter::token_estimator() const {
+    std::vector<size_t> order = ranked();
+    return order.empty() ? TokenEstimator() : backends_[order[0]].ai->token_estimator();
+}
+
+// Native tool blocks must be understood by every backend a call can reach
+bool AIRouter::supports_native_tools() const {
+    std::vector<size_t> order = ranked();
+    if (order.empty()) return false;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (!backends_[order[i]].ai->supports_native_tools()) return false;
+    }
+    return true;
+}
+
+bool AIRouter::supports_batch() const {
+    for (size_t i = 0; i < backends_.size(); ++i) {
+        if (backends_[i].ai->supports_batch()) return true;
+    }
+    return false;
+}
+
+CompletionResult AIRouter::complete(const std::string& prompt, const CompletionOptions& opts) {
+    std::vector<ConversationMessage> messages;
+    messages.push_back(ConversationMessage::user(prompt));
+    return chat(messages, opts);
+}
+
+CompletionResult AIRouter::chat(const std::vector<ConversationMessage>& messages,
+                                const CompletionOptions& opts) {
+    std::vector<size_t> order = ranked();
+    if (order.empty()) return CompletionResult::fail("No AI provider available");
+
+    // Blocking callers get failover but no hedging
+    CompletionResult result;
+    for (size_t i = 0; i < order.size(); ++i) {
+        AIPlugin* ai = backends_[order[i]].ai;
+        int64_t started = current_timestamp_ms();
+        result = ai->chat(messages, opts);
+        int64_t elapsed = current_timestamp_ms() - started;
+        record(order[i], result, elapsed, elapsed);
+        if (!retryable(result)) break;
+        LOG_WARN("[Router] %s failed (%s); trying the next provider",
+                 ai->provider_id().c_str(), result.error.c_str());
+    }
+    return result;
+}
+
+void AIRouter::chat_async(const std::vector<ConversationMessage>& messages,
+                          const CompletionOptions& opts,
+                          CompletionCallback on_done) {
+    std::vector<size_t> order = ranked();
+    if (order.empty()) {
+        if (on_done) on_done(CompletionResult::fail("No AI provider available"));
+        return;
+    }
+    if (opts.batch) {
+        // Backends with a batch endpoint first, keeping health order otherwise
+        std::stable_partition(order.begin(), order.end(),
+                              [this](size_t i) { return backends_[i].ai->supports_batch(); });
+    }
+
+    CallPtr call = std::make_shared<Call>();
+    call->opts = opts;
+    call->on_done = on_done;
+    call->candidates = order;
+    // Attempts may start after this returns (budget wait, failover, hedge);
+    // message contents are shared, so the copy is shallow
+    call->messages = messages;
+    // Attempt slots never reallocate while callbacks read them
+    call->backend.reserve(order.size());
+    call->started_ms.reserve(order.size());
+    call->first_byte_ms.reserve(order.size());
+
+    if (budget_ && !opts.batch) {
+        TokenEstimator estimator = backends_[order[0]].ai->token_estimator();
+        call->input_estimate = estimator.count(messages) +
+                               estimator.count(opts.tools_prompt) + estimator.count(opts.system_prompt);
+    }
+
+    launch(call);
+
+    // Only worth hedging once the primary's normal TTFB is known
+    Snapshot<Settings>::Ptr settings = settings_.get();
+    if (settings->hedge && !opts.batch && order.size() > 1) {
+        int64_t p95 = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            p95 = p95_ttfb_locked(backends_[order[0]]);
+        }
+        if (p95 > 0) {
+            std::lock_guard<std::mutex> lock(call->mutex);
+            if (!call->done) {
+                call->hedge_timer = wheel_.schedule_in(std::max(p95, settings->hedge_min_ms),
+                                                       [this, call] { on_hedge_timer(call); }, this);
+            }
+        }
+    }
+
+}
+
+void AIRouter::launch(CallPtr call) {
+    size_t attempt = 0;
+    size_t index = 0;
+    {
+        std::lock_guard<std::mutex> lock(call->mutex);
+        attempt = call->backend.size();
+        index = call->candidates[call->next++];
+        call->backend.push_back(index);
+        call->started_ms.push_back(current_timestamp_ms());
+        call->first_byte_ms.push_back(std::make_shared<std::atomic<int64_t> >(0));
+        call->running++;
+    }
+    std::shared_ptr<std::atomic<int64_t> > first_byte = call->first_byte_ms[attempt];
+
+    // Of concurrent attempts, only the first to stream reaches the caller
+    CompletionOptions opts = call->opts;
+    if (call->opts.on_chunk) {
+        StreamCallback user_chunk = call->opts.on_chunk;
+        opts.on_chunk = [call, attempt, first_byte, user_chunk](const std::string& chunk) {
+            if (first_byte->load() == 0) first_byte->store(current_timestamp_ms());
+            {
+                std::lock_guard<std::mutex> lock(call->mutex);
+                if (call->streaming < 0) call->streaming = static_cast<int>(attempt);
+                if (call->streaming != static_cast<int>(attempt)) return;
+            }
+            user_chunk(chunk);
+        };
+    } else {
+        opts.on_chunk = StreamCallback();
+    }
+
+    AIPlugin* ai = backends_[index].ai;
+    // Batches are billed and rate limited apart from the live limits
+    ProviderBudget* budget = call->opts.batch ? nullptr : budget_;
+    const std::vector<ConversationMessage>* messages = &call->messages;
+
+    ProviderBudget::AdmitCallback send = [this, call, attempt, ai, opts, budget, messages]
+                                         (ProviderBudget::Ticket ticket) {
+        call->started_ms[attempt] = current_timestamp_ms();
+        ai->chat_async(*messages, opts, [this, call, attempt, budget, ticket](const CompletionResult& result) {
+            if (budget) budget->release(ticket, result);
+            on_attempt_done(call, attempt, result);
+        });
+    };
+
+    if (budget) {
+        budget->acquire(ai->provider_id(), call->input_estimate, opts.max_tokens, send);
+    } else {
+        send(0);
+    }
+}
+
+void AIRouter::on_hedge_timer(CallPtr call) {
+    size_t primary = 0;
+    {
+        std::lock_guard<std::mutex> lock(call->mutex);
+        call->hedge_timer = 0;
+        if (call->done || call->next >= call->candidates.size()) return;
+        // Already streaming: not stalled
+        if (call->first_byte_ms[0]->load() > 0 || call->running != 1) return;
+        primary = call->backend[0];
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backends_[call->candidates[call->next]].hedges++;
+        LOG_INFO("[Router] %s past its p95 time to first byte; hedging to %s",
+                 backends_[primary].ai->provider_id().c_str(),
+                 backends_[call->candidates[call->next]].ai->provider_id().c_str());
+    }
+    launch(call);
+}
+
+void AIRouter::on_attempt_done(CallPtr call, size_t attempt, const CompletionResult& result) {
+    int64_t now = current_timestamp_ms();
+    int64_t started = call->started_ms[attempt];
+    int64_t first = call->first_byte_ms[attempt]->load();
+    // Batched calls take minutes by design and say nothing about live latency
+    if (!call->opts.batch) {
+        record(call->backend[attempt], result, now - started, first > 0 ? first - started : now - started);
+    }
+
+    bool deliver = false;
+    bool failover = false;
+    CompletionResult answer;
+    {
+        std::lock_guard<std::mutex> lock(call->mutex);
+        call->running--;
+        if (call->done) return;     // Lost the race to another attempt
+
+        bool streamed_other = call->streaming >= 0 && call->streaming != static_cast<int>(attempt);
+        if (result.success && !streamed_other) {
+            answer = result;
+            deliver = true;
+        } else if (result.success) {
+            // The caller has seen the other attempt's chunks; wait for it
+            call->spare = result;
+            call->has_spare = true;
+        } else {
+            call->last_failure = result;
+            bool streamed_this = call->streaming == static_cast<int>(attempt);
+            if (!streamed_this && retryable(result) && call->next < call->candidates.size() &&
+                call->running == 0) {
+                failover = true;
+            }
+        }
+
+        if (!deliver && !failover && call->running == 0) {
+            answer = call->has_spare ? call->spare : call->last_failure;
+            deliver = true;
+        }
+        if (deliver) {
+            call->done = true;
+            if (call->hedge_timer) {
+                wheel_.cancel(call->hedge_timer);
+                call->hedge_timer = 0;
+            }
+        }
+    }
+
+    if (failover) {
+        LOG_WARN("[Router] %s failed (%s); failing over",
+                 backends_[call->backend[attempt]].ai->provider_id().c_str(), result.error.c_str());
+        launch(call);
+        return;
+    }
+    if (deliver && call->on_done) {
+        call->on_done(answer);
+    }
+}
+
+} // namespace openclaw
@@ -0,0 +1,459 @@
+/*
+ * OpenClaw C++11 - Microbenchmarks
+ *
+ * Times the core hot paths on synthetic but realistic input and writes the
+ * results as JSON, so runs of different releases can be compared.
+ *
+ * Usage:
+ *   openclaw-bench [--filter substr] [--min-time seconds] [--repeat n]
+ *                  [--out file.json] [--compare old.json]
+ *
+ * Each benchmark runs enough iterations to last --min-time, --repeat times;
+ * the fastest run is reported (the others mostly measure noise). With
+ * --compare, the change against an earlier result file goes to stderr.
+ */
+#include <openclaw/core/agent.hpp>
+#include <openclaw/core/application.hpp>
+#include <openclaw/core/html_text.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/core/rate_limiter.hpp>
+#include <openclaw/core/session.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/memory/manager.hpp>
+#include <openclaw/memory/store.hpp>
+#include <openclaw/core/json.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace openclaw;
+
+namespace {
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double ns_per_op;
+    size_t bytes_per_op;        // Input processed per operation (0 = n/a)
+};
+
+struct BenchOptions {
+    std::string filter;
+    double min_time;
+    int repeat;
+    std::string out;
+    std::string compare;
+
+    BenchOptions() : min_time(0.2), repeat(3) {}
+};
+
+// Keeps the optimizer from dropping a result
+volatile size_t g_sink = 0;
+
+template <typename T>
+void consume(const T& value) {
+    g_sink = g_sink + value.size();
+}
+
+double elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+class Runner {
+public:
+    explicit Runner(const BenchOptions& options) : options_(options) {}
+
+    void run(const std::string& name, size_t bytes_per_op, const std::function<void()>& op) {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string::npos) return;
+
+        // Grow the batch until one takes a tenth of min_time
+        uint64_t batch = 1;
+        for (;;) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < batch; ++i) op();
+            if (elapsed_ns(start) >= options_.min_time * 1e8 || batch >= (1ULL << 30)) break;
+            batch *= 2;
+        }
+
+        BenchResult best;
+        best.name = name;
+        best.iterations = 0;
+        best.ns_per_op = 0;
+        best.bytes_per_op = bytes_per_op;
+        for (int r = 0; r < options_.repeat; ++r) {
+            uint64_t iterations = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            double ns = 0;
+            do {
+                for (uint64_t i = 0; i < batch; ++i) op();
+                iterations += batch;
+                ns = elapsed_ns(start);
+            } while (ns < options_.min_time * 1e9);
+            double per_op = ns / static_cast<double>(iterations);
+            if (best.iterations == 0 || per_op < best.ns_per_op) {
+                best.iterations = iterations;
+                best.ns_per_op = per_op;
+            }
+        }
+
+        fprintf(stderr, "%-36s %12.0f ns/op", name.c_str(), best.ns_per_op);
+        if (bytes_per_op) {
+            fprintf(stderr, " %10.1f MB/s", bytes_per_op / best.ns_per_op * 1e9 / (1 << 20));
+        }
+        fprintf(stderr, "\n");
+        results_.push_back(best);
+    }
+
+    const std::vector<BenchResult>& results() const { return results_; }
+
+private:
+    BenchOptions options_;
+    std::vector<BenchResult> results_;
+};
+
+// ============================================================================
+// Synthetic input (fixed seeds: every run sees the same data)
+// ============================================================================
+
+const char* const WORDS[] = {
+    "the", "session", "agent", "returns", "memory", "index", "request", "channel",
+    "provider", "latency", "thread", "pool", "config", "message", "tool", "result",
+    "search", "budget", "timeout", "history", "summary", "context", "user", "reply",
+    "network", "cache", "kernel", "buffer", "parser", "stream", "token", "window"
+};
+const size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+std::string sentence(std::mt19937& rng, int words) {
+    std::string out;
+    for (int i = 0; i < words; ++i) {
+        if (i) out += ' ';
+        out += WORDS[rng() % WORD_COUNT];
+    }
+    out += '.';
+    return out;
+}
+
+std::string prose(std::mt19937& rng, size_t bytes) {
+    std::string out;
+    while (out.size() < bytes) {
+        out += sentence(rng, 8 + static_cast<int>(rng() % 12));
+        out += (rng() % 5 == 0) ? "\n\n" : " ";
+    }
+    return out;
+}
+
+// A model reply as the agent sees it: reasoning, three tool calls, prose
+std::string model_output(std::mt19937& rng) {
+    std::string out = prose(rng, 600);
+    out += "\n<tool_call name=\"bash\">{\"command\": \"grep -rn 'timeout' src/ | head -50\"}</tool_call>\n";
+    out += prose(rng, 300);
+    out += "\n<tool_call name=\"read\">{\"path\": \"src/core/agent.cpp\", \"offset\": 120, \"limit\": 80}</tool_call>\n";
+    out += "<tool_call name=\"memory_search\">{\"query\": \"provider budget timeout\", \"max_results\": 5}</tool_call>\n";
+    out += prose(rng, 400);
+    return out;
+}
+
+std::string markdown(std::mt19937& rng, size_t bytes) {
+    std::string out;
+    int section = 0;
+    while (out.size() < bytes) {
+        out += "## Section " + std::to_string(++section) + "\n\n";
+        out += prose(rng, 400 + rng() % 800);
+        out += "\n\n- " + sentence(rng, 6) + "\n- " + sentence(rng, 7) + "\n\n";
+    }
+    return out;
+}
+
+std::string session_jsonl(std::mt19937& rng, int messages) {
+    std::string out;
+    out += "{\"key\":\"agent:default:main\",\"type\":\"session\",\"v\":1}\n";
+    for (int i = 0; i < messages; ++i) {
+        Json record;
+        record["role"] = (i % 2) ? "assistant" : "user";
+        record["content"] = prose(rng, 100 + rng() % 600);
+        record["ts"] = 1700000000 + i * 30;
+        out += record.dump() + "\n";
+    }
+    return out;
+}
+
+std::string html_page(std::mt19937& rng, size_t bytes) {
+    std::string out = "<!DOCTYPE html><html><head><title>Benchmark page</title>"
+                      "<style>body { font-family: sans-serif; } .nav a { color: #333; }</style>"
+                      "<script>window.analytics = { track: function() {} };</script></head><body>"
+                      "<nav class=\"nav\"><a href=\"/\">Home</a> <a href=\"/docs\">Docs</a></nav>";
+    int n = 0;
+    while (out.size() < bytes) {
+        out += "<h2 id=\"s" + std::to_string(++n) + "\">" + sentence(rng, 4) + "</h2>";
+        out += "<p>" + sentence(rng, 12) + " <a href=\"/page/" + std::to_string(n) + "\">" +
+               sentence(rng, 3) + "</a> " + sentence(rng, 15) + " &amp; " + sentence(rng, 6) + "</p>";
+        out += "<ul><li>" + sentence(rng, 5) + "</li><li>" + sentence(rng, 7) + "</li></ul>";
+        if (n % 5 == 0) out += "<script>var x" + std::to_string(n) + " = [1, 2, 3];</script>";
+    }
+    out += "</body></html>";
+    return out;
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+void bench_agent(Runner& runner) {
+    std::mt19937 rng(1);
+    Agent agent;
+
+    std::string reply = model_output(rng);
+    runner.run("agent.parse_tool_calls", reply.size(), [&] {
+        consume(agent.parse_tool_calls(reply));
+    });
+
+    // recover_params_from_raw is internal; a call that failed to parse as
+    // JSON reaches it through execute_tool (the tool itself does nothing)
+    AgentTool tool("bench_shell", "No-op tool with bash-like parameters",
+                   [](const Json&) { return AgentToolResult::ok(""); });
+    tool.params.push_back(ToolParamSchema("command", "string", "Command to run", true));
+    tool.params.push_back(ToolParamSchema("timeout", "number", "Seconds", false));
+    tool.params.push_back(ToolParamSchema("workdir", "string", "Directory", false));
+    agent.register_tool(tool);
+
+    ParsedToolCall call;
+    call.tool_name = "bench_shell";
+    call.raw_content = "{\"command\": \"find . -name '*.cpp' | xargs grep -l \\\"Json\\\"\", timeout: 30, "
+                       "\"workdir\": \"/srv/app\"";
+    call.valid = false;
+    call.parse_error = "unterminated object";
+    if (!agent.execute_tool(call).success) {
+        fprintf(stderr, "warning: agent.recover_params input is not recoverable\n");
+    }
+    runner.run("agent.recover_params", call.raw_content.size(), [&] {
+        consume(agent.execute_tool(call).output);
+    });
+}
+
+void bench_chunker(Runner& runner) {
+    std::mt19937 rng(2);
+    ContentChunker chunker;
+    chunker.configure(256 << 20, 0);
+
+    std::string content = prose(rng, 100 * 1024);
+    runner.run("chunker.store", content.size(), [&] {
+        std::string id = chunker.store(content, "bench");
+        chunker.remove(id);
+    });
+
+    std::string big = prose(rng, 1024 * 1024);
+    std::string id = chunker.store(big, "bench");
+    chunker.search(id, "provider latency");     // Builds the index once
+    runner.run("chunker.search", big.size(), [&] {
+        consume(chunker.search(id, "provider latency"));
+    });
+    runner.run("chunker.search_phrase", big.size(), [&] {
+        consume(chunker.search(id, "\"thread pool\" timeout"));
+    });
+}
+
+void bench_messages(Runner& runner) {
+    std::mt19937 rng(3);
+    std::string reply = markdown(rng, 20 * 1024);
+    runner.run("split_message_chunks", reply.size(), [&] {
+        consume(split_message_chunks(reply, 4096));
+    });
+
+    RoutePeer peer = RoutePeer::dm("123456789");
+    runner.run("session_key.build", 0, [&] {
+        consume(SessionKey::build("default", "telegram", "default", &peer, DMScope::PER_CHANNEL_PEER));
+    });
+
+    KeyedRateLimiter limiter(KeyedRateLimiter::TOKEN_BUCKET, 1000000, 1000000);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1000; ++i) keys.push_back("user:" + std::to_string(100000 + i));
+    size_t next = 0;
+    runner.run("rate_limiter.check", 0, [&] {
+        g_sink = g_sink + limiter.check(keys[next]).allowed;
+        next = (next + 1) % keys.size();
+    });
+
+    std::string page = html_page(rng, 100 * 1024);
+    runner.run("html_text.extract", page.size(), [&] {
+        std::string text;
+        html_text::extract(page, 100000, text);
+        consume(text);
+    });
+}
+
+void bench_memory(Runner& runner) {
+    std::mt19937 rng(4);
+    MemoryConfig config;
+    MemoryManager manager(config);
+
+    std::string doc = markdown(rng, 64 * 1024);
+    runner.run("memory.chunk_content", doc.size(), [&] {
+        consume(manager.chunk_content(doc, "memory/notes.md", MemorySource::MEMORY));
+    });
+
+    std::string transcript = session_jsonl(rng, 500);
+    runner.run("memory.extract_session_text", transcript.size(), [&] {
+        size_t consumed = 0;
+        consume(manager.extract_session_text(transcript, 0, consumed));
+    });
+
+    // Search over a synthetic corpus of 200 files (a few thousand chunks)
+    char dir[] = "/tmp/openclaw-bench-XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "warning: no temp dir; skipping memory_store.search\n");
+        return;
+    }
+    std::string db_path = std::string(dir) + "/memory.db";
+    {
+        MemoryStore store;
+        if (!store.open(db_path) || !store.ensure_schema()) {
+            fprintf(stderr, "warning: %s; skipping memory_store.search\n", store.last_error().c_str());
+        } else {
+            store.begin();
+            for (int f = 0; f < 200; ++f) {
+                MemoryFile file;
+                file.path = "memory/note-" + std::to_string(f) + ".md";
+                file.abs_path = std::string(dir) + "/" + file.path;
+                // A topic word shared by a few files keeps the query selective
+                std::string text = "# Notes on project" + std::to_string(f % 40) + "\n\n" +
+                                   markdown(rng, 16 * 1024);
+                file.hash = std::to_string(f);
+                file.size = static_cast<int64_t>(text.size());
+                store.replace_file(file, manager.chunk_content(text, file.path, MemorySource::MEMORY));
+            }
+            store.commit();
+
+            MemorySearchConfig search;
+            search.min_score = 0;
+            if (store.search("project7 latency", search).empty()) {
+                fprintf(stderr, "warning: memory_store.search finds nothing\n");
+            }
+            runner.run("memory_store.search", 0, [&] {
+                consume(store.search("project7 latency", search));
+            });
+        }
+    }
+    unlink(db_path.c_str());
+    unlink((db_path + "-wal").c_str());
+    unlink((db_path + "-shm").c_str());
+    rmdir(dir);
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+Json to_json(const std::vector<BenchResult>& results) {
+    Json doc;
+    doc["suite"] = "openclaw-bench";
+    doc["version"] = std::string(AppInfo::VERSION);
+    doc["timestamp"] = current_timestamp();
+#ifdef __OPTIMIZE__
+    doc["optimized"] = true;
+#else
+    doc["optimized"] = false;
+#endif
+    doc["compiler"] = __VERSION__;
+    Json list = Json::array();
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        Json j;
+        j["name"] = r.name;
+        j["iterations"] = r.iterations;
+        j["ns_per_op"] = r.ns_per_op;
+        j["ops_per_sec"] = 1e9 / r.ns_per_op;
+        if (r.bytes_per_op) {
+            j["bytes_per_op"] = r.bytes_per_op;
+            j["mb_per_sec"] = r.bytes_per_op / r.ns_per_op * 1e9 / (1 << 20);
+        }
+        list.push_back(j);
+    }
+    doc["results"] = list;
+    return doc;
+}
+
+void compare(const std::vector<BenchResult>& results, const std::string& path) {
+    std::ifstream in(path.c_str());
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    Json old = Json::parse(buffer.str(), nullptr, false);
+    if (!old.is_object() || !old.contains("results")) {
+        fprintf(stderr, "cannot read %s\n", path.c_str());
+        return;
+    }
+    fprintf(stderr, "\nAgainst %s (%s):\n", path.c_str(), old.value("version", "?").c_str());
+    for (size_t i = 0; i < results.size(); ++i) {
+        for (const auto& o : old["results"]) {
+            if (o.value("name", "") != results[i].name) continue;
+            double before = o.value("ns_per_op", 0.0);
+            if (before <= 0) break;
+            double change = (results[i].ns_per_op - before) / before * 100.0;
+            fprintf(stderr, "%-36s %+8.1f%%%s\n", results[i].name.c_str(), change,
+                    change > 10.0 ? "  slower" : "");
+            break;
+        }
+    }
+}
+
+void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [--filter substr] [--min-time seconds] [--repeat n]\n"
+            "          [--out file.json] [--compare old.json]\n", prog);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && has_value) {
+            options.min_time = atof(argv[++i]);
+        } else if (arg == "--repeat" && has_value) {
+            options.repeat = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--out" && has_value) {
+            options.out = argv[++i];
+        } else if (arg == "--compare" && has_value) {
+            options.compare = argv[++i];
+        } else {
+            usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : 1;
+        }
+    }
+
+    Logger::instance().set_level(LogLevel::ERROR);
+
+    Runner runner(options);
+    bench_agent(runner);
+    bench_chunker(runner);
+    bench_messages(runner);
+    bench_memory(runner);
+
+    std::string json = to_json(runner.results()).dump(2) + "\n";
+    if (options.out.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream out(options.out.c_str());
+        out << json;
+        if (!out) {
+            fprintf(stderr, "cannot write %s\n", options.out.c_str());
+            return 1;
+        }
+    }
+    if (!options.compare.empty()) compare(runner.results(), options.compare);
+    return 0;
+}
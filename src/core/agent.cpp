@@ -7,6 +7,10 @@
 #include <openclaw/core/agent.hpp>
 #include <openclaw/ai/ai.hpp>
 #include <openclaw/core/utils.hpp>
+#include <openclaw/core/thread_pool.hpp>
+#include <openclaw/core/provider_budget.hpp>
+#include <openclaw/core/timer_wheel.hpp>
+#include <openclaw/core/metrics.hpp>
 #include <sstream>
 #include <algorithm>
 #include <cstdlib>
@@ -14,6 +18,14 @@
 #include <cstring>
 #include <cctype>
 #include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace openclaw {
 
@@ -21,43 +33,447 @@ namespace openclaw {
 // ContentChunker Implementation
 // ============================================================================
 
-ContentChunker::ContentChunker() : next_id_(1) {}
+namespace {
+
+// Scope of the calling thread (see ContentChunker::ScopeGuard)
+thread_local const std::string* tls_chunk_scope = nullptr;
+
+const std::string& current_chunk_scope() {
+    static const std::string unscoped;
+    return tls_chunk_scope ? *tls_chunk_scope : unscoped;
+}
+
+// Case-folded, de-duplicated query terms. Words are separate terms;
+// "double quotes" keep a phrase together.
+std::vector<std::string> parse_search_terms(const std::string& query) {
+    std::vector<std::string> terms;
+    std::string current;
+    bool quoted = false;
+    
+    for (size_t i = 0; i <= query.size(); ++i) {
+        char c = i < query.size() ? query[i] : ' ';
+        bool split = (c == '"') || (!quoted && isspace(static_cast<unsigned char>(c)));
+        if (!split) {
+            current += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            continue;
+        }
+        if (c == '"') quoted = !quoted;
+        if (!current.empty() && std::find(terms.begin(), terms.end(), current) == terms.end()) {
+            terms.push_back(current);
+        }
+        current.clear();
+    }
+    return terms;
+}
+
+size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+} // anonymous namespace
+
+ContentChunker::ScopeGuard::ScopeGuard(const std::string& scope)
+    : previous_(tls_chunk_scope), scope_(scope) {
+    tls_chunk_scope = &scope_;
+}
+
+ContentChunker::ScopeGuard::~ScopeGuard() {
+    tls_chunk_scope = previous_;
+}
+
+const std::string& ContentChunker::current_scope() {
+    return current_chunk_scope();
+}
+
+// Case-folded copy of an item and its positions sorted by trigram, so the
+// occurrences of any trigram form one contiguous range. Built on first search.
+struct ContentChunker::SearchIndex {
+    std::string folded;
+    std::vector<uint32_t> positions;
+    
+    explicit SearchIndex(const std::string& content) : folded(content) {
+        for (size_t i = 0; i < folded.size(); ++i) {
+            folded[i] = static_cast<char>(tolower(static_cast<unsigned char>(folded[i])));
+        }
+        if (folded.size() < 3) return;
+        
+        // LSD radix sort on the three trigram bytes, last byte first
+        size_t n = folded.size() - 2;
+        positions.resize(n);
+        for (size_t i = 0; i < n; ++i) positions[i] = static_cast<uint32_t>(i);
+        
+        std::vector<uint32_t> sorted(n);
+        for (int byte = 2; byte >= 0; --byte) {
+            size_t counts[257] = {0};
+            for (size_t i = 0; i < n; ++i) {
+                counts[at(positions[i] + byte) + 1]++;
+            }
+            for (size_t b = 1; b < 257; ++b) counts[b] += counts[b - 1];
+            for (size_t i = 0; i < n; ++i) {
+                sorted[counts[at(positions[i] + byte)]++] = positions[i];
+            }
+            positions.swap(sorted);
+        }
+    }
+    
+    size_t bytes() const { return folded.size() + positions.size() * sizeof(uint32_t); }
+    
+    unsigned char at(size_t pos) const { return static_cast<unsigned char>(folded[pos]); }
+    
+    uint32_t key(size_t pos) const {
+        return (static_cast<uint32_t>(at(pos)) << 16) | (static_cast<uint32_t>(at(pos + 1)) << 8) | at(pos + 2);
+    }
+    
+    typedef std::vector<uint32_t>::const_iterator Iter;
+    
+    std::pair<Iter, Iter> range(uint32_t k) const {
+        Iter first = std::lower_bound(positions.begin(), positions.end(), k,
+            [this](uint32_t pos, uint32_t value) { return key(pos) < value; });
+        Iter last = std::upper_bound(first, positions.end(), k,
+            [this](uint32_t value, uint32_t pos) { return value < key(pos); });
+        return std::make_pair(first, last);
+    }
+    
+    // Ascending start offsets of a folded term
+    std::vector<size_t> find_all(const std::string& term) const {
+        std::vector<size_t> found;
+        if (term.empty()) return found;
+        
+        if (term.size() < 3 || positions.empty()) {
+            size_t pos = folded.find(term);
+            while (pos != std::string::npos) {
+                found.push_back(pos);
+                pos = folded.find(term, pos + 1);
+            }
+            return found;
+        }
+        
+        // Verify the candidates of the term's rarest trigram
+        size_t offset = 0;
+        std::pair<Iter, Iter> rarest;
+        for (size_t k = 0; k + 3 <= term.size(); ++k) {
+            uint32_t value = (static_cast<uint32_t>(static_cast<unsigned char>(term[k])) << 16) |
+                             (static_cast<uint32_t>(static_cast<unsigned char>(term[k + 1])) << 8) |
+                             static_cast<unsigned char>(term[k + 2]);
+            std::pair<Iter, Iter> r = range(value);
+            if (k == 0 || (r.second - r.first) < (rarest.second - rarest.first)) {
+                offset = k;
+                rarest = r;
+            }
+            if (r.first == r.second) return found;
+        }
+        
+        for (Iter it = rarest.first; it != rarest.second; ++it) {
+            if (*it < offset) continue;
+            size_t start = *it - offset;
+            if (start + term.size() <= folded.size() &&
+                folded.compare(start, term.size(), term) == 0) {
+                found.push_back(start);
+            }
+        }
+        return found;
+    }
+};
+
+struct ContentChunker::Item {
+    std::string id;
+    std::string scope;
+    std::string source;
+    size_t chunk_size;
+    size_t total_chunks;
+    size_t size;
+    std::string content;            // Empty once spilled, or for a file slice
+    FileSlice file;                 // Set: content is this mapped range
+    bool spilled;
+    size_t spill_offset;
+    std::list<std::string>::iterator lru;
+    std::unique_ptr<SearchIndex> index;
+    
+    Item() : chunk_size(0), total_chunks(0), size(0), spilled(false), spill_offset(0) {}
+};
+
+// Unlinked scratch file mapped into memory. Spilled content is paged in on
+// access and can be reclaimed by the kernel instead of sitting in the heap.
+struct ContentChunker::SpillFile {
+    int fd;
+    char* base;
+    size_t capacity;
+    size_t used;
+    std::map<size_t, size_t> free_;    // Offset -> length, coalesced
+    
+    SpillFile() : fd(-1), base(nullptr), capacity(0), used(0) {}
+    
+    ~SpillFile() {
+        if (base) munmap(base, capacity);
+        if (fd >= 0) close(fd);
+    }
+    
+    bool open(const std::string& dir, size_t bytes) {
+        std::string path = (dir.empty() ? std::string("/tmp") : dir) + "/openclaw-chunks-XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        
+        fd = mkstemp(&name[0]);
+        if (fd < 0) {
+            LOG_WARN("[ContentChunker] Cannot create spill file in %s: %s", dir.c_str(), strerror(errno));
+            return false;
+        }
+        unlink(&name[0]);   // Disappears with the process
+        
+        // Reserve the blocks up front: writing to a hole on a full disk
+        // would raise SIGBUS instead of failing cleanly
+        int rc = posix_fallocate(fd, 0, static_cast<off_t>(bytes));
+        if (rc != 0) {
+            LOG_WARN("[ContentChunker] Cannot reserve %zu byte spill file: %s", bytes, strerror(rc));
+            return false;
+        }
+        
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            LOG_WARN("[ContentChunker] Cannot map spill file: %s", strerror(errno));
+            return false;
+        }
+        base = static_cast<char*>(p);
+        capacity = bytes;
+        free_[0] = bytes;
+        return true;
+    }
+    
+    // First fit
+    bool allocate(size_t len, size_t& offset) {
+        for (std::map<size_t, size_t>::iterator it = free_.begin(); it != free_.end(); ++it) {
+            if (it->second < len) continue;
+            offset = it->first;
+            size_t rest = it->second - len;
+            free_.erase(it);
+            if (rest > 0) free_[offset + len] = rest;
+            used += len;
+            return true;
+        }
+        return false;
+    }
+    
+    void release(size_t offset, size_t len) {
+        used -= len;
+        std::map<size_t, size_t>::iterator it = free_.insert(std::make_pair(offset, len)).first;
+        
+        std::map<size_t, size_t>::iterator next = it;
+        ++next;
+        if (next != free_.end() && it->first + it->second == next->first) {
+            it->second += next->second;
+            free_.erase(next);
+        }
+        if (it != free_.begin()) {
+            std::map<size_t, size_t>::iterator prev = it;
+            --prev;
+            if (prev->first + prev->second == it->first) {
+                prev->second += it->second;
+                free_.erase(it);
+            }
+        }
+    }
+    
+    void write(size_t offset, const std::string& data) {
+        memcpy(base + offset, data.data(), data.size());
+        
+        // Drop the whole pages from our mapping; the data stays in the file
+        size_t page = page_size();
+        size_t first = (offset + page - 1) / page * page;
+        size_t last = (offset + data.size()) / page * page;
+        if (last > first) {
+            madvise(base + first, last - first, MADV_DONTNEED);
+        }
+    }
+};
+
+ContentChunker::ContentChunker()
+    : memory_budget_(64 * 1024 * 1024)
+    , memory_bytes_(0)
+    , next_id_(1) {}
+
+ContentChunker::~ContentChunker() {}
+
+void ContentChunker::configure(size_t memory_budget, size_t spill_bytes, const std::string& spill_dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_budget_ = memory_budget;
+    
+    // Only a scratch file without spilled items can be replaced
+    bool busy = spill_ && spill_->used > 0;
+    if (!busy) {
+        spill_.reset();
+        if (spill_bytes > 0) {
+            std::unique_ptr<SpillFile> file(new SpillFile());
+            if (file->open(spill_dir, spill_bytes)) {
+                spill_.swap(file);
+            }
+        }
+    }
+    
+    LOG_DEBUG("[ContentChunker] Memory budget %zu bytes, spill file %zu bytes",
+              memory_budget_, spill_ ? spill_->capacity : static_cast<size_t>(0));
+    enforce_budget();
+}
 
 std::string ContentChunker::store(const std::string& content, const std::string& source, size_t chunk_size) {
-    ChunkedContent cc;
-    cc.id = "chunk_" + std::to_string(next_id_++);
-    cc.full_content = content;
-    cc.source = source;
-    cc.chunk_size = chunk_size;
-    cc.total_chunks = (content.size() + chunk_size - 1) / chunk_size;
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    storage_[cc.id] = cc;
+    std::string id = "chunk_" + std::to_string(next_id_++);
+    Item& item = storage_[id];
+    item.id = id;
+    item.scope = current_chunk_scope();
+    item.source = source;
+    item.chunk_size = chunk_size;
+    item.total_chunks = (content.size() + chunk_size - 1) / chunk_size;
+    item.size = content.size();
+    item.content = content;
+    lru_.push_front(id);
+    item.lru = lru_.begin();
+    memory_bytes_ += item.size;
     
     LOG_DEBUG("[ContentChunker] Stored content '%s' from '%s': %zu bytes, %zu chunks",
-              cc.id.c_str(), source.c_str(), content.size(), cc.total_chunks);
+              id.c_str(), source.c_str(), item.size, item.total_chunks);
     
-    return cc.id;
+    enforce_budget();
+    return id;
 }
 
-std::string ContentChunker::get_chunk(const std::string& id, size_t chunk_index) const {
-    std::map<std::string, ChunkedContent>::const_iterator it = storage_.find(id);
+std::string ContentChunker::store(const FileSlice& slice, const std::string& source, size_t chunk_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    std::string id = "chunk_" + std::to_string(next_id_++);
+    Item& item = storage_[id];
+    item.id = id;
+    item.scope = current_chunk_scope();
+    item.source = source;
+    item.chunk_size = chunk_size;
+    item.total_chunks = (slice.length + chunk_size - 1) / chunk_size;
+    item.size = slice.length;
+    item.file = slice;
+    lru_.push_front(id);
+    item.lru = lru_.begin();
+    
+    LOG_DEBUG("[ContentChunker] Stored '%s' from '%s': %zu bytes of %s, %zu chunks",
+              id.c_str(), source.c_str(), item.size, slice.file->path().c_str(), item.total_chunks);
+    
+    enforce_budget();
+    return id;
+}
+
+const ContentChunker::Item* ContentChunker::find(const std::string& id) const {
+    ItemMap::const_iterator it = storage_.find(id);
     if (it == storage_.end()) {
-        return "Error: Content ID '" + id + "' not found.";
+        return nullptr;
+    }
+    const std::string& scope = current_chunk_scope();
+    if (!scope.empty() && it->second.scope != scope) {
+        return nullptr;     // Another session's content
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return &it->second;
+}
+
+std::string ContentChunker::content_of(const Item& item, size_t pos, size_t len) const {
+    if (pos >= item.size) return std::string();
+    len = std::min(len, item.size - pos);
+    if (item.file.file) {
+        // Reading a mapping of a file cut short would fault
+        if (!item.file.file->intact()) return std::string();
+        return std::string(item.file.data() + pos, len);
+    }
+    if (item.spilled) {
+        return std::string(spill_->base + item.spill_offset + pos, len);
+    }
+    return item.content.substr(pos, len);
+}
+
+void ContentChunker::erase(ItemMap::iterator it) {
+    Item& item = it->second;
+    if (item.spilled) {
+        spill_->release(item.spill_offset, item.size);
+    } else if (!item.file.file) {
+        memory_bytes_ -= item.size;
+    }
+    if (item.index) {
+        memory_bytes_ -= item.index->bytes();
+    }
+    lru_.erase(item.lru);
+    storage_.erase(it);
+}
+
+void ContentChunker::enforce_budget() {
+    // The newest item always stays resident, even if it alone is over budget
+    std::list<std::string>::iterator cursor = lru_.end();
+    while (memory_bytes_ > memory_budget_ && cursor != lru_.begin()) {
+        --cursor;
+        if (cursor == lru_.begin()) break;
+        
+        ItemMap::iterator it = storage_.find(*cursor);
+        Item& item = it->second;
+        
+        // Indexes are cheapest to give up: they are rebuilt on the next search
+        if (item.index) {
+            memory_bytes_ -= item.index->bytes();
+            item.index.reset();
+        }
+        if (item.spilled || item.file.file) continue;
+        
+        size_t offset = 0;
+        bool placed = spill_ && item.size <= spill_->capacity && spill_->allocate(item.size, offset);
+        
+        // Make room in the scratch file by dropping the oldest spilled items
+        std::list<std::string>::iterator victim = lru_.end();
+        while (spill_ && !placed && item.size <= spill_->capacity && victim != lru_.begin()) {
+            --victim;
+            ItemMap::iterator v = storage_.find(*victim);
+            if (!v->second.spilled) continue;
+            std::list<std::string>::iterator next = victim;
+            ++next;
+            LOG_DEBUG("[ContentChunker] Dropping spilled '%s' (%zu bytes)", victim->c_str(), v->second.size);
+            erase(v);
+            counters_.evictions++;
+            victim = next;
+            placed = spill_->allocate(item.size, offset);
+        }
+        
+        std::list<std::string>::iterator next = cursor;
+        ++next;
+        if (placed) {
+            spill_->write(offset, item.content);
+            std::string().swap(item.content);
+            item.spilled = true;
+            item.spill_offset = offset;
+            memory_bytes_ -= item.size;
+            counters_.spills++;
+            LOG_DEBUG("[ContentChunker] Spilled '%s' (%zu bytes) to scratch file", item.id.c_str(), item.size);
+        } else {
+            LOG_DEBUG("[ContentChunker] Dropping '%s' (%zu bytes) over memory budget", item.id.c_str(), item.size);
+            erase(it);
+            counters_.evictions++;
+        }
+        cursor = next;
+    }
+}
+
+std::string ContentChunker::get_chunk(const std::string& id, size_t chunk_index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Item* item = find(id);
+    if (!item) {
+        return "Error: Content ID '" + id + "' not found (it may have expired).";
     }
     
-    const ChunkedContent& cc = it->second;
+    const Item& cc = *item;
     if (chunk_index >= cc.total_chunks) {
         return "Error: Chunk index " + std::to_string(chunk_index) + 
                " out of range. Total chunks: " + std::to_string(cc.total_chunks);
     }
     
     size_t start = chunk_index * cc.chunk_size;
-    size_t len = std::min(cc.chunk_size, cc.full_content.size() - start);
     
     std::ostringstream oss;
     oss << "[Chunk " << (chunk_index + 1) << "/" << cc.total_chunks 
         << " from " << cc.source << "]\n";
-    oss << cc.full_content.substr(start, len);
+    oss << content_of(cc, start, cc.chunk_size);
     
     if (chunk_index + 1 < cc.total_chunks) {
         oss << "\n\n[Use content_chunk tool with id=\"" << id 
@@ -70,88 +486,200 @@ std::string ContentChunker::get_chunk(const std::string& id, size_t chunk_index)
 }
 
 std::string ContentChunker::get_info(const std::string& id) const {
-    std::map<std::string, ChunkedContent>::const_iterator it = storage_.find(id);
-    if (it == storage_.end()) {
-        return "Content ID '" + id + "' not found.";
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Item* item = find(id);
+    if (!item) {
+        return "Content ID '" + id + "' not found (it may have expired).";
     }
     
-    const ChunkedContent& cc = it->second;
+    const Item& cc = *item;
     std::ostringstream oss;
     oss << "Content ID: " << cc.id << "\n";
     oss << "Source: " << cc.source << "\n";
-    oss << "Total size: " << cc.full_content.size() << " characters\n";
+    oss << "Total size: " << cc.size << " characters\n";
     oss << "Total chunks: " << cc.total_chunks << " (each ~" << cc.chunk_size << " chars)\n";
     
     return oss.str();
 }
 
-std::string ContentChunker::search(const std::string& id, const std::string& query, size_t context_chars) const {
-    std::map<std::string, ChunkedContent>::const_iterator it = storage_.find(id);
-    if (it == storage_.end()) {
-        return "Content ID '" + id + "' not found.";
+std::string ContentChunker::search(const std::string& id, const std::string& query, size_t context_chars) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Item* found = find(id);
+    if (!found) {
+        return "Content ID '" + id + "' not found (it may have expired).";
     }
+    Item& item = storage_.find(id)->second;
     
-    const ChunkedContent& cc = it->second;
-    std::string content_lower = cc.full_content;
-    std::string query_lower = query;
-    
-    // Convert to lowercase for case-insensitive search
-    for (size_t i = 0; i < content_lower.size(); ++i) {
-        content_lower[i] = tolower(content_lower[i]);
+    std::vector<std::string> terms = parse_search_terms(query);
+    if (terms.empty()) {
+        return "Error: Empty search query.";
     }
-    for (size_t i = 0; i < query_lower.size(); ++i) {
-        query_lower[i] = tolower(query_lower[i]);
+    
+    if (!item.index) {
+        item.index.reset(new SearchIndex(content_of(item, 0, item.size)));
+        memory_bytes_ += item.index->bytes();
+        LOG_DEBUG("[ContentChunker] Indexed '%s' for search (%zu bytes)", item.id.c_str(), item.index->bytes());
     }
     
-    std::vector<size_t> matches;
-    size_t pos = 0;
-    while ((pos = content_lower.find(query_lower, pos)) != std::string::npos) {
-        matches.push_back(pos);
-        pos += query_lower.size();
-        if (matches.size() >= 10) break; // Limit matches
+    // All occurrences of all terms in document order
+    std::vector<std::pair<size_t, size_t> > hits;     // Position, term
+    std::vector<size_t> term_hits(terms.size(), 0);
+    for (size_t t = 0; t < terms.size(); ++t) {
+        std::vector<size_t> positions = item.index->find_all(terms[t]);
+        term_hits[t] = positions.size();
+        for (size_t i = 0; i < positions.size(); ++i) {
+            hits.push_back(std::make_pair(positions[i], t));
+        }
     }
     
-    if (matches.empty()) {
+    if (hits.empty()) {
+        enforce_budget();
         return "No matches found for '" + query + "' in content.";
     }
+    std::sort(hits.begin(), hits.end());
+    
+    // Score each hit by the distinct terms (then total hits) within
+    // context_chars of it
+    struct Passage {
+        size_t pos;
+        size_t term;
+        size_t distinct;
+        size_t total;
+        bool operator<(const Passage& o) const {
+            if (distinct != o.distinct) return distinct > o.distinct;
+            if (total != o.total) return total > o.total;
+            return pos < o.pos;
+        }
+    };
+    
+    std::vector<Passage> passages;
+    passages.reserve(hits.size());
+    std::vector<size_t> in_window(terms.size(), 0);
+    size_t distinct = 0, lo = 0, hi = 0;
+    for (size_t i = 0; i < hits.size(); ++i) {
+        size_t pos = hits[i].first;
+        while (hi < hits.size() && hits[hi].first <= pos + context_chars) {
+            if (in_window[hits[hi].second]++ == 0) distinct++;
+            hi++;
+        }
+        while (hits[lo].first + context_chars < pos) {
+            if (--in_window[hits[lo].second] == 0) distinct--;
+            lo++;
+        }
+        Passage p;
+        p.pos = pos;
+        p.term = hits[i].second;
+        p.distinct = distinct;
+        p.total = hi - lo;
+        passages.push_back(p);
+    }
+    
+    // One term keeps document order; several rank by how many occur together
+    const size_t max_matches = 10;
+    std::vector<Passage> shown;
+    if (terms.size() == 1) {
+        for (size_t i = 0; i < passages.size() && shown.size() < max_matches; ++i) {
+            shown.push_back(passages[i]);
+        }
+    } else {
+        std::sort(passages.begin(), passages.end());
+        for (size_t i = 0; i < passages.size() && shown.size() < max_matches; ++i) {
+            bool overlaps = false;
+            for (size_t j = 0; j < shown.size() && !overlaps; ++j) {
+                size_t a = std::min(passages[i].pos, shown[j].pos);
+                size_t b = std::max(passages[i].pos, shown[j].pos);
+                overlaps = (b - a) <= context_chars;
+            }
+            if (!overlaps) shown.push_back(passages[i]);
+        }
+    }
     
     std::ostringstream oss;
-    oss << "Found " << matches.size() << " match(es) for '" << query << "':\n\n";
+    oss << "Found " << hits.size() << " match(es) for '" << query << "'";
+    if (terms.size() > 1) {
+        oss << " (";
+        for (size_t t = 0; t < terms.size(); ++t) {
+            oss << (t ? ", " : "") << "'" << terms[t] << "': " << term_hits[t];
+        }
+        oss << "), best passages first";
+    }
+    oss << ":\n\n";
     
-    for (size_t i = 0; i < matches.size(); ++i) {
-        size_t match_pos = matches[i];
-        size_t start = (match_pos > context_chars) ? (match_pos - context_chars) : 0;
-        size_t end = std::min(match_pos + query.size() + context_chars, cc.full_content.size());
+    for (size_t i = 0; i < shown.size(); ++i) {
+        const Passage& p = shown[i];
+        size_t start = (p.pos > context_chars) ? (p.pos - context_chars) : 0;
+        size_t end = std::min(p.pos + terms[p.term].size() + context_chars, item.size);
         
-        oss << "--- Match " << (i + 1) << " (at position " << match_pos << ") ---\n";
+        oss << "--- Match " << (i + 1) << " (at position " << p.pos;
+        if (terms.size() > 1) {
+            oss << ", " << p.distinct << "/" << terms.size() << " terms";
+        }
+        oss << ") ---\n";
         if (start > 0) oss << "...";
-        oss << cc.full_content.substr(start, end - start);
-        if (end < cc.full_content.size()) oss << "...";
+        oss << content_of(item, start, end - start);
+        if (end < item.size) oss << "...";
         oss << "\n\n";
     }
     
+    enforce_budget();
     return oss.str();
 }
 
 bool ContentChunker::has(const std::string& id) const {
-    return storage_.find(id) != storage_.end();
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find(id) != nullptr;
 }
 
 void ContentChunker::clear() {
-    storage_.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!storage_.empty()) {
+        erase(storage_.begin());
+    }
     LOG_DEBUG("[ContentChunker] Cleared all stored content");
 }
 
 void ContentChunker::remove(const std::string& id) {
-    storage_.erase(id);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (find(id)) {
+        erase(storage_.find(id));
+    }
+}
+
+void ContentChunker::remove_scope(const std::string& scope) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t removed = 0;
+    ItemMap::iterator it = storage_.begin();
+    while (it != storage_.end()) {
+        ItemMap::iterator next = it;
+        ++next;
+        if (it->second.scope == scope) {
+            erase(it);
+            removed++;
+        }
+        it = next;
+    }
+    if (removed > 0) {
+        LOG_DEBUG("[ContentChunker] Removed %zu item(s) of '%s'", removed, scope.c_str());
+    }
 }
 
 size_t ContentChunker::get_total_chunks(const std::string& id) const {
-    std::map<std::string, ChunkedContent>::const_iterator it = storage_.find(id);
-    if (it == storage_.end()) {
-        return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Item* item = find(id);
+    return item ? item->total_chunks : 0;
+}
+
+ContentChunker::Stats ContentChunker::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = counters_;
+    s.items = storage_.size();
+    s.memory_bytes = memory_bytes_;
+    for (ItemMap::const_iterator it = storage_.begin(); it != storage_.end(); ++it) {
+        if (it->second.spilled) s.spilled_items++;
+        if (it->second.file.file) s.mapped_items++;
     }
-    return it->second.total_chunks;
+    s.spill_bytes = spill_ ? spill_->used : 0;
+    return s;
 }
 
 // ============================================================================
@@ -365,13 +893,41 @@ static bool recover_params_from_raw(const AgentTool& tool, const std::string& ra
 // Agent Implementation
 // ============================================================================
 
-Agent::Agent() {}
+Agent::Agent()
+    : max_parallel_tools_(4), early_tool_start_(true), native_tools_(false), budget_(nullptr),
+      tools_version_(1) {
+    tools_prompt_version_[0] = tools_prompt_version_[1] = 0;
+}
 
-Agent::~Agent() {}
+Agent::~Agent() {
+    if (tool_pool_) {
+        tool_pool_->shutdown();
+    }
+}
 
 void Agent::register_tool(const AgentTool& tool) {
     LOG_DEBUG("[Agent] Registering tool: %s", tool.name.c_str());
+    std::lock_guard<std::mutex> lock(prompt_mutex_);
     tools_[tool.name] = tool;
+    tools_version_++;
+}
+
+SharedPrompt Agent::tools_prompt(bool native) const {
+    size_t mode = native ? 1 : 0;
+    std::lock_guard<std::mutex> lock(prompt_mutex_);
+    if (!tools_prompt_cache_[mode] || tools_prompt_version_[mode] != tools_version_) {
+        tools_prompt_cache_[mode] = std::make_shared<const std::string>(
+            native ? build_native_tools_prompt() : build_tools_prompt());
+        tools_prompt_version_[mode] = tools_version_;
+        LOG_DEBUG("[Agent] Built %s tools prompt v%llu (%zu chars)", native ? "native" : "text",
+                  static_cast<unsigned long long>(tools_version_), tools_prompt_cache_[mode]->size());
+    }
+    return tools_prompt_cache_[mode];
+}
+
+uint64_t Agent::tools_version() const {
+    std::lock_guard<std::mutex> lock(prompt_mutex_);
+    return tools_version_;
 }
 
 void Agent::register_tool(const std::string& name, const std::string& desc, ToolExecutor executor) {
@@ -379,6 +935,98 @@ void Agent::register_tool(const std::string& name, const std::string& desc, Tool
     register_tool(tool);
 }
 
+namespace {
+
+// Tool usage hints shared by the prompt and native tool modes
+void append_tool_guidance(std::ostringstream& oss, bool has_browser, bool has_content_chunk) {
+    if (has_browser) {
+        oss << "### Web Fetching\n";
+        oss << "When you need to fetch or read web content, use 'browser_extract_text' for readable text,\n";
+        oss << "'browser_fetch' for raw HTML, and 'browser_get_links' for links.\n\n";
+    }
+    
+    if (has_content_chunk) {
+        oss << "### Large Content Handling\n";
+        oss << "When a tool returns content too large to fit in context, it will be automatically chunked.\n";
+        oss << "You'll see a message like 'Stored as chunk_N with X chunks'. To access this content:\n";
+        oss << "- Use 'content_chunk' with id and chunk number (0-based) to retrieve specific chunks\n";
+        oss << "- Use 'content_search' with id and query to search within the content\n";
+        oss << "This allows you to work with large web pages, files, or command outputs.\n\n";
+    }
+}
+
+std::string tool_result_text(const std::string& tool_name, bool success, const std::string& body) {
+    return "<tool_result name=\"" + tool_name + "\" success=\"" +
+           (success ? "true" : "false") + "\">\n" + body + "\n</tool_result>";
+}
+
+// Native tool calls in the shape the tool loop works with
+std::vector<ParsedToolCall> native_tool_calls(const std::vector<ToolUse>& uses) {
+    std::vector<ParsedToolCall> calls;
+    for (size_t i = 0; i < uses.size(); ++i) {
+        ParsedToolCall call;
+        call.id = uses[i].id;
+        call.tool_name = uses[i].name;
+        call.params = uses[i].input;
+        call.raw_content = uses[i].input.dump();
+        call.valid = true;
+        calls.push_back(call);
+    }
+    return calls;
+}
+
+} // anonymous namespace
+
+std::vector<ToolSpec> Agent::build_tool_specs() const {
+    std::vector<ToolSpec> specs;
+    for (std::map<std::string, AgentTool>::const_iterator it = tools_.begin();
+         it != tools_.end(); ++it) {
+        const AgentTool& tool = it->second;
+        
+        Json properties = Json::object();
+        Json required = Json::array();
+        for (size_t i = 0; i < tool.params.size(); ++i) {
+            const ToolParamSchema& param = tool.params[i];
+            Json prop = Json::object();
+            prop["type"] = param.type.empty() ? std::string("string") : param.type;
+            prop["description"] = param.description;
+            if (param.type == "array") {
+                prop["items"] = Json::object();
+            }
+            properties[param.name] = prop;
+            if (param.required) {
+                required.push_back(param.name);
+            }
+        }
+        
+        ToolSpec spec;
+        spec.name = tool.name;
+        spec.description = tool.description;
+        spec.input_schema = Json::object();
+        spec.input_schema["type"] = "object";
+        spec.input_schema["properties"] = properties;
+        if (!required.empty()) {
+            spec.input_schema["required"] = required;
+        }
+        specs.push_back(spec);
+    }
+    return specs;
+}
+
+std::string Agent::build_native_tools_prompt() const {
+    bool has_browser = false;
+    bool has_content_chunk = false;
+    for (std::map<std::string, AgentTool>::const_iterator it = tools_.begin();
+         it != tools_.end(); ++it) {
+        if (it->first.find("browser") != std::string::npos) has_browser = true;
+        if (it->first == "content_chunk" || it->first == "content_search") has_content_chunk = true;
+    }
+    
+    std::ostringstream oss;
+    append_tool_guidance(oss, has_browser, has_content_chunk);
+    return oss.str();
+}
+
 std::string Agent::build_tools_prompt() const {
     if (tools_.empty()) {
         return "";
@@ -442,20 +1090,7 @@ std::string Agent::build_tools_prompt() const {
     oss << "CRITICAL: Use single quotes in bash commands to avoid escaping issues.\n";
     oss << "CRITICAL: JSON params must be valid - no extra escaping needed.\n\n";
 
-    if (has_browser) {
-        oss << "### Web Fetching\n";
-        oss << "When you need to fetch or read web content, use 'browser_extract_text' for readable text,\n";
-        oss << "'browser_fetch' for raw HTML, and 'browser_get_links' for links.\n\n";
-    }
-    
-    if (has_content_chunk) {
-        oss << "### Large Content Handling\n";
-        oss << "When a tool returns content too large to fit in context, it will be automatically chunked.\n";
-        oss << "You'll see a message like 'Stored as chunk_N with X chunks'. To access this content:\n";
-        oss << "- Use 'content_chunk' with id and chunk number (0-based) to retrieve specific chunks\n";
-        oss << "- Use 'content_search' with id and query to search within the content\n";
-        oss << "This allows you to work with large web pages, files, or command outputs.\n\n";
-    }
+    append_tool_guidance(oss, has_browser, has_content_chunk);
     
     oss << "### Tools:\n\n";
     
@@ -677,7 +1312,8 @@ std::vector<ParsedToolCall> Agent::parse_tool_calls(const std::string& response)
     return calls;
 }
 
-AgentToolResult Agent::execute_tool(const ParsedToolCall& call) {
+const AgentTool* Agent::resolve_tool(const ParsedToolCall& call, ParsedToolCall& effective,
+                                     AgentToolResult& failure) {
     // Check for common mistakes
     if (call.tool_name == "tool_call") {
         std::string hint = "ERROR: Used 'tool_call' as name. Must use actual tool name.\n";
@@ -689,7 +1325,8 @@ AgentToolResult Agent::execute_tool(const ParsedToolCall& call) {
             first = false;
         }
         hint += "\nExample: <tool_call name=\"bash\">{\"command\":\"ls\"}</tool_call>";
-        return AgentToolResult::fail(hint);
+        failure = AgentToolResult::fail(hint);
+        return NULL;
     }
     
     std::map<std::string, AgentTool>::iterator it = tools_.find(call.tool_name);
@@ -699,27 +1336,37 @@ AgentToolResult Agent::execute_tool(const ParsedToolCall& call) {
             if (t != tools_.begin()) error += ", ";
             error += t->first;
         }
-        return AgentToolResult::fail(error);
+        failure = AgentToolResult::fail(error);
+        return NULL;
     }
 
-    ParsedToolCall effective_call = call;
-    if (!effective_call.valid) {
+    effective = call;
+    if (!effective.valid) {
         Json recovered;
         std::string recover_error;
-        if (recover_params_from_raw(it->second, effective_call.raw_content, recovered, recover_error)) {
-            effective_call.params = recovered;
-            effective_call.valid = true;
+        if (recover_params_from_raw(it->second, effective.raw_content, recovered, recover_error)) {
+            effective.params = recovered;
+            effective.valid = true;
             LOG_DEBUG("[Agent] Recovered tool params for '%s' from raw content", call.tool_name.c_str());
         } else {
-            return AgentToolResult::fail("Invalid tool call: " + (recover_error.empty() ? call.parse_error : recover_error));
+            failure = AgentToolResult::fail("Invalid tool call: " + (recover_error.empty() ? call.parse_error : recover_error));
+            return NULL;
         }
     }
     
     LOG_INFO("[Agent] Executing tool: %s", call.tool_name.c_str());
-    LOG_DEBUG("[Agent] Tool params: %s", effective_call.params.dump().c_str());
+    LOG_DEBUG("[Agent] Tool params: %s", effective.params.dump().c_str());
+    return &it->second;
+}
+
+AgentToolResult Agent::execute_tool(const ParsedToolCall& call) {
+    ParsedToolCall effective_call;
+    AgentToolResult failure;
+    const AgentTool* tool = resolve_tool(call, effective_call, failure);
+    if (!tool) return failure;
     
     try {
-        AgentToolResult result = it->second.execute(effective_call.params);
+        AgentToolResult result = tool->execute(effective_call.params);
         LOG_DEBUG("[Agent] Tool %s result: success=%s, output_len=%zu",
                   call.tool_name.c_str(), result.success ? "yes" : "no", 
                   result.output.size());
@@ -730,14 +1377,64 @@ AgentToolResult Agent::execute_tool(const ParsedToolCall& call) {
     }
 }
 
+void Agent::execute_tool_async(const ParsedToolCall& call, ToolDoneCallback done) {
+    ParsedToolCall effective_call;
+    AgentToolResult failure;
+    const AgentTool* tool = resolve_tool(call, effective_call, failure);
+    if (!tool) {
+        done(failure);
+        return;
+    }
+    
+    std::string tool_name = call.tool_name;
+    AgentToolResult result;
+    try {
+        if (tool->execute_async) {
+            tool->execute_async(effective_call.params, [tool_name, done](const AgentToolResult& r) {
+                LOG_DEBUG("[Agent] Tool %s result: success=%s, output_len=%zu",
+                          tool_name.c_str(), r.success ? "yes" : "no", r.output.size());
+                done(r);
+            });
+            return;
+        }
+        result = tool->execute(effective_call.params);
+    } catch (const std::exception& e) {
+        LOG_ERROR("[Agent] Tool %s threw exception: %s", tool_name.c_str(), e.what());
+        result = AgentToolResult::fail(std::string("Tool exception: ") + e.what());
+    }
+    done(result);
+}
+
 std::string Agent::format_tool_result(const std::string& tool_name, const AgentToolResult& result) {
+    return tool_result_text(tool_name, result.success, format_tool_output(tool_name, result));
+}
+
+std::string Agent::format_tool_output(const std::string& tool_name, const AgentToolResult& result) {
     std::ostringstream oss;
-    oss << "<tool_result name=\"" << tool_name << "\" success=\"" 
-        << (result.success ? "true" : "false") << "\">\n";
     
     if (result.success) {
-        // Check if the result is too large and should be chunked
-        if (config_.auto_chunk_large_results && result.output.size() > config_.max_tool_result_size) {
+        // A file range stays in its mapping; the chunker refers to it
+        if (config_.auto_chunk_large_results && !result.full.empty() &&
+            result.full.length > config_.max_tool_result_size) {
+            std::string chunk_id = chunker_.store(result.full, tool_name);
+            size_t total_chunks = chunker_.get_total_chunks(chunk_id);
+            
+            LOG_INFO("[Agent] Large file result (%zu bytes) chunked as '%s' (%zu chunks, mapped)",
+                     result.full.length, chunk_id.c_str(), total_chunks);
+            
+            oss << "Content too large (" << result.full.length << " characters). "
+                << "Stored as '" << chunk_id << "' with " << total_chunks << " chunks.\n\n";
+            
+            size_t preview_size = std::min(config_.max_tool_result_size / 2, result.full.length);
+            oss << "=== Preview (first " << preview_size << " characters) ===\n";
+            oss.write(result.full.data(), preview_size);
+            oss << "\n... [content truncated] ...\n";
+            
+            oss << "\n\n=== To access full content ===\n";
+            oss << "Use 'content_chunk' tool with id=\"" << chunk_id << "\" and chunk=0 to get first chunk.\n";
+            oss << "Use 'content_search' tool with id=\"" << chunk_id << "\" and query=\"your search\" to find specific content.\n";
+            oss << "Total chunks available: " << total_chunks;
+        } else if (config_.auto_chunk_large_results && result.output.size() > config_.max_tool_result_size) {
             // Store the large content in the chunker
             std::string chunk_id = chunker_.store(result.output, tool_name);
             size_t total_chunks = chunker_.get_total_chunks(chunk_id);
@@ -768,7 +1465,6 @@ std::string Agent::format_tool_result(const std::string& tool_name, const AgentT
         oss << "Error: " << result.error;
     }
     
-    oss << "\n</tool_result>";
     return oss.str();
 }
 
@@ -831,49 +1527,8 @@ bool Agent::try_truncate_history(std::vector<ConversationMessage>& history) cons
     // Strategy 1: Find and truncate large tool_result messages
     bool truncated_something = false;
     for (size_t i = 0; i < history.size(); ++i) {
-        ConversationMessage& msg = history[i];
-        if (msg.role == MessageRole::USER && msg.content.find("<tool_result") != std::string::npos) {
-            // This is a tool result message - check if it's large
-            if (msg.content.size() > 10000) {
-                // Truncate to a summary
-                size_t result_start = msg.content.find("<tool_result");
-                size_t result_end = msg.content.find("</tool_result>");
-                if (result_end != std::string::npos) {
-                    // Extract tool name
-                    std::string tool_name = "unknown";
-                    size_t name_start = msg.content.find("name=\"", result_start);
-                    if (name_start != std::string::npos) {
-                        name_start += 6;
-                        size_t name_end = msg.content.find("\"", name_start);
-                        if (name_end != std::string::npos) {
-                            tool_name = msg.content.substr(name_start, name_end - name_start);
-                        }
-                    }
-                    
-                    // Create truncated version
-                    std::ostringstream truncated;
-                    truncated << "<tool_result name=\"" << tool_name << "\" success=\"true\">\n";
-                    truncated << "[Content truncated to fit context window - original was " 
-                              << msg.content.size() << " characters]\n";
-                    
-                    // Keep first 2000 chars of content
-                    size_t content_start = msg.content.find(">", result_start) + 1;
-                    size_t content_len = result_end - content_start;
-                    if (content_len > 2000) {
-                        truncated << msg.content.substr(content_start, 2000);
-                        truncated << "\n... [truncated] ...";
-                    } else {
-                        truncated << msg.content.substr(content_start, content_len);
-                    }
-                    truncated << "\n</tool_result>";
-                    
-                    LOG_DEBUG("[Agent] Truncated tool result for '%s' from %zu to %zu chars",
-                              tool_name.c_str(), msg.content.size(), truncated.str().size());
-                    
-                    msg.content = truncated.str();
-                    truncated_something = true;
-                }
-            }
+        if (truncate_tool_result(history[i])) {
+            truncated_something = true;
         }
     }
     
@@ -915,234 +1570,1016 @@ bool Agent::try_truncate_history(std::vector<ConversationMessage>& history) cons
     return false;
 }
 
-AgentResult Agent::run(
-    AIPlugin* ai,
-    const std::string& user_message,
-    std::vector<ConversationMessage>& history,
-    const std::string& system_prompt,
-    const AgentConfig& config) {
+bool Agent::truncate_tool_result(ConversationMessage& msg) {
+    if (msg.role != MessageRole::USER || msg.content.find("<tool_result") == std::string::npos) {
+        return false;
+    }
+    // This is a tool result message - check if it's large
+    if (msg.content.size() <= 10000) {
+        return false;
+    }
+    
+    // Truncate to a summary
+    size_t result_start = msg.content.find("<tool_result");
+    size_t result_end = msg.content.find("</tool_result>");
+    if (result_end == std::string::npos) {
+        return false;
+    }
+    
+    // Extract tool name
+    std::string tool_name = "unknown";
+    size_t name_start = msg.content.find("name=\"", result_start);
+    if (name_start != std::string::npos) {
+        name_start += 6;
+        size_t name_end = msg.content.find("\"", name_start);
+        if (name_end != std::string::npos) {
+            tool_name = msg.content.substr(name_start, name_end - name_start);
+        }
+    }
+    
+    // Create truncated version
+    std::ostringstream truncated;
+    truncated << "<tool_result name=\"" << tool_name << "\" success=\"true\">\n";
+    truncated << "[Content truncated to fit context window - original was " 
+              << msg.content.size() << " characters]\n";
+    
+    // Keep first 2000 chars of content
+    size_t content_start = msg.content.find(">", result_start) + 1;
+    size_t content_len = result_end - content_start;
+    if (content_len > 2000) {
+        truncated << msg.content.substr(content_start, 2000);
+        truncated << "\n... [truncated] ...";
+    } else {
+        truncated << msg.content.substr(content_start, content_len);
+    }
+    truncated << "\n</tool_result>";
+    
+    LOG_DEBUG("[Agent] Truncated tool result for '%s' from %zu to %zu chars",
+              tool_name.c_str(), msg.content.size(), truncated.str().size());
+    
+    msg.content = SharedText(truncated.str());
+    
+    // Native results carry their own copy of the output
+    for (size_t i = 0; i < msg.tool_results.size(); ++i) {
+        SharedText& content = msg.tool_results[i].content;
+        if (content.size() > 2000) {
+            content = "[Content truncated to fit context window - original was " +
+                      std::to_string(content.size()) + " characters]\n" +
+                      content.substr(0, 2000) + "\n... [truncated] ...";
+        }
+    }
+    return true;
+}
+
+int Agent::fit_history_to_budget(AIPlugin* ai,
+                                 const CompletionOptions& opts,
+                                 std::vector<ConversationMessage>& history) const {
+    int window = ai->context_window(opts.model);
+    if (window <= 0) {
+        return 0;
+    }
+    
+    TokenEstimator estimator = ai->token_estimator();
+    int system_tokens = estimator.count(opts.tools_prompt) + estimator.count(opts.system_prompt);
+    int history_tokens = estimator.count(history);
+    
+    // Leave room for the reply plus a margin for estimation error
+    int budget = window - opts.max_tokens - window / 20 - system_tokens;
+    if (history_tokens <= budget) {
+        return system_tokens + history_tokens;
+    }
+    
+    LOG_INFO("[Agent] History estimated at %d tokens, budget %d - trimming before request",
+             history_tokens, budget);
+    
+    // Strategy 1: shrink large tool results, oldest first, until it fits
+    for (size_t i = 0; i + 1 < history.size() && history_tokens > budget; ++i) {
+        int before = estimator.count(history[i]);
+        if (truncate_tool_result(history[i])) {
+            history_tokens += estimator.count(history[i]) - before;
+        }
+    }
+    
+    // Strategy 2: drop the oldest messages, keeping the first (original
+    // request) and the newest one
+    const std::string note =
+        "[Note: Earlier conversation history was truncated to fit context window. "
+        "Please continue based on available context.]";
+    size_t keep_head = 1;
+    bool noted = history.size() > 1 && history[1].content == note;
+    if (noted) keep_head = 2;
+    
+    size_t removed = 0;
+    while (history_tokens > budget && history.size() > keep_head + 1) {
+        if (!noted) {
+            history.insert(history.begin() + 1, ConversationMessage::user(note));
+            history_tokens += estimator.count(history[1]);
+            noted = true;
+            keep_head = 2;
+            continue;
+        }
+        history_tokens -= estimator.count(history[keep_head]);
+        history.erase(history.begin() + keep_head);
+        removed++;
+    }
+    
+    if (removed > 0) {
+        LOG_INFO("[Agent] Dropped %zu old messages, history now ~%d tokens", removed, history_tokens);
+    }
+    if (history_tokens > budget) {
+        LOG_WARN("[Agent] History still ~%d tokens over budget after trimming",
+                 history_tokens - budget);
+    }
+    return system_tokens + history_tokens;
+}
+
+// ============================================================================
+// Agentic Loop (resumable state machine)
+// ============================================================================
+
+// A parallel-safe tool call started before the reply finished streaming
+struct Agent::EarlyToolCall {
+    typedef std::function<void(const AgentToolResult&)> ResultCallback;
+    
+    ParsedToolCall call;
+    bool claimed;               // Matched to a call of the final reply
+    int64_t started_us;         // AgentTrace::clock_us(), set before complete()
+    int64_t finished_us;
+    
+    EarlyToolCall() : claimed(false), started_us(0), finished_us(0), done_(false) {}
+    
+    void complete(const AgentToolResult& r) {
+        ResultCallback cb;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            result_ = r;
+            done_ = true;
+            cb.swap(then_);
+        }
+        if (cb) cb(result_);
+    }
+    
+    // Runs cb with the result, right away if the call already finished
+    void on_result(ResultCallback cb) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!done_) {
+                then_ = cb;
+                return;
+            }
+        }
+        cb(result_);
+    }
+    
+private:
+    std::mutex mutex_;
+    bool done_;
+    AgentToolResult result_;
+    ResultCallback then_;
+};
+
+// Watches one streamed reply for complete <tool_call>...</tool_call> elements.
+// Fed from the HTTP thread; read by the turn only after the reply completed.
+struct Agent::ToolScanner {
+    std::string text;           // Unscanned tail of the reply
+    std::string scope;          // ContentChunker scope of the turn
+    std::vector<EarlyToolCallPtr> started;
+};
+
+struct Agent::Turn {
+    AIPlugin* ai;
+    std::vector<ConversationMessage>* history;
+    SharedText user_message;        // As pushed into history; found again by identity
+    SharedPrompt tools_prompt;      // Kept apart from system_prompt for prompt caching
+    SharedPrompt system_prompt;
+    AgentConfig config;
+    AgentCallback on_done;
+    AgentExecutor executor;
     
     AgentResult result;
-    result.iterations = 0;
-    result.tool_calls_made = 0;
+    int consecutive_errors;
+    int token_limit_retries;
+    int rate_limit_retries;
+    int prompt_estimate;            // Estimated prompt tokens of the last request
+    std::string accumulated_response;
+    std::shared_ptr<ToolScanner> scanner;   // Set while the current reply streams
+    bool native_tools;                      // Tools go through the provider's tool-use API
+    std::vector<ToolSpec> tool_specs;
+    
+    Turn() : ai(nullptr), history(nullptr), consecutive_errors(0), token_limit_retries(0),
+             rate_limit_retries(0), prompt_estimate(0), native_tools(false) {}
+    
+    // Take a failed turn back out of the history: its message and what
+    // its iterations appended. Not assumed to be the last message, nor at
+    // its original index (history truncation may have moved it).
+    void drop_user_message() {
+        std::vector<ConversationMessage>& h = *history;
+        for (size_t i = h.size(); i-- > 0; ) {
+            if (h[i].role == MessageRole::USER && h[i].content.data() == user_message.data()) {
+                h.erase(h.begin() + static_cast<std::ptrdiff_t>(i), h.end());
+                return;
+            }
+        }
+    }
+    
+    // Time spent waiting for the executor shows up as a queue span
+    void dispatch(std::function<void()> fn) {
+        if (executor) {
+            int64_t queued = AgentTrace::clock_us();
+            AgentTrace* trace = &result.trace;
+            int iteration = result.iterations;
+            executor([fn, queued, trace, iteration] {
+                trace->add("queue", "resume", queued, AgentTrace::clock_us()).iteration = iteration;
+                fn();
+            });
+        } else {
+            fn();
+        }
+    }
+};
+
+struct Agent::ToolBatch {
+    std::vector<ParsedToolCall> calls;
+    std::vector<AgentToolResult> results;   // Same order as calls
+    std::vector<EarlyToolCallPtr> early;    // Per call: started while streaming, or null
+    std::vector<int64_t> started_us;        // Per call: AgentTrace::clock_us() run times
+    std::vector<int64_t> finished_us;
+    std::string response;                   // AI response the calls came from
+    bool native;                            // Calls came as native tool_use blocks
+    size_t next;                            // First call not started yet
+    std::atomic<size_t> running;            // Calls left in the current parallel group
+    
+    ToolBatch() : native(false), next(0), running(0) {}
+};
+
+namespace {
+const int max_token_limit_retries = 2;
+const int max_rate_limit_retries = 5;
+const int64_t max_rate_limit_backoff_ms = 64000;
+
+// Delay before retrying a throttled call without a ProviderBudget: the
+// provider's retry-after (seconds) if sent, exponential backoff otherwise
+int64_t rate_limit_delay_ms(const CompletionResult& result, int attempt) {
+    for (std::map<std::string, std::string>::const_iterator it = result.response_headers.begin();
+         it != result.response_headers.end(); ++it) {
+        if (to_lower(it->first) != "retry-after") continue;
+        char* end = nullptr;
+        long long seconds = std::strtoll(it->second.c_str(), &end, 10);
+        if (end != it->second.c_str() && seconds >= 0) {
+            return std::min(max_rate_limit_backoff_ms, static_cast<int64_t>(seconds) * 1000);
+        }
+    }
+    return std::min(max_rate_limit_backoff_ms, static_cast<int64_t>(1000) << std::min(attempt - 1, 6));
+}
+
+// Forwards streamed text to AgentConfig::on_delta but holds back tool calls,
+// which get executed rather than shown. Used by one AI request at a time.
+struct DeltaFilter {
+    StreamCallback out;
+    std::string pending;    // Tail that might be the start of "<tool_call"
+    bool in_tool_call;
+    
+    explicit DeltaFilter(StreamCallback cb) : out(cb), in_tool_call(false) {}
+    
+    void feed(const std::string& chunk) {
+        if (in_tool_call) return;
+        pending += chunk;
+        
+        static const std::string marker = "<tool_call";
+        size_t pos = pending.find(marker);
+        if (pos != std::string::npos) {
+            if (pos > 0) out(pending.substr(0, pos));
+            pending.clear();
+            in_tool_call = true;
+            return;
+        }
+        
+        // Hold back a trailing partial marker until the next chunk decides it
+        size_t hold = pending.size();
+        size_t lt = pending.rfind('<');
+        if (lt != std::string::npos && pending.size() - lt < marker.size() &&
+            marker.compare(0, pending.size() - lt, pending, lt, std::string::npos) == 0) {
+            hold = lt;
+        }
+        if (hold > 0) {
+            out(pending.substr(0, hold));
+            pending.erase(0, hold);
+        }
+    }
+    
+    void flush() {
+        if (!in_tool_call && !pending.empty()) out(pending);
+        pending.clear();
+    }
+};
+
+void report_tool(const AgentConfig& config, const ParsedToolCall& call, const AgentToolResult* result) {
+    if (config.on_tool) config.on_tool(call.tool_name, result);
+}
+}
+
+AgentResult Agent::run(
+    AIPlugin* ai,
+    SharedText user_message,
+    std::vector<ConversationMessage>& history,
+    const std::string& system_prompt,
+    const AgentConfig& config) {
+    return run(ai, std::move(user_message), history, std::make_shared<const std::string>(system_prompt), config);
+}
+
+AgentResult Agent::run(
+    AIPlugin* ai,
+    SharedText user_message,
+    std::vector<ConversationMessage>& history,
+    SharedPrompt system_prompt,
+    const AgentConfig& config) {
+    
+    // Drive the state machine on this thread: continuations are queued to
+    // a local mailbox and executed here, never on the HTTP engine thread
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()> > mailbox;
+    bool done = false;
+    AgentResult out;
+    
+    AgentExecutor executor = [&mutex, &cv, &mailbox](std::function<void()> fn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        mailbox.push_back(fn);
+        cv.notify_one();
+    };
+    
+    run_async(ai, std::move(user_message), history, system_prompt, config,
+              [&mutex, &done, &out](const AgentResult& r) {
+                  std::lock_guard<std::mutex> lock(mutex);
+                  out = r;
+                  done = true;
+              },
+              executor);
+    
+    while (true) {
+        std::function<void()> fn;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&done, &mailbox] { return done || !mailbox.empty(); });
+            if (mailbox.empty()) {
+                break;
+            }
+            fn = mailbox.front();
+            mailbox.pop_front();
+        }
+        fn();
+    }
+    
+    return out;
+}
+
+void Agent::run_async(
+    AIPlugin* ai,
+    SharedText user_message,
+    std::vector<ConversationMessage>& history,
+    const std::string& system_prompt,
+    const AgentConfig& config,
+    AgentCallback on_done,
+    AgentExecutor executor) {
+    run_async(ai, std::move(user_message), history, std::make_shared<const std::string>(system_prompt),
+              config, on_done, executor);
+}
+
+void Agent::run_async(
+    AIPlugin* ai,
+    SharedText user_message,
+    std::vector<ConversationMessage>& history,
+    SharedPrompt system_prompt,
+    const AgentConfig& config,
+    AgentCallback on_done,
+    AgentExecutor executor) {
+    
+    TurnPtr turn(new Turn());
+    turn->ai = ai;
+    turn->history = &history;
+    turn->config = config;
+    turn->on_done = on_done;
+    turn->executor = executor;
+    
+    AgentTrace& trace = turn->result.trace;
+    trace.start();
+    if (config.queued_at_us > 0) {
+        trace.add("queue", "admission", config.queued_at_us, AgentTrace::clock_us());
+    }
     
     if (!ai || !ai->is_configured()) {
-        result.error = "AI not configured";
-        return result;
+        turn->result.error = "AI not configured";
+        turn_finish(turn);
+        return;
     }
     
     LOG_INFO("[Agent] Starting agentic loop for message: %.50s%s", 
              user_message.c_str(), user_message.size() > 50 ? "..." : "");
     
     // Add user message to history
-    history.push_back(ConversationMessage::user(user_message));
+    turn->user_message = user_message;
+    history.push_back(ConversationMessage::user(std::move(user_message)));
     
-    // Build full system prompt with tools
-    std::string full_system_prompt = system_prompt;
-    std::string tools_prompt = build_tools_prompt();
-    if (!tools_prompt.empty()) {
-        full_system_prompt = tools_prompt + "\n\n" + system_prompt;
+    // Tools prompt goes ahead of the system prompt (see CompletionOptions)
+    turn->native_tools = native_tools_ && ai->supports_native_tools();
+    if (turn->native_tools) {
+        turn->tool_specs = build_tool_specs();
     }
+    turn->tools_prompt = tools_prompt(turn->native_tools);
+    turn->system_prompt = system_prompt ? system_prompt : std::make_shared<const std::string>();
     
-    int consecutive_errors = 0;
-    int token_limit_retries = 0;
-    const int max_token_limit_retries = 2;
-    std::string accumulated_response;
+    turn_request(turn);
+}
+
+void Agent::turn_request(TurnPtr turn) {
+    AgentResult& result = turn->result;
     
-    // Agentic loop
-    while (result.iterations < config.max_iterations) {
-        result.iterations++;
-        LOG_DEBUG("[Agent] === Iteration %d ===", result.iterations);
-        
-        // Call AI
-        CompletionOptions opts;
-        opts.system_prompt = full_system_prompt;
-        opts.max_tokens = 4096;
+    if (result.iterations >= turn->config.max_iterations) {
+        // Reached max iterations
+        LOG_WARN("[Agent] Reached max iterations (%d)", turn->config.max_iterations);
+        result.success = true;  // Partial success
+        result.final_response = turn->accumulated_response.empty() 
+            ? "Reached maximum tool call iterations." 
+            : turn->accumulated_response + "\n\n(Reached maximum iterations)";
+        turn_finish(turn);
+        return;
+    }
+    
+    result.iterations++;
+    LOG_DEBUG("[Agent] === Iteration %d ===", result.iterations);
+    
+    // Call AI; the reply is handled wherever the executor puts it
+    CompletionOptions opts;
+    opts.tools_prompt = *turn->tools_prompt;
+    opts.system_prompt = *turn->system_prompt;
+    opts.tools = turn->tool_specs;
+    opts.max_tokens = 4096;
+    
+    // Trim to the context window up front instead of waiting for a rejection
+    turn->prompt_estimate = fit_history_to_budget(turn->ai, opts, *turn->history);
+    
+    // Prefetched memory rides on the first request only; history keeps
+    // the user's own words (message contents are shared, so this is cheap)
+    std::shared_ptr<std::vector<ConversationMessage> > request;
+    if (result.iterations == 1 && !turn->config.recalled.empty() && !turn->history->empty()) {
+        request = std::make_shared<std::vector<ConversationMessage> >(*turn->history);
+        request->back() = ConversationMessage::user(turn->config.recalled + "\n\n" + request->back().content.str());
+        turn->prompt_estimate += TokenEstimator::count_text(turn->config.recalled);
+    }
+    
+    std::shared_ptr<DeltaFilter> filter;
+    if (turn->config.on_delta) {
+        filter.reset(new DeltaFilter(turn->config.on_delta));
+    }
+    
+    // Stream the reply to overlap read-only tools with generation as well
+    std::shared_ptr<ToolScanner> scanner;
+    if (early_tool_start_ && max_parallel_tools_ > 1 && !turn->native_tools) {
+        for (std::map<std::string, AgentTool>::const_iterator it = tools_.begin(); it != tools_.end(); ++it) {
+            if (it->second.parallel_safe) {
+                scanner.reset(new ToolScanner());
+                scanner->scope = turn->config.session_key;
+                break;
+            }
+        }
+    }
+    turn->scanner = scanner;
+    
+    // First chunk time is written on the HTTP thread, read after completion
+    int64_t queued = AgentTrace::clock_us();
+    std::shared_ptr<std::atomic<int64_t> > first_chunk(new std::atomic<int64_t>(0));
+    
+    if (filter || scanner) {
+        opts.stream = true;
+        opts.on_chunk = [this, filter, scanner, first_chunk](const std::string& chunk) {
+            if (first_chunk->load() == 0) first_chunk->store(AgentTrace::clock_us());
+            if (filter) filter->feed(chunk);
+            if (scanner) scan_stream(*scanner, chunk);
+        };
+    }
+    
+    std::string model = opts.model.empty() ? turn->ai->default_model() : opts.model;
+    ProviderBudget* budget = budget_;
+    ProviderBudget::AdmitCallback send = [this, turn, opts, filter, queued, first_chunk, model, budget, request]
+                                         (ProviderBudget::Ticket ticket) {
+        int64_t requested = AgentTrace::clock_us();
+        turn->ai->chat_async(request ? *request : *turn->history, opts,
+                             [this, turn, filter, queued, requested, first_chunk, model, budget, ticket]
+                             (const CompletionResult& ai_result) {
+            if (budget) budget->release(ticket, ai_result);
+            if (filter) filter->flush();
+            int64_t completed = AgentTrace::clock_us();
+            turn->dispatch([this, turn, ai_result, queued, requested, completed, first_chunk, model] {
+                turn_on_response(turn, ai_result, model, queued, requested, completed, first_chunk->load());
+            });
+        });
+    };
+    
+    // Wait for the provider's per-minute budget instead of running into a 429
+    if (budget) {
+        budget->acquire(turn->ai->provider_id(), turn->prompt_estimate, opts.max_tokens, send);
+    } else {
+        send(0);
+    }
+}
+
+void Agent::turn_on_response(TurnPtr turn, const CompletionResult& ai_result, const std::string& model,
+                             int64_t queued, int64_t requested, int64_t completed, int64_t first) {
+    // Time spent waiting for provider budget
+    if (requested - queued >= 1000) {
+        turn->result.trace.add("queue", "budget", queued, requested).iteration = turn->result.iterations;
+    }
+    TraceSpan& span = turn->result.trace.add("ai", ai_result.model.empty() ? model : ai_result.model,
+                                             requested, completed);
+    span.iteration = turn->result.iterations;
+    span.ttfb_us = first > 0 ? first - requested : -1;
+    span.input_tokens = ai_result.usage.input_tokens;
+    span.output_tokens = ai_result.usage.output_tokens;
+    span.cache_read_tokens = ai_result.usage.cache_read_tokens;
+    span.ok = ai_result.success;
+    span.error = ai_result.error;
+
+    static HistogramFamily& request_seconds = Metrics::instance().histogram_family(
+        "openclaw_ai_request_seconds", "AI request latency, from send to the full response",
+        {"provider", "model"}, Metrics::latency_buckets());
+    static HistogramFamily& ttfb_seconds = Metrics::instance().histogram_family(
+        "openclaw_ai_ttfb_seconds", "AI time to the first streamed chunk",
+        {"provider", "model"}, Metrics::latency_buckets());
+    static CounterFamily& tokens = Metrics::instance().counter_family(
+        "openclaw_ai_tokens_total", "AI tokens by kind (input, output, cache_read)",
+        {"provider", "model", "kind"});
+    std::string provider = turn->ai->provider_id();
+    request_seconds.get(provider, span.name).observe_us(completed - requested);
+    if (span.ttfb_us >= 0) ttfb_seconds.get(provider, span.name).observe_us(span.ttfb_us);
+    if (ai_result.usage.input_tokens > 0) {
+        tokens.get(provider, span.name, "input").inc(ai_result.usage.input_tokens);
+    }
+    if (ai_result.usage.output_tokens > 0) {
+        tokens.get(provider, span.name, "output").inc(ai_result.usage.output_tokens);
+    }
+    if (ai_result.usage.cache_read_tokens > 0) {
+        tokens.get(provider, span.name, "cache_read").inc(ai_result.usage.cache_read_tokens);
+    }
+    turn_on_completion(turn, ai_result);
+}
+
+void Agent::turn_on_completion(TurnPtr turn, const CompletionResult& ai_result) {
+    AgentResult& result = turn->result;
+    const AgentConfig& config = turn->config;
+    std::vector<ConversationMessage>& history = *turn->history;
+    
+    if (!ai_result.success) {
+        LOG_ERROR("[Agent] AI call failed: %s", ai_result.error.c_str());
         
-        CompletionResult ai_result = ai->chat(history, opts);
+        // Throttled by the provider: not the model's fault, so it does not
+        // count as an error or an iteration. The budget holds the retry
+        // back until the provider's retry-after has passed; without one
+        // the retry waits here.
+        if (ai_result.http_status == 429 || ai_result.http_status == 529) {
+            turn->rate_limit_retries++;
+            if (turn->rate_limit_retries <= max_rate_limit_retries) {
+                result.iterations--;
+                if (budget_) {
+                    LOG_WARN("[Agent] Provider throttled (HTTP %ld), retrying (attempt %d/%d)",
+                             ai_result.http_status, turn->rate_limit_retries, max_rate_limit_retries);
+                    turn_request(turn);
+                    return;
+                }
+                int64_t delay = rate_limit_delay_ms(ai_result, turn->rate_limit_retries);
+                LOG_WARN("[Agent] Provider throttled (HTTP %ld), retrying in %lld ms (attempt %d/%d)",
+                         ai_result.http_status, static_cast<long long>(delay),
+                         turn->rate_limit_retries, max_rate_limit_retries);
+                TimerWheel::instance().schedule_in(delay, [this, turn] {
+                    turn->dispatch([this, turn] { turn_request(turn); });
+                });
+                return;
+            }
+            result.error = "AI provider is rate limiting requests, try again later.";
+            turn->drop_user_message();
+            turn_finish(turn);
+            return;
+        }
         
-        if (!ai_result.success) {
-            LOG_ERROR("[Agent] AI call failed: %s", ai_result.error.c_str());
+        // Check if this is a token limit error
+        if (is_token_limit_error(ai_result.error)) {
+            turn->token_limit_retries++;
+            LOG_WARN("[Agent] Token limit exceeded (attempt %d/%d), trying to recover...",
+                     turn->token_limit_retries, max_token_limit_retries);
             
-            // Check if this is a token limit error
-            if (is_token_limit_error(ai_result.error)) {
-                token_limit_retries++;
-                LOG_WARN("[Agent] Token limit exceeded (attempt %d/%d), trying to recover...",
-                         token_limit_retries, max_token_limit_retries);
-                
-                if (token_limit_retries <= max_token_limit_retries) {
-                    // Try to truncate history and retry
-                    if (try_truncate_history(history)) {
-                        LOG_INFO("[Agent] History truncated, retrying...");
-                        consecutive_errors = 0;  // Reset error count for this recovery attempt
-                        continue;
-                    } else {
-                        LOG_WARN("[Agent] Could not truncate history further");
-                    }
+            if (turn->token_limit_retries <= max_token_limit_retries) {
+                // Try to truncate history and retry
+                if (try_truncate_history(history)) {
+                    LOG_INFO("[Agent] History truncated, retrying...");
+                    turn->consecutive_errors = 0;  // Reset error count for this recovery attempt
+                    turn_request(turn);
+                    return;
+                } else {
+                    LOG_WARN("[Agent] Could not truncate history further");
                 }
-                
-                // If we've exhausted retries or can't truncate, fail gracefully
-                result.error = "Context window exceeded and recovery failed. Try a simpler request or use smaller data.";
-                history.pop_back();
-                return result;
             }
             
-            consecutive_errors++;
-            if (consecutive_errors >= config.max_consecutive_errors) {
-                result.error = "Too many consecutive AI errors: " + ai_result.error;
-                // Remove user message on failure
-                history.pop_back();
-                return result;
-            }
-            continue;
+            // If we've exhausted retries or can't truncate, fail gracefully
+            result.error = "Context window exceeded and recovery failed. Try a simpler request or use smaller data.";
+            turn->drop_user_message();
+            turn_finish(turn);
+            return;
         }
         
-        consecutive_errors = 0;
-        token_limit_retries = 0;  // Reset on successful call
-        std::string response = ai_result.content;
+        turn->consecutive_errors++;
+        if (turn->consecutive_errors >= config.max_consecutive_errors) {
+            result.error = "Too many consecutive AI errors: " + ai_result.error;
+            // Remove user message on failure
+            turn->drop_user_message();
+            turn_finish(turn);
+            return;
+        }
+        turn_request(turn);
+        return;
+    }
+    
+    turn->consecutive_errors = 0;
+    turn->token_limit_retries = 0;  // Reset on successful call
+    turn->rate_limit_retries = 0;
+    std::string response = ai_result.content;
+    
+    LOG_DEBUG("[Agent] AI response length: %zu", response.size());
+    LOG_DEBUG("[Agent] Prompt tokens: %d new, %d cache read, %d cache write (estimated %d)",
+              ai_result.usage.input_tokens, ai_result.usage.cache_read_tokens,
+              ai_result.usage.cache_write_tokens, turn->prompt_estimate);
+    LOG_DEBUG("[Agent] AI response preview: %.300s%s", response.c_str(), 
+              response.size() > 300 ? "..." : "");
+    
+    // Parse tool calls
+    int64_t parse_start = AgentTrace::clock_us();
+    std::vector<ParsedToolCall> calls = turn->native_tools
+        ? native_tool_calls(ai_result.tool_uses)
+        : parse_tool_calls(response);
+    result.trace.add("parse", "", parse_start, AgentTrace::clock_us()).iteration = result.iterations;
+    
+    if (calls.empty()) {
+        // Check if the AI indicated intent to use a tool but didn't emit the call
+        // This is common with smaller models that "think out loud"
+        bool indicates_tool_intent = false;
+        bool is_asking_question = false;
+        std::string response_lower = response;
+        std::transform(response_lower.begin(), response_lower.end(), response_lower.begin(), ::tolower);
         
-        LOG_DEBUG("[Agent] AI response length: %zu", response.size());
-        LOG_DEBUG("[Agent] AI response preview: %.300s%s", response.c_str(), 
-                  response.size() > 300 ? "..." : "");
+        // Check if AI is asking a question (not intent to act)
+        if (response_lower.find("?") != std::string::npos &&
+            (response_lower.find("which") != std::string::npos ||
+             response_lower.find("what") != std::string::npos ||
+             response_lower.find("where") != std::string::npos ||
+             response_lower.find("could you") != std::string::npos ||
+             response_lower.find("would you") != std::string::npos ||
+             response_lower.find("do you want") != std::string::npos)) {
+            is_asking_question = true;
+            LOG_DEBUG("[Agent] AI is asking a question, not forcing tool call");
+        }
         
-        // Parse tool calls
-        std::vector<ParsedToolCall> calls = parse_tool_calls(response);
+        // Patterns that indicate the AI wants to use a tool NOW
+        // Only trigger if it's a clear statement of intent to act immediately
+        const char* intent_patterns[] = {
+            "let's do that",
+            "let's do it",
+            "i'll do that",
+            "doing that now",
+            "executing now",
+            "running the command now",
+            "let's execute it",
+            "i'll emit the tool call",
+            "emitting tool call",
+            "calling the tool",
+            NULL
+        };
         
-        if (calls.empty()) {
-            // Check if the AI indicated intent to use a tool but didn't emit the call
-            // This is common with smaller models that "think out loud"
-            bool indicates_tool_intent = false;
-            bool is_asking_question = false;
-            std::string response_lower = response;
-            std::transform(response_lower.begin(), response_lower.end(), response_lower.begin(), ::tolower);
-            
-            // Check if AI is asking a question (not intent to act)
-            if (response_lower.find("?") != std::string::npos &&
-                (response_lower.find("which") != std::string::npos ||
-                 response_lower.find("what") != std::string::npos ||
-                 response_lower.find("where") != std::string::npos ||
-                 response_lower.find("could you") != std::string::npos ||
-                 response_lower.find("would you") != std::string::npos ||
-                 response_lower.find("do you want") != std::string::npos)) {
-                is_asking_question = true;
-                LOG_DEBUG("[Agent] AI is asking a question, not forcing tool call");
-            }
-            
-            // Patterns that indicate the AI wants to use a tool NOW
-            // Only trigger if it's a clear statement of intent to act immediately
-            const char* intent_patterns[] = {
-                "let's do that",
-                "let's do it",
-                "i'll do that",
-                "doing that now",
-                "executing now",
-                "running the command now",
-                "let's execute it",
-                "i'll emit the tool call",
-                "emitting tool call",
-                "calling the tool",
-                NULL
-            };
-            
-            for (int i = 0; intent_patterns[i] != NULL && !is_asking_question; ++i) {
-                if (response_lower.find(intent_patterns[i]) != std::string::npos) {
-                    indicates_tool_intent = true;
-                    LOG_DEBUG("[Agent] Detected tool intent pattern: '%s'", intent_patterns[i]);
-                    break;
-                }
-            }
-            
-            // If AI indicated intent but no tool call, prompt it to actually emit the call
-            if (indicates_tool_intent && !is_asking_question && result.iterations < config.max_iterations) {
-                LOG_INFO("[Agent] AI indicated tool intent but didn't emit call, prompting to continue");
-                
-                // Add the AI's response to history
-                history.push_back(ConversationMessage::assistant(response));
-                
-                // Add a prompt to actually emit the tool call
-                std::string continuation_prompt = 
-                    "You indicated you want to use a tool, but you didn't emit the actual tool call. "
-                    "Please emit the tool call now using the exact format:\n\n"
-                    "<tool_call name=\"TOOLNAME\">\n{\"param\": \"value\"}\n</tool_call>\n\n"
-                    "Do not explain - just emit the tool call.";
-                
-                history.push_back(ConversationMessage::user(continuation_prompt));
-                continue;  // Continue the loop to get the actual tool call
+        for (int i = 0; intent_patterns[i] != NULL && !is_asking_question; ++i) {
+            if (response_lower.find(intent_patterns[i]) != std::string::npos) {
+                indicates_tool_intent = true;
+                LOG_DEBUG("[Agent] Detected tool intent pattern: '%s'", intent_patterns[i]);
+                break;
             }
+        }
+        
+        // If AI indicated intent but no tool call, prompt it to actually emit the call
+        if (indicates_tool_intent && !is_asking_question && !turn->native_tools &&
+            result.iterations < config.max_iterations) {
+            LOG_INFO("[Agent] AI indicated tool intent but didn't emit call, prompting to continue");
             
-            // No tool calls and no intent - we're done
-            LOG_INFO("[Agent] No tool calls in response, loop complete after %d iterations", 
-                     result.iterations);
-            
-            // Add final response to history
+            // Add the AI's response to history
             history.push_back(ConversationMessage::assistant(response));
             
-            result.success = true;
-            result.final_response = response;
-            return result;
+            // Add a prompt to actually emit the tool call
+            std::string continuation_prompt = 
+                "You indicated you want to use a tool, but you didn't emit the actual tool call. "
+                "Please emit the tool call now using the exact format:\n\n"
+                "<tool_call name=\"TOOLNAME\">\n{\"param\": \"value\"}\n</tool_call>\n\n"
+                "Do not explain - just emit the tool call.";
+            
+            history.push_back(ConversationMessage::user(continuation_prompt));
+            turn_request(turn);  // Continue the loop to get the actual tool call
+            return;
         }
         
-        // Execute tool calls and build results
-        LOG_INFO("[Agent] Found %zu tool call(s) in response", calls.size());
+        // No tool calls and no intent - we're done
+        LOG_INFO("[Agent] No tool calls in response, loop complete after %d iterations", 
+                 result.iterations);
         
-        std::ostringstream results_oss;
-        bool should_continue = true;
+        // Add final response to history
+        history.push_back(ConversationMessage::assistant(response));
         
-        for (size_t i = 0; i < calls.size(); ++i) {
-            const ParsedToolCall& call = calls[i];
-            result.tool_calls_made++;
-            
-            // Track tool usage
-            if (std::find(result.tools_used.begin(), result.tools_used.end(), call.tool_name) 
-                == result.tools_used.end()) {
-                result.tools_used.push_back(call.tool_name);
+        result.success = true;
+        result.final_response = response;
+        turn_finish(turn);
+        return;
+    }
+    
+    // Execute tool calls and build results
+    LOG_INFO("[Agent] Found %zu tool call(s) in response", calls.size());
+    
+    ToolBatchPtr batch(new ToolBatch());
+    batch->calls = calls;
+    batch->results.resize(calls.size());
+    batch->early.resize(calls.size());
+    batch->started_us.resize(calls.size());
+    batch->finished_us.resize(calls.size());
+    batch->response = response;
+    batch->native = turn->native_tools;
+    claim_early_calls(turn, batch);
+    
+    for (size_t i = 0; i < calls.size(); ++i) {
+        result.tool_calls_made++;
+        
+        // Track tool usage
+        if (std::find(result.tools_used.begin(), result.tools_used.end(), calls[i].tool_name) 
+            == result.tools_used.end()) {
+            result.tools_used.push_back(calls[i].tool_name);
+        }
+    }
+    
+    run_tool_calls(turn, batch, false);
+}
+
+// ============================================================================
+// Tool execution
+// ============================================================================
+
+bool Agent::is_parallel_safe(const ParsedToolCall& call) const {
+    std::map<std::string, AgentTool>::const_iterator it = tools_.find(call.tool_name);
+    return it != tools_.end() && it->second.parallel_safe;
+}
+
+bool Agent::is_async(const ParsedToolCall& call) const {
+    std::map<std::string, AgentTool>::const_iterator it = tools_.find(call.tool_name);
+    return it != tools_.end() && it->second.execute_async;
+}
+
+ThreadPool& Agent::tool_pool() {
+    std::lock_guard<std::mutex> lock(tool_pool_mutex_);
+    if (!tool_pool_) {
+        tool_pool_.reset(new ThreadPool(max_parallel_tools_, 0));
+    }
+    return *tool_pool_;
+}
+
+void Agent::scan_stream(ToolScanner& scanner, const std::string& chunk) {
+    static const std::string open_tag = "<tool_call";
+    static const std::string close_tag = "</tool_call>";
+    
+    scanner.text += chunk;
+    
+    size_t close = scanner.text.find(close_tag);
+    while (close != std::string::npos) {
+        size_t end = close + close_tag.size();
+        size_t open = scanner.text.rfind(open_tag, close);
+        
+        if (open != std::string::npos) {
+            std::vector<ParsedToolCall> calls = parse_tool_calls(scanner.text.substr(open, end - open));
+            if (calls.size() == 1 && is_parallel_safe(calls[0])) {
+                EarlyToolCallPtr early(new EarlyToolCall());
+                early->call = calls[0];
+                scanner.started.push_back(early);
+                
+                LOG_DEBUG("[Agent] Starting tool '%s' while the reply streams",
+                          early->call.tool_name.c_str());
+                std::string scope = scanner.scope;
+                tool_pool().enqueue([this, early, scope] {
+                    ContentChunker::ScopeGuard guard(scope);
+                    early->started_us = AgentTrace::clock_us();
+                    AgentToolResult r = execute_tool(early->call);
+                    early->finished_us = AgentTrace::clock_us();
+                    early->complete(r);
+                });
             }
-            
-            AgentToolResult tool_result = execute_tool(call);
-            
-            if (!tool_result.should_continue) {
-                should_continue = false;
+        }
+        
+        scanner.text.erase(0, end);
+        close = scanner.text.find(close_tag);
+    }
+    
+    // Nothing before the last opening tag can be part of a later call
+    size_t open = scanner.text.rfind(open_tag);
+    if (open == std::string::npos) {
+        // Keep a tail that might be the start of a split opening tag
+        open = scanner.text.size() > open_tag.size() ? scanner.text.size() - open_tag.size() : 0;
+    }
+    scanner.text.erase(0, open);
+}
+
+void Agent::claim_early_calls(TurnPtr turn, ToolBatchPtr batch) {
+    std::shared_ptr<ToolScanner> scanner;
+    scanner.swap(turn->scanner);
+    if (!scanner || scanner->started.empty()) return;
+    
+    size_t claimed = 0;
+    for (size_t i = 0; i < batch->calls.size(); ++i) {
+        const ParsedToolCall& call = batch->calls[i];
+        for (size_t j = 0; j < scanner->started.size(); ++j) {
+            EarlyToolCall& early = *scanner->started[j];
+            if (!early.claimed && early.call.tool_name == call.tool_name &&
+                early.call.raw_content == call.raw_content) {
+                early.claimed = true;
+                batch->early[i] = scanner->started[j];
+                claimed++;
+                break;
             }
-            
-            results_oss << format_tool_result(call.tool_name, tool_result) << "\n";
         }
+    }
+    
+    LOG_DEBUG("[Agent] %zu of %zu tool call(s) were started while streaming",
+              claimed, batch->calls.size());
+}
+
+void Agent::run_tool_calls(TurnPtr turn, ToolBatchPtr batch, bool resumed) {
+    const size_t n = batch->calls.size();
+    
+    while (batch->next < n) {
+        // A run of consecutive parallel-safe calls forms one group; any
+        // other call is a barrier that runs on its own, in order
+        size_t start = batch->next;
+        size_t end = start + 1;
+        if (max_parallel_tools_ > 1 && is_parallel_safe(batch->calls[start])) {
+            while (end < n && is_parallel_safe(batch->calls[end])) end++;
+        }
+        batch->next = end;
         
-        // Extract text response (non-tool-call content)
-        std::string text_response = extract_response_text(response, calls);
+        // A tool that waits on the reactor (bash) holds no thread while it
+        // runs; its completion carries on with the batch from the tool pool
+        if (end - start == 1 && !batch->early[start] && is_async(batch->calls[start])) {
+            report_tool(turn->config, batch->calls[start], NULL);
+            batch->started_us[start] = AgentTrace::clock_us();
+            execute_tool_async(batch->calls[start], [this, turn, batch, start](const AgentToolResult& r) {
+                batch->results[start] = r;
+                batch->finished_us[start] = AgentTrace::clock_us();
+                report_tool(turn->config, batch->calls[start], &batch->results[start]);
+                tool_pool().enqueue([this, turn, batch] { run_tool_calls(turn, batch, true); });
+            });
+            return;
+        }
         
-        // Add AI's response (with tool calls) to history
-        history.push_back(ConversationMessage::assistant(response));
+        if (end - start == 1 && !batch->early[start]) {
+            ContentChunker::ScopeGuard guard(turn->config.session_key);
+            report_tool(turn->config, batch->calls[start], NULL);
+            batch->started_us[start] = AgentTrace::clock_us();
+            batch->results[start] = execute_tool(batch->calls[start]);
+            batch->finished_us[start] = AgentTrace::clock_us();
+            report_tool(turn->config, batch->calls[start], &batch->results[start]);
+            continue;
+        }
         
-        // Add tool results as a user message (this continues the conversation)
-        std::string tool_results = results_oss.str();
-        LOG_DEBUG("[Agent] Tool results:\n%s", tool_results.c_str());
+        LOG_DEBUG("[Agent] Running %zu tool calls in parallel", end - start);
         
-        history.push_back(ConversationMessage::user(tool_results));
+        // The last call of the group to finish carries on with the batch.
+        // Calls started while streaming are only waited for.
+        batch->running = end - start;
+        for (size_t i = start; i < end; ++i) {
+            if (batch->early[i]) {
+                // Already running (or done); reported from here so events
+                // only cover calls the reply actually made
+                report_tool(turn->config, batch->calls[i], NULL);
+                batch->early[i]->on_result([this, turn, batch, i](const AgentToolResult& r) {
+                    report_tool(turn->config, batch->calls[i], &r);
+                    batch->results[i] = r;
+                    batch->started_us[i] = batch->early[i]->started_us;
+                    batch->finished_us[i] = batch->early[i]->finished_us;
+                    if (--batch->running == 0) {
+                        run_tool_calls(turn, batch, true);
+                    }
+                });
+                continue;
+            }
+            tool_pool().enqueue([this, turn, batch, i] {
+                ContentChunker::ScopeGuard guard(turn->config.session_key);
+                report_tool(turn->config, batch->calls[i], NULL);
+                batch->started_us[i] = AgentTrace::clock_us();
+                batch->results[i] = execute_tool(batch->calls[i]);
+                batch->finished_us[i] = AgentTrace::clock_us();
+                report_tool(turn->config, batch->calls[i], &batch->results[i]);
+                if (--batch->running == 0) {
+                    run_tool_calls(turn, batch, true);
+                }
+            });
+        }
+        return;
+    }
+    
+    // Back onto the run's own executor once we have left it
+    if (resumed) {
+        turn->dispatch([this, turn, batch] { turn_on_tool_results(turn, batch); });
+    } else {
+        turn_on_tool_results(turn, batch);
+    }
+}
+
+void Agent::turn_on_tool_results(TurnPtr turn, ToolBatchPtr batch) {
+    AgentResult& result = turn->result;
+    std::vector<ConversationMessage>& history = *turn->history;
+    const std::string& response = batch->response;
+    
+    std::ostringstream results_oss;
+    std::vector<ToolResultBlock> native_results;
+    bool should_continue = true;
+    ContentChunker::ScopeGuard guard(turn->config.session_key);
+    
+    static HistogramFamily& tool_seconds = Metrics::instance().histogram_family(
+        "openclaw_tool_seconds", "Tool execution latency", {"tool"}, Metrics::latency_buckets());
+    for (size_t i = 0; i < batch->calls.size(); ++i) {
+        const AgentToolResult& r = batch->results[i];
+        TraceSpan& span = result.trace.add("tool", batch->calls[i].tool_name,
+                                           batch->started_us[i], batch->finished_us[i]);
+        span.iteration = result.iterations;
+        span.ok = r.success;
+        span.error = r.error;
+        tool_seconds.get(batch->calls[i].tool_name).observe_us(batch->finished_us[i] - batch->started_us[i]);
+    }
+    
+    int64_t format_start = AgentTrace::clock_us();
+    for (size_t i = 0; i < batch->calls.size(); ++i) {
+        const ParsedToolCall& call = batch->calls[i];
+        const AgentToolResult& tool_result = batch->results[i];
         
-        if (!should_continue) {
-            LOG_INFO("[Agent] Tool requested stop, ending loop");
-            result.success = true;
-            result.final_response = text_response.empty() ? "Task completed." : text_response;
-            return result;
+        if (!tool_result.should_continue) {
+            should_continue = false;
         }
         
-        // Accumulate non-tool response text
-        if (!text_response.empty()) {
-            if (!accumulated_response.empty()) {
-                accumulated_response += "\n\n";
-            }
-            accumulated_response += text_response;
+        std::string output = format_tool_output(call.tool_name, tool_result);
+        results_oss << tool_result_text(call.tool_name, tool_result.success, output) << "\n";
+        if (batch->native) {
+            native_results.push_back(ToolResultBlock(call.id, std::move(output), !tool_result.success));
+        }
+    }
+    
+    // Extract text response (non-tool-call content)
+    std::string text_response = batch->native ? response : extract_response_text(response, batch->calls);
+    result.trace.add("format", "", format_start, AgentTrace::clock_us()).iteration = result.iterations;
+    
+    // Add AI's response (with tool calls) to history
+    ConversationMessage assistant_msg = ConversationMessage::assistant(response);
+    if (batch->native) {
+        for (size_t i = 0; i < batch->calls.size(); ++i) {
+            ToolUse use;
+            use.id = batch->calls[i].id;
+            use.name = batch->calls[i].tool_name;
+            use.input = batch->calls[i].params;
+            assistant_msg.tool_uses.push_back(use);
+        }
+    }
+    history.push_back(std::move(assistant_msg));
+    
+    // Add tool results as a user message (this continues the conversation)
+    SharedText tool_results = results_oss.str();
+    LOG_DEBUG("[Agent] Tool results:\n%s", tool_results.c_str());
+    
+    ConversationMessage results_msg = ConversationMessage::user(tool_results);
+    results_msg.tool_results.swap(native_results);
+    history.push_back(std::move(results_msg));
+    
+    if (!should_continue) {
+        LOG_INFO("[Agent] Tool requested stop, ending loop");
+        result.success = true;
+        result.final_response = text_response.empty() ? "Task completed." : text_response;
+        turn_finish(turn);
+        return;
+    }
+    
+    // Accumulate non-tool response text
+    if (!text_response.empty()) {
+        if (!turn->accumulated_response.empty()) {
+            turn->accumulated_response += "\n\n";
         }
+        turn->accumulated_response += text_response;
     }
     
-    // Reached max iterations
-    LOG_WARN("[Agent] Reached max iterations (%d)", config.max_iterations);
-    result.success = true;  // Partial success
-    result.final_response = accumulated_response.empty() 
-        ? "Reached maximum tool call iterations." 
-        : accumulated_response + "\n\n(Reached maximum iterations)";
+    turn_request(turn);
+}
+
+void Agent::turn_finish(TurnPtr turn) {
+    turn->result.trace.finish();
+    LOG_DEBUG("[Agent] Turn trace %s: %s", turn->result.trace.trace_id().c_str(),
+              turn->result.trace.summary().c_str());
     
-    return result;
+    if (turn->on_done) {
+        turn->on_done(turn->result);
+    }
 }
 
 } // namespace openclaw
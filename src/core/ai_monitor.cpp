@@ -5,6 +5,7 @@
 #include <openclaw/core/application.hpp>
 #include <openclaw/core/channel.hpp>
 #include <openclaw/core/logger.hpp>
+#include <algorithm>
 
 namespace openclaw {
 
@@ -14,6 +15,8 @@ namespace openclaw {
 
 AIProcessMonitor::AIProcessMonitor()
     : running_(false)
+    , wheel_(TimerWheel::instance())
+    , next_serial_(1)
     , total_sessions_started_(0)
     , total_hung_detected_(0)
     , total_typing_indicators_sent_(0)
@@ -22,6 +25,7 @@ AIProcessMonitor::AIProcessMonitor()
 
 AIProcessMonitor::~AIProcessMonitor() {
     stop();
+    wheel_.cancel_all(this);
 }
 
 // ============================================================================
@@ -34,8 +38,14 @@ void AIProcessMonitor::start() {
         return;
     }
     
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
     running_.store(true);
-    monitor_thread_ = std::thread(&AIProcessMonitor::monitor_loop, this);
+    
+    // Sessions tracked before start get their deadlines now
+    for (auto& entry : active_sessions_) {
+        arm_hang_check(entry.first, entry.second, config_.hang_timeout_seconds * 1000LL);
+        arm_typing(entry.first, entry.second, 0);
+    }
     
     LOG_INFO("[AIProcessMonitor] started (hang_timeout=%ds, typing_interval=%ds)",
              config_.hang_timeout_seconds, config_.typing_interval_seconds);
@@ -46,10 +56,13 @@ void AIProcessMonitor::stop() {
         return;
     }
     
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
     running_.store(false);
     
-    if (monitor_thread_.joinable()) {
-        monitor_thread_.join();
+    wheel_.cancel_all(this);
+    for (auto& entry : active_sessions_) {
+        entry.second.hang_timer = 0;
+        entry.second.typing_timer = 0;
     }
     
     LOG_INFO("[AIProcessMonitor] stopped");
@@ -64,13 +77,23 @@ void AIProcessMonitor::start_session(const std::string& session_id,
                                      const std::string& chat_id) {
     std::lock_guard<std::mutex> lock(sessions_mutex_);
     
-    AISessionState state;
+    AISessionState& state = active_sessions_[session_id];
+    if (state.hang_timer) wheel_.cancel(state.hang_timer);
+    if (state.typing_timer) wheel_.cancel(state.typing_timer);
+    
+    state = AISessionState();
     state.channel_id = channel_id;
     state.chat_id = chat_id;
-    
-    active_sessions_[session_id] = state;
+    state.serial = next_serial_++;
     total_sessions_started_.fetch_add(1);
     
+    if (running_.load()) {
+        arm_hang_check(session_id, state, config_.hang_timeout_seconds * 1000LL);
+        // First indicator right away, then every typing interval
+        queue_typing(state, true);
+        arm_typing(session_id, state, std::max(config_.typing_interval_seconds, 1) * 1000LL);
+    }
+    
     LOG_DEBUG("[AIProcessMonitor] session started [%s] -> %s:%s", 
               session_id.c_str(), channel_id.c_str(), chat_id.c_str());
 }
@@ -80,12 +103,21 @@ void AIProcessMonitor::heartbeat(const std::string& session_id) {
     
     auto it = active_sessions_.find(session_id);
     if (it != active_sessions_.end()) {
-        it->second.last_heartbeat = std::chrono::steady_clock::now();
-        it->second.heartbeat_count++;
-        it->second.is_hung = false;
+        AISessionState& state = it->second;
+        state.last_heartbeat = std::chrono::steady_clock::now();
+        state.heartbeat_count++;
+        
+        // The pending hang check sees the new time when it fires; a session
+        // already reported hung needs a fresh one
+        if (state.is_hung) {
+            state.is_hung = false;
+            if (running_.load()) {
+                arm_hang_check(session_id, state, config_.hang_timeout_seconds * 1000LL);
+            }
+        }
         
         LOG_DEBUG("[AIProcessMonitor] heartbeat [%s] count=%d", 
-                  session_id.c_str(), it->second.heartbeat_count);
+                  session_id.c_str(), state.heartbeat_count);
     }
 }
 
@@ -104,13 +136,12 @@ void AIProcessMonitor::end_session(const std::string& session_id) {
                   it->second.heartbeat_count,
                   it->second.is_hung ? "yes" : "no");
         
-        // Stop typing indicator
-        auto& state = it->second;
-        auto& app = Application::instance();
-        auto& plugins = app.registry().plugins();
-        for (size_t i = 0; i < plugins.size(); ++i) {
-            plugins[i]->on_typing_indicator(state.channel_id, state.chat_id, false);
-        }
+        AISessionState& state = it->second;
+        if (state.hang_timer) wheel_.cancel(state.hang_timer);
+        if (state.typing_timer) wheel_.cancel(state.typing_timer);
+        
+        // Stop typing indicator, after any indicator still queued for the channel
+        queue_typing(state, false);
         
         active_sessions_.erase(it);
     }
@@ -133,71 +164,96 @@ AIProcessMonitor::Stats AIProcessMonitor::get_stats() const {
 }
 
 // ============================================================================
-// Monitoring Thread
+// Deadlines
 // ============================================================================
 
-void AIProcessMonitor::monitor_loop() {
-    LOG_DEBUG("[AIProcessMonitor] monitor thread started");
-    
-    auto last_typing_time = std::chrono::steady_clock::now();
-    
-    while (running_.load()) {
-        auto now = std::chrono::steady_clock::now();
+void AIProcessMonitor::arm_hang_check(const std::string& session_id, AISessionState& state,
+                                      int64_t delay_ms) {
+    if (state.hang_timer) wheel_.cancel(state.hang_timer);
+    uint64_t serial = state.serial;
+    state.hang_timer = wheel_.schedule_in(delay_ms, [this, session_id, serial] {
+        on_hang_check(session_id, serial);
+    }, this);
+}
+
+void AIProcessMonitor::arm_typing(const std::string& session_id, AISessionState& state,
+                                  int64_t delay_ms) {
+    if (state.typing_timer) wheel_.cancel(state.typing_timer);
+    uint64_t serial = state.serial;
+    state.typing_timer = wheel_.schedule_in(delay_ms, [this, session_id, serial] {
+        on_typing(session_id, serial);
+    }, this);
+}
+
+void AIProcessMonitor::on_hang_check(const std::string& session_id, uint64_t serial) {
+    long long elapsed = 0;
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
         
-        // Check all sessions
-        {
-            std::lock_guard<std::mutex> lock(sessions_mutex_);
-            
-            for (auto& entry : active_sessions_) {
-                check_session(entry.first, entry.second);
-            }
-        }
+        auto it = active_sessions_.find(session_id);
+        if (it == active_sessions_.end() || it->second.serial != serial) return;
+        AISessionState& state = it->second;
+        state.hang_timer = 0;
+        if (state.is_hung || !running_.load()) return;
         
-        // Send typing indicators periodically
-        auto elapsed_typing = std::chrono::duration_cast<std::chrono::seconds>(
-            now - last_typing_time
-        ).count();
+        auto since = std::chrono::steady_clock::now() - state.last_heartbeat;
+        int64_t since_ms = std::chrono::duration_cast<std::chrono::milliseconds>(since).count();
+        int64_t timeout_ms = config_.hang_timeout_seconds * 1000LL;
         
-        if (elapsed_typing >= config_.typing_interval_seconds) {
-            std::lock_guard<std::mutex> lock(sessions_mutex_);
-            
-            for (const auto& entry : active_sessions_) {
-                const auto& state = entry.second;
-                send_typing_indicator(state.channel_id, state.chat_id);
-            }
-            
-            last_typing_time = now;
+        // Heartbeats arrived meanwhile: check again a timeout after the last
+        if (since_ms < timeout_ms) {
+            arm_hang_check(session_id, state, timeout_ms - since_ms);
+            return;
         }
         
-        // Sleep
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(config_.check_interval_ms)
-        );
+        state.is_hung = true;
+        elapsed = since_ms / 1000;
     }
     
-    LOG_DEBUG("[AIProcessMonitor] monitor thread exited");
+    total_hung_detected_.fetch_add(1);
+    LOG_WARN("[AIProcessMonitor] HUNG SESSION DETECTED [%s] - no heartbeat for %llds",
+             session_id.c_str(), elapsed);
+    
+    // Invoke callback if set
+    if (hung_callback_) {
+        hung_callback_(session_id, static_cast<int>(elapsed));
+    }
 }
 
-void AIProcessMonitor::check_session(const std::string& session_id, 
-                                     AISessionState& state) {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-        now - state.last_heartbeat
-    ).count();
+void AIProcessMonitor::on_typing(const std::string& session_id, uint64_t serial) {
+    std::lock_guard<std::mutex> lock(sessions_mutex_);
     
-    // Check for hung session
-    if (!state.is_hung && elapsed >= config_.hang_timeout_seconds) {
-        state.is_hung = true;
-        total_hung_detected_.fetch_add(1);
-        
-        LOG_WARN("[AIProcessMonitor] HUNG SESSION DETECTED [%s] - no heartbeat for %llds",
-                 session_id.c_str(), static_cast<long long>(elapsed));
-        
-        // Invoke callback if set
-        if (hung_callback_) {
-            hung_callback_(session_id, static_cast<int>(elapsed));
-        }
-    }
+    auto it = active_sessions_.find(session_id);
+    if (it == active_sessions_.end() || it->second.serial != serial) return;
+    AISessionState& state = it->second;
+    state.typing_timer = 0;
+    if (!running_.load()) return;
+    
+    queue_typing(state, true);
+    arm_typing(session_id, state, std::max(config_.typing_interval_seconds, 1) * 1000LL);
+}
+
+void AIProcessMonitor::queue_typing(const AISessionState& state, bool typing) {
+    // One queued indicator per session is enough while the channel is slow
+    std::shared_ptr<std::atomic<bool> > queued = state.typing_queued;
+    if (typing && queued->exchange(true)) return;
+    
+    // Ordered per chat (an indicator never lands after its stop), but a
+    // slow chat does not hold up the others of the channel
+    std::string channel_id = state.channel_id;
+    std::string chat_id = state.chat_id;
+    Application::instance().thread_pool().enqueue_serial("typing:" + channel_id + ":" + chat_id,
+        [this, channel_id, chat_id, typing, queued] {
+            if (typing) {
+                queued->store(false);
+                send_typing_indicator(channel_id, chat_id);
+                return;
+            }
+            auto& plugins = Application::instance().registry().plugins();
+            for (size_t i = 0; i < plugins.size(); ++i) {
+                plugins[i]->on_typing_indicator(channel_id, chat_id, false);
+            }
+        });
 }
 
 void AIProcessMonitor::send_typing_indicator(const std::string& channel_id,
@@ -226,7 +282,7 @@ void AIProcessMonitor::send_typing_indicator(const std::string& channel_id,
     
     if (send_result.success) {
         total_typing_indicators_sent_.fetch_add(1);
-        LOG_INFO("[AIProcessMonitor] typing indicator sent to %s:%s (total: %d)",
+        LOG_DEBUG("[AIProcessMonitor] typing indicator sent to %s:%s (total: %d)",
                   channel_id.c_str(), chat_id.c_str(), total_typing_indicators_sent_.load());
     } else {
         LOG_WARN("[AIProcessMonitor] failed to send typing indicator to %s:%s - %s",
@@ -11,9 +11,18 @@
 #include <openclaw/core/memory_tool.hpp>
 #include <openclaw/core/message_handler.hpp>
 #include <openclaw/core/utils.hpp>
+#include <openclaw/core/http_client.hpp>
+#include <openclaw/core/timer_wheel.hpp>
+#include <openclaw/core/reactor.hpp>
+#include <openclaw/core/metrics.hpp>
+#include <openclaw/ai/completion_cache.hpp>
 
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include <csignal>
+#include <cstdio>
 #include <cstring>
 #include <unistd.h>
 #include <curl/curl.h>
@@ -41,7 +50,10 @@ void print_usage(const char* prog) {
               << "Usage: " << prog << " [options] [config.json]\n\n"
               << "Options:\n"
               << "  -h, --help     Show this help message\n"
-              << "  -v, --version  Show version\n\n"
+              << "  -v, --version  Show version\n"
+              << "  --profile-startup\n"
+              << "                 Print the wall time of each startup step and plugin\n\n"
+              << "Send SIGHUP to reload limits and timeouts from the config file.\n\n"
               << "Config file format (JSON):\n"
               << "  {\n"
               << "    \"plugins\": [\"telegram\", \"claude\", \"browser\", \"memory\"],\n"
@@ -108,13 +120,71 @@ std::vector<std::string> split_message_chunks(const std::string& text, size_t ma
 // ============================================================================
 
 namespace {
+    // Set by the handler, logged once the main loop has returned
+    volatile sig_atomic_t g_shutdown_signal = 0;
+    
+    // Async-signal-safe only: no logging here, as the log call could land
+    // in the ring of the very thread the signal interrupted
     void signal_handler(int sig) {
-        (void)sig;
+        g_shutdown_signal = sig;
         Application::instance().stop();
-        LOG_INFO("Received shutdown signal");
+    }
+    
+    void reload_signal_handler(int sig) {
+        (void)sig;
+        Application::instance().request_reload();
+    }
+    
+    LogLevel parse_log_level(const std::string& name) {
+        if (name == "debug") return LogLevel::DEBUG;
+        if (name == "warn") return LogLevel::WARN;
+        if (name == "error") return LogLevel::ERROR;
+        return LogLevel::INFO;
+    }
+    
+    DMScope parse_dm_scope(const std::string& name) {
+        if (name == "per_peer") return DMScope::PER_PEER;
+        if (name == "per_channel_peer") return DMScope::PER_CHANNEL_PEER;
+        if (name == "per_account_peer") return DMScope::PER_ACCOUNT_PEER;
+        return DMScope::MAIN;
+    }
+    
+    int64_t steady_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 }
 
+// ============================================================================
+// RuntimeSettings Implementation
+// ============================================================================
+
+RuntimeSettings RuntimeSettings::from_config(const Config& cfg) {
+    RuntimeSettings s;
+    s.log_level = parse_log_level(cfg.get_string("log_level", "info"));
+    
+    s.session_max_history = static_cast<size_t>(cfg.get_int("session.max_history", 20));
+    s.session_timeout = cfg.get_int("session.timeout", 3600);
+    s.session_dm_scope = parse_dm_scope(cfg.get_string("session.dm_scope", "main"));
+    
+    s.max_parallel_tools = static_cast<size_t>(cfg.get_int("agent.max_parallel_tools", 4));
+    s.early_tool_start = cfg.get_bool("agent.early_tool_start", true);
+    
+    s.budget_max_wait_ms = static_cast<int64_t>(cfg.get_int("provider_budget.max_wait_seconds", 60)) * 1000;
+    s.budget_max_skips = static_cast<int>(cfg.get_int("provider_budget.max_skips", 4));
+    
+    s.monitor.hang_timeout_seconds = static_cast<int>(cfg.get_int("ai_monitor.hang_timeout", 30));
+    s.monitor.typing_interval_seconds = static_cast<int>(cfg.get_int("ai_monitor.typing_interval", 3));
+    
+    s.http2 = cfg.get_bool("http.http2", true);
+    s.http_max_idle_per_host = static_cast<size_t>(cfg.get_int("http.max_idle_per_host", 8));
+    
+    s.admission = AdmissionConfig::from_config(cfg);
+    s.recall = RecallConfig::from_config(cfg);
+    s.routing = RoutingConfig::from_config(cfg);
+    return s;
+}
+
 // ============================================================================
 // Application Implementation
 // ============================================================================
@@ -126,10 +196,15 @@ Application& Application::instance() {
 
 Application::Application() 
     : running_(true)
+    , reload_requested_(false)
+    , profile_startup_(false)
     , thread_pool_(8)  // 8 worker threads
+    , compactor_(thread_pool_)
+    , tracer_(thread_pool_)
     , user_limiter_(KeyedRateLimiter::TOKEN_BUCKET, 10, 2)
     , debouncer_(5)
-    , system_prompt_(AppInfo::default_system_prompt())
+    , system_prompt_(std::make_shared<const std::string>(AppInfo::default_system_prompt()))
+    , system_prompt_version_(1)
 {}
 
 bool Application::parse_args(int argc, char* argv[], const char** config_file) {
@@ -144,31 +219,37 @@ bool Application::parse_args(int argc, char* argv[], const char** config_file) {
             print_version();
             return false;
         }
+        if (strcmp(argv[i], "--profile-startup") == 0) {
+            profile_startup_ = true;
+            continue;
+        }
         *config_file = argv[i];
     }
     return true;
 }
 
 void Application::setup_logging() {
-    auto log_level = config_.get_string("log_level", "info");
-    
-    if (log_level == "debug") {
-        Logger::instance().set_level(LogLevel::DEBUG);
-    } else if (log_level == "warn") {
-        Logger::instance().set_level(LogLevel::WARN);
-    } else if (log_level == "error") {
-        Logger::instance().set_level(LogLevel::ERROR);
-    }
+    // The level comes with the runtime settings
+    LogOptions log_options;
+    log_options.async = config_.get_bool("logging.async", true);
+    log_options.format = config_.get_string("logging.format", "text");
+    log_options.file = config_.get_string("logging.file", "");
+    log_options.max_file_bytes = static_cast<size_t>(
+        std::max<int64_t>(0, config_.get_int("logging.max_file_mb", 0))) << 20;
+    log_options.max_files = static_cast<int>(config_.get_int("logging.max_files", 5));
+    log_options.ring_bytes = static_cast<size_t>(
+        std::max<int64_t>(4, config_.get_int("logging.ring_kb", 256))) << 10;
+    Logger::instance().configure(log_options);
     
     // Load custom system prompt from config
     auto custom_prompt = config_.get_string("system_prompt", "");
     if (!custom_prompt.empty()) {
-        system_prompt_ = custom_prompt;
+        set_system_prompt(custom_prompt);
         LOG_DEBUG("Using custom system prompt from config");
     }
 }
 
-void Application::setup_skills() {
+Application::SkillScan Application::scan_skills() {
     LOG_INFO("Initializing skills system...");
     
     SkillsConfig skills_config;
@@ -185,38 +266,88 @@ void Application::setup_skills() {
     LOG_INFO("Loaded %zu skills (%zu eligible for this environment)", 
              entries.size(), eligible.size());
     
-    // Store for later use
-    skill_entries_ = std::move(eligible);
-    skill_command_specs_ = skill_manager_.build_workspace_skill_command_specs(&entries, nullptr, nullptr);
+    SkillScan scan;
+    scan.entries = std::move(eligible);
+    scan.command_table = SkillCommandTable(
+        skill_manager_.build_workspace_skill_command_specs(&entries, nullptr, nullptr));
     
-    LOG_DEBUG("[Skills] Built %zu skill command specs", skill_command_specs_.size());
-    for (const auto& spec : skill_command_specs_) {
+    LOG_DEBUG("[Skills] Built %zu skill command specs", scan.command_table.specs().size());
+    for (const auto& spec : scan.command_table.specs()) {
         LOG_DEBUG("[Skills]   /%s -> skill '%s' (%s)", spec.name.c_str(), spec.skill_name.c_str(), spec.description.c_str());
     }
     
+    if (!scan.entries.empty()) {
+        scan.prompt_section = skill_manager_.build_skills_section(&entries);
+    }
+    return scan;
+}
+
+void Application::apply_skills(SkillScan& scan) {
+    skill_entries_ = std::move(scan.entries);
+    skill_command_table_ = std::move(scan.command_table);
+    
     // Append skills section to system prompt
-    if (!skill_entries_.empty()) {
-        auto skills_section = skill_manager_.build_skills_section(&entries);
-        if (!skills_section.empty()) {
-            system_prompt_ += "\n\n" + skills_section;
-            LOG_DEBUG("Appended skills section to system prompt");
-            
-            auto prompt_size = system_prompt_.size();
-            if (prompt_size > 20000) {
-                LOG_WARN("System prompt is very large (%zu chars). This may consume significant context window.",
-                         prompt_size);
-            } else if (prompt_size > 10000) {
-                LOG_WARN("System prompt is large (%zu chars).", prompt_size);
-            }
-            LOG_DEBUG("Final system prompt size: %zu characters (~%zu tokens)", 
-                      prompt_size, prompt_size / 4);
+    if (!scan.prompt_section.empty()) {
+        set_system_prompt(*system_prompt() + "\n\n" + scan.prompt_section);
+        LOG_DEBUG("Appended skills section to system prompt");
+        
+        auto prompt_size = system_prompt()->size();
+        if (prompt_size > 20000) {
+            LOG_WARN("System prompt is very large (%zu chars). This may consume significant context window.",
+                     prompt_size);
+        } else if (prompt_size > 10000) {
+            LOG_WARN("System prompt is large (%zu chars).", prompt_size);
         }
+        LOG_DEBUG("Final system prompt size: %zu characters (~%zu tokens)", 
+                  prompt_size, prompt_size / 4);
     }
 }
 
 void Application::setup_agent() {
     LOG_INFO("Initializing agent tools...");
     
+    agent_.set_native_tools(config_.get_bool("agent.native_tools", false));
+    
+    if (config_.get_bool("provider_budget.enabled", true)) {
+        agent_.set_budget(&provider_budget_);
+    }
+    
+    // Large tool results: LRU over a memory budget, then an on-disk spill file
+    size_t chunk_memory_mb = static_cast<size_t>(config_.get_int("agent.chunk_memory_mb", 64));
+    size_t chunk_spill_mb = static_cast<size_t>(config_.get_int("agent.chunk_spill_mb", 256));
+    agent_.chunker().configure(chunk_memory_mb << 20, chunk_spill_mb << 20,
+                               config_.get_string("agent.chunk_spill_dir", "/tmp"));
+    
+    // Exact-match cache for calls that opt in (CompletionOptions::cache_response)
+    CompletionCache::Config cache;
+    cache.memory_bytes = static_cast<size_t>(config_.get_int("completion_cache.memory_mb", 16)) << 20;
+    cache.db_path = config_.get_string("completion_cache.db_path", "");
+    cache.ttl_seconds = config_.get_int("completion_cache.ttl_seconds", 86400);
+    cache.max_disk_entries = static_cast<size_t>(config_.get_int("completion_cache.max_disk_entries", 10000));
+    CompletionCache::instance().configure(cache, &thread_pool_);
+    
+    HistoryCompactor::Config compaction;
+    compaction.enabled = config_.get_bool("compaction.enabled", true);
+    compaction.threshold_tokens = config_.get_int("compaction.threshold_tokens", 0);
+    compaction.keep_recent = static_cast<size_t>(config_.get_int("compaction.keep_recent", 8));
+    compaction.provider = config_.get_string("compaction.provider", "");
+    compaction.model = config_.get_string("compaction.model", "");
+    compaction.summary_tokens = config_.get_int("compaction.summary_tokens", 1024);
+    compaction.batch = config_.get_bool("compaction.batch", false);
+    compactor_.set_config(compaction);
+    
+    TraceExporter::Config tracing;
+    tracing.file = config_.get_string("trace.file", "");
+    tracing.format = config_.get_string("trace.format", "jsonl");
+    tracing.otlp_endpoint = config_.get_string("trace.otlp_endpoint", "");
+    tracing.service_name = config_.get_string("trace.service_name", "openclaw");
+    tracer_.set_config(tracing);
+    if (tracer_.enabled()) {
+        LOG_INFO("Agent turn traces: %s%s%s", tracing.file.empty() ? "" : tracing.file.c_str(),
+                 (!tracing.file.empty() && !tracing.otlp_endpoint.empty()) ? ", " : "",
+                 tracing.otlp_endpoint.c_str());
+    }
+    
     // Built-in tools are now registered via BuiltinToolsProvider
     // which will be initialized along with other plugins in setup_plugins()
     
@@ -233,9 +364,13 @@ void Application::setup_plugins() {
         loader_.add_search_path(plugins_dir);
     }
     
-    // Load external plugins from config
+    // Load external plugins from config. dlopen holds the dynamic loader's
+    // lock, so loading stays sequential; init below is what runs in parallel.
     int loaded = loader_.load_from_config(config_);
     LOG_INFO("Loaded %d external plugins", loaded);
+    for (const auto& plugin : loader_.plugins()) {
+        record_phase(std::string("plugin load: ") + plugin.info.name, plugin.load_us);
+    }
     
     // Register internal/core tool providers (built into the binary)
     static BuiltinToolsProvider builtin_tools_provider;
@@ -265,10 +400,45 @@ void Application::setup_plugins() {
     // Register core commands
     register_core_commands(config_, registry());
 
-    // Initialize all plugins
-    registry().init_all(config_);
+    // Initialize all plugins, independent ones concurrently on the pool
+    bool parallel = config_.get_bool("startup.parallel_init", true);
+    int64_t init_start = steady_us();
+    registry().init_all(config_, parallel ? &thread_pool_ : nullptr);
+    record_phase(parallel ? "plugin init (parallel)" : "plugin init", steady_us() - init_start);
+    for (const auto& st : registry().init_stats()) {
+        record_phase("  " + st.name + (st.ok ? "" : " (failed)"), st.duration_us);
+    }
     
     LOG_INFO("Registered %zu commands", registry().commands().size());
+    
+    // Spread AI calls over the configured providers by measured health
+    if (config_.get_bool("ai_router.enabled", false)) {
+        std::vector<std::string> names = split(config_.get_string("ai_router.providers", ""), ',');
+        if (names.empty()) {
+            for (auto* ai : registry().ai_providers()) ai_router_.add_backend(ai);
+        }
+        for (const auto& name : names) {
+            auto* ai = registry().get_ai(trim(name));
+            if (ai) {
+                ai_router_.add_backend(ai);
+            } else {
+                LOG_WARN("[Router] Unknown AI provider: %s", trim(name).c_str());
+            }
+        }
+        ai_router_.init(config_);
+        
+        if (ai_router_.backend_count() > 1) {
+            // The router reserves budget per backend it picks
+            if (agent_.budget()) {
+                ai_router_.set_budget(agent_.budget());
+                agent_.set_budget(nullptr);
+            }
+            registry().set_default_ai(&ai_router_);
+            LOG_INFO("AI router enabled over %zu providers", ai_router_.backend_count());
+        } else {
+            LOG_WARN("AI router needs at least two providers; using the default provider");
+        }
+    }
 
     // Set up chunker reference for builtin tools
     builtin_tools_provider.set_chunker(&agent_.chunker());
@@ -303,7 +473,11 @@ void Application::setup_channels() {
     // Start channels
     int started_count = 0;
     for (auto* channel : channels) {
-        if (channel->is_initialized() && channel->start()) {
+        if (!channel->is_initialized()) continue;
+        int64_t start = steady_us();
+        bool started = channel->start();
+        record_phase(std::string("channel start: ") + channel->channel_id(), steady_us() - start);
+        if (started) {
             LOG_INFO("Started channel: %s", channel->channel_id());
             started_count++;
         }
@@ -320,7 +494,7 @@ void Application::setup_channels() {
     }
     
     if (has_gateway) {
-        LOG_INFO("Gateway service available - will start on first poll");
+        LOG_INFO("Gateway service available - will start with the main loop");
     }
     
     // Log AI status
@@ -334,6 +508,32 @@ void Application::setup_channels() {
     LOG_INFO("%d channel(s) started, ready to receive messages", started_count);
 }
 
+void Application::setup_metrics() {
+    // Gauges read state the pool and session manager already keep
+    Metrics& metrics = Metrics::instance();
+    static const char* lanes[] = { "high", "normal", "low" };
+    for (size_t i = 0; i < TASK_PRIORITY_COUNT; ++i) {
+        TaskPriority lane = static_cast<TaskPriority>(i);
+        std::vector<std::string> label(1, "lane");
+        std::vector<std::string> value(1, lanes[i]);
+        ThreadPool* pool = &thread_pool_;
+        metrics.gauge("openclaw_thread_pool_queued", "Tasks waiting for a worker",
+                      [pool, lane] { return static_cast<double>(pool->lane_stats(lane).queued); },
+                      label, value);
+        metrics.gauge("openclaw_thread_pool_running", "Tasks running",
+                      [pool, lane] { return static_cast<double>(pool->lane_stats(lane).running); },
+                      label, value);
+        metrics.gauge("openclaw_thread_pool_completed", "Tasks completed since start",
+                      [pool, lane] { return static_cast<double>(pool->lane_stats(lane).completed); },
+                      label, value);
+        metrics.gauge("openclaw_thread_pool_wait_seconds", "Total time tasks waited for a worker",
+                      [pool, lane] { return static_cast<double>(pool->lane_stats(lane).total_wait_us) / 1e6; },
+                      label, value);
+    }
+    metrics.gauge("openclaw_sessions", "Sessions held in memory",
+                  [] { return static_cast<double>(SessionManager::instance().session_count()); });
+}
+
 bool Application::init(int argc, char* argv[]) {
     // Initialize libcurl globally (before threads start)
     curl_global_init(CURL_GLOBAL_ALL);
@@ -344,14 +544,19 @@ bool Application::init(int argc, char* argv[]) {
         return false;
     }
     
+    int64_t init_start = steady_us();
+    int64_t phase_start = init_start;
+    
     // Setup signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGHUP, reload_signal_handler);
     
     LOG_INFO("%s v%s starting...", AppInfo::NAME, AppInfo::VERSION);
     
     // Load configuration
     if (config_file) {
+        config_path_ = config_file;
         if (!config_.load_file(config_file)) {
             LOG_WARN("Failed to load config from %s, using defaults", config_file);
         } else {
@@ -359,24 +564,86 @@ bool Application::init(int argc, char* argv[]) {
         }
     }
     
-    // Setup components in order
+    // Limits, timeouts and pool sizes that reloads can change later
+    settings_.set(RuntimeSettings::from_config(config_));
+    apply_settings(*settings());
+    record_phase("config", steady_us() - phase_start);
+    
+    phase_start = steady_us();
     setup_logging();
-    setup_skills();
+    record_phase("logging", steady_us() - phase_start);
+    
+    // Scanning the skill directories is file I/O nothing else needs until
+    // messages arrive; it overlaps agent and plugin setup and is joined
+    // before channels start. Only the scan runs on the thread: the tables
+    // and the prompt are set here after the join.
+    bool parallel = config_.get_bool("startup.parallel_init", true);
+    int64_t skills_us = 0;
+    SkillScan skills;
+    auto timed_skills = [this, &skills_us, &skills] {
+        int64_t start = steady_us();
+        skills = scan_skills();
+        skills_us = steady_us() - start;
+    };
+    std::thread skills_thread;
+    if (parallel) {
+        skills_thread = std::thread(timed_skills);
+    } else {
+        timed_skills();
+    }
+    
+    phase_start = steady_us();
+    
+    user_limiter_.set_idle_expiry(3600);
+    
+    // Instances on one host can share rate limits and dedup state
+    if (config_.get_string("rate_limit.shared", "") == "shm") {
+        ShmRateLimitStore::Config shm_config;
+        shm_config.name = config_.get_string("rate_limit.shm_name", shm_config.name);
+        shm_config.slots = static_cast<size_t>(config_.get_int("rate_limit.shm_slots",
+            static_cast<int>(shm_config.slots)));
+        if (limit_store_.open(shm_config)) {
+            user_limiter_.set_store(&limit_store_, "user:",
+                                    config_.get_int("rate_limit.lease_batch", 4));
+            debouncer_.set_store(&limit_store_);
+        }
+    }
     
-    // Configure session manager
-    sessions().set_max_history(static_cast<size_t>(
-        config_.get_int("session.max_history", 20)));
+    // Conversations survive restarts in per-session logs (also the memory
+    // indexer's transcripts); histories load lazily on first use
+    if (config_.get_bool("session.persist", true)) {
+        SessionStore::Config store_config;
+        store_config.dir = config_.get_string("session.dir",
+            config_.get_string("workspace_dir", ".") + "/.openclaw/sessions");
+        store_config.commit_interval_ms = config_.get_int("session.commit_interval_ms", 10);
+        store_config.fsync = config_.get_bool("session.fsync", true);
+        if (session_store_.open(store_config)) {
+            sessions().set_backend(&session_store_);
+        }
+    }
     
+    setup_metrics();
+    record_phase("sessions and rate limits", steady_us() - phase_start);
+    
+    phase_start = steady_us();
     setup_agent();
+    record_phase("agent", steady_us() - phase_start);
+    
+    phase_start = steady_us();
     setup_plugins();
+    record_phase("plugins", steady_us() - phase_start);
+    
+    if (skills_thread.joinable()) skills_thread.join();
+    apply_skills(skills);
+    record_phase(parallel ? "skills (overlapped)" : "skills", skills_us);
+    
+    phase_start = steady_us();
     setup_channels();
+    record_phase("channels", steady_us() - phase_start);
     
-    // Start AI process monitor
-    AIProcessMonitor::Config monitor_config;
-    monitor_config.hang_timeout_seconds = config_.get_int("ai_monitor.hang_timeout", 30);
-    monitor_config.typing_interval_seconds = config_.get_int("ai_monitor.typing_interval", 3);
-    monitor_config.check_interval_ms = config_.get_int("ai_monitor.check_interval_ms", 1000);
-    ai_monitor_.set_config(monitor_config);
+    // After the gateway, whose server then carries the forwards
+    cluster_.start(Cluster::Settings::from_config(config_),
+                   [this](const Message& msg) { return accept_from_cluster(msg); });
     
     // Set hung session callback
     ai_monitor_.set_hung_callback([](const std::string& session_id, int elapsed_seconds) {
@@ -388,6 +655,8 @@ bool Application::init(int argc, char* argv[]) {
     ai_monitor_.start();
     LOG_INFO("AI process monitor started");
     
+    if (profile_startup_) report_startup(steady_us() - init_start);
+    
     // Verify we have something to run
     auto* gateway = registry().get_plugin("gateway");
     bool has_gateway = (gateway != nullptr && gateway->is_initialized());
@@ -404,10 +673,130 @@ bool Application::init(int argc, char* argv[]) {
     return true;
 }
 
+void Application::record_phase(const std::string& name, int64_t us) {
+    if (profile_startup_) startup_phases_.push_back(StartupPhase{name, us});
+}
+
+void Application::report_startup(int64_t total_us) const {
+    fprintf(stderr, "Startup profile (wall time):\n");
+    for (const auto& phase : startup_phases_) {
+        fprintf(stderr, "  %-40s %10.2f ms\n", phase.name.c_str(), phase.us / 1000.0);
+    }
+    fprintf(stderr, "  %-40s %10.2f ms\n", "total", total_us / 1000.0);
+}
+
+void Application::apply_settings(const RuntimeSettings& settings) {
+    Logger::instance().set_level(settings.log_level);
+#if OPENCLAW_MIN_LOG_LEVEL > 0
+    if (settings.log_level == LogLevel::DEBUG) {
+        LOG_WARN("log_level debug: debug logging is compiled out of this build (LOG_MIN_LEVEL=%d)",
+                 OPENCLAW_MIN_LOG_LEVEL);
+    }
+#endif
+    
+    sessions().set_max_history(settings.session_max_history);
+    sessions().set_idle_expiry(settings.session_timeout);
+    sessions().set_dm_scope(settings.session_dm_scope);
+    
+    agent_.set_max_parallel_tools(settings.max_parallel_tools);
+    agent_.set_early_tool_start(settings.early_tool_start);
+    provider_budget_.set_max_wait(settings.budget_max_wait_ms);
+    provider_budget_.set_max_skips(settings.budget_max_skips);
+    
+    // Admission limits are read per message; the hard queue bound is the pool's
+    thread_pool_.set_capacity(settings.admission.queue_capacity);
+    
+    ai_monitor_.set_config(settings.monitor);
+    
+    // Shared HTTP connection pool (before any plugin makes requests)
+    HttpConnectionPool::instance().configure(settings.http2, settings.http_max_idle_per_host);
+}
+
+void Application::request_reload() {
+    reload_requested_.store(true);
+    Reactor::instance().wake();
+}
+
+bool Application::reload_config() {
+    if (config_path_.empty()) {
+        LOG_WARN("Config reload: started without a config file");
+        return false;
+    }
+    Config fresh;
+    if (!fresh.load_file(config_path_)) {
+        LOG_WARN("Config reload: cannot load %s, keeping the current settings", config_path_.c_str());
+        return false;
+    }
+    
+    settings_.set(RuntimeSettings::from_config(fresh));
+    apply_settings(*settings());
+    if (ai_router_.is_initialized()) {
+        ai_router_.reconfigure(fresh);
+    }
+    registry().reconfigure_all(fresh);
+    if (cluster_.reconfigure(Cluster::Settings::from_config(fresh))) {
+        hand_off_sessions();
+    }
+    
+    LOG_INFO("Reloaded config from %s", config_path_.c_str());
+    return true;
+}
+
+bool Application::accept_from_cluster(const Message& msg) {
+    if (!accept_message(msg)) return false;
+    // A turn run for an unreachable owner: drop the copy afterwards, or it
+    // would be stale the next time the owner is down
+    std::string key = sessions().session_key_for_message(msg);
+    if (!cluster_.owns(key)) {
+        thread_pool_.enqueue_serial(key, [this, key] {
+            sessions().remove_session(key);
+            session_store_.release(key);
+        }, TaskPriority::HIGH);
+    }
+    return true;
+}
+
+void Application::hand_off_sessions() {
+    // Each session goes after the turns already queued on its strand; the
+    // new owner holds its messages meanwhile (cluster.handoff_ms)
+    size_t moved = 0;
+    for (const std::string& key : sessions().session_keys()) {
+        if (cluster_.owns(key)) continue;
+        thread_pool_.enqueue_serial(key, [this, key] {
+            sessions().remove_session(key);
+            session_store_.release(key);
+        }, TaskPriority::HIGH);
+        moved++;
+    }
+    LOG_INFO("[Cluster] Handing off %zu session(s) to other nodes", moved);
+}
+
+SharedPrompt Application::system_prompt() const {
+    std::lock_guard<std::mutex> lock(system_prompt_mutex_);
+    return system_prompt_;
+}
+
+uint64_t Application::system_prompt_version() const {
+    std::lock_guard<std::mutex> lock(system_prompt_mutex_);
+    return system_prompt_version_;
+}
+
+void Application::set_system_prompt(const std::string& prompt) {
+    std::lock_guard<std::mutex> lock(system_prompt_mutex_);
+    // An identical rebuild keeps the old snapshot, and with it the
+    // provider's cached prompt prefix
+    if (*system_prompt_ == prompt) {
+        return;
+    }
+    system_prompt_ = std::make_shared<const std::string>(prompt);
+    system_prompt_version_++;
+    LOG_DEBUG("System prompt v%llu (%zu chars)",
+              static_cast<unsigned long long>(system_prompt_version_), prompt.size());
+}
+
 void Application::rebuild_system_prompt() {
     // Rebuild with current skills
-    auto base_prompt = config_.get_string("system_prompt", AppInfo::default_system_prompt());
-    system_prompt_ = base_prompt;
+    std::string prompt = config_.get_string("system_prompt", AppInfo::default_system_prompt());
     
     auto entries = skill_manager_.load_workspace_skill_entries();
     auto eligible = skill_manager_.filter_skill_entries(entries, nullptr);
@@ -415,9 +804,10 @@ void Application::rebuild_system_prompt() {
     if (!eligible.empty()) {
         auto snapshot = skill_manager_.build_workspace_skill_snapshot(&entries, nullptr);
         if (!snapshot.prompt.empty()) {
-            system_prompt_ += "\n\n" + snapshot.prompt;
+            prompt += "\n\n" + snapshot.prompt;
         }
     }
+    set_system_prompt(prompt);
     
     LOG_DEBUG("System prompt rebuilt with %zu eligible skills", eligible.size());
 }
@@ -425,40 +815,90 @@ void Application::rebuild_system_prompt() {
 int Application::run() {
     LOG_INFO("Entering main loop");
     
+    Reactor& reactor = Reactor::instance();
+    
+    // Plugins that still poll get a repeating timer at their own interval
+    std::vector<Reactor::TimerId> poll_timers;
+    const std::vector<Plugin*>& plugins = registry().plugins();
+    for (size_t i = 0; i < plugins.size(); ++i) {
+        Plugin* plugin = plugins[i];
+        int interval = plugin->poll_interval_ms();
+        if (interval <= 0) continue;
+        Reactor::TimerId id = reactor.add_timer(interval, interval, [plugin] { plugin->poll(); });
+        if (id) poll_timers.push_back(id);
+    }
+    LOG_DEBUG("Main loop: %zu polling plugin(s), %zu watched fd(s)",
+              poll_timers.size(), reactor.fd_count());
+    
+    // A timer scheduled earlier than the current wait shortens it
+    TimerWheel::instance().set_wakeup_hook([] { Reactor::instance().wake(); });
+    
     while (running_.load()) {
-        // Poll all plugins
-        registry().poll_all();
-        sleep_ms(100);
+        // Sleep until a descriptor, timer or post is ready, or until the
+        // wheel's next deadline
+        int64_t wakeup_ms = TimerWheel::instance().next_wakeup_ms();
+        int timeout = -1;
+        if (wakeup_ms >= 0) {
+            int64_t wait_ms = wakeup_ms - current_timestamp_ms();
+            timeout = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(wait_ms, 60000)));
+        }
+        reactor.run_once(timeout);
         
-        // Periodic cleanup (~10 seconds)
-        static int cleanup_counter = 0;
-        if (++cleanup_counter >= 100) {
-            cleanup_counter = 0;
-            sessions().cleanup_inactive(3600);  // 1 hour timeout
-            user_limiter_.cleanup(3600);
+        if (reload_requested_.exchange(false)) {
+            reload_config();
         }
+        
+        // Expire idle sessions, rate-limiter keys and stale typing state,
+        // and run AI monitor deadlines; only entries that are due are touched
+        TimerWheel::instance().advance();
+    }
+    
+    if (g_shutdown_signal != 0) {
+        LOG_INFO("Received shutdown signal (%d)", static_cast<int>(g_shutdown_signal));
+    }
+    
+    TimerWheel::instance().set_wakeup_hook(TimerWheel::Callback());
+    for (size_t i = 0; i < poll_timers.size(); ++i) {
+        reactor.cancel_timer(poll_timers[i]);
     }
     
     return 0;
 }
 
+void Application::stop() {
+    running_.store(false);
+    Reactor::instance().wake();
+}
+
 void Application::shutdown() {
     LOG_INFO("Shutting down...");
     
     // Stop AI monitor first
     ai_monitor_.stop();
     
+    // Other nodes fall back to handling our sessions themselves
+    cluster_.stop();
+    
+    // Stop async HTTP first: in-flight AI turns fail fast and finish on the pool
+    AsyncHttpEngine::instance().shutdown();
+    
     // Stop thread pool (wait for pending)
     thread_pool_.shutdown();
     
+    // Finished turns are persisted by now; write out the last batch
+    sessions().set_backend(nullptr);
+    session_store_.close();
+    
     registry().stop_all_channels();
     registry().shutdown_all();
     loader_.unload_all();
     
-    // Cleanup libcurl
+    // Cleanup libcurl (pooled handles first)
+    HttpConnectionPool::instance().clear();
     curl_global_cleanup();
     
     LOG_INFO("Goodbye!");
+    Logger::instance().shutdown();
 }
 
 } // namespace openclaw
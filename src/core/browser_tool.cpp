@@ -5,6 +5,8 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
+#include <condition_variable>
+#include <mutex>
 
 namespace openclaw {
 
@@ -42,11 +44,38 @@ static bool get_optional_bool(const Json& params, const std::string& key, bool d
     return default_value;
 }
 
+// URLs a single fetch_many call accepts
+const size_t fetch_many_max_urls = 20;
+
+// Host part of a normalized URL, for the per-host limit
+static std::string url_host(const std::string& url) {
+    size_t start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    return url.substr(start, url.find('/', start) - start);
+}
+
+// Split budget over texts of the given lengths: each gets at most an equal
+// share of what is left, and what short ones do not use goes to the rest
+static std::vector<size_t> share_budget(const std::vector<size_t>& lengths, size_t budget) {
+    std::vector<size_t> order(lengths.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&lengths](size_t a, size_t b) {
+        return lengths[a] < lengths[b];
+    });
+
+    std::vector<size_t> shares(lengths.size(), 0);
+    for (size_t k = 0; k < order.size(); ++k) {
+        size_t share = budget / (order.size() - k);
+        shares[order[k]] = std::min(lengths[order[k]], share);
+        budget -= shares[order[k]];
+    }
+    return shares;
+}
+
 } // namespace
 
 BrowserTool::BrowserTool()
-    : max_content_length_(100000)
-    , timeout_secs_(30) {
+    : timeout_secs_(30) {
 }
 
 const char* BrowserTool::name() const { return "browser"; }
@@ -62,6 +91,7 @@ std::vector<std::string> BrowserTool::actions() const {
     result.push_back("fetch");
     result.push_back("extract_text");
     result.push_back("get_links");
+    result.push_back("fetch_many");
     result.push_back("status");
     return result;
 }
@@ -74,6 +104,7 @@ std::vector<AgentTool> BrowserTool::get_agent_tools() const {
     {
         AgentTool tool;
         tool.name = "browser_fetch";
+        tool.parallel_safe = true;
         tool.description = "Fetch raw HTML content from a URL. Returns the full HTML source code.";
         tool.params.push_back(ToolParamSchema("url", "string", "The URL to fetch (must start with http:// or https://)", true));
         tool.params.push_back(ToolParamSchema("max_length", "number", "Maximum content length to return (default: 100000)", false));
@@ -94,6 +125,7 @@ std::vector<AgentTool> BrowserTool::get_agent_tools() const {
     {
         AgentTool tool;
         tool.name = "browser_extract_text";
+        tool.parallel_safe = true;
         tool.description = "Extract readable plain text from a URL or HTML content. Strips all HTML tags, scripts, and styles. Best for reading article content.";
         tool.params.push_back(ToolParamSchema("url", "string", "The URL to fetch and extract text from", false));
         tool.params.push_back(ToolParamSchema("html", "string", "Raw HTML content to extract text from (alternative to url)", false));
@@ -118,6 +150,7 @@ std::vector<AgentTool> BrowserTool::get_agent_tools() const {
     {
         AgentTool tool;
         tool.name = "browser_get_links";
+        tool.parallel_safe = true;
         tool.description = "Extract all hyperlinks from a URL or HTML content. Returns a list of URLs with their link text.";
         tool.params.push_back(ToolParamSchema("url", "string", "The URL to fetch and extract links from", false));
         tool.params.push_back(ToolParamSchema("html", "string", "Raw HTML content to extract links from (alternative to url)", false));
@@ -134,20 +167,64 @@ std::vector<AgentTool> BrowserTool::get_agent_tools() const {
         tools.push_back(tool);
     }
     
+    // browser_fetch_many - Fetch several URLs at once
+    {
+        AgentTool tool;
+        tool.name = "browser_fetch_many";
+        tool.parallel_safe = true;
+        tool.description = "Fetch several URLs concurrently and return the readable text of each. "
+                           "Use this instead of repeated browser_fetch calls when you already know the URLs "
+                           "(up to 20). The text is truncated to a budget shared by all pages.";
+        tool.params.push_back(ToolParamSchema("urls", "array", "URLs to fetch (each must start with http:// or https://)", true));
+        tool.params.push_back(ToolParamSchema("max_length", "number", "Total text length across all pages (default: 100000)", false));
+        
+        tool.execute = [self](const Json& params) -> AgentToolResult {
+            ToolResult result = self->execute("fetch_many", params);
+            if (!result.success) {
+                return AgentToolResult::fail(result.error);
+            }
+            return AgentToolResult::ok(result.data.dump(2));
+        };
+        
+        tools.push_back(tool);
+    }
+    
     return tools;
 }
 
+BrowserTool::Settings BrowserTool::Settings::from_config(const Config& cfg) {
+    Settings s;
+    s.max_content_length = static_cast<size_t>(std::max<int64_t>(0, cfg.get_int("browser.max_content_length", 100000)));
+    s.fetch_many_concurrency = static_cast<size_t>(std::max<int64_t>(1, cfg.get_int("browser.fetch_many_concurrency", 8)));
+    s.fetch_many_per_host = static_cast<size_t>(std::max<int64_t>(1, cfg.get_int("browser.fetch_many_per_host", 2)));
+    return s;
+}
+
 bool BrowserTool::init(const Config& cfg) {
-    max_content_length_ = cfg.get_int("browser.max_content_length", 100000);
+    settings_.set(Settings::from_config(cfg));
     timeout_secs_ = cfg.get_int("browser.timeout", 30);
+    http_.set_timeout(timeout_secs_ * 1000L);
+
+    // Shared fetch cache (memory LRU, optional SQLite tier)
+    WebCache::Config cache;
+    cache.memory_bytes = static_cast<size_t>(cfg.get_int("browser.cache_memory_mb", 32)) << 20;
+    cache.db_path = cfg.get_string("browser.cache_db_path", "");
+    cache.default_ttl_seconds = cfg.get_int("browser.cache_default_ttl", 300);
+    cache.max_body_bytes = static_cast<size_t>(cfg.get_int("browser.cache_max_body_mb", 8)) << 20;
+    cache.max_disk_entries = static_cast<size_t>(cfg.get_int("browser.cache_max_disk_entries", 5000));
+    WebCache::instance().configure(cache);
 
     LOG_INFO("Browser tool initialized (max_content=%zu, timeout=%ds)",
-             max_content_length_, timeout_secs_);
+             settings_.get()->max_content_length, timeout_secs_);
 
     initialized_ = true;
     return true;
 }
 
+void BrowserTool::reconfigure(const Config& cfg) {
+    settings_.set(Settings::from_config(cfg));
+}
+
 void BrowserTool::shutdown() {
     initialized_ = false;
 }
@@ -159,6 +236,8 @@ ToolResult BrowserTool::execute(const std::string& action, const Json& params) {
         return do_extract_text(params);
     } else if (action == "get_links") {
         return do_get_links(params);
+    } else if (action == "fetch_many") {
+        return do_fetch_many(params);
     } else if (action == "status") {
         return do_status();
     }
@@ -169,23 +248,21 @@ ToolResult BrowserTool::execute(const std::string& action, const Json& params) {
     return result;
 }
 
-ToolResult BrowserTool::do_fetch(const Json& params) {
-    ToolResult result;
-
+bool BrowserTool::load_page(const Json& params, WebFetchResult& fetch, ToolResult& failure) {
     // Validate URL parameter
     if (!params.contains("url") || !params["url"].is_string()) {
-        result.success = false;
-        result.error = "Missing required parameter: url";
-        return result;
+        failure.success = false;
+        failure.error = "Missing required parameter: url";
+        return false;
     }
 
     std::string url = params["url"].get<std::string>();
 
     // Validate URL format
     if (url.find("http://") != 0 && url.find("https://") != 0) {
-        result.success = false;
-        result.error = "URL must start with http:// or https://";
-        return result;
+        failure.success = false;
+        failure.error = "URL must start with http:// or https://";
+        return false;
     }
 
     // Set up headers
@@ -194,87 +271,100 @@ ToolResult BrowserTool::do_fetch(const Json& params) {
     headers["Accept"] = "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8";
     headers["Accept-Language"] = "en-US,en;q=0.5";
 
-    // Add custom headers if provided
+    // Custom headers may change the response, so they bypass the cache
+    bool custom = false;
     if (params.contains("headers") && params["headers"].is_object()) {
         const Json& custom_headers = params["headers"];
         for (auto it = custom_headers.begin(); it != custom_headers.end(); ++it) {
             if (it.value().is_string()) {
                 headers[it.key()] = it.value().get<std::string>();
+                custom = true;
             }
         }
     }
 
-    // Make HTTP request
-    HttpResponse response = http_.get(url, headers);
+    if (custom) {
+        fetch.page = WebCache::to_page(url, http_.get(url, headers));
+        fetch.cache = "bypass";
+    } else {
+        fetch = WebCache::instance().get(http_, url, headers);
+    }
+
+    long status = fetch.page->status_code;
+    if (status < 200 || status >= 300) {
+        Json data;
+        data["url"] = url;
+        data["status_code"] = status;
+        data["success"] = false;
+        data["error"] = "HTTP request failed with status " + std::to_string(status);
+        failure.success = false;
+        failure.error = data["error"].get<std::string>();
+        failure.data = data;
+        return false;
+    }
+    return true;
+}
+
+ToolResult BrowserTool::do_fetch(const Json& params) {
+    ToolResult result;
+    WebFetchResult fetch;
+    if (!load_page(params, fetch, result)) {
+        return result;
+    }
+    const WebPage& page = *fetch.page;
 
     // Build result data
     Json data;
-    data["url"] = url;
-    data["status_code"] = response.status_code;
-    data["success"] = (response.status_code >= 200 && response.status_code < 300);
-
-    if (response.status_code >= 200 && response.status_code < 300) {
-        // Optional behavior controls
-        size_t max_len = get_optional_size(params, "max_length", max_content_length_);
-        size_t chunk_size = get_optional_size(params, "chunk_size", 0);
-        size_t max_chunks = get_optional_size(params, "max_chunks", 20);
-        bool extract_text = get_optional_bool(params, "extract_text", false);
-
-        std::string content = response.body;
-        if (extract_text) {
-            content = normalize_whitespace(strip_html(content));
-        }
+    data["url"] = page.url;
+    data["status_code"] = page.status_code;
+    data["success"] = true;
+    data["cache"] = fetch.cache;
 
-        bool truncated = false;
-        size_t original_length = content.length();
-        if (content.length() > max_len) {
-            content = content.substr(0, max_len);
-            truncated = true;
-        }
+    // Optional behavior controls
+    size_t max_len = get_optional_size(params, "max_length", settings_.get()->max_content_length);
+    size_t chunk_size = get_optional_size(params, "chunk_size", 0);
+    size_t max_chunks = get_optional_size(params, "max_chunks", 20);
+    bool extract_text = get_optional_bool(params, "extract_text", false);
 
-        data["truncated"] = truncated;
-        data["original_length"] = static_cast<int64_t>(original_length);
+    // Text extraction stops at max_len, so the full length is then unknown
+    std::shared_ptr<const WebText> text;
+    if (extract_text) {
+        text = page.text(max_len);
+    }
+    const std::string& full = text ? text->text : page.body;
+    bool complete = !text || text->complete;
 
-        if (chunk_size > 0) {
-            std::vector<std::string> chunks = chunk_text(content, chunk_size, max_chunks);
-            Json chunks_array = Json::array();
-            for (size_t i = 0; i < chunks.size(); ++i) {
-                chunks_array.push_back(chunks[i]);
-            }
-            data["chunks"] = chunks_array;
-            data["chunk_count"] = static_cast<int64_t>(chunks.size());
-            data["content_length"] = static_cast<int64_t>(content.length());
-            if (content.length() > chunk_size * max_chunks) {
-                data["truncated"] = true;
-            }
-        } else {
-            data["content"] = content;
-            data["content_length"] = static_cast<int64_t>(content.length());
-        }
+    std::string content = full.substr(0, max_len);
+    data["truncated"] = !complete || full.length() > max_len;
+    if (complete) {
+        data["original_length"] = static_cast<int64_t>(full.length());
+    }
 
-        // Extract content type from headers if available
-        std::string content_type;
-        std::map<std::string, std::string>::const_iterator ct_it = response.headers.find("Content-Type");
-        if (ct_it == response.headers.end()) {
-            ct_it = response.headers.find("content-type");
-        }
-        if (ct_it != response.headers.end()) {
-            content_type = ct_it->second;
+    if (chunk_size > 0) {
+        std::vector<std::string> chunks = chunk_text(content, chunk_size, max_chunks);
+        Json chunks_array = Json::array();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            chunks_array.push_back(chunks[i]);
         }
-        if (extract_text) {
-            data["content_type"] = "text/plain; charset=utf-8";
-            data["extracted_text"] = true;
-        } else {
-            data["content_type"] = content_type;
+        data["chunks"] = chunks_array;
+        data["chunk_count"] = static_cast<int64_t>(chunks.size());
+        data["content_length"] = static_cast<int64_t>(content.length());
+        if (content.length() > chunk_size * max_chunks) {
+            data["truncated"] = true;
         }
+    } else {
+        data["content"] = content;
+        data["content_length"] = static_cast<int64_t>(content.length());
+    }
 
-        result.success = true;
+    if (extract_text) {
+        data["content_type"] = "text/plain; charset=utf-8";
+        data["extracted_text"] = true;
     } else {
-        data["error"] = "HTTP request failed with status " + std::to_string(response.status_code);
-        result.success = false;
-        result.error = data["error"].get<std::string>();
+        data["content_type"] = page.content_type;
     }
 
+    result.success = true;
     result.data = data;
     return result;
 }
@@ -282,41 +372,33 @@ ToolResult BrowserTool::do_fetch(const Json& params) {
 ToolResult BrowserTool::do_extract_text(const Json& params) {
     ToolResult result;
 
-    // Can extract from HTML content directly or fetch from URL
-    std::string html;
+    // Optional truncation and chunking
+    size_t max_len = get_optional_size(params, "max_length", settings_.get()->max_content_length);
+    size_t chunk_size = get_optional_size(params, "chunk_size", 0);
+    size_t max_chunks = get_optional_size(params, "max_chunks", 20);
+
+    // Can extract from HTML content directly or fetch from URL; fetched
+    // pages keep their text in the cache. Extraction stops at max_len.
+    std::shared_ptr<const WebText> extracted;
 
     if (params.contains("html") && params["html"].is_string()) {
-        html = params["html"].get<std::string>();
+        std::shared_ptr<WebText> own = std::make_shared<WebText>();
+        own->complete = html_text::extract(params["html"].get<std::string>(), max_len, own->text);
+        extracted = own;
     } else if (params.contains("url") && params["url"].is_string()) {
-        // Fetch the URL first
-        ToolResult fetch_result = do_fetch(params);
-        if (!fetch_result.success) {
-            return fetch_result;
-        }
-        if (fetch_result.data.contains("content") && fetch_result.data["content"].is_string()) {
-            html = fetch_result.data["content"].get<std::string>();
+        WebFetchResult fetch;
+        if (!load_page(params, fetch, result)) {
+            return result;
         }
+        extracted = fetch.page->text(max_len);
     } else {
         result.success = false;
         result.error = "Missing required parameter: url or html";
         return result;
     }
 
-    // Extract text from HTML
-    std::string text = strip_html(html);
-    text = normalize_whitespace(text);
-
-    // Optional truncation and chunking
-    size_t max_len = get_optional_size(params, "max_length", max_content_length_);
-    size_t chunk_size = get_optional_size(params, "chunk_size", 0);
-    size_t max_chunks = get_optional_size(params, "max_chunks", 20);
-
-    bool truncated = false;
-    size_t original_length = text.length();
-    if (text.length() > max_len) {
-        text = text.substr(0, max_len);
-        truncated = true;
-    }
+    bool truncated = !extracted->complete || extracted->text.length() > max_len;
+    std::string text = extracted->text.substr(0, max_len);
 
     Json data;
     if (chunk_size > 0) {
@@ -335,7 +417,9 @@ ToolResult BrowserTool::do_extract_text(const Json& params) {
         data["text"] = text;
         data["text_length"] = static_cast<int64_t>(text.length());
     }
-    data["original_length"] = static_cast<int64_t>(original_length);
+    if (extracted->complete) {
+        data["original_length"] = static_cast<int64_t>(extracted->text.length());
+    }
     data["truncated"] = truncated;
 
     result.success = true;
@@ -346,219 +430,199 @@ ToolResult BrowserTool::do_extract_text(const Json& params) {
 ToolResult BrowserTool::do_get_links(const Json& params) {
     ToolResult result;
 
-    std::string html;
-    std::string base_url;
+    std::shared_ptr<const WebLinks> links;
 
     if (params.contains("html") && params["html"].is_string()) {
-        html = params["html"].get<std::string>();
-        base_url = params.value("base_url", std::string(""));
+        links = std::make_shared<const WebLinks>(html_text::links(
+            params["html"].get<std::string>(), params.value("base_url", std::string(""))));
     } else if (params.contains("url") && params["url"].is_string()) {
-        base_url = params["url"].get<std::string>();
-
-        // Fetch the URL first
-        ToolResult fetch_result = do_fetch(params);
-        if (!fetch_result.success) {
-            return fetch_result;
-        }
-        if (fetch_result.data.contains("content") && fetch_result.data["content"].is_string()) {
-            html = fetch_result.data["content"].get<std::string>();
+        WebFetchResult fetch;
+        if (!load_page(params, fetch, result)) {
+            return result;
         }
+        links = fetch.page->links();
     } else {
         result.success = false;
         result.error = "Missing required parameter: url or html";
         return result;
     }
 
-    // Extract links
-    std::vector<std::pair<std::string, std::string> > links = extract_links(html, base_url);
-
     // Build result
     Json links_array = Json::array();
-    for (size_t i = 0; i < links.size(); ++i) {
+    for (size_t i = 0; i < links->size(); ++i) {
         Json link;
-        link["url"] = links[i].first;
-        link["text"] = links[i].second;
+        link["url"] = (*links)[i].first;
+        link["text"] = (*links)[i].second;
         links_array.push_back(link);
     }
 
     Json data;
     data["links"] = links_array;
-    data["count"] = static_cast<int64_t>(links.size());
+    data["count"] = static_cast<int64_t>(links->size());
 
     result.success = true;
     result.data = data;
     return result;
 }
 
-ToolResult BrowserTool::do_status() {
+ToolResult BrowserTool::do_fetch_many(const Json& params) {
     ToolResult result;
 
-    Json data;
-    data["status"] = "ok";
-    data["max_content_length"] = static_cast<int64_t>(max_content_length_);
-    data["timeout_secs"] = timeout_secs_;
-
-    result.success = true;
-    result.data = data;
-    return result;
-}
-
-// ============ Helper Functions ============
-
-std::string BrowserTool::strip_html(const std::string& html) {
-    std::string result;
-    result.reserve(html.size());
-
-    bool in_tag = false;
-    bool in_script = false;
-    bool in_style = false;
-
-    for (size_t i = 0; i < html.size(); ++i) {
-        char c = html[i];
-
-        if (c == '<') {
-            in_tag = true;
+    if (!params.contains("urls") || !params["urls"].is_array() || params["urls"].empty()) {
+        result.success = false;
+        result.error = "Missing required parameter: urls (a non-empty array)";
+        return result;
+    }
+    const Json& url_list = params["urls"];
+    if (url_list.size() > fetch_many_max_urls) {
+        result.success = false;
+        result.error = "Too many URLs (at most " + std::to_string(fetch_many_max_urls) + ")";
+        return result;
+    }
 
-            // Check for script/style tags
-            std::string lower_rest;
-            for (size_t j = i; j < html.size() && j < i + 10; ++j) {
-                lower_rest += static_cast<char>(std::tolower(html[j]));
-            }
+    std::map<std::string, std::string> headers;
+    headers["User-Agent"] = "OpenClaw C++/1.0";
+    headers["Accept"] = "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8";
+    headers["Accept-Language"] = "en-US,en;q=0.5";
 
-            if (lower_rest.find("<script") == 0) {
-                in_script = true;
-            } else if (lower_rest.find("</script") == 0) {
-                in_script = false;
-            } else if (lower_rest.find("<style") == 0) {
-                in_style = true;
-            } else if (lower_rest.find("</style") == 0) {
-                in_style = false;
-            }
-        } else if (c == '>') {
-            in_tag = false;
-            result += ' ';  // Replace tag with space
-        } else if (!in_tag && !in_script && !in_style) {
-            // Decode common HTML entities
-            if (c == '&' && i + 1 < html.size()) {
-                std::string entity;
-                size_t j = i + 1;
-                while (j < html.size() && j < i + 10 && html[j] != ';' && html[j] != ' ') {
-                    entity += html[j];
-                    ++j;
-                }
-
-                if (j < html.size() && html[j] == ';') {
-                    std::string decoded;
-                    if (entity == "nbsp" || entity == "#160") decoded = " ";
-                    else if (entity == "amp") decoded = "&";
-                    else if (entity == "lt") decoded = "<";
-                    else if (entity == "gt") decoded = ">";
-                    else if (entity == "quot") decoded = "\"";
-                    else if (entity == "apos") decoded = "'";
-
-                    if (!decoded.empty()) {
-                        result += decoded;
-                        i = j;
-                        continue;
-                    }
-                }
-            }
-            result += c;
+    struct Slot {
+        std::string url;
+        std::string host;
+        std::string error;
+        WebFetchResult fetch;
+        bool done;
+    };
+    std::vector<Slot> slots(url_list.size());
+    std::vector<size_t> queued;
+    for (size_t i = 0; i < url_list.size(); ++i) {
+        Slot& slot = slots[i];
+        slot.done = true;
+        if (!url_list[i].is_string()) {
+            slot.error = "Not a string";
+            continue;
         }
+        slot.url = url_list[i].get<std::string>();
+        if (slot.url.find("http://") != 0 && slot.url.find("https://") != 0) {
+            slot.error = "URL must start with http:// or https://";
+            continue;
+        }
+        slot.host = url_host(WebCache::normalize_url(slot.url));
+        slot.done = false;
+        queued.push_back(i);
     }
 
-    return result;
-}
-
-std::string BrowserTool::normalize_whitespace(const std::string& s) {
-    std::string result;
-    result.reserve(s.size());
-
-    bool last_was_space = true;  // Start true to trim leading whitespace
-
-    for (size_t i = 0; i < s.size(); ++i) {
-        char c = s[i];
-        bool is_space = std::isspace(static_cast<unsigned char>(c));
-
-        if (is_space) {
-            if (!last_was_space) {
-                result += ' ';
-                last_was_space = true;
+    // Start what the limits allow; completions free their slot and wake us
+    Snapshot<Settings>::Ptr settings = settings_.get();
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t in_flight = 0;
+    std::map<std::string, size_t> per_host;
+    size_t remaining = queued.size();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (remaining > 0) {
+        for (size_t q = 0; q < queued.size() && in_flight < settings->fetch_many_concurrency; ) {
+            Slot& slot = slots[queued[q]];
+            if (per_host[slot.host] >= settings->fetch_many_per_host) {
+                ++q;
+                continue;
             }
+            queued.erase(queued.begin() + q);
+            in_flight++;
+            per_host[slot.host]++;
+
+            // A cache hit completes inline, so the lock is not held here
+            lock.unlock();
+            WebCache::instance().get_async(http_, slot.url, headers,
+                [&slot, &mutex, &cv, &in_flight, &per_host, &remaining](const WebFetchResult& fetch) {
+                    std::lock_guard<std::mutex> done_lock(mutex);
+                    slot.fetch = fetch;
+                    slot.done = true;
+                    in_flight--;
+                    per_host[slot.host]--;
+                    remaining--;
+                    cv.notify_one();
+                });
+            lock.lock();
+        }
+        if (remaining > 0) cv.wait(lock);
+    }
+    lock.unlock();
+
+    // Texts of the pages that loaded, sharing one length budget; no page
+    // can use more than all of it, so extraction stops there
+    size_t budget = get_optional_size(params, "max_length", settings->max_content_length);
+    std::vector<std::shared_ptr<const WebText> > texts(slots.size());
+    std::vector<size_t> lengths(slots.size(), 0);
+    size_t succeeded = 0;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        Slot& slot = slots[i];
+        if (!slot.error.empty()) continue;
+        long status = slot.fetch.page->status_code;
+        if (status < 200 || status >= 300) {
+            slot.error = status == 0 ? "Request failed"
+                                     : "HTTP request failed with status " + std::to_string(status);
+            continue;
+        }
+        texts[i] = slot.fetch.page->text(budget);
+        lengths[i] = texts[i]->text.size();
+        succeeded++;
+    }
+    std::vector<size_t> shares = share_budget(lengths, budget);
+
+    Json pages = Json::array();
+    for (size_t i = 0; i < slots.size(); ++i) {
+        const Slot& slot = slots[i];
+        Json page;
+        page["url"] = slot.url;
+        if (!slot.error.empty()) {
+            page["success"] = false;
+            page["error"] = slot.error;
+            if (slot.fetch.page) page["status_code"] = slot.fetch.page->status_code;
         } else {
-            result += c;
-            last_was_space = false;
+            page["success"] = true;
+            page["status_code"] = slot.fetch.page->status_code;
+            page["cache"] = slot.fetch.cache;
+            page["text"] = texts[i]->text.substr(0, shares[i]);
+            if (texts[i]->complete) {
+                page["original_length"] = static_cast<int64_t>(lengths[i]);
+            }
+            page["truncated"] = !texts[i]->complete || shares[i] < lengths[i];
         }
+        pages.push_back(page);
     }
 
-    // Trim trailing space
-    if (!result.empty() && result[result.size() - 1] == ' ') {
-        result.erase(result.size() - 1);
-    }
+    Json data;
+    data["results"] = pages;
+    data["count"] = static_cast<int64_t>(slots.size());
+    data["succeeded"] = static_cast<int64_t>(succeeded);
 
+    result.success = true;
+    result.data = data;
     return result;
 }
 
-std::vector<std::pair<std::string, std::string> > BrowserTool::extract_links(
-        const std::string& html, const std::string& base_url) {
-    std::vector<std::pair<std::string, std::string> > links;
-
-    // Simple regex-free link extraction
-    std::string lower_html = html;
-    for (size_t i = 0; i < lower_html.size(); ++i) {
-        lower_html[i] = static_cast<char>(std::tolower(lower_html[i]));
-    }
+ToolResult BrowserTool::do_status() {
+    ToolResult result;
 
-    size_t pos = 0;
-    while ((pos = lower_html.find("<a ", pos)) != std::string::npos) {
-        // Find href attribute
-        size_t href_pos = lower_html.find("href=", pos);
-        if (href_pos == std::string::npos || href_pos > pos + 200) {
-            pos++;
-            continue;
-        }
+    Json data;
+    data["status"] = "ok";
+    data["max_content_length"] = static_cast<int64_t>(settings_.get()->max_content_length);
+    data["timeout_secs"] = timeout_secs_;
 
-        // Extract URL
-        size_t url_start = href_pos + 5;
-        char quote = html[url_start];
-        if (quote == '"' || quote == '\'') {
-            url_start++;
-            size_t url_end = html.find(quote, url_start);
-            if (url_end != std::string::npos) {
-                std::string url = html.substr(url_start, url_end - url_start);
-
-                // Make absolute URL if relative
-                if (!url.empty() && url[0] == '/') {
-                    // Find base domain from base_url
-                    size_t scheme_end = base_url.find("://");
-                    if (scheme_end != std::string::npos) {
-                        size_t domain_end = base_url.find('/', scheme_end + 3);
-                        if (domain_end != std::string::npos) {
-                            url = base_url.substr(0, domain_end) + url;
-                        } else {
-                            url = base_url + url;
-                        }
-                    }
-                }
-
-                // Extract link text
-                size_t tag_end = html.find('>', url_end);
-                size_t link_text_end = lower_html.find("</a>", tag_end);
-                std::string text;
-                if (tag_end != std::string::npos && link_text_end != std::string::npos) {
-                    text = strip_html(html.substr(tag_end + 1, link_text_end - tag_end - 1));
-                    text = normalize_whitespace(text);
-                }
-
-                if (!url.empty() && url.find("javascript:") != 0 && url.find("#") != 0) {
-                    links.push_back(std::make_pair(url, text));
-                }
-            }
-        }
-        pos++;
-    }
+    WebCache::Stats cs = WebCache::instance().stats();
+    Json cache;
+    cache["memory_hits"] = static_cast<int64_t>(cs.memory_hits);
+    cache["disk_hits"] = static_cast<int64_t>(cs.disk_hits);
+    cache["revalidated"] = static_cast<int64_t>(cs.revalidated);
+    cache["misses"] = static_cast<int64_t>(cs.misses);
+    cache["entries"] = static_cast<int64_t>(cs.entries);
+    cache["bytes"] = static_cast<int64_t>(cs.bytes);
+    data["cache"] = cache;
 
-    return links;
+    result.success = true;
+    result.data = data;
+    return result;
 }
 
 } // namespace openclaw
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <openclaw/core/builtin_tools.hpp>
 #include <openclaw/core/logger.hpp>
 #include <openclaw/core/config.hpp>
+#include <openclaw/core/subprocess.hpp>
+#include <openclaw/core/file_view.hpp>
 
 #include <fstream>
 #include <sstream>
@@ -28,6 +30,181 @@
 namespace openclaw {
 namespace builtin_tools {
 
+// ============================================================================
+// Read Helpers
+// ============================================================================
+
+namespace {
+
+// Bytes of a read returned inline; past it the rest goes by reference
+const size_t read_inline_max = 50000;
+
+void add_read_params(AgentTool& tool) {
+    tool.params.push_back(ToolParamSchema(
+        "path", "string", 
+        "Path to the file to read (relative to workspace)", 
+        true
+    ));
+    tool.params.push_back(ToolParamSchema(
+        "start_line", "number",
+        "First line to read, 1-based (default: 1)",
+        false
+    ));
+    tool.params.push_back(ToolParamSchema(
+        "num_lines", "number",
+        "Number of lines to read (default: to the end of the file)",
+        false
+    ));
+}
+
+// Read (a line range of) a file through a mapping: only the requested
+// lines are touched, and a range too large to inline is handed on as a
+// slice of the mapping rather than copied
+AgentToolResult read_file_range(const Json& params, const std::string& workspace) {
+    if (!params.contains("path") || !params["path"].is_string()) {
+        return AgentToolResult::fail("Missing required parameter: path");
+    }
+    
+    auto file_path = params["path"].get<std::string>();
+    auto full_path = path::resolve(file_path, workspace);
+    
+    LOG_DEBUG("[read tool] Reading file: %s", full_path.c_str());
+    
+    if (!path::is_within_workspace(full_path, workspace)) {
+        return AgentToolResult::fail("Path not allowed: " + file_path);
+    }
+    
+    std::string error;
+    std::shared_ptr<const FileView> file = FileView::open(full_path, error);
+    if (!file) {
+        return AgentToolResult::fail("Cannot open file: " + file_path);
+    }
+    
+    size_t start_line = 1;
+    size_t num_lines = 0;
+    if (params.contains("start_line") && params["start_line"].is_number_integer() &&
+        params["start_line"].get<int64_t>() > 1) {
+        start_line = static_cast<size_t>(params["start_line"].get<int64_t>());
+    }
+    if (params.contains("num_lines") && params["num_lines"].is_number_integer() &&
+        params["num_lines"].get<int64_t>() > 0) {
+        num_lines = static_cast<size_t>(params["num_lines"].get<int64_t>());
+    }
+    
+    size_t offset = 0, length = 0;
+    if (!file->line_range(start_line - 1, num_lines, offset, length)) {
+        if (start_line == 1) return AgentToolResult::ok("");
+        return AgentToolResult::fail("Start line out of range: " + std::to_string(start_line));
+    }
+    
+    if (length <= read_inline_max) {
+        return AgentToolResult::ok(file->substr(offset, length));
+    }
+    
+    AgentToolResult result = AgentToolResult::ok(
+        file->substr(offset, read_inline_max) + "\n\n... [truncated, file too large] ...");
+    result.full = FileSlice(file, offset, length);
+    return result;
+}
+
+// ============================================================================
+// Bash Helpers
+// ============================================================================
+
+// Output kept per command when not configured (agent.bash_max_output)
+const size_t default_bash_max_output = 1000000;
+
+// Validate a bash call and fill in what to run; false with failure set
+// when it must not run
+bool prepare_bash(const Json& params, const std::string& workspace, int timeout_secs,
+                  SubprocessOptions& options, AgentToolResult& failure) {
+    if (!params.contains("command") || !params["command"].is_string()) {
+        failure = AgentToolResult::fail("Missing required parameter: command");
+        return false;
+    }
+    
+    auto command = params["command"].get<std::string>();
+    auto workdir = workspace;
+    
+    if (params.contains("workdir") && params["workdir"].is_string()) {
+        workdir = path::resolve(params["workdir"].get<std::string>(), workspace);
+    }
+    
+    // Auto-add timeout to curl commands
+    if (command.find("curl ") != std::string::npos && 
+        command.find("--connect-timeout") == std::string::npos &&
+        command.find("-m ") == std::string::npos &&
+        command.find("--max-time") == std::string::npos) {
+        
+        auto curl_pos = command.find("curl ");
+        command = command.substr(0, curl_pos + 5) + 
+                  "--connect-timeout 10 --max-time 15 " + 
+                  command.substr(curl_pos + 5);
+        LOG_DEBUG("[bash tool] Auto-added timeout to curl: %s", command.c_str());
+    }
+    
+    LOG_INFO("[bash tool] Executing: %s (in %s)", command.c_str(), workdir.c_str());
+    
+    // Security: Block dangerous patterns
+    std::string lower_cmd = command;
+    for (auto& c : lower_cmd) {
+        c = std::tolower(static_cast<unsigned char>(c));
+    }
+    
+    if (lower_cmd.find("rm -rf /") != std::string::npos ||
+        lower_cmd.find("rm -rf ~") != std::string::npos ||
+        lower_cmd.find(":(){") != std::string::npos) {  // Fork bomb
+        failure = AgentToolResult::fail("Command blocked for safety");
+        return false;
+    }
+    
+    options.command = command;
+    options.workdir = workdir;
+    options.timeout_ms = timeout_secs > 0 ? timeout_secs * 1000LL : 0;
+    if (options.max_output == 0) options.max_output = default_bash_max_output;
+    return true;
+}
+
+// What the AI sees for a finished command
+AgentToolResult bash_result(const SubprocessResult& r, int timeout_secs) {
+    if (!r.started) {
+        return AgentToolResult::fail("Failed to execute command: " + r.error);
+    }
+    
+    std::string result = r.output;
+    if (r.truncated) {
+        std::ostringstream note;
+        note << "\n... [output truncated at " << r.output.size() << " bytes; command stopped] ...";
+        result += note.str();
+    }
+    
+    if (r.timed_out || r.exit_code != 0) {
+        std::ostringstream err;
+        if (r.timed_out) {
+            err << "Command timed out after " << timeout_secs << " seconds.";
+            if (!result.empty()) {
+                err << " Partial output:\n" << result;
+            }
+            err << "\nTry an alternative approach or different service.";
+        } else {
+            err << "Command exited with code " << r.exit_code;
+            if (!result.empty()) {
+                err << ":\n" << result;
+            }
+        }
+        // Return as success so AI can see output and retry
+        return AgentToolResult::ok(err.str());
+    }
+    
+    if (result.empty()) {
+        result = "(no output)";
+    }
+    
+    return AgentToolResult::ok(result);
+}
+
+} // anonymous namespace
+
 // ============================================================================
 // Path Utilities
 // ============================================================================
@@ -67,49 +244,16 @@ bool is_within_workspace(const std::string& path, const std::string& /*workspace
 AgentTool create_read_tool(const std::string& workspace_dir) {
     AgentTool tool;
     tool.name = "read";
+    tool.parallel_safe = true;
     tool.description = "Read the contents of a file. Use this to examine files, "
-                       "read documentation, or load skill instructions.";
-    
-    tool.params.push_back(ToolParamSchema(
-        "path", "string", 
-        "Path to the file to read (relative to workspace)", 
-        true
-    ));
+                       "read documentation, or load skill instructions. "
+                       "Use start_line and num_lines to read part of a large file.";
+    add_read_params(tool);
     
     std::string workspace = workspace_dir;
     
     tool.execute = [workspace](const Json& params) -> AgentToolResult {
-        if (!params.contains("path") || !params["path"].is_string()) {
-            return AgentToolResult::fail("Missing required parameter: path");
-        }
-        
-        auto file_path = params["path"].get<std::string>();
-        auto full_path = path::resolve(file_path, workspace);
-        
-        LOG_DEBUG("[read tool] Reading file: %s", full_path.c_str());
-        
-        if (!path::is_within_workspace(full_path, workspace)) {
-            return AgentToolResult::fail("Path not allowed: " + file_path);
-        }
-        
-        std::ifstream file(full_path.c_str());
-        if (!file.is_open()) {
-            return AgentToolResult::fail("Cannot open file: " + file_path);
-        }
-        
-        std::ostringstream content;
-        content << file.rdbuf();
-        file.close();
-        
-        auto result = content.str();
-        
-        // Truncate very large files
-        constexpr size_t MAX_SIZE = 50000;
-        if (result.size() > MAX_SIZE) {
-            result = result.substr(0, MAX_SIZE) + "\n\n... [truncated, file too large] ...";
-        }
-        
-        return AgentToolResult::ok(result);
+        return read_file_range(params, workspace);
     };
     
     return tool;
@@ -198,109 +342,23 @@ AgentTool create_bash_tool(const std::string& workspace_dir, int timeout_secs) {
     int timeout = timeout_secs;
     
     tool.execute = [workspace, timeout](const Json& params) -> AgentToolResult {
-        if (!params.contains("command") || !params["command"].is_string()) {
-            return AgentToolResult::fail("Missing required parameter: command");
-        }
-        
-        auto command = params["command"].get<std::string>();
-        auto workdir = workspace;
-        
-        if (params.contains("workdir") && params["workdir"].is_string()) {
-            workdir = path::resolve(params["workdir"].get<std::string>(), workspace);
+        SubprocessOptions options;
+        AgentToolResult failure;
+        if (!prepare_bash(params, workspace, timeout, options, failure)) {
+            return failure;
         }
-        
-        // Auto-add timeout to curl commands
-        if (command.find("curl ") != std::string::npos && 
-            command.find("--connect-timeout") == std::string::npos &&
-            command.find("-m ") == std::string::npos &&
-            command.find("--max-time") == std::string::npos) {
-            
-            auto curl_pos = command.find("curl ");
-            command = command.substr(0, curl_pos + 5) + 
-                      "--connect-timeout 10 --max-time 15 " + 
-                      command.substr(curl_pos + 5);
-            LOG_DEBUG("[bash tool] Auto-added timeout to curl: %s", command.c_str());
-        }
-        
-        LOG_INFO("[bash tool] Executing: %s (in %s)", command.c_str(), workdir.c_str());
-        
-        // Security: Block dangerous patterns
-        std::string lower_cmd = command;
-        for (auto& c : lower_cmd) {
-            c = std::tolower(static_cast<unsigned char>(c));
-        }
-        
-        if (lower_cmd.find("rm -rf /") != std::string::npos ||
-            lower_cmd.find("rm -rf ~") != std::string::npos ||
-            lower_cmd.find(":(){") != std::string::npos) {  // Fork bomb
-            return AgentToolResult::fail("Command blocked for safety");
-        }
-        
-        // Build full command
-        std::ostringstream full_cmd;
-        full_cmd << "cd \"" << workdir << "\" && ";
-        
-#ifndef _WIN32
-        if (timeout > 0) {
-            full_cmd << "timeout " << timeout << " ";
-        }
-#endif
-        
-        full_cmd << command << " 2>&1";
-        
-        // Execute
-        FILE* pipe = popen(full_cmd.str().c_str(), "r");
-        if (!pipe) {
-            return AgentToolResult::fail("Failed to execute command");
-        }
-        
-        std::ostringstream output;
-        char buffer[4096];
-        size_t total_read = 0;
-        constexpr size_t MAX_OUTPUT = 100000;
-        
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr && total_read < MAX_OUTPUT) {
-            output << buffer;
-            total_read += strlen(buffer);
-        }
-        
-        int status = pclose(pipe);
-        
-        auto result = output.str();
-        if (total_read >= MAX_OUTPUT) {
-            result += "\n... [output truncated] ...";
-        }
-        
-#ifndef _WIN32
-        int exit_code = WEXITSTATUS(status);
-#else
-        int exit_code = status;
-#endif
-        
-        if (exit_code != 0) {
-            std::ostringstream err;
-            if (exit_code == 124) {
-                // Timeout
-                err << "Command timed out after " << timeout << " seconds.";
-                if (!result.empty()) {
-                    err << " Partial output:\n" << result;
-                }
-                err << "\nTry an alternative approach or different service.";
-            } else {
-                err << "Command exited with code " << exit_code;
-                if (!result.empty()) {
-                    err << ":\n" << result;
-                }
-            }
-            // Return as success so AI can see output and retry
-            return AgentToolResult::ok(err.str());
-        }
-        
-        if (result.empty()) {
-            result = "(no output)";
-        }
-        
-        return AgentToolResult::ok(result);
+        return bash_result(Subprocess::run(options), timeout);
+    };
+    tool.execute_async = [workspace, timeout](const Json& params, ToolDoneCallback done) {
+        SubprocessOptions options;
+        AgentToolResult failure;
+        if (!prepare_bash(params, workspace, timeout, options, failure)) {
+            done(failure);
+            return;
+        }
+        Subprocess::run_async(options, [timeout, done](const SubprocessResult& r) {
+            done(bash_result(r, timeout));
+        });
     };
     
     return tool;
@@ -313,6 +371,7 @@ AgentTool create_bash_tool(const std::string& workspace_dir, int timeout_secs) {
 AgentTool create_list_dir_tool(const std::string& workspace_dir) {
     AgentTool tool;
     tool.name = "list_dir";
+    tool.parallel_safe = true;
     tool.description = "List the contents of a directory.";
     
     tool.params.push_back(ToolParamSchema(
@@ -443,7 +502,7 @@ AgentTool create_content_search_tool(ContentChunker& chunker) {
     ));
     tool.params.push_back(ToolParamSchema(
         "query", "string", 
-        "Text to search for (case-insensitive)", 
+        "Words to search for (case-insensitive); passages with more of them rank first. Use \"double quotes\" for an exact phrase", 
         true
     ));
     tool.params.push_back(ToolParamSchema(
@@ -499,9 +558,20 @@ AgentTool create_content_search_tool(ContentChunker& chunker) {
 // BuiltinToolsProvider Implementation
 // ============================================================================
 
+BuiltinToolsProvider::BashLimits::BashLimits()
+    : timeout(20)
+    , max_output(builtin_tools::default_bash_max_output) {}
+
+BuiltinToolsProvider::BashLimits BuiltinToolsProvider::BashLimits::from_config(const Config& cfg) {
+    BashLimits limits;
+    limits.timeout = static_cast<int>(cfg.get_int("agent.bash_timeout", 20));
+    int64_t max_output = cfg.get_int("agent.bash_max_output", static_cast<int64_t>(builtin_tools::default_bash_max_output));
+    limits.max_output = max_output > 0 ? static_cast<size_t>(max_output) : builtin_tools::default_bash_max_output;
+    return limits;
+}
+
 BuiltinToolsProvider::BuiltinToolsProvider()
     : workspace_dir_(".")
-    , bash_timeout_(20)
     , chunker_(nullptr) {}
 
 BuiltinToolsProvider::~BuiltinToolsProvider() {
@@ -510,15 +580,30 @@ BuiltinToolsProvider::~BuiltinToolsProvider() {
 
 bool BuiltinToolsProvider::init(const Config& cfg) {
     workspace_dir_ = cfg.get_string("workspace_dir", ".");
-    bash_timeout_ = static_cast<int>(cfg.get_int("agent.bash_timeout", 20));
+    bash_limits_.set(BashLimits::from_config(cfg));
+    
+    // Optional cgroup v2 directory every command runs in
+    bash_cgroup_ = cfg.get_string("agent.bash_cgroup", "");
+    if (!bash_cgroup_.empty()) {
+        int64_t memory_mb = cfg.get_int("agent.bash_memory_max_mb", 0);
+        int cpu_percent = static_cast<int>(cfg.get_int("agent.bash_cpu_percent", 0));
+        if (!Subprocess::setup_cgroup(bash_cgroup_, memory_mb * 1024 * 1024, cpu_percent)) {
+            LOG_WARN("Builtin tools: bash commands run without cgroup limits");
+            bash_cgroup_.clear();
+        }
+    }
     
     LOG_INFO("Builtin tools initialized (workspace=%s, bash_timeout=%ds)",
-             workspace_dir_.c_str(), bash_timeout_);
+             workspace_dir_.c_str(), bash_limits_.get()->timeout);
     
     initialized_ = true;
     return true;
 }
 
+void BuiltinToolsProvider::reconfigure(const Config& cfg) {
+    bash_limits_.set(BashLimits::from_config(cfg));
+}
+
 void BuiltinToolsProvider::shutdown() {
     initialized_ = false;
 }
@@ -569,13 +654,11 @@ std::vector<AgentTool> BuiltinToolsProvider::get_agent_tools() const {
     {
         AgentTool tool;
         tool.name = "read";
+        tool.parallel_safe = true;
         tool.description = "Read the contents of a file. Use this to examine files, "
-                           "read documentation, or load skill instructions.";
-        tool.params.push_back(ToolParamSchema(
-            "path", "string", 
-            "Path to the file to read (relative to workspace)", 
-            true
-        ));
+                           "read documentation, or load skill instructions. "
+                           "Use start_line and num_lines to read part of a large file.";
+        builtin_tools::add_read_params(tool);
         
         tool.execute = [self](const Json& params) -> AgentToolResult {
             return self->do_read(params);
@@ -628,6 +711,9 @@ std::vector<AgentTool> BuiltinToolsProvider::get_agent_tools() const {
         tool.execute = [self](const Json& params) -> AgentToolResult {
             return self->do_bash(params);
         };
+        tool.execute_async = [self](const Json& params, ToolDoneCallback done) {
+            self->do_bash_async(params, done);
+        };
         
         tools.push_back(tool);
     }
@@ -636,6 +722,7 @@ std::vector<AgentTool> BuiltinToolsProvider::get_agent_tools() const {
     {
         AgentTool tool;
         tool.name = "list_dir";
+        tool.parallel_safe = true;
         tool.description = "List the contents of a directory.";
         tool.params.push_back(ToolParamSchema(
             "path", "string", 
@@ -687,7 +774,7 @@ std::vector<AgentTool> BuiltinToolsProvider::get_agent_tools() const {
         ));
         tool.params.push_back(ToolParamSchema(
             "query", "string", 
-            "Text to search for (case-insensitive)", 
+            "Words to search for (case-insensitive); passages with more of them rank first. Use \"double quotes\" for an exact phrase", 
             true
         ));
         tool.params.push_back(ToolParamSchema(
@@ -711,37 +798,7 @@ std::vector<AgentTool> BuiltinToolsProvider::get_agent_tools() const {
 // ============================================================================
 
 AgentToolResult BuiltinToolsProvider::do_read(const Json& params) const {
-    if (!params.contains("path") || !params["path"].is_string()) {
-        return AgentToolResult::fail("Missing required parameter: path");
-    }
-    
-    auto file_path = params["path"].get<std::string>();
-    auto full_path = builtin_tools::path::resolve(file_path, workspace_dir_);
-    
-    LOG_DEBUG("[read tool] Reading file: %s", full_path.c_str());
-    
-    if (!builtin_tools::path::is_within_workspace(full_path, workspace_dir_)) {
-        return AgentToolResult::fail("Path not allowed: " + file_path);
-    }
-    
-    std::ifstream file(full_path.c_str());
-    if (!file.is_open()) {
-        return AgentToolResult::fail("Cannot open file: " + file_path);
-    }
-    
-    std::ostringstream content;
-    content << file.rdbuf();
-    file.close();
-    
-    auto result = content.str();
-    
-    // Truncate very large files
-    constexpr size_t MAX_SIZE = 50000;
-    if (result.size() > MAX_SIZE) {
-        result = result.substr(0, MAX_SIZE) + "\n\n... [truncated, file too large] ...";
-    }
-    
-    return AgentToolResult::ok(result);
+    return builtin_tools::read_file_range(params, workspace_dir_);
 }
 
 AgentToolResult BuiltinToolsProvider::do_write(const Json& params) const {
@@ -776,110 +833,35 @@ AgentToolResult BuiltinToolsProvider::do_write(const Json& params) const {
     );
 }
 
+bool BuiltinToolsProvider::prepare_bash(const Json& params, const BashLimits& limits,
+                                        SubprocessOptions& options, AgentToolResult& failure) const {
+    options.max_output = limits.max_output;
+    options.cgroup = bash_cgroup_;
+    return ::openclaw::builtin_tools::prepare_bash(params, workspace_dir_, limits.timeout, options, failure);
+}
+
 AgentToolResult BuiltinToolsProvider::do_bash(const Json& params) const {
-    if (!params.contains("command") || !params["command"].is_string()) {
-        return AgentToolResult::fail("Missing required parameter: command");
-    }
-    
-    auto command = params["command"].get<std::string>();
-    auto workdir = workspace_dir_;
-    
-    if (params.contains("workdir") && params["workdir"].is_string()) {
-        workdir = builtin_tools::path::resolve(params["workdir"].get<std::string>(), workspace_dir_);
-    }
-    
-    // Auto-add timeout to curl commands
-    if (command.find("curl ") != std::string::npos && 
-        command.find("--connect-timeout") == std::string::npos &&
-        command.find("-m ") == std::string::npos &&
-        command.find("--max-time") == std::string::npos) {
-        
-        auto curl_pos = command.find("curl ");
-        command = command.substr(0, curl_pos + 5) + 
-                  "--connect-timeout 10 --max-time 15 " + 
-                  command.substr(curl_pos + 5);
-        LOG_DEBUG("[bash tool] Auto-added timeout to curl: %s", command.c_str());
-    }
-    
-    LOG_INFO("[bash tool] Executing: %s (in %s)", command.c_str(), workdir.c_str());
-    
-    // Security: Block dangerous patterns
-    std::string lower_cmd = command;
-    for (auto& c : lower_cmd) {
-        c = std::tolower(static_cast<unsigned char>(c));
-    }
-    
-    if (lower_cmd.find("rm -rf /") != std::string::npos ||
-        lower_cmd.find("rm -rf ~") != std::string::npos ||
-        lower_cmd.find(":(){") != std::string::npos) {  // Fork bomb
-        return AgentToolResult::fail("Command blocked for safety");
-    }
-    
-    // Build full command
-    std::ostringstream full_cmd;
-    full_cmd << "cd \"" << workdir << "\" && ";
-    
-#ifndef _WIN32
-    if (bash_timeout_ > 0) {
-        full_cmd << "timeout " << bash_timeout_ << " ";
+    Snapshot<BashLimits>::Ptr limits = bash_limits_.get();
+    SubprocessOptions options;
+    AgentToolResult failure;
+    if (!prepare_bash(params, *limits, options, failure)) {
+        return failure;
     }
-#endif
-    
-    full_cmd << command << " 2>&1";
-    
-    // Execute
-    FILE* pipe = popen(full_cmd.str().c_str(), "r");
-    if (!pipe) {
-        return AgentToolResult::fail("Failed to execute command");
-    }
-    
-    std::ostringstream output;
-    char buffer[4096];
-    size_t total_read = 0;
-    constexpr size_t MAX_OUTPUT = 100000;
-    
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr && total_read < MAX_OUTPUT) {
-        output << buffer;
-        total_read += strlen(buffer);
-    }
-    
-    int status = pclose(pipe);
-    
-    auto result = output.str();
-    if (total_read >= MAX_OUTPUT) {
-        result += "\n... [output truncated] ...";
-    }
-    
-#ifndef _WIN32
-    int exit_code = WEXITSTATUS(status);
-#else
-    int exit_code = status;
-#endif
-    
-    if (exit_code != 0) {
-        std::ostringstream err;
-        if (exit_code == 124) {
-            // Timeout
-            err << "Command timed out after " << bash_timeout_ << " seconds.";
-            if (!result.empty()) {
-                err << " Partial output:\n" << result;
-            }
-            err << "\nTry an alternative approach or different service.";
-        } else {
-            err << "Command exited with code " << exit_code;
-            if (!result.empty()) {
-                err << ":\n" << result;
-            }
-        }
-        // Return as success so AI can see output and retry
-        return AgentToolResult::ok(err.str());
-    }
-    
-    if (result.empty()) {
-        result = "(no output)";
-    }
-    
-    return AgentToolResult::ok(result);
+    return builtin_tools::bash_result(Subprocess::run(options), limits->timeout);
+}
+
+void BuiltinToolsProvider::do_bash_async(const Json& params, ToolDoneCallback done) const {
+    Snapshot<BashLimits>::Ptr limits = bash_limits_.get();
+    SubprocessOptions options;
+    AgentToolResult failure;
+    if (!prepare_bash(params, *limits, options, failure)) {
+        done(failure);
+        return;
+    }
+    int timeout = limits->timeout;
+    Subprocess::run_async(options, [timeout, done](const SubprocessResult& r) {
+        done(builtin_tools::bash_result(r, timeout));
+    });
 }
 
 AgentToolResult BuiltinToolsProvider::do_list_dir(const Json& params) const {
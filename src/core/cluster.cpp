@@ -0,0 +1,363 @@
+/*
+ * OpenClaw C++11 - Cluster Routing Implementation
+ */
+#include <openclaw/core/cluster.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/core/metrics.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/json.hpp>
+#include <algorithm>
+
+namespace openclaw {
+
+namespace {
+
+const char* token_header = "X-OpenClaw-Cluster-Token";
+const char* node_header = "X-OpenClaw-Node";
+
+// Constant-time compare, so the token cannot be guessed byte by byte
+bool secret_matches(const std::string& expected, const std::string& given) {
+    if (expected.size() != given.size()) return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        diff |= static_cast<unsigned char>(expected[i] ^ given[i]);
+    }
+    return diff == 0;
+}
+
+// Spreads FNV-1a's output over the ring: similar keys ("node-a#1",
+// "node-a#2") otherwise land close together
+uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+Counter& forwarded_counter() {
+    static Counter& c = Metrics::instance().counter(
+        "openclaw_cluster_forwarded_total", "Messages forwarded to the node owning their session");
+    return c;
+}
+
+Counter& forward_failures_counter() {
+    static Counter& c = Metrics::instance().counter(
+        "openclaw_cluster_forward_failures_total",
+        "Forwards that failed or were refused and ran on the receiving node");
+    return c;
+}
+
+Counter& received_counter() {
+    static Counter& c = Metrics::instance().counter(
+        "openclaw_cluster_received_total", "Messages received from other nodes");
+    return c;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// HashRing
+// ============================================================================
+
+uint64_t HashRing::hash(const std::string& text) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < text.size(); ++i) {
+        h ^= static_cast<unsigned char>(text[i]);
+        h *= 1099511628211ULL;
+    }
+    return mix(h);
+}
+
+void HashRing::build(const std::vector<std::string>& nodes, int vnodes) {
+    nodes_ = nodes;
+    points_.clear();
+    if (vnodes < 1) vnodes = 1;
+    points_.reserve(nodes.size() * static_cast<size_t>(vnodes));
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        for (int v = 0; v < vnodes; ++v) {
+            points_.push_back(std::make_pair(hash(nodes[n] + "#" + std::to_string(v)), n));
+        }
+    }
+    std::sort(points_.begin(), points_.end());
+}
+
+const std::string& HashRing::owner(const std::string& key) const {
+    static const std::string none;
+    if (points_.empty()) return none;
+    // First point clockwise from the key, wrapping past the top
+    std::vector<std::pair<uint64_t, size_t> >::const_iterator it = std::upper_bound(
+        points_.begin(), points_.end(), std::make_pair(hash(key), nodes_.size()));
+    if (it == points_.end()) it = points_.begin();
+    return nodes_[it->second];
+}
+
+// ============================================================================
+// Settings
+// ============================================================================
+
+Cluster::Settings Cluster::Settings::from_config(const Config& cfg) {
+    Settings s;
+    s.enabled = cfg.get_bool("cluster.enabled", false);
+    s.node_id = cfg.get_string("cluster.node_id", "");
+    s.vnodes = static_cast<int>(std::max<int64_t>(cfg.get_int("cluster.vnodes", s.vnodes), 1));
+    s.token = cfg.get_string("cluster.token", "");
+    s.bind = cfg.get_string("cluster.bind", s.bind);
+    s.port = static_cast<int>(cfg.get_int("cluster.port", s.port));
+    s.handoff_ms = std::max<int64_t>(cfg.get_int("cluster.handoff_ms", s.handoff_ms), 0);
+    s.forward_timeout_ms = static_cast<long>(
+        std::max<int64_t>(cfg.get_int("cluster.forward_timeout_ms", s.forward_timeout_ms), 100));
+
+    const Json& nodes = cfg.get_section("cluster.nodes");
+    if (nodes.is_array()) {
+        for (const auto& entry : nodes) {
+            if (!entry.is_object()) continue;
+            Node node;
+            node.id = entry.value("id", std::string(""));
+            node.url = entry.value("url", std::string(""));
+            while (!node.url.empty() && node.url[node.url.size() - 1] == '/') {
+                node.url.erase(node.url.size() - 1);
+            }
+            if (node.id.empty()) continue;
+            s.nodes.push_back(node);
+        }
+    }
+    return s;
+}
+
+const Cluster::Node* Cluster::State::node(const std::string& id) const {
+    for (size_t i = 0; i < settings.nodes.size(); ++i) {
+        if (settings.nodes[i].id == id) return &settings.nodes[i];
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// Cluster
+// ============================================================================
+
+// Received IDs are remembered for a minute, well past any forward timeout
+Cluster::Cluster() : received_(60) {}
+
+Cluster::~Cluster() {
+    stop();
+}
+
+bool Cluster::start(const Settings& settings, LocalHandler local) {
+    if (!settings.enabled) return true;
+
+    State state;
+    state.settings = settings;
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < settings.nodes.size(); ++i) ids.push_back(settings.nodes[i].id);
+    state.ring.build(ids, settings.vnodes);
+    if (!state.node(settings.node_id)) {
+        LOG_ERROR("[Cluster] cluster.node_id '%s' is not in cluster.nodes; running standalone",
+                  settings.node_id.c_str());
+        return false;
+    }
+    // Without a secret any client that reaches the endpoint could inject
+    // messages into any session
+    if (settings.token.empty()) {
+        LOG_ERROR("[Cluster] cluster.token is not set; running standalone");
+        return false;
+    }
+
+    local_ = local;
+    http_.set_timeout(settings.forward_timeout_ms);
+    state_.set(state);
+
+    WebhookRouter::instance().add("cluster",
+        [this](const WebhookRequest& request) { return on_forward(request); });
+    if (WebhookRouter::instance().mounted()) {
+        LOG_INFO("[Cluster] Receiving forwarded messages through the gateway on %scluster",
+                 WebhookRouter::path_prefix());
+    } else if (!server_.start(settings.bind, settings.port)) {
+        LOG_ERROR("[Cluster] Cannot listen on %s:%d; other nodes cannot forward to this one",
+                  settings.bind.c_str(), settings.port);
+    }
+
+    LOG_INFO("[Cluster] Node '%s' of %zu (%d virtual nodes each)",
+             settings.node_id.c_str(), ids.size(), settings.vnodes);
+    return true;
+}
+
+void Cluster::stop() {
+    if (!enabled()) return;
+    WebhookRouter::instance().remove("cluster");
+    server_.stop();
+    state_.set(State());
+}
+
+bool Cluster::reconfigure(const Settings& settings) {
+    StatePtr current = state_.get();
+    if (!current->settings.enabled) {
+        if (settings.enabled) {
+            LOG_WARN("[Cluster] cluster.enabled takes effect on restart");
+        }
+        return false;
+    }
+    if (!settings.enabled || settings.node_id != current->settings.node_id) {
+        LOG_WARN("[Cluster] Leaving the cluster or changing cluster.node_id takes effect on restart");
+        return false;
+    }
+
+    if (settings.token.empty()) {
+        LOG_WARN("[Cluster] Reloaded cluster.token is empty; keeping the current settings");
+        return false;
+    }
+
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < settings.nodes.size(); ++i) ids.push_back(settings.nodes[i].id);
+    if (std::find(ids.begin(), ids.end(), settings.node_id) == ids.end()) {
+        LOG_WARN("[Cluster] Reloaded cluster.nodes lacks this node ('%s'); keeping the current ring",
+                 settings.node_id.c_str());
+        return false;
+    }
+
+    State next;
+    next.settings = settings;
+    next.ring.build(ids, settings.vnodes);
+    bool changed = ids != current->ring.nodes() || settings.vnodes != current->settings.vnodes;
+    if (changed) {
+        next.previous = current->ring;
+        next.changed_at_ms = current_timestamp_ms();
+        LOG_INFO("[Cluster] Membership changed: %zu -> %zu nodes", current->ring.nodes().size(), ids.size());
+    } else {
+        next.previous = current->previous;
+        next.changed_at_ms = current->changed_at_ms;
+    }
+    http_.set_timeout(settings.forward_timeout_ms);
+    state_.set(next);
+    return changed;
+}
+
+bool Cluster::enabled() const {
+    return state_.get()->settings.enabled;
+}
+
+const std::string& Cluster::node_id() const {
+    return state_.get()->settings.node_id;
+}
+
+bool Cluster::owns(const std::string& session_key) const {
+    StatePtr state = state_.get();
+    if (!state->settings.enabled) return true;
+    return state->ring.owner(session_key) == state->settings.node_id;
+}
+
+bool Cluster::forward(const Message& msg, const std::string& session_key) {
+    StatePtr state = state_.get();
+    if (!state->settings.enabled) return false;
+    const std::string& owner = state->ring.owner(session_key);
+    if (owner == state->settings.node_id) return false;
+
+    const Node* node = state->node(owner);
+    if (!node || node->url.empty()) {
+        run_local(msg, "no URL for node '" + owner + "'");
+        return true;
+    }
+
+    std::map<std::string, std::string> headers;
+    headers[token_header] = state->settings.token;
+    headers[node_header] = state->settings.node_id;
+    std::string target = owner;
+    forwarded_counter().inc();
+    LOG_DEBUG("[Cluster] Forwarding message %s to '%s'", msg.id.c_str(), owner.c_str());
+    http_.post_json_async(node->url + WebhookRouter::path_prefix() + "cluster", message_to_json(msg),
+        headers, [this, msg, target](const HttpResponse& response) {
+            if (response.status_code == 202) return;
+            if (response.status_code == 0 && response.sent) {
+                // The owner got it but did not answer in time: it may be
+                // running the turn, and running it here too would reply twice
+                forward_failures_counter().inc();
+                LOG_WARN("[Cluster] No answer from '%s' for message %s (%s); leaving it to that node",
+                         target.c_str(), msg.id.c_str(), response.error.c_str());
+                return;
+            }
+            run_local(msg, "'" + target + "' answered " + (response.error.empty()
+                ? "HTTP " + std::to_string(response.status_code) : response.error));
+        });
+    return true;
+}
+
+int64_t Cluster::handoff_wait_ms(const std::string& session_key) const {
+    StatePtr state = state_.get();
+    if (!state->settings.enabled || state->previous.empty()) return 0;
+    int64_t left = state->changed_at_ms + state->settings.handoff_ms - current_timestamp_ms();
+    if (left <= 0) return 0;
+    // Only sessions that moved here wait for their old owner
+    const std::string& self = state->settings.node_id;
+    if (state->ring.owner(session_key) != self || state->previous.owner(session_key) == self) return 0;
+    return left;
+}
+
+void Cluster::run_local(const Message& msg, const std::string& why) {
+    forward_failures_counter().inc();
+    LOG_WARN("[Cluster] Forward of message %s failed (%s); handling it here",
+             msg.id.c_str(), why.c_str());
+    if (!local_ || !local_(msg)) {
+        LOG_ERROR("[Cluster] Dropped message %s: no node could take it", msg.id.c_str());
+    }
+}
+
+WebhookResponse Cluster::on_forward(const WebhookRequest& request) {
+    StatePtr state = state_.get();
+    if (!secret_matches(state->settings.token, request.header("x-openclaw-cluster-token"))) {
+        LOG_WARN("[Cluster] Rejected a forward with a bad token (from '%s')",
+                 request.header("x-openclaw-node").c_str());
+        return WebhookResponse(401, "Unauthorized");
+    }
+
+    Json json = Json::parse(request.body, nullptr, false);
+    Message msg;
+    if (json.is_discarded() || !message_from_json(json, msg)) {
+        return WebhookResponse(400, "Bad message");
+    }
+
+    // A retried or twice-delivered forward: already taken
+    if (!msg.id.empty() && !received_.should_process(msg.id)) {
+        LOG_DEBUG("[Cluster] Dropping duplicate message %s", msg.id.c_str());
+        return WebhookResponse(202, "");
+    }
+
+    received_counter().inc();
+    LOG_DEBUG("[Cluster] Message %s from node '%s'", msg.id.c_str(),
+              request.header("x-openclaw-node").c_str());
+    // Refused: the sender handles it itself
+    if (!local_ || !local_(msg)) return WebhookResponse(503, "Cannot handle the message");
+    return WebhookResponse(202, "");
+}
+
+Json Cluster::message_to_json(const Message& msg) {
+    Json json;
+    json["id"] = msg.id;
+    json["channel"] = msg.channel;
+    json["from"] = msg.from;
+    json["from_name"] = msg.from_name;
+    json["to"] = msg.to;
+    json["text"] = msg.text;
+    json["chat_type"] = msg.chat_type;
+    json["timestamp"] = msg.timestamp;
+    if (!msg.reply_to_id.empty()) json["reply_to_id"] = msg.reply_to_id;
+    if (!msg.media_url.empty()) json["media_url"] = msg.media_url;
+    return json;
+}
+
+bool Cluster::message_from_json(const Json& json, Message& msg) {
+    if (!json.is_object() || !json.contains("channel") || !json["channel"].is_string()) return false;
+    msg.id = json.value("id", std::string(""));
+    msg.channel = json.value("channel", std::string(""));
+    msg.from = json.value("from", std::string(""));
+    msg.from_name = json.value("from_name", std::string(""));
+    msg.to = json.value("to", std::string(""));
+    msg.text = json.value("text", std::string(""));
+    msg.chat_type = json.value("chat_type", std::string(""));
+    msg.timestamp = json.value("timestamp", static_cast<int64_t>(0));
+    msg.reply_to_id = json.value("reply_to_id", std::string(""));
+    msg.media_url = json.value("media_url", std::string(""));
+    return !msg.channel.empty();
+}
+
+} // namespace openclaw
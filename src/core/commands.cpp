@@ -5,7 +5,11 @@
 #include <openclaw/core/logger.hpp>
 #include <openclaw/core/utils.hpp>
 #include <openclaw/core/application.hpp>
+#include <openclaw/core/http_client.hpp>
+#include <openclaw/ai/completion_cache.hpp>
+#include <openclaw/core/web_cache.hpp>
 #include <sstream>
+#include <cstdio>
 
 namespace openclaw {
 
@@ -113,6 +117,8 @@ std::string cmd_start(const Message& /*msg*/, Session& /*session*/, const std::s
 
 std::string cmd_new(const Message& /*msg*/, Session& session, const std::string& /*args*/) {
     session.clear_history();
+    Application::instance().agent().chunker().remove_scope(session.key());
+    Application::instance().compactor().forget(session.key());
     return "🔄 Conversation cleared. Let's start fresh!";
 }
 
@@ -172,7 +178,65 @@ std::string cmd_monitor(const Message& /*msg*/, Session& /*session*/, const std:
         << "Typing indicators sent: " << stats.total_typing_indicators_sent << "\n\n"
         << "Config:\n"
         << "  Hang timeout: " << app.ai_monitor().get_config().hang_timeout_seconds << "s\n"
-        << "  Typing interval: " << app.ai_monitor().get_config().typing_interval_seconds << "s";
+        << "  Typing interval: " << app.ai_monitor().get_config().typing_interval_seconds << "s\n\n";
+    
+    ThreadPool& pool = app.thread_pool();
+    oss << "Thread pool (" << pool.size() << " workers, " << pool.steals() << " steals, "
+        << pool.rejected() << " rejected):\n";
+    for (size_t lane = 0; lane < TASK_PRIORITY_COUNT; ++lane) {
+        TaskPriority priority = static_cast<TaskPriority>(lane);
+        ThreadPool::LaneStats ls = pool.lane_stats(priority);
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "  %s: %zu queued, %zu deferred, %zu running, %llu done, wait avg %.1fms max %.1fms, run avg %.1fms max %.1fms\n",
+                 task_priority_name(priority), ls.queued, ls.deferred, ls.running,
+                 static_cast<unsigned long long>(ls.completed),
+                 ls.avg_wait_ms(), ls.max_wait_us / 1000.0,
+                 ls.avg_run_ms(), ls.max_run_us / 1000.0);
+        oss << line;
+    }
+    
+    HistoryCompactor::Stats cs = app.compactor().stats();
+    oss << "\nHistory compaction: " << cs.scheduled << " scheduled, " << cs.applied << " applied, "
+        << cs.discarded << " discarded, " << cs.failed << " failed, " << cs.pending << " pending\n";
+    
+    if (app.session_store().is_open()) {
+        SessionStore::Stats ss = app.session_store().stats();
+        oss << "Session store: " << ss.sessions << " sessions, " << ss.loaded << " loaded, "
+            << ss.records << " records in " << ss.commits << " commits (" << ss.syncs << " syncs), "
+            << ss.rewrites << " rewrites\n";
+    }
+    
+    CompletionCache::Stats ccs = CompletionCache::instance().stats();
+    oss << "\nCompletion cache: " << ccs.memory_hits << " memory hits, " << ccs.disk_hits
+        << " disk hits, " << ccs.misses << " misses, " << ccs.entries << " entries ("
+        << ccs.bytes / 1024 << " KB), " << ccs.evictions << " evicted\n";
+    
+    WebCache::Stats wcs = WebCache::instance().stats();
+    oss << "Web cache: " << wcs.memory_hits << " memory hits, " << wcs.disk_hits << " disk hits, "
+        << wcs.revalidated << " revalidated, " << wcs.misses << " misses, " << wcs.entries
+        << " entries (" << wcs.bytes / 1024 << " KB), " << wcs.evictions << " evicted\n";
+    oss << "Log records dropped: " << Logger::instance().dropped() << "\n";
+    
+    if (PluginRegistry::instance().get_default_ai() == &app.ai_router()) {
+        std::vector<AIRouter::BackendStats> rs = app.ai_router().stats();
+        oss << "\nAI router:\n";
+        for (size_t i = 0; i < rs.size(); ++i) {
+            char line[256];
+            snprintf(line, sizeof(line),
+                     "  %s: %llu calls, latency %.0fms, p95 TTFB %lldms, errors %.0f%%, %llu hedged%s\n",
+                     rs[i].provider.c_str(), static_cast<unsigned long long>(rs[i].calls),
+                     rs[i].latency_ms, static_cast<long long>(rs[i].p95_ttfb_ms),
+                     rs[i].error_rate * 100.0, static_cast<unsigned long long>(rs[i].hedges),
+                     rs[i].open ? ", cooling down" : "");
+            oss << line;
+        }
+    }
+    
+    HttpConnectionPool::Stats hs = HttpConnectionPool::instance().stats();
+    oss << "\nHTTP pool: " << hs.requests << " requests, " << hs.connections_opened
+        << " connections opened, " << hs.handles_reused << " handles reused, "
+        << hs.idle << " idle\n";
     
     return oss.str();
 }
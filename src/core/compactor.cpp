@@ -0,0 +1,219 @@
+/*
+ * OpenClaw C++11 - Background History Compaction Implementation
+ */
+#include <openclaw/core/compactor.hpp>
+#include <openclaw/core/session.hpp>
+#include <openclaw/core/registry.hpp>
+#include <openclaw/ai/completion_cache.hpp>
+#include <openclaw/core/thread_pool.hpp>
+#include <openclaw/core/logger.hpp>
+#include <sstream>
+
+namespace openclaw {
+
+namespace {
+
+const char* const summary_marker = "[Summary of the earlier conversation]";
+
+// Per-message cap in the transcript sent for summarizing
+const size_t max_transcript_message = 4000;
+
+const char* const summary_instructions =
+    "You maintain the long-term memory of a chat assistant. Summarize the "
+    "conversation transcript below so the assistant can carry on without the "
+    "original messages. Keep facts about the user, decisions, open tasks and "
+    "questions, names, numbers, file paths and URLs; drop greetings and tool "
+    "output details that were already acted on. If the transcript starts with "
+    "an earlier summary, merge it into the new one. Reply with the summary "
+    "only, as compact notes in the conversation's language.";
+
+std::string clip(const std::string& text) {
+    if (text.size() <= max_transcript_message) return text;
+    return text.substr(0, max_transcript_message) + " [...]";
+}
+
+std::string transcript(const std::vector<ConversationMessage>& segment) {
+    std::ostringstream oss;
+    for (size_t i = 0; i < segment.size(); ++i) {
+        const ConversationMessage& msg = segment[i];
+        if (msg.role == MessageRole::ASSISTANT) {
+            oss << "Assistant: " << clip(msg.tool_uses.empty() ? msg.content.str() : tool_uses_as_text(msg));
+        } else if (msg.role == MessageRole::SYSTEM) {
+            oss << "System: " << clip(msg.content);
+        } else {
+            oss << (msg.tool_results.empty() ? "User: " : "Tool results: ") << clip(msg.content);
+        }
+        oss << "\n\n";
+    }
+    return oss.str();
+}
+
+bool same_message(const ConversationMessage& a, const ConversationMessage& b) {
+    return a.role == b.role && a.content == b.content &&
+           a.tool_uses.size() == b.tool_uses.size() &&
+           a.tool_results.size() == b.tool_results.size();
+}
+
+// A plain user message: the kept part must start with one so the history
+// still alternates and no tool_use is cut off from its result
+bool is_turn_start(const ConversationMessage& msg) {
+    return msg.role == MessageRole::USER && msg.tool_results.empty();
+}
+
+} // anonymous namespace
+
+struct HistoryCompactor::Job {
+    std::vector<ConversationMessage> segment;   // Oldest messages, as summarized
+    std::string summary;
+    bool done;
+    bool failed;
+
+    Job() : done(false), failed(false) {}
+};
+
+HistoryCompactor::HistoryCompactor(ThreadPool& pool) : pool_(pool) {}
+
+void HistoryCompactor::maybe_compact(const Session& session, AIPlugin* ai) {
+    if (!config_.enabled || !ai) return;
+
+    AIPlugin* summarizer = ai;
+    if (!config_.provider.empty()) {
+        summarizer = PluginRegistry::instance().get_ai(config_.provider);
+        if (!summarizer || !summarizer->is_configured()) {
+            LOG_WARN("[Compactor] Provider '%s' not available, using '%s'",
+                     config_.provider.c_str(), ai->provider_id().c_str());
+            summarizer = ai;
+        }
+    }
+
+    const std::vector<ConversationMessage>& history = session.history();
+    if (history.size() <= config_.keep_recent + 2) return;
+
+    int threshold = config_.threshold_tokens;
+    if (threshold <= 0) {
+        threshold = ai->context_window() / 2;
+        if (threshold <= 0) return;     // Unknown window and no explicit limit
+    }
+
+    int tokens = ai->token_estimator().count(history);
+    if (tokens < threshold) return;
+
+    // Cut at a turn boundary; moving back keeps more messages verbatim
+    size_t cut = history.size() - config_.keep_recent;
+    while (cut > 0 && !is_turn_start(history[cut])) --cut;
+    if (cut < 2) return;
+
+    const std::string& key = session.key();
+    JobPtr job(new Job());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (jobs_.count(key)) return;   // One at a time per session
+        job->segment.assign(history.begin(), history.begin() + cut);
+        jobs_[key] = job;
+        counters_.scheduled++;
+    }
+
+    LOG_INFO("[Compactor] Session %s at ~%d tokens (threshold %d), summarizing %zu of %zu messages",
+             key.c_str(), tokens, threshold, cut, history.size());
+
+    pool_.enqueue([this, key, job, summarizer] { run(key, job, summarizer); }, TaskPriority::LOW);
+}
+
+void HistoryCompactor::run(const std::string& session_key, JobPtr job, AIPlugin* ai) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, JobPtr>::iterator it = jobs_.find(session_key);
+        if (it == jobs_.end() || it->second != job) return;     // Forgotten meanwhile
+    }
+
+    std::vector<ConversationMessage> request;
+    request.push_back(ConversationMessage::user(transcript(job->segment)));
+
+    CompletionOptions opts;
+    opts.model = config_.model;
+    opts.system_prompt = summary_instructions;
+    opts.max_tokens = config_.summary_tokens;
+    opts.temperature = 0.2;
+    opts.cache_prompt = false;
+    // The same segment summarized again (a discarded summary, a restart
+    // with the disk tier) is answered from the cache
+    opts.cache_response = true;
+    opts.batch = config_.batch;
+
+    CompletionCache::instance().chat_async(ai, request, opts,
+                                           [this, session_key, job](const CompletionResult& result) {
+        finish(session_key, job, result);
+    });
+}
+
+void HistoryCompactor::finish(const std::string& session_key, JobPtr job, const CompletionResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, JobPtr>::iterator it = jobs_.find(session_key);
+    if (it == jobs_.end() || it->second != job) return;
+
+    if (!result.success || result.content.empty()) {
+        LOG_WARN("[Compactor] Summary for %s failed: %s", session_key.c_str(),
+                 result.success ? "empty reply" : result.error.c_str());
+        counters_.failed++;
+        jobs_.erase(it);
+        return;
+    }
+
+    job->summary = result.content;
+    job->done = true;
+    LOG_DEBUG("[Compactor] Summary for %s ready (%zu chars, %d output tokens)",
+              session_key.c_str(), job->summary.size(), result.usage.output_tokens);
+}
+
+bool HistoryCompactor::apply_pending(Session& session) {
+    JobPtr job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, JobPtr>::iterator it = jobs_.find(session.key());
+        if (it == jobs_.end() || !it->second->done) return false;
+        job = it->second;
+        jobs_.erase(it);
+    }
+
+    std::vector<ConversationMessage>& history = session.history();
+    const std::vector<ConversationMessage>& segment = job->segment;
+
+    bool unchanged = history.size() > segment.size();
+    for (size_t i = 0; unchanged && i < segment.size(); ++i) {
+        unchanged = same_message(history[i], segment[i]);
+    }
+    if (!unchanged) {
+        LOG_DEBUG("[Compactor] History of %s changed, discarding summary", session.key().c_str());
+        std::lock_guard<std::mutex> lock(mutex_);
+        counters_.discarded++;
+        return false;
+    }
+
+    std::vector<ConversationMessage> compacted;
+    compacted.reserve(history.size() - segment.size() + 2);
+    compacted.push_back(ConversationMessage::user(std::string(summary_marker) + "\n" + job->summary));
+    compacted.push_back(ConversationMessage::assistant("Understood, I will continue from this summary."));
+    compacted.insert(compacted.end(), history.begin() + segment.size(), history.end());
+    history.swap(compacted);
+
+    LOG_INFO("[Compactor] Replaced %zu messages of %s with a summary (%zu messages left)",
+             segment.size(), session.key().c_str(), history.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    counters_.applied++;
+    return true;
+}
+
+void HistoryCompactor::forget(const std::string& session_key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.erase(session_key);
+}
+
+HistoryCompactor::Stats HistoryCompactor::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = counters_;
+    s.pending = jobs_.size();
+    return s;
+}
+
+} // namespace openclaw
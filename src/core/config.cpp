@@ -1,5 +1,4 @@
 #include <openclaw/core/config.hpp>
-#include <openclaw/core/logger.hpp>
 
 namespace openclaw {
 
@@ -28,88 +27,42 @@ bool Config::load_string(const std::string& json_str) {
     }
 }
 
-std::string Config::get_string(const std::string& key, const std::string& def) const {
-    // Support dot notation for nested keys (e.g., "gateway.bind")
-    size_t dot_pos = key.find('.');
-    if (dot_pos != std::string::npos) {
-        std::string section = key.substr(0, dot_pos);
-        std::string subkey = key.substr(dot_pos + 1);
-        
-        if (data_.contains(section)) {
-            const Json& sec = data_[section];
-            // Handle multi-level nesting (e.g., "gateway.auth.token")
-            size_t dot_pos2 = subkey.find('.');
-            if (dot_pos2 != std::string::npos) {
-                std::string subsection = subkey.substr(0, dot_pos2);
-                std::string finalkey = subkey.substr(dot_pos2 + 1);
-                if (sec.contains(subsection)) {
-                    const Json& subsec = sec[subsection];
-                    if (subsec.contains(finalkey) && subsec[finalkey].is_string()) {
-                        LOG_DEBUG("Config: found nested key '%s.%s.%s'", 
-                                  section.c_str(), subsection.c_str(), finalkey.c_str());
-                        return subsec[finalkey].get<std::string>();
-                    }
-                }
-            } else if (sec.contains(subkey) && sec[subkey].is_string()) {
-                LOG_DEBUG("Config: found key '%s.%s'", section.c_str(), subkey.c_str());
-                return sec[subkey].get<std::string>();
-            }
-        }
-
-        LOG_DEBUG("Config: key '%s' not found in section '%s'", subkey.c_str(), section.c_str());
-        return def;
-    }
-    
-    // No dot notation, direct lookup
-    if (data_.contains(key) && data_[key].is_string()) {
-        LOG_DEBUG("Config: found key '%s'", key.c_str());
-        return data_[key].get<std::string>();
+const Json* Config::find(const std::string& key) const {
+    // Dot notation walks nested objects (e.g. "gateway.auth.token")
+    const Json* node = &data_;
+    std::string part;
+    size_t start = 0;
+    while (true) {
+        if (!node->is_object()) return nullptr;
+        size_t dot = key.find('.', start);
+        part.assign(key, start, dot == std::string::npos ? std::string::npos : dot - start);
+        Json::const_iterator it = node->find(part);
+        if (it == node->end()) return nullptr;
+        node = &*it;
+        if (dot == std::string::npos) return node;
+        start = dot + 1;
     }
+}
 
-    LOG_DEBUG("Config: key '%s' not found", key.c_str());
-    return def;
+std::string Config::get_string(const std::string& key, const std::string& def) const {
+    const Json* value = find(key);
+    return value && value->is_string() ? value->get<std::string>() : def;
 }
 
 int64_t Config::get_int(const std::string& key, int64_t def) const {
-    // Support dot notation for nested keys
-    size_t dot_pos = key.find('.');
-    if (dot_pos != std::string::npos) {
-        std::string section = key.substr(0, dot_pos);
-        std::string subkey = key.substr(dot_pos + 1);
-        
-        if (data_.contains(section)) {
-            const Json& sec = data_[section];
-            if (sec.contains(subkey) && sec[subkey].is_number()) {
-                LOG_DEBUG("Config: found key '%s.%s'", section.c_str(), subkey.c_str());
-                return sec[subkey].get<int64_t>();
-            }
-        }
-        LOG_DEBUG("Config: key '%s' not found in section '%s'", subkey.c_str(), section.c_str());
-        return def;
-    }
-    
-    // No dot notation, direct lookup
-    if (data_.contains(key) && data_[key].is_number()) {
-        LOG_DEBUG("Config: found key '%s'", key.c_str());
-        return data_[key].get<int64_t>();
-    }
-    return def;
+    const Json* value = find(key);
+    return value && value->is_number() ? value->get<int64_t>() : def;
 }
 
 bool Config::get_bool(const std::string& key, bool def) const {
-    if (data_.contains(key) && data_[key].is_boolean()) {
-        LOG_DEBUG("Config: found key '%s'", key.c_str());
-        return data_[key].get<bool>();
-    }
-    return def;
+    const Json* value = find(key);
+    return value && value->is_boolean() ? value->get<bool>() : def;
 }
 
 const Json& Config::get_section(const std::string& key) const {
     static Json null_json;
-    if (data_.contains(key)) {
-        return data_[key];
-    }
-    return null_json;
+    const Json* value = find(key);
+    return value ? *value : null_json;
 }
 
 std::string Config::get_channel_string(const std::string& channel, 
@@ -0,0 +1,129 @@
+/*
+ * OpenClaw C++11 - Memory-Mapped File View Implementation
+ */
+#include <openclaw/core/file_view.hpp>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace openclaw {
+
+namespace {
+
+// Lines between entries of the sparse index
+const size_t index_stride = 64;
+
+} // anonymous namespace
+
+FileView::FileView()
+    : fd_(-1)
+    , data_(nullptr)
+    , size_(0)
+    , scanned_lines_(0)
+    , scanned_to_(0) {
+    sparse_.push_back(0);
+}
+
+FileView::~FileView() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+    if (fd_ >= 0) close(fd_);
+}
+
+std::shared_ptr<const FileView> FileView::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = strerror(errno);
+        return std::shared_ptr<const FileView>();
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        error = strerror(errno);
+        close(fd);
+        return std::shared_ptr<const FileView>();
+    }
+    if (!S_ISREG(st.st_mode)) {
+        error = S_ISDIR(st.st_mode) ? "Is a directory" : "Not a regular file";
+        close(fd);
+        return std::shared_ptr<const FileView>();
+    }
+
+    std::shared_ptr<FileView> view(new FileView());
+    view->path_ = path;
+    view->fd_ = fd;
+    view->size_ = static_cast<size_t>(st.st_size);
+
+    // An empty file cannot be mapped and has nothing to map
+    if (view->size_ > 0) {
+        void* p = mmap(nullptr, view->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            error = strerror(errno);
+            return std::shared_ptr<const FileView>();
+        }
+        view->data_ = static_cast<const char*>(p);
+    }
+    return view;
+}
+
+size_t FileView::line_start(size_t line) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Extend the index up to the wanted line
+    while (scanned_lines_ < line && scanned_to_ < size_) {
+        const void* nl = memchr(data_ + scanned_to_, '\n', size_ - scanned_to_);
+        scanned_to_ = nl ? static_cast<size_t>(static_cast<const char*>(nl) - data_) + 1 : size_;
+        scanned_lines_++;
+        if (scanned_lines_ % index_stride == 0) {
+            sparse_.push_back(scanned_to_);
+        }
+    }
+    if (line >= scanned_lines_) {
+        return line == scanned_lines_ ? scanned_to_ : size_;
+    }
+
+    // Known region: nearest indexed line, then at most index_stride - 1 more
+    size_t pos = sparse_[line / index_stride];
+    for (size_t i = line % index_stride; i > 0; --i) {
+        const void* nl = memchr(data_ + pos, '\n', size_ - pos);
+        pos = static_cast<size_t>(static_cast<const char*>(nl) - data_) + 1;
+    }
+    return pos;
+}
+
+bool FileView::line_range(size_t first, size_t count, size_t& offset, size_t& length) const {
+    size_t start = line_start(first);
+    if (start >= size_) return false;
+
+    size_t end = size_;
+    if (count > 0 && count < static_cast<size_t>(-1) - first) {
+        end = line_start(first + count);
+    }
+    if (end > start && data_[end - 1] == '\n') {
+        end--;
+    }
+    offset = start;
+    length = end - start;
+    return true;
+}
+
+size_t FileView::line_count() const {
+    line_start(static_cast<size_t>(-1));
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scanned_lines_;
+}
+
+bool FileView::intact() const {
+    struct stat st;
+    return fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) >= size_;
+}
+
+std::string FileView::substr(size_t offset, size_t length) const {
+    if (offset >= size_) return std::string();
+    if (length > size_ - offset) length = size_ - offset;
+    return std::string(data_ + offset, length);
+}
+
+} // namespace openclaw
@@ -0,0 +1,397 @@
+/*
+ * OpenClaw C++11 - HTML to Text Implementation
+ */
+#include <openclaw/core/html_text.hpp>
+#include <cstring>
+#include <cstdlib>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace openclaw {
+namespace html_text {
+
+namespace {
+
+// Longest entity name looked at ("&" up to ";")
+const size_t max_entity = 10;
+
+// Link text kept per link
+const size_t max_link_text = 500;
+
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+inline char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+inline bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// Case-insensitive prefix match of a lowercase word
+inline bool starts_with_word(const char* p, const char* end, const char* word) {
+    for (; *word; ++word, ++p) {
+        if (p == end || lower(*p) != *word) return false;
+    }
+    return true;
+}
+
+// First '<' or '&' at or after p, or end
+const char* find_markup(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i amp = _mm_set1_epi8('&');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, amp)));
+        if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '<' && *p != '&') ++p;
+    return p;
+}
+
+const char* find(const char* p, const char* end, const char* needle) {
+    size_t n = strlen(needle);
+    while (end - p >= static_cast<ptrdiff_t>(n)) {
+        const char* hit = static_cast<const char*>(memchr(p, needle[0], end - p - n + 1));
+        if (!hit) return end;
+        if (memcmp(hit, needle, n) == 0) return hit;
+        p = hit + 1;
+    }
+    return end;
+}
+
+size_t put_utf8(unsigned long cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (cp >> 18));
+    out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Decode the entity at p ('&'). Returns the end of it with its bytes in
+// out (a space for &nbsp;), or p when it is not one we know.
+const char* decode_entity(const char* p, const char* end, char* out, size_t& len) {
+    const char* name = p + 1;
+    const char* semi = name;
+    while (semi < end && semi < name + max_entity && *semi != ';' && *semi != ' ') ++semi;
+    if (semi == end || *semi != ';' || semi == name) return p;
+    size_t n = static_cast<size_t>(semi - name);
+
+    unsigned long cp = 0;
+    if (name[0] == '#') {
+        char digits[max_entity + 1];
+        bool hex = n > 1 && (name[1] == 'x' || name[1] == 'X');
+        size_t skip = hex ? 2 : 1;
+        if (n <= skip) return p;
+        memcpy(digits, name + skip, n - skip);
+        digits[n - skip] = '\0';
+        char* stop = nullptr;
+        cp = strtoul(digits, &stop, hex ? 16 : 10);
+        if (*stop != '\0' || cp == 0 || cp > 0x10FFFF) return p;
+    } else if (n == 4 && memcmp(name, "nbsp", 4) == 0) {
+        cp = 160;
+    } else if (n == 3 && memcmp(name, "amp", 3) == 0) {
+        cp = '&';
+    } else if (n == 2 && memcmp(name, "lt", 2) == 0) {
+        cp = '<';
+    } else if (n == 2 && memcmp(name, "gt", 2) == 0) {
+        cp = '>';
+    } else if (n == 4 && memcmp(name, "quot", 4) == 0) {
+        cp = '"';
+    } else if (n == 4 && memcmp(name, "apos", 4) == 0) {
+        cp = '\'';
+    } else {
+        return p;
+    }
+
+    if (cp == 160) cp = ' ';
+    len = put_utf8(cp, out);
+    return semi + 1;
+}
+
+// Writes text with runs of whitespace collapsed to one space, none at
+// either end, up to a byte budget
+struct Sink {
+    std::string* out;
+    size_t max;
+    size_t start;               // out may already hold text of its own
+    bool pending_space;
+    bool full;
+
+    Sink(std::string* o, size_t m)
+        : out(o), max(m), start(o ? o->size() : 0), pending_space(false), full(!o || m == 0) {}
+
+    void space() {
+        pending_space = true;
+    }
+
+    void put(const char* p, size_t n) {
+        if (full) return;
+        if (pending_space) {
+            pending_space = false;
+            if (out->size() > start) {
+                if (out->size() - start >= max) {
+                    full = true;
+                    return;
+                }
+                out->push_back(' ');
+            }
+        }
+        size_t left = max - (out->size() - start);
+        if (n <= left) {
+            out->append(p, n);
+            return;
+        }
+        // Take what fits, short of a split UTF-8 sequence, then stop
+        while (left > 0 && (static_cast<unsigned char>(p[left]) & 0xC0) == 0x80) --left;
+        out->append(p, left);
+        full = true;
+    }
+
+    // Copy a run of plain text
+    void run(const char* p, const char* end) {
+        while (p < end && !full) {
+            if (is_space(*p)) {
+                space();
+                ++p;
+                continue;
+            }
+            const char* word = p;
+            while (p < end && !is_space(*p)) ++p;
+            put(word, static_cast<size_t>(p - word));
+        }
+    }
+};
+
+struct Parser {
+    const char* end;
+    Sink text;
+    WebLinks* links;
+    const std::string& base_url;
+
+    // The <a> being read, if any
+    bool in_anchor;
+    std::string anchor_url;
+    std::string anchor_text;
+    Sink anchor_sink;
+
+    Parser(const char* e, std::string* out, size_t max, WebLinks* l, const std::string& base)
+        : end(e), text(out, max), links(l), base_url(base), in_anchor(false),
+          anchor_sink(nullptr, 0) {}
+
+    bool done() const {
+        return text.full && !links;
+    }
+
+    void space() {
+        text.space();
+        if (in_anchor) anchor_sink.space();
+    }
+
+    void put(const char* p, size_t n) {
+        text.put(p, n);
+        if (in_anchor) anchor_sink.put(p, n);
+    }
+
+    void run(const char* p, const char* q) {
+        text.run(p, q);
+        if (in_anchor) anchor_sink.run(p, q);
+    }
+
+    std::string resolve(const std::string& url) const {
+        if (url.size() > 1 && url[0] == '/' && url[1] == '/') {
+            size_t colon = base_url.find(':');
+            return colon == std::string::npos ? "https:" + url : base_url.substr(0, colon + 1) + url;
+        }
+        if (!url.empty() && url[0] == '/') {
+            size_t scheme_end = base_url.find("://");
+            if (scheme_end != std::string::npos) {
+                size_t domain_end = base_url.find('/', scheme_end + 3);
+                return (domain_end != std::string::npos ? base_url.substr(0, domain_end) : base_url) + url;
+            }
+        }
+        return url;
+    }
+
+    void open_anchor(const std::string& href) {
+        close_anchor();
+        if (href.empty() || href[0] == '#' || href.compare(0, 11, "javascript:") == 0) return;
+        in_anchor = true;
+        anchor_url = resolve(href);
+        anchor_text.clear();
+        anchor_sink = Sink(&anchor_text, max_link_text);
+    }
+
+    void close_anchor() {
+        if (!in_anchor) return;
+        in_anchor = false;
+        links->push_back(std::make_pair(anchor_url, anchor_text));
+    }
+
+    // Value of an attribute at p (after '='), entities decoded
+    const char* attribute_value(const char* p, std::string* value) {
+        char quote = 0;
+        if (p < end && (*p == '"' || *p == '\'')) quote = *p++;
+        while (p < end) {
+            char c = *p;
+            if (quote ? c == quote : (is_space(c) || c == '>')) break;
+            if (c == '&' && value) {
+                char buf[4];
+                size_t len = 0;
+                const char* next = decode_entity(p, end, buf, len);
+                if (next != p) {
+                    value->append(buf, len);
+                    p = next;
+                    continue;
+                }
+            }
+            if (value) value->push_back(c);
+            ++p;
+        }
+        return (quote && p < end) ? p + 1 : p;
+    }
+
+    // Tag at p ('<' then a letter or '/'); returns where text resumes
+    const char* tag(const char* p) {
+        bool closing = p[1] == '/';
+        const char* q = p + (closing ? 2 : 1);
+        char name[8];
+        size_t n = 0;
+        while (q < end && (is_alpha(*q) || (*q >= '0' && *q <= '9'))) {
+            if (n < sizeof(name) - 1) name[n] = lower(*q);
+            ++n;
+            ++q;
+        }
+        name[n < sizeof(name) ? n : sizeof(name) - 1] = '\0';
+        if (n >= sizeof(name)) name[0] = '\0';     // Longer than any we care about
+
+        bool anchor = links && strcmp(name, "a") == 0;
+        std::string href;
+
+        // Attributes, minding quotes that may contain '>'
+        while (q < end && *q != '>') {
+            if (*q == '"' || *q == '\'') {
+                const char* close = static_cast<const char*>(memchr(q + 1, *q, end - q - 1));
+                q = close ? close + 1 : end;
+                continue;
+            }
+            if (anchor && !closing && lower(*q) == 'h' && starts_with_word(q, end, "href") &&
+                is_space(q[-1])) {
+                const char* v = q + 4;
+                while (v < end && is_space(*v)) ++v;
+                if (v < end && *v == '=') {
+                    ++v;
+                    while (v < end && is_space(*v)) ++v;
+                    href.clear();
+                    q = attribute_value(v, &href);
+                    continue;
+                }
+            }
+            ++q;
+        }
+        if (q < end) ++q;
+
+        // A tag separates words
+        space();
+
+        if (anchor) {
+            if (closing) close_anchor();
+            else open_anchor(href);
+        }
+
+        // Raw text elements: skip to their end tag
+        if (!closing && (strcmp(name, "script") == 0 || strcmp(name, "style") == 0)) {
+            std::string close_tag = std::string("</") + name;
+            const char* r = q;
+            while (r < end) {
+                r = static_cast<const char*>(memchr(r, '<', end - r));
+                if (!r) return end;
+                if (starts_with_word(r, end, close_tag.c_str())) return r;
+                ++r;
+            }
+            return end;
+        }
+        return q;
+    }
+
+    // Parse all of [p, end); false when cut short
+    bool parse(const char* p) {
+        while (p < end && !done()) {
+            const char* q = find_markup(p, end);
+            run(p, q);
+            if (q == end || done()) break;
+
+            if (*q == '&') {
+                char buf[4];
+                size_t len = 0;
+                const char* next = decode_entity(q, end, buf, len);
+                if (next == q) {
+                    put(q, 1);
+                    p = q + 1;
+                } else {
+                    if (len == 1 && buf[0] == ' ') space();
+                    else put(buf, len);
+                    p = next;
+                }
+                continue;
+            }
+
+            // '<'
+            if (starts_with_word(q, end, "<!--")) {
+                const char* close = find(q + 4, end, "-->");
+                p = close == end ? end : close + 3;
+                space();
+            } else if (q + 1 < end && (q[1] == '!' || q[1] == '?')) {
+                const char* close = static_cast<const char*>(memchr(q, '>', end - q));
+                p = close ? close + 1 : end;
+                space();
+            } else if (q + 1 < end && (is_alpha(q[1]) || q[1] == '/')) {
+                p = tag(q);
+            } else {
+                put(q, 1);
+                p = q + 1;
+            }
+        }
+        if (links) close_anchor();
+        return !text.full;
+    }
+};
+
+} // anonymous namespace
+
+bool extract(const std::string& html, size_t max_chars, std::string& out,
+             WebLinks* links, const std::string& base_url) {
+    const char* begin = html.data();
+    Parser parser(begin + html.size(), &out, max_chars, links, base_url);
+    return parser.parse(begin);
+}
+
+WebLinks links(const std::string& html, const std::string& base_url) {
+    WebLinks result;
+    const char* begin = html.data();
+    Parser parser(begin + html.size(), nullptr, 0, &result, base_url);
+    parser.parse(begin);
+    return result;
+}
+
+} // namespace html_text
+} // namespace openclaw
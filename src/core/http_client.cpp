@@ -1,19 +1,14 @@
 #include <openclaw/core/http_client.hpp>
+#include <openclaw/core/logger.hpp>
 #include <cstring>
 #include <sstream>
+#include <memory>
 
 namespace openclaw {
 
-HttpClient::HttpClient() : curl_(nullptr), timeout_ms_(30000) {
-    curl_ = curl_easy_init();
-}
+HttpClient::HttpClient() : timeout_ms_(30000) {}
 
-HttpClient::~HttpClient() {
-    if (curl_) {
-        curl_easy_cleanup(curl_);
-        curl_ = nullptr;
-    }
-}
+HttpClient::~HttpClient() {}
 
 void HttpClient::set_timeout(long ms) { 
     timeout_ms_ = ms; 
@@ -21,7 +16,7 @@ void HttpClient::set_timeout(long ms) {
 
 HttpResponse HttpClient::get(const std::string& url, 
                              const std::map<std::string, std::string>& headers) {
-    return perform_request("GET", url, "", headers);
+    return perform_request("GET", url, "", headers, timeout_ms_, nullptr);
 }
 
 HttpResponse HttpClient::post_json(const std::string& url, 
@@ -29,7 +24,7 @@ HttpResponse HttpClient::post_json(const std::string& url,
                                    const std::map<std::string, std::string>& extra_headers) {
     std::map<std::string, std::string> headers = extra_headers;
     headers["Content-Type"] = "application/json";
-    return perform_request("POST", url, body.dump(), headers);
+    return perform_request("POST", url, body.dump(), headers, timeout_ms_, nullptr);
 }
 
 HttpResponse HttpClient::post_json(const std::string& url, 
@@ -37,7 +32,36 @@ HttpResponse HttpClient::post_json(const std::string& url,
                                    const std::map<std::string, std::string>& extra_headers) {
     std::map<std::string, std::string> headers = extra_headers;
     headers["Content-Type"] = "application/json";
-    return perform_request("POST", url, body, headers);
+    return perform_request("POST", url, body, headers, timeout_ms_, nullptr);
+}
+
+HttpResponse HttpClient::perform(const HttpRequest& request) {
+    return perform_request(request.method, request.url, request.body, request.headers,
+                           request.timeout_ms, request.on_data ? &request.on_data : nullptr);
+}
+
+void HttpClient::get_async(const std::string& url,
+                           const std::map<std::string, std::string>& headers,
+                           HttpCallback on_done) {
+    HttpRequest request("GET", url);
+    request.headers = headers;
+    request.timeout_ms = timeout_ms_;
+    AsyncHttpEngine::instance().submit(request, on_done);
+}
+
+void HttpClient::post_json_async(const std::string& url,
+                                 const Json& body,
+                                 const std::map<std::string, std::string>& extra_headers,
+                                 HttpCallback on_done) {
+    HttpRequest request("POST", url, body.dump());
+    request.headers = extra_headers;
+    request.headers["Content-Type"] = "application/json";
+    request.timeout_ms = timeout_ms_;
+    AsyncHttpEngine::instance().submit(request, on_done);
+}
+
+std::future<HttpResponse> HttpClient::perform_async(const HttpRequest& request) {
+    return AsyncHttpEngine::instance().submit(request);
 }
 
 HttpResponse HttpClient::post_form(const std::string& url,
@@ -50,15 +74,25 @@ HttpResponse HttpClient::post_form(const std::string& url,
     for (std::map<std::string, std::string>::const_iterator it = form_data.begin();
          it != form_data.end(); ++it) {
         if (!body.empty()) body += "&";
-        body += url_encode(curl_, it->first) + "=" + url_encode(curl_, it->second);
+        body += url_encode(it->first) + "=" + url_encode(it->second);
     }
-    return perform_request("POST", url, body, headers);
+    return perform_request("POST", url, body, headers, timeout_ms_, nullptr);
 }
 
 size_t HttpClient::write_callback(char* ptr, size_t size, size_t nmemb, void* userdata) {
     size_t total = size * nmemb;
-    std::string* response_body = static_cast<std::string*>(userdata);
-    response_body->append(ptr, total);
+    BodySink* sink = static_cast<BodySink*>(userdata);
+    
+    if (sink->on_data && *sink->on_data) {
+        // Stream successful bodies; keep error bodies for finish_response
+        long status = 0;
+        curl_easy_getinfo(sink->curl, CURLINFO_RESPONSE_CODE, &status);
+        if (status >= 200 && status < 300) {
+            (*sink->on_data)(ptr, total);
+            return total;
+        }
+    }
+    sink->body->append(ptr, total);
     return total;
 }
 
@@ -91,68 +125,60 @@ size_t HttpClient::header_callback(char* buffer, size_t size, size_t nitems, voi
     return total;
 }
 
-std::string HttpClient::url_encode(CURL* curl, const std::string& s) {
-    if (!curl) {
-        // Fallback encoding
-        std::string result;
-        for (size_t i = 0; i < s.size(); ++i) {
-            char c = s[i];
-            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
-                (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~') {
-                result += c;
-            } else {
-                char buf[4];
-                snprintf(buf, sizeof(buf), "%%%02X", (unsigned char)c);
-                result += buf;
-            }
+std::string HttpClient::url_encode(const std::string& s) {
+    // RFC 3986 unreserved characters pass through, everything else is escaped
+    std::string result;
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+            (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~') {
+            result += c;
+        } else {
+            char buf[4];
+            snprintf(buf, sizeof(buf), "%%%02X", (unsigned char)c);
+            result += buf;
         }
-        return result;
     }
-    
-    char* encoded = curl_easy_escape(curl, s.c_str(), static_cast<int>(s.length()));
-    if (!encoded) return s;
-    std::string result(encoded);
-    curl_free(encoded);
     return result;
 }
 
-HttpResponse HttpClient::perform_request(const std::string& method,
-                                         const std::string& url,
-                                         const std::string& body,
-                                         const std::map<std::string, std::string>& headers) {
-    HttpResponse resp;
-    
-    if (!curl_) {
-        resp.error = "CURL not initialized";
-        return resp;
-    }
-    
-    // Reset curl handle for reuse
-    curl_easy_reset(curl_);
-    
+struct curl_slist* HttpClient::setup_handle(CURL* curl,
+                                           const std::string& method,
+                                           const std::string& url,
+                                           const std::string& body,
+                                           const std::map<std::string, std::string>& headers,
+                                           long timeout_ms,
+                                           BodySink* sink,
+                                           std::map<std::string, std::string>* response_headers) {
     // Set URL
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     
     // Set timeout
-    curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, timeout_ms_);
-    curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, timeout_ms_ / 2);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, timeout_ms / 2);
+    
+    // A stream may legitimately run long; fail it only once it stalls
+    if (sink->on_data && *sink->on_data) {
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+    }
     
     // Set method
     if (method == "POST") {
-        curl_easy_setopt(curl_, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
     } else if (method == "PUT") {
-        curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "PUT");
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
     } else if (method == "DELETE") {
-        curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "DELETE");
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
     } else if (method == "PATCH") {
-        curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "PATCH");
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PATCH");
     }
     // GET is the default
     
-    // Set request body
+    // Set request body (caller keeps it alive for the whole transfer)
     if (!body.empty()) {
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.length()));
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.length()));
     }
     
     // Set headers
@@ -163,44 +189,47 @@ HttpResponse HttpClient::perform_request(const std::string& method,
         header_list = curl_slist_append(header_list, header.c_str());
     }
     if (header_list) {
-        curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, header_list);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
     }
     
     // Set response callbacks
-    std::string response_body;
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response_body);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    sink->curl = curl;
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, sink);
     
-    std::map<std::string, std::string> response_headers;
-    curl_easy_setopt(curl_, CURLOPT_HEADERFUNCTION, header_callback);
-    curl_easy_setopt(curl_, CURLOPT_HEADERDATA, &response_headers);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, response_headers);
     
     // Follow redirects
-    curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl_, CURLOPT_MAXREDIRS, 5L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 5L);
     
     // SSL verification (enabled by default)
-    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, 1L);
-    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYHOST, 2L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
     
-    // Perform the request
-    CURLcode res = curl_easy_perform(curl_);
+    // Required for timeouts in multi-threaded programs
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
     
-    // Cleanup headers
-    if (header_list) {
-        curl_slist_free_all(header_list);
-    }
+    // Shared caches and keep-alive (cleared by curl_easy_reset)
+    HttpConnectionPool::instance().apply(curl, url);
+    
+    return header_list;
+}
+
+void HttpClient::finish_response(CURL* curl, CURLcode res, HttpResponse& resp) {
+    // Request header bytes sent; none if it failed before going out
+    long request_size = 0;
+    resp.sent = curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &request_size) == CURLE_OK &&
+                request_size > 0;
     
     if (res != CURLE_OK) {
         resp.error = curl_easy_strerror(res);
-        return resp;
+        return;
     }
     
     // Get status code
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &resp.status_code);
-    
-    resp.body = response_body;
-    resp.headers = response_headers;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &resp.status_code);
     
     if (!resp.ok() && resp.error.empty()) {
         std::ostringstream oss;
@@ -214,8 +243,424 @@ HttpResponse HttpClient::perform_request(const std::string& method,
         }
         resp.error = oss.str();
     }
+}
+
+HttpResponse HttpClient::perform_request(const std::string& method,
+                                         const std::string& url,
+                                         const std::string& body,
+                                         const std::map<std::string, std::string>& headers,
+                                         long timeout_ms,
+                                         const HttpDataCallback* on_data) {
+    HttpResponse resp;
+    
+    // Pooled handle: keeps its connection alive for the next request
+    HttpConnectionPool& pool = HttpConnectionPool::instance();
+    CURL* curl = pool.acquire(url);
+    if (!curl) {
+        resp.error = "CURL not initialized";
+        return resp;
+    }
+    
+    BodySink sink;
+    sink.body = &resp.body;
+    sink.on_data = on_data;
+    struct curl_slist* header_list = setup_handle(curl, method, url, body, headers,
+                                                  timeout_ms, &sink, &resp.headers);
+    
+    // Perform the request
+    CURLcode res = curl_easy_perform(curl);
     
+    // Cleanup headers
+    if (header_list) {
+        curl_slist_free_all(header_list);
+    }
+    
+    finish_response(curl, res, resp);
+    pool.release(url, curl);
+    if (res != CURLE_OK) {
+        resp.body.clear();
+        resp.headers.clear();
+    }
     return resp;
 }
 
+// ============================================================================
+// HttpConnectionPool
+// ============================================================================
+
+HttpConnectionPool& HttpConnectionPool::instance() {
+    static HttpConnectionPool pool;
+    return pool;
+}
+
+HttpConnectionPool::HttpConnectionPool()
+    : share_(curl_share_init())
+    , idle_count_(0)
+    , max_idle_per_host_(8)
+    , http2_(true)
+    , handles_created_(0)
+    , handles_reused_(0)
+    , connections_opened_(0)
+    , requests_(0)
+{
+    if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lock_share);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlock_share);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+}
+
+HttpConnectionPool::~HttpConnectionPool() {
+    clear();
+    if (share_) {
+        curl_share_cleanup(share_);
+        share_ = nullptr;
+    }
+}
+
+void HttpConnectionPool::lock_share(CURL* handle, curl_lock_data data,
+                                    curl_lock_access access, void* userptr) {
+    (void)handle;
+    (void)access;
+    HttpConnectionPool* self = static_cast<HttpConnectionPool*>(userptr);
+    self->share_locks_[data].lock();
+}
+
+void HttpConnectionPool::unlock_share(CURL* handle, curl_lock_data data, void* userptr) {
+    (void)handle;
+    HttpConnectionPool* self = static_cast<HttpConnectionPool*>(userptr);
+    self->share_locks_[data].unlock();
+}
+
+void HttpConnectionPool::configure(bool http2, size_t max_idle_per_host) {
+    http2_ = http2;
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_idle_per_host_ = max_idle_per_host;
+    LOG_DEBUG("[HTTP] Connection pool: http2=%s, max idle per host=%zu",
+              http2 ? "on" : "off", max_idle_per_host);
+}
+
+std::string HttpConnectionPool::host_key(const std::string& url) {
+    // scheme://authority - path, query and userinfo do not matter for reuse
+    size_t scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) {
+        return url;
+    }
+    size_t host_start = scheme_end + 3;
+    size_t host_end = url.find_first_of("/?#", host_start);
+    std::string authority = url.substr(host_start,
+        host_end == std::string::npos ? std::string::npos : host_end - host_start);
+    size_t at = authority.rfind('@');
+    if (at != std::string::npos) {
+        authority = authority.substr(at + 1);
+    }
+    return url.substr(0, host_start) + authority;
+}
+
+CURL* HttpConnectionPool::acquire(const std::string& url) {
+    std::string key = host_key(url);
+    CURL* handle = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, std::vector<CURL*> >::iterator it = idle_.find(key);
+        if (it != idle_.end() && !it->second.empty()) {
+            handle = it->second.back();
+            it->second.pop_back();
+            idle_count_--;
+        }
+    }
+    
+    if (handle) {
+        // Reset keeps the live connection and caches, drops per-request options
+        curl_easy_reset(handle);
+        handles_reused_++;
+    } else {
+        handle = curl_easy_init();
+        if (!handle) {
+            return nullptr;
+        }
+        handles_created_++;
+    }
+    apply(handle, url);
+    return handle;
+}
+
+void HttpConnectionPool::apply(CURL* handle, const std::string& url) const {
+    if (share_) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+    }
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, 60L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPINTVL, 30L);
+    curl_easy_setopt(handle, CURLOPT_DNS_CACHE_TIMEOUT, 300L);
+    if (http2_) {
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        // Wait for an in-progress connection to multiplex on instead of opening
+        // another; plain http never negotiates HTTP/2, so waiting would serialize
+        if (url.compare(0, 8, "https://") == 0) {
+            curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+        }
+    } else {
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_1_1);
+    }
+}
+
+void HttpConnectionPool::release(const std::string& url, CURL* handle) {
+    if (!handle) {
+        return;
+    }
+    
+    long connects = 0;
+    if (curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects) == CURLE_OK && connects > 0) {
+        connections_opened_ += static_cast<uint64_t>(connects);
+    }
+    requests_++;
+    
+    std::string key = host_key(url);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<CURL*>& handles = idle_[key];
+        if (handles.size() < max_idle_per_host_) {
+            handles.push_back(handle);
+            idle_count_++;
+            return;
+        }
+    }
+    curl_easy_cleanup(handle);
+}
+
+HttpConnectionPool::Stats HttpConnectionPool::stats() const {
+    Stats s;
+    s.handles_created = handles_created_.load();
+    s.handles_reused = handles_reused_.load();
+    s.connections_opened = connections_opened_.load();
+    s.requests = requests_.load();
+    std::lock_guard<std::mutex> lock(mutex_);
+    s.idle = idle_count_;
+    return s;
+}
+
+void HttpConnectionPool::clear() {
+    std::map<std::string, std::vector<CURL*> > handles;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handles.swap(idle_);
+        idle_count_ = 0;
+    }
+    for (std::map<std::string, std::vector<CURL*> >::iterator it = handles.begin();
+         it != handles.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); ++i) {
+            curl_easy_cleanup(it->second[i]);
+        }
+    }
+}
+
+// ============================================================================
+// AsyncHttpEngine
+// ============================================================================
+
+struct AsyncHttpEngine::Transfer {
+    CURL* curl;
+    struct curl_slist* header_list;
+    HttpRequest request;        // Owns the body for CURLOPT_POSTFIELDS
+    HttpResponse response;
+    HttpClient::BodySink sink;
+    HttpCallback on_done;
+    
+    Transfer() : curl(nullptr), header_list(nullptr) {}
+};
+
+AsyncHttpEngine& AsyncHttpEngine::instance() {
+    static AsyncHttpEngine engine;
+    return engine;
+}
+
+AsyncHttpEngine::AsyncHttpEngine()
+    : multi_(nullptr)
+    , stop_(false)
+    , in_flight_(0)
+{
+    // Construct the pool first so it outlives the engine at exit
+    HttpConnectionPool& pool = HttpConnectionPool::instance();
+    multi_ = curl_multi_init();
+    if (multi_ && pool.http2()) {
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+}
+
+AsyncHttpEngine::~AsyncHttpEngine() {
+    shutdown();
+    if (multi_) {
+        curl_multi_cleanup(multi_);
+        multi_ = nullptr;
+    }
+}
+
+void AsyncHttpEngine::submit(const HttpRequest& request, HttpCallback on_done) {
+    Transfer* t = new Transfer();
+    t->request = request;
+    t->on_done = on_done;
+    
+    // Checked and queued under the lock shutdown() stops under, so a
+    // transfer is either failed here or seen by shutdown's leftover sweep
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stop_ && multi_) {
+            submitted_.push_back(t);
+            in_flight_++;
+            accepted = true;
+            // Start the loop on first use so processes that never go async pay nothing
+            if (!thread_.joinable()) {
+                thread_ = std::thread(&AsyncHttpEngine::loop, this);
+            }
+        }
+    }
+    if (!accepted) {
+        delete t;
+        HttpResponse resp;
+        resp.error = "HTTP engine stopped";
+        if (on_done) on_done(resp);
+        return;
+    }
+    curl_multi_wakeup(multi_);
+}
+
+std::future<HttpResponse> AsyncHttpEngine::submit(const HttpRequest& request) {
+    std::shared_ptr<std::promise<HttpResponse> > result = std::make_shared<std::promise<HttpResponse> >();
+    std::future<HttpResponse> future = result->get_future();
+    submit(request, [result](const HttpResponse& resp) { result->set_value(resp); });
+    return future;
+}
+
+void AsyncHttpEngine::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) return;
+        stop_ = true;
+    }
+    if (multi_) {
+        curl_multi_wakeup(multi_);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    
+    // Fail whatever never made it onto the engine thread
+    std::vector<Transfer*> leftover;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        leftover.swap(submitted_);
+    }
+    for (size_t i = 0; i < leftover.size(); ++i) {
+        complete(leftover[i], CURLE_ABORTED_BY_CALLBACK);
+    }
+}
+
+void AsyncHttpEngine::start_submitted() {
+    std::vector<Transfer*> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch.swap(submitted_);
+    }
+    
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Transfer* t = batch[i];
+        t->curl = HttpConnectionPool::instance().acquire(t->request.url);
+        if (!t->curl) {
+            complete(t, CURLE_FAILED_INIT);
+            continue;
+        }
+        t->sink.body = &t->response.body;
+        t->sink.on_data = &t->request.on_data;
+        t->header_list = HttpClient::setup_handle(t->curl, t->request.method, t->request.url,
+                                                  t->request.body, t->request.headers,
+                                                  t->request.timeout_ms,
+                                                  &t->sink, &t->response.headers);
+        curl_easy_setopt(t->curl, CURLOPT_PRIVATE, t);
+        active_[t->curl] = t;
+        curl_multi_add_handle(multi_, t->curl);
+    }
+}
+
+void AsyncHttpEngine::reap_completed() {
+    int queued = 0;
+    CURLMsg* msg = nullptr;
+    while ((msg = curl_multi_info_read(multi_, &queued)) != nullptr) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        
+        CURL* easy = msg->easy_handle;
+        CURLcode res = msg->data.result;
+        std::map<CURL*, Transfer*>::iterator it = active_.find(easy);
+        if (it == active_.end()) continue;
+        
+        Transfer* t = it->second;
+        active_.erase(it);
+        curl_multi_remove_handle(multi_, easy);
+        complete(t, res);
+    }
+}
+
+void AsyncHttpEngine::complete(Transfer* t, CURLcode res) {
+    if (t->curl) {
+        HttpClient::finish_response(t->curl, res, t->response);
+    } else {
+        t->response.error = curl_easy_strerror(res);
+    }
+    if (res != CURLE_OK) {
+        t->response.body.clear();
+        t->response.headers.clear();
+    }
+    
+    if (t->header_list) {
+        curl_slist_free_all(t->header_list);
+    }
+    if (t->curl) {
+        HttpConnectionPool::instance().release(t->request.url, t->curl);
+    }
+    
+    HttpCallback cb = t->on_done;
+    HttpResponse resp = t->response;
+    delete t;
+    in_flight_--;
+    
+    if (cb) {
+        try {
+            cb(resp);
+        } catch (const std::exception& e) {
+            LOG_ERROR("[HTTP] Async callback threw exception: %s", e.what());
+        } catch (...) {
+            LOG_ERROR("[HTTP] Async callback threw unknown exception");
+        }
+    }
+}
+
+void AsyncHttpEngine::loop() {
+    LOG_DEBUG("[HTTP] Async engine started");
+    
+    while (!stop_) {
+        start_submitted();
+        
+        int running = 0;
+        curl_multi_perform(multi_, &running);
+        reap_completed();
+        
+        // Sleeps until socket activity, a curl timeout or curl_multi_wakeup()
+        curl_multi_poll(multi_, nullptr, 0, 1000, nullptr);
+    }
+    
+    // Cancel everything still on the wire
+    std::map<CURL*, Transfer*> remaining;
+    remaining.swap(active_);
+    for (std::map<CURL*, Transfer*>::iterator it = remaining.begin(); it != remaining.end(); ++it) {
+        curl_multi_remove_handle(multi_, it->first);
+        complete(it->second, CURLE_ABORTED_BY_CALLBACK);
+    }
+    
+    LOG_DEBUG("[HTTP] Async engine stopped");
+}
+
 } // namespace openclaw
@@ -8,6 +8,7 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <cstring>
+#include <chrono>
 
 namespace openclaw {
 
@@ -55,9 +56,12 @@ bool PluginLoader::load(const std::string& path) {
     }
     
     LoadedPlugin plugin;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     if (!load_impl(full_path, plugin)) {
         return false;
     }
+    plugin.load_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
     
     // Check for duplicate
     if (name_index_.find(plugin.info.name) != name_index_.end()) {
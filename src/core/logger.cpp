@@ -1,7 +1,441 @@
 #include <openclaw/core/logger.hpp>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
 
 namespace openclaw {
 
+namespace {
+
+// Thread-locals here are plain pointers and flags: records may still be
+// logged from destructors that run after a thread's own thread_local
+// objects are gone (static destructors at exit, for one).
+
+// Context of the records of this thread, owned by the innermost LogContext
+thread_local const std::string* t_session = nullptr;
+thread_local const std::string* t_turn = nullptr;
+
+const std::string no_context;
+
+const char* level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        default: return "ERROR";
+    }
+}
+
+int64_t now_ms() {
+    struct timespec ts;
+#ifdef CLOCK_REALTIME_COARSE
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_REALTIME, &ts);
+#endif
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Fixed-size head of each record in a ring; the session, turn and text
+// follow it. Records are padded to a multiple of the head size, so the
+// space left before the end of the buffer always fits a padding record.
+struct RecordHead {
+    uint32_t size;              // Whole record, padded
+    uint8_t level;              // pad_level: skip to the start of the buffer
+    uint8_t reserved;
+    uint16_t session_len;
+    uint16_t turn_len;
+    uint16_t reserved2;
+    uint32_t text_len;
+    uint64_t seq;               // Call order across threads
+    int64_t time_ms;
+};
+
+const uint8_t pad_level = 0xff;
+const size_t record_align = sizeof(RecordHead);
+
+// Records written per writer pass at most
+const size_t max_batch_records = 8192;
+
+// Single-producer (the owning thread), single-consumer (the writer) ring
+class Ring {
+public:
+    explicit Ring(size_t bytes) : head_(0), tail_(0), orphaned(false) {
+        size_t capacity = 4096;
+        while (capacity < bytes) capacity <<= 1;
+        buf_.resize(capacity);
+        mask_ = capacity - 1;
+    }
+
+    // `first` is set when the consumer may have found the ring empty
+    // before this record: the writer has to be woken for it
+    bool push(RecordHead head, const std::string& session, const std::string& turn,
+              const char* text, size_t text_len, bool& first) {
+        size_t session_len = std::min<size_t>(session.size(), 0xffff);
+        size_t turn_len = std::min<size_t>(turn.size(), 0xffff);
+        size_t need = sizeof(RecordHead) + session_len + turn_len + text_len;
+        need = (need + record_align - 1) / record_align * record_align;
+        if (need > buf_.size()) return false;
+
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        uint64_t t = tail_.load(std::memory_order_acquire);
+        uint64_t start = h;
+        size_t offset = static_cast<size_t>(h & mask_);
+        size_t contiguous = buf_.size() - offset;
+        size_t total = contiguous < need ? contiguous + need : need;
+        if (buf_.size() - static_cast<size_t>(h - t) < total) return false;
+
+        if (contiguous < need) {
+            RecordHead pad;
+            memset(&pad, 0, sizeof(pad));
+            pad.size = static_cast<uint32_t>(contiguous);
+            pad.level = pad_level;
+            memcpy(&buf_[offset], &pad, sizeof(pad));
+            h += contiguous;
+            offset = 0;
+        }
+
+        head.size = static_cast<uint32_t>(need);
+        head.session_len = static_cast<uint16_t>(session_len);
+        head.turn_len = static_cast<uint16_t>(turn_len);
+        head.text_len = static_cast<uint32_t>(text_len);
+        char* p = &buf_[offset];
+        memcpy(p, &head, sizeof(head));
+        p += sizeof(head);
+        memcpy(p, session.data(), session_len);
+        p += session_len;
+        memcpy(p, turn.data(), turn_len);
+        p += turn_len;
+        memcpy(p, text, text_len);
+
+        head_.store(h + need, std::memory_order_release);
+        // Pairs with the fence in front(): either the consumer sees this
+        // record or this producer sees the consumer caught up to it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        first = tail_.load(std::memory_order_relaxed) >= start;
+        return true;
+    }
+
+    // Oldest queued record, read in place; false when there is none
+    bool front(RecordHead& head, const char*& body) {
+        uint64_t t = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            if (t == head_.load(std::memory_order_acquire)) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (t == head_.load(std::memory_order_acquire)) return false;
+            }
+            const char* p = &buf_[static_cast<size_t>(t & mask_)];
+            memcpy(&head, p, sizeof(head));
+            if (head.level != pad_level) {
+                body = p + sizeof(head);
+                return true;
+            }
+            t += head.size;
+            tail_.store(t, std::memory_order_release);
+        }
+    }
+
+    // Free the record front() returned
+    void pop(const RecordHead& head) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + head.size, std::memory_order_release);
+    }
+
+    size_t capacity() const { return buf_.size(); }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<char> buf_;
+    size_t mask_;
+    std::atomic<uint64_t> head_;    // Written by the producer
+    std::atomic<uint64_t> tail_;    // Written by the consumer
+
+public:
+    std::atomic<bool> orphaned;     // Thread gone; freed once drained
+};
+
+// The ring of this thread, registered with the writer on first use. Once
+// the thread is exiting its records are written directly.
+thread_local Ring* t_ring = nullptr;
+thread_local bool t_exiting = false;
+
+struct RingOwner {
+    std::shared_ptr<Ring> ring;
+    ~RingOwner() {
+        if (ring) ring->orphaned.store(true);
+        t_ring = nullptr;
+        t_exiting = true;
+    }
+};
+thread_local RingOwner t_ring_owner;
+
+void append_json_string(std::string& out, const char* s, size_t len) {
+    out += '"';
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char esc[8];
+                    snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    out += esc;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+} // anonymous namespace
+
+struct Logger::Backend {
+    LogOptions options;
+    bool json;
+    FILE* out;
+    size_t file_bytes;
+
+    std::atomic<bool> async;
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> dropped;
+    uint64_t reported_drops;
+
+    std::mutex mutex;                           // Rings, output, options
+    std::vector<std::shared_ptr<Ring> > rings;
+
+    std::thread writer;
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    std::condition_variable pass_cv;            // A writer pass completed
+    bool stopping;
+    bool wake_pending;                          // A record landed in an empty ring
+    uint64_t passes;
+    uint64_t flush_until;                       // Keep passing until this many
+
+    // Formatted local time of the current second
+    int64_t stamp_sec;
+    char stamp[32];
+
+    Backend()
+        : json(false), out(stderr), file_bytes(0), async(false), seq(0), dropped(0)
+        , reported_drops(0), stopping(false), wake_pending(false), passes(0), flush_until(0)
+        , stamp_sec(-1) {
+        stamp[0] = '\0';
+    }
+
+    void wake() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            wake_pending = true;
+        }
+        wake_cv.notify_one();
+    }
+
+    // Null once the thread is exiting
+    Ring* thread_ring() {
+        if (!t_ring && !t_exiting) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::shared_ptr<Ring> ring = std::make_shared<Ring>(options.ring_bytes);
+            rings.push_back(ring);
+            t_ring_owner.ring = ring;
+            t_ring = ring.get();
+        }
+        return t_ring;
+    }
+
+    // Local time to the second, computed once per second
+    const char* stamp_for(int64_t time_ms) {
+        int64_t sec = time_ms / 1000;
+        if (sec != stamp_sec) {
+            time_t t = static_cast<time_t>(sec);
+            struct tm tm;
+            localtime_r(&t, &tm);
+            strftime(stamp, sizeof(stamp), json ? "%Y-%m-%dT%H:%M:%S" : "%Y-%m-%d %H:%M:%S", &tm);
+            stamp_sec = sec;
+        }
+        return stamp;
+    }
+
+    void format(std::string& line, LogLevel level, int64_t time_ms,
+                const char* session, size_t session_len, const char* turn, size_t turn_len,
+                const char* text, size_t text_len) {
+        const char* ts = stamp_for(time_ms);
+        if (!json) {
+            line += '[';
+            line += ts;
+            line += "] [";
+            line += level_name(level);
+            line += "] ";
+            line.append(text, text_len);
+            line += '\n';
+            return;
+        }
+        char ms[8];
+        snprintf(ms, sizeof(ms), ".%03d", static_cast<int>(time_ms % 1000));
+        line += "{\"time\":\"";
+        line += ts;
+        line += ms;
+        line += "\",\"level\":\"";
+        line += level_name(level);
+        line += '"';
+        if (session_len > 0) {
+            line += ",\"session\":";
+            append_json_string(line, session, session_len);
+        }
+        if (turn_len > 0) {
+            line += ",\"turn\":";
+            append_json_string(line, turn, turn_len);
+        }
+        line += ",\"msg\":";
+        append_json_string(line, text, text_len);
+        line += "}\n";
+    }
+
+    void write_out(const std::string& data) {
+        fwrite(data.data(), 1, data.size(), out);
+        fflush(out);
+        file_bytes += data.size();
+        if (out != stderr && options.max_file_bytes > 0 && file_bytes > options.max_file_bytes) {
+            rotate();
+        }
+    }
+
+    // file -> file.1 -> ... -> file.N (dropped)
+    void rotate() {
+        fclose(out);
+        const std::string& path = options.file;
+        for (int i = options.max_files; i >= 1; --i) {
+            std::string from = i == 1 ? path : path + "." + std::to_string(i - 1);
+            std::string to = path + "." + std::to_string(i);
+            rename(from.c_str(), to.c_str());
+        }
+        if (options.max_files < 1) {
+            remove(path.c_str());
+        }
+        out = fopen(path.c_str(), "a");
+        if (!out) out = stderr;
+        file_bytes = 0;
+    }
+
+    // Called with mutex held
+    bool open_output(const LogOptions& opts) {
+        if (out != stderr) fclose(out);
+        out = stderr;
+        file_bytes = 0;
+        if (opts.file.empty()) return true;
+
+        FILE* f = fopen(opts.file.c_str(), "a");
+        if (!f) return false;
+        struct stat st;
+        if (fstat(fileno(f), &st) == 0) file_bytes = static_cast<size_t>(st.st_size);
+        out = f;
+        return true;
+    }
+
+    // Direct write on the caller (no writer running)
+    void write_direct(LogLevel level, const char* text, size_t len) {
+        std::string line;
+        line.reserve(len + 64);
+        std::lock_guard<std::mutex> lock(mutex);
+        const std::string& session = t_session ? *t_session : no_context;
+        const std::string& turn = t_turn ? *t_turn : no_context;
+        format(line, level, now_ms(), session.data(), session.size(),
+               turn.data(), turn.size(), text, len);
+        write_out(line);
+    }
+
+    // One writer pass: the queued records of all rings, merged back into
+    // call order and formatted straight from the rings. False when there
+    // was nothing to write.
+    bool write_pass() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string data;
+        uint64_t drops = dropped.load();
+        if (drops != reported_drops) {
+            char note[96];
+            int n = snprintf(note, sizeof(note), "Logger: dropped %llu records (ring full)",
+                             static_cast<unsigned long long>(drops - reported_drops));
+            format(data, LogLevel::WARN, now_ms(), "", 0, "", 0, note, static_cast<size_t>(n));
+            reported_drops = drops;
+        }
+
+        // Rings hold their records in call order; repeatedly take the
+        // oldest front. Bounded, so busy producers cannot starve a write.
+        std::vector<RecordHead> heads(rings.size());
+        std::vector<const char*> bodies(rings.size());
+        std::vector<bool> ready(rings.size());
+        for (size_t i = 0; i < rings.size(); ++i) {
+            ready[i] = rings[i]->front(heads[i], bodies[i]);
+        }
+        for (size_t n = 0; n < max_batch_records; ++n) {
+            size_t oldest = rings.size();
+            for (size_t i = 0; i < rings.size(); ++i) {
+                if (ready[i] && (oldest == rings.size() || heads[i].seq < heads[oldest].seq)) {
+                    oldest = i;
+                }
+            }
+            if (oldest == rings.size()) break;
+
+            const RecordHead& head = heads[oldest];
+            const char* session = bodies[oldest];
+            const char* turn = session + head.session_len;
+            const char* text = turn + head.turn_len;
+            format(data, static_cast<LogLevel>(head.level), head.time_ms,
+                   session, head.session_len, turn, head.turn_len, text, head.text_len);
+            rings[oldest]->pop(head);
+            ready[oldest] = rings[oldest]->front(heads[oldest], bodies[oldest]);
+        }
+
+        for (size_t i = 0; i < rings.size(); ) {
+            if (rings[i]->orphaned.load() && rings[i]->empty()) {
+                rings.erase(rings.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+
+        if (data.empty()) return false;
+        write_out(data);
+        return true;
+    }
+
+    void run() {
+        for (;;) {
+            bool stop;
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                stop = stopping;
+                wake_pending = false;
+            }
+            bool wrote = write_pass();
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                passes++;
+            }
+            pass_cv.notify_all();
+            if (wrote) continue;
+            if (stop) break;
+
+            // Idle until a record lands in an empty ring, a flush or shutdown
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake_cv.wait(lock, [this] { return wake_pending || stopping || passes < flush_until; });
+        }
+    }
+};
+
 // Force visibility for the singleton across shared library boundaries
 #ifdef __GNUC__
 __attribute__((visibility("default")))
@@ -11,54 +445,160 @@ Logger& Logger::instance() {
     return logger;
 }
 
-void Logger::set_level(LogLevel level) { level_ = level; }
+std::atomic<int> Logger::level_(static_cast<int>(LogLevel::INFO));
+
+void Logger::set_level(LogLevel level) { level_.store(static_cast<int>(level)); }
 
-LogLevel Logger::level() const { return level_; }
+LogLevel Logger::level() const { return static_cast<LogLevel>(level_.load()); }
 
 void Logger::debug(const char* fmt, ...) {
-    if (level_ > LogLevel::DEBUG) return;
+    if (!enabled(LogLevel::DEBUG)) return;
     va_list args;
     va_start(args, fmt);
-    log_impl("DEBUG", fmt, args);
+    log_impl(LogLevel::DEBUG, fmt, args);
     va_end(args);
 }
 
 void Logger::info(const char* fmt, ...) {
-    if (level_ > LogLevel::INFO) return;
+    if (!enabled(LogLevel::INFO)) return;
     va_list args;
     va_start(args, fmt);
-    log_impl("INFO", fmt, args);
+    log_impl(LogLevel::INFO, fmt, args);
     va_end(args);
 }
 
 void Logger::warn(const char* fmt, ...) {
-    if (level_ > LogLevel::WARN) return;
+    if (!enabled(LogLevel::WARN)) return;
     va_list args;
     va_start(args, fmt);
-    log_impl("WARN", fmt, args);
+    log_impl(LogLevel::WARN, fmt, args);
     va_end(args);
 }
 
 void Logger::error(const char* fmt, ...) {
-    if (level_ > LogLevel::ERROR) return;
+    if (!enabled(LogLevel::ERROR)) return;
     va_list args;
     va_start(args, fmt);
-    log_impl("ERROR", fmt, args);
+    log_impl(LogLevel::ERROR, fmt, args);
     va_end(args);
 }
 
-Logger::Logger() : level_(LogLevel::INFO) {}
+// The backend is never freed: threads may still log during exit
+Logger::Logger() : backend_(new Backend()) {}
+
+Logger::~Logger() {
+    shutdown();
+}
+
+bool Logger::configure(const LogOptions& options) {
+    shutdown();
+
+    Backend& b = *backend_;
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(b.mutex);
+        b.options = options;
+        b.json = options.format == "json";
+        b.stamp_sec = -1;
+        ok = b.open_output(options);
+    }
+    if (!ok) {
+        LOG_ERROR("Cannot open log file %s, logging to stderr", options.file.c_str());
+    }
+
+    if (options.async) {
+        b.stopping = false;
+        b.writer = std::thread([&b] { b.run(); });
+        b.async.store(true, std::memory_order_release);
+    }
+    return ok;
+}
+
+void Logger::flush() {
+    Backend& b = *backend_;
+    if (!b.writer.joinable()) return;
+
+    // Two more passes: the second starts after this call
+    std::unique_lock<std::mutex> lock(b.wake_mutex);
+    uint64_t target = b.passes + 2;
+    b.flush_until = std::max(b.flush_until, target);
+    b.wake_cv.notify_one();
+    b.pass_cv.wait(lock, [&b, target] { return b.passes >= target || b.stopping; });
+}
+
+void Logger::shutdown() {
+    Backend& b = *backend_;
+    if (!b.writer.joinable()) return;
+
+    b.async.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(b.wake_mutex);
+        b.stopping = true;
+    }
+    b.wake_cv.notify_one();
+    b.writer.join();
+
+    // Records pushed while the writer was stopping
+    b.write_pass();
+}
+
+uint64_t Logger::dropped() const {
+    return backend_->dropped.load();
+}
+
+void Logger::log_impl(LogLevel level, const char* fmt, va_list args) {
+    char small[512];
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(small, sizeof(small), fmt, copy);
+    va_end(copy);
+    if (n < 0) return;
+
+    const char* text = small;
+    std::vector<char> large;
+    if (static_cast<size_t>(n) >= sizeof(small)) {
+        large.resize(static_cast<size_t>(n) + 1);
+        vsnprintf(&large[0], large.size(), fmt, args);
+        text = &large[0];
+    }
+
+    Backend& b = *backend_;
+    if (!b.async.load(std::memory_order_acquire)) {
+        b.write_direct(level, text, static_cast<size_t>(n));
+        return;
+    }
+
+    // A record too big for the ring goes out directly, still whole
+    Ring* ring = b.thread_ring();
+    if (!ring || static_cast<size_t>(n) > ring->capacity() / 4) {
+        b.write_direct(level, text, static_cast<size_t>(n));
+        return;
+    }
+    RecordHead head;
+    memset(&head, 0, sizeof(head));
+    head.level = static_cast<uint8_t>(level);
+    head.seq = b.seq.fetch_add(1, std::memory_order_relaxed);
+    head.time_ms = now_ms();
+    bool first = false;
+    if (!ring->push(head, t_session ? *t_session : no_context, t_turn ? *t_turn : no_context,
+                    text, static_cast<size_t>(n), first)) {
+        b.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // The writer drains every ring before it sleeps again, so only a
+    // record it may have missed needs to wake it
+    if (first) b.wake();
+}
+
+LogContext::LogContext(const std::string& session, const std::string& turn)
+    : session_(session), turn_(turn), prev_session_(t_session), prev_turn_(t_turn) {
+    t_session = &session_;
+    t_turn = &turn_;
+}
 
-void Logger::log_impl(const char* level_str, const char* fmt, va_list args) {
-    time_t now = time(NULL);
-    struct tm* t = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", t);
-    
-    fprintf(stderr, "[%s] [%s] ", timestamp, level_str);
-    vfprintf(stderr, fmt, args);
-    fprintf(stderr, "\n");
-    fflush(stderr);
+LogContext::~LogContext() {
+    t_session = prev_session_;
+    t_turn = prev_turn_;
 }
 
 } // namespace openclaw
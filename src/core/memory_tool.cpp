@@ -3,6 +3,8 @@
  */
 #include <openclaw/core/memory_tool.hpp>
 #include <openclaw/core/registry.hpp>
+#include <openclaw/core/application.hpp>
+#include <openclaw/core/session.hpp>
 #include <sstream>
 
 namespace openclaw {
@@ -197,6 +199,20 @@ bool MemoryTool::init(const Config& cfg) {
     config_.chunking.overlap_tokens = cfg.get_int("memory_chunk_overlap", 80);
     config_.search.max_results = cfg.get_int("memory_max_results", 10);
     config_.search.min_score = 0.1;
+    // Results carry an FTS5 snippet of this many tokens, not the whole chunk
+    config_.search.snippet_tokens = cfg.get_int("memory.snippet_tokens", 48);
+    
+    // Embeddings for hybrid (BM25 + vector) search
+    config_.embedding.url = cfg.get_string("memory.embedding_url", "");
+    config_.embedding.model = cfg.get_string("memory.embedding_model", "");
+    config_.embedding.api_key = cfg.get_string("memory.embedding_api_key", "");
+    config_.embedding.batch_size = cfg.get_int("memory.embedding_batch", 32);
+    config_.embedding.nprobe = cfg.get_int("memory.vector_nprobe", 8);
+    
+    // Reindex files as they change instead of only on explicit syncs
+    config_.watch_enabled = cfg.get_bool("memory.watch", true);
+    config_.watch_debounce_ms = cfg.get_int("memory.watch_debounce_ms", 1500);
+    config_.read_connections = cfg.get_int("memory.read_connections", 4);
     
     manager_.reset(new MemoryManager(config_));
     
@@ -207,6 +223,26 @@ bool MemoryTool::init(const Config& cfg) {
     // Perform initial sync
     manager_->sync();
     
+    // Due tasks are sent to the chat they were created from, at the deadline
+    if (cfg.get_bool("memory.task_reminders", true)) {
+        MemoryManager* manager = manager_.get();
+        manager_->set_task_callback([manager](const MemoryTask& task) {
+            if (task.channel.empty() || task.user_id.empty()) return;
+            std::string text = "Reminder: " + task.content;
+            if (!task.context.empty()) text += "\n" + task.context;
+            MemoryTask due = task;
+            Application::instance().thread_pool().enqueue_serial("reminder:" + task.channel,
+                [manager, due, text] {
+                    ChannelPlugin* channel = PluginRegistry::instance().get_channel(due.channel);
+                    if (!channel) return;
+                    std::string id = due.id;
+                    channel->send_message_async(due.user_id, text, "", [manager, id](const SendResult& result) {
+                        if (result.success) manager->mark_task_notified(id);
+                    });
+                });
+        });
+    }
+    
     initialized_ = true;
     return true;
 }
@@ -516,8 +552,8 @@ Json MemoryTool::memory_search(const Json& params) {
         return make_error("Query is required");
     }
     
-    MemorySearchConfig config;
-    config.max_results = params.value("max_results", 10);
+    MemorySearchConfig config = config_.search;
+    config.max_results = params.value("max_results", config_.search.max_results);
     
     std::vector<MemorySearchResult> results = manager_->search(query, config);
     
@@ -589,7 +625,15 @@ Json MemoryTool::task_create(const Json& params) {
     }
     
     std::string context = params.value("context", std::string(""));
-    std::string task_id = manager_->create_task(content, context);
+    
+    // Remember the chat of the current turn, for the due reminder
+    std::string channel, user_id;
+    SessionPtr session = SessionManager::instance().find_session(ContentChunker::current_scope());
+    if (session) {
+        channel = session->channel();
+        user_id = session->peer_id();
+    }
+    std::string task_id = manager_->create_task(content, context, channel, user_id);
     
     if (task_id.empty()) {
         return make_error("Failed to create task");
@@ -638,7 +682,7 @@ Json MemoryTool::task_list(const Json& params) {
         item["content"] = t.content;
         item["context"] = t.context;
         item["created_at"] = static_cast<int>(t.created_at);
-        item["due_at"] = static_cast<int>(t.due_at);
+        item["due_at"] = t.due_at;
         item["completed"] = t.completed;
         if (t.completed) {
             item["completed_at"] = static_cast<int>(t.completed_at);
@@ -7,13 +7,434 @@
 #include <openclaw/core/application.hpp>
 #include <openclaw/core/logger.hpp>
 #include <openclaw/core/channel.hpp>
+#include <openclaw/core/memory_tool.hpp>
+#include <openclaw/core/metrics.hpp>
+#include <openclaw/core/timer_wheel.hpp>
+#include <openclaw/core/utils.hpp>
 #include <openclaw/ai/ai.hpp>
 
 #include <sstream>
 #include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 namespace openclaw {
 
+// ============================================================================
+// Admission Control
+// ============================================================================
+
+AdmissionConfig::Policy AdmissionConfig::parse_policy(const std::string& name) {
+    if (name == "reject") return REJECT;
+    if (name == "coalesce") return COALESCE;
+    return BUSY;
+}
+
+AdmissionConfig AdmissionConfig::from_config(const Config& cfg) {
+    AdmissionConfig ac;
+    ac.policy = parse_policy(cfg.get_string("admission.policy", "busy"));
+    ac.max_queue = static_cast<size_t>(cfg.get_int("admission.max_queue", 32));
+    ac.max_wait_ms = static_cast<int64_t>(cfg.get_int("admission.max_wait_seconds", 120)) * 1000;
+    ac.queue_capacity = static_cast<size_t>(cfg.get_int("admission.queue_capacity", 256));
+    ac.retry_hint_seconds = cfg.get_int("admission.retry_hint_seconds", 30);
+    return ac;
+}
+
+RoutingConfig RoutingConfig::from_config(const Config& cfg) {
+    RoutingConfig rc;
+    rc.stream_edits = cfg.get_bool("routing.stream_edits", true);
+    const Json& section = cfg.get_section("routing");
+    if (!section.is_object() || !section.contains("broadcast") || !section["broadcast"].is_array()) {
+        return rc;
+    }
+    for (const auto& entry : section["broadcast"]) {
+        Target target;
+        if (entry.is_string()) {
+            target.channel = entry.get<std::string>();
+        } else if (entry.is_object()) {
+            target.channel = entry.value("channel", std::string(""));
+            target.to = entry.value("to", std::string(""));
+        }
+        if (!target.channel.empty()) rc.broadcast.push_back(target);
+    }
+    return rc;
+}
+
+RecallConfig RecallConfig::from_config(const Config& cfg) {
+    RecallConfig rc;
+    rc.enabled = cfg.get_bool("memory_recall.enabled", false);
+    rc.max_results = cfg.get_int("memory_recall.max_results", 3);
+    const Json& section = cfg.get_section("memory_recall");
+    if (section.is_object()) rc.min_score = section.value("min_score", rc.min_score);
+    rc.max_tokens = cfg.get_int("memory_recall.max_tokens", 600);
+    rc.wait_ms = cfg.get_int("memory_recall.wait_ms", 150);
+    rc.min_chars = static_cast<size_t>(cfg.get_int("memory_recall.min_chars", 12));
+    return rc;
+}
+
+namespace {
+
+// A recall search running on the pool; whoever finishes last frees it
+struct PendingRecall {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done;
+    std::string block;
+    
+    PendingRecall() : done(false) {}
+};
+typedef std::shared_ptr<PendingRecall> RecallPtr;
+
+// Snippets as one note for the model, cut to the token budget
+std::string format_recall(const std::vector<MemorySearchResult>& results, const RecallConfig& rc) {
+    std::string block;
+    int used = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const MemorySearchResult& r = results[i];
+        if (r.score < rc.min_score || r.snippet.empty()) continue;
+        std::string line = "- " + r.format_citation() + ": " + r.snippet + "\n";
+        int tokens = TokenEstimator::count_text(line);
+        if (used + tokens > rc.max_tokens) break;
+        used += tokens;
+        block += line;
+    }
+    if (block.empty()) return block;
+    return "[Possibly relevant notes from memory; use them only if they help answer]\n" + block +
+           "[End of notes]";
+}
+
+// Start a search on the pool, or return null when recall does not apply
+RecallPtr start_recall(const std::string& text) {
+    auto& app = Application::instance();
+    RuntimeSettingsPtr settings = app.settings();
+    const RecallConfig& rc = settings->recall;
+    if (!rc.enabled || text.size() < rc.min_chars || text[0] == '/') return RecallPtr();
+    
+    MemoryTool* tool = static_cast<MemoryTool*>(app.registry().get_tool("memory"));
+    MemoryManager* memory = tool ? tool->memory_manager() : nullptr;
+    if (!memory || !memory->is_initialized()) return RecallPtr();
+    
+    RecallPtr recall = std::make_shared<PendingRecall>();
+    RecallConfig config = rc;
+    // Part of an AI turn, so it shares the turn's lane; if no worker is
+    // free within recall.wait_ms the turn goes ahead without it
+    bool queued = app.thread_pool().try_enqueue([recall, memory, config, text] {
+        MemorySearchConfig search;
+        search.max_results = config.max_results;
+        search.min_score = config.min_score;
+        std::string block = format_recall(memory->search(text, search), config);
+        std::lock_guard<std::mutex> lock(recall->mutex);
+        recall->block = block;
+        recall->done = true;
+        recall->cv.notify_all();
+    }, TaskPriority::NORMAL);
+    return queued ? recall : RecallPtr();
+}
+
+// The search result if it is ready within wait_ms; a late one is dropped
+std::string await_recall(const RecallPtr& recall) {
+    if (!recall) return std::string();
+    std::unique_lock<std::mutex> lock(recall->mutex);
+    int64_t wait_ms = Application::instance().settings()->recall.wait_ms;
+    if (!recall->cv.wait_for(lock, std::chrono::milliseconds(wait_ms), [&recall] { return recall->done; })) {
+        LOG_DEBUG("[Recall] Memory search not ready after %lld ms, skipping", static_cast<long long>(wait_ms));
+        return std::string();
+    }
+    return recall->block;
+}
+
+}
+
+namespace {
+
+// A slash command without the @botname suffix some chats add to it
+std::string command_text(const std::string& text) {
+    std::string cmd_text = text;
+    auto at_pos = cmd_text.find('@');
+    if (at_pos != std::string::npos) {
+        auto space_pos = cmd_text.find(' ');
+        if (space_pos == std::string::npos || at_pos < space_pos) {
+            cmd_text = cmd_text.substr(0, at_pos) +
+                      (space_pos != std::string::npos ? cmd_text.substr(space_pos) : "");
+        }
+    }
+    return cmd_text;
+}
+
+// Skill commands are slash commands too, but each runs an agent turn
+bool is_skill_command(const std::string& text) {
+    auto& app = Application::instance();
+    return app.skills().resolve_skill_command_invocation(
+        command_text(text), app.skill_command_table()).first != nullptr;
+}
+
+// AI messages that are queued but not started yet, by session key.
+// Used by the COALESCE policy to fold a new message into the queued one.
+std::mutex g_queued_mutex;
+std::map<std::string, std::shared_ptr<Message> > g_queued_messages;
+
+bool coalesce_into_queued(const std::string& session_key, const Message& msg) {
+    std::lock_guard<std::mutex> lock(g_queued_mutex);
+    std::map<std::string, std::shared_ptr<Message> >::iterator it = g_queued_messages.find(session_key);
+    if (it == g_queued_messages.end()) {
+        return false;
+    }
+    it->second->text += "\n\n" + msg.text;
+    return true;
+}
+
+// Caller holds g_queued_mutex. Only removes the entry if it is still ours.
+void forget_queued_locked(const std::string& session_key, const std::shared_ptr<Message>& queued) {
+    std::map<std::string, std::shared_ptr<Message> >::iterator it = g_queued_messages.find(session_key);
+    if (it != g_queued_messages.end() && it->second == queued) {
+        g_queued_messages.erase(it);
+    }
+}
+
+void send_busy_reply(const Message& msg, int retry_seconds) {
+    auto* channel = Application::instance().registry().get_channel(msg.channel);
+    if (!channel) return;
+    
+    std::string text = "⏳ I'm handling a lot of requests right now. Please retry in " +
+                       std::to_string(retry_seconds) + " s.";
+    std::string channel_id = msg.channel;
+    channel->send_message_async(msg.to, text, msg.id, [channel_id](const SendResult& result) {
+        if (!result.success) {
+            LOG_WARN("Failed to send busy reply to %s: %s", channel_id.c_str(), result.error.c_str());
+        }
+    });
+}
+
+// Queue every chunk with the channel at once; its send queue keeps them
+// in order per chat, so they go out back to back without waiting on us
+void deliver_chunks(ChannelPlugin* channel, const std::string& to, const std::string& reply_to,
+                    const std::vector<std::string>& chunks) {
+    std::string channel_id = channel->channel_id();
+    bool first = true;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const std::string& chunk = chunks[i];
+        if (chunk.empty()) continue;
+        
+        channel->send_message_async(to, chunk, first ? reply_to : std::string(),
+            [channel_id, to, chunk, reply_to](const SendResult& result) {
+                if (!result.success) {
+                    LOG_ERROR("Failed to send response to %s: %s", channel_id.c_str(), result.error.c_str());
+                    return;
+                }
+                LOG_DEBUG("[MessageHandler] Message sent to %s: %s", channel_id.c_str(), result.message_id.c_str());
+                notify_outgoing_message(channel_id, to, chunk, reply_to);
+            });
+        first = false;
+    }
+}
+
+// Replies are sent in chunks of at most this many characters
+const size_t reply_chunk_chars = 3500;
+
+// Shows an AI reply while it is generated, on a channel that can edit
+// messages: the first text goes out as the reply, later text edits it,
+// no more often than the channel's edit interval. finish() then turns the
+// message into the first chunk of the complete reply.
+class ReplyStreamer : public std::enable_shared_from_this<ReplyStreamer> {
+public:
+    ReplyStreamer(ChannelPlugin* channel, const std::string& to, const std::string& reply_to)
+        : channel_(channel)
+        , channel_id_(channel->channel_id())
+        , to_(to)
+        , reply_to_(reply_to)
+        , interval_ms_(std::max(channel->capabilities().edit_interval_ms, 1))
+        , last_sent_ms_(0)
+        , started_(false)
+        , busy_(false)
+        , failed_(false)
+        , finished_(false)
+        , capped_(false)
+        , flush_timer_(0) {}
+    
+    ~ReplyStreamer() {
+        if (flush_timer_) TimerWheel::instance().cancel(flush_timer_);
+    }
+    
+    void on_delta(const std::string& chunk) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (finished_ || failed_ || capped_) return;
+        text_ += chunk;
+        // Shown text is capped at one chunk, the rest follows at the end.
+        // Once the reply outgrows it that chunk is settled: later deltas
+        // cannot change it, so they are not kept.
+        if (text_.size() > reply_chunk_chars) {
+            text_ = split_message_chunks(text_, reply_chunk_chars).front();
+            capped_ = true;
+        }
+        pump(lock);
+    }
+    
+    // Deliver the complete reply. False when nothing was streamed, in which
+    // case the caller sends it the usual way.
+    bool finish(const std::vector<std::string>& chunks) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_ = true;
+        if (!started_) return false;
+        final_chunks_ = chunks;
+        pump(lock);
+        return true;
+    }
+    
+private:
+    // Send or edit if due; called with the lock held, returns with it held
+    void pump(std::unique_lock<std::mutex>& lock) {
+        if (busy_) return;
+        
+        if (finished_) {
+            if (!final_chunks_.empty()) deliver_final(lock);
+            return;
+        }
+        
+        // A copy: it is sent after the lock is released (at most one chunk)
+        std::string shown = text_;
+        if (shown.empty() || shown == shown_) return;
+        
+        int64_t now = current_timestamp_ms();
+        if (started_ && now - last_sent_ms_ < interval_ms_) {
+            // Deltas may pause (tool calls); show what we have once due
+            if (!flush_timer_) {
+                std::weak_ptr<ReplyStreamer> weak = shared_from_this();
+                flush_timer_ = TimerWheel::instance().schedule_in(interval_ms_ - (now - last_sent_ms_), [weak] {
+                    std::shared_ptr<ReplyStreamer> self = weak.lock();
+                    if (!self) return;
+                    std::unique_lock<std::mutex> timer_lock(self->mutex_);
+                    self->flush_timer_ = 0;
+                    self->pump(timer_lock);
+                });
+            }
+            return;
+        }
+        
+        busy_ = true;
+        shown_ = shown;
+        last_sent_ms_ = now;
+        bool first = !started_;
+        started_ = true;
+        std::string message_id = message_id_;
+        std::shared_ptr<ReplyStreamer> self = shared_from_this();
+        lock.unlock();
+        
+        SendCallback done = [self, first](const SendResult& result) {
+            std::unique_lock<std::mutex> done_lock(self->mutex_);
+            self->busy_ = false;
+            if (first) {
+                if (result.success) {
+                    self->message_id_ = result.message_id;
+                } else {
+                    LOG_WARN("[Stream] First send to %s failed: %s", self->channel_id_.c_str(), result.error.c_str());
+                    self->failed_ = true;
+                }
+            }
+            self->pump(done_lock);
+        };
+        if (first) {
+            channel_->send_message_async(to_, shown, reply_to_, done);
+        } else {
+            channel_->edit_message_async(to_, message_id, shown, done);
+        }
+        lock.lock();
+    }
+    
+    // Edit the streamed message into the first chunk and send the others
+    void deliver_final(std::unique_lock<std::mutex>& lock) {
+        std::vector<std::string> chunks;
+        chunks.swap(final_chunks_);
+        std::string message_id = message_id_;
+        bool edit = !failed_ && !message_id.empty();
+        lock.unlock();
+        
+        if (!edit) {
+            deliver_chunks(channel_, to_, reply_to_, chunks);
+        } else {
+            std::string channel_id = channel_id_;
+            std::string to = to_;
+            std::string reply_to = reply_to_;
+            std::string text = chunks.front();
+            channel_->edit_message_async(to_, message_id, text,
+                [channel_id, to, text, reply_to](const SendResult& result) {
+                    if (!result.success) {
+                        LOG_ERROR("Failed to finish streamed reply on %s: %s", channel_id.c_str(), result.error.c_str());
+                        return;
+                    }
+                    notify_outgoing_message(channel_id, to, text, reply_to);
+                });
+            chunks.erase(chunks.begin());
+            deliver_chunks(channel_, to_, "", chunks);
+        }
+        lock.lock();
+    }
+    
+    ChannelPlugin* channel_;
+    std::string channel_id_;
+    std::string to_;
+    std::string reply_to_;
+    int64_t interval_ms_;
+    
+    std::mutex mutex_;
+    std::string text_;                  // Streamed so far, up to the first chunk
+    std::string shown_;                 // Text last sent or edited in
+    std::string message_id_;
+    int64_t last_sent_ms_;
+    bool started_;                      // First send queued
+    bool busy_;                         // A send or edit in flight
+    bool failed_;                       // First send failed; stop streaming
+    bool finished_;
+    bool capped_;                       // text_ is the settled first chunk
+    std::vector<std::string> final_chunks_;
+    TimerWheel::TimerId flush_timer_;
+};
+
+typedef std::shared_ptr<ReplyStreamer> ReplyStreamerPtr;
+
+// Streamers of turns in progress, by channel and message ID, for
+// send_response to pick up
+std::mutex g_streamers_mutex;
+std::map<std::string, ReplyStreamerPtr> g_streamers;
+
+std::string streamer_key(const Message& msg) {
+    return msg.channel + ":" + msg.id;
+}
+
+ReplyStreamerPtr take_streamer(const Message& msg) {
+    std::lock_guard<std::mutex> lock(g_streamers_mutex);
+    std::map<std::string, ReplyStreamerPtr>::iterator it = g_streamers.find(streamer_key(msg));
+    if (it == g_streamers.end()) return ReplyStreamerPtr();
+    ReplyStreamerPtr streamer = it->second;
+    g_streamers.erase(it);
+    return streamer;
+}
+
+// Per-stage totals of a finished turn, while a load run is measuring.
+// Stages the turn never reached (no tool call, say) are left out.
+void record_stage_latency(const AgentTrace& trace) {
+    StageLatency& latency = StageLatency::instance();
+    if (!latency.enabled()) return;
+    static const char* const kinds[] = { "queue", "ai", "tool", "parse", "format" };
+    const std::vector<TraceSpan>& spans = trace.spans();
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); ++i) {
+        for (size_t j = 0; j < spans.size(); ++j) {
+            if (spans[j].kind == kinds[i]) {
+                latency.record(kinds[i], trace.total_us(kinds[i]));
+                break;
+            }
+        }
+    }
+    latency.record("turn", trace.total_us());
+}
+
+// Rate limit and queue a message that runs on this node
+void admit_message(const Message& msg, const std::string& session_key);
+
+} // anonymous namespace
+
 // ============================================================================
 // Plugin Notification
 // ============================================================================
@@ -46,6 +467,15 @@ void notify_outgoing_message(
     }
 }
 
+void notify_turn_event(const TurnEvent& event) {
+    auto& app = Application::instance();
+    for (auto* plugin : app.registry().plugins()) {
+        if (plugin && plugin->is_initialized()) {
+            plugin->on_turn_event(event);
+        }
+    }
+}
+
 // ============================================================================
 // Error Callback
 // ============================================================================
@@ -67,8 +497,41 @@ void on_message(const Message& msg) {
         return;
     }
     
-    LOG_INFO("[%s] Message from %s: %s", 
-             msg.channel.c_str(), msg.from_name.c_str(), msg.text.c_str());
+    LOG_INFO("[%s] Message from %s (%zu chars)",
+             msg.channel.c_str(), msg.from_name.c_str(), msg.text.size());
+    LOG_DEBUG("[%s] Message text: %s", msg.channel.c_str(), msg.text.c_str());
+    
+    // In a cluster the session's owner runs the turn
+    std::string session_key = app.sessions().session_key_for_message(msg);
+    if (app.cluster().forward(msg, session_key)) return;
+    
+    admit_message(msg, session_key);
+}
+
+bool accept_message(const Message& msg) {
+    auto& app = Application::instance();
+    if (!app.registry().get_channel(msg.channel)) {
+        LOG_WARN("Cannot accept message %s: channel %s is not loaded here",
+                 msg.id.c_str(), msg.channel.c_str());
+        return false;
+    }
+    admit_message(msg, app.sessions().session_key_for_message(msg));
+    return true;
+}
+
+namespace {
+
+void admit_message(const Message& msg, const std::string& session_key) {
+    auto& app = Application::instance();
+    
+    // A session that just moved here: let its old owner finish and release it
+    int64_t hold_ms = app.cluster().handoff_wait_ms(session_key);
+    if (hold_ms > 0) {
+        TimerWheel::instance().schedule_in(hold_ms, [msg, session_key] {
+            admit_message(msg, session_key);
+        });
+        return;
+    }
     
     // Notify all plugins
     for (auto* plugin : app.registry().plugins()) {
@@ -80,19 +543,94 @@ void on_message(const Message& msg) {
     // Rate limit check
     auto rate_result = app.user_limiter().check(msg.from);
     if (!rate_result.allowed) {
+        static Counter& denied = Metrics::instance().counter(
+            "openclaw_rate_limit_denied_total", "Messages dropped by the per-user rate limit");
+        denied.inc();
         LOG_WARN("Rate limit exceeded for user %s, retry in %lldms", 
                  msg.from.c_str(), static_cast<long long>(rate_result.retry_after_ms));
         return;
     }
     
-    // Process in thread pool (non-blocking)
-    // Copy msg for the lambda capture
-    Message msg_copy = msg;
-    app.thread_pool().enqueue([msg_copy]() {
-        process_message(msg_copy);
-    });
+    // Process in thread pool (non-blocking). Messages for the same session
+    // go through one strand so history is never mutated concurrently.
+    // Built-in commands use the high-priority lane; AI turns and skill
+    // commands, which are agent turns as well, the normal one.
+    // Once the pool is overloaded the admission policy sheds AI messages.
+    bool command = !msg.text.empty() && msg.text[0] == '/';
+    TaskPriority priority = (command && !is_skill_command(msg.text))
+        ? TaskPriority::HIGH : TaskPriority::NORMAL;
+    
+    ThreadPool& pool = app.thread_pool();
+    RuntimeSettingsPtr settings = app.settings();
+    const AdmissionConfig& admission = settings->admission;
+    
+    // Commands are cheap and bypass the soft limits (only the hard capacity applies)
+    if (priority == TaskPriority::NORMAL) {
+        size_t depth = pool.pending();
+        int64_t wait_ms = pool.estimated_wait_ms(TaskPriority::NORMAL);
+        bool overloaded = (admission.max_queue > 0 && depth >= admission.max_queue) ||
+                          (admission.max_wait_ms > 0 && wait_ms >= admission.max_wait_ms);
+        
+        if (overloaded) {
+            int retry_seconds = wait_ms > 0
+                ? static_cast<int>((wait_ms + 999) / 1000)
+                : admission.retry_hint_seconds;
+            
+            if (admission.policy == AdmissionConfig::COALESCE && !command &&
+                coalesce_into_queued(session_key, msg)) {
+                LOG_INFO("[Admission] Coalesced message from %s into queued turn (depth %zu)",
+                         msg.from.c_str(), depth);
+                return;
+            }
+            
+            LOG_WARN("[Admission] Overloaded (depth %zu, est. wait %lldms) - %s message from %s",
+                     depth, static_cast<long long>(wait_ms),
+                     admission.policy == AdmissionConfig::REJECT ? "rejecting" : "deferring",
+                     msg.from.c_str());
+            if (admission.policy != AdmissionConfig::REJECT) {
+                send_busy_reply(msg, retry_seconds);
+            }
+            return;
+        }
+    }
+    
+    // Shared so a later message can be coalesced into it while queued
+    std::shared_ptr<Message> queued(new Message(msg));
+    bool track = (priority == TaskPriority::NORMAL && !command);
+    if (track) {
+        std::lock_guard<std::mutex> lock(g_queued_mutex);
+        g_queued_messages[session_key] = queued;
+    }
+    
+    int64_t queued_at = AgentTrace::clock_us();
+    bool accepted = pool.try_enqueue_serial_async(session_key,
+        [queued, session_key, track, queued_at](StrandDone done) {
+            // Snapshot under the lock; coalescing may still be appending
+            Message current;
+            {
+                std::lock_guard<std::mutex> lock(g_queued_mutex);
+                if (track) forget_queued_locked(session_key, queued);
+                current = *queued;
+            }
+            // The strand is released when processing completes, not on return
+            process_message(std::move(current), done, queued_at);
+        }, priority);
+    
+    if (!accepted) {
+        if (track) {
+            std::lock_guard<std::mutex> lock(g_queued_mutex);
+            forget_queued_locked(session_key, queued);
+        }
+        LOG_WARN("[Admission] Queue full (capacity %zu) - dropping message from %s",
+                 pool.capacity(), msg.from.c_str());
+        if (admission.policy != AdmissionConfig::REJECT) {
+            send_busy_reply(msg, admission.retry_hint_seconds);
+        }
+    }
 }
 
+} // anonymous namespace
+
 // ============================================================================
 // Internal Helpers
 // ============================================================================
@@ -106,12 +644,6 @@ std::string handle_command(
 {
     auto& app = Application::instance();
     
-    // Check if this is a skill command
-    std::string response;
-    if (handle_skill_command(msg, session, cmd_text, response)) {
-        return response;
-    }
-    
     // Parse command and arguments
     std::string command, args;
     auto space_pos = cmd_text.find(' ');
@@ -139,12 +671,12 @@ bool handle_skill_command(
     const Message& msg,
     Session& session,
     const std::string& cmd_text,
-    std::string& response_out)
+    std::function<void(const std::string&)> on_response)
 {
     auto& app = Application::instance();
     
     // Check if this is a skill command
-    auto skill_cmd = app.skills().resolve_skill_command_invocation(cmd_text, app.skill_commands());
+    auto skill_cmd = app.skills().resolve_skill_command_invocation(cmd_text, app.skill_command_table());
     
     LOG_DEBUG("[Skills] Skill command resolution result: %s", 
               skill_cmd.first ? "MATCHED" : "NO MATCH");
@@ -161,8 +693,8 @@ bool handle_skill_command(
     
     if (!spec->dispatch.empty() && spec->dispatch.kind == "tool") {
         // Direct tool dispatch - not implemented yet
-        response_out = "⚠️ Direct tool dispatch not yet implemented for skill '" + spec->skill_name + "'";
         LOG_WARN("Direct tool dispatch requested but not implemented");
+        on_response("⚠️ Direct tool dispatch not yet implemented for skill '" + spec->skill_name + "'");
         return true;
     }
     
@@ -174,8 +706,8 @@ bool handle_skill_command(
     LOG_DEBUG("[Skills] Skill entry lookup: %s", entry ? "FOUND" : "NOT FOUND");
     
     if (!entry) {
-        response_out = "⚠️ Skill '" + spec->skill_name + "' not found in loaded entries";
         LOG_WARN("Skill command matched but skill entry not found: %s", spec->skill_name.c_str());
+        on_response("⚠️ Skill '" + spec->skill_name + "' not found in loaded entries");
         return true;
     }
     
@@ -187,7 +719,7 @@ bool handle_skill_command(
     rewritten += skill_args;
     
     LOG_DEBUG("[Skills] Rewritten prompt: %s", rewritten.c_str());
-    LOG_DEBUG("[Skills] System prompt size: %zu chars", app.system_prompt().size());
+    LOG_DEBUG("[Skills] System prompt size: %zu chars", app.system_prompt()->size());
     
     // Route to AI
     auto* ai = app.registry().get_default_ai();
@@ -195,8 +727,8 @@ bool handle_skill_command(
               ai ? (ai->is_configured() ? "READY" : "NOT CONFIGURED") : "NULL");
     
     if (!ai || !ai->is_configured()) {
-        response_out = "⚠️ AI not configured for skill execution. Check your config.json.";
         LOG_WARN("Cannot execute skill - AI not configured");
+        on_response("⚠️ AI not configured for skill execution. Check your config.json.");
         return true;
     }
     
@@ -210,43 +742,65 @@ bool handle_skill_command(
     
     AgentConfig agent_config;
     agent_config.max_iterations = 15;
+    agent_config.session_key = session.key();
     
-    auto agent_result = app.agent().run(
+    // Like AI messages: each step resumes on a pool worker, and the session
+    // strand stays held until on_response has run
+    AgentExecutor executor = [](std::function<void()> fn) {
+        Application::instance().thread_pool().enqueue(fn, TaskPriority::NORMAL);
+    };
+    std::string to = msg.to;
+    Session* session_ptr = &session;
+    
+    app.agent().run_async(
         ai, 
         rewritten, 
         session.history(), 
         app.system_prompt(),
-        agent_config
+        agent_config,
+        [to, monitor_session_id, on_response, session_ptr](const AgentResult& agent_result) {
+            auto& app = Application::instance();
+            
+            LOG_DEBUG("[Skills] Agent loop completed: success=%s, iterations=%d, tool_calls=%d",
+                      agent_result.success ? "yes" : "no", 
+                      agent_result.iterations, 
+                      agent_result.tool_calls_made);
+            
+            std::string response;
+            if (agent_result.success) {
+                response = agent_result.final_response;
+                LOG_INFO("Skill executed via %d tool calls", agent_result.tool_calls_made);
+            } else {
+                response = "❌ Skill execution failed: " + agent_result.error;
+                LOG_ERROR("Skill execution failed: %s", agent_result.error.c_str());
+            }
+            
+            app.typing().stop_typing(to);
+            app.ai_monitor().end_session(monitor_session_id);
+            
+            // Still on the session strand: the history is ours to read
+            app.sessions().persist(*session_ptr);
+            on_response(response);
+        },
+        executor
     );
-    
-    LOG_DEBUG("[Skills] Agent loop completed: success=%s, iterations=%d, tool_calls=%d",
-              agent_result.success ? "yes" : "no", 
-              agent_result.iterations, 
-              agent_result.tool_calls_made);
-    
-    if (agent_result.success) {
-        response_out = agent_result.final_response;
-        LOG_INFO("Skill executed via %d tool calls", agent_result.tool_calls_made);
-    } else {
-        response_out = "❌ Skill execution failed: " + agent_result.error;
-        LOG_ERROR("Skill execution failed: %s", agent_result.error.c_str());
-    }
-    
-    app.typing().stop_typing(msg.to);
-    app.ai_monitor().end_session(monitor_session_id);
     return true;
 }
 
-std::string handle_ai_message(
+void handle_ai_message(
     const Message& msg,
-    Session& session)
+    Session& session,
+    std::function<void(const std::string&)> on_response,
+    int64_t queued_at_us,
+    const std::string& recalled)
 {
     auto& app = Application::instance();
     
     auto* ai = app.registry().get_default_ai();
     if (!ai || !ai->is_configured()) {
-        return "🤖 AI not configured. Set claude.api_key in config.json to enable Claude.\n"
-               "Type /help for available commands.";
+        on_response("🤖 AI not configured. Set claude.api_key in config.json to enable Claude.\n"
+                    "Type /help for available commands.");
+        return;
     }
     
     // Start AI monitoring session
@@ -256,113 +810,177 @@ std::string handle_ai_message(
     // Start typing indicator
     app.typing().start_typing(msg.to);
     
+    // A summary finished since the last turn replaces the oldest messages
+    app.compactor().apply_pending(session);
+    
     LOG_DEBUG("[AI] === Processing user message via agentic loop ===");
     LOG_DEBUG("[AI] User: %s", msg.from_name.c_str());
     LOG_DEBUG("[AI] Message: %s", msg.text.c_str());
     LOG_DEBUG("[AI] Session history size: %zu messages", session.history().size());
-    LOG_DEBUG("[AI] System prompt length: %zu chars", app.system_prompt().size());
+    LOG_DEBUG("[AI] System prompt length: %zu chars", app.system_prompt()->size());
     LOG_DEBUG("[AI] Registered tools: %zu", app.agent().tools().size());
     
     // Run agentic loop with heartbeat callbacks
     AgentConfig agent_config;
     agent_config.max_iterations = 15;
+    agent_config.session_key = session.key();
     agent_config.max_consecutive_errors = 3;
+    agent_config.queued_at_us = queued_at_us;
+    agent_config.recalled = recalled;
+    if (!recalled.empty()) {
+        LOG_DEBUG("[AI] Injecting %zu chars of recalled memory", recalled.size());
+    }
     
-    // Add heartbeat callback to agent config (if AgentConfig supports it)
-    // For now, we'll send heartbeats periodically from a wrapper
+    // Every streamed delta is a heartbeat; channels that render partial
+    // replies get the deltas in order on a per-chat strand
+    ChannelPlugin* channel = app.registry().get_channel(msg.channel);
+    ChannelCapabilities caps = channel ? channel->capabilities() : ChannelCapabilities();
+    bool forward_deltas = caps.supports_streaming;
     
-    auto agent_result = app.agent().run(
-        ai, 
-        msg.text, 
-        session.history(), 
-        app.system_prompt(),
-        agent_config
-    );
+    // Otherwise channels that can edit show the reply as it grows
+    ReplyStreamerPtr streamer;
+    if (channel && !forward_deltas && caps.supports_edit && app.settings()->routing.stream_edits) {
+        streamer = std::make_shared<ReplyStreamer>(channel, msg.to, msg.id);
+        std::lock_guard<std::mutex> lock(g_streamers_mutex);
+        g_streamers[streamer_key(msg)] = streamer;
+    }
+    std::string channel_id = msg.channel;
+    std::string to = msg.to;
+    std::string delta_key = "delta:" + monitor_session_id;
     
-    LOG_DEBUG("[AI] === Agent loop complete ===");
-    LOG_DEBUG("[AI] Success: %s", agent_result.success ? "yes" : "no");
-    LOG_DEBUG("[AI] Iterations: %d", agent_result.iterations);
-    LOG_DEBUG("[AI] Tool calls: %d", agent_result.tool_calls_made);
-    LOG_DEBUG("[AI] Response length: %zu chars", agent_result.final_response.size());
+    // Plugins (the gateway) follow the turn by the triggering message's id
+    TurnEvent turn_event;
+    turn_event.request_id = msg.id;
+    turn_event.channel = msg.channel;
+    turn_event.chat_id = msg.to;
     
-    std::string response;
-    if (agent_result.success) {
-        response = agent_result.final_response;
+    agent_config.on_delta = [monitor_session_id, forward_deltas, channel_id, to, delta_key, turn_event, streamer](
+            const std::string& chunk) {
+        auto& app = Application::instance();
+        app.ai_monitor().heartbeat(monitor_session_id);
         
-        // Log tools used
-        if (!agent_result.tools_used.empty()) {
-            std::ostringstream tools_str;
-            for (size_t i = 0; i < agent_result.tools_used.size(); ++i) {
-                if (i > 0) tools_str << ", ";
-                tools_str << agent_result.tools_used[i];
-            }
-            LOG_INFO("[AI] Tools used: %s", tools_str.str().c_str());
-        }
-    } else {
-        response = "❌ Agent error: " + agent_result.error;
-    }
+        TurnEvent event = turn_event;
+        event.text = chunk;
+        notify_turn_event(event);
+        
+        if (streamer) streamer->on_delta(chunk);
+        if (!forward_deltas) return;
+        app.thread_pool().enqueue_serial(delta_key, [channel_id, to, chunk] {
+            auto* ch = Application::instance().registry().get_channel(channel_id);
+            if (ch) ch->send_stream_delta(to, chunk);
+        }, TaskPriority::HIGH);
+    };
+    agent_config.on_tool = [turn_event](const std::string& tool, const AgentToolResult* result) {
+        TurnEvent event = turn_event;
+        event.kind = result ? TurnEvent::TOOL_FINISH : TurnEvent::TOOL_START;
+        event.text = tool;
+        event.success = result && result->success;
+        notify_turn_event(event);
+    };
     
-    // Stop typing and end monitoring session
-    app.typing().stop_typing(msg.to);
-    app.ai_monitor().end_session(monitor_session_id);
+    // Each step resumes on a pool worker; no worker waits on the network.
+    // The session strand stays held until on_response has run.
+    AgentExecutor executor = [](std::function<void()> fn) {
+        Application::instance().thread_pool().enqueue(fn, TaskPriority::NORMAL);
+    };
+    std::string session_key = session.key();
+    Session* session_ptr = &session;
     
-    return response;
+    app.agent().run_async(
+        ai, 
+        msg.text, 
+        session.history(), 
+        app.system_prompt(),
+        agent_config,
+        [to, monitor_session_id, on_response, ai, session_key, session_ptr, turn_event](
+                const AgentResult& agent_result) {
+            auto& app = Application::instance();
+            
+            LOG_DEBUG("[AI] === Agent loop complete ===");
+            LOG_DEBUG("[AI] Success: %s", agent_result.success ? "yes" : "no");
+            LOG_DEBUG("[AI] Iterations: %d", agent_result.iterations);
+            LOG_DEBUG("[AI] Tool calls: %d", agent_result.tool_calls_made);
+            LOG_DEBUG("[AI] Response length: %zu chars", agent_result.final_response.size());
+            app.tracer().export_trace(agent_result.trace, session_key);
+            record_stage_latency(agent_result.trace);
+
+            std::string response;
+            if (agent_result.success) {
+                response = agent_result.final_response;
+                
+                // Log tools used
+                if (!agent_result.tools_used.empty()) {
+                    std::ostringstream tools_str;
+                    for (size_t i = 0; i < agent_result.tools_used.size(); ++i) {
+                        if (i > 0) tools_str << ", ";
+                        tools_str << agent_result.tools_used[i];
+                    }
+                    LOG_INFO("[AI] Tools used: %s", tools_str.str().c_str());
+                }
+            } else {
+                response = "❌ Agent error: " + agent_result.error;
+            }
+            
+            TurnEvent done = turn_event;
+            done.kind = TurnEvent::DONE;
+            done.text = response;
+            done.success = agent_result.success;
+            notify_turn_event(done);
+            
+            // Stop typing and end monitoring session
+            app.typing().stop_typing(to);
+            app.ai_monitor().end_session(monitor_session_id);
+            
+            // Still on the session strand: the history is ours to read
+            app.sessions().persist(*session_ptr);
+            if (agent_result.success) {
+                app.compactor().maybe_compact(*session_ptr, ai);
+            }
+            
+            on_response(response);
+        },
+        executor
+    );
 }
 
 void send_response(
     const Message& original_msg,
     const std::string& response)
 {
+    ReplyStreamerPtr streamer = take_streamer(original_msg);
     if (response.empty()) {
         return;
     }
     
     auto& app = Application::instance();
     
-    // Route message to ALL registered channels
-    const auto& channels = app.registry().channels();
+    // Split into chunks if needed
+    auto chunks = split_message_chunks(response, reply_chunk_chars);
     
-    if (channels.empty()) {
-        LOG_ERROR("No channels registered");
-        return;
+    // Reply where the message came from (already on screen if streamed)
+    ChannelPlugin* origin = app.registry().get_channel(original_msg.channel);
+    if (streamer && streamer->finish(chunks)) {
+        // The streamer edits and sends the rest
+    } else if (origin) {
+        deliver_chunks(origin, original_msg.to, original_msg.id, chunks);
+    } else {
+        LOG_ERROR("No channel '%s' to reply on", original_msg.channel.c_str());
     }
     
-    // Split into chunks if needed
-    auto chunks = split_message_chunks(response, 3500);
-    
-    for (auto* channel : channels) {
-        if (!channel) continue;
-        
-        std::string channel_id = channel->channel_id();
+    // Copies for broadcast targets (not as replies: the ID is foreign there)
+    RuntimeSettingsPtr settings = app.settings();
+    const std::vector<RoutingConfig::Target>& broadcast = settings->routing.broadcast;
+    for (size_t i = 0; i < broadcast.size(); ++i) {
+        const RoutingConfig::Target& target = broadcast[i];
+        std::string to = target.to.empty() ? original_msg.to : target.to;
+        if (target.channel == original_msg.channel && to == original_msg.to) continue;
         
-        for (size_t i = 0; i < chunks.size(); ++i) {
-            const auto& chunk = chunks[i];
-            if (chunk.empty()) {
-                continue;
-            }
-
-            SendResult result;
-            if (i == 0) {
-                // Reply to original message on first chunk
-                result = channel->send_message(original_msg.to, chunk, original_msg.id);
-            } else {
-                result = channel->send_message(original_msg.to, chunk);
-            }
-
-            if (result.success) {
-                LOG_DEBUG("[MessageHandler] Message sent to %s: %s", channel_id.c_str(), result.message_id.c_str());
-                notify_outgoing_message(channel_id, original_msg.to, chunk, original_msg.id);
-            } else {
-                LOG_ERROR("Failed to send response to %s: %s", channel_id.c_str(), result.error.c_str());
-                
-                // Check thread pool status
-                auto pending = app.thread_pool().pending();
-                if (pending > 4) {
-                    LOG_WARN("Thread pool has %zu pending tasks - system may be overloaded", pending);
-                }
-                break;
-            }
+        ChannelPlugin* channel = app.registry().get_channel(target.channel);
+        if (!channel) {
+            LOG_WARN("Broadcast channel '%s' is not loaded", target.channel.c_str());
+            continue;
         }
+        deliver_chunks(channel, to, "", chunks);
     }
 }
 
@@ -372,48 +990,75 @@ void send_response(
 // Main Message Processor
 // ============================================================================
 
-void process_message(const Message& msg) {
+void process_message(Message msg, std::function<void()> on_done, int64_t queued_at_us) {
     auto& app = Application::instance();
+    LogContext log_context(msg.channel + ":" + msg.to, msg.id);
     
     LOG_DEBUG("[AI] Processing message from %s: %s", msg.from_name.c_str(), msg.text.c_str());
     
     auto* channel = app.registry().get_channel(msg.channel);
     if (!channel || msg.text.empty()) {
+        if (on_done) on_done();
         return;
     }
     
-    // Get session
-    auto& session = app.sessions().get_session_for_message(msg);
+    // Memory recall runs on another worker while the session loads
+    RecallPtr recall = start_recall(msg.text);
+    
+    // Another node may have run a turn of this session while this one was
+    // unreachable (cluster fallback): read its log afresh before this turn
+    if (app.cluster().enabled()) {
+        std::string key = app.sessions().session_key_for_message(msg);
+        if (app.session_store().changed_elsewhere(key)) {
+            LOG_INFO("[Cluster] Session %s changed on another node; reloading it", key.c_str());
+            app.sessions().remove_session(key);
+            app.session_store().release(key);
+        }
+    }
+    
+    // Locked until we return; all messages of a session share one strand,
+    // so this never waits on another turn of the same session
+    SessionHandle session = app.sessions().get_session_for_message(msg);
     
     std::string response;
     
     // Handle commands (start with /)
     if (msg.text[0] == '/') {
-        // Parse command text (handle @botname suffix)
-        std::string cmd_text = msg.text;
+        std::string cmd_text = command_text(msg.text);
         
-        auto at_pos = cmd_text.find('@');
-        if (at_pos != std::string::npos) {
-            auto space_pos = cmd_text.find(' ');
-            if (space_pos == std::string::npos || at_pos < space_pos) {
-                cmd_text = cmd_text.substr(0, at_pos) + 
-                          (space_pos != std::string::npos ? cmd_text.substr(space_pos) : "");
-            }
+        // Skill commands are agent turns: like AI messages they finish
+        // asynchronously, holding the strand until the reply is sent
+        std::shared_ptr<const Message> original = std::make_shared<const Message>(msg);
+        SessionPtr keep_alive = session.ptr();
+        if (detail::handle_skill_command(*original, *session, cmd_text,
+                [original, on_done, keep_alive](const std::string& skill_response) {
+                    detail::send_response(*original, skill_response);
+                    if (on_done) on_done();
+                })) {
+            return;
         }
         
-        response = detail::handle_command(msg, session, cmd_text);
+        response = detail::handle_command(msg, *session, cmd_text);
+        app.sessions().persist(*session);
         
         // Unknown command - don't respond
-        if (response.empty()) {
-            return;
+        if (!response.empty()) {
+            detail::send_response(msg, response);
         }
-    } else {
-        // Regular message - route to AI
-        response = detail::handle_ai_message(msg, session);
+        if (on_done) on_done();
+        return;
     }
     
-    // Send response
-    detail::send_response(msg, response);
+    // Regular message - route to AI. The reply arrives asynchronously; the
+    // strand (not the session lock) keeps the turn exclusive from here on,
+    // and the captured pointer keeps the session alive until the reply.
+    // The message moves into one shared copy the reply callback holds on to.
+    std::shared_ptr<const Message> original = std::make_shared<const Message>(std::move(msg));
+    SessionPtr keep_alive = session.ptr();
+    detail::handle_ai_message(*original, *session, [original, on_done, keep_alive](const std::string& ai_response) {
+        detail::send_response(*original, ai_response);
+        if (on_done) on_done();
+    }, queued_at_us, await_recall(recall));
 }
 
 } // namespace openclaw
@@ -0,0 +1,444 @@
+/*
+ * OpenClaw C++11 - Runtime Metrics Implementation
+ */
+#include <openclaw/core/metrics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace openclaw {
+
+namespace {
+
+// Spreads threads over the shards: each thread takes the next index once
+size_t shard_index() {
+    static std::atomic<size_t> next(0);
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return index;
+}
+
+std::string escape_label(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        char c = value[i];
+        if (c == '\\') out += "\\\\";
+        else if (c == '"') out += "\\\"";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+std::string render_labels(const std::vector<std::string>& names, const std::vector<std::string>& values) {
+    if (names.empty()) return std::string();
+    std::string out = "{";
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (i > 0) out += ",";
+        out += names[i] + "=\"" + escape_label(i < values.size() ? values[i] : std::string()) + "\"";
+    }
+    out += "}";
+    return out;
+}
+
+std::string format_number(double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.17g", value);
+    return buf;
+}
+
+std::string format_bound(double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%g", value);
+    return buf;
+}
+
+// Adds le="..." to a rendered label set
+std::string with_le(const std::string& labels, const std::string& le) {
+    if (labels.empty()) return "{le=\"" + le + "\"}";
+    return labels.substr(0, labels.size() - 1) + ",le=\"" + le + "\"}";
+}
+
+const char* type_name(MetricFamily::Type type) {
+    switch (type) {
+    case MetricFamily::COUNTER: return "counter";
+    case MetricFamily::HISTOGRAM: return "histogram";
+    default: return "gauge";
+    }
+}
+
+}
+
+// ============================================================================
+// Counter / Histogram
+// ============================================================================
+
+void Counter::inc(uint64_t n) {
+    cells_[shard_index()].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < METRIC_SHARDS; ++i) {
+        total += cells_[i].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Histogram(const std::vector<double>& bounds)
+    : bounds_(bounds) {
+    std::sort(bounds_.begin(), bounds_.end());
+    size_t per_line = 64 / sizeof(std::atomic<uint64_t>);
+    stride_ = (bounds_.size() + 2 + per_line - 1) / per_line * per_line;
+    values_ = new std::atomic<uint64_t>[METRIC_SHARDS * stride_];
+    for (size_t i = 0; i < METRIC_SHARDS * stride_; ++i) {
+        values_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+Histogram::~Histogram() {
+    delete[] values_;
+}
+
+void Histogram::observe(double value) {
+    size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    std::atomic<uint64_t>* shard = values_ + shard_index() * stride_;
+    shard[bucket].fetch_add(1, std::memory_order_relaxed);
+    if (value > 0) {
+        shard[bounds_.size() + 1].fetch_add(static_cast<uint64_t>(value * 1e6 + 0.5),
+                                            std::memory_order_relaxed);
+    }
+}
+
+void Histogram::snapshot(std::vector<uint64_t>& cumulative, double& sum) const {
+    cumulative.assign(bounds_.size() + 1, 0);
+    uint64_t sum_millionths = 0;
+    for (size_t s = 0; s < METRIC_SHARDS; ++s) {
+        const std::atomic<uint64_t>* shard = values_ + s * stride_;
+        for (size_t b = 0; b <= bounds_.size(); ++b) {
+            cumulative[b] += shard[b].load(std::memory_order_relaxed);
+        }
+        sum_millionths += shard[bounds_.size() + 1].load(std::memory_order_relaxed);
+    }
+    for (size_t b = 1; b < cumulative.size(); ++b) {
+        cumulative[b] += cumulative[b - 1];
+    }
+    sum = static_cast<double>(sum_millionths) / 1e6;
+}
+
+// ============================================================================
+// MetricFamily
+// ============================================================================
+
+MetricFamily::MetricFamily(const std::string& name, const std::string& help, Type type,
+                           const std::vector<std::string>& label_names)
+    : name_(name)
+    , help_(help)
+    , type_(type)
+    , label_names_(label_names)
+    , size_(0)
+    , overflow_(nullptr) {
+    if (label_names_.size() > 3) label_names_.resize(3);
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        slots_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+MetricFamily::~MetricFamily() {
+    // Families live as long as the process (see Metrics::instance)
+}
+
+void* MetricFamily::find(const std::string& a, const std::string& b, const std::string& c) {
+    const std::string* values[3] = { &a, &b, &c };
+    size_t n = label_names_.size();
+
+    size_t hash = 0;
+    std::hash<std::string> hasher;
+    for (size_t i = 0; i < n; ++i) {
+        hash = hash * 31 + hasher(*values[i]);
+    }
+
+    // Series are never removed, so an empty slot ends the probe
+    for (size_t probe = 0; probe < CAPACITY; ++probe) {
+        Series* series = slots_[(hash + probe) % CAPACITY].load(std::memory_order_acquire);
+        if (!series) break;
+        bool match = true;
+        for (size_t i = 0; i < n && match; ++i) {
+            match = series->labels[i] == *values[i];
+        }
+        if (match) return series->metric;
+    }
+
+    std::vector<std::string> labels;
+    for (size_t i = 0; i < n; ++i) labels.push_back(*values[i]);
+    return insert(labels, hash)->metric;
+}
+
+MetricFamily::Series* MetricFamily::insert(const std::vector<std::string>& labels, size_t hash) {
+    std::lock_guard<std::mutex> lock(insert_mutex_);
+
+    // Another thread may have added it meanwhile
+    for (size_t probe = 0; probe < CAPACITY; ++probe) {
+        std::atomic<Series*>& slot = slots_[(hash + probe) % CAPACITY];
+        Series* series = slot.load(std::memory_order_acquire);
+        if (series) {
+            if (series->labels == labels) return series;
+            continue;
+        }
+        // Keep probes short: past 3/4 full, new label sets go to "other"
+        if (size_.load(std::memory_order_relaxed) >= CAPACITY * 3 / 4) break;
+
+        series = new Series();
+        series->labels = labels;
+        series->metric = create();
+        slot.store(series, std::memory_order_release);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return series;
+    }
+
+    if (!overflow_) {
+        overflow_ = new Series();
+        overflow_->labels.assign(labels.size(), "other");
+        overflow_->metric = create();
+    }
+    return overflow_;
+}
+
+void MetricFamily::render(std::string& out) const {
+    out += "# HELP " + name_ + " " + help_ + "\n";
+    out += "# TYPE " + name_ + " " + type_name(type_) + "\n";
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        const Series* series = slots_[i].load(std::memory_order_acquire);
+        if (series) render_series(out, render_labels(label_names_, series->labels), series->metric);
+    }
+    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(insert_mutex_));
+    if (overflow_) render_series(out, render_labels(label_names_, overflow_->labels), overflow_->metric);
+}
+
+void* CounterFamily::create() const {
+    return new Counter();
+}
+
+void CounterFamily::render_series(std::string& out, const std::string& labels, const void* metric) const {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%llu",
+             static_cast<unsigned long long>(static_cast<const Counter*>(metric)->value()));
+    out += name_ + labels + " " + buf + "\n";
+}
+
+void* HistogramFamily::create() const {
+    return new Histogram(bounds_);
+}
+
+void HistogramFamily::render_series(std::string& out, const std::string& labels, const void* metric) const {
+    const Histogram* histogram = static_cast<const Histogram*>(metric);
+    std::vector<uint64_t> cumulative;
+    double sum = 0;
+    histogram->snapshot(cumulative, sum);
+
+    char buf[32];
+    const std::vector<double>& bounds = histogram->bounds();
+    for (size_t b = 0; b <= bounds.size(); ++b) {
+        std::string le = b < bounds.size() ? format_bound(bounds[b]) : "+Inf";
+        snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(cumulative[b]));
+        out += name_ + "_bucket" + with_le(labels, le) + " " + buf + "\n";
+    }
+    out += name_ + "_sum" + labels + " " + format_number(sum) + "\n";
+    snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(cumulative.back()));
+    out += name_ + "_count" + labels + " " + buf + "\n";
+}
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+Metrics& Metrics::instance() {
+    // Never destroyed: threads may still record while the process exits
+    static Metrics* metrics = new Metrics();
+    return *metrics;
+}
+
+Metrics::~Metrics() {
+}
+
+std::vector<double> Metrics::latency_buckets() {
+    static const double bounds[] = {
+        0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120
+    };
+    return std::vector<double>(bounds, bounds + sizeof(bounds) / sizeof(bounds[0]));
+}
+
+MetricFamily* Metrics::find_locked(const std::string& name) const {
+    for (size_t i = 0; i < families_.size(); ++i) {
+        if (families_[i]->name() == name) return families_[i];
+    }
+    return nullptr;
+}
+
+CounterFamily& Metrics::counter_family(const std::string& name, const std::string& help,
+                                       const std::vector<std::string>& label_names) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MetricFamily* existing = find_locked(name);
+    if (existing && existing->type() == MetricFamily::COUNTER) {
+        return *static_cast<CounterFamily*>(existing);
+    }
+    CounterFamily* family = new CounterFamily(name, help, label_names);
+    families_.push_back(family);
+    return *family;
+}
+
+HistogramFamily& Metrics::histogram_family(const std::string& name, const std::string& help,
+                                           const std::vector<std::string>& label_names,
+                                           const std::vector<double>& bounds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MetricFamily* existing = find_locked(name);
+    if (existing && existing->type() == MetricFamily::HISTOGRAM) {
+        return *static_cast<HistogramFamily*>(existing);
+    }
+    HistogramFamily* family = new HistogramFamily(name, help, label_names, bounds);
+    families_.push_back(family);
+    return *family;
+}
+
+Counter& Metrics::counter(const std::string& name, const std::string& help) {
+    return counter_family(name, help, std::vector<std::string>()).get();
+}
+
+Histogram& Metrics::histogram(const std::string& name, const std::string& help,
+                              const std::vector<double>& bounds) {
+    return histogram_family(name, help, std::vector<std::string>(), bounds).get();
+}
+
+void Metrics::gauge(const std::string& name, const std::string& help, GaugeReader read,
+                    const std::vector<std::string>& label_names,
+                    const std::vector<std::string>& label_values) {
+    Gauge gauge;
+    gauge.name = name;
+    gauge.help = help;
+    gauge.labels = render_labels(label_names, label_values);
+    gauge.read = read;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    gauges_.push_back(gauge);
+}
+
+std::string Metrics::render() const {
+    std::vector<MetricFamily*> families;
+    std::vector<Gauge> gauges;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        families = families_;
+        gauges = gauges_;
+    }
+
+    std::string out;
+    for (size_t i = 0; i < families.size(); ++i) {
+        families[i]->render(out);
+    }
+
+    // Series of one gauge name are grouped under a single HELP/TYPE
+    std::vector<bool> done(gauges.size(), false);
+    for (size_t i = 0; i < gauges.size(); ++i) {
+        if (done[i]) continue;
+        out += "# HELP " + gauges[i].name + " " + gauges[i].help + "\n";
+        out += "# TYPE " + gauges[i].name + " gauge\n";
+        for (size_t j = i; j < gauges.size(); ++j) {
+            if (done[j] || gauges[j].name != gauges[i].name) continue;
+            done[j] = true;
+            out += gauges[j].name + gauges[j].labels + " " + format_number(gauges[j].read()) + "\n";
+        }
+    }
+    return out;
+}
+
+// ============================================================================
+// StageLatency
+// ============================================================================
+
+StageLatency& StageLatency::instance() {
+    static StageLatency latency;
+    return latency;
+}
+
+void StageLatency::enable(size_t max_samples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_samples_ = std::max<size_t>(max_samples, 1);
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void StageLatency::record(const std::string& stage, int64_t us) {
+    if (!enabled()) return;
+    if (us < 0) us = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stage* entry = nullptr;
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        if (stages_[i].name == stage) {
+            entry = &stages_[i];
+            break;
+        }
+    }
+    if (!entry) {
+        stages_.push_back(Stage());
+        entry = &stages_.back();
+        entry->name = stage;
+        entry->count = 0;
+        entry->sum_us = 0;
+        entry->max_us = 0;
+    }
+
+    entry->count++;
+    entry->sum_us += static_cast<double>(us);
+    if (us > entry->max_us) entry->max_us = us;
+
+    // Reservoir sampling (algorithm R) once the stage is full
+    if (entry->samples.size() < max_samples_) {
+        entry->samples.push_back(us);
+        return;
+    }
+    rng_state_ ^= rng_state_ << 13;
+    rng_state_ ^= rng_state_ >> 7;
+    rng_state_ ^= rng_state_ << 17;
+    uint64_t slot = rng_state_ % entry->count;
+    if (slot < entry->samples.size()) entry->samples[slot] = us;
+}
+
+void StageLatency::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_.clear();
+}
+
+std::vector<StageLatency::Summary> StageLatency::summarize() const {
+    std::vector<Stage> stages;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stages = stages_;
+    }
+
+    std::vector<Summary> out;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        std::vector<int64_t>& samples = stages[i].samples;
+        std::sort(samples.begin(), samples.end());
+
+        // Nearest rank: the smallest sample with at least q of them at or below it
+        auto rank = [&samples](double q) -> int64_t {
+            if (samples.empty()) return 0;
+            size_t n = static_cast<size_t>(std::ceil(q * static_cast<double>(samples.size())));
+            return samples[std::min(std::max<size_t>(n, 1), samples.size()) - 1];
+        };
+
+        Summary summary;
+        summary.stage = stages[i].name;
+        summary.count = stages[i].count;
+        summary.mean_us = stages[i].count ? stages[i].sum_us / static_cast<double>(stages[i].count) : 0;
+        summary.p50_us = rank(0.50);
+        summary.p99_us = rank(0.99);
+        summary.p999_us = rank(0.999);
+        summary.max_us = stages[i].max_us;
+        out.push_back(summary);
+    }
+    return out;
+}
+
+} // namespace openclaw
@@ -3,6 +3,14 @@
  */
 #include <openclaw/core/registry.hpp>
 #include <openclaw/core/logger.hpp>
+#include <openclaw/core/thread_pool.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 
 namespace openclaw {
 
@@ -48,14 +56,119 @@ const CommandDef* PluginRegistry::find_command(const std::string& command) const
     return it != commands_.end() ? &it->second : NULL;
 }
 
-bool PluginRegistry::init_all(const Config& cfg) {
-    bool all_ok = true;
+namespace {
+
+int64_t steady_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Shared with the pool tasks, which may still be unwinding after the
+// last one woke init_all()
+struct InitRun {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::vector<size_t> > dependents;
+    std::vector<int> waiting_on;        // Dependencies not initialized yet
+    std::vector<bool> started;
+    std::vector<size_t> ready;          // Startable, in registration order
+    size_t running;
+    size_t done;
+    bool all_ok;
+    
+    InitRun() : running(0), done(0), all_ok(true) {}
+};
+
+} // namespace
+
+bool PluginRegistry::init_all(const Config& cfg, ThreadPool* pool) {
+    size_t n = plugins_.size();
+    std::shared_ptr<InitRun> run = std::make_shared<InitRun>();
+    run->dependents.resize(n);
+    run->waiting_on.assign(n, 0);
+    run->started.assign(n, false);
+    init_stats_.assign(n, PluginInitStats());
+    
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < n; ++i) index[plugins_[i]->name()] = i;
+    for (size_t i = 0; i < n; ++i) {
+        std::vector<std::string> deps = plugins_[i]->dependencies();
+        for (size_t d = 0; d < deps.size(); ++d) {
+            std::map<std::string, size_t>::const_iterator it = index.find(deps[d]);
+            if (it == index.end()) {
+                LOG_WARN("[Registry] %s depends on %s, which is not loaded", plugins_[i]->name(), deps[d].c_str());
+                continue;
+            }
+            if (it->second == i) continue;
+            run->dependents[it->second].push_back(i);
+            run->waiting_on[i]++;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (run->waiting_on[i] == 0) run->ready.push_back(i);
+    }
+    
+    int64_t origin_us = steady_us();
+    std::vector<PluginInitStats>& stats = init_stats_;
+    std::function<void(size_t)> init_one = [run, &cfg, &stats, origin_us, this](size_t i) {
+        int64_t start_us = steady_us();
+        bool ok = plugins_[i]->init(cfg);
+        int64_t end_us = steady_us();
+        
+        std::lock_guard<std::mutex> lock(run->mutex);
+        PluginInitStats& st = stats[i];
+        st.name = plugins_[i]->name();
+        st.start_us = start_us - origin_us;
+        st.duration_us = end_us - start_us;
+        st.ok = ok;
+        if (!ok) run->all_ok = false;
+        for (size_t k = 0; k < run->dependents[i].size(); ++k) {
+            size_t d = run->dependents[i][k];
+            if (--run->waiting_on[d] == 0 && !run->started[d]) run->ready.push_back(d);
+        }
+        std::sort(run->ready.begin(), run->ready.end());
+        run->running--;
+        run->done++;
+        run->cv.notify_all();
+    };
+    
+    std::unique_lock<std::mutex> lock(run->mutex);
+    while (run->done < n) {
+        if (run->ready.empty()) {
+            if (run->running > 0) {
+                run->cv.wait(lock);
+                continue;
+            }
+            // Only a dependency cycle leaves nothing ready and nothing running
+            for (size_t i = 0; i < n; ++i) {
+                if (run->started[i]) continue;
+                LOG_WARN("[Registry] %s is in a dependency cycle; initializing it anyway", plugins_[i]->name());
+                run->waiting_on[i] = 0;
+                run->ready.push_back(i);
+            }
+        }
+        size_t i = run->ready.front();
+        run->ready.erase(run->ready.begin());
+        run->started[i] = true;
+        run->running++;
+        
+        lock.unlock();
+        if (pool) {
+            pool->enqueue([init_one, i] { init_one(i); }, TaskPriority::HIGH);
+        } else {
+            init_one(i);
+        }
+        lock.lock();
+    }
+    return run->all_ok;
+}
+
+void PluginRegistry::reconfigure_all(const Config& cfg) {
     for (size_t i = 0; i < plugins_.size(); ++i) {
-        if (!plugins_[i]->init(cfg)) {
-            all_ok = false;
+        if (plugins_[i]->is_initialized()) {
+            plugins_[i]->reconfigure(cfg);
         }
     }
-    return all_ok;
 }
 
 void PluginRegistry::shutdown_all() {
@@ -107,6 +220,9 @@ ToolResult PluginRegistry::execute_tool(const std::string& tool_id,
 }
 
 AIPlugin* PluginRegistry::get_default_ai() {
+    if (default_ai_ && default_ai_->is_configured()) {
+        return default_ai_;
+    }
     LOG_DEBUG("[Registry] Selecting default AI provider from %zu registered providers", ai_providers_.size());
     for (size_t i = 0; i < ai_providers_.size(); ++i) {
         LOG_DEBUG("[Registry]   Checking: %s (initialized=%d, configured=%d)", 
@@ -0,0 +1,297 @@
+/*
+ * OpenClaw C++11 - Provider Budget Implementation
+ */
+#include <openclaw/core/provider_budget.hpp>
+#include <openclaw/ai/ai.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/logger.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+namespace openclaw {
+
+namespace {
+
+const int64_t minute_ms = 60000;
+const int64_t max_backoff_ms = 64000;
+
+// Rate-limit headers per bucket (requests, input, output, total tokens):
+// Anthropic names first, then the OpenAI-compatible ones
+const char* const limit_headers[][2] = {
+    { "anthropic-ratelimit-requests-limit", "x-ratelimit-limit-requests" },
+    { "anthropic-ratelimit-input-tokens-limit", nullptr },
+    { "anthropic-ratelimit-output-tokens-limit", nullptr },
+    { "anthropic-ratelimit-tokens-limit", "x-ratelimit-limit-tokens" },
+};
+const char* const remaining_headers[][2] = {
+    { "anthropic-ratelimit-requests-remaining", "x-ratelimit-remaining-requests" },
+    { "anthropic-ratelimit-input-tokens-remaining", nullptr },
+    { "anthropic-ratelimit-output-tokens-remaining", nullptr },
+    { "anthropic-ratelimit-tokens-remaining", "x-ratelimit-remaining-tokens" },
+};
+const char* const retry_after_header[2] = { "retry-after", nullptr };
+
+// -1 when neither header was sent or holds a number
+int64_t header_number(const std::map<std::string, std::string>& headers, const char* const names[2]) {
+    for (int i = 0; i < 2; ++i) {
+        if (!names[i]) continue;
+        std::map<std::string, std::string>::const_iterator it = headers.find(names[i]);
+        if (it == headers.end()) continue;
+        char* end = nullptr;
+        long long value = std::strtoll(it->second.c_str(), &end, 10);
+        if (end != it->second.c_str() && value >= 0) return value;
+    }
+    return -1;
+}
+
+}
+
+ProviderBudget::ProviderBudget()
+    : max_wait_ms_(60000)
+    , max_skips_(4)
+    , next_ticket_(1)
+    , wheel_(TimerWheel::instance()) {}
+
+ProviderBudget::~ProviderBudget() {
+    wheel_.cancel_all(this);
+}
+
+void ProviderBudget::refill_locked(Provider& p, int64_t now_ms) {
+    int64_t elapsed = p.refilled_ms > 0 ? now_ms - p.refilled_ms : 0;
+    p.refilled_ms = now_ms;
+    if (elapsed <= 0) return;
+
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        Bucket& b = p.buckets[d];
+        if (b.limit <= 0) continue;
+        b.level = std::min(b.limit, b.level + b.limit * elapsed / minute_ms);
+    }
+}
+
+bool ProviderBudget::fits_locked(const Provider& p, const int64_t* need, int64_t now_ms) const {
+    if (now_ms < p.blocked_until_ms) return false;
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        const Bucket& b = p.buckets[d];
+        // A call larger than the whole limit goes once the bucket is full
+        if (b.limit > 0 && b.level < std::min(static_cast<double>(need[d]), b.limit)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int64_t ProviderBudget::wait_ms_locked(const Provider& p, const int64_t* need, int64_t now_ms) const {
+    int64_t wait = std::max<int64_t>(p.blocked_until_ms - now_ms, 0);
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        const Bucket& b = p.buckets[d];
+        if (b.limit <= 0) continue;
+        double deficit = std::min(static_cast<double>(need[d]), b.limit) - b.level;
+        if (deficit > 0) {
+            wait = std::max(wait, static_cast<int64_t>(std::ceil(deficit * minute_ms / b.limit)));
+        }
+    }
+    return wait;
+}
+
+void ProviderBudget::take_locked(const std::string& name, Provider& p, const Waiter& w) {
+    Reservation& r = reservations_[w.ticket];
+    r.provider = name;
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        p.buckets[d].level -= w.need[d];
+        p.buckets[d].reserved += w.need[d];
+        r.need[d] = w.need[d];
+    }
+}
+
+void ProviderBudget::pump_locked(const std::string& name, Provider& p, int64_t now_ms, Admitted& out) {
+    int64_t max_wait_ms = max_wait_ms_.load(std::memory_order_relaxed);
+    int max_skips = max_skips_.load(std::memory_order_relaxed);
+    while (!p.waiters.empty()) {
+        Waiter& head = p.waiters.front();
+        bool overdue = max_wait_ms > 0 && now_ms - head.since_ms >= max_wait_ms;
+        if (overdue || fits_locked(p, head.need, now_ms)) {
+            if (overdue) {
+                LOG_WARN("[Budget] %s: sending a call after waiting %lld ms for budget",
+                         name.c_str(), static_cast<long long>(now_ms - head.since_ms));
+            }
+            take_locked(name, p, head);
+            out.push_back(std::make_pair(head.admit, head.ticket));
+            p.waiters.pop_front();
+            continue;
+        }
+
+        // The head waits for room; smaller calls that fit now may pass it,
+        // but only so often that it cannot starve
+        if (head.skips >= max_skips) break;
+        bool passed = false;
+        for (size_t i = 1; i < p.waiters.size(); ++i) {
+            if (!fits_locked(p, p.waiters[i].need, now_ms)) continue;
+            head.skips++;
+            take_locked(name, p, p.waiters[i]);
+            out.push_back(std::make_pair(p.waiters[i].admit, p.waiters[i].ticket));
+            p.waiters.erase(p.waiters.begin() + i);
+            passed = true;
+            break;
+        }
+        if (!passed) break;
+    }
+
+    if (p.timer) {
+        wheel_.cancel(p.timer);
+        p.timer = 0;
+    }
+    if (p.waiters.empty()) return;
+
+    const Waiter& head = p.waiters.front();
+    int64_t delay = wait_ms_locked(p, head.need, now_ms);
+    if (max_wait_ms > 0) {
+        delay = std::min(delay, head.since_ms + max_wait_ms - now_ms);
+    }
+    delay = std::max(delay, wheel_.tick_ms());
+    p.timer = wheel_.schedule_in(delay, [this, name] { on_timer(name); }, this);
+}
+
+void ProviderBudget::on_timer(const std::string& name) {
+    Admitted admitted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, Provider>::iterator it = providers_.find(name);
+        if (it == providers_.end()) return;
+        Provider& p = it->second;
+        p.timer = 0;
+        int64_t now = current_timestamp_ms();
+        refill_locked(p, now);
+        pump_locked(name, p, now, admitted);
+    }
+    run(admitted);
+}
+
+void ProviderBudget::run(Admitted& admitted) {
+    for (size_t i = 0; i < admitted.size(); ++i) {
+        admitted[i].first(admitted[i].second);
+    }
+}
+
+void ProviderBudget::acquire(const std::string& provider, int input_tokens, int output_tokens,
+                             AdmitCallback admit) {
+    if (!admit) return;
+
+    Admitted admitted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Provider& p = providers_[provider];
+        int64_t now = current_timestamp_ms();
+        refill_locked(p, now);
+
+        Waiter w;
+        w.ticket = next_ticket_++;
+        w.need[REQUESTS] = 1;
+        w.need[INPUT] = std::max(input_tokens, 0);
+        w.need[OUTPUT] = std::max(output_tokens, 0);
+        w.need[TOKENS] = w.need[INPUT] + w.need[OUTPUT];
+        w.since_ms = now;
+        w.skips = 0;
+        w.admit = admit;
+
+        if (p.waiters.empty() && fits_locked(p, w.need, now)) {
+            take_locked(provider, p, w);
+            admitted.push_back(std::make_pair(admit, w.ticket));
+        } else {
+            LOG_DEBUG("[Budget] %s: queueing a call for ~%lld input tokens (%zu waiting)",
+                      provider.c_str(), static_cast<long long>(w.need[INPUT]), p.waiters.size());
+            p.waiters.push_back(w);
+            pump_locked(provider, p, now, admitted);
+        }
+    }
+    run(admitted);
+}
+
+void ProviderBudget::learn_locked(Provider& p, const CompletionResult& result, int64_t now_ms) {
+    // Header names are matched case-insensitively
+    std::map<std::string, std::string> headers;
+    for (std::map<std::string, std::string>::const_iterator it = result.response_headers.begin();
+         it != result.response_headers.end(); ++it) {
+        headers[to_lower(it->first)] = it->second;
+    }
+
+    for (int d = 0; d < DIMENSIONS; ++d) {
+        Bucket& b = p.buckets[d];
+        int64_t limit = header_number(headers, limit_headers[d]);
+        if (limit > 0) {
+            if (b.limit <= 0) b.level = static_cast<double>(limit) - b.reserved;
+            b.limit = static_cast<double>(limit);
+        }
+        // The provider has not counted calls still in flight yet
+        int64_t remaining = header_number(headers, remaining_headers[d]);
+        if (remaining >= 0 && b.limit > 0) {
+            b.level = std::min(b.limit, static_cast<double>(remaining)) - b.reserved;
+        }
+    }
+
+    if (result.http_status == 429 || result.http_status == 529) {
+        int64_t retry_after = header_number(headers, retry_after_header);
+        int64_t delay = retry_after > 0
+            ? retry_after * 1000
+            : std::min(max_backoff_ms, static_cast<int64_t>(1000) << std::min(p.strikes, 6));
+        p.strikes++;
+        p.blocked_until_ms = std::max(p.blocked_until_ms, now_ms + delay);
+        LOG_WARN("[Budget] Provider throttled (HTTP %ld); holding calls for %lld ms",
+                 result.http_status, static_cast<long long>(delay));
+    } else if (result.success) {
+        p.strikes = 0;
+    }
+}
+
+void ProviderBudget::release(Ticket ticket, const CompletionResult& result) {
+    Admitted admitted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<Ticket, Reservation>::iterator rit = reservations_.find(ticket);
+        if (rit == reservations_.end()) return;
+        std::string name = rit->second.provider;
+        int64_t need[DIMENSIONS];
+        std::copy(rit->second.need, rit->second.need + DIMENSIONS, need);
+        reservations_.erase(rit);
+
+        Provider& p = providers_[name];
+        int64_t now = current_timestamp_ms();
+        refill_locked(p, now);
+
+        // Replace the estimate with what the call used; a call that failed
+        // without usage still counts as a request but spent no tokens
+        int64_t used[DIMENSIONS];
+        used[REQUESTS] = 1;
+        used[INPUT] = result.usage.input_tokens + result.usage.cache_write_tokens;
+        used[OUTPUT] = result.usage.output_tokens;
+        used[TOKENS] = used[INPUT] + used[OUTPUT];
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            Bucket& b = p.buckets[d];
+            b.reserved -= need[d];
+            b.level += need[d] - used[d];
+            if (b.limit > 0) b.level = std::min(b.level, b.limit);
+        }
+
+        learn_locked(p, result, now);
+        pump_locked(name, p, now, admitted);
+    }
+    run(admitted);
+}
+
+int64_t ProviderBudget::blocked_for_ms(const std::string& provider) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, Provider>::const_iterator it = providers_.find(provider);
+    if (it == providers_.end()) return 0;
+    return std::max<int64_t>(it->second.blocked_until_ms - current_timestamp_ms(), 0);
+}
+
+size_t ProviderBudget::waiting() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = 0;
+    for (std::map<std::string, Provider>::const_iterator it = providers_.begin(); it != providers_.end(); ++it) {
+        n += it->second.waiters.size();
+    }
+    return n;
+}
+
+} // namespace openclaw
@@ -1,6 +1,7 @@
 #include <openclaw/core/rate_limiter.hpp>
 #include <openclaw/core/utils.hpp>
 #include <algorithm>
+#include <chrono>
 
 namespace openclaw {
 
@@ -99,95 +100,290 @@ void SlidingWindowLimiter::reset() {
     timestamps_.clear();
 }
 
+// ============ RateLimitPolicy ============
+
+namespace {
+
+const int64_t max_window_count = 0xFFFF;
+
+}
+
+RateLimitPolicy RateLimitPolicy::token_bucket(int limit, int refill_per_second) {
+    RateLimitPolicy p;
+    p.sliding_window = false;
+    p.limit = std::max(1, std::min(limit, static_cast<int>(max_window_count)));
+    p.interval_us = 1000000 / (refill_per_second > 0 ? refill_per_second : 1);
+    p.burst_us = p.interval_us * (p.limit - 1);
+    return p;
+}
+
+RateLimitPolicy RateLimitPolicy::token_bucket_interval(int limit, int64_t refill_interval_us) {
+    RateLimitPolicy p = token_bucket(limit, 1);
+    p.interval_us = refill_interval_us > 0 ? refill_interval_us : 1;
+    p.burst_us = p.interval_us * (p.limit - 1);
+    return p;
+}
+
+RateLimitPolicy RateLimitPolicy::window(int limit, int window_seconds) {
+    RateLimitPolicy p;
+    p.sliding_window = true;
+    p.limit = std::max(1, std::min(limit, static_cast<int>(max_window_count)));
+    p.window_ms = static_cast<int64_t>(window_seconds > 0 ? window_seconds : 1) * 1000;
+    return p;
+}
+
+int64_t RateLimitPolicy::now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t RateLimitPolicy::idle_seconds() const {
+    // A full bucket, or two windows without a request
+    return sliding_window ? (2 * window_ms) / 1000 + 1 : (burst_us + interval_us) / 1000000 + 1;
+}
+
+RateLimitResult RateLimitPolicy::take(std::atomic<int64_t>& state, int n, int64_t now_us) const {
+    int64_t word = state.load();
+    
+    if (!sliding_window) {
+        // Each token pushes the arrival time one refill interval further;
+        // a full bucket is an arrival time at or before now
+        while (true) {
+            int64_t base = std::max(word, now_us);
+            int64_t next = base + n * interval_us;
+            int64_t over = next - now_us - burst_us - interval_us;
+            if (over > 0) {
+                return RateLimitResult::deny((over + 999) / 1000, limit);
+            }
+            if (state.compare_exchange_weak(word, next)) {
+                int64_t used = (next - now_us + interval_us - 1) / interval_us;
+                return RateLimitResult::allow(std::max(0, limit - static_cast<int>(used)), limit);
+            }
+        }
+    }
+    
+    int64_t now_ms = now_us / 1000;
+    int64_t window = now_ms / window_ms;
+    int64_t elapsed = now_ms % window_ms;
+    int64_t window_bits = window & 0xFFFFFFFF;
+    
+    while (true) {
+        int64_t stored_window = static_cast<int64_t>(static_cast<uint64_t>(word) >> 32);
+        int64_t previous = (word >> 16) & max_window_count;
+        int64_t current = word & max_window_count;
+        
+        if (stored_window != window_bits) {
+            previous = (stored_window == ((window - 1) & 0xFFFFFFFF)) ? current : 0;
+            current = 0;
+        }
+        
+        // Part of the previous window still inside the sliding window
+        int64_t estimate = current + previous * (window_ms - elapsed) / window_ms;
+        if (estimate + n > limit) {
+            int64_t wait_ms = window_ms - elapsed;
+            int64_t room = limit - current - (n - 1);
+            if (room > 0 && previous > 0) {
+                // Until the previous window's share drops below the room left
+                int64_t clear_at = window_ms - room * window_ms / previous;
+                wait_ms = clear_at - elapsed + 1;
+            }
+            return RateLimitResult::deny(std::max(wait_ms, static_cast<int64_t>(1)), limit);
+        }
+        
+        int64_t next = static_cast<int64_t>((static_cast<uint64_t>(window_bits) << 32) |
+                                            static_cast<uint64_t>(previous << 16) |
+                                            static_cast<uint64_t>(current + n));
+        if (state.compare_exchange_weak(word, next)) {
+            return RateLimitResult::allow(static_cast<int>(limit - estimate - n), limit);
+        }
+    }
+}
+
 // ============ KeyedRateLimiter ============
 
 KeyedRateLimiter::KeyedRateLimiter(LimiterType type, int limit, int window_or_rate)
-    : type_(type)
-    , limit_(limit)
-    , window_or_rate_(window_or_rate) {}
+    : policy_(type == TOKEN_BUCKET ? RateLimitPolicy::token_bucket(limit, window_or_rate)
+                                   : RateLimitPolicy::window(limit, window_or_rate))
+    , store_(nullptr)
+    , lease_batch_(1)
+    , idle_expiry_(0)
+    , count_(0)
+    , wheel_(TimerWheel::instance()) {}
+
+KeyedRateLimiter::~KeyedRateLimiter() {
+    wheel_.cancel_all(this);
+}
+
+KeyedRateLimiter::Shard& KeyedRateLimiter::shard_for(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % SHARD_COUNT];
+}
+
+KeyedRateLimiter::KeyStatePtr KeyedRateLimiter::acquire(const std::string& key) {
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    KeyStatePtr& slot = shard.keys[key];
+    if (!slot) {
+        slot = std::make_shared<KeyState>();
+        count_++;
+        int64_t idle = idle_expiry_.load();
+        if (idle > 0) arm_expiry_locked(key, *slot, current_timestamp() + idle);
+    }
+    return slot;
+}
 
 RateLimitResult KeyedRateLimiter::check(const std::string& key) {
-    last_activity_[key] = current_timestamp();
-    
-    if (type_ == TOKEN_BUCKET) {
-        std::map<std::string, TokenBucketLimiter>::iterator it = token_limiters_.find(key);
-        if (it == token_limiters_.end()) {
-            token_limiters_.insert(std::make_pair(key, 
-                TokenBucketLimiter(limit_, window_or_rate_)));
-            it = token_limiters_.find(key);
-        }
-        return it->second.try_acquire();
-    } else {
-        std::map<std::string, SlidingWindowLimiter>::iterator it = window_limiters_.find(key);
-        if (it == window_limiters_.end()) {
-            window_limiters_.insert(std::make_pair(key,
-                SlidingWindowLimiter(limit_, window_or_rate_)));
-            it = window_limiters_.find(key);
+    KeyStatePtr state = acquire(key);
+    state->last_seen.store(current_timestamp(), std::memory_order_relaxed);
+    if (store_) {
+        return check_shared(key, *state);
+    }
+    return policy_.take(state->state, 1, RateLimitPolicy::now_us());
+}
+
+RateLimitResult KeyedRateLimiter::check_shared(const std::string& key, KeyState& state) {
+    // Spend a token leased earlier
+    int have = state.leased.load();
+    while (have > 0) {
+        if (state.leased.compare_exchange_weak(have, have - 1)) {
+            return RateLimitResult::allow(have - 1, policy_.limit);
         }
-        return it->second.try_acquire();
     }
+    
+    // Lease a batch; near the limit a whole batch may not fit, one might
+    RateLimitResult result;
+    int granted = store_->lease(store_prefix_ + key, policy_, lease_batch_, result);
+    if (granted == 0 && lease_batch_ > 1) {
+        granted = store_->lease(store_prefix_ + key, policy_, 1, result);
+    }
+    if (granted < 0) {
+        // Store full or unavailable: enforce locally
+        return policy_.take(state.state, 1, RateLimitPolicy::now_us());
+    }
+    if (granted == 0) {
+        return result;
+    }
+    state.leased.fetch_add(granted - 1);
+    return RateLimitResult::allow(granted - 1, policy_.limit);
+}
+
+void KeyedRateLimiter::set_store(RateLimitStore* store, const std::string& prefix, int lease_batch) {
+    store_ = store;
+    store_prefix_ = prefix;
+    lease_batch_ = std::max(1, std::min(lease_batch, policy_.limit));
 }
 
 void KeyedRateLimiter::reset(const std::string& key) {
-    if (type_ == TOKEN_BUCKET) {
-        token_limiters_.erase(key);
-    } else {
-        window_limiters_.erase(key);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::unordered_map<std::string, KeyStatePtr>::iterator it = shard.keys.find(key);
+    if (it != shard.keys.end()) {
+        if (it->second->expiry != 0) wheel_.cancel(it->second->expiry);
+        shard.keys.erase(it);
+        count_--;
     }
-    last_activity_.erase(key);
 }
 
 void KeyedRateLimiter::reset_all() {
-    token_limiters_.clear();
-    window_limiters_.clear();
-    last_activity_.clear();
+    wheel_.cancel_all(this);
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        count_ -= shards_[i].keys.size();
+        shards_[i].keys.clear();
+    }
 }
 
 size_t KeyedRateLimiter::cleanup(int64_t max_age_seconds) {
     int64_t now = current_timestamp();
     size_t removed = 0;
     
-    std::vector<std::string> to_remove;
-    for (std::map<std::string, int64_t>::iterator it = last_activity_.begin();
-         it != last_activity_.end(); ++it) {
-        if (now - it->second > max_age_seconds) {
-            to_remove.push_back(it->first);
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::unordered_map<std::string, KeyStatePtr>::iterator it = shard.keys.begin();
+        while (it != shard.keys.end()) {
+            if (now - it->second->last_seen.load() > max_age_seconds) {
+                if (it->second->expiry != 0) wheel_.cancel(it->second->expiry);
+                it = shard.keys.erase(it);
+                ++removed;
+            } else {
+                ++it;
+            }
         }
     }
     
-    for (size_t i = 0; i < to_remove.size(); ++i) {
-        reset(to_remove[i]);
-        ++removed;
-    }
-    
+    count_ -= removed;
     return removed;
 }
 
-size_t KeyedRateLimiter::key_count() const {
-    if (type_ == TOKEN_BUCKET) {
-        return token_limiters_.size();
-    } else {
-        return window_limiters_.size();
+void KeyedRateLimiter::set_idle_expiry(int64_t max_age_seconds) {
+    idle_expiry_ = max_age_seconds > 0 ? max_age_seconds : 0;
+}
+
+void KeyedRateLimiter::arm_expiry_locked(const std::string& key, KeyState& state, int64_t deadline) {
+    state.expiry = wheel_.schedule_at(deadline * 1000, [this, key] { expire(key); }, this);
+}
+
+void KeyedRateLimiter::expire(const std::string& key) {
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::unordered_map<std::string, KeyStatePtr>::iterator it = shard.keys.find(key);
+    if (it == shard.keys.end()) return;
+    
+    // Seen again since the timer was set: wait out the rest of the new window
+    int64_t idle = idle_expiry_.load();
+    int64_t deadline = it->second->last_seen.load() + idle;
+    if (idle > 0 && deadline > current_timestamp()) {
+        arm_expiry_locked(key, *it->second, deadline);
+        return;
     }
+    shard.keys.erase(it);
+    count_--;
 }
 
 // ============ TypingIndicator ============
 
 TypingIndicator::TypingIndicator()
-    : interval_ms_(5000) {}
+    : interval_ms_(5000)
+    , timeout_ms_(600000)
+    , wheel_(TimerWheel::instance()) {}
+
+TypingIndicator::~TypingIndicator() {
+    wheel_.cancel_all(this);
+}
 
 void TypingIndicator::start_typing(const std::string& chat_id) {
-    is_typing_[chat_id] = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Typing& typing = typing_[chat_id];
+    if (typing.timer != 0) wheel_.cancel(typing.timer);
+    typing.until_ms = current_timestamp_ms() + timeout_ms_;
+    typing.timer = wheel_.schedule_at(typing.until_ms, [this, chat_id] { expire(chat_id); }, this);
 }
 
 void TypingIndicator::stop_typing(const std::string& chat_id) {
-    is_typing_[chat_id] = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, Typing>::iterator it = typing_.find(chat_id);
+    if (it != typing_.end()) {
+        wheel_.cancel(it->second.timer);
+        typing_.erase(it);
+    }
+    last_typing_.erase(chat_id);
+}
+
+void TypingIndicator::expire(const std::string& chat_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, Typing>::iterator it = typing_.find(chat_id);
+    
+    // Restarted while this timer was firing: the newer timer owns it
+    if (it == typing_.end() || it->second.until_ms > current_timestamp_ms()) return;
+    typing_.erase(it);
+    last_typing_.erase(chat_id);
 }
 
 bool TypingIndicator::should_send_typing(const std::string& chat_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
     // Check if typing is active
-    std::map<std::string, bool>::iterator typing_it = is_typing_.find(chat_id);
-    if (typing_it == is_typing_.end() || !typing_it->second) {
+    if (typing_.find(chat_id) == typing_.end()) {
         return false;
     }
     
@@ -204,12 +400,11 @@ bool TypingIndicator::should_send_typing(const std::string& chat_id) {
 }
 
 std::vector<std::string> TypingIndicator::active_chats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<std::string> chats;
-    for (std::map<std::string, bool>::const_iterator it = is_typing_.begin();
-         it != is_typing_.end(); ++it) {
-        if (it->second) {
-            chats.push_back(it->first);
-        }
+    for (std::map<std::string, Typing>::const_iterator it = typing_.begin();
+         it != typing_.end(); ++it) {
+        chats.push_back(it->first);
     }
     return chats;
 }
@@ -283,37 +478,120 @@ std::vector<std::string> HeartbeatManager::unhealthy_targets() const {
 
 // ============ MessageDebouncer ============
 
-MessageDebouncer::MessageDebouncer(int window_seconds)
-    : window_seconds_(window_seconds) {}
+namespace {
 
-bool MessageDebouncer::should_process(const std::string& message_id) {
-    cleanup();
+const size_t bloom_hashes = 4;
+
+}
+
+MessageDebouncer::MessageDebouncer(int window_seconds, size_t exact_capacity, size_t bloom_bits)
+    : window_seconds_(window_seconds)
+    , store_(nullptr)
+    , current_(0) {
+    // Power-of-two sizes so slots and bits are masks; the set stays at
+    // most half full to keep probes short
+    size_t slots = 16;
+    while (slots < exact_capacity * 2) slots <<= 1;
+    size_t words = 64;
+    while (words * 64 < bloom_bits) words <<= 1;
     
-    if (seen_messages_.find(message_id) != seen_messages_.end()) {
-        return false;  // Duplicate
+    int64_t now = current_timestamp();
+    for (size_t i = 0; i < 2; ++i) {
+        generations_[i].started = now;
+        generations_[i].count = 0;
+        generations_[i].overflowed = false;
+        generations_[i].exact.assign(slots, 0);
+        generations_[i].bloom.assign(words, 0);
+    }
+}
+
+uint64_t MessageDebouncer::hash_id(const std::string& message_id) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < message_id.size(); ++i) {
+        h = (h ^ static_cast<unsigned char>(message_id[i])) * 1099511628211ULL;
+    }
+    return h != 0 ? h : 1;
+}
+
+bool MessageDebouncer::contains(const Generation& gen, uint64_t hash) const {
+    size_t mask = gen.exact.size() - 1;
+    for (size_t i = static_cast<size_t>(hash) & mask; gen.exact[i] != 0; i = (i + 1) & mask) {
+        if (gen.exact[i] == hash) return true;
     }
+    if (!gen.overflowed) return false;
     
-    seen_messages_[message_id] = current_timestamp();
+    // Double hashing: k bit positions from the two halves of one hash
+    size_t bits = gen.bloom.size() * 64;
+    uint64_t step = (hash >> 32) | 1;
+    for (size_t k = 0; k < bloom_hashes; ++k) {
+        uint64_t bit = (hash + k * step) & (bits - 1);
+        if (!(gen.bloom[bit / 64] & (static_cast<uint64_t>(1) << (bit % 64)))) return false;
+    }
     return true;
 }
 
-void MessageDebouncer::cleanup() {
-    int64_t now = current_timestamp();
-    int64_t cutoff = now - window_seconds_;
+void MessageDebouncer::insert(Generation& gen, uint64_t hash) {
+    size_t bits = gen.bloom.size() * 64;
+    uint64_t step = (hash >> 32) | 1;
+    for (size_t k = 0; k < bloom_hashes; ++k) {
+        uint64_t bit = (hash + k * step) & (bits - 1);
+        gen.bloom[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+    }
     
-    std::vector<std::string> to_remove;
-    for (std::map<std::string, int64_t>::iterator it = seen_messages_.begin();
-         it != seen_messages_.end(); ++it) {
-        if (it->second < cutoff) {
-            to_remove.push_back(it->first);
-        }
+    if (gen.count * 2 >= gen.exact.size()) {
+        gen.overflowed = true;
+        return;
     }
+    size_t mask = gen.exact.size() - 1;
+    size_t i = static_cast<size_t>(hash) & mask;
+    while (gen.exact[i] != 0) i = (i + 1) & mask;
+    gen.exact[i] = hash;
+    gen.count++;
+}
+
+void MessageDebouncer::rotate_locked(int64_t now) {
+    Generation& current = generations_[current_];
+    if (now - current.started < window_seconds_) return;
     
-    for (size_t i = 0; i < to_remove.size(); ++i) {
-        seen_messages_.erase(to_remove[i]);
+    // The older generation is past the window: reuse it as the current one.
+    // Past two windows both are stale.
+    bool both = now - current.started >= 2 * static_cast<int64_t>(window_seconds_);
+    current_ ^= 1;
+    for (size_t i = 0; i < 2; ++i) {
+        Generation& gen = generations_[i];
+        if (i != current_ && !both) continue;
+        gen.started = now;
+        gen.count = 0;
+        gen.overflowed = false;
+        std::fill(gen.exact.begin(), gen.exact.end(), 0);
+        std::fill(gen.bloom.begin(), gen.bloom.end(), 0);
     }
 }
 
+bool MessageDebouncer::should_process(const std::string& message_id) {
+    uint64_t hash = hash_id(message_id);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    rotate_locked(current_timestamp());
+    
+    if (contains(generations_[current_], hash) || contains(generations_[current_ ^ 1], hash)) {
+        return false;  // Duplicate
+    }
+    
+    // Another process may have taken it; only the store's first caller wins
+    if (store_ && store_->mark_seen(hash, window_seconds_) == 0) {
+        return false;
+    }
+    
+    insert(generations_[current_], hash);
+    return true;
+}
+
+void MessageDebouncer::cleanup() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rotate_locked(current_timestamp());
+}
+
 // ============ Throttler ============
 
 Throttler::Throttler(int min_interval_ms)
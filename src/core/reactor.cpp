@@ -0,0 +1,270 @@
+/*
+ * OpenClaw C++11 - Event Reactor Implementation
+ */
+#include <openclaw/core/reactor.hpp>
+#include <openclaw/core/logger.hpp>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+namespace openclaw {
+
+namespace {
+
+// Events taken from the kernel per epoll_wait
+const int max_events = 64;
+
+void to_timespec(int64_t ms, struct timespec& ts) {
+    ts.tv_sec = static_cast<time_t>(ms / 1000);
+    ts.tv_nsec = static_cast<long>((ms % 1000) * 1000000);
+}
+
+template <typename Fn>
+void run_guarded(const Fn& fn) {
+    try {
+        fn();
+    } catch (const std::exception& e) {
+        LOG_ERROR("[Reactor] Callback threw: %s", e.what());
+    }
+}
+
+} // anonymous namespace
+
+Reactor& Reactor::instance() {
+    static Reactor reactor;
+    return reactor;
+}
+
+Reactor::Reactor()
+    : epoll_fd_(epoll_create1(EPOLL_CLOEXEC))
+    , wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , next_id_(1) {
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        LOG_ERROR("[Reactor] Cannot create epoll/eventfd: %s", strerror(errno));
+        return;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;            // Source ids start at 1
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+}
+
+Reactor::~Reactor() {
+    for (std::map<TimerId, int>::iterator it = timers_.begin(); it != timers_.end(); ++it) {
+        if (it->second >= 0) close(it->second);
+    }
+    if (wake_fd_ >= 0) close(wake_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+}
+
+bool Reactor::add_fd(int fd, uint32_t events, FdCallback cb) {
+    SourcePtr source = std::make_shared<Source>();
+    source->fd = fd;
+    source->timer = false;
+    source->repeat = true;
+    source->cancelled = false;
+    source->on_fd = cb;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    source->id = next_id_++;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u64 = source->id;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        LOG_ERROR("[Reactor] Cannot watch fd %d: %s", fd, strerror(errno));
+        return false;
+    }
+    sources_[source->id] = source;
+    fds_[fd] = source->id;
+    return true;
+}
+
+bool Reactor::modify_fd(int fd, uint32_t events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<int, uint64_t>::iterator it = fds_.find(fd);
+    if (it == fds_.end()) return false;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u64 = it->second;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void Reactor::remove_fd(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<int, uint64_t>::iterator it = fds_.find(fd);
+    if (it == fds_.end()) return;
+    std::map<uint64_t, SourcePtr>::iterator source = sources_.find(it->second);
+    if (source != sources_.end()) {
+        source->second->cancelled = true;
+        sources_.erase(source);
+    }
+    fds_.erase(it);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+Reactor::TimerId Reactor::add_timer(int64_t delay_ms, int64_t interval_ms, Callback cb) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("[Reactor] Cannot create timer: %s", strerror(errno));
+        return 0;
+    }
+
+    // An all-zero it_value would disarm the timer
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    to_timespec(delay_ms > 0 ? delay_ms : 0, spec.it_value);
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) spec.it_value.tv_nsec = 1;
+    to_timespec(interval_ms > 0 ? interval_ms : 0, spec.it_interval);
+    timerfd_settime(fd, 0, &spec, nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    SourcePtr source = std::make_shared<Source>();
+    source->id = next_id_++;
+    source->fd = fd;
+    source->timer = true;
+    source->repeat = interval_ms > 0;
+    source->cancelled = false;
+    source->on_timer = cb;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = source->id;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        LOG_ERROR("[Reactor] Cannot watch timer: %s", strerror(errno));
+        close(fd);
+        return 0;
+    }
+    sources_[source->id] = source;
+    timers_[source->id] = fd;
+    return source->id;
+}
+
+bool Reactor::cancel_timer(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<TimerId, int>::iterator it = timers_.find(id);
+    if (it == timers_.end()) return false;
+    int fd = it->second;
+    timers_.erase(it);
+    std::map<uint64_t, SourcePtr>::iterator source = sources_.find(id);
+    if (source != sources_.end()) {
+        source->second->cancelled = true;
+        sources_.erase(source);
+    }
+    if (fd >= 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+    }
+    return true;
+}
+
+void Reactor::post(Callback cb) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        posted_.push_back(cb);
+    }
+    wake();
+}
+
+void Reactor::wake() {
+    uint64_t one = 1;
+    ssize_t n = write(wake_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void Reactor::drain_posted(std::vector<Callback>& out) {
+    out.swap(posted_);
+}
+
+size_t Reactor::run_once(int timeout_ms) {
+    std::vector<Callback> posted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drain_posted(posted);
+    }
+    struct epoll_event events[max_events];
+    int n = posted.empty() ? epoll_wait(epoll_fd_, events, max_events, timeout_ms) : 0;
+    if (n < 0) {
+        if (errno != EINTR) LOG_ERROR("[Reactor] epoll_wait failed: %s", strerror(errno));
+        n = 0;
+    }
+
+    std::vector<std::pair<SourcePtr, uint32_t> > ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < n; ++i) {
+            uint64_t id = events[i].data.u64;
+            if (id == 0) {
+                uint64_t count;
+                ssize_t r = read(wake_fd_, &count, sizeof(count));
+                (void)r;
+                continue;
+            }
+
+            // Removed since epoll_wait returned
+            std::map<uint64_t, SourcePtr>::iterator it = sources_.find(id);
+            if (it == sources_.end()) continue;
+            SourcePtr source = it->second;
+
+            if (source->timer) {
+                int fd = source->fd;
+                uint64_t expirations = 0;
+                if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) continue;
+                // A fired one-shot stays registered (without its timerfd)
+                // until its callback runs, so it can still be cancelled
+                if (!source->repeat) {
+                    timers_[id] = -1;
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+                    close(fd);
+                }
+            }
+            uint32_t mask = events[i].events;
+            ready.push_back(std::make_pair(source, mask));
+        }
+        std::vector<Callback> more;
+        drain_posted(more);
+        posted.insert(posted.end(), more.begin(), more.end());
+    }
+
+    for (size_t i = 0; i < posted.size(); ++i) {
+        run_guarded(posted[i]);
+    }
+    for (size_t i = 0; i < ready.size(); ++i) {
+        const Source& source = *ready[i].first;
+        uint32_t mask = ready[i].second;
+        // An earlier callback of this turn (or another thread) may have
+        // removed it: a cancelled deadline must not fire after the fact
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (source.cancelled) continue;
+            if (source.timer && !source.repeat) {
+                timers_.erase(source.id);
+                sources_.erase(source.id);
+            }
+        }
+        if (source.timer) {
+            if (source.on_timer) run_guarded(source.on_timer);
+        } else if (source.on_fd) {
+            run_guarded([&source, mask] { source.on_fd(mask); });
+        }
+    }
+    return posted.size() + ready.size();
+}
+
+size_t Reactor::fd_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fds_.size();
+}
+
+size_t Reactor::timer_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+} // namespace openclaw
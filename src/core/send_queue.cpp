@@ -0,0 +1,272 @@
+/*
+ * OpenClaw C++11 - Outbound Send Queue Implementation
+ */
+#include <openclaw/core/send_queue.hpp>
+#include <openclaw/core/logger.hpp>
+#include <future>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+namespace openclaw {
+
+namespace {
+
+// Idle chats are looked for at most this often
+const int64_t prune_interval_us = 60 * 1000000LL;
+
+} // anonymous namespace
+
+SendQueue::SendQueue(const std::string& name, Sender sender)
+    : name_(name)
+    , sender_(sender)
+    , global_policy_(RateLimitPolicy::token_bucket(30, 30))
+    , max_attempts_(5)
+    , global_bucket_(0)
+    , next_prune_us_(0)
+    , pending_(0)
+    , in_flight_(0)
+    , stop_(true)
+    , retries_(0) {
+}
+
+SendQueue::~SendQueue() {
+    stop();
+}
+
+void SendQueue::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) return;
+    stop_ = false;
+    thread_ = std::thread(&SendQueue::run, this);
+}
+
+void SendQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    // Fail what never started; a message in flight stays at the head of
+    // its chat until finish() takes it off
+    std::vector<SendCallback> dropped;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (auto& entry : chats_) {
+            Chat& chat = entry.second;
+            size_t keep = chat.in_flight ? 1 : 0;
+            while (chat.queue.size() > keep) {
+                if (chat.queue.back().on_done) dropped.push_back(chat.queue.back().on_done);
+                chat.queue.pop_back();
+                pending_--;
+            }
+        }
+        cv_.wait(lock, [this] { return in_flight_ == 0; });
+        schedule_.clear();
+        chats_.clear();
+    }
+
+    for (size_t i = 0; i < dropped.size(); ++i) {
+        dropped[i](SendResult::fail("Channel stopped"));
+    }
+}
+
+bool SendQueue::push(OutboundMessage& msg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_) return false;
+
+    auto it = chats_.find(msg.to);
+    if (it == chats_.end()) {
+        it = chats_.emplace(std::piecewise_construct, std::forward_as_tuple(msg.to),
+                            std::forward_as_tuple()).first;
+        it->second.policy = chat_policy_ ? chat_policy_(msg.to) : RateLimitPolicy::token_bucket(1, 1);
+    }
+    Chat& chat = it->second;
+
+    // The newest text of a message replaces a queued edit of it; the head
+    // is skipped while in flight
+    if (!msg.edit_id.empty()) {
+        size_t first = chat.in_flight ? 1 : 0;
+        for (size_t i = chat.queue.size(); i > first; --i) {
+            OutboundMessage& queued = chat.queue[i - 1];
+            if (queued.edit_id != msg.edit_id) continue;
+            queued.text = msg.text;
+            SendCallback earlier = queued.on_done;
+            SendCallback later = msg.on_done;
+            if (earlier && later) {
+                queued.on_done = [earlier, later](const SendResult& result) {
+                    earlier(result);
+                    later(result);
+                };
+            } else if (later) {
+                queued.on_done = later;
+            }
+            return true;
+        }
+    }
+
+    chat.queue.push_back(msg);
+    pending_++;
+
+    if (!chat.in_flight) {
+        schedule_locked(msg.to, chat, std::max(chat.due_us, RateLimitPolicy::now_us()));
+    }
+    return true;
+}
+
+void SendQueue::enqueue(const std::string& to, const std::string& text,
+                        const std::string& reply_to, SendCallback on_done) {
+    OutboundMessage msg;
+    msg.to = to;
+    msg.text = text;
+    msg.reply_to = reply_to;
+    msg.on_done = on_done;
+    if (!push(msg)) {
+        if (on_done) on_done(SendResult::fail("Channel stopped"));
+        return;
+    }
+    cv_.notify_all();
+}
+
+void SendQueue::enqueue_edit(const std::string& to, const std::string& message_id,
+                             const std::string& text, SendCallback on_done) {
+    OutboundMessage msg;
+    msg.to = to;
+    msg.text = text;
+    msg.edit_id = message_id;
+    msg.on_done = on_done;
+    if (!push(msg)) {
+        if (on_done) on_done(SendResult::fail("Channel stopped"));
+        return;
+    }
+    cv_.notify_all();
+}
+
+SendResult SendQueue::send(const std::string& to, const std::string& text,
+                           const std::string& reply_to) {
+    std::shared_ptr<std::promise<SendResult> > result = std::make_shared<std::promise<SendResult> >();
+    std::future<SendResult> future = result->get_future();
+    enqueue(to, text, reply_to, [result](const SendResult& r) { result->set_value(r); });
+    return future.get();
+}
+
+size_t SendQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+void SendQueue::schedule_locked(const std::string& to, Chat& chat, int64_t due_us) {
+    if (chat.scheduled) return;
+    chat.scheduled = true;
+    chat.due_us = due_us;
+    schedule_.insert(std::make_pair(due_us, to));
+}
+
+void SendQueue::run() {
+    LOG_DEBUG("[SendQueue] %s: dispatcher started", name_.c_str());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        int64_t now = RateLimitPolicy::now_us();
+        if (now >= next_prune_us_) {
+            prune_locked(now);
+            next_prune_us_ = now + prune_interval_us;
+        }
+
+        if (schedule_.empty()) {
+            cv_.wait_for(lock, std::chrono::microseconds(prune_interval_us));
+            continue;
+        }
+
+        std::multimap<int64_t, std::string>::iterator next = schedule_.begin();
+        if (next->first > now) {
+            cv_.wait_for(lock, std::chrono::microseconds(next->first - now));
+            continue;
+        }
+
+        std::string to = next->second;
+        schedule_.erase(next);
+        Chat& chat = chats_[to];
+        chat.scheduled = false;
+        if (chat.in_flight || chat.queue.empty()) continue;
+
+        // Both buckets must allow the send; try them on copies so that a
+        // denial by one does not use up a token of the other
+        std::atomic<int64_t> chat_probe(chat.bucket.load());
+        std::atomic<int64_t> global_probe(global_bucket_.load());
+        RateLimitResult chat_limit = chat.policy.take(chat_probe, 1, now);
+        RateLimitResult global_limit = global_policy_.take(global_probe, 1, now);
+        if (!chat_limit.allowed || !global_limit.allowed) {
+            int64_t wait_ms = std::max(chat_limit.allowed ? 0 : chat_limit.retry_after_ms,
+                                       global_limit.allowed ? 0 : global_limit.retry_after_ms);
+            schedule_locked(to, chat, now + wait_ms * 1000);
+            continue;
+        }
+        chat.bucket = chat_probe.load();
+        global_bucket_ = global_probe.load();
+
+        chat.in_flight = true;
+        in_flight_++;
+        OutboundMessage& head = chat.queue.front();
+        head.attempts++;
+        OutboundMessage msg = head;
+        msg.on_done = SendCallback();
+
+        lock.unlock();
+        sender_(msg, [this, to](const SendResult& result, int64_t retry_after_ms) {
+            finish(to, result, retry_after_ms);
+        });
+        lock.lock();
+    }
+
+    LOG_DEBUG("[SendQueue] %s: dispatcher stopped", name_.c_str());
+}
+
+void SendQueue::finish(const std::string& to, const SendResult& result, int64_t retry_after_ms) {
+    SendCallback on_done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Chat& chat = chats_[to];
+        chat.in_flight = false;
+        in_flight_--;
+
+        int64_t now = RateLimitPolicy::now_us();
+        OutboundMessage& head = chat.queue.front();
+        if (retry_after_ms > 0 && head.attempts < max_attempts_ && !stop_) {
+            retries_++;
+            chat.due_us = now + retry_after_ms * 1000;
+            LOG_WARN("[SendQueue] %s: rate limited sending to %s, retrying in %lld ms",
+                     name_.c_str(), to.c_str(), (long long)retry_after_ms);
+        } else {
+            on_done = head.on_done;
+            chat.queue.pop_front();
+            pending_--;
+        }
+
+        if (!chat.queue.empty() && !stop_) {
+            schedule_locked(to, chat, std::max(chat.due_us, now));
+        }
+    }
+    cv_.notify_all();
+
+    if (on_done) on_done(result);
+}
+
+void SendQueue::prune_locked(int64_t now_us) {
+    for (auto it = chats_.begin(); it != chats_.end(); ) {
+        const Chat& chat = it->second;
+        if (chat.queue.empty() && !chat.in_flight && !chat.scheduled && chat.bucket.load() <= now_us) {
+            it = chats_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace openclaw
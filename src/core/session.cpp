@@ -181,38 +181,109 @@ void Session::remove_data(const std::string& key) {
 
 // ============ SessionManager ============
 
+// ============ SessionHandle ============
+
+SessionHandle::SessionHandle(const SessionPtr& session)
+    : session_(session) {
+    if (session_) {
+        lock_ = std::unique_lock<std::mutex>(session_->mutex_);
+    }
+}
+
+SessionHandle::SessionHandle(SessionHandle&& other)
+    : session_(std::move(other.session_))
+    , lock_(std::move(other.lock_)) {}
+
+SessionHandle& SessionHandle::operator=(SessionHandle&& other) {
+    if (this != &other) {
+        if (lock_.owns_lock()) lock_.unlock();
+        lock_ = std::move(other.lock_);
+        session_ = std::move(other.session_);
+    }
+    return *this;
+}
+
+void SessionHandle::unlock() {
+    if (lock_.owns_lock()) lock_.unlock();
+}
+
+// ============ SessionManager ============
+
 SessionManager& SessionManager::instance() {
     static SessionManager manager;
     return manager;
 }
 
 SessionManager::SessionManager() 
-    : dm_scope_(DMScope::MAIN)
-    , max_history_(20) {}
-
-Session& SessionManager::get_session(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    std::map<std::string, Session>::iterator it = sessions_.find(key);
-    if (it == sessions_.end()) {
-        Session new_session(key);
-        sessions_[key] = new_session;
-        return sessions_[key];
+    : count_(0)
+    , dm_scope_(DMScope::MAIN)
+    , max_history_(20)
+    , backend_(nullptr)
+    , idle_expiry_(0)
+    , wheel_(TimerWheel::instance()) {}
+
+SessionManager::~SessionManager() {
+    wheel_.cancel_all(this);
+}
+
+SessionManager::Shard& SessionManager::shard_for(const std::string& key) const {
+    return shards_[std::hash<std::string>()(key) % SHARD_COUNT];
+}
+
+SessionHandle SessionManager::get_session(const std::string& key) {
+    SessionHandle handle;
+    SessionPtr session;
+    {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        SessionPtr& slot = shard.sessions[key];
+        if (!slot) {
+            slot = std::make_shared<Session>(key);
+            count_++;
+            // Locked before anyone else can see it (so this never waits):
+            // others block until the history is loaded below
+            handle = SessionHandle(slot);
+            int64_t idle = idle_expiry_.load();
+            if (idle > 0) arm_expiry(key, slot, current_timestamp() + idle);
+        } else {
+            session = slot;
+        }
     }
-    it->second.touch();
-    return it->second;
+    if (handle) {
+        if (backend_) backend_->load(*handle);
+    } else {
+        // The session lock is taken outside the shard lock so a busy session
+        // never stalls lookups of its neighbours
+        handle = SessionHandle(session);
+    }
+    handle->touch();
+    return handle;
+}
+
+void SessionManager::persist(const Session& session) {
+    if (backend_) backend_->persist(session);
+}
+
+SessionPtr SessionManager::find_session(const std::string& key) const {
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::unordered_map<std::string, SessionPtr>::const_iterator it = shard.sessions.find(key);
+    return it != shard.sessions.end() ? it->second : SessionPtr();
 }
 
 bool SessionManager::has_session(const std::string& key) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return sessions_.find(key) != sessions_.end();
+    return find_session(key) != nullptr;
 }
 
 void SessionManager::remove_session(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    sessions_.erase(key);
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.sessions.erase(key) > 0) {
+        count_--;
+    }
 }
 
-Session& SessionManager::get_session_for_message(const Message& msg, const std::string& agent_id) {
+std::string SessionManager::session_key_for_message(const Message& msg, const std::string& agent_id) const {
     // Determine peer kind from message
     PeerKind kind = PeerKind::DM;
     if (msg.chat_type == "group") {
@@ -223,55 +294,100 @@ Session& SessionManager::get_session_for_message(const Message& msg, const std::
     
     RoutePeer peer(kind, msg.to);
     
-    std::string session_key = SessionKey::build(
+    return SessionKey::build(
         agent_id.empty() ? SessionKey::DEFAULT_AGENT_ID : agent_id,
         msg.channel,
         SessionKey::DEFAULT_ACCOUNT_ID,
         &peer,
         dm_scope_
     );
+}
+
+SessionHandle SessionManager::get_session_for_message(const Message& msg, const std::string& agent_id) {
+    std::string session_key = session_key_for_message(msg, agent_id);
     
-    Session& session = get_session(session_key);
-    session.set_channel(msg.channel);
-    session.set_peer_id(msg.from);
-    session.set_agent_id(agent_id.empty() ? SessionKey::DEFAULT_AGENT_ID : agent_id);
+    SessionHandle session = get_session(session_key);
+    session->set_channel(msg.channel);
+    session->set_peer_id(msg.from);
+    session->set_agent_id(agent_id.empty() ? SessionKey::DEFAULT_AGENT_ID : agent_id);
     
     // Apply history limit
-    session.limit_history(max_history_);
+    session->limit_history(max_history_);
     
     return session;
 }
 
 void SessionManager::clear_all() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    sessions_.clear();
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        count_ -= shards_[i].sessions.size();
+        shards_[i].sessions.clear();
+    }
 }
 
 size_t SessionManager::cleanup_inactive(int64_t max_age_seconds) {
-    std::lock_guard<std::mutex> lock(mutex_);
     int64_t now = current_timestamp();
     size_t removed = 0;
     
-    std::map<std::string, Session>::iterator it = sessions_.begin();
-    while (it != sessions_.end()) {
-        if (now - it->second.last_activity() > max_age_seconds) {
-            it = sessions_.erase(it);
-            ++removed;
-        } else {
-            ++it;
+    // One shard at a time; a session someone still holds is in use
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::unordered_map<std::string, SessionPtr>::iterator it = shard.sessions.begin();
+        while (it != shard.sessions.end()) {
+            if (it->second.use_count() == 1 &&
+                now - it->second->last_activity() > max_age_seconds) {
+                it = shard.sessions.erase(it);
+                ++removed;
+            } else {
+                ++it;
+            }
         }
     }
     
+    count_ -= removed;
     return removed;
 }
 
+void SessionManager::arm_expiry(const std::string& key, const SessionPtr& session, int64_t deadline) {
+    std::weak_ptr<Session> weak = session;
+    wheel_.schedule_at(deadline * 1000, [this, key, weak] { expire(key, weak); }, this);
+}
+
+void SessionManager::expire(const std::string& key, const std::weak_ptr<Session>& session) {
+    int64_t idle = idle_expiry_.load();
+    if (idle <= 0) return;
+    
+    Shard& shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::unordered_map<std::string, SessionPtr>::iterator it = shard.sessions.find(key);
+    
+    // Removed (and maybe recreated with its own timer) since this was set
+    if (it == shard.sessions.end() || it->second != session.lock()) return;
+    
+    int64_t now = current_timestamp();
+    int64_t deadline = it->second->last_activity() + idle;
+    if (deadline > now) {
+        arm_expiry(key, it->second, deadline);
+    } else if (it->second.use_count() > 1) {
+        // Idle but held by a turn or handle; look again in a minute
+        arm_expiry(key, it->second, now + 60);
+    } else {
+        shard.sessions.erase(it);
+        count_--;
+    }
+}
+
 std::vector<std::string> SessionManager::session_keys() const {
-    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<std::string> keys;
-    for (std::map<std::string, Session>::const_iterator it = sessions_.begin();
-         it != sessions_.end(); ++it) {
-        keys.push_back(it->first);
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        for (std::unordered_map<std::string, SessionPtr>::const_iterator it = shards_[i].sessions.begin();
+             it != shards_[i].sessions.end(); ++it) {
+            keys.push_back(it->first);
+        }
     }
+    std::sort(keys.begin(), keys.end());
     return keys;
 }
 
@@ -0,0 +1,701 @@
+/*
+ * OpenClaw C++11 - Persistent Session Store Implementation
+ */
+#include <openclaw/core/session_store.hpp>
+#include <openclaw/core/json.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/ai/ai.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+
+namespace openclaw {
+
+namespace {
+
+const uint64_t fnv_offset = 14695981039346656037ULL;
+const uint64_t fnv_prime = 1099511628211ULL;
+
+// Dead bytes tolerated before a log is rewritten to its live history
+const uint64_t rewrite_slack = 1 << 20;
+
+uint64_t fnv1a(uint64_t h, const std::string& s) {
+    for (size_t i = 0; i < s.size(); ++i) {
+        h ^= static_cast<unsigned char>(s[i]);
+        h *= fnv_prime;
+    }
+    // Length terminates the field so ("ab","c") != ("a","bc")
+    h ^= s.size();
+    h *= fnv_prime;
+    return h;
+}
+
+uint64_t message_hash(const ConversationMessage& msg) {
+    uint64_t h = fnv1a(fnv_offset, role_to_string(msg.role));
+    h = fnv1a(h, msg.content);
+    for (size_t i = 0; i < msg.tool_uses.size(); ++i) {
+        h = fnv1a(h, msg.tool_uses[i].id);
+        h = fnv1a(h, msg.tool_uses[i].name);
+        h = fnv1a(h, msg.tool_uses[i].input.dump());
+    }
+    for (size_t i = 0; i < msg.tool_results.size(); ++i) {
+        h = fnv1a(h, msg.tool_results[i].tool_use_id);
+        h = fnv1a(h, msg.tool_results[i].content);
+        h = fnv1a(h, msg.tool_results[i].is_error ? "1" : "0");
+    }
+    return h;
+}
+
+// Invalid UTF-8 from a channel or tool must not make a record unwritable
+std::string to_line(const Json& record) {
+    return record.dump(-1, ' ', false, Json::error_handler_t::replace) + "\n";
+}
+
+// "content" sorts before "tool_results", so the transcript indexer's
+// first-match scan picks up the message text
+std::string message_line(const ConversationMessage& msg, int64_t ts) {
+    Json record;
+    record["role"] = role_to_string(msg.role);
+    record["content"] = msg.content;
+    record["ts"] = ts;
+    if (!msg.tool_uses.empty()) {
+        Json uses = Json::array();
+        for (size_t i = 0; i < msg.tool_uses.size(); ++i) {
+            Json use;
+            use["id"] = msg.tool_uses[i].id;
+            use["name"] = msg.tool_uses[i].name;
+            use["input"] = msg.tool_uses[i].input;
+            uses.push_back(use);
+        }
+        record["tool_uses"] = uses;
+    }
+    if (!msg.tool_results.empty()) {
+        Json results = Json::array();
+        for (size_t i = 0; i < msg.tool_results.size(); ++i) {
+            Json result;
+            result["tool_use_id"] = msg.tool_results[i].tool_use_id;
+            result["content"] = msg.tool_results[i].content;
+            result["is_error"] = msg.tool_results[i].is_error;
+            results.push_back(result);
+        }
+        record["tool_results"] = results;
+    }
+    return to_line(record);
+}
+
+ConversationMessage parse_message(const Json& record) {
+    ConversationMessage msg(string_to_role(record.value("role", "user")),
+                            record.value("content", ""));
+    if (record.contains("tool_uses") && record["tool_uses"].is_array()) {
+        const Json& uses = record["tool_uses"];
+        for (size_t i = 0; i < uses.size(); ++i) {
+            ToolUse use;
+            use.id = uses[i].value("id", "");
+            use.name = uses[i].value("name", "");
+            use.input = uses[i].contains("input") ? uses[i]["input"] : Json::object();
+            msg.tool_uses.push_back(use);
+        }
+    }
+    if (record.contains("tool_results") && record["tool_results"].is_array()) {
+        const Json& results = record["tool_results"];
+        for (size_t i = 0; i < results.size(); ++i) {
+            msg.tool_results.push_back(ToolResultBlock(results[i].value("tool_use_id", ""),
+                                                       results[i].value("content", ""),
+                                                       results[i].value("is_error", false)));
+        }
+    }
+    return msg;
+}
+
+std::string header_line(const std::string& key) {
+    Json header;
+    header["type"] = "session";
+    header["key"] = key;
+    header["v"] = 1;
+    return to_line(header);
+}
+
+std::string drop_line(size_t count) {
+    Json drop;
+    drop["type"] = "drop";
+    drop["count"] = count;
+    return to_line(drop);
+}
+
+std::string reset_line() {
+    Json reset;
+    reset["type"] = "reset";
+    return to_line(reset);
+}
+
+bool write_all(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool ends_with_jsonl(const std::string& name) {
+    return name.size() > 6 && name.compare(name.size() - 6, 6, ".jsonl") == 0;
+}
+
+// Result of replaying one log
+struct Replay {
+    std::vector<ConversationMessage> messages;
+    std::vector<uint32_t> bytes;        // Record size of each message
+    uint64_t live_offset;               // Start of the last reset
+    uint64_t good_end;                  // End of the last complete line
+    size_t corrupt;
+
+    Replay() : live_offset(0), good_end(0), corrupt(0) {}
+};
+
+void replay(const char* data, size_t size, uint64_t offset, Replay& out) {
+    out.live_offset = offset;
+    out.good_end = offset;
+    size_t pos = static_cast<size_t>(offset);
+    while (pos < size) {
+        const char* nl = static_cast<const char*>(memchr(data + pos, '\n', size - pos));
+        if (!nl) break;     // Torn write at the tail
+        size_t end = static_cast<size_t>(nl - data) + 1;
+
+        Json record = Json::parse(data + pos, nl, nullptr, false);
+        if (record.is_discarded() || !record.is_object()) {
+            out.corrupt++;
+        } else if (record.contains("role")) {
+            out.messages.push_back(parse_message(record));
+            out.bytes.push_back(static_cast<uint32_t>(end - pos));
+        } else {
+            std::string type = record.value("type", "");
+            if (type == "reset") {
+                out.messages.clear();
+                out.bytes.clear();
+                out.live_offset = pos;
+            } else if (type == "drop") {
+                size_t count = std::min(out.messages.size(), record.value("count", static_cast<size_t>(0)));
+                out.messages.erase(out.messages.begin(), out.messages.begin() + static_cast<long>(count));
+                out.bytes.erase(out.bytes.begin(), out.bytes.begin() + static_cast<long>(count));
+            }
+        }
+        pos = end;
+        out.good_end = end;
+    }
+}
+
+} // anonymous namespace
+
+SessionStore::SessionStore()
+    : running_(false)
+    , queued_seq_(1)
+    , committed_seq_(0)
+    , failed_seq_(0)
+    , stop_(false) {}
+
+SessionStore::~SessionStore() {
+    close();
+}
+
+std::string SessionStore::file_name(const std::string& key) {
+    std::string name;
+    for (size_t i = 0; i < key.size() && name.size() < 96; ++i) {
+        char c = key[i];
+        bool safe = std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.';
+        name += safe ? c : '_';
+    }
+    char suffix[24];
+    snprintf(suffix, sizeof(suffix), "-%08x.jsonl",
+             static_cast<unsigned>(fnv1a(fnv_offset, key) & 0xffffffffu));
+    return name + suffix;
+}
+
+bool SessionStore::open(const Config& config) {
+    if (running_) return true;
+    config_ = config;
+    if (config_.dir.empty() || !mkdir_p(config_.dir)) {
+        LOG_ERROR("[SessionStore] Cannot create session directory '%s'", config_.dir.c_str());
+        return false;
+    }
+
+    scan();
+
+    stop_ = false;
+    running_ = true;
+    writer_ = std::thread(&SessionStore::writer_loop, this);
+    return true;
+}
+
+void SessionStore::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || stop_) return;
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+    running_ = false;
+    done_cv_.notify_all();
+}
+
+void SessionStore::scan() {
+    int64_t started = current_timestamp_ms();
+    DIR* dir = opendir(config_.dir.c_str());
+    if (!dir) return;
+
+    size_t skipped = 0;
+    uint64_t total_bytes = 0;
+    struct dirent* ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        std::string name = ent->d_name;
+        if (!ends_with_jsonl(name)) continue;
+        std::string path = config_.dir + "/" + name;
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        struct stat st;
+        char buf[4096];
+        ssize_t n = (fstat(fd, &st) == 0) ? pread(fd, buf, sizeof(buf), 0) : -1;
+        ::close(fd);
+
+        // Only the header: histories are read when first used
+        const char* nl = n > 0 ? static_cast<const char*>(memchr(buf, '\n', static_cast<size_t>(n))) : nullptr;
+        Json header = nl ? Json::parse(static_cast<const char*>(buf), nl, nullptr, false) : Json();
+        if (!header.is_object() || header.value("type", "") != "session" ||
+            !header.contains("key") || !header["key"].is_string()) {
+            skipped++;
+            continue;
+        }
+
+        Entry& entry = entries_[header["key"].get<std::string>()];
+        entry.path = path;
+        entry.size = static_cast<uint64_t>(st.st_size);
+        total_bytes += entry.size;
+    }
+    closedir(dir);
+
+    LOG_INFO("[SessionStore] %zu sessions (%.1f MB) in %s, indexed in %lld ms%s",
+             entries_.size(), total_bytes / (1024.0 * 1024.0), config_.dir.c_str(),
+             static_cast<long long>(current_timestamp_ms() - started),
+             skipped ? " (skipped files without a session header)" : "");
+}
+
+void SessionStore::wait_for(uint64_t seq, std::unique_lock<std::mutex>& lock) {
+    done_cv_.wait(lock, [this, seq] { return committed_seq_ >= seq || !running_; });
+}
+
+bool SessionStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) return true;
+    uint64_t before = committed_seq_;
+    // An empty dirty list means only the batch in flight is outstanding
+    uint64_t target = dirty_.empty() ? queued_seq_ - 1 : queued_seq_;
+    wait_for(target, lock);
+    return failed_seq_ <= before;
+}
+
+bool SessionStore::contains(const std::string& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(key) > 0;
+}
+
+void SessionStore::release(const std::string& key) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::map<std::string, Entry>::iterator it = entries_.find(key);
+    if (it == entries_.end()) return;
+    if (it->second.queued_seq > committed_seq_) wait_for(it->second.queued_seq, lock);
+    // Look it up again: the writer ran in between
+    it = entries_.find(key);
+    if (it == entries_.end() || !it->second.pending.empty() || it->second.rewrite) return;
+    entries_.erase(it);
+}
+
+bool SessionStore::changed_elsewhere(const std::string& key) const {
+    if (!running_) return false;
+    std::string path;
+    uint64_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, Entry>::const_iterator it = entries_.find(key);
+        if (it == entries_.end() || !it->second.known) return false;
+        const Entry& entry = it->second;
+        // The file lags behind `size` until the writer is done with it
+        if (!entry.pending.empty() || entry.rewrite || entry.queued_seq > committed_seq_) return false;
+        path = entry.path;
+        size = entry.size;
+    }
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return size > 0;
+    return static_cast<uint64_t>(st.st_size) != size;
+}
+
+SessionStore::Stats SessionStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = counters_;
+    s.sessions = entries_.size();
+    return s;
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+void SessionStore::load(Session& session) {
+    const std::string& key = session.key();
+    std::string path;
+    uint64_t offset = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_) return;
+        std::map<std::string, Entry>::iterator it = entries_.find(key);
+        if (it == entries_.end()) {
+            // Not in the startup scan, but another node may have created it since
+            path = config_.dir + "/" + file_name(key);
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0 || st.st_size == 0) {
+                Entry& entry = entries_[key];
+                entry.path = path;
+                entry.known = true;
+                return;
+            }
+            entries_[key].path = path;
+        } else {
+            // Evicted from memory with appends still queued: read them back too
+            if (it->second.queued_seq > committed_seq_) wait_for(it->second.queued_seq, lock);
+            path = it->second.path;
+            offset = it->second.live_offset;
+        }
+    }
+
+    int64_t started = current_timestamp_ms();
+    int fd = ::open(path.c_str(), O_RDWR);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        LOG_ERROR("[SessionStore] Cannot open %s: %s", path.c_str(), strerror(errno));
+        if (fd >= 0) ::close(fd);
+        return;
+    }
+
+    Replay result;
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size > 0 && offset < size) {
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            LOG_ERROR("[SessionStore] Cannot map %s: %s", path.c_str(), strerror(errno));
+            ::close(fd);
+            return;
+        }
+        madvise(map, size, MADV_SEQUENTIAL);
+        replay(static_cast<const char*>(map), size, offset, result);
+        munmap(map, size);
+    } else {
+        result.good_end = size;
+        result.live_offset = offset;
+    }
+
+    // A crash mid-append leaves a partial line; appending after it would
+    // glue the next record onto it
+    if (result.good_end < size) {
+        LOG_WARN("[SessionStore] %s: dropping %zu bytes of a torn record", path.c_str(),
+                 static_cast<size_t>(size - result.good_end));
+        if (ftruncate(fd, static_cast<off_t>(result.good_end)) != 0) {
+            LOG_ERROR("[SessionStore] Cannot truncate %s: %s", path.c_str(), strerror(errno));
+        }
+    }
+    ::close(fd);
+    if (result.corrupt > 0) {
+        LOG_WARN("[SessionStore] %s: skipped %zu unreadable records", path.c_str(), result.corrupt);
+    }
+
+    std::vector<Record> live(result.messages.size());
+    uint64_t live_bytes = 0;
+    for (size_t i = 0; i < result.messages.size(); ++i) {
+        live[i].hash = message_hash(result.messages[i]);
+        live[i].bytes = result.bytes[i];
+        live_bytes += result.bytes[i];
+    }
+
+    LOG_DEBUG("[SessionStore] Loaded %zu messages of %s in %lld ms", result.messages.size(),
+              key.c_str(), static_cast<long long>(current_timestamp_ms() - started));
+    session.history().swap(result.messages);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[key];
+    entry.size = result.good_end;
+    entry.live_offset = result.live_offset;
+    entry.live.swap(live);
+    entry.live_bytes = live_bytes;
+    entry.known = true;
+    counters_.loaded++;
+}
+
+// ============================================================================
+// Appending
+// ============================================================================
+
+void SessionStore::persist(const Session& session) {
+    if (!running_) return;
+    const std::string& key = session.key();
+    const std::vector<ConversationMessage>& history = session.history();
+
+    std::vector<uint64_t> hashes(history.size());
+    for (size_t i = 0; i < history.size(); ++i) hashes[i] = message_hash(history[i]);
+
+    // Decide under the lock; only this session's strand changes its entry,
+    // so the records can be built without it
+    bool append = false;
+    size_t drop = 0;
+    size_t first_new = 0;
+    bool new_file = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry& entry = entries_[key];
+        if (entry.path.empty()) entry.path = config_.dir + "/" + file_name(key);
+        new_file = entry.size == 0;
+
+        if (entry.known) {
+            const std::vector<Record>& live = entry.live;
+            if (live.empty()) {
+                append = true;
+            } else if (!hashes.empty()) {
+                // The history is the persisted one minus its oldest `drop`
+                // messages plus new ones (trimming and appending)
+                for (size_t j = 0; j < live.size() && !append; ++j) {
+                    if (live[j].hash != hashes[0] || live.size() - j > hashes.size()) continue;
+                    bool match = true;
+                    for (size_t k = j; k < live.size() && match; ++k) {
+                        match = live[k].hash == hashes[k - j];
+                    }
+                    if (match) {
+                        append = true;
+                        drop = j;
+                    }
+                }
+            }
+            if (append) {
+                first_new = live.size() - drop;
+                if (drop == 0 && first_new == hashes.size()) return;    // Unchanged
+            } else if (live.empty() && hashes.empty()) {
+                return;
+            }
+        } else if (new_file && hashes.empty()) {
+            return;
+        }
+    }
+
+    int64_t now = current_timestamp();
+    std::string out;
+    std::vector<Record> added;
+    uint64_t added_bytes = 0;
+    size_t records = 0;
+    if (new_file) out += header_line(key);
+    if (append && drop > 0) {
+        out += drop_line(drop);
+        records++;
+    } else if (!append && !new_file) {
+        out += reset_line();
+        records++;
+    }
+    size_t control_bytes = out.size();
+    for (size_t i = append ? first_new : 0; i < history.size(); ++i) {
+        std::string line = message_line(history[i], now);
+        Record rec;
+        rec.hash = hashes[i];
+        rec.bytes = static_cast<uint32_t>(line.size());
+        added.push_back(rec);
+        added_bytes += line.size();
+        out += line;
+        records++;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[key];
+    if (append) {
+        for (size_t j = 0; j < drop; ++j) entry.live_bytes -= entry.live[j].bytes;
+        entry.live.erase(entry.live.begin(), entry.live.begin() + static_cast<long>(drop));
+    } else {
+        entry.live.clear();
+        entry.live_bytes = 0;
+        entry.live_offset = new_file ? control_bytes : entry.size;
+    }
+    entry.live.insert(entry.live.end(), added.begin(), added.end());
+    entry.live_bytes += added_bytes;
+    entry.known = true;
+
+    bool was_dirty = !entry.pending.empty() || entry.rewrite;
+    if (entry.failed || entry.size + out.size() > 3 * entry.live_bytes + rewrite_slack) {
+        // Mostly trimmed or summarized history: replace the file with the live part
+        std::string rewritten = header_line(key);
+        entry.live_offset = rewritten.size();
+        entry.live_bytes = 0;
+        for (size_t i = 0; i < history.size(); ++i) {
+            std::string line = message_line(history[i], now);
+            entry.live[i].bytes = static_cast<uint32_t>(line.size());
+            entry.live_bytes += line.size();
+            rewritten += line;
+        }
+        entry.pending.swap(rewritten);
+        entry.size = entry.pending.size();
+        entry.rewrite = true;
+        entry.failed = false;
+        counters_.rewrites++;
+    } else {
+        entry.pending += out;
+        entry.size += out.size();
+    }
+    counters_.records += records;
+    entry.queued_seq = queued_seq_;
+    if (!was_dirty) dirty_.push_back(key);
+    work_cv_.notify_one();
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+void SessionStore::writer_loop() {
+    struct Job {
+        std::string key;
+        std::string path;
+        std::string data;
+        bool rewrite;
+    };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this] { return stop_ || !dirty_.empty(); });
+        if (dirty_.empty()) break;      // Stopping with nothing left
+
+        // Let the rest of the batch arrive; one sync then covers all of it
+        if (!stop_ && config_.commit_interval_ms > 0) {
+            work_cv_.wait_for(lock, std::chrono::milliseconds(config_.commit_interval_ms),
+                              [this] { return stop_; });
+        }
+
+        std::vector<Job> jobs;
+        jobs.reserve(dirty_.size());
+        for (size_t i = 0; i < dirty_.size(); ++i) {
+            Entry& entry = entries_[dirty_[i]];
+            Job job;
+            job.key = dirty_[i];
+            job.path = entry.path;
+            job.data.swap(entry.pending);
+            job.rewrite = entry.rewrite;
+            entry.rewrite = false;
+            jobs.push_back(job);
+        }
+        dirty_.clear();
+        uint64_t seq = queued_seq_++;
+        lock.unlock();
+
+        uint64_t bytes = 0;
+        uint64_t syncs = 0;
+        bool names_changed = false;
+        std::vector<std::string> failed;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            const Job& job = jobs[i];
+            std::string target = job.rewrite ? job.path + ".tmp" : job.path;
+            int flags = O_WRONLY | O_CREAT | (job.rewrite ? O_TRUNC : O_APPEND);
+            int fd = ::open(target.c_str(), flags, 0600);
+            if (fd < 0) {
+                LOG_ERROR("[SessionStore] Cannot open %s: %s", target.c_str(), strerror(errno));
+                failed.push_back(job.key);
+                continue;
+            }
+            struct stat st;
+            off_t before = -1;
+            if (fstat(fd, &st) == 0) {
+                before = st.st_size;
+                if (st.st_size == 0) names_changed = true;
+            }
+
+            bool ok = write_all(fd, job.data);
+            if (ok && config_.fsync) {
+                ok = fdatasync(fd) == 0;
+                syncs++;
+            }
+            if (!ok) {
+                LOG_ERROR("[SessionStore] Write to %s failed: %s", target.c_str(), strerror(errno));
+                // Cut off what did get written: later appends would glue onto
+                // a torn line. A failed rewrite leaves the old file in place.
+                if (job.rewrite) {
+                    unlink(target.c_str());
+                } else if (before < 0 || ftruncate(fd, before) != 0) {
+                    LOG_ERROR("[SessionStore] Cannot truncate %s: %s", target.c_str(), strerror(errno));
+                }
+                ::close(fd);
+                failed.push_back(job.key);
+                continue;
+            }
+            ::close(fd);
+            if (job.rewrite) {
+                if (rename(target.c_str(), job.path.c_str()) != 0) {
+                    LOG_ERROR("[SessionStore] Cannot replace %s: %s", job.path.c_str(), strerror(errno));
+                    unlink(target.c_str());
+                    failed.push_back(job.key);
+                    continue;
+                }
+                names_changed = true;
+            }
+            bytes += job.data.size();
+        }
+
+        // New and renamed files only survive a crash once the directory is synced
+        if (names_changed && config_.fsync) {
+            int dfd = ::open(config_.dir.c_str(), O_RDONLY | O_DIRECTORY);
+            if (dfd >= 0) {
+                fsync(dfd);
+                ::close(dfd);
+            }
+        }
+
+        lock.lock();
+        // The entries of failed writes no longer mirror their files: drop
+        // what was queued on top and rewrite them in full on the next persist
+        bool dropped = false;
+        for (size_t i = 0; i < failed.size(); ++i) {
+            Entry& entry = entries_[failed[i]];
+            if (!entry.pending.empty() || entry.rewrite) {
+                dirty_.erase(std::remove(dirty_.begin(), dirty_.end(), failed[i]), dirty_.end());
+                dropped = true;
+            }
+            entry.pending.clear();
+            entry.rewrite = false;
+            entry.queued_seq = seq;     // Nothing left to wait for
+            entry.known = false;
+            entry.failed = true;
+            entry.live.clear();
+            entry.live_bytes = 0;
+            struct stat st;
+            entry.size = stat(entry.path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+        }
+        if (!failed.empty()) failed_seq_ = seq;
+        committed_seq_ = seq;
+        // That may have emptied the batch being filled; close it as well, or
+        // flush() callers waiting for it would never wake
+        if (dropped && dirty_.empty()) {
+            committed_seq_ = queued_seq_++;
+            failed_seq_ = committed_seq_;
+        }
+        counters_.commits++;
+        counters_.syncs += syncs;
+        counters_.bytes += bytes;
+        done_cv_.notify_all();
+    }
+}
+
+} // namespace openclaw
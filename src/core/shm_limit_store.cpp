@@ -0,0 +1,187 @@
+/*
+ * OpenClaw C++11 - Shared-Memory Rate-Limit Store Implementation
+ */
+#include <openclaw/core/shm_limit_store.hpp>
+#include <openclaw/core/logger.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace openclaw {
+
+namespace {
+
+const uint64_t fnv_offset = 14695981039346656037ULL;
+const uint64_t fnv_prime = 1099511628211ULL;
+
+// Stable across processes and builds (std::hash is neither); 0 marks a free slot
+uint64_t key_tag(const char* kind, const std::string& key) {
+    uint64_t h = fnv_offset;
+    for (const char* p = kind; *p; ++p) {
+        h = (h ^ static_cast<unsigned char>(*p)) * fnv_prime;
+    }
+    for (size_t i = 0; i < key.size(); ++i) {
+        h = (h ^ static_cast<unsigned char>(key[i])) * fnv_prime;
+    }
+    return h != 0 ? h : 1;
+}
+
+// Message IDs come hashed already; keep them apart from limiter keys
+uint64_t seen_tag(uint64_t id_hash) {
+    uint64_t h = id_hash ^ 0x9e3779b97f4a7c15ULL;
+    return h != 0 ? h : 1;
+}
+
+}
+
+ShmRateLimitStore::ShmRateLimitStore()
+    : mapping_(nullptr)
+    , mapping_size_(0)
+    , slots_(nullptr)
+    , slot_count_(0) {}
+
+ShmRateLimitStore::~ShmRateLimitStore() {
+    close();
+}
+
+bool ShmRateLimitStore::open(const Config& config) {
+    close();
+
+    int fd = shm_open(config.name.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        LOG_ERROR("[ShmLimits] Cannot open shared memory %s: %s", config.name.c_str(), strerror(errno));
+        return false;
+    }
+
+    // The first process sizes the segment; later ones take it as it is
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0) {
+        size_t slots = config.slots > 0 ? config.slots : 1;
+        if (ftruncate(fd, static_cast<off_t>(slots * sizeof(Slot))) != 0) {
+            LOG_ERROR("[ShmLimits] Cannot size %s: %s", config.name.c_str(), strerror(errno));
+            ::close(fd);
+            return false;
+        }
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Slot))) {
+        LOG_ERROR("[ShmLimits] Unusable shared memory %s", config.name.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        LOG_ERROR("[ShmLimits] Cannot map %s: %s", config.name.c_str(), strerror(errno));
+        return false;
+    }
+
+    // Zero-filled memory is an empty table
+    Slot* slots = static_cast<Slot*>(mapping);
+    if (!slots[0].word.is_lock_free() || !slots[0].tag.is_lock_free()) {
+        LOG_ERROR("[ShmLimits] 64-bit atomics are not lock-free here; shared limits disabled");
+        munmap(mapping, size);
+        return false;
+    }
+
+    mapping_ = mapping;
+    mapping_size_ = size;
+    slots_ = slots;
+    slot_count_ = size / sizeof(Slot);
+
+    LOG_INFO("[ShmLimits] Sharing rate limits and dedup through %s (%zu slots)",
+             config.name.c_str(), slot_count_);
+    return true;
+}
+
+void ShmRateLimitStore::close() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    }
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    slots_ = nullptr;
+    slot_count_ = 0;
+}
+
+ShmRateLimitStore::Slot* ShmRateLimitStore::claim(uint64_t tag, int64_t now_s, bool& created) {
+    created = false;
+    size_t probes = slot_count_ < MAX_PROBE ? slot_count_ : MAX_PROBE;
+
+    for (size_t i = 0; i < probes; ++i) {
+        Slot& slot = slots_[(tag + i) % slot_count_];
+        uint64_t current = slot.tag.load();
+        if (current == tag) {
+            return &slot;
+        }
+
+        if (current == 0) {
+            uint64_t expected = 0;
+            if (slot.tag.compare_exchange_strong(expected, tag)) {
+                created = true;
+                return &slot;
+            }
+            if (expected == tag) {
+                return &slot;
+            }
+            continue;
+        }
+
+        // Past the time its owner needs it: reset and retag. -1 keeps
+        // others off while the words change.
+        int64_t until = slot.until.load();
+        if (until > 0 && until < now_s && slot.until.compare_exchange_strong(until, -1)) {
+            slot.word.store(0);
+            slot.tag.store(tag);
+            created = true;
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+int ShmRateLimitStore::lease(const std::string& key, const RateLimitPolicy& policy, int n,
+                             RateLimitResult& result) {
+    if (!slots_) return -1;
+
+    int64_t now_us = RateLimitPolicy::now_us();
+    int64_t now_s = now_us / 1000000 + 1;
+    bool created = false;
+    Slot* slot = claim(key_tag("limit:", key), now_s, created);
+    if (!slot) return -1;
+
+    slot->until.store(now_s + policy.idle_seconds());
+    result = policy.take(slot->word, n, now_us);
+    return result.allowed ? n : 0;
+}
+
+int ShmRateLimitStore::mark_seen(uint64_t id_hash, int window_seconds) {
+    if (!slots_) return -1;
+
+    int64_t now_s = RateLimitPolicy::now_us() / 1000000 + 1;
+    bool created = false;
+    Slot* slot = claim(seen_tag(id_hash), now_s, created);
+    if (!slot) return -1;
+
+    int64_t keep_until = now_s + std::max(window_seconds, 1);
+    if (created) {
+        slot->until.store(keep_until);
+        return 1;
+    }
+
+    // Still being set up by the process that claimed it, or inside the
+    // window; past it, whoever moves the deadline first takes the message
+    int64_t until = slot->until.load();
+    if (until <= 0 || until >= now_s) {
+        return 0;
+    }
+    return slot->until.compare_exchange_strong(until, keep_until) ? 1 : 0;
+}
+
+} // namespace openclaw
@@ -0,0 +1,103 @@
+#include <openclaw/core/sse.hpp>
+
+namespace openclaw {
+
+SseParser::SseParser(EventCallback on_event)
+    : on_event_(on_event)
+    , has_data_(false)
+    , skip_lf_(false)
+    , events_(0)
+{}
+
+void SseParser::feed(const char* data, size_t len) {
+    size_t start = 0;
+    for (size_t i = 0; i < len; ++i) {
+        char c = data[i];
+        if (c != '\r' && c != '\n') {
+            continue;
+        }
+        // "\r\n" split across two feeds: the '\n' already ended the line
+        if (c == '\n' && skip_lf_ && i == 0) {
+            skip_lf_ = false;
+            start = 1;
+            continue;
+        }
+        line_.append(data + start, i - start);
+        process_line(line_);
+        line_.clear();
+        
+        if (c == '\r') {
+            if (i + 1 < len) {
+                if (data[i + 1] == '\n') ++i;
+            } else {
+                skip_lf_ = true;
+                start = len;
+                return;
+            }
+        }
+        start = i + 1;
+    }
+    skip_lf_ = false;
+    if (start < len) {
+        line_.append(data + start, len - start);
+    }
+}
+
+void SseParser::finish() {
+    if (!line_.empty()) {
+        process_line(line_);
+        line_.clear();
+    }
+    dispatch();
+}
+
+void SseParser::process_line(const std::string& line) {
+    // Blank line ends the event
+    if (line.empty()) {
+        dispatch();
+        return;
+    }
+    // Comment / keep-alive
+    if (line[0] == ':') {
+        return;
+    }
+    
+    std::string field;
+    std::string value;
+    size_t colon = line.find(':');
+    if (colon == std::string::npos) {
+        field = line;
+    } else {
+        field = line.substr(0, colon);
+        size_t vstart = colon + 1;
+        if (vstart < line.size() && line[vstart] == ' ') ++vstart;
+        value = line.substr(vstart);
+    }
+    
+    if (field == "data") {
+        if (has_data_) data_ += '\n';
+        data_ += value;
+        has_data_ = true;
+    } else if (field == "event") {
+        event_ = value;
+    }
+    // id and retry are not needed for API streams
+}
+
+void SseParser::dispatch() {
+    if (!has_data_) {
+        event_.clear();
+        return;
+    }
+    std::string event = event_.empty() ? std::string("message") : event_;
+    std::string data;
+    data.swap(data_);
+    event_.clear();
+    has_data_ = false;
+    events_++;
+    if (on_event_) {
+        on_event_(event, data);
+    }
+}
+
+} // namespace openclaw
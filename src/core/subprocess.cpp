@@ -0,0 +1,278 @@
+/*
+ * OpenClaw C++11 - Subprocess Executor Implementation
+ */
+#include <openclaw/core/subprocess.hpp>
+#include <openclaw/core/reactor.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/core/utils.hpp>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace openclaw {
+
+namespace {
+
+// How often a child that closed its output is checked for having exited
+const int64_t reap_interval_ms = 50;
+
+std::atomic<size_t> g_running(0);
+
+struct Child {
+    pid_t pid;
+    int fd;                     // Read end of the output pipe, -1 once closed
+    size_t max_output;
+    int64_t started_ms;
+    Reactor::TimerId deadline;
+    Reactor::TimerId reaper;
+    SubprocessResult result;
+    SubprocessCallback on_done;
+    std::mutex mutex;           // Timer ids are set after registration
+
+    Child() : pid(-1), fd(-1), max_output(0), started_ms(0), deadline(0), reaper(0) {}
+};
+typedef std::shared_ptr<Child> ChildPtr;
+
+std::string shell_quote(const std::string& s) {
+    std::string out = "'";
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '\'') out += "'\\''";
+        else out += s[i];
+    }
+    return out + "'";
+}
+
+void kill_group(const ChildPtr& child) {
+    if (child->pid > 0) kill(-child->pid, SIGKILL);
+}
+
+void finish(const ChildPtr& child, int status) {
+    Reactor::TimerId deadline, reaper;
+    {
+        std::lock_guard<std::mutex> lock(child->mutex);
+        deadline = child->deadline;
+        reaper = child->reaper;
+        child->deadline = child->reaper = 0;
+    }
+    if (deadline) Reactor::instance().cancel_timer(deadline);
+    if (reaper) Reactor::instance().cancel_timer(reaper);
+
+    SubprocessResult& result = child->result;
+    if (WIFEXITED(status)) {
+        result.exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result.term_signal = WTERMSIG(status);
+        result.exit_code = 128 + result.term_signal;
+    }
+    result.duration_ms = current_timestamp_ms() - child->started_ms;
+    g_running--;
+
+    SubprocessCallback cb;
+    cb.swap(child->on_done);
+    try {
+        cb(result);
+    } catch (const std::exception& e) {
+        LOG_ERROR("[Subprocess] Completion callback threw: %s", e.what());
+    }
+}
+
+// The output is closed; the child may still be exiting
+bool try_reap(const ChildPtr& child) {
+    int status = 0;
+    pid_t r = waitpid(child->pid, &status, WNOHANG);
+    if (r == 0) return false;
+    if (r < 0) status = 0;
+    finish(child, status);
+    return true;
+}
+
+void on_output_closed(const ChildPtr& child) {
+    Reactor::instance().remove_fd(child->fd);
+    close(child->fd);
+    child->fd = -1;
+
+    if (try_reap(child)) return;
+    std::lock_guard<std::mutex> lock(child->mutex);
+    child->reaper = Reactor::instance().add_timer(reap_interval_ms, reap_interval_ms, [child] {
+        try_reap(child);
+    });
+}
+
+void on_readable(const ChildPtr& child) {
+    if (child->fd < 0) return;
+    char buffer[16384];
+    for (;;) {
+        ssize_t n = read(child->fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            std::string& out = child->result.output;
+            if (child->result.truncated) continue;   // Draining until the kill lands
+            size_t room = child->max_output > out.size() ? child->max_output - out.size() : 0;
+            out.append(buffer, std::min(static_cast<size_t>(n), room));
+            if (static_cast<size_t>(n) > room) {
+                child->result.truncated = true;
+                kill_group(child);
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        on_output_closed(child);
+        return;
+    }
+}
+
+bool write_file(const std::string& path, const std::string& value) {
+    std::ofstream f(path.c_str());
+    if (!f) return false;
+    f << value;
+    f.flush();
+    return static_cast<bool>(f);
+}
+
+} // anonymous namespace
+
+void Subprocess::run_async(const SubprocessOptions& options, SubprocessCallback on_done) {
+    ChildPtr child = std::make_shared<Child>();
+    child->max_output = options.max_output > 0 ? options.max_output : 1;
+    child->on_done = on_done;
+
+    // The shell joins the cgroup before it runs anything else
+    std::ostringstream script;
+    if (!options.cgroup.empty()) {
+        script << "echo $$ > " << shell_quote(options.cgroup + "/cgroup.procs") << " && ";
+    }
+    if (!options.workdir.empty()) {
+        script << "cd " << shell_quote(options.workdir) << " && ";
+    }
+    script << options.command;
+    std::string script_text = script.str();
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        child->result.error = std::string("pipe: ") + strerror(errno);
+        on_done(child->result);
+        return;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], 1);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], 2);
+
+    // Own process group, default signal handling (we ignore SIGPIPE)
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGTERM);
+    sigset_t none;
+    sigemptyset(&none);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF |
+                                    POSIX_SPAWN_SETSIGMASK);
+
+    const char* argv[] = { "/bin/sh", "-c", script_text.c_str(), nullptr };
+    child->started_ms = current_timestamp_ms();
+    int rc = posix_spawn(&child->pid, "/bin/sh", &actions, &attr,
+                         const_cast<char* const*>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(fds[1]);
+
+    if (rc != 0) {
+        close(fds[0]);
+        child->result.error = std::string("posix_spawn: ") + strerror(rc);
+        on_done(child->result);
+        return;
+    }
+
+    child->result.started = true;
+    child->fd = fds[0];
+    fcntl(child->fd, F_SETFL, fcntl(child->fd, F_GETFL) | O_NONBLOCK);
+    g_running++;
+
+    LOG_DEBUG("[Subprocess] Started pid %d: %s", (int)child->pid, options.command.c_str());
+
+    std::lock_guard<std::mutex> lock(child->mutex);
+    if (options.timeout_ms > 0) {
+        child->deadline = Reactor::instance().add_timer(options.timeout_ms, 0, [child] {
+            {
+                // Already reaped: its process group may belong to someone else now
+                std::lock_guard<std::mutex> lock(child->mutex);
+                if (!child->deadline) return;
+                child->deadline = 0;
+            }
+            child->result.timed_out = true;
+            kill_group(child);
+        });
+    }
+    if (!Reactor::instance().add_fd(child->fd, EPOLLIN,
+                                    [child](uint32_t) { on_readable(child); })) {
+        // Cannot watch it: treat the output as closed once the child is gone
+        kill_group(child);
+        child->result.error = "cannot watch output";
+        close(child->fd);
+        child->fd = -1;
+        child->reaper = Reactor::instance().add_timer(reap_interval_ms, reap_interval_ms, [child] {
+            try_reap(child);
+        });
+    }
+}
+
+SubprocessResult Subprocess::run(const SubprocessOptions& options) {
+    std::shared_ptr<std::promise<SubprocessResult> > result =
+        std::make_shared<std::promise<SubprocessResult> >();
+    std::future<SubprocessResult> future = result->get_future();
+    run_async(options, [result](const SubprocessResult& r) { result->set_value(r); });
+    return future.get();
+}
+
+bool Subprocess::setup_cgroup(const std::string& cgroup, int64_t memory_max, int cpu_percent) {
+    if (mkdir(cgroup.c_str(), 0755) != 0 && errno != EEXIST) {
+        LOG_WARN("[Subprocess] Cannot create cgroup %s: %s", cgroup.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = true;
+    if (memory_max > 0) {
+        std::ostringstream v;
+        v << memory_max;
+        ok = write_file(cgroup + "/memory.max", v.str()) && ok;
+    }
+    if (cpu_percent > 0) {
+        // quota and period in microseconds
+        std::ostringstream v;
+        v << (cpu_percent * 1000) << " 100000";
+        ok = write_file(cgroup + "/cpu.max", v.str()) && ok;
+    }
+    if (!ok) {
+        LOG_WARN("[Subprocess] Cannot set limits on cgroup %s (is it delegated to us?)",
+                 cgroup.c_str());
+    }
+    return ok;
+}
+
+size_t Subprocess::running() {
+    return g_running.load();
+}
+
+} // namespace openclaw
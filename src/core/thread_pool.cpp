@@ -3,35 +3,283 @@
  */
 #include <openclaw/core/thread_pool.hpp>
 #include <openclaw/core/logger.hpp>
+#include <chrono>
 
 namespace openclaw {
 
-ThreadPool::ThreadPool(size_t num_threads) : stop_(false) {
+namespace {
+
+// Pool and worker index of the current thread (tls_pool is null outside workers)
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local size_t tls_worker_index = 0;
+
+int64_t monotonic_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void update_max(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load();
+    while (value > current && !target.compare_exchange_weak(current, value)) {}
+}
+
+} // anonymous namespace
+
+const char* task_priority_name(TaskPriority priority) {
+    switch (priority) {
+        case TaskPriority::HIGH: return "high";
+        case TaskPriority::NORMAL: return "normal";
+        case TaskPriority::LOW: return "low";
+    }
+    return "normal";
+}
+
+ThreadPool::ThreadPool(size_t num_threads, size_t reserved_high, size_t low_workers)
+    : normal_limit_(num_threads > reserved_high ? num_threads - reserved_high : num_threads)
+    , low_limit_(low_workers < normal_limit_ ? low_workers : normal_limit_)
+    , next_queue_(0)
+    , steals_(0)
+    , capacity_(0)
+    , rejected_(0)
+    , stop_(false)
+{
+    for (size_t i = 0; i < num_threads; ++i) {
+        queues_.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    }
     for (size_t i = 0; i < num_threads; ++i) {
-        threads_.emplace_back([this] { worker(); });
+        threads_.emplace_back([this, i] { worker(i); });
     }
-    LOG_INFO("Thread pool started with %zu workers", num_threads);
+    LOG_INFO("Thread pool started with %zu workers (%zu reserved for high priority, up to %zu on low)",
+             num_threads, num_threads - normal_limit_, low_limit_);
 }
 
 ThreadPool::~ThreadPool() {
     shutdown();
 }
 
-void ThreadPool::enqueue(std::function<void()> task) {
+void ThreadPool::enqueue(std::function<void()> task, TaskPriority priority) {
+    if (stop_) {
+        LOG_WARN("Cannot enqueue task - thread pool is stopped");
+        return;
+    }
+    push(task, priority);
+}
+
+void ThreadPool::push(std::function<void()> task, TaskPriority priority) {
+    if (queues_.empty()) {
+        return;
+    }
+
+    size_t lane = static_cast<size_t>(priority);
+
+    // Tasks spawned by a worker stay local; external tasks are spread out
+    size_t target = (tls_pool == this)
+        ? tls_worker_index
+        : next_queue_.fetch_add(1) % queues_.size();
+
+    Task t;
+    t.fn = task;
+    t.priority = priority;
+    t.enqueued_us = monotonic_us();
+
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (stop_) {
-            LOG_WARN("Cannot enqueue task - thread pool is stopped");
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        lanes_[lane].queued++;
+        queues_[target]->lanes[lane].push_back(t);
+    }
+    lanes_[lane].enqueued++;
+    wake_one();
+}
+
+void ThreadPool::wake_one() {
+    {
+        // Taking the lock orders the caller's change against a worker's
+        // predicate check
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    condition_.notify_one();
+}
+
+bool ThreadPool::try_enqueue(std::function<void()> task, TaskPriority priority) {
+    size_t cap = capacity_.load();
+    if (cap > 0 && pending() >= cap) {
+        rejected_++;
+        return false;
+    }
+    enqueue(task, priority);
+    return true;
+}
+
+bool ThreadPool::try_enqueue_serial(const std::string& key, std::function<void()> task,
+                                    TaskPriority priority) {
+    size_t cap = capacity_.load();
+    if (cap > 0 && pending() >= cap) {
+        rejected_++;
+        return false;
+    }
+    enqueue_serial(key, task, priority);
+    return true;
+}
+
+bool ThreadPool::try_enqueue_serial_async(const std::string& key, AsyncStrandTask task,
+                                          TaskPriority priority) {
+    size_t cap = capacity_.load();
+    if (cap > 0 && pending() >= cap) {
+        rejected_++;
+        return false;
+    }
+    enqueue_serial_async(key, task, priority);
+    return true;
+}
+
+void ThreadPool::enqueue_serial(const std::string& key, std::function<void()> task,
+                                TaskPriority priority) {
+    enqueue_serial_async(key, [task](StrandDone done) {
+        task();
+        done();
+    }, priority);
+}
+
+void ThreadPool::enqueue_serial_async(const std::string& key, AsyncStrandTask task,
+                                      TaskPriority priority) {
+    if (stop_) {
+        LOG_WARN("Cannot enqueue strand task - thread pool is stopped");
+        return;
+    }
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(strands_mutex_);
+        std::map<std::string, Strand>::iterator it = strands_.find(key);
+        if (it == strands_.end()) {
+            // No work in flight for this key - start a new strand
+            it = strands_.insert(std::make_pair(key, Strand())).first;
+            schedule = true;
+        } else {
+            lanes_[static_cast<size_t>(priority)].deferred++;
+        }
+        it->second.tasks.push(std::make_pair(task, priority));
+    }
+
+    if (schedule) {
+        push([this, key] { run_strand(key); }, priority);
+    }
+}
+
+size_t ThreadPool::strand_count() const {
+    std::lock_guard<std::mutex> lock(strands_mutex_);
+    return strands_.size();
+}
+
+void ThreadPool::run_strand(const std::string& key) {
+    AsyncStrandTask task;
+    {
+        std::lock_guard<std::mutex> lock(strands_mutex_);
+        std::map<std::string, Strand>::iterator it = strands_.find(key);
+        if (it == strands_.end() || it->second.tasks.empty()) {
             return;
         }
-        tasks_.push(task);
+        task = it->second.tasks.front().first;
+    }
+
+    // The strand stays busy until done() runs, on whichever thread finishes
+    std::shared_ptr<std::atomic<bool> > released(new std::atomic<bool>(false));
+    StrandDone done = [this, key, released] {
+        if (!released->exchange(true)) {
+            release_strand(key);
+        }
+    };
+
+    try {
+        task(done);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Strand task threw exception (%s): %s", key.c_str(), e.what());
+        done();
+    } catch (...) {
+        LOG_ERROR("Strand task threw unknown exception (%s)", key.c_str());
+        done();
+    }
+}
+
+void ThreadPool::release_strand(const std::string& key) {
+    // Pop only after the task finished so a concurrent enqueue_serial()
+    // never sees an empty strand and starts a second runner for the key.
+    bool more = false;
+    TaskPriority next_priority = TaskPriority::NORMAL;
+    {
+        std::lock_guard<std::mutex> lock(strands_mutex_);
+        std::map<std::string, Strand>::iterator it = strands_.find(key);
+        if (it != strands_.end()) {
+            it->second.tasks.pop();
+            if (it->second.tasks.empty()) {
+                strands_.erase(it);
+            } else {
+                more = true;
+                next_priority = it->second.tasks.front().second;
+                lanes_[static_cast<size_t>(next_priority)].deferred--;
+            }
+        }
+    }
+
+    // Re-post instead of looping so one busy session cannot monopolize
+    // a worker while other sessions are waiting in the queue. This goes on
+    // during shutdown: the workers drain the strands before they exit.
+    if (more) {
+        push([this, key] { run_strand(key); }, next_priority);
     }
-    condition_.notify_one();
 }
 
 size_t ThreadPool::pending() const {
-    std::unique_lock<std::mutex> lock(mutex_);
-    return tasks_.size();
+    size_t total = 0;
+    for (size_t lane = 0; lane < TASK_PRIORITY_COUNT; ++lane) {
+        total += lanes_[lane].queued.load() + lanes_[lane].deferred.load();
+    }
+    return total;
+}
+
+size_t ThreadPool::queued() const {
+    size_t total = 0;
+    for (size_t lane = 0; lane < TASK_PRIORITY_COUNT; ++lane) {
+        total += lanes_[lane].queued.load();
+    }
+    return total;
+}
+
+size_t ThreadPool::pending(TaskPriority priority) const {
+    const LaneCounters& c = lanes_[static_cast<size_t>(priority)];
+    return c.queued.load() + c.deferred.load();
+}
+
+int64_t ThreadPool::estimated_wait_ms(TaskPriority priority) const {
+    const LaneCounters& c = lanes_[static_cast<size_t>(priority)];
+    uint64_t completed = c.completed.load();
+    if (completed == 0) {
+        return 0;
+    }
+    size_t workers = threads_.size();
+    if (priority == TaskPriority::NORMAL) workers = normal_limit_;
+    if (priority == TaskPriority::LOW) workers = low_limit_;
+    if (workers == 0) {
+        return 0;
+    }
+    double avg_run_ms = c.total_run_us.load() / 1000.0 / completed;
+    // Everything ahead of us plus the tasks currently running
+    double backlog = static_cast<double>(pending(priority) + c.running.load());
+    return static_cast<int64_t>(avg_run_ms * backlog / workers);
+}
+
+ThreadPool::LaneStats ThreadPool::lane_stats(TaskPriority priority) const {
+    const LaneCounters& c = lanes_[static_cast<size_t>(priority)];
+    LaneStats stats;
+    stats.enqueued = c.enqueued.load();
+    stats.completed = c.completed.load();
+    stats.total_wait_us = c.total_wait_us.load();
+    stats.max_wait_us = c.max_wait_us.load();
+    stats.total_run_us = c.total_run_us.load();
+    stats.max_run_us = c.max_run_us.load();
+    stats.queued = c.queued.load();
+    stats.deferred = c.deferred.load();
+    stats.running = c.running.load();
+    return stats;
 }
 
 void ThreadPool::shutdown() {
@@ -40,50 +288,194 @@ void ThreadPool::shutdown() {
         if (stop_) return;  // Already stopped
         stop_ = true;
     }
-    
+
     condition_.notify_all();
-    
+
     for (std::thread& thread : threads_) {
         if (thread.joinable()) {
             thread.join();
         }
     }
-    
+
+    // The workers ran everything runnable. What is left waits behind an
+    // async strand task that has not called done() and never will run:
+    // cancel it, so a late done() finds no strand to re-post
+    size_t cancelled = 0;
+    {
+        std::lock_guard<std::mutex> lock(strands_mutex_);
+        for (std::map<std::string, Strand>::iterator it = strands_.begin(); it != strands_.end(); ++it) {
+            Strand& strand = it->second;
+            strand.tasks.pop();     // The task still in flight
+            while (!strand.tasks.empty()) {
+                lanes_[static_cast<size_t>(strand.tasks.front().second)].deferred--;
+                strand.tasks.pop();
+                cancelled++;
+            }
+        }
+        strands_.clear();
+    }
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        std::lock_guard<std::mutex> lock(queues_[i]->mutex);
+        for (size_t lane = 0; lane < TASK_PRIORITY_COUNT; ++lane) {
+            cancelled += queues_[i]->lanes[lane].size();
+            lanes_[lane].queued -= queues_[i]->lanes[lane].size();
+            queues_[i]->lanes[lane].clear();
+        }
+    }
+    if (cancelled > 0) {
+        LOG_WARN("Thread pool cancelled %zu task(s) behind unfinished strand tasks", cancelled);
+    }
+
     LOG_INFO("Thread pool shutdown complete");
 }
 
-void ThreadPool::worker() {
-    while (true) {
-        std::function<void()> task;
-        
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            
-            // Wait for a task or stop signal
-            condition_.wait(lock, [this] { 
-                return stop_ || !tasks_.empty(); 
-            });
-            
-            if (stop_ && tasks_.empty()) {
-                return;  // Exit thread
-            }
-            
-            if (!tasks_.empty()) {
-                task = tasks_.front();
-                tasks_.pop();
-            }
+bool ThreadPool::pop_from(size_t queue_index, size_t lane, Task& out) {
+    WorkerQueue& q = *queues_[queue_index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.lanes[lane].empty()) {
+        return false;
+    }
+    out = q.lanes[lane].front();
+    q.lanes[lane].pop_front();
+    lanes_[lane].queued--;
+    return true;
+}
+
+bool ThreadPool::try_pop(size_t index, Task& out) {
+    size_t n = queues_.size();
+
+    for (size_t lane = 0; lane < TASK_PRIORITY_COUNT; ++lane) {
+        if (lanes_[lane].queued.load() == 0) {
+            continue;
+        }
+
+        // Claim a NORMAL/LOW slot up front so reserved workers stay free for HIGH
+        bool limited = (lane != static_cast<size_t>(TaskPriority::HIGH));
+        if (limited && !claim_slot(lane)) {
+            continue;
         }
-        
-        // Execute task outside the lock
-        if (task) {
-            try {
-                task();
-            } catch (const std::exception& e) {
-                LOG_ERROR("Thread pool task threw exception: %s", e.what());
-            } catch (...) {
-                LOG_ERROR("Thread pool task threw unknown exception");
+
+        // Own deque first, then steal from peers
+        for (size_t i = 0; i < n; ++i) {
+            size_t victim = (index + i) % n;
+            if (pop_from(victim, lane, out)) {
+                if (i > 0) steals_++;
+                if (!limited) lanes_[lane].running++;
+                return true;
             }
         }
+
+        if (limited) {
+            // A peer that checked for a free slot meanwhile saw this claim
+            lanes_[lane].running--;
+            wake_one();
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::claim_slot(size_t lane) {
+    // NORMAL and LOW share the non-reserved workers; LOW has its own cap too
+    LaneCounters& normal = lanes_[static_cast<size_t>(TaskPriority::NORMAL)];
+    LaneCounters& low = lanes_[static_cast<size_t>(TaskPriority::LOW)];
+    
+    size_t before = lanes_[lane].running.fetch_add(1);
+    size_t shared = normal.running.load() + low.running.load();
+    bool over = shared > normal_limit_;
+    if (lane == static_cast<size_t>(TaskPriority::LOW) && before >= low_limit_) {
+        over = true;
+    }
+    if (over) {
+        lanes_[lane].running--;
+        wake_one();     // A peer may have seen the transient claim
+        return false;
+    }
+    return true;
+}
+
+bool ThreadPool::has_runnable() const {
+    if (lanes_[static_cast<size_t>(TaskPriority::HIGH)].queued.load() > 0) {
+        return true;
+    }
+    const LaneCounters& normal = lanes_[static_cast<size_t>(TaskPriority::NORMAL)];
+    const LaneCounters& low = lanes_[static_cast<size_t>(TaskPriority::LOW)];
+    size_t shared = normal.running.load() + low.running.load();
+    if (shared >= normal_limit_) {
+        return false;
+    }
+    return normal.queued.load() > 0 ||
+           (low.queued.load() > 0 && low.running.load() < low_limit_);
+}
+
+void ThreadPool::run_task(Task& task) {
+    size_t lane = static_cast<size_t>(task.priority);
+    LaneCounters& c = lanes_[lane];
+
+    int64_t start = monotonic_us();
+    uint64_t wait = static_cast<uint64_t>(start - task.enqueued_us);
+    c.total_wait_us += wait;
+    update_max(c.max_wait_us, wait);
+
+    // Execute task outside any lock
+    try {
+        task.fn();
+    } catch (const std::exception& e) {
+        LOG_ERROR("Thread pool task threw exception: %s", e.what());
+    } catch (...) {
+        LOG_ERROR("Thread pool task threw unknown exception");
+    }
+
+    uint64_t run = static_cast<uint64_t>(monotonic_us() - start);
+    c.total_run_us += run;
+    update_max(c.max_run_us, run);
+    c.completed++;
+    c.running--;
+
+    // A freed NORMAL/LOW slot may unblock a waiting worker; during shutdown
+    // every idle worker has to re-check whether the pool has drained
+    if (stop_) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        condition_.notify_all();
+    } else if (lane != static_cast<size_t>(TaskPriority::HIGH) &&
+               (lanes_[static_cast<size_t>(TaskPriority::NORMAL)].queued.load() > 0 ||
+                lanes_[static_cast<size_t>(TaskPriority::LOW)].queued.load() > 0)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        condition_.notify_one();
+    }
+}
+
+void ThreadPool::worker(size_t index) {
+    tls_pool = this;
+    tls_worker_index = index;
+
+    while (true) {
+        Task task;
+        if (try_pop(index, task)) {
+            run_task(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // Stopping exits once nothing is runnable: a running strand task
+        // re-posts its successor before its worker comes back here
+        if (stop_ && queued() == 0) {
+            return;  // Exit thread
+        }
+
+        // Wait for a runnable task or stop signal. Whoever frees a slot or
+        // queues a task notifies under mutex_, so no wakeup is missed.
+        condition_.wait(lock, [this] {
+            return (stop_ && queued() == 0) || has_runnable();
+        });
+
+        if (stop_ && queued() == 0) {
+            return;
+        }
     }
 }
 
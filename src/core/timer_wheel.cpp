@@ -0,0 +1,169 @@
+/*
+ * OpenClaw C++11 - Hierarchical Timer Wheel Implementation
+ */
+#include <openclaw/core/timer_wheel.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/logger.hpp>
+
+namespace openclaw {
+
+TimerWheel& TimerWheel::instance() {
+    static TimerWheel wheel;
+    return wheel;
+}
+
+TimerWheel::TimerWheel(int64_t tick_ms)
+    : tick_ms_(tick_ms > 0 ? tick_ms : 1)
+    , current_tick_(current_timestamp_ms() / tick_ms_)
+    , next_id_(1)
+    , wakeup_tick_(-1) {}
+
+void TimerWheel::file_locked(TimerId id, int64_t deadline_tick) {
+    int64_t delta = deadline_tick - current_tick_;
+    for (int level = 0; level < LEVELS; ++level) {
+        int shift = SLOT_BITS * level;
+        int64_t span = static_cast<int64_t>(1) << (shift + SLOT_BITS);
+        if (delta < span || level == LEVELS - 1) {
+            // Past the top level's span: park in its furthest slot, the
+            // cascade files it again with the real deadline
+            int64_t tick = delta < span ? deadline_tick : current_tick_ + span - 1;
+            slots_[level][(tick >> shift) & (SLOTS - 1)].push_back(id);
+            return;
+        }
+    }
+}
+
+TimerWheel::TimerId TimerWheel::schedule_at(int64_t deadline_ms, Callback cb, const void* owner) {
+    TimerId id;
+    Callback hook;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // The current tick's slot was already visited; the earliest is the next
+        int64_t deadline_tick = (deadline_ms + tick_ms_ - 1) / tick_ms_;
+        if (deadline_tick <= current_tick_) deadline_tick = current_tick_ + 1;
+
+        id = next_id_++;
+        Timer& timer = timers_[id];
+        timer.deadline_tick = deadline_tick;
+        timer.cb = cb;
+        timer.owner = owner;
+        file_locked(id, deadline_tick);
+
+        if (wakeup_tick_ < 0 || deadline_tick < wakeup_tick_) {
+            wakeup_tick_ = deadline_tick;
+            hook = wakeup_hook_;
+        }
+    }
+    if (hook) hook();
+    return id;
+}
+
+TimerWheel::TimerId TimerWheel::schedule_in(int64_t delay_ms, Callback cb, const void* owner) {
+    return schedule_at(current_timestamp_ms() + delay_ms, cb, owner);
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.erase(id) > 0;
+}
+
+size_t TimerWheel::cancel_all(const void* owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t removed = 0;
+    std::unordered_map<TimerId, Timer>::iterator it = timers_.begin();
+    while (it != timers_.end()) {
+        if (it->second.owner == owner) {
+            it = timers_.erase(it);
+            ++removed;
+        } else {
+            ++it;
+        }
+    }
+    return removed;
+}
+
+size_t TimerWheel::advance() {
+    return advance(current_timestamp_ms());
+}
+
+size_t TimerWheel::advance(int64_t now_ms) {
+    std::vector<Callback> due;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t target = now_ms / tick_ms_;
+
+        while (current_tick_ < target) {
+            if (timers_.empty()) {
+                // Nothing to fire or cascade (slots may hold cancelled ids,
+                // which are skipped whenever they are reached)
+                current_tick_ = target;
+                break;
+            }
+
+            int64_t tick = ++current_tick_;
+
+            // Entering a new block of a level moves its slot one level
+            // down; higher levels first, they may refill a lower slot
+            for (int level = LEVELS - 1; level > 0; --level) {
+                int shift = SLOT_BITS * level;
+                if ((tick & ((static_cast<int64_t>(1) << shift) - 1)) != 0) continue;
+
+                std::vector<TimerId> moving;
+                moving.swap(slots_[level][(tick >> shift) & (SLOTS - 1)]);
+                for (size_t i = 0; i < moving.size(); ++i) {
+                    std::unordered_map<TimerId, Timer>::const_iterator it = timers_.find(moving[i]);
+                    if (it != timers_.end()) file_locked(moving[i], it->second.deadline_tick);
+                }
+            }
+
+            std::vector<TimerId> expiring;
+            expiring.swap(slots_[0][tick & (SLOTS - 1)]);
+            for (size_t i = 0; i < expiring.size(); ++i) {
+                std::unordered_map<TimerId, Timer>::iterator it = timers_.find(expiring[i]);
+                if (it == timers_.end()) continue;
+                due.push_back(std::move(it->second.cb));
+                timers_.erase(it);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < due.size(); ++i) {
+        try {
+            if (due[i]) due[i]();
+        } catch (const std::exception& e) {
+            LOG_ERROR("[TimerWheel] Timer callback threw: %s", e.what());
+        }
+    }
+    return due.size();
+}
+
+int64_t TimerWheel::next_wakeup_ms() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timers_.empty()) {
+        wakeup_tick_ = -1;
+        return -1;
+    }
+
+    // Lower levels only move at a level-1 boundary; until then only the
+    // lowest level's slots can fire (cancelled ids make this early at worst)
+    int64_t boundary = (current_tick_ | (SLOTS - 1)) + 1;
+    int64_t tick = current_tick_ + 1;
+    while (tick < boundary && slots_[0][tick & (SLOTS - 1)].empty()) {
+        ++tick;
+    }
+    wakeup_tick_ = tick;
+    return tick * tick_ms_;
+}
+
+void TimerWheel::set_wakeup_hook(Callback hook) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wakeup_hook_ = hook;
+}
+
+size_t TimerWheel::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+} // namespace openclaw
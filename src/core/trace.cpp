@@ -0,0 +1,271 @@
+/*
+ * OpenClaw C++11 - Agent Turn Tracing Implementation
+ */
+#include <openclaw/core/trace.hpp>
+#include <openclaw/core/thread_pool.hpp>
+#include <openclaw/core/http_client.hpp>
+#include <openclaw/core/logger.hpp>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+namespace openclaw {
+
+namespace {
+
+std::string random_hex(size_t bytes) {
+    static thread_local std::mt19937_64 rng(std::random_device{}() ^
+        static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(bytes * 2);
+    uint64_t bits = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        if (i % 8 == 0) bits = rng();
+        unsigned char b = static_cast<unsigned char>(bits >> ((i % 8) * 8));
+        out += digits[b >> 4];
+        out += digits[b & 0xf];
+    }
+    return out;
+}
+
+double ms(int64_t us) {
+    return us / 1000.0;
+}
+
+Json otlp_attribute(const std::string& key, const std::string& value) {
+    Json a;
+    a["key"] = key;
+    a["value"]["stringValue"] = value;
+    return a;
+}
+
+Json otlp_attribute(const std::string& key, int64_t value) {
+    Json a;
+    a["key"] = key;
+    a["value"]["intValue"] = std::to_string(value);   // int64 is a string in OTLP/JSON
+    return a;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// AgentTrace
+// ============================================================================
+
+AgentTrace::AgentTrace() : origin_us_(0), origin_unix_us_(0), total_us_(0) {
+    start();
+}
+
+int64_t AgentTrace::clock_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AgentTrace::start() {
+    trace_id_ = random_hex(16);
+    origin_us_ = clock_us();
+    origin_unix_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    total_us_ = 0;
+    spans_.clear();
+}
+
+TraceSpan& AgentTrace::add(const std::string& kind, const std::string& name,
+                           int64_t begin_clock_us, int64_t end_clock_us) {
+    TraceSpan span;
+    span.kind = kind;
+    span.name = name;
+    span.start_us = begin_clock_us - origin_us_;
+    span.duration_us = end_clock_us > begin_clock_us ? end_clock_us - begin_clock_us : 0;
+    spans_.push_back(span);
+    return spans_.back();
+}
+
+void AgentTrace::finish() {
+    total_us_ = elapsed_us();
+}
+
+int64_t AgentTrace::total_us(const std::string& kind) const {
+    int64_t total = 0;
+    for (size_t i = 0; i < spans_.size(); ++i) {
+        if (spans_[i].kind == kind) total += spans_[i].duration_us;
+    }
+    return total;
+}
+
+std::string AgentTrace::summary() const {
+    // Tools can overlap each other and the AI call; their sum is wall time per tool
+    int64_t first_byte = -1;
+    for (size_t i = 0; i < spans_.size() && first_byte < 0; ++i) {
+        if (spans_[i].kind == "ai") first_byte = spans_[i].ttfb_us;
+    }
+    char ttfb[48] = "";
+    if (first_byte >= 0) {
+        snprintf(ttfb, sizeof(ttfb), " (first ttfb %.1fms)", ms(first_byte));
+    }
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "total %.1fms: queue %.1fms, ai %.1fms%s, tools %.1fms, parse %.2fms, format %.2fms",
+             ms(total_us_), ms(total_us("queue")), ms(total_us("ai")), ttfb,
+             ms(total_us("tool")), ms(total_us("parse")), ms(total_us("format")));
+    return buf;
+}
+
+std::string AgentTrace::to_json_lines(const std::string& session_key) const {
+    std::ostringstream oss;
+    for (size_t i = 0; i < spans_.size(); ++i) {
+        const TraceSpan& s = spans_[i];
+        Json line;
+        line["trace_id"] = trace_id_;
+        line["session"] = session_key;
+        line["kind"] = s.kind;
+        line["name"] = s.name;
+        line["iteration"] = s.iteration;
+        line["start_ms"] = ms(s.start_us);
+        line["duration_ms"] = ms(s.duration_us);
+        if (s.kind == "ai") {
+            if (s.ttfb_us >= 0) line["ttfb_ms"] = ms(s.ttfb_us);
+            line["input_tokens"] = s.input_tokens;
+            line["output_tokens"] = s.output_tokens;
+            line["cache_read_tokens"] = s.cache_read_tokens;
+        }
+        line["ok"] = s.ok;
+        if (!s.error.empty()) line["error"] = s.error;
+        oss << line.dump() << "\n";
+    }
+
+    Json turn;
+    turn["trace_id"] = trace_id_;
+    turn["session"] = session_key;
+    turn["kind"] = "turn";
+    turn["start_unix_ms"] = origin_unix_us_ / 1000;
+    turn["duration_ms"] = ms(total_us_);
+    turn["queue_ms"] = ms(total_us("queue"));
+    turn["ai_ms"] = ms(total_us("ai"));
+    turn["tool_ms"] = ms(total_us("tool"));
+    turn["parse_ms"] = ms(total_us("parse"));
+    turn["format_ms"] = ms(total_us("format"));
+    oss << turn.dump() << "\n";
+    return oss.str();
+}
+
+Json AgentTrace::to_otlp(const std::string& service_name, const std::string& session_key) const {
+    const int64_t unix_ns = origin_unix_us_ * 1000;
+    std::string root_id = random_hex(8);
+
+    // Queue wait happened before the trace origin; the root covers it too
+    int64_t root_start_us = 0;
+    for (size_t i = 0; i < spans_.size(); ++i) {
+        if (spans_[i].start_us < root_start_us) root_start_us = spans_[i].start_us;
+    }
+
+    Json spans = Json::array();
+
+    Json root;
+    root["traceId"] = trace_id_;
+    root["spanId"] = root_id;
+    root["name"] = "agent.turn";
+    root["kind"] = 1;   // SPAN_KIND_INTERNAL
+    root["startTimeUnixNano"] = std::to_string(unix_ns + root_start_us * 1000);
+    root["endTimeUnixNano"] = std::to_string(unix_ns + total_us_ * 1000);
+    root["attributes"] = Json::array();
+    root["attributes"].push_back(otlp_attribute("openclaw.session", session_key));
+    spans.push_back(root);
+
+    for (size_t i = 0; i < spans_.size(); ++i) {
+        const TraceSpan& s = spans_[i];
+        Json span;
+        span["traceId"] = trace_id_;
+        span["spanId"] = random_hex(8);
+        span["parentSpanId"] = root_id;
+        span["name"] = "agent." + s.kind + (s.name.empty() ? "" : " " + s.name);
+        span["kind"] = (s.kind == "ai") ? 3 : 1;    // SPAN_KIND_CLIENT for provider calls
+        span["startTimeUnixNano"] = std::to_string(unix_ns + s.start_us * 1000);
+        span["endTimeUnixNano"] = std::to_string(unix_ns + (s.start_us + s.duration_us) * 1000);
+
+        Json attrs = Json::array();
+        attrs.push_back(otlp_attribute("openclaw.iteration", static_cast<int64_t>(s.iteration)));
+        if (s.kind == "ai") {
+            attrs.push_back(otlp_attribute("gen_ai.request.model", s.name));
+            attrs.push_back(otlp_attribute("gen_ai.usage.input_tokens", static_cast<int64_t>(s.input_tokens)));
+            attrs.push_back(otlp_attribute("gen_ai.usage.output_tokens", static_cast<int64_t>(s.output_tokens)));
+            if (s.ttfb_us >= 0) attrs.push_back(otlp_attribute("openclaw.ttfb_us", s.ttfb_us));
+        } else if (s.kind == "tool") {
+            attrs.push_back(otlp_attribute("openclaw.tool", s.name));
+        }
+        span["attributes"] = attrs;
+
+        if (!s.ok) {
+            span["status"]["code"] = 2;     // STATUS_CODE_ERROR
+            span["status"]["message"] = s.error;
+        }
+        spans.push_back(span);
+    }
+
+    Json scope;
+    scope["scope"]["name"] = "openclaw.agent";
+    scope["spans"] = spans;
+
+    Json resource;
+    resource["resource"]["attributes"] = Json::array();
+    resource["resource"]["attributes"].push_back(otlp_attribute("service.name", service_name));
+    resource["scopeSpans"] = Json::array();
+    resource["scopeSpans"].push_back(scope);
+
+    Json request;
+    request["resourceSpans"] = Json::array();
+    request["resourceSpans"].push_back(resource);
+    return request;
+}
+
+// ============================================================================
+// TraceExporter
+// ============================================================================
+
+TraceExporter::TraceExporter(ThreadPool& pool) : pool_(pool) {}
+
+void TraceExporter::export_trace(const AgentTrace& trace, const std::string& session_key) {
+    if (!enabled()) return;
+
+    // Serialization and I/O happen on the LOW lane
+    AgentTrace copy = trace;
+    pool_.enqueue([this, copy, session_key] {
+        Json otlp;
+        bool need_otlp = !config_.otlp_endpoint.empty() || config_.format == "otlp";
+        if (need_otlp) {
+            otlp = copy.to_otlp(config_.service_name, session_key);
+        }
+
+        if (!config_.file.empty()) {
+            write_file(config_.format == "otlp" ? otlp.dump() + "\n" : copy.to_json_lines(session_key));
+        }
+
+        if (!config_.otlp_endpoint.empty()) {
+            HttpRequest request("POST", config_.otlp_endpoint, otlp.dump());
+            request.headers["Content-Type"] = "application/json";
+            request.timeout_ms = 5000;
+            std::string endpoint = config_.otlp_endpoint;
+            AsyncHttpEngine::instance().submit(request, [endpoint](const HttpResponse& response) {
+                if (!response.ok()) {
+                    LOG_DEBUG("[Trace] OTLP export to %s failed: %ld %s", endpoint.c_str(),
+                              response.status_code, response.error.c_str());
+                }
+            });
+        }
+    }, TaskPriority::LOW);
+}
+
+void TraceExporter::write_file(const std::string& text) {
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    std::ofstream out(config_.file.c_str(), std::ios::app);
+    if (!out) {
+        LOG_WARN("[Trace] Cannot open %s", config_.file.c_str());
+        return;
+    }
+    out << text;
+}
+
+} // namespace openclaw
@@ -0,0 +1,499 @@
+/*
+ * OpenClaw C++11 - Web Fetch Cache Implementation
+ */
+#include <openclaw/core/web_cache.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/logger.hpp>
+#include <curl/curl.h>
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdlib>
+#include <strings.h>
+
+namespace openclaw {
+
+namespace {
+
+// Header value by case-insensitive name; servers differ (HTTP/2 lowercases)
+std::string header(const HttpResponse& response, const char* name) {
+    for (std::map<std::string, std::string>::const_iterator it = response.headers.begin();
+         it != response.headers.end(); ++it) {
+        if (strcasecmp(it->first.c_str(), name) == 0) return it->second;
+    }
+    return std::string();
+}
+
+// Unix time of an HTTP date, -1 if absent or invalid
+int64_t http_date(const std::string& value) {
+    if (value.empty()) return -1;
+    return static_cast<int64_t>(curl_getdate(value.c_str(), nullptr));
+}
+
+// Until when a response may be served without asking the server; storable
+// is cleared for responses that must not be kept at all
+int64_t fresh_until(const HttpResponse& response, int64_t now, int64_t default_ttl, bool& storable) {
+    storable = trim(header(response, "Vary")) != "*";
+
+    bool no_cache = false;
+    int64_t max_age = -1;
+    std::vector<std::string> directives = split(to_lower(header(response, "Cache-Control")), ',');
+    for (size_t i = 0; i < directives.size(); ++i) {
+        std::string d = trim(directives[i]);
+        if (d == "no-store") {
+            storable = false;
+        } else if (d == "no-cache") {
+            no_cache = true;
+        } else if (starts_with(d, "max-age=")) {
+            max_age = std::atoll(d.c_str() + 8);
+        }
+    }
+    if (!storable || no_cache) return now;
+
+    if (max_age >= 0) {
+        int64_t age = std::atoll(header(response, "Age").c_str());
+        return now + std::max<int64_t>(0, max_age - age);
+    }
+
+    int64_t date = http_date(header(response, "Date"));
+    if (date < 0) date = now;
+    std::string expires = header(response, "Expires");
+    if (!expires.empty()) {
+        // An invalid Expires means already expired
+        int64_t t = http_date(expires);
+        return t < 0 ? now : now + std::max<int64_t>(0, t - date);
+    }
+
+    int64_t modified = http_date(header(response, "Last-Modified"));
+    if (modified >= 0) {
+        return now + std::min(default_ttl, std::max<int64_t>(0, (date - modified) / 10));
+    }
+    return now + default_ttl;
+}
+
+size_t entry_bytes(const std::string& key, const WebPage& page) {
+    // The body again: room for the text and links derived from it
+    return key.size() * 2 + page.url.size() + page.content_type.size() + page.etag.size() +
+           page.last_modified.size() + page.body.size() * 2 + 256;
+}
+
+std::string column_text(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    return text ? std::string(reinterpret_cast<const char*>(text)) : std::string();
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// WebPage
+// ============================================================================
+
+std::shared_ptr<const WebText> WebPage::text(size_t max_chars) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!text_ || (!text_->complete && text_->max_chars < max_chars)) {
+        std::shared_ptr<WebText> extracted = std::make_shared<WebText>();
+        extracted->max_chars = max_chars;
+        extracted->complete = html_text::extract(body, max_chars, extracted->text);
+        text_ = extracted;
+    }
+    return text_;
+}
+
+std::shared_ptr<const WebLinks> WebPage::links() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!links_) links_ = std::make_shared<const WebLinks>(html_text::links(body, url));
+    return links_;
+}
+
+// ============================================================================
+// WebCache
+// ============================================================================
+
+WebCache& WebCache::instance() {
+    static WebCache cache;
+    return cache;
+}
+
+WebCache::WebCache()
+    : bytes_(0)
+    , db_(nullptr)
+    , disk_stores_(0) {}
+
+WebCache::~WebCache() {
+    close();
+}
+
+bool WebCache::configure(const Config& config) {
+    close();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_ = config;
+        while (bytes_ > config_.memory_bytes && !lru_.empty()) {
+            bytes_ -= lru_.back().bytes;
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+            counters_.evictions++;
+        }
+    }
+
+    if (config.db_path.empty()) return true;
+
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (sqlite3_open(config.db_path.c_str(), &db_) != SQLITE_OK) {
+        LOG_ERROR("[WebCache] Cannot open %s: %s", config.db_path.c_str(),
+                  db_ ? sqlite3_errmsg(db_) : "out of memory");
+        sqlite3_close(db_);
+        db_ = nullptr;
+        return false;
+    }
+    sqlite3_exec(db_, "PRAGMA journal_mode=WAL", nullptr, nullptr, nullptr);
+    sqlite3_exec(db_, "PRAGMA synchronous=NORMAL", nullptr, nullptr, nullptr);
+    char* err = nullptr;
+    if (sqlite3_exec(db_,
+            "CREATE TABLE IF NOT EXISTS web_cache ("
+            "  key TEXT PRIMARY KEY,"
+            "  url TEXT NOT NULL,"
+            "  status INTEGER NOT NULL,"
+            "  content_type TEXT NOT NULL,"
+            "  etag TEXT NOT NULL,"
+            "  last_modified TEXT NOT NULL,"
+            "  body BLOB NOT NULL,"
+            "  fresh_until INTEGER NOT NULL,"
+            "  used INTEGER NOT NULL"
+            ");"
+            "CREATE INDEX IF NOT EXISTS idx_web_cache_used ON web_cache(used);",
+            nullptr, nullptr, &err) != SQLITE_OK) {
+        LOG_ERROR("[WebCache] Cannot create schema: %s", err ? err : "unknown");
+        sqlite3_free(err);
+        sqlite3_close(db_);
+        db_ = nullptr;
+        return false;
+    }
+
+    LOG_INFO("[WebCache] Disk tier at %s", config.db_path.c_str());
+    return true;
+}
+
+void WebCache::close() {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (db_) {
+        sqlite3_close(db_);
+        db_ = nullptr;
+    }
+}
+
+std::string WebCache::normalize_url(const std::string& url) {
+    size_t scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) return url;
+    std::string scheme = to_lower(url.substr(0, scheme_end));
+
+    size_t host_start = scheme_end + 3;
+    size_t host_end = url.find_first_of("/?#", host_start);
+    if (host_end == std::string::npos) host_end = url.size();
+
+    // Lowercase the host, not the user info before it
+    std::string authority = url.substr(host_start, host_end - host_start);
+    size_t at = authority.rfind('@');
+    size_t host_from = at == std::string::npos ? 0 : at + 1;
+    authority = authority.substr(0, host_from) + to_lower(authority.substr(host_from));
+    if ((scheme == "http" && ends_with(authority, ":80")) ||
+        (scheme == "https" && ends_with(authority, ":443"))) {
+        authority.erase(authority.rfind(':'));
+    }
+
+    std::string rest = url.substr(host_end);
+    size_t fragment = rest.find('#');
+    if (fragment != std::string::npos) rest.erase(fragment);
+    if (rest.empty() || rest[0] != '/') rest = "/" + rest;
+
+    return scheme + "://" + authority + rest;
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+std::shared_ptr<WebPage> WebCache::to_page(const std::string& url, const HttpResponse& response) {
+    std::shared_ptr<WebPage> page = std::make_shared<WebPage>();
+    page->url = url;
+    page->status_code = response.status_code;
+    page->content_type = header(response, "Content-Type");
+    page->etag = header(response, "ETag");
+    page->last_modified = header(response, "Last-Modified");
+    page->body = response.body;
+    return page;
+}
+
+bool WebCache::begin(const std::string& key, WebFetchResult& hit, std::shared_ptr<Entry>& cached,
+                     std::map<std::string, std::string>& headers) {
+    Entry entry;
+    bool from_disk = false;
+    if (!lookup(key, entry, from_disk)) return false;
+
+    if (entry.fresh_until > current_timestamp()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (from_disk) counters_.disk_hits++;
+        else counters_.memory_hits++;
+        hit.page = entry.page;
+        hit.cache = "hit";
+        return true;
+    }
+
+    if (!entry.page->etag.empty()) headers["If-None-Match"] = entry.page->etag;
+    if (!entry.page->last_modified.empty()) headers["If-Modified-Since"] = entry.page->last_modified;
+    cached = std::make_shared<Entry>(entry);
+    return false;
+}
+
+WebFetchResult WebCache::get(HttpClient& http, const std::string& url,
+                             const std::map<std::string, std::string>& headers) {
+    std::string key = normalize_url(url);
+    WebFetchResult result;
+    std::shared_ptr<Entry> cached;
+    std::map<std::string, std::string> request_headers = headers;
+    if (begin(key, result, cached, request_headers)) return result;
+
+    HttpResponse response = http.get(url, request_headers);
+    return finish(key, cached.get(), url, response);
+}
+
+void WebCache::get_async(HttpClient& http, const std::string& url,
+                         const std::map<std::string, std::string>& headers, WebFetchCallback on_done) {
+    std::string key = normalize_url(url);
+    WebFetchResult result;
+    std::shared_ptr<Entry> cached;
+    std::map<std::string, std::string> request_headers = headers;
+    if (begin(key, result, cached, request_headers)) {
+        on_done(result);
+        return;
+    }
+
+    http.get_async(url, request_headers, [this, key, cached, url, on_done](const HttpResponse& response) {
+        on_done(finish(key, cached.get(), url, response));
+    });
+}
+
+WebFetchResult WebCache::finish(const std::string& key, const Entry* cached,
+                                const std::string& url, const HttpResponse& response) {
+    int64_t now = current_timestamp();
+    bool storable = true;
+    int64_t fresh = fresh_until(response, now, config_.default_ttl_seconds, storable);
+
+    WebFetchResult result;
+    if (cached && response.status_code == 304) {
+        set_fresh_until(key, fresh);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            counters_.revalidated++;
+        }
+        result.page = cached->page;
+        result.cache = "revalidated";
+        return result;
+    }
+
+    std::shared_ptr<WebPage> page = to_page(url, response);
+    result.page = page;
+    result.cache = "miss";
+
+    bool ok = response.status_code >= 200 && response.status_code < 300;
+    Entry entry;
+    entry.key = key;
+    entry.page = page;
+    entry.fresh_until = fresh;
+    entry.bytes = entry_bytes(key, *page);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counters_.misses++;
+        if (ok && storable && page->body.size() <= config_.max_body_bytes) {
+            counters_.stores++;
+            insert_locked(entry);
+        } else {
+            storable = false;
+        }
+    }
+    if (storable) disk_store(entry);
+    return result;
+}
+
+// ============================================================================
+// Memory tier
+// ============================================================================
+
+bool WebCache::lookup(const std::string& key, Entry& out, bool& from_disk) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::unordered_map<std::string, Lru::iterator>::iterator it = index_.find(key);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            out = *it->second;
+            from_disk = false;
+            return true;
+        }
+    }
+
+    if (!disk_lookup(key, out)) return false;
+    from_disk = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert_locked(out);
+    return true;
+}
+
+void WebCache::insert_locked(const Entry& entry) {
+    if (entry.bytes > config_.memory_bytes) return;
+
+    std::unordered_map<std::string, Lru::iterator>::iterator it = index_.find(entry.key);
+    if (it != index_.end()) {
+        bytes_ -= it->second->bytes;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    lru_.push_front(entry);
+    index_[entry.key] = lru_.begin();
+    bytes_ += entry.bytes;
+
+    while (bytes_ > config_.memory_bytes && !lru_.empty()) {
+        bytes_ -= lru_.back().bytes;
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+        counters_.evictions++;
+    }
+}
+
+void WebCache::set_fresh_until(const std::string& key, int64_t fresh_until) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::unordered_map<std::string, Lru::iterator>::iterator it = index_.find(key);
+        if (it != index_.end()) it->second->fresh_until = fresh_until;
+    }
+    disk_touch(key, fresh_until);
+}
+
+void WebCache::clear() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (db_) sqlite3_exec(db_, "DELETE FROM web_cache", nullptr, nullptr, nullptr);
+}
+
+WebCache::Stats WebCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = counters_;
+    s.entries = lru_.size();
+    s.bytes = bytes_;
+    return s;
+}
+
+// ============================================================================
+// Disk tier
+// ============================================================================
+
+bool WebCache::disk_lookup(const std::string& key, Entry& out) {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!db_) return false;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_,
+            "SELECT url, status, content_type, etag, last_modified, body, fresh_until "
+            "FROM web_cache WHERE key = ?", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        std::shared_ptr<WebPage> page = std::make_shared<WebPage>();
+        page->url = column_text(stmt, 0);
+        page->status_code = static_cast<long>(sqlite3_column_int64(stmt, 1));
+        page->content_type = column_text(stmt, 2);
+        page->etag = column_text(stmt, 3);
+        page->last_modified = column_text(stmt, 4);
+        const void* body = sqlite3_column_blob(stmt, 5);
+        if (body) page->body.assign(static_cast<const char*>(body), sqlite3_column_bytes(stmt, 5));
+        out.key = key;
+        out.page = page;
+        out.fresh_until = sqlite3_column_int64(stmt, 6);
+        out.bytes = entry_bytes(key, *page);
+        found = true;
+    }
+    sqlite3_finalize(stmt);
+
+    if (found && sqlite3_prepare_v2(db_, "UPDATE web_cache SET used = ? WHERE key = ?",
+                                    -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, current_timestamp());
+        sqlite3_bind_text(stmt, 2, key.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    return found;
+}
+
+void WebCache::disk_store(const Entry& entry) {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!db_) return;
+
+    const WebPage& page = *entry.page;
+    int64_t now = current_timestamp();
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_,
+            "INSERT OR REPLACE INTO web_cache "
+            "(key, url, status, content_type, etag, last_modified, body, fresh_until, used) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)", -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_WARN("[WebCache] Cannot store: %s", sqlite3_errmsg(db_));
+        return;
+    }
+    sqlite3_bind_text(stmt, 1, entry.key.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, page.url.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 3, page.status_code);
+    sqlite3_bind_text(stmt, 4, page.content_type.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 5, page.etag.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 6, page.last_modified.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_blob(stmt, 7, page.body.data(), static_cast<int>(page.body.size()), SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 8, entry.fresh_until);
+    sqlite3_bind_int64(stmt, 9, now);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        LOG_WARN("[WebCache] Cannot store: %s", sqlite3_errmsg(db_));
+    }
+    sqlite3_finalize(stmt);
+
+    // Now and then drop stale rows that cannot be revalidated, and the
+    // least recently used ones past the cap
+    if (++disk_stores_ % 64 != 0) return;
+    if (sqlite3_prepare_v2(db_,
+            "DELETE FROM web_cache WHERE fresh_until < ? AND etag = '' AND last_modified = ''",
+            -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, now);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+    if (config_.max_disk_entries > 0 &&
+        sqlite3_prepare_v2(db_,
+            "DELETE FROM web_cache WHERE key IN ("
+            "  SELECT key FROM web_cache ORDER BY used DESC LIMIT -1 OFFSET ?)",
+            -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, static_cast<int64_t>(config_.max_disk_entries));
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+}
+
+void WebCache::disk_touch(const std::string& key, int64_t fresh_until) {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    if (!db_) return;
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "UPDATE web_cache SET fresh_until = ?, used = ? WHERE key = ?",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    sqlite3_bind_int64(stmt, 1, fresh_until);
+    sqlite3_bind_int64(stmt, 2, current_timestamp());
+    sqlite3_bind_text(stmt, 3, key.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+}
+
+} // namespace openclaw
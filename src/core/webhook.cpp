@@ -0,0 +1,255 @@
+/*
+ * OpenClaw C++11 - Webhook Routing Implementation
+ */
+#include <openclaw/core/webhook.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/core/utils.hpp>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace openclaw {
+
+namespace {
+
+// Upper bound on one accept wait, so stop() is noticed promptly
+const int accept_wait_ms = 250;
+
+// A peer gets this long per read before the connection is dropped
+const int read_timeout_ms = 5000;
+
+const size_t max_header_bytes = 16 * 1024;
+const size_t max_body_bytes = 4 * 1024 * 1024;
+
+const char* status_text(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 503: return "Service Unavailable";
+    default: return "Error";
+    }
+}
+
+void send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+void respond(int fd, const WebhookResponse& response) {
+    std::string out = "HTTP/1.1 " + std::to_string(response.status) + " " +
+                      status_text(response.status) + "\r\n";
+    out += "Content-Type: text/plain\r\n";
+    out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    out += "Connection: close\r\n\r\n";
+    out += response.body;
+    send_all(fd, out);
+}
+
+// Append what the peer sends to buf; false on EOF, error or timeout
+bool read_more(int fd, std::string& buf) {
+    char chunk[8192];
+    for (;;) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            buf.append(chunk, static_cast<size_t>(n));
+            return true;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        return false;
+    }
+}
+
+}
+
+// ============================================================================
+// WebhookRouter
+// ============================================================================
+
+WebhookRouter& WebhookRouter::instance() {
+    static WebhookRouter router;
+    return router;
+}
+
+void WebhookRouter::add(const std::string& name, Handler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handlers_[name] = handler;
+}
+
+void WebhookRouter::remove(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handlers_.erase(name);
+}
+
+WebhookResponse WebhookRouter::dispatch(const WebhookRequest& request) const {
+    Handler handler;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, Handler>::const_iterator it = handlers_.find(request.name);
+        if (it == handlers_.end()) return WebhookResponse(404, "Not Found");
+        handler = it->second;
+    }
+    return handler(request);
+}
+
+// ============================================================================
+// WebhookServer
+// ============================================================================
+
+WebhookServer::WebhookServer()
+    : listen_fd_(-1)
+    , stop_(false) {
+}
+
+WebhookServer::~WebhookServer() {
+    stop();
+}
+
+bool WebhookServer::start(const std::string& bind_host, int port) {
+    if (running()) return true;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    struct addrinfo* addrs = nullptr;
+    std::string port_str = std::to_string(port);
+    if (getaddrinfo(bind_host.empty() ? nullptr : bind_host.c_str(), port_str.c_str(), &hints, &addrs) != 0) {
+        LOG_ERROR("[Webhook] Cannot resolve bind address %s", bind_host.c_str());
+        return false;
+    }
+
+    for (struct addrinfo* ai = addrs; ai && listen_fd_ < 0; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 64) == 0) {
+            listen_fd_ = fd;
+        } else {
+            close(fd);
+        }
+    }
+    freeaddrinfo(addrs);
+
+    if (listen_fd_ < 0) {
+        LOG_ERROR("[Webhook] Cannot listen on %s:%d: %s", bind_host.c_str(), port, strerror(errno));
+        return false;
+    }
+
+    stop_ = false;
+    thread_ = std::thread(&WebhookServer::run, this);
+    LOG_INFO("[Webhook] Listening on %s:%d", bind_host.c_str(), port);
+    return true;
+}
+
+void WebhookServer::stop() {
+    if (thread_.joinable()) {
+        stop_ = true;
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void WebhookServer::run() {
+    while (!stop_) {
+        struct pollfd pfd;
+        pfd.fd = listen_fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, accept_wait_ms) <= 0) continue;
+
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        struct timeval tv;
+        tv.tv_sec = read_timeout_ms / 1000;
+        tv.tv_usec = (read_timeout_ms % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        serve(fd);
+        close(fd);
+    }
+}
+
+void WebhookServer::serve(int fd) {
+    std::string buf;
+    size_t header_end;
+    while ((header_end = buf.find("\r\n\r\n")) == std::string::npos) {
+        if (buf.size() > max_header_bytes) return respond(fd, WebhookResponse(413, "Headers too large"));
+        if (!read_more(fd, buf)) return;
+    }
+
+    // Request line: METHOD SP target SP version
+    size_t line_end = buf.find("\r\n");
+    std::string request_line = buf.substr(0, line_end);
+    size_t sp1 = request_line.find(' ');
+    size_t sp2 = request_line.find(' ', sp1 == std::string::npos ? 0 : sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) {
+        return respond(fd, WebhookResponse(400, "Bad request line"));
+    }
+    std::string method = request_line.substr(0, sp1);
+    std::string target = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+    size_t query = target.find('?');
+    if (query != std::string::npos) target.resize(query);
+
+    WebhookRequest request;
+    size_t pos = line_end + 2;
+    while (pos < header_end) {
+        size_t eol = buf.find("\r\n", pos);
+        std::string line = buf.substr(pos, eol - pos);
+        pos = eol + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        request.headers[to_lower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+    }
+
+    std::string prefix = WebhookRouter::path_prefix();
+    if (!starts_with(target, prefix) || target.size() == prefix.size()) {
+        return respond(fd, WebhookResponse(404, "Not Found"));
+    }
+    if (method != "POST") return respond(fd, WebhookResponse(405, "POST only"));
+    request.name = target.substr(prefix.size());
+
+    if (!request.header("transfer-encoding").empty()) {
+        return respond(fd, WebhookResponse(400, "Chunked bodies are not supported"));
+    }
+    size_t length = static_cast<size_t>(std::strtoull(request.header("content-length").c_str(), nullptr, 10));
+    if (length > max_body_bytes) return respond(fd, WebhookResponse(413, "Body too large"));
+
+    request.body = buf.substr(header_end + 4);
+    while (request.body.size() < length) {
+        if (!read_more(fd, request.body)) return;
+    }
+    request.body.resize(length);
+
+    respond(fd, WebhookRouter::instance().dispatch(request));
+}
+
+} // namespace openclaw
@@ -0,0 +1,127 @@
+/*
+ * OpenClaw C++11 - Memory Embedder Implementation
+ */
+#include <openclaw/memory/embedder.hpp>
+#include <openclaw/core/http_client.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace openclaw {
+
+namespace {
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// A number array, or llama.cpp's [[...]] for pooled output
+bool read_vector(const Json& value, std::vector<float>& out) {
+    const Json* v = &value;
+    if (v->is_array() && !v->empty() && (*v)[0].is_array()) v = &(*v)[0];
+    if (!v->is_array() || v->empty()) return false;
+    out.clear();
+    out.reserve(v->size());
+    for (size_t i = 0; i < v->size(); ++i) {
+        if (!(*v)[i].is_number()) return false;
+        out.push_back((*v)[i].get<float>());
+    }
+    return true;
+}
+
+}
+
+Embedder::Embedder(const EmbeddingConfig& config)
+    : config_(config)
+    , native_(ends_with(config.url, "/embedding")) {
+    if (config_.batch_size < 1) config_.batch_size = 1;
+}
+
+std::string Embedder::model_tag() const {
+    return config_.model.empty() ? config_.url : config_.model;
+}
+
+void Embedder::normalize(std::vector<float>& v) {
+    double sum = 0;
+    for (size_t i = 0; i < v.size(); ++i) sum += static_cast<double>(v[i]) * v[i];
+    if (sum <= 0) return;
+    float scale = static_cast<float>(1.0 / std::sqrt(sum));
+    for (size_t i = 0; i < v.size(); ++i) v[i] *= scale;
+}
+
+bool Embedder::embed(const std::vector<std::string>& texts,
+                     std::vector<std::vector<float> >& out,
+                     std::string& error) const {
+    out.assign(texts.size(), std::vector<float>());
+    size_t batch = static_cast<size_t>(config_.batch_size);
+    for (size_t begin = 0; begin < texts.size(); begin += batch) {
+        size_t end = std::min(texts.size(), begin + batch);
+        if (!embed_batch(texts, begin, end, out, error)) return false;
+    }
+    return true;
+}
+
+bool Embedder::embed_one(const std::string& text, std::vector<float>& out, std::string& error) const {
+    std::vector<std::string> texts(1, text);
+    std::vector<std::vector<float> > vectors;
+    if (!embed(texts, vectors, error)) return false;
+    out.swap(vectors[0]);
+    return true;
+}
+
+bool Embedder::embed_batch(const std::vector<std::string>& texts, size_t begin, size_t end,
+                           std::vector<std::vector<float> >& out, std::string& error) const {
+    Json input = Json::array();
+    for (size_t i = begin; i < end; ++i) input.push_back(texts[i]);
+
+    Json body = Json::object();
+    if (native_) {
+        body["content"] = input;
+    } else {
+        body["input"] = input;
+        if (!config_.model.empty()) body["model"] = config_.model;
+    }
+
+    std::map<std::string, std::string> headers;
+    if (!config_.api_key.empty()) {
+        headers["Authorization"] = "Bearer " + config_.api_key;
+    }
+
+    HttpClient http;
+    http.set_timeout(config_.timeout_ms);
+    HttpResponse response = http.post_json(config_.url, body, headers);
+    if (!response.ok()) {
+        error = "Embedding request failed (HTTP " + std::to_string(response.status_code) + ")";
+        if (!response.error.empty()) error += ": " + response.error;
+        return false;
+    }
+
+    // OpenAI: {"data": [{"index", "embedding"}]}; llama.cpp: [{"index", "embedding"}]
+    Json resp = response.json();
+    const Json* items = &resp;
+    if (resp.is_object() && resp.contains("data")) items = &resp["data"];
+    if (resp.is_object() && resp.contains("embedding")) {
+        Json wrapped = Json::array();
+        wrapped.push_back(resp);
+        resp = wrapped;
+        items = &resp;
+    }
+    if (!items->is_array() || items->size() != end - begin) {
+        error = "Embedding response has no vector per input";
+        return false;
+    }
+
+    for (size_t i = 0; i < items->size(); ++i) {
+        const Json& item = (*items)[i];
+        size_t index = item.is_object() && item.contains("index") && item["index"].is_number()
+            ? item["index"].get<size_t>() : i;
+        if (index >= end - begin || !item.is_object() || !item.contains("embedding") ||
+            !read_vector(item["embedding"], out[begin + index])) {
+            error = "Malformed embedding in response";
+            return false;
+        }
+        normalize(out[begin + index]);
+    }
+    return true;
+}
+
+} // namespace openclaw
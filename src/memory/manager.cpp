@@ -2,21 +2,98 @@
  * OpenClaw C++11 - Memory Manager Implementation
  */
 #include <openclaw/memory/manager.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/json.hpp>
+#include <openclaw/core/metrics.hpp>
+#include <openclaw/core/file_view.hpp>
 #include <fstream>
 #include <sstream>
 #include <ctime>
 #include <cstdlib>
-#include <iomanip>
+#include <algorithm>
+#include <set>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
 #include <sys/stat.h>
 #include <dirent.h>
 #include <openssl/sha.h>
 
 namespace openclaw {
 
+namespace {
+
+// Files indexed per transaction during a sync
+const size_t sync_batch_files = 256;
+
+// Below this, a sync reads and chunks on the calling thread
+const size_t parallel_sync_min_files = 8;
+
+int64_t stat_mtime_ms(const struct stat& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+}
+
+// Transcripts are append-only between rewrites (which replace the inode).
+// Their files row keeps the offset indexed so far as size and a hash of the
+// bytes just before it as hash, so an append is recognised from a small read.
+const size_t session_anchor_bytes = 4096;
+
+std::string session_anchor(const std::string& data, size_t end) {
+    size_t begin = end > session_anchor_bytes ? end - session_anchor_bytes : 0;
+    return xxh64_hex(data.substr(begin, end - begin));
+}
+
+bool read_from(const std::string& path, size_t offset, std::string& out) {
+    std::ifstream f(path.c_str(), std::ios::binary);
+    if (!f || !f.seekg(static_cast<std::streamoff>(offset))) return false;
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Message text of a transcript record: this tree's {"role", "content"} lines
+// and the {"message": {...}} envelope with content blocks
+std::string record_text(const Json& record, std::string& role) {
+    const Json* msg = &record;
+    if (record.contains("message") && record["message"].is_object()) msg = &record["message"];
+    if (!msg->contains("role") || !(*msg)["role"].is_string()) return "";
+    role = (*msg)["role"].get<std::string>();
+    if (!msg->contains("content")) return "";
+    
+    const Json& content = (*msg)["content"];
+    if (content.is_string()) return content.get<std::string>();
+    
+    std::string text;
+    if (content.is_array()) {
+        for (size_t i = 0; i < content.size(); ++i) {
+            const Json& block = content[i];
+            if (!block.is_object() || block.value("type", "") != "text" ||
+                !block.contains("text") || !block["text"].is_string()) continue;
+            if (!text.empty()) text += "\n";
+            text += block["text"].get<std::string>();
+        }
+    }
+    return text;
+}
+
+// Same mtime, size and inode as when indexed: skip reading the file at all
+bool stat_unchanged(const MemoryFile& stored, int64_t mtime, int64_t size, int64_t inode) {
+    return stored.inode != 0 && stored.inode == inode &&
+           stored.mtime == mtime && stored.size == size;
+}
+
+}
+
 MemoryManager::MemoryManager(const MemoryConfig& config)
     : config_(config)
     , store_(new MemoryStore())
+    , vectors_dirty_(false)
+    , vectors_saved_at_(0)
+    , embed_retry_at_(0)
     , initialized_(false)
+    , dirty_(false)
+    , sessions_dirty_(false)
 {
 }
 
@@ -49,7 +126,7 @@ bool MemoryManager::initialize() {
     }
     
     // Open database
-    if (!store_->open(db_path)) {
+    if (!store_->open(db_path, config_.read_connections)) {
         set_error("Failed to open database: " + store_->last_error());
         return false;
     }
@@ -60,11 +137,37 @@ bool MemoryManager::initialize() {
         return false;
     }
     
+    // Vector index: load the snapshot, then catch up with the chunk table
+    if (config_.embedding.enabled()) {
+        embedder_.reset(new Embedder(config_.embedding));
+        vectors_path_ = db_path + ".vectors";
+        vectors_.load(vectors_path_, embedder_->model_tag());
+        vectors_saved_at_ = get_current_timestamp();
+        reconcile_vectors();
+    }
+    
     initialized_ = true;
+    if (config_.watch_enabled) start_watching();
     return true;
 }
 
 void MemoryManager::shutdown() {
+    // The watcher thread syncs under the lock, so it is stopped first
+    if (watcher_) {
+        watcher_->stop();
+        watcher_.reset();
+    }
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        TimerWheel::instance().cancel_all(this);
+        armed_tasks_.clear();
+        task_callback_ = TaskCallback();
+    }
+    
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (initialized_ && embedder_) {
+        save_vectors(true);
+    }
     if (store_) {
         store_->close();
     }
@@ -76,29 +179,63 @@ bool MemoryManager::is_initialized() const {
 }
 
 bool MemoryManager::sync() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (!initialized_) {
         set_error("Memory manager not initialized");
         return false;
     }
     
-    // Discover memory files
-    std::vector<MemoryFile> files = discover_memory_files();
+    static Histogram& sync_seconds = Metrics::instance().histogram(
+        "openclaw_memory_sync_seconds", "Full memory index sync duration", Metrics::latency_buckets());
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    
+    // Workers stat, read, hash and chunk; this thread is the only one
+    // writing to SQLite, committing in batches as results come in
+    std::vector<std::string> files = discover_memory_files();
     std::vector<std::string> active_paths;
     
-    for (const auto& file : files) {
-        active_paths.push_back(file.path);
-        
-        // Check if file has changed
-        MemoryFile existing;
-        bool exists = store_->get_file(file.path, MemorySource::MEMORY, existing);
+    std::map<std::string, MemoryFile> stored;
+    std::vector<MemoryFile> known = store_->list_files(MemorySource::MEMORY);
+    for (size_t i = 0; i < known.size(); ++i) stored[known[i].path] = known[i];
+    
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    std::deque<PreparedFile> ready;
+    bool parallel = files.size() >= parallel_sync_min_files;
+    size_t max_in_flight = parallel ? 4 * index_pool().size() : 1;
+    size_t next = 0;
+    
+    store_->begin();
+    size_t indexed = 0;
+    
+    for (size_t done = 0; done < files.size(); ++done) {
+        // Bounded look-ahead keeps the chunked text in memory small
+        for (; next < files.size() && next - done < max_in_flight; ++next) {
+            if (!parallel) {
+                ready.push_back(prepare_file(files[next], stored));
+                continue;
+            }
+            const std::string& path = files[next];
+            index_pool().enqueue([this, &path, &stored, &mutex, &ready_cv, &ready] {
+                PreparedFile prepared = prepare_file(path, stored);
+                std::lock_guard<std::mutex> lock(mutex);
+                ready.push_back(std::move(prepared));
+                ready_cv.notify_one();
+            });
+        }
         
-        if (exists && existing.hash == file.hash) {
-            continue;  // File unchanged
+        PreparedFile prepared;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready_cv.wait(lock, [&ready] { return !ready.empty(); });
+            prepared = std::move(ready.front());
+            ready.pop_front();
         }
         
-        // Index the file
-        if (!index_file(file)) {
-            // Log error but continue with other files
+        active_paths.push_back(prepared.file.path);
+        if (write_prepared(prepared) && ++indexed % sync_batch_files == 0) {
+            store_->commit();
+            store_->begin();
         }
     }
     
@@ -108,10 +245,107 @@ bool MemoryManager::sync() {
         store_->delete_chunks_for_file(path, MemorySource::MEMORY);
         store_->delete_file(path, MemorySource::MEMORY);
     }
+    store_->commit();
+    
+    reconcile_vectors();
+    sync_seconds.observe_us(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started).count());
+    return true;
+}
+
+bool MemoryManager::write_prepared(const PreparedFile& prepared) {
+    if (prepared.state == PreparedFile::UNCHANGED) return false;
+    if (prepared.state == PreparedFile::TOUCHED) {
+        store_->upsert_file(prepared.file);
+        return false;
+    }
+    
+    // Replace the file's chunks and record in one savepoint
+    if (!store_->replace_file(prepared.file, prepared.chunks)) {
+        // Log error but continue with other files
+    }
+    return true;
+}
+
+bool MemoryManager::sync_memory_paths(const std::vector<std::string>& abs_paths) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!initialized_) return false;
+    
+    store_->begin();
+    for (size_t i = 0; i < abs_paths.size(); ++i) {
+        MemoryFile file = build_file_entry(abs_paths[i]);
+        struct stat st;
+        if (stat(abs_paths[i].c_str(), &st) != 0) {
+            store_->delete_chunks_for_file(file.path, MemorySource::MEMORY);
+            store_->delete_file(file.path, MemorySource::MEMORY);
+            continue;
+        }
+        
+        std::map<std::string, MemoryFile> stored;
+        MemoryFile existing;
+        if (store_->get_file(file.path, MemorySource::MEMORY, existing)) stored[file.path] = existing;
+        write_prepared(prepare_file(abs_paths[i], stored));
+    }
+    store_->commit();
     
+    reconcile_vectors();
     return true;
 }
 
+void MemoryManager::start_watching() {
+    std::vector<std::string> dirs;
+    dirs.push_back(config_.workspace_dir);              // MEMORY.md
+    dirs.push_back(config_.workspace_dir + "/memory");
+    if (config_.has_source("sessions")) dirs.push_back(resolve_session_transcripts_dir());
+    
+    watcher_.reset(new FileWatcher());
+    if (!watcher_->start(dirs, config_.watch_debounce_ms,
+                         [this](const std::set<std::string>& paths, bool overflow) {
+                             on_files_changed(paths, overflow);
+                         })) {
+        watcher_.reset();   // No watcher on this platform; explicit syncs only
+    }
+}
+
+void MemoryManager::on_files_changed(const std::set<std::string>& paths, bool overflow) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!initialized_) return;
+    
+    std::string memory_dir = config_.workspace_dir + "/memory";
+    std::string sessions_dir = resolve_session_transcripts_dir();
+    bool sessions = config_.has_source("sessions");
+    
+    // Lost events, or a whole directory (re)appeared: walk it once
+    bool walk_memory = overflow || paths.count(memory_dir) > 0 || paths.count(config_.workspace_dir) > 0;
+    bool walk_sessions = sessions && (overflow || paths.count(sessions_dir) > 0);
+    
+    std::vector<std::string> memory_files;
+    std::vector<std::string> session_files;
+    for (std::set<std::string>::const_iterator it = paths.begin(); it != paths.end(); ++it) {
+        const std::string& path = *it;
+        std::string dir = path.substr(0, path.rfind('/'));
+        if (dir == sessions_dir) {
+            if (sessions && path.size() > 6 && path.compare(path.size() - 6, 6, ".jsonl") == 0) {
+                session_files.push_back(path);
+            }
+        } else if ((dir == memory_dir || dir == config_.workspace_dir) &&
+                   is_memory_path(session_path_for_file(path))) {
+            memory_files.push_back(path);
+        }
+    }
+    
+    if (walk_memory) {
+        sync();
+    } else if (!memory_files.empty()) {
+        sync_memory_paths(memory_files);
+    }
+    if (walk_sessions) {
+        sync_session_files();
+    } else if (!session_files.empty()) {
+        sync_session_paths(session_files);
+    }
+}
+
 bool MemoryManager::save_memory(const std::string& content, const std::string& filename) {
     std::string target = filename.empty() ? "MEMORY.md" : filename;
     std::string full_path = config_.workspace_dir + "/" + target;
@@ -125,8 +359,8 @@ bool MemoryManager::save_memory(const std::string& content, const std::string& f
     file << content;
     file.close();
     
-    // Trigger sync to index the new content
-    return sync();
+    // Index just the file that was written
+    return sync_memory_paths(std::vector<std::string>(1, full_path));
 }
 
 bool MemoryManager::save_daily_memory(const std::string& content) {
@@ -170,10 +404,11 @@ bool MemoryManager::append_to_memory(const std::string& content, const std::stri
     file << "\n" << content;
     file.close();
     
-    return sync();
+    return sync_memory_paths(std::vector<std::string>(1, full_path));
 }
 
 std::vector<std::string> MemoryManager::list_memory_files() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     std::vector<std::string> result;
     std::vector<MemoryFile> files = store_->list_files(MemorySource::MEMORY);
     for (const auto& f : files) {
@@ -188,18 +423,162 @@ std::vector<MemorySearchResult> MemoryManager::search(const std::string& query)
 
 std::vector<MemorySearchResult> MemoryManager::search(const std::string& query, 
                                                        const MemorySearchConfig& config) {
+    // With a read pool, searches run alongside syncs and each other
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::defer_lock);
+    if (!store_->has_read_pool()) lock.lock();
     if (!initialized_) {
         return std::vector<MemorySearchResult>();
     }
+    if (embedder_ && config.hybrid_enabled && config.vector_weight > 0 && vectors_.size() > 0) {
+        return hybrid_search(query, config);
+    }
     return store_->search(query, config);
 }
 
+std::vector<MemorySearchResult> MemoryManager::hybrid_search(const std::string& query,
+                                                             const MemorySearchConfig& config) {
+    // Both rankers look deeper than the final cut so fusion has overlap to work with
+    size_t depth = static_cast<size_t>(std::max(config.max_results * 4, 20));
+    MemorySearchConfig wide = config;
+    wide.max_results = static_cast<int>(depth);
+    wide.min_score = 0;
+    std::vector<MemorySearchResult> keyword = store_->search(query, wide);
+    
+    std::vector<float> query_vec;
+    std::string error;
+    if (!embedder_->embed_one(query, query_vec, error)) {
+        set_error(error);
+        std::vector<MemorySearchResult> results;
+        for (size_t i = 0; i < keyword.size() && results.size() < static_cast<size_t>(config.max_results); ++i) {
+            if (keyword[i].score >= config.min_score) results.push_back(keyword[i]);
+        }
+        return results;
+    }
+    std::vector<VectorIndex::Hit> hits = vectors_.search(query_vec, depth,
+                                                         static_cast<size_t>(config_.embedding.nprobe));
+    
+    // Reciprocal-rank fusion: sum of weight / (k + rank) over the rankers
+    double k = config.rrf_k > 0 ? config.rrf_k : 60;
+    std::map<std::string, double> fused;
+    std::map<std::string, MemorySearchResult> found;
+    for (size_t i = 0; i < keyword.size(); ++i) {
+        if (keyword[i].chunk_id.empty()) continue;
+        fused[keyword[i].chunk_id] += config.bm25_weight / (k + i + 1);
+        found[keyword[i].chunk_id] = keyword[i];
+    }
+    std::vector<std::string> missing;
+    for (size_t i = 0; i < hits.size(); ++i) {
+        if (hits[i].second <= 0) break;     // Unrelated; best first, so the rest are too
+        fused[hits[i].first] += config.vector_weight / (k + i + 1);
+        if (!found.count(hits[i].first)) missing.push_back(hits[i].first);
+    }
+    std::vector<MemoryChunk> chunks = store_->get_chunks(missing);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        MemorySearchResult r;
+        r.chunk_id = chunks[i].id;
+        r.path = chunks[i].path;
+        r.source = chunks[i].source;
+        r.start_line = chunks[i].start_line;
+        r.end_line = chunks[i].end_line;
+        r.snippet = MemoryStore::excerpt(chunks[i].text, query, config);
+        found[r.chunk_id] = r;
+    }
+    
+    std::vector<std::pair<double, std::string> > ranked;
+    for (std::map<std::string, double>::const_iterator it = fused.begin(); it != fused.end(); ++it) {
+        if (found.count(it->first)) ranked.push_back(std::make_pair(it->second, it->first));
+    }
+    std::sort(ranked.begin(), ranked.end(), std::greater<std::pair<double, std::string> >());
+    
+    // 1.0 = ranked first by every ranker
+    double best = (config.bm25_weight + config.vector_weight) / (k + 1);
+    std::vector<MemorySearchResult> results;
+    for (size_t i = 0; i < ranked.size() && results.size() < static_cast<size_t>(config.max_results); ++i) {
+        MemorySearchResult r = found[ranked[i].second];
+        r.score = best > 0 ? ranked[i].first / best : 0;
+        if (r.score >= config.min_score) results.push_back(r);
+    }
+    return results;
+}
+
+void MemoryManager::reconcile_vectors() {
+    if (!embedder_) return;
+    
+    std::vector<std::pair<std::string, std::string> > chunks = store_->list_chunk_hashes();
+    std::set<std::string> live;
+    std::vector<std::string> missing;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        live.insert(chunks[i].first);
+        if (!vectors_.contains(chunks[i].first)) missing.push_back(chunks[i].first);
+    }
+    
+    std::vector<std::string> indexed = vectors_.ids();
+    for (size_t i = 0; i < indexed.size(); ++i) {
+        if (!live.count(indexed[i])) {
+            vectors_.remove(indexed[i]);
+            vectors_dirty_ = true;
+        }
+    }
+    
+    if (!missing.empty()) {
+        embed_chunks(store_->get_chunks(missing));
+        store_->prune_embeddings();
+    }
+    save_vectors(false);
+}
+
+void MemoryManager::embed_chunks(const std::vector<MemoryChunk>& chunks) {
+    std::string model = embedder_->model_tag();
+    std::vector<const MemoryChunk*> pending;
+    std::vector<std::string> texts;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        std::vector<float> vec;
+        if (store_->get_embedding(chunks[i].hash, model, vec)) {
+            vectors_.add(chunks[i].id, vec);
+            vectors_dirty_ = true;
+        } else {
+            pending.push_back(&chunks[i]);
+            texts.push_back(chunks[i].text);
+        }
+    }
+    
+    // A dead endpoint would otherwise stall every sync; keyword search still works
+    if (texts.empty() || get_current_timestamp() < embed_retry_at_) return;
+    
+    std::vector<std::vector<float> > vectors;
+    std::string error;
+    if (!embedder_->embed(texts, vectors, error)) {
+        set_error(error);
+        embed_retry_at_ = get_current_timestamp() + 300000;
+    }
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (vectors[i].empty()) continue;
+        store_->put_embedding(pending[i]->hash, model, vectors[i]);
+        vectors_.add(pending[i]->id, vectors[i]);
+        vectors_dirty_ = true;
+    }
+}
+
+// The snapshot only speeds up startup (vectors also live in SQLite), so
+// it is rewritten at most every ten minutes
+void MemoryManager::save_vectors(bool force) {
+    if (!vectors_dirty_ || vectors_path_.empty()) return;
+    int64_t now = get_current_timestamp();
+    if (!force && now - vectors_saved_at_ < 600000) return;
+    if (vectors_.save(vectors_path_, embedder_->model_tag())) {
+        vectors_dirty_ = false;
+        vectors_saved_at_ = now;
+    }
+}
+
 std::string MemoryManager::get_memory_content(const std::string& path) {
     return load_memory_file(path);
 }
 
 // Task operations
-std::string MemoryManager::create_task(const std::string& content, const std::string& context) {
+std::string MemoryManager::create_task(const std::string& content, const std::string& context,
+                                       const std::string& channel, const std::string& user_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (!initialized_) {
         set_error("Memory manager not initialized");
         return "";
@@ -209,6 +588,8 @@ std::string MemoryManager::create_task(const std::string& content, const std::st
     task.id = generate_uuid();
     task.content = content;
     task.context = context;
+    task.channel = channel;
+    task.user_id = user_id;
     task.created_at = get_current_timestamp();
     task.due_at = 0;
     task.completed = false;
@@ -221,21 +602,29 @@ std::string MemoryManager::create_task(const std::string& content, const std::st
 }
 
 bool MemoryManager::complete_task(const std::string& task_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (!initialized_) return false;
+    disarm_task(task_id);
     return store_->complete_task(task_id);
 }
 
 std::vector<MemoryTask> MemoryManager::list_tasks(bool include_completed) {
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::defer_lock);
+    if (!store_->has_read_pool()) lock.lock();
     if (!initialized_) return std::vector<MemoryTask>();
     return store_->list_tasks(include_completed);
 }
 
 std::vector<MemoryTask> MemoryManager::get_pending_tasks() {
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::defer_lock);
+    if (!store_->has_read_pool()) lock.lock();
     if (!initialized_) return std::vector<MemoryTask>();
     return store_->get_pending_tasks();
 }
 
 std::vector<MemoryTask> MemoryManager::get_tasks_due_soon(int hours) {
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::defer_lock);
+    if (!store_->has_read_pool()) lock.lock();
     if (!initialized_) return std::vector<MemoryTask>();
     int64_t now = get_current_timestamp();
     int64_t deadline = now + (static_cast<int64_t>(hours) * 3600 * 1000);
@@ -243,6 +632,7 @@ std::vector<MemoryTask> MemoryManager::get_tasks_due_soon(int hours) {
 }
 
 bool MemoryManager::update_task_due(const std::string& task_id, int64_t due_at) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (!initialized_) return false;
     
     MemoryTask task;
@@ -251,10 +641,72 @@ bool MemoryManager::update_task_due(const std::string& task_id, int64_t due_at)
     }
     
     task.due_at = due_at;
-    return store_->upsert_task(task);
+    if (!store_->upsert_task(task)) return false;
+    arm_task(task);
+    return true;
+}
+
+void MemoryManager::set_task_callback(TaskCallback callback) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    {
+        std::lock_guard<std::mutex> tasks_lock(tasks_mutex_);
+        task_callback_ = callback;
+    }
+    if (!initialized_) return;
+    
+    // One query at startup; from then on the timers follow task updates
+    std::vector<MemoryTask> pending = store_->get_pending_tasks();
+    for (size_t i = 0; i < pending.size(); ++i) arm_task(pending[i]);
+}
+
+bool MemoryManager::mark_task_notified(const std::string& task_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!initialized_) return false;
+    return store_->mark_task_notified(task_id, get_current_timestamp());
+}
+
+void MemoryManager::arm_task(const MemoryTask& task) {
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    std::map<std::string, ArmedTask>::iterator it = armed_tasks_.find(task.id);
+    if (it != armed_tasks_.end()) {
+        TimerWheel::instance().cancel(it->second.timer);
+        armed_tasks_.erase(it);
+    }
+    // A reminder already sent for this due date is not repeated
+    if (!task_callback_ || task.completed || task.due_at <= 0 || task.notified_at >= task.due_at) return;
+    
+    std::string id = task.id;
+    int64_t due_at = task.due_at;
+    ArmedTask& armed = armed_tasks_[id];
+    armed.task = task;
+    armed.timer = TimerWheel::instance().schedule_at(due_at, [this, id, due_at] { fire_task(id, due_at); }, this);
+}
+
+void MemoryManager::disarm_task(const std::string& task_id) {
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    std::map<std::string, ArmedTask>::iterator it = armed_tasks_.find(task_id);
+    if (it == armed_tasks_.end()) return;
+    TimerWheel::instance().cancel(it->second.timer);
+    armed_tasks_.erase(it);
+}
+
+void MemoryManager::fire_task(const std::string& task_id, int64_t due_at) {
+    MemoryTask task;
+    TaskCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        std::map<std::string, ArmedTask>::iterator it = armed_tasks_.find(task_id);
+        // Completed or rescheduled after the wheel picked this timer up
+        if (it == armed_tasks_.end() || it->second.task.due_at != due_at) return;
+        task = it->second.task;
+        callback = task_callback_;
+        armed_tasks_.erase(it);
+    }
+    if (callback) callback(task);
 }
 
 std::string MemoryManager::last_error() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
     return last_error_;
 }
 
@@ -264,8 +716,8 @@ const MemoryConfig& MemoryManager::config() const {
 
 // Private methods
 
-std::vector<MemoryFile> MemoryManager::discover_memory_files() {
-    std::vector<MemoryFile> result;
+std::vector<std::string> MemoryManager::discover_memory_files() {
+    std::vector<std::string> result;
     
     // Check for MEMORY.md (case-insensitive)
     std::vector<std::string> main_files = {"MEMORY.md", "memory.md"};
@@ -273,7 +725,7 @@ std::vector<MemoryFile> MemoryManager::discover_memory_files() {
         std::string path = config_.workspace_dir + "/" + name;
         struct stat st;
         if (stat(path.c_str(), &st) == 0) {
-            result.push_back(build_file_entry(path));
+            result.push_back(path);
             break;  // Only one main memory file
         }
     }
@@ -290,7 +742,7 @@ std::vector<MemoryFile> MemoryManager::discover_memory_files() {
             // Only .md files
             if (name.length() > 3 && name.substr(name.length() - 3) == ".md") {
                 std::string path = memory_dir + "/" + name;
-                result.push_back(build_file_entry(path));
+                result.push_back(path);
             }
         }
         closedir(dir);
@@ -311,49 +763,48 @@ MemoryFile MemoryManager::build_file_entry(const std::string& abs_path) {
         file.path = abs_path;
     }
     
-    // Get file stats
+    // Get file stats; the content is only read (and hashed) if they changed
     struct stat st;
     if (stat(abs_path.c_str(), &st) == 0) {
-        file.mtime = static_cast<int64_t>(st.st_mtime) * 1000;
+        file.mtime = stat_mtime_ms(st);
         file.size = st.st_size;
-    }
-    
-    // Compute hash of content
-    std::ifstream f(abs_path.c_str());
-    if (f) {
-        std::stringstream buffer;
-        buffer << f.rdbuf();
-        file.hash = compute_hash(buffer.str());
+        file.inode = static_cast<int64_t>(st.st_ino);
     }
     
     return file;
 }
 
-bool MemoryManager::index_file(const MemoryFile& file) {
-    // Read file content
-    std::ifstream f(file.abs_path.c_str());
-    if (!f) {
-        return false;
+MemoryManager::PreparedFile MemoryManager::prepare_file(const std::string& abs_path,
+                                                        const std::map<std::string, MemoryFile>& stored) {
+    PreparedFile prepared;
+    prepared.file = build_file_entry(abs_path);
+    MemoryFile& file = prepared.file;
+    
+    // Check if file has changed: stat first, then a content hash
+    std::map<std::string, MemoryFile>::const_iterator it = stored.find(file.path);
+    if (it != stored.end() && stat_unchanged(it->second, file.mtime, file.size, file.inode)) {
+        prepared.state = PreparedFile::UNCHANGED;
+        return prepared;
     }
     
-    std::stringstream buffer;
-    buffer << f.rdbuf();
-    std::string content = buffer.str();
-    
-    // Delete existing chunks
-    store_->delete_chunks_for_file(file.path, file.source);
-    
-    // Create new chunks
-    std::vector<MemoryChunk> chunks = chunk_content(content, file.path, file.source);
-    
-    for (const auto& chunk : chunks) {
-        if (!store_->upsert_chunk(chunk)) {
-            // Log error but continue
-        }
+    std::string content = load_file_content(file.abs_path);
+    file.hash = xxh64_hex(content);
+    if (it != stored.end() && it->second.hash == file.hash) {
+        prepared.state = PreparedFile::TOUCHED;
+        return prepared;
     }
     
-    // Update file record
-    return store_->upsert_file(file);
+    prepared.state = PreparedFile::CHANGED;
+    prepared.chunks = chunk_content(content, file.path, file.source);
+    return prepared;
+}
+
+ThreadPool& MemoryManager::index_pool() {
+    if (!index_pool_) {
+        size_t threads = std::max(2u, std::thread::hardware_concurrency());
+        index_pool_.reset(new ThreadPool(std::min<size_t>(threads, 8), 0));
+    }
+    return *index_pool_;
 }
 
 std::vector<MemoryChunk> MemoryManager::chunk_content(const std::string& content,
@@ -361,114 +812,149 @@ std::vector<MemoryChunk> MemoryManager::chunk_content(const std::string& content
                                                        MemorySource source) {
     std::vector<MemoryChunk> chunks;
     
-    // Split content into paragraphs first
-    std::vector<std::string> paragraphs = split_into_paragraphs(content);
+    std::vector<std::string> lines;
+    std::vector<Paragraph> paragraphs = split_into_paragraphs(content, lines);
     
-    // Combine paragraphs into chunks of target size
-    int max_chars = config_.chunking.max_chars();
-    int overlap_chars = config_.chunking.overlap_chars();
+    // Boundaries fall after paragraphs whose hash says so, with a probability
+    // proportional to their length (about one per target/2 chars). The choice
+    // depends only on the paragraph itself, so an edit moves at most the
+    // boundaries next to it; max_chars is still a hard cap.
+    size_t max_chars = static_cast<size_t>(std::max(1, config_.chunking.max_chars()));
+    size_t overlap_chars = static_cast<size_t>(std::max(0, config_.chunking.overlap_chars()));
+    uint64_t avg_chars = std::max<uint64_t>(1, max_chars / 2);
+    size_t min_chars = max_chars / 4;
     
-    std::string current_chunk;
-    int chunk_start_line = 1;
-    int line_count = 1;
+    int64_t now = get_current_timestamp();
+    std::map<std::string, int> seen;
+    size_t first = 0;       // First paragraph of the current chunk
+    size_t size = 0;
+    size_t overlap_line = std::string::npos;    // Overlap from the previous chunk
     
     for (size_t i = 0; i < paragraphs.size(); ++i) {
-        const std::string& para = paragraphs[i];
+        const Paragraph& para = paragraphs[i];
         
-        // Count lines in this paragraph
-        int para_lines = 1;
-        for (char c : para) {
-            if (c == '\n') para_lines++;
+        if (i > first && size + para.size > max_chars) {
+            emit_chunk(lines, std::min(overlap_line, paragraphs[first].first_line),
+                       paragraphs[i - 1].last_line, path, source, now, seen, chunks);
+            overlap_line = overlap_start(lines, paragraphs[first].first_line,
+                                         paragraphs[i - 1].last_line, overlap_chars);
+            first = i;
+            size = 0;
         }
-        
-        // Check if adding this paragraph would exceed target size
-        if (!current_chunk.empty() && 
-            static_cast<int>(current_chunk.length() + para.length()) > max_chars) {
-            // Save current chunk
-            MemoryChunk chunk;
-            chunk.id = generate_uuid();
-            chunk.path = path;
-            chunk.source = source;
-            chunk.start_line = chunk_start_line;
-            chunk.end_line = line_count - 1;
-            chunk.text = current_chunk;
-            chunk.hash = compute_hash(current_chunk);
-            chunk.updated_at = get_current_timestamp();
-            chunks.push_back(chunk);
-            
-            // Start new chunk with overlap
-            if (overlap_chars > 0 && static_cast<int>(current_chunk.length()) > overlap_chars) {
-                current_chunk = current_chunk.substr(current_chunk.length() - overlap_chars);
-            } else {
-                current_chunk.clear();
-            }
-            chunk_start_line = line_count;
-        }
-        
-        if (!current_chunk.empty()) {
-            current_chunk += "\n\n";
+        size += para.size;
+        if (size >= min_chars && para.hash % avg_chars < para.size) {
+            emit_chunk(lines, std::min(overlap_line, paragraphs[first].first_line),
+                       para.last_line, path, source, now, seen, chunks);
+            overlap_line = overlap_start(lines, paragraphs[first].first_line,
+                                         para.last_line, overlap_chars);
+            first = i + 1;
+            size = 0;
         }
-        current_chunk += para;
-        line_count += para_lines;
     }
     
-    // Save final chunk if non-empty
-    if (!current_chunk.empty()) {
-        MemoryChunk chunk;
-        chunk.id = generate_uuid();
-        chunk.path = path;
-        chunk.source = source;
-        chunk.start_line = chunk_start_line;
-        chunk.end_line = line_count;
-        chunk.text = current_chunk;
-        chunk.hash = compute_hash(current_chunk);
-        chunk.updated_at = get_current_timestamp();
-        chunks.push_back(chunk);
+    if (first < paragraphs.size()) {
+        emit_chunk(lines, std::min(overlap_line, paragraphs[first].first_line),
+                   paragraphs.back().last_line, path, source, now, seen, chunks);
     }
     
     return chunks;
 }
 
-std::vector<std::string> MemoryManager::split_into_paragraphs(const std::string& content) {
-    std::vector<std::string> paragraphs;
-    std::string current;
+void MemoryManager::emit_chunk(const std::vector<std::string>& lines, size_t first_line, size_t last_line,
+                               const std::string& path, MemorySource source, int64_t now,
+                               std::map<std::string, int>& seen, std::vector<MemoryChunk>& out) {
+    MemoryChunk chunk;
+    for (size_t l = first_line; l <= last_line; ++l) {
+        if (l > first_line) chunk.text += "\n";
+        chunk.text += lines[l];
+    }
+    chunk.path = path;
+    chunk.source = source;
+    chunk.start_line = static_cast<int>(first_line) + 1;
+    chunk.end_line = static_cast<int>(last_line) + 1;
+    chunk.hash = compute_hash(chunk.text);
+    chunk.updated_at = now;
+    
+    // Id from the location and the text, so unchanged chunks keep their rows
+    // (and vectors) across a resync; repeats within a file are numbered
+    chunk.id = compute_hash(memory_source_to_string(source) + "\n" + path + "\n" + chunk.hash).substr(0, 32);
+    int repeat = seen[chunk.id]++;
+    if (repeat > 0) chunk.id += "-" + std::to_string(repeat);
+    
+    out.push_back(chunk);
+}
+
+size_t MemoryManager::overlap_start(const std::vector<std::string>& lines, size_t first_line,
+                                    size_t last_line, size_t overlap_chars) {
+    // Whole trailing lines of the previous chunk, up to overlap_chars
+    size_t start = last_line + 1;
+    size_t size = 0;
+    while (start > first_line) {
+        size_t len = lines[start - 1].size() + 1;
+        if (size + len > overlap_chars) break;
+        size += len;
+        --start;
+    }
+    // Never start on blank lines
+    while (start <= last_line && is_blank_line(lines[start])) ++start;
+    return start;
+}
+
+std::vector<MemoryManager::Paragraph> MemoryManager::split_into_paragraphs(const std::string& content,
+                                                                          std::vector<std::string>& lines) {
+    std::vector<Paragraph> paragraphs;
     
     std::istringstream stream(content);
     std::string line;
-    
     while (std::getline(stream, line)) {
-        bool is_blank = line.empty() || (line.find_first_not_of(" \t\r") == std::string::npos);
-        
-        if (is_blank) {
-            if (!current.empty()) {
-                paragraphs.push_back(current);
-                current.clear();
-            }
-        } else {
-            if (!current.empty()) {
-                current += "\n";
-            }
-            current += line;
-        }
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+        lines.push_back(line);
     }
     
-    if (!current.empty()) {
-        paragraphs.push_back(current);
+    bool open = false;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (is_blank_line(lines[i])) {
+            open = false;
+            continue;
+        }
+        if (!open) {
+            Paragraph para;
+            para.first_line = i;
+            para.size = 0;
+            para.hash = 14695981039346656037ULL;    // FNV-1a offset basis
+            paragraphs.push_back(para);
+            open = true;
+        }
+        Paragraph& para = paragraphs.back();
+        para.last_line = i;
+        para.size += lines[i].size() + 1;
+        for (size_t c = 0; c < lines[i].size(); ++c) {
+            para.hash = (para.hash ^ static_cast<unsigned char>(lines[i][c])) * 1099511628211ULL;
+        }
+        para.hash = (para.hash ^ '\n') * 1099511628211ULL;
     }
     
     return paragraphs;
 }
 
+bool MemoryManager::is_blank_line(const std::string& line) {
+    return line.find_first_not_of(" \t\r") == std::string::npos;
+}
+
 std::string MemoryManager::compute_hash(const std::string& content) {
+    // SHA-256 where identity matters (chunk ids, embedding keys); file
+    // change detection uses xxh64_hex instead
+    static const char digits[] = "0123456789abcdef";
     unsigned char hash[SHA256_DIGEST_LENGTH];
     SHA256(reinterpret_cast<const unsigned char*>(content.c_str()), 
            content.length(), hash);
     
-    std::stringstream ss;
+    std::string out(SHA256_DIGEST_LENGTH * 2, '0');
     for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
-        ss << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(hash[i]);
+        out[i * 2] = digits[hash[i] >> 4];
+        out[i * 2 + 1] = digits[hash[i] & 0xf];
     }
-    return ss.str();
+    return out;
 }
 
 std::string MemoryManager::generate_uuid() {
@@ -505,11 +991,13 @@ int64_t MemoryManager::get_current_timestamp() {
 }
 
 void MemoryManager::set_error(const std::string& error) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
     last_error_ = error;
 }
 
 // Sync with reason and force flag
 bool MemoryManager::sync(const std::string& reason, bool force) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     // Log reason if needed in the future
     (void)reason;
     
@@ -525,6 +1013,7 @@ bool MemoryManager::sync(const std::string& reason, bool force) {
 // Session support methods
 
 void MemoryManager::warm_session(const std::string& session_key) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (!initialized_) {
         return;
     }
@@ -537,6 +1026,7 @@ void MemoryManager::warm_session(const std::string& session_key) {
 }
 
 bool MemoryManager::sync_session_files() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     if (!initialized_) {
         set_error("Memory manager not initialized");
         return false;
@@ -545,29 +1035,16 @@ bool MemoryManager::sync_session_files() {
     std::vector<std::string> session_files = list_session_files();
     std::vector<std::string> active_paths;
     
+    store_->begin();
+    size_t indexed = 0;
+    
     for (const auto& path : session_files) {
-        SessionFileEntry entry = build_session_entry(path);
-        active_paths.push_back(entry.path);
-        
-        // Check if file has changed
-        MemoryFile existing;
-        bool exists = store_->get_file(entry.path, MemorySource::SESSIONS, existing);
-        
-        // Compute hash of session file
-        std::string content = load_file_content(entry.abs_path);
-        std::string hash = compute_hash(content);
-        
-        if (exists && existing.hash == hash) {
-            continue;  // File unchanged
-        }
-        
-        // Index the session file
-        if (!index_session_file(entry)) {
-            // Log error but continue
+        std::string rel_path;
+        if (sync_session_file(path, rel_path) && ++indexed % sync_batch_files == 0) {
+            store_->commit();
+            store_->begin();
         }
-        
-        // Remove from dirty set if it was there
-        sessions_dirty_files_.erase(entry.path);
+        active_paths.push_back(rel_path);
     }
     
     // Remove stale session files
@@ -576,7 +1053,54 @@ bool MemoryManager::sync_session_files() {
         store_->delete_chunks_for_file(path, MemorySource::SESSIONS);
         store_->delete_file(path, MemorySource::SESSIONS);
     }
+    store_->commit();
     
+    reconcile_vectors();
+    sessions_dirty_ = !sessions_dirty_files_.empty();
+    return true;
+}
+
+bool MemoryManager::sync_session_file(const std::string& abs_path, std::string& rel_path) {
+    SessionFileEntry entry = build_session_entry(abs_path);
+    rel_path = entry.path;
+    sessions_dirty_files_.erase(entry.path);
+    
+    // Check if file has changed: stat first, then whether it only grew
+    MemoryFile existing;
+    bool exists = store_->get_file(entry.path, MemorySource::SESSIONS, existing);
+    if (exists && stat_unchanged(existing, entry.mtime_ms, entry.size, entry.inode)) {
+        return false;
+    }
+    
+    bool appended = exists && existing.inode == entry.inode && entry.size >= existing.size &&
+                    index_session_tail(entry, existing);
+    
+    // Rewritten, truncated or new: index the whole transcript
+    if (!appended && !index_session_file(entry, load_file_content(entry.abs_path))) {
+        // Log error but continue
+    }
+    return true;
+}
+
+bool MemoryManager::sync_session_paths(const std::vector<std::string>& abs_paths) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!initialized_) return false;
+    
+    store_->begin();
+    for (size_t i = 0; i < abs_paths.size(); ++i) {
+        struct stat st;
+        if (stat(abs_paths[i].c_str(), &st) != 0) {
+            std::string rel_path = session_path_for_file(abs_paths[i]);
+            store_->delete_chunks_for_file(rel_path, MemorySource::SESSIONS);
+            store_->delete_file(rel_path, MemorySource::SESSIONS);
+            continue;
+        }
+        std::string rel_path;
+        sync_session_file(abs_paths[i], rel_path);
+    }
+    store_->commit();
+    
+    reconcile_vectors();
     sessions_dirty_ = !sessions_dirty_files_.empty();
     return true;
 }
@@ -620,8 +1144,9 @@ SessionFileEntry MemoryManager::build_session_entry(const std::string& abs_path)
     
     struct stat st;
     if (stat(abs_path.c_str(), &st) == 0) {
-        entry.mtime_ms = static_cast<int64_t>(st.st_mtime) * 1000;
+        entry.mtime_ms = stat_mtime_ms(st);
         entry.size = st.st_size;
+        entry.inode = static_cast<int64_t>(st.st_ino);
     }
     
     return entry;
@@ -640,91 +1165,83 @@ std::string MemoryManager::session_path_for_file(const std::string& abs_path) {
     return abs_path;
 }
 
-bool MemoryManager::index_session_file(const SessionFileEntry& entry) {
-    // Read file content
-    std::string content = load_file_content(entry.abs_path);
-    std::string hash = compute_hash(content);
-    
-    // Delete existing chunks
-    store_->delete_chunks_for_file(entry.path, MemorySource::SESSIONS);
-    
+bool MemoryManager::index_session_file(const SessionFileEntry& entry, const std::string& content) {
     // Extract text from session transcript
-    std::string text = extract_session_text(content);
+    size_t consumed = 0;
+    std::string text = extract_session_text(content, 0, consumed);
     text = normalize_session_text(text);
     
+    std::vector<MemoryChunk> chunks;
     if (!text.empty()) {
-        // Create chunks from the extracted text
-        std::vector<MemoryChunk> chunks = chunk_content(text, entry.path, MemorySource::SESSIONS);
-        
-        for (const auto& chunk : chunks) {
-            if (!store_->upsert_chunk(chunk)) {
-                // Log error but continue
-            }
-        }
+        chunks = chunk_content(text, entry.path, MemorySource::SESSIONS);
     }
     
-    // Update file record
+    // Replace the transcript's chunks and record in one transaction
     MemoryFile mf;
     mf.path = entry.path;
     mf.abs_path = entry.abs_path;
     mf.source = MemorySource::SESSIONS;
-    mf.hash = hash;
+    mf.hash = session_anchor(content, consumed);
     mf.mtime = entry.mtime_ms;
-    mf.size = entry.size;
+    mf.size = static_cast<int64_t>(consumed);
+    mf.inode = entry.inode;
+    
+    return store_->replace_file(mf, chunks);
+}
+
+bool MemoryManager::index_session_tail(const SessionFileEntry& entry, const MemoryFile& existing) {
+    // One read covers the anchor before the old offset and everything after it
+    size_t offset = static_cast<size_t>(existing.size);
+    size_t base = offset > session_anchor_bytes ? offset - session_anchor_bytes : 0;
+    std::string data;
+    if (!read_from(entry.abs_path, base, data) || data.size() < offset - base) return false;
+    if (session_anchor(data, offset - base) != existing.hash) return false;
+    
+    size_t consumed = 0;
+    std::string text = normalize_session_text(extract_session_text(data, offset - base, consumed));
+    
+    std::vector<MemoryChunk> chunks;
+    if (!text.empty()) {
+        // Continue the line numbering of the chunks already stored; the offset
+        // keeps ids of repeated text (an "ok" each day) apart
+        chunks = chunk_content(text, entry.path, MemorySource::SESSIONS);
+        int shift = store_->max_end_line(entry.path, MemorySource::SESSIONS);
+        if (shift > 0) shift += 1;
+        std::string at = "@" + std::to_string(offset);
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            chunks[i].start_line += shift;
+            chunks[i].end_line += shift;
+            chunks[i].id = compute_hash(chunks[i].id + at).substr(0, 32);
+        }
+    }
     
-    return store_->upsert_file(mf);
+    MemoryFile mf = existing;
+    mf.abs_path = entry.abs_path;
+    mf.hash = session_anchor(data, offset - base + consumed);
+    mf.mtime = entry.mtime_ms;
+    mf.size = static_cast<int64_t>(offset + consumed);
+    return store_->append_file_chunks(mf, chunks);
 }
 
-std::string MemoryManager::extract_session_text(const std::string& content) {
-    // Parse JSONL session transcript and extract user/assistant messages
+std::string MemoryManager::extract_session_text(const std::string& content, size_t from, size_t& consumed) {
+    // User and assistant messages of complete JSONL lines; a torn last line
+    // is left for the next pass
     std::string result;
-    std::istringstream stream(content);
-    std::string line;
+    size_t pos = from;
+    consumed = 0;
     
-    while (std::getline(stream, line)) {
-        if (line.empty()) continue;
-        
-        // Simple JSON parsing - look for role and content fields
-        // Format: {"role":"user","content":"..."}
-        std::string role;
-        std::string msg_content;
+    while (pos < content.size()) {
+        size_t nl = content.find('\n', pos);
+        if (nl == std::string::npos) break;
         
-        // Find role
-        size_t role_pos = line.find("\"role\"");
-        if (role_pos != std::string::npos) {
-            size_t colon = line.find(':', role_pos);
-            if (colon != std::string::npos) {
-                size_t quote1 = line.find('"', colon);
-                if (quote1 != std::string::npos) {
-                    size_t quote2 = line.find('"', quote1 + 1);
-                    if (quote2 != std::string::npos) {
-                        role = line.substr(quote1 + 1, quote2 - quote1 - 1);
-                    }
-                }
-            }
-        }
+        Json record = Json::parse(content.begin() + static_cast<long>(pos),
+                                  content.begin() + static_cast<long>(nl), nullptr, false);
+        pos = nl + 1;
+        consumed = pos - from;
+        if (record.is_discarded() || !record.is_object()) continue;
         
-        // Find content
-        size_t content_pos = line.find("\"content\"");
-        if (content_pos != std::string::npos) {
-            size_t colon = line.find(':', content_pos);
-            if (colon != std::string::npos) {
-                size_t quote1 = line.find('"', colon);
-                if (quote1 != std::string::npos) {
-                    // Handle escaped quotes in content
-                    size_t pos = quote1 + 1;
-                    while (pos < line.length()) {
-                        if (line[pos] == '"' && (pos == 0 || line[pos-1] != '\\')) {
-                            break;
-                        }
-                        pos++;
-                    }
-                    msg_content = line.substr(quote1 + 1, pos - quote1 - 1);
-                    // Unescape basic sequences
-                    msg_content = unescape_json_string(msg_content);
-                }
-            }
-        }
+        std::string role;
+        std::string msg_content = record_text(record, role);
         
         // Only include user and assistant messages
         if ((role == "user" || role == "assistant") && !msg_content.empty()) {
@@ -770,29 +1287,6 @@ std::string MemoryManager::normalize_session_text(const std::string& text) {
     return result;
 }
 
-std::string MemoryManager::unescape_json_string(const std::string& s) {
-    std::string result;
-    result.reserve(s.length());
-    
-    for (size_t i = 0; i < s.length(); ++i) {
-        if (s[i] == '\\' && i + 1 < s.length()) {
-            char next = s[i + 1];
-            switch (next) {
-                case 'n':  result += '\n'; ++i; break;
-                case 't':  result += '\t'; ++i; break;
-                case 'r':  result += '\r'; ++i; break;
-                case '"':  result += '"';  ++i; break;
-                case '\\': result += '\\'; ++i; break;
-                default:   result += s[i]; break;
-            }
-        } else {
-            result += s[i];
-        }
-    }
-    
-    return result;
-}
-
 std::string MemoryManager::load_file_content(const std::string& abs_path) {
     std::ifstream f(abs_path.c_str());
     if (!f) {
@@ -821,9 +1315,11 @@ bool MemoryManager::is_allowed_path(const std::string& abs_path) {
 }
 
 MemoryManager::MemoryStatus MemoryManager::status() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     MemoryStatus s;
     s.backend = "builtin";
-    s.provider = "bm25";
+    s.provider = embedder_ ? "bm25+vector" : "bm25";
+    s.vectors = static_cast<int>(vectors_.size());
     s.dirty = dirty_;
     s.sessions_dirty = sessions_dirty_;
     s.workspace_dir = config_.workspace_dir;
@@ -881,42 +1377,23 @@ MemoryManager::ReadFileResult MemoryManager::read_file(const std::string& rel_pa
         return result;
     }
     
-    std::ifstream f(abs_path.c_str());
-    if (!f) {
+    std::string error;
+    std::shared_ptr<const FileView> file = FileView::open(abs_path, error);
+    if (!file) {
         result.error = "File not found: " + rel_path;
         return result;
     }
     
-    // Read file lines
-    std::vector<std::string> lines;
-    std::string line;
-    while (std::getline(f, line)) {
-        lines.push_back(line);
-    }
-    
-    int total_lines = static_cast<int>(lines.size());
-    
-    // Adjust line range (from_line is 0-indexed)
-    int start = (from_line > 0) ? from_line : 0;
-    int end = (num_lines > 0) ? (start + num_lines) : total_lines;
-    
-    if (start >= total_lines) {
+    // Only the requested lines are scanned (from_line is 0-indexed)
+    size_t start = (from_line > 0) ? static_cast<size_t>(from_line) : 0;
+    size_t count = (num_lines > 0) ? static_cast<size_t>(num_lines) : 0;
+    size_t offset = 0, length = 0;
+    if (!file->line_range(start, count, offset, length)) {
         result.error = "Start line out of range";
         return result;
     }
     
-    if (end > total_lines) {
-        end = total_lines;
-    }
-    
-    // Extract requested lines
-    std::stringstream ss;
-    for (int i = start; i < end; ++i) {
-        if (i > start) ss << "\n";
-        ss << lines[i];
-    }
-    
-    result.text = ss.str();
+    result.text = file->substr(offset, length);
     result.success = true;
     
     return result;
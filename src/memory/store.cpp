@@ -2,7 +2,10 @@
  * OpenClaw C++11 - Memory SQLite Store Implementation
  */
 #include <openclaw/memory/store.hpp>
+#include <algorithm>
 #include <cstring>
+#include <cctype>
+#include <set>
 #include <sstream>
 
 namespace openclaw {
@@ -10,6 +13,7 @@ namespace openclaw {
 MemoryStore::MemoryStore() 
     : db_(nullptr)
     , fts_available_(false)
+    , transaction_depth_(0)
 {
 }
 
@@ -17,7 +21,7 @@ MemoryStore::~MemoryStore() {
     close();
 }
 
-bool MemoryStore::open(const std::string& db_path) {
+bool MemoryStore::open(const std::string& db_path, int read_connections) {
     if (db_) {
         close();
     }
@@ -29,14 +33,106 @@ bool MemoryStore::open(const std::string& db_path) {
         return false;
     }
     
-    // Enable WAL mode for better concurrency
+    // Enable WAL mode for better concurrency; with WAL, NORMAL only syncs
+    // at checkpoints, which is safe against corruption
     exec("PRAGMA journal_mode=WAL");
     exec("PRAGMA synchronous=NORMAL");
+    exec("PRAGMA cache_size=-16384");       // 16 MB page cache
+    exec("PRAGMA temp_store=MEMORY");
+    sqlite3_busy_timeout(db_, 5000);
+    
+    // Readers see the last committed state while the writer is mid-transaction
+    bool in_memory = db_path.empty() || db_path == ":memory:";
+    for (int i = 0; !in_memory && i < read_connections; ++i) {
+        sqlite3* rdb = nullptr;
+        if (sqlite3_open_v2(db_path.c_str(), &rdb, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+                            nullptr) != SQLITE_OK) {
+            sqlite3_close(rdb);
+            break;      // Reads fall back to the remaining readers or the writer
+        }
+        sqlite3_busy_timeout(rdb, 5000);
+        sqlite3_exec(rdb, "PRAGMA cache_size=-4096", nullptr, nullptr, nullptr);
+        sqlite3_exec(rdb, "PRAGMA temp_store=MEMORY", nullptr, nullptr, nullptr);
+        Reader* reader = new Reader();
+        reader->db = rdb;
+        readers_.push_back(reader);
+        idle_readers_.push_back(reader);
+    }
     
     return true;
 }
 
+bool MemoryStore::has_read_pool() const {
+    std::lock_guard<std::mutex> lock(readers_mutex_);
+    return !readers_.empty();
+}
+
+void MemoryStore::close_readers() {
+    std::unique_lock<std::mutex> lock(readers_mutex_);
+    readers_cv_.wait(lock, [this] { return idle_readers_.size() == readers_.size(); });
+    for (size_t i = 0; i < readers_.size(); ++i) {
+        Reader* reader = readers_[i];
+        for (std::map<std::string, sqlite3_stmt*>::iterator it = reader->statements.begin();
+             it != reader->statements.end(); ++it) {
+            sqlite3_finalize(it->second);
+        }
+        sqlite3_close(reader->db);
+        delete reader;
+    }
+    readers_.clear();
+    idle_readers_.clear();
+}
+
+MemoryStore::ReadLease::ReadLease(MemoryStore& store)
+    : store_(store)
+    , reader_(nullptr) {
+    std::unique_lock<std::mutex> lock(store_.readers_mutex_);
+    if (store_.readers_.empty()) return;
+    store_.readers_cv_.wait(lock, [this] { return !store_.idle_readers_.empty(); });
+    reader_ = store_.idle_readers_.back();
+    store_.idle_readers_.pop_back();
+}
+
+MemoryStore::ReadLease::~ReadLease() {
+    // An unreset SELECT would pin its WAL snapshot and stall checkpoints
+    for (size_t i = 0; i < used_.size(); ++i) sqlite3_reset(used_[i]);
+    if (!reader_) return;
+    std::lock_guard<std::mutex> lock(store_.readers_mutex_);
+    store_.idle_readers_.push_back(reader_);
+    store_.readers_cv_.notify_all();
+}
+
+sqlite3_stmt* MemoryStore::ReadLease::statement(const char* sql) {
+    if (!reader_) {
+        sqlite3_stmt* stmt = store_.statement(sql);
+        if (stmt) used_.push_back(stmt);
+        return stmt;
+    }
+    std::map<std::string, sqlite3_stmt*>::iterator it = reader_->statements.find(sql);
+    if (it != reader_->statements.end()) {
+        sqlite3_reset(it->second);
+        sqlite3_clear_bindings(it->second);
+        used_.push_back(it->second);
+        return it->second;
+    }
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(reader_->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        store_.set_error(sqlite3_errmsg(reader_->db));
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    reader_->statements[sql] = stmt;
+    used_.push_back(stmt);
+    return stmt;
+}
+
 void MemoryStore::close() {
+    close_readers();
+    for (std::map<std::string, sqlite3_stmt*>::iterator it = statements_.begin(); it != statements_.end(); ++it) {
+        sqlite3_finalize(it->second);
+    }
+    statements_.clear();
+    transaction_depth_ = 0;
     if (db_) {
         sqlite3_close(db_);
         db_ = nullptr;
@@ -70,10 +166,14 @@ bool MemoryStore::ensure_schema() {
         "  hash TEXT,"
         "  mtime INTEGER,"
         "  size INTEGER,"
+        "  inode INTEGER,"
         "  PRIMARY KEY (path, source)"
         ")"
     )) return false;
     
+    // Databases from before the stat fast path lack the inode column
+    if (!has_column("files", "inode") && !exec("ALTER TABLE files ADD COLUMN inode INTEGER")) return false;
+    
     // Chunks table for text chunks
     if (!exec(
         "CREATE TABLE IF NOT EXISTS chunks ("
@@ -88,7 +188,21 @@ bool MemoryStore::ensure_schema() {
         ")"
     )) return false;
     
-    if (!exec("CREATE INDEX IF NOT EXISTS idx_chunks_path ON chunks(path, source)")) return false;
+    // end_line makes MAX(end_line) of a transcript an index lookup
+    if (!exec("DROP INDEX IF EXISTS idx_chunks_path")) return false;
+    if (!exec("CREATE INDEX IF NOT EXISTS idx_chunks_path_line ON chunks(path, source, end_line)")) return false;
+    if (!exec("CREATE INDEX IF NOT EXISTS idx_chunks_hash ON chunks(hash)")) return false;
+    
+    // Embeddings by text hash, so re-chunked but unchanged text keeps its vector
+    if (!exec(
+        "CREATE TABLE IF NOT EXISTS embeddings ("
+        "  hash TEXT NOT NULL,"
+        "  model TEXT NOT NULL,"
+        "  dims INTEGER,"
+        "  vector BLOB,"
+        "  PRIMARY KEY (hash, model)"
+        ")"
+    )) return false;
     
     // Tasks table
     if (!exec(
@@ -105,6 +219,9 @@ bool MemoryStore::ensure_schema() {
         ")"
     )) return false;
     
+    if (!has_column("tasks", "notified_at") &&
+        !exec("ALTER TABLE tasks ADD COLUMN notified_at INTEGER DEFAULT 0")) return false;
+    
     if (!exec("CREATE INDEX IF NOT EXISTS idx_tasks_due ON tasks(due_at)")) return false;
     if (!exec("CREATE INDEX IF NOT EXISTS idx_tasks_completed ON tasks(completed)")) return false;
     
@@ -115,52 +232,156 @@ bool MemoryStore::ensure_schema() {
 }
 
 bool MemoryStore::ensure_fts_table() {
+    // Older databases declared chunks_fts as an external-content table over
+    // columns chunks does not have, so every MATCH failed; rebuild those
+    bool exists = false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "SELECT sql FROM sqlite_master WHERE name = 'chunks_fts'", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* sql = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            exists = !(sql && std::strstr(sql, "content=chunks"));
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (!exists) {
+        exec("DROP TABLE IF EXISTS chunks_fts");
+    }
+    
     std::string error;
-    bool ok = exec(
-        "CREATE VIRTUAL TABLE IF NOT EXISTS chunks_fts USING fts5("
-        "  chunk_id,"
-        "  path,"
-        "  source,"
-        "  text,"
-        "  content=chunks,"
-        "  content_rowid=rowid"
-        ")",
-        error
-    );
+    bool ok = exec("CREATE VIRTUAL TABLE IF NOT EXISTS chunks_fts USING fts5(text)", error);
     
     if (!ok) {
         // FTS5 might not be available, try FTS4
-        ok = exec(
-            "CREATE VIRTUAL TABLE IF NOT EXISTS chunks_fts USING fts4("
-            "  chunk_id,"
-            "  path,"
-            "  source,"
-            "  text"
-            ")",
-            error
-        );
+        ok = exec("CREATE VIRTUAL TABLE IF NOT EXISTS chunks_fts USING fts4(text)", error);
+    }
+    
+    if (ok && !exists) {
+        ok = exec("INSERT INTO chunks_fts (rowid, text) SELECT rowid, text FROM chunks");
     }
     
     return ok;
 }
 
-bool MemoryStore::upsert_file(const MemoryFile& file) {
+// Transactions; nested levels are savepoints, so a failed file only
+// undoes its own writes
+bool MemoryStore::begin() {
     if (!db_) {
         set_error("Database not open");
         return false;
     }
-    
-    const char* sql = 
-        "INSERT OR REPLACE INTO files (path, source, abs_path, hash, mtime, size) "
-        "VALUES (?, ?, ?, ?, ?, ?)";
-    
+    std::string sql = transaction_depth_ == 0
+        ? std::string("BEGIN IMMEDIATE")
+        : "SAVEPOINT sp" + std::to_string(transaction_depth_);
+    if (!exec(sql)) return false;
+    transaction_depth_++;
+    return true;
+}
+
+bool MemoryStore::commit() {
+    if (!db_ || transaction_depth_ == 0) return false;
+    transaction_depth_--;
+    if (transaction_depth_ > 0) {
+        return exec("RELEASE sp" + std::to_string(transaction_depth_));
+    }
+    if (!exec("COMMIT")) {
+        exec("ROLLBACK");
+        return false;
+    }
+    return true;
+}
+
+void MemoryStore::rollback() {
+    if (!db_ || transaction_depth_ == 0) return;
+    transaction_depth_--;
+    if (transaction_depth_ > 0) {
+        std::string sp = "sp" + std::to_string(transaction_depth_);
+        exec("ROLLBACK TO " + sp);
+        exec("RELEASE " + sp);
+        return;
+    }
+    exec("ROLLBACK");
+}
+
+sqlite3_stmt* MemoryStore::statement(const char* sql) {
+    std::map<std::string, sqlite3_stmt*>::iterator it = statements_.find(sql);
+    if (it != statements_.end()) {
+        sqlite3_reset(it->second);
+        sqlite3_clear_bindings(it->second);
+        return it->second;
+    }
     sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         set_error_from_db();
+        return nullptr;
+    }
+    statements_[sql] = stmt;
+    return stmt;
+}
+
+bool MemoryStore::step_done(sqlite3_stmt* stmt) {
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) set_error_from_db();
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool MemoryStore::replace_file(const MemoryFile& file, const std::vector<MemoryChunk>& chunks) {
+    if (!begin()) return false;
+    
+    // Chunk ids are content-derived: rows whose id and hash survive only get
+    // their line numbers refreshed, so FTS and vectors are left alone
+    std::map<std::string, std::string> existing;   // id -> hash
+    bool ok = list_file_chunks(file.path, memory_source_to_string(file.source), existing);
+    for (size_t i = 0; ok && i < chunks.size(); ++i) {
+        std::map<std::string, std::string>::iterator it = existing.find(chunks[i].id);
+        if (it != existing.end() && it->second == chunks[i].hash) {
+            ok = update_chunk_lines(chunks[i]);
+            existing.erase(it);
+        } else {
+            if (it != existing.end()) existing.erase(it);
+            ok = remove_chunk(chunks[i].id) && insert_chunk(chunks[i]);
+        }
+    }
+    for (std::map<std::string, std::string>::const_iterator it = existing.begin();
+         ok && it != existing.end(); ++it) {
+        ok = remove_chunk(it->first);
+    }
+    ok = ok && upsert_file(file);
+    
+    if (!ok) {
+        rollback();
+        return false;
+    }
+    return commit();
+}
+
+bool MemoryStore::append_file_chunks(const MemoryFile& file, const std::vector<MemoryChunk>& chunks) {
+    if (!begin()) return false;
+    
+    bool ok = true;
+    for (size_t i = 0; ok && i < chunks.size(); ++i) {
+        ok = remove_chunk(chunks[i].id) && insert_chunk(chunks[i]);
+    }
+    ok = ok && upsert_file(file);
+    
+    if (!ok) {
+        rollback();
+        return false;
+    }
+    return commit();
+}
+
+bool MemoryStore::upsert_file(const MemoryFile& file) {
+    if (!db_) {
+        set_error("Database not open");
         return false;
     }
     
+    sqlite3_stmt* stmt = statement(
+        "INSERT OR REPLACE INTO files (path, source, abs_path, hash, mtime, size, inode) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?)");
+    if (!stmt) return false;
+    
     std::string source = memory_source_to_string(file.source);
     sqlite3_bind_text(stmt, 1, file.path.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, source.c_str(), -1, SQLITE_TRANSIENT);
@@ -168,16 +389,9 @@ bool MemoryStore::upsert_file(const MemoryFile& file) {
     sqlite3_bind_text(stmt, 4, file.hash.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int64(stmt, 5, file.mtime);
     sqlite3_bind_int64(stmt, 6, file.size);
+    sqlite3_bind_int64(stmt, 7, file.inode);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    if (rc != SQLITE_DONE) {
-        set_error_from_db();
-        return false;
-    }
-    
-    return true;
+    return step_done(stmt);
 }
 
 bool MemoryStore::delete_file(const std::string& path, MemorySource source) {
@@ -186,23 +400,14 @@ bool MemoryStore::delete_file(const std::string& path, MemorySource source) {
         return false;
     }
     
-    std::string src = memory_source_to_string(source);
-    
-    const char* sql = "DELETE FROM files WHERE path = ? AND source = ?";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        set_error_from_db();
-        return false;
-    }
+    sqlite3_stmt* stmt = statement("DELETE FROM files WHERE path = ? AND source = ?");
+    if (!stmt) return false;
     
+    std::string src = memory_source_to_string(source);
     sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, src.c_str(), -1, SQLITE_TRANSIENT);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    return rc == SQLITE_DONE;
+    return step_done(stmt);
 }
 
 bool MemoryStore::get_file(const std::string& path, MemorySource source, MemoryFile& out) {
@@ -213,33 +418,30 @@ bool MemoryStore::get_file(const std::string& path, MemorySource source, MemoryF
     
     std::string src = memory_source_to_string(source);
     
-    const char* sql = "SELECT path, source, abs_path, hash, mtime, size FROM files WHERE path = ? AND source = ?";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        set_error_from_db();
-        return false;
-    }
+    // Called for every file on every sync, so the statement is cached
+    sqlite3_stmt* stmt = statement(
+        "SELECT path, source, abs_path, hash, mtime, size, inode FROM files WHERE path = ? AND source = ?");
+    if (!stmt) return false;
     
     sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, src.c_str(), -1, SQLITE_TRANSIENT);
     
-    rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW) {
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        const char* abs = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        const char* hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
         out.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
         out.source = string_to_memory_source(
             reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))
         );
-        out.abs_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        out.hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        out.abs_path = abs ? abs : "";
+        out.hash = hash ? hash : "";
         out.mtime = sqlite3_column_int64(stmt, 4);
         out.size = sqlite3_column_int64(stmt, 5);
-        sqlite3_finalize(stmt);
-        return true;
+        out.inode = sqlite3_column_int64(stmt, 6);
     }
-    
-    sqlite3_finalize(stmt);
-    return false;
+    sqlite3_reset(stmt);
+    return found;
 }
 
 std::vector<MemoryFile> MemoryStore::list_files(MemorySource source) {
@@ -248,7 +450,7 @@ std::vector<MemoryFile> MemoryStore::list_files(MemorySource source) {
     
     std::string src = memory_source_to_string(source);
     
-    const char* sql = "SELECT path, source, abs_path, hash, mtime, size FROM files WHERE source = ?";
+    const char* sql = "SELECT path, source, abs_path, hash, mtime, size, inode FROM files WHERE source = ?";
     sqlite3_stmt* stmt = nullptr;
     int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
     if (rc != SQLITE_OK) return result;
@@ -267,6 +469,7 @@ std::vector<MemoryFile> MemoryStore::list_files(MemorySource source) {
         f.hash = hash ? hash : "";
         f.mtime = sqlite3_column_int64(stmt, 4);
         f.size = sqlite3_column_int64(stmt, 5);
+        f.inode = sqlite3_column_int64(stmt, 6);
         result.push_back(f);
     }
     
@@ -278,16 +481,10 @@ std::vector<std::string> MemoryStore::get_stale_paths(const std::vector<std::str
                                                        MemorySource source) {
     std::vector<std::string> stale;
     std::vector<MemoryFile> files = list_files(source);
+    std::set<std::string> active(active_paths.begin(), active_paths.end());
     
     for (const auto& f : files) {
-        bool found = false;
-        for (const auto& p : active_paths) {
-            if (p == f.path) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
+        if (!active.count(f.path)) {
             stale.push_back(f.path);
         }
     }
@@ -301,16 +498,23 @@ bool MemoryStore::upsert_chunk(const MemoryChunk& chunk) {
         return false;
     }
     
-    const char* sql = 
-        "INSERT OR REPLACE INTO chunks (id, path, source, start_line, end_line, text, hash, updated_at) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?)";
+    if (!begin()) return false;
     
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        set_error_from_db();
+    // A replaced row gets a new rowid; its old FTS row goes first
+    bool ok = remove_chunk(chunk.id) && insert_chunk(chunk);
+    
+    if (!ok) {
+        rollback();
         return false;
     }
+    return commit();
+}
+
+bool MemoryStore::insert_chunk(const MemoryChunk& chunk) {
+    sqlite3_stmt* stmt = statement(
+        "INSERT OR REPLACE INTO chunks (id, path, source, start_line, end_line, text, hash, updated_at) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    if (!stmt) return false;
     
     std::string source = memory_source_to_string(chunk.source);
     sqlite3_bind_text(stmt, 1, chunk.id.c_str(), -1, SQLITE_TRANSIENT);
@@ -321,53 +525,81 @@ bool MemoryStore::upsert_chunk(const MemoryChunk& chunk) {
     sqlite3_bind_text(stmt, 6, chunk.text.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 7, chunk.hash.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int64(stmt, 8, chunk.updated_at);
+    if (!step_done(stmt)) return false;
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    if (rc != SQLITE_DONE) {
-        set_error_from_db();
-        return false;
-    }
+    if (!fts_available_) return true;
     
-    // Sync to FTS if available
+    sqlite3_int64 rowid = sqlite3_last_insert_rowid(db_);
+    stmt = statement("INSERT INTO chunks_fts (rowid, text) VALUES (?, ?)");
+    if (!stmt) return false;
+    sqlite3_bind_int64(stmt, 1, rowid);
+    sqlite3_bind_text(stmt, 2, chunk.text.c_str(), -1, SQLITE_TRANSIENT);
+    return step_done(stmt);
+}
+
+bool MemoryStore::remove_chunk(const std::string& id) {
     if (fts_available_) {
-        sync_chunk_to_fts(chunk);
+        sqlite3_stmt* stmt = statement(
+            "DELETE FROM chunks_fts WHERE rowid = (SELECT rowid FROM chunks WHERE id = ?)");
+        if (!stmt) return false;
+        sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        if (!step_done(stmt)) return false;
     }
     
-    return true;
+    sqlite3_stmt* stmt = statement("DELETE FROM chunks WHERE id = ?");
+    if (!stmt) return false;
+    sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+    return step_done(stmt);
 }
 
-bool MemoryStore::sync_chunk_to_fts(const MemoryChunk& chunk) {
-    // Delete any existing entry first
-    delete_chunk_from_fts(chunk.id);
-    
-    const char* sql = "INSERT INTO chunks_fts (chunk_id, path, source, text) VALUES (?, ?, ?, ?)";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) return false;
-    
-    std::string source = memory_source_to_string(chunk.source);
-    sqlite3_bind_text(stmt, 1, chunk.id.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, chunk.path.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, source.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, chunk.text.c_str(), -1, SQLITE_TRANSIENT);
+bool MemoryStore::update_chunk_lines(const MemoryChunk& chunk) {
+    sqlite3_stmt* stmt = statement(
+        "UPDATE chunks SET start_line = ?, end_line = ? "
+        "WHERE id = ? AND (start_line IS NOT ? OR end_line IS NOT ?)");
+    if (!stmt) return false;
+    sqlite3_bind_int(stmt, 1, chunk.start_line);
+    sqlite3_bind_int(stmt, 2, chunk.end_line);
+    sqlite3_bind_text(stmt, 3, chunk.id.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 4, chunk.start_line);
+    sqlite3_bind_int(stmt, 5, chunk.end_line);
+    return step_done(stmt);
+}
+
+bool MemoryStore::list_file_chunks(const std::string& path, const std::string& source,
+                                   std::map<std::string, std::string>& out) {
+    sqlite3_stmt* stmt = statement("SELECT id, hash FROM chunks WHERE path = ? AND source = ?");
+    if (!stmt) return false;
+    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, source.c_str(), -1, SQLITE_TRANSIENT);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        const char* hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        out[id ? id : ""] = hash ? hash : "";
+    }
+    if (rc != SQLITE_DONE) set_error_from_db();
+    sqlite3_reset(stmt);
     return rc == SQLITE_DONE;
 }
 
-bool MemoryStore::delete_chunk_from_fts(const std::string& chunk_id) {
-    const char* sql = "DELETE FROM chunks_fts WHERE chunk_id = ?";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) return false;
+bool MemoryStore::remove_file_chunks(const std::string& path, const std::string& source) {
+    // FTS rows are found through the chunks index, never by scanning the FTS table
+    if (fts_available_) {
+        sqlite3_stmt* stmt = statement(
+            "DELETE FROM chunks_fts WHERE rowid IN "
+            "(SELECT rowid FROM chunks WHERE path = ? AND source = ?)");
+        if (!stmt) return false;
+        sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, source.c_str(), -1, SQLITE_TRANSIENT);
+        if (!step_done(stmt)) return false;
+    }
     
-    sqlite3_bind_text(stmt, 1, chunk_id.c_str(), -1, SQLITE_TRANSIENT);
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    return rc == SQLITE_DONE;
+    sqlite3_stmt* stmt = statement("DELETE FROM chunks WHERE path = ? AND source = ?");
+    if (!stmt) return false;
+    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, source.c_str(), -1, SQLITE_TRANSIENT);
+    return step_done(stmt);
 }
 
 bool MemoryStore::delete_chunks_for_file(const std::string& path, MemorySource source) {
@@ -376,35 +608,12 @@ bool MemoryStore::delete_chunks_for_file(const std::string& path, MemorySource s
         return false;
     }
     
-    std::string src = memory_source_to_string(source);
-    
-    // Delete from FTS first if available
-    if (fts_available_) {
-        const char* fts_sql = "DELETE FROM chunks_fts WHERE path = ? AND source = ?";
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db_, fts_sql, -1, &stmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 2, src.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_step(stmt);
-            sqlite3_finalize(stmt);
-        }
-    }
-    
-    const char* sql = "DELETE FROM chunks WHERE path = ? AND source = ?";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        set_error_from_db();
+    if (!begin()) return false;
+    if (!remove_file_chunks(path, memory_source_to_string(source))) {
+        rollback();
         return false;
     }
-    
-    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, src.c_str(), -1, SQLITE_TRANSIENT);
-    
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    return rc == SQLITE_DONE;
+    return commit();
 }
 
 std::vector<MemoryChunk> MemoryStore::get_chunks_for_file(const std::string& path, MemorySource source) {
@@ -415,8 +624,9 @@ std::vector<MemoryChunk> MemoryStore::get_chunks_for_file(const std::string& pat
     
     const char* sql = "SELECT id, path, source, start_line, end_line, text, hash, updated_at "
                       "FROM chunks WHERE path = ? AND source = ? ORDER BY start_line";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return result;
+    ReadLease conn(*this);
+    sqlite3_stmt* stmt = conn.statement(sql);
+    if (!stmt) return result;
     
     sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, src.c_str(), -1, SQLITE_TRANSIENT);
@@ -438,7 +648,6 @@ std::vector<MemoryChunk> MemoryStore::get_chunks_for_file(const std::string& pat
         result.push_back(c);
     }
     
-    sqlite3_finalize(stmt);
     return result;
 }
 
@@ -448,8 +657,9 @@ int MemoryStore::count_chunks(MemorySource source) {
     std::string src = memory_source_to_string(source);
     
     const char* sql = "SELECT COUNT(*) FROM chunks WHERE source = ?";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return 0;
+    ReadLease conn(*this);
+    sqlite3_stmt* stmt = conn.statement(sql);
+    if (!stmt) return 0;
     
     sqlite3_bind_text(stmt, 1, src.c_str(), -1, SQLITE_TRANSIENT);
     
@@ -458,32 +668,120 @@ int MemoryStore::count_chunks(MemorySource source) {
         count = sqlite3_column_int(stmt, 0);
     }
     
-    sqlite3_finalize(stmt);
     return count;
 }
 
+int MemoryStore::max_end_line(const std::string& path, MemorySource source) {
+    if (!db_) return 0;
+    
+    sqlite3_stmt* stmt = statement("SELECT MAX(end_line) FROM chunks WHERE path = ? AND source = ?");
+    if (!stmt) return 0;
+    
+    std::string src = memory_source_to_string(source);
+    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, src.c_str(), -1, SQLITE_TRANSIENT);
+    
+    int line = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        line = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_reset(stmt);
+    return line;
+}
+
+// Words of the query as quoted FTS terms joined by OR, so punctuation
+// in natural-language questions cannot break the MATCH syntax
+std::string MemoryStore::fts_query(const std::string& query) {
+    std::string out;
+    std::string word;
+    for (size_t i = 0; i <= query.size(); ++i) {
+        unsigned char c = i < query.size() ? static_cast<unsigned char>(query[i]) : ' ';
+        if (std::isalnum(c) || c >= 0x80 || c == '_') {
+            word += static_cast<char>(c);
+            continue;
+        }
+        if (!word.empty()) {
+            if (!out.empty()) out += " OR ";
+            out += "\"" + word + "\"";
+            word.clear();
+        }
+    }
+    return out;
+}
+
+namespace {
+
+// Shrink a hit's line range to the lines its snippet was cut from
+void narrow_lines(const std::string& chunk, const std::string& snippet, MemorySearchResult& r) {
+    size_t at = snippet.empty() ? std::string::npos : chunk.find(snippet);
+    if (at == std::string::npos) return;
+    int first = r.start_line + static_cast<int>(std::count(chunk.begin(), chunk.begin() + at, '\n'));
+    int last = first + static_cast<int>(std::count(snippet.begin(), snippet.end(), '\n'));
+    r.start_line = first;
+    r.end_line = std::min(last, r.end_line);
+}
+
+}
+
 std::vector<MemorySearchResult> MemoryStore::search(const std::string& query, 
                                                      const MemorySearchConfig& config) {
     std::vector<MemorySearchResult> results;
     if (!db_ || query.empty()) return results;
     
-    // Use FTS if available
-    if (fts_available_) {
-        const char* sql = 
-            "SELECT chunk_id, path, source, text, bm25(chunks_fts) as score "
-            "FROM chunks_fts "
-            "WHERE chunks_fts MATCH ? "
-            "ORDER BY score "
-            "LIMIT ?";
+    ReadLease conn(*this);
+    
+    // Use FTS if available; the text column is whatever the caller will
+    // actually show, so a hit never copies more of the chunk than that
+    std::string match = fts_query(query);
+    if (fts_available_ && !match.empty()) {
+        bool windowed = !config.ids_only && config.snippet_tokens > 0;
+        const char* sql;
+        if (config.ids_only) {
+            sql = "SELECT c.id, c.path, c.source, NULL, bm25(chunks_fts) AS score, c.start_line, c.end_line "
+                  "FROM chunks_fts JOIN chunks c ON c.rowid = chunks_fts.rowid "
+                  "WHERE chunks_fts MATCH ?1 "
+                  "ORDER BY score "
+                  "LIMIT ?2";
+        } else if (windowed) {
+            // Plain snippet and chunk text locate the window's lines for citations
+            sql = "SELECT c.id, c.path, c.source, snippet(chunks_fts, 0, ?3, ?4, '...', ?5), "
+                  "bm25(chunks_fts) AS score, c.start_line, c.end_line, "
+                  "snippet(chunks_fts, 0, '', '', '', ?5), c.text "
+                  "FROM chunks_fts JOIN chunks c ON c.rowid = chunks_fts.rowid "
+                  "WHERE chunks_fts MATCH ?1 "
+                  "ORDER BY score "
+                  "LIMIT ?2";
+        } else if (!config.highlight_open.empty() || !config.highlight_close.empty()) {
+            sql = "SELECT c.id, c.path, c.source, highlight(chunks_fts, 0, ?3, ?4), "
+                  "bm25(chunks_fts) AS score, c.start_line, c.end_line "
+                  "FROM chunks_fts JOIN chunks c ON c.rowid = chunks_fts.rowid "
+                  "WHERE chunks_fts MATCH ?1 "
+                  "ORDER BY score "
+                  "LIMIT ?2";
+        } else {
+            sql = "SELECT c.id, c.path, c.source, c.text, bm25(chunks_fts) AS score, c.start_line, c.end_line "
+                  "FROM chunks_fts JOIN chunks c ON c.rowid = chunks_fts.rowid "
+                  "WHERE chunks_fts MATCH ?1 "
+                  "ORDER BY score "
+                  "LIMIT ?2";
+        }
         
-        sqlite3_stmt* stmt = nullptr;
-        if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, query.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_stmt* stmt = conn.statement(sql);
+        if (stmt) {
+            sqlite3_bind_text(stmt, 1, match.c_str(), -1, SQLITE_TRANSIENT);
             sqlite3_bind_int(stmt, 2, config.max_results);
+            if (sqlite3_bind_parameter_count(stmt) >= 4) {
+                sqlite3_bind_text(stmt, 3, config.highlight_open.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(stmt, 4, config.highlight_close.c_str(), -1, SQLITE_TRANSIENT);
+            }
+            if (windowed) {
+                // FTS5 rejects windows over 64 tokens
+                sqlite3_bind_int(stmt, 5, std::min(config.snippet_tokens, 64));
+            }
             
             while (sqlite3_step(stmt) == SQLITE_ROW) {
                 MemorySearchResult r;
-                // chunk_id not used but we retrieve it
+                r.chunk_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
                 r.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
                 r.source = string_to_memory_source(
                     reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2))
@@ -492,16 +790,20 @@ std::vector<MemorySearchResult> MemoryStore::search(const std::string& query,
                 r.snippet = txt ? txt : "";
                 // BM25 returns negative scores, lower is better, convert to 0-1 range
                 double raw_score = sqlite3_column_double(stmt, 4);
-                r.score = 1.0 / (1.0 - raw_score);  // Normalize
-                r.start_line = 0;
-                r.end_line = 0;
+                r.score = -raw_score / (1.0 - raw_score);  // Normalize
+                r.start_line = sqlite3_column_int(stmt, 5);
+                r.end_line = sqlite3_column_int(stmt, 6);
+                if (windowed) {
+                    const char* plain = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 7));
+                    const char* chunk = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 8));
+                    if (plain && chunk) narrow_lines(chunk, plain, r);
+                }
                 
                 if (r.score >= config.min_score) {
                     results.push_back(r);
                 }
             }
             
-            sqlite3_finalize(stmt);
             return results;
         }
     }
@@ -512,8 +814,8 @@ std::vector<MemorySearchResult> MemoryStore::search(const std::string& query,
         "WHERE text LIKE ? "
         "LIMIT ?";
     
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return results;
+    sqlite3_stmt* stmt = conn.statement(sql);
+    if (!stmt) return results;
     
     std::string like_query = "%" + query + "%";
     sqlite3_bind_text(stmt, 1, like_query.c_str(), -1, SQLITE_TRANSIENT);
@@ -521,22 +823,198 @@ std::vector<MemorySearchResult> MemoryStore::search(const std::string& query,
     
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         MemorySearchResult r;
+        r.chunk_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
         r.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         r.source = string_to_memory_source(
             reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2))
         );
         r.start_line = sqlite3_column_int(stmt, 3);
         r.end_line = sqlite3_column_int(stmt, 4);
-        const char* txt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
-        r.snippet = txt ? txt : "";
+        if (!config.ids_only) {
+            const char* txt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+            r.snippet = excerpt(txt ? txt : "", query, config);
+        }
         r.score = 0.5;  // Fixed score for LIKE matches
         results.push_back(r);
     }
     
-    sqlite3_finalize(stmt);
     return results;
 }
 
+std::string MemoryStore::excerpt(const std::string& text, const std::string& query,
+                                 const MemorySearchConfig& config) {
+    if (config.ids_only) return std::string();
+    if (config.snippet_tokens <= 0) return text;
+    
+    // Whitespace-separated words stand in for FTS5 tokens
+    std::vector<std::pair<size_t, size_t> > words;
+    for (size_t i = 0; i < text.size(); ) {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+        size_t start = i;
+        while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i]))) ++i;
+        if (i > start) words.push_back(std::make_pair(start, i));
+    }
+    
+    std::vector<std::string> terms;
+    std::string term;
+    for (size_t i = 0; i <= query.size(); ++i) {
+        unsigned char c = i < query.size() ? static_cast<unsigned char>(query[i]) : ' ';
+        if (std::isalnum(c) || c >= 0x80 || c == '_') {
+            term += static_cast<char>(std::tolower(c));
+        } else if (!term.empty()) {
+            terms.push_back(term);
+            term.clear();
+        }
+    }
+    
+    std::vector<bool> hit(words.size(), false);
+    size_t first = words.size();
+    for (size_t w = 0; w < words.size(); ++w) {
+        std::string word = text.substr(words[w].first, words[w].second - words[w].first);
+        for (size_t k = 0; k < word.size(); ++k) {
+            word[k] = static_cast<char>(std::tolower(static_cast<unsigned char>(word[k])));
+        }
+        for (size_t t = 0; t < terms.size() && !hit[w]; ++t) {
+            hit[w] = word.find(terms[t]) != std::string::npos;
+        }
+        if (hit[w] && first == words.size()) first = w;
+    }
+    
+    // Like FTS5, keep a little context before the first match
+    size_t window = static_cast<size_t>(std::min(config.snippet_tokens, 64));
+    size_t begin = first < words.size() && first > window / 4 ? first - window / 4 : 0;
+    size_t end = std::min(words.size(), begin + window);
+    if (end - begin < window) begin = end > window ? end - window : 0;
+    
+    std::string out;
+    if (begin > 0) out += "...";
+    for (size_t w = begin; w < end; ++w) {
+        if (w > begin) out.append(text, words[w - 1].second, words[w].first - words[w - 1].second);
+        if (hit[w]) out += config.highlight_open;
+        out.append(text, words[w].first, words[w].second - words[w].first);
+        if (hit[w]) out += config.highlight_close;
+    }
+    if (end < words.size()) out += "...";
+    return out;
+}
+
+std::vector<MemoryChunk> MemoryStore::get_chunks(const std::vector<std::string>& ids) {
+    std::vector<MemoryChunk> result;
+    if (!db_ || ids.empty()) return result;
+    
+    const char* sql = "SELECT id, path, source, start_line, end_line, text, hash, updated_at "
+                      "FROM chunks WHERE id = ?";
+    ReadLease conn(*this);
+    sqlite3_stmt* stmt = conn.statement(sql);
+    if (!stmt) return result;
+    
+    for (size_t i = 0; i < ids.size(); ++i) {
+        sqlite3_bind_text(stmt, 1, ids[i].c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            MemoryChunk c;
+            c.id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            c.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            c.source = string_to_memory_source(
+                reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2))
+            );
+            c.start_line = sqlite3_column_int(stmt, 3);
+            c.end_line = sqlite3_column_int(stmt, 4);
+            const char* txt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+            c.text = txt ? txt : "";
+            const char* hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
+            c.hash = hash ? hash : "";
+            c.updated_at = sqlite3_column_int64(stmt, 7);
+            result.push_back(c);
+        }
+        sqlite3_reset(stmt);
+    }
+    
+    return result;
+}
+
+std::vector<std::pair<std::string, std::string> > MemoryStore::list_chunk_hashes() {
+    std::vector<std::pair<std::string, std::string> > result;
+    if (!db_) return result;
+    
+    const char* sql = "SELECT id, hash FROM chunks";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return result;
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        result.push_back(std::make_pair(
+            std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))),
+            std::string(hash ? hash : "")));
+    }
+    
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+// Embedding operations
+bool MemoryStore::get_embedding(const std::string& hash, const std::string& model, std::vector<float>& out) {
+    if (!db_) return false;
+    
+    const char* sql = "SELECT dims, vector FROM embeddings WHERE hash = ? AND model = ?";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+    
+    sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, model.c_str(), -1, SQLITE_TRANSIENT);
+    
+    bool found = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        int dims = sqlite3_column_int(stmt, 0);
+        const void* blob = sqlite3_column_blob(stmt, 1);
+        int bytes = sqlite3_column_bytes(stmt, 1);
+        if (blob && dims > 0 && bytes == dims * static_cast<int>(sizeof(float))) {
+            out.resize(dims);
+            std::memcpy(&out[0], blob, bytes);
+            found = true;
+        }
+    }
+    
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool MemoryStore::put_embedding(const std::string& hash, const std::string& model, const std::vector<float>& vec) {
+    if (!db_) {
+        set_error("Database not open");
+        return false;
+    }
+    if (vec.empty()) return false;
+    
+    const char* sql = "INSERT OR REPLACE INTO embeddings (hash, model, dims, vector) VALUES (?, ?, ?, ?)";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        set_error_from_db();
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, model.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, static_cast<int>(vec.size()));
+    sqlite3_bind_blob(stmt, 4, &vec[0], static_cast<int>(vec.size() * sizeof(float)), SQLITE_TRANSIENT);
+    
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    if (rc != SQLITE_DONE) {
+        set_error_from_db();
+        return false;
+    }
+    return true;
+}
+
+int MemoryStore::prune_embeddings() {
+    if (!db_) return 0;
+    if (!exec("DELETE FROM embeddings WHERE hash NOT IN (SELECT hash FROM chunks WHERE hash IS NOT NULL)")) {
+        return 0;
+    }
+    return sqlite3_changes(db_);
+}
+
 // Task operations
 bool MemoryStore::upsert_task(const MemoryTask& task) {
     if (!db_) {
@@ -545,8 +1023,8 @@ bool MemoryStore::upsert_task(const MemoryTask& task) {
     }
     
     const char* sql = 
-        "INSERT OR REPLACE INTO tasks (id, content, context, channel, user_id, created_at, due_at, completed, completed_at) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        "INSERT OR REPLACE INTO tasks (id, content, context, channel, user_id, created_at, due_at, completed, completed_at, notified_at) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
     
     sqlite3_stmt* stmt = nullptr;
     int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
@@ -564,6 +1042,7 @@ bool MemoryStore::upsert_task(const MemoryTask& task) {
     sqlite3_bind_int64(stmt, 7, task.due_at);
     sqlite3_bind_int(stmt, 8, task.completed ? 1 : 0);
     sqlite3_bind_int64(stmt, 9, task.completed_at);
+    sqlite3_bind_int64(stmt, 10, task.notified_at);
     
     rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
@@ -594,14 +1073,14 @@ bool MemoryStore::delete_task(const std::string& id) {
 bool MemoryStore::get_task(const std::string& id, MemoryTask& out) {
     if (!db_) return false;
     
-    const char* sql = "SELECT id, content, context, channel, user_id, created_at, due_at, completed, completed_at FROM tasks WHERE id = ?";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) return false;
+    const char* sql = "SELECT id, content, context, channel, user_id, created_at, due_at, completed, completed_at, notified_at FROM tasks WHERE id = ?";
+    ReadLease conn(*this);
+    sqlite3_stmt* stmt = conn.statement(sql);
+    if (!stmt) return false;
     
     sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_TRANSIENT);
     
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         out.id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
         out.content = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
@@ -615,11 +1094,10 @@ bool MemoryStore::get_task(const std::string& id, MemoryTask& out) {
         out.due_at = sqlite3_column_int64(stmt, 6);
         out.completed = sqlite3_column_int(stmt, 7) != 0;
         out.completed_at = sqlite3_column_int64(stmt, 8);
-        sqlite3_finalize(stmt);
+        out.notified_at = sqlite3_column_int64(stmt, 9);
         return true;
     }
     
-    sqlite3_finalize(stmt);
     return false;
 }
 
@@ -627,14 +1105,15 @@ std::vector<MemoryTask> MemoryStore::list_tasks(bool include_completed) {
     std::vector<MemoryTask> result;
     if (!db_) return result;
     
-    std::string sql = "SELECT id, content, context, channel, user_id, created_at, due_at, completed, completed_at FROM tasks";
+    std::string sql = "SELECT id, content, context, channel, user_id, created_at, due_at, completed, completed_at, notified_at FROM tasks";
     if (!include_completed) {
         sql += " WHERE completed = 0";
     }
     sql += " ORDER BY due_at ASC, created_at ASC";
     
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return result;
+    ReadLease conn(*this);
+    sqlite3_stmt* stmt = conn.statement(sql.c_str());
+    if (!stmt) return result;
     
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         MemoryTask t;
@@ -650,10 +1129,10 @@ std::vector<MemoryTask> MemoryStore::list_tasks(bool include_completed) {
         t.due_at = sqlite3_column_int64(stmt, 6);
         t.completed = sqlite3_column_int(stmt, 7) != 0;
         t.completed_at = sqlite3_column_int64(stmt, 8);
+        t.notified_at = sqlite3_column_int64(stmt, 9);
         result.push_back(t);
     }
     
-    sqlite3_finalize(stmt);
     return result;
 }
 
@@ -665,10 +1144,11 @@ std::vector<MemoryTask> MemoryStore::get_tasks_due_before(int64_t timestamp) {
     std::vector<MemoryTask> result;
     if (!db_) return result;
     
-    const char* sql = "SELECT id, content, context, channel, user_id, created_at, due_at, completed, completed_at "
+    const char* sql = "SELECT id, content, context, channel, user_id, created_at, due_at, completed, completed_at, notified_at "
                       "FROM tasks WHERE completed = 0 AND due_at > 0 AND due_at <= ? ORDER BY due_at ASC";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return result;
+    ReadLease conn(*this);
+    sqlite3_stmt* stmt = conn.statement(sql);
+    if (!stmt) return result;
     
     sqlite3_bind_int64(stmt, 1, timestamp);
     
@@ -686,10 +1166,10 @@ std::vector<MemoryTask> MemoryStore::get_tasks_due_before(int64_t timestamp) {
         t.due_at = sqlite3_column_int64(stmt, 6);
         t.completed = sqlite3_column_int(stmt, 7) != 0;
         t.completed_at = sqlite3_column_int64(stmt, 8);
+        t.notified_at = sqlite3_column_int64(stmt, 9);
         result.push_back(t);
     }
     
-    sqlite3_finalize(stmt);
     return result;
 }
 
@@ -713,6 +1193,16 @@ bool MemoryStore::complete_task(const std::string& id) {
     return rc == SQLITE_DONE;
 }
 
+bool MemoryStore::mark_task_notified(const std::string& id, int64_t at) {
+    if (!db_) return false;
+    
+    sqlite3_stmt* stmt = statement("UPDATE tasks SET notified_at = ? WHERE id = ?");
+    if (!stmt) return false;
+    sqlite3_bind_int64(stmt, 1, at);
+    sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_TRANSIENT);
+    return step_done(stmt);
+}
+
 // Meta operations
 bool MemoryStore::set_meta(const std::string& key, const std::string& value) {
     if (!db_) return false;
@@ -735,9 +1225,9 @@ std::string MemoryStore::get_meta(const std::string& key, const std::string& def
     if (!db_) return default_val;
     
     const char* sql = "SELECT value FROM meta WHERE key = ?";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) return default_val;
+    ReadLease conn(*this);
+    sqlite3_stmt* stmt = conn.statement(sql);
+    if (!stmt) return default_val;
     
     sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
     
@@ -747,14 +1237,28 @@ std::string MemoryStore::get_meta(const std::string& key, const std::string& def
         if (val) result = val;
     }
     
-    sqlite3_finalize(stmt);
     return result;
 }
 
 std::string MemoryStore::last_error() const {
+    std::lock_guard<std::mutex> lock(error_mutex_);
     return last_error_;
 }
 
+bool MemoryStore::has_column(const std::string& table, const std::string& column) {
+    sqlite3_stmt* stmt = nullptr;
+    std::string sql = "PRAGMA table_info(" + table + ")";
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return false;
+    
+    bool found = false;
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        found = name && column == name;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
 bool MemoryStore::exec(const std::string& sql) {
     std::string error;
     return exec(sql, error);
@@ -766,7 +1270,7 @@ bool MemoryStore::exec(const std::string& sql, std::string& error) {
     if (rc != SQLITE_OK) {
         if (err_msg) {
             error = err_msg;
-            last_error_ = err_msg;
+            set_error(err_msg);
             sqlite3_free(err_msg);
         }
         return false;
@@ -775,12 +1279,13 @@ bool MemoryStore::exec(const std::string& sql, std::string& error) {
 }
 
 void MemoryStore::set_error(const std::string& error) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
     last_error_ = error;
 }
 
 void MemoryStore::set_error_from_db() {
     if (db_) {
-        last_error_ = sqlite3_errmsg(db_);
+        set_error(sqlite3_errmsg(db_));
     }
 }
 
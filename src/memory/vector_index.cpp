@@ -0,0 +1,370 @@
+/*
+ * OpenClaw C++11 - Memory Vector Index Implementation
+ */
+#include <openclaw/memory/vector_index.hpp>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <fstream>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace openclaw {
+
+namespace {
+
+const char snapshot_magic[4] = { 'O', 'C', 'V', 'X' };
+const uint32_t snapshot_version = 1;
+const int kmeans_iterations = 6;
+const size_t samples_per_list = 32;
+const size_t max_lists = 4096;
+
+template <typename T>
+void put(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool get(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+void put_string(std::ofstream& out, const std::string& s) {
+    put<uint32_t>(out, static_cast<uint32_t>(s.size()));
+    out.write(s.data(), s.size());
+}
+
+bool get_string(std::ifstream& in, std::string& s) {
+    uint32_t len = 0;
+    if (!get(in, len) || len > (1u << 20)) return false;
+    s.resize(len);
+    return len == 0 || static_cast<bool>(in.read(&s[0], len));
+}
+
+void normalize(float* v, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) sum += static_cast<double>(v[i]) * v[i];
+    if (sum <= 0) return;
+    float scale = static_cast<float>(1.0 / std::sqrt(sum));
+    for (size_t i = 0; i < n; ++i) v[i] *= scale;
+}
+
+}
+
+const size_t VectorIndex::MIN_TRAIN;
+const uint32_t VectorIndex::NO_LIST;
+
+VectorIndex::VectorIndex() : dims_(0), trained_size_(0) {}
+
+float VectorIndex::dot(const float* a, const float* b, size_t n) {
+    size_t i = 0;
+    float sum = 0;
+#if defined(__SSE__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+void VectorIndex::reset(size_t dims) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reset_locked(dims);
+}
+
+void VectorIndex::reset_locked(size_t dims) {
+    dims_ = dims;
+    data_.clear();
+    ids_.clear();
+    list_of_.clear();
+    free_.clear();
+    slot_of_.clear();
+    centroids_.clear();
+    lists_.clear();
+    trained_size_ = 0;
+}
+
+uint32_t VectorIndex::nearest_list_locked(const float* v) const {
+    uint32_t best = 0;
+    float best_score = -2.0f;
+    for (size_t l = 0; l < lists_.size(); ++l) {
+        float s = dot(v, &centroids_[l * dims_], dims_);
+        if (s > best_score) {
+            best_score = s;
+            best = static_cast<uint32_t>(l);
+        }
+    }
+    return best;
+}
+
+bool VectorIndex::add(const std::string& id, const std::vector<float>& vec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id.empty() || vec.empty()) return false;
+    if (slot_of_.empty() && vec.size() != dims_) reset_locked(vec.size());
+    if (vec.size() != dims_) return false;
+
+    size_t slot;
+    std::unordered_map<std::string, size_t>::iterator it = slot_of_.find(id);
+    if (it != slot_of_.end()) {
+        slot = it->second;
+        if (list_of_[slot] != NO_LIST) {
+            std::vector<uint32_t>& list = lists_[list_of_[slot]];
+            list.erase(std::find(list.begin(), list.end(), static_cast<uint32_t>(slot)));
+        }
+    } else if (!free_.empty()) {
+        slot = free_.back();
+        free_.pop_back();
+    } else {
+        slot = ids_.size();
+        ids_.push_back(std::string());
+        list_of_.push_back(NO_LIST);
+        data_.resize(data_.size() + dims_);
+    }
+
+    std::copy(vec.begin(), vec.end(), data_.begin() + slot * dims_);
+    ids_[slot] = id;
+    slot_of_[id] = slot;
+    list_of_[slot] = NO_LIST;
+    if (!lists_.empty()) {
+        uint32_t l = nearest_list_locked(vec_locked(slot));
+        lists_[l].push_back(static_cast<uint32_t>(slot));
+        list_of_[slot] = l;
+    }
+
+    // Centroids drift as the corpus grows; re-cluster each time it doubles
+    if (slot_of_.size() >= MIN_TRAIN && slot_of_.size() >= 2 * trained_size_) {
+        train_locked();
+    }
+    return true;
+}
+
+void VectorIndex::remove(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<std::string, size_t>::iterator it = slot_of_.find(id);
+    if (it == slot_of_.end()) return;
+    size_t slot = it->second;
+    slot_of_.erase(it);
+    if (list_of_[slot] != NO_LIST) {
+        std::vector<uint32_t>& list = lists_[list_of_[slot]];
+        std::vector<uint32_t>::iterator pos = std::find(list.begin(), list.end(), static_cast<uint32_t>(slot));
+        *pos = list.back();
+        list.pop_back();
+    }
+    ids_[slot].clear();
+    list_of_[slot] = NO_LIST;
+    free_.push_back(slot);
+}
+
+bool VectorIndex::contains(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slot_of_.count(id) > 0;
+}
+
+std::vector<std::string> VectorIndex::ids() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> out;
+    out.reserve(slot_of_.size());
+    for (std::unordered_map<std::string, size_t>::const_iterator it = slot_of_.begin(); it != slot_of_.end(); ++it) {
+        out.push_back(it->first);
+    }
+    return out;
+}
+
+size_t VectorIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slot_of_.size();
+}
+
+size_t VectorIndex::dims() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dims_;
+}
+
+size_t VectorIndex::lists() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lists_.size();
+}
+
+void VectorIndex::train_locked() {
+    std::vector<size_t> live;
+    live.reserve(slot_of_.size());
+    for (size_t slot = 0; slot < ids_.size(); ++slot) {
+        if (!ids_[slot].empty()) live.push_back(slot);
+    }
+    size_t n = live.size();
+    size_t nlist = std::min(max_lists, std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(n)))));
+
+    // Cluster an evenly spread sample; assigning everything comes after
+    size_t sample_size = std::min(n, nlist * samples_per_list);
+    std::vector<size_t> sample(sample_size);
+    for (size_t i = 0; i < sample_size; ++i) sample[i] = live[i * n / sample_size];
+
+    std::vector<float> centroids(nlist * dims_);
+    for (size_t l = 0; l < nlist; ++l) {
+        const float* v = vec_locked(sample[l * sample_size / nlist]);
+        std::copy(v, v + dims_, centroids.begin() + l * dims_);
+    }
+
+    lists_.assign(nlist, std::vector<uint32_t>());
+    centroids_.swap(centroids);
+    std::vector<float> sums(nlist * dims_);
+    std::vector<size_t> counts(nlist);
+    for (int iter = 0; iter < kmeans_iterations; ++iter) {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t i = 0; i < sample_size; ++i) {
+            const float* v = vec_locked(sample[i]);
+            uint32_t l = nearest_list_locked(v);
+            float* sum = &sums[l * dims_];
+            for (size_t d = 0; d < dims_; ++d) sum[d] += v[d];
+            counts[l]++;
+        }
+        // Spherical k-means: centroids stay unit length; empty ones keep their place
+        for (size_t l = 0; l < nlist; ++l) {
+            if (counts[l] == 0) continue;
+            normalize(&sums[l * dims_], dims_);
+            std::copy(sums.begin() + l * dims_, sums.begin() + (l + 1) * dims_, centroids_.begin() + l * dims_);
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t l = nearest_list_locked(vec_locked(live[i]));
+        lists_[l].push_back(static_cast<uint32_t>(live[i]));
+        list_of_[live[i]] = l;
+    }
+    trained_size_ = n;
+}
+
+std::vector<VectorIndex::Hit> VectorIndex::search(const std::vector<float>& query, size_t k,
+                                                  size_t nprobe) const {
+    std::vector<Hit> hits;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (k == 0 || slot_of_.empty() || query.size() != dims_) return hits;
+
+    // Min-heap of the best k (score, slot)
+    typedef std::pair<float, size_t> Scored;
+    std::priority_queue<Scored, std::vector<Scored>, std::greater<Scored> > best;
+    const float* q = &query[0];
+    auto consider = [&](size_t slot) {
+        float s = dot(q, vec_locked(slot), dims_);
+        if (best.size() < k) {
+            best.push(Scored(s, slot));
+        } else if (s > best.top().first) {
+            best.pop();
+            best.push(Scored(s, slot));
+        }
+    };
+
+    if (lists_.empty()) {
+        for (size_t slot = 0; slot < ids_.size(); ++slot) {
+            if (!ids_[slot].empty()) consider(slot);
+        }
+    } else {
+        std::vector<Scored> order(lists_.size());
+        for (size_t l = 0; l < lists_.size(); ++l) {
+            order[l] = Scored(dot(q, &centroids_[l * dims_], dims_), l);
+        }
+        size_t probe = std::min(std::max<size_t>(nprobe, 1), order.size());
+        std::partial_sort(order.begin(), order.begin() + probe, order.end(), std::greater<Scored>());
+        for (size_t p = 0; p < probe; ++p) {
+            const std::vector<uint32_t>& list = lists_[order[p].second];
+            for (size_t i = 0; i < list.size(); ++i) consider(list[i]);
+        }
+    }
+
+    hits.resize(best.size());
+    for (size_t i = hits.size(); i-- > 0; best.pop()) {
+        hits[i] = Hit(ids_[best.top().second], best.top().first);
+    }
+    return hits;
+}
+
+bool VectorIndex::save(const std::string& path, const std::string& tag) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(snapshot_magic, sizeof(snapshot_magic));
+        put<uint32_t>(out, snapshot_version);
+        put_string(out, tag);
+        put<uint64_t>(out, dims_);
+        put<uint64_t>(out, lists_.size());
+        put<uint64_t>(out, trained_size_);
+        if (!centroids_.empty()) {
+            out.write(reinterpret_cast<const char*>(&centroids_[0]), centroids_.size() * sizeof(float));
+        }
+        put<uint64_t>(out, slot_of_.size());
+        for (size_t slot = 0; slot < ids_.size(); ++slot) {
+            if (ids_[slot].empty()) continue;
+            put_string(out, ids_[slot]);
+            put<uint32_t>(out, list_of_[slot]);
+            out.write(reinterpret_cast<const char*>(vec_locked(slot)), dims_ * sizeof(float));
+        }
+        if (!out.flush()) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool VectorIndex::load(const std::string& path, const std::string& tag) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reset_locked(0);
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    std::string stored_tag;
+    uint64_t dims = 0, nlist = 0, trained = 0, count = 0;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, snapshot_magic, sizeof(magic)) != 0 ||
+        !get(in, version) || version != snapshot_version ||
+        !get_string(in, stored_tag) || stored_tag != tag ||
+        !get(in, dims) || !get(in, nlist) || !get(in, trained) || dims == 0 || nlist > max_lists) {
+        return false;
+    }
+
+    reset_locked(static_cast<size_t>(dims));
+    centroids_.resize(nlist * dims_);
+    lists_.assign(nlist, std::vector<uint32_t>());
+    if (nlist > 0 && !in.read(reinterpret_cast<char*>(&centroids_[0]), centroids_.size() * sizeof(float))) {
+        reset_locked(0);
+        return false;
+    }
+    if (!get(in, count)) {
+        reset_locked(0);
+        return false;
+    }
+
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string id;
+        uint32_t list = NO_LIST;
+        size_t slot = ids_.size();
+        data_.resize(data_.size() + dims_);
+        if (!get_string(in, id) || id.empty() || !get(in, list) ||
+            (list != NO_LIST && list >= nlist) ||
+            !in.read(reinterpret_cast<char*>(&data_[slot * dims_]), dims_ * sizeof(float))) {
+            reset_locked(0);
+            return false;
+        }
+        if (nlist > 0 && list == NO_LIST) list = nearest_list_locked(vec_locked(slot));
+        ids_.push_back(id);
+        list_of_.push_back(nlist > 0 ? list : NO_LIST);
+        if (nlist > 0) lists_[list].push_back(static_cast<uint32_t>(slot));
+        slot_of_[id] = slot;
+    }
+    trained_size_ = static_cast<size_t>(trained);
+    return true;
+}
+
+} // namespace openclaw
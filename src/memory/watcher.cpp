@@ -0,0 +1,259 @@
+/*
+ * OpenClaw C++11 - Memory File Watcher Implementation
+ */
+#include <openclaw/memory/watcher.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#define OPENCLAW_WATCH_INOTIFY 1
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#define OPENCLAW_WATCH_KQUEUE 1
+#endif
+
+namespace openclaw {
+
+namespace {
+
+// Upper bound on one wait, so stop() is noticed promptly
+const int max_wait_ms = 250;
+
+// How often directories that do not exist yet are retried
+const int retry_missing_ms = 1000;
+
+bool is_dir(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+}
+
+FileWatcher::FileWatcher()
+    : fd_(-1)
+    , debounce_ms_(0)
+    , stop_(false) {
+}
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::start(const std::vector<std::string>& dirs, int debounce_ms, Callback callback) {
+    if (running()) return true;
+
+#if defined(OPENCLAW_WATCH_INOTIFY)
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#elif defined(OPENCLAW_WATCH_KQUEUE)
+    fd_ = kqueue();
+#endif
+    if (fd_ < 0) return false;
+
+    dirs_ = dirs;
+    handles_.assign(dirs_.size(), -1);
+    dir_of_.clear();
+    debounce_ms_ = debounce_ms > 0 ? debounce_ms : 0;
+    callback_ = callback;
+
+    // Whatever exists now was just indexed by the caller's startup sync
+    std::set<std::string> ignored;
+    add_missing(ignored);
+
+    stop_ = false;
+    thread_ = std::thread(&FileWatcher::run, this);
+    return true;
+}
+
+void FileWatcher::stop() {
+    if (thread_.joinable()) {
+        stop_ = true;
+        thread_.join();
+    }
+    for (size_t i = 0; i < handles_.size(); ++i) {
+#if defined(OPENCLAW_WATCH_KQUEUE)
+        if (handles_[i] >= 0) close(handles_[i]);
+#endif
+        handles_[i] = -1;
+    }
+    dir_of_.clear();
+    if (fd_ >= 0) {
+        close(fd_);     // Drops any inotify watches with it
+        fd_ = -1;
+    }
+}
+
+void FileWatcher::run() {
+    typedef std::chrono::steady_clock Clock;
+    std::set<std::string> changed;
+    bool overflow = false;
+    Clock::time_point quiet_at = Clock::now();
+    Clock::time_point due_at = Clock::now();   // Cap for a directory that never goes quiet
+    Clock::time_point retry_at = Clock::now() + std::chrono::milliseconds(retry_missing_ms);
+
+    while (!stop_) {
+        bool idle = changed.empty() && !overflow;
+        bool got = false;
+        Clock::time_point now = Clock::now();
+        if (now >= retry_at) {
+            got = add_missing(changed);
+            retry_at = now + std::chrono::milliseconds(retry_missing_ms);
+        }
+
+        int timeout = max_wait_ms;
+        if (!idle) {
+            Clock::time_point flush_at = std::min(quiet_at, due_at);
+            long long left = std::chrono::duration_cast<std::chrono::milliseconds>(flush_at - now).count();
+            timeout = static_cast<int>(std::max(0LL, std::min<long long>(left, max_wait_ms)));
+        }
+        if (wait_events(timeout, changed, overflow)) got = true;
+
+        now = Clock::now();
+        if (got) {
+            quiet_at = now + std::chrono::milliseconds(debounce_ms_);
+            if (idle) due_at = now + std::chrono::milliseconds(4 * debounce_ms_);
+        }
+
+        if ((!changed.empty() || overflow) && (now >= quiet_at || now >= due_at)) {
+            std::set<std::string> batch;
+            batch.swap(changed);
+            bool lost = overflow;
+            overflow = false;
+            callback_(batch, lost);
+        }
+    }
+}
+
+#if defined(OPENCLAW_WATCH_INOTIFY)
+
+bool FileWatcher::add_missing(std::set<std::string>& changed) {
+    bool added = false;
+    for (size_t i = 0; i < dirs_.size(); ++i) {
+        if (handles_[i] >= 0 || !is_dir(dirs_[i])) continue;
+        int wd = inotify_add_watch(fd_, dirs_[i].c_str(),
+                                   IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE |
+                                   IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF);
+        if (wd < 0) continue;
+        handles_[i] = wd;
+        dir_of_[wd] = i;
+        changed.insert(dirs_[i]);
+        added = true;
+    }
+    return added;
+}
+
+bool FileWatcher::wait_events(int timeout_ms, std::set<std::string>& changed, bool& overflow) {
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+
+    bool got = false;
+    alignas(struct inotify_event) char buf[16384];
+    for (;;) {
+        ssize_t n = read(fd_, buf, sizeof(buf));
+        if (n <= 0) break;      // EAGAIN: drained
+        for (char* p = buf; p < buf + n; ) {
+            const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+            got = true;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            std::map<int, size_t>::iterator it = dir_of_.find(ev->wd);
+            if (it == dir_of_.end()) continue;
+            const std::string& dir = dirs_[it->second];
+
+            if (ev->mask & IN_IGNORED) {
+                // Directory deleted or moved away: watch again once it is back
+                handles_[it->second] = -1;
+                dir_of_.erase(it);
+                changed.insert(dir);
+            } else if (ev->len > 0 && ev->name[0] != '\0') {
+                changed.insert(dir + "/" + ev->name);
+            } else {
+                changed.insert(dir);
+            }
+        }
+    }
+    return got;
+}
+
+#elif defined(OPENCLAW_WATCH_KQUEUE)
+
+bool FileWatcher::add_missing(std::set<std::string>& changed) {
+    bool added = false;
+    for (size_t i = 0; i < dirs_.size(); ++i) {
+        if (handles_[i] >= 0 || !is_dir(dirs_[i])) continue;
+#ifdef O_EVTONLY
+        int fd = open(dirs_[i].c_str(), O_EVTONLY);
+#else
+        int fd = open(dirs_[i].c_str(), O_RDONLY);
+#endif
+        if (fd < 0) continue;
+        struct kevent change;
+        EV_SET(&change, fd, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+               NOTE_WRITE | NOTE_EXTEND | NOTE_DELETE | NOTE_RENAME, 0, 0);
+        if (kevent(fd_, &change, 1, nullptr, 0, nullptr) < 0) {
+            close(fd);
+            continue;
+        }
+        handles_[i] = fd;
+        dir_of_[fd] = i;
+        changed.insert(dirs_[i]);
+        added = true;
+    }
+    return added;
+}
+
+bool FileWatcher::wait_events(int timeout_ms, std::set<std::string>& changed, bool& overflow) {
+    (void)overflow;     // kqueue coalesces per directory instead of dropping
+    struct timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000L;
+
+    struct kevent events[16];
+    int n = kevent(fd_, nullptr, 0, events, 16, &ts);
+    bool got = false;
+    for (int i = 0; i < n; ++i) {
+        int fd = static_cast<int>(events[i].ident);
+        std::map<int, size_t>::iterator it = dir_of_.find(fd);
+        if (it == dir_of_.end()) continue;
+        changed.insert(dirs_[it->second]);
+        got = true;
+        if (events[i].fflags & (NOTE_DELETE | NOTE_RENAME)) {
+            handles_[it->second] = -1;
+            dir_of_.erase(it);
+            close(fd);
+        }
+    }
+    return got;
+}
+
+#else
+
+bool FileWatcher::add_missing(std::set<std::string>& changed) {
+    (void)changed;
+    return false;
+}
+
+bool FileWatcher::wait_events(int timeout_ms, std::set<std::string>& changed, bool& overflow) {
+    (void)timeout_ms;
+    (void)changed;
+    (void)overflow;
+    return false;
+}
+
+#endif
+
+} // namespace openclaw
@@ -1,15 +1,141 @@
 #include <openclaw/plugins/claude/claude.hpp>
 #include <openclaw/core/loader.hpp>
+#include <openclaw/core/json_reader.hpp>
 #include <sstream>
+#include <condition_variable>
 
 namespace openclaw {
 
+namespace {
+
+// Ends a cacheable prompt prefix at this block
+void mark_cacheable(Json& block) {
+    Json cache_control = Json::object();
+    cache_control["type"] = "ephemeral";
+    block["cache_control"] = cache_control;
+}
+
+// Text content block; cache marks the end of a cacheable prompt prefix
+Json text_block(const std::string& text, bool cache) {
+    Json block = Json::object();
+    block["type"] = "text";
+    block["text"] = text;
+    if (cache) {
+        mark_cacheable(block);
+    }
+    return block;
+}
+
+// Content blocks of a message with paired native tool_use/tool_result
+Json tool_blocks(const ConversationMessage& msg) {
+    Json blocks = Json::array();
+    if (msg.role == MessageRole::ASSISTANT) {
+        if (!msg.content.empty()) {
+            blocks.push_back(text_block(msg.content, false));
+        }
+        for (size_t i = 0; i < msg.tool_uses.size(); ++i) {
+            Json block = Json::object();
+            block["type"] = "tool_use";
+            block["id"] = msg.tool_uses[i].id;
+            block["name"] = msg.tool_uses[i].name;
+            block["input"] = msg.tool_uses[i].input.is_object() ? msg.tool_uses[i].input : Json::object();
+            blocks.push_back(block);
+        }
+    } else {
+        for (size_t i = 0; i < msg.tool_results.size(); ++i) {
+            Json block = Json::object();
+            block["type"] = "tool_result";
+            block["tool_use_id"] = msg.tool_results[i].tool_use_id;
+            block["content"] = msg.tool_results[i].content;
+            if (msg.tool_results[i].is_error) {
+                block["is_error"] = true;
+            }
+            blocks.push_back(block);
+        }
+    }
+    return blocks;
+}
+
+// A content block as it is read; members come in any order
+struct ContentBlock {
+    std::string type;
+    std::string text;
+    ToolUse tool;
+
+    void reset() {
+        type.clear();
+        text.clear();
+        tool = ToolUse();
+        tool.input = Json::object();
+    }
+};
+
+// Content block fields under prefix ("content.*." or "content_block.")
+void bind_block(JsonReader& reader, const std::string& prefix, ContentBlock& block) {
+    reader.bind(prefix + "type", block.type);
+    reader.bind(prefix + "text", block.text);
+    reader.bind(prefix + "id", block.tool.id);
+    reader.bind(prefix + "name", block.tool.name);
+    reader.capture(prefix + "input", [&block](Json& input) {
+        if (input.is_object()) block.tool.input = std::move(input);
+    });
+}
+
+// Token counters under prefix; prompt caching ones are reported
+// alongside input_tokens
+void bind_usage(JsonReader& reader, const std::string& prefix, UsageStats& stats) {
+    reader.bind(prefix + "input_tokens", stats.input_tokens);
+    reader.bind(prefix + "output_tokens", stats.output_tokens);
+    reader.bind(prefix + "cache_creation_input_tokens", stats.cache_write_tokens);
+    reader.bind(prefix + "cache_read_input_tokens", stats.cache_read_tokens);
+}
+
+} // anonymous namespace
+
+// Batch callbacks (HTTP completions, poll timers) outlive any one call
+// and may fire after shutdown(). They run through this guard, which
+// skips them once stopped; stop() waits out those already running.
+struct ClaudeAI::CallbackGuard {
+    std::mutex mutex;
+    std::condition_variable idle;
+    bool stopped;
+    int running;
+    
+    CallbackGuard() : stopped(false), running(0) {}
+    
+    template <typename Fn>
+    void run(const Fn& fn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopped) return;
+            running++;
+        }
+        struct Leave {
+            CallbackGuard& guard;
+            ~Leave() {
+                std::lock_guard<std::mutex> lock(guard.mutex);
+                if (--guard.running == 0) guard.idle.notify_all();
+            }
+        } leave = { *this };
+        fn();
+    }
+    
+    void stop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopped = true;
+        idle.wait(lock, [this] { return running == 0; });
+    }
+};
+
 ClaudeAI::ClaudeAI()
     : api_key_()
     , default_model_("claude-sonnet-4-20250514")
     , api_url_("https://api.anthropic.com/v1/messages")
     , api_version_("2023-06-01")
     , initialized_(false)
+    , batch_timer_(0)
+    , batch_seq_(0)
+    , batch_guard_(std::make_shared<CallbackGuard>())
 {}
 
 const char* ClaudeAI::name() const { return "Claude AI"; }
@@ -18,6 +144,15 @@ const char* ClaudeAI::description() const {
     return "Anthropic Claude AI provider using Messages API"; 
 }
 
+ClaudeAI::BatchSettings ClaudeAI::BatchSettings::from_config(const Config& cfg) {
+    BatchSettings s;
+    s.window_ms = cfg.get_int("claude.batch_window_ms", 2000);
+    s.max_requests = static_cast<size_t>(cfg.get_int("claude.batch_max_requests", 100));
+    s.poll_ms = cfg.get_int("claude.batch_poll_seconds", 30) * 1000;
+    if (s.max_requests == 0) s.max_requests = 1;
+    return s;
+}
+
 bool ClaudeAI::init(const Config& cfg) {
     api_key_ = cfg.get_string("claude.api_key", "");
     
@@ -31,6 +166,8 @@ bool ClaudeAI::init(const Config& cfg) {
         api_url_ = url;
     }
     
+    batch_settings_.set(BatchSettings::from_config(cfg));
+    
     if (api_key_.empty()) {
         LOG_WARN("Claude AI: No API key configured (set claude.api_key in config.json)");
         initialized_ = false;
@@ -42,7 +179,14 @@ bool ClaudeAI::init(const Config& cfg) {
     return true;
 }
 
+void ClaudeAI::reconfigure(const Config& cfg) {
+    batch_settings_.set(BatchSettings::from_config(cfg));
+}
+
 void ClaudeAI::shutdown() {
+    // Stop first: a callback still running may schedule another poll
+    batch_guard_->stop();
+    TimerWheel::instance().cancel_all(this);
     initialized_ = false;
 }
 
@@ -65,6 +209,20 @@ std::string ClaudeAI::default_model() const { return default_model_; }
 
 bool ClaudeAI::is_configured() const { return !api_key_.empty(); }
 
+int ClaudeAI::context_window(const std::string& model) const {
+    (void)model;  // Every current Claude model has a 200k window
+    return 200000;
+}
+
+bool ClaudeAI::supports_native_tools() const { return true; }
+
+bool ClaudeAI::supports_batch() const { return true; }
+
+TokenEstimator ClaudeAI::token_estimator() const {
+    // Claude's tokenizer produces somewhat more tokens than GPT-style BPE
+    return TokenEstimator(1.15);
+}
+
 CompletionResult ClaudeAI::complete(
     const std::string& prompt,
     const CompletionOptions& opts
@@ -74,16 +232,20 @@ CompletionResult ClaudeAI::complete(
     return chat(messages, opts);
 }
 
-CompletionResult ClaudeAI::chat(
+bool ClaudeAI::build_request(
     const std::vector<ConversationMessage>& messages,
-    const CompletionOptions& opts
-) {
+    const CompletionOptions& opts,
+    HttpRequest& out,
+    std::string& error
+) const {
     if (!initialized_) {
-        return CompletionResult::fail("Claude AI not initialized");
+        error = "Claude AI not initialized";
+        return false;
     }
     
     if (messages.empty()) {
-        return CompletionResult::fail("No messages provided");
+        error = "No messages provided";
+        return false;
     }
     
     LOG_DEBUG("[Claude] Starting chat request with %zu messages", messages.size());
@@ -101,12 +263,44 @@ CompletionResult ClaudeAI::chat(
         request["temperature"] = opts.temperature;
     }
     
-    if (!opts.system_prompt.empty()) {
-        request["system"] = opts.system_prompt;
+    // With caching, tools and system prompt are separate blocks, each
+    // ending a cache breakpoint, so a skills change keeps the tools cached
+    std::string system_prompt = opts.full_system_prompt();
+    if (opts.cache_prompt && !system_prompt.empty()) {
+        Json system = Json::array();
+        if (!opts.tools_prompt.empty()) {
+            system.push_back(text_block(opts.tools_prompt, true));
+        }
+        if (!opts.system_prompt.empty()) {
+            system.push_back(text_block(opts.system_prompt, true));
+        }
+        request["system"] = system;
+    } else if (!system_prompt.empty()) {
+        request["system"] = system_prompt;
+    }
+    if (!system_prompt.empty()) {
         LOG_DEBUG("[Claude] System prompt (%zu chars): %.200s%s", 
-                  opts.system_prompt.size(), 
-                  opts.system_prompt.c_str(),
-                  opts.system_prompt.size() > 200 ? "..." : "");
+                  system_prompt.size(), 
+                  system_prompt.c_str(),
+                  system_prompt.size() > 200 ? "..." : "");
+    }
+    
+    // Native tool definitions come first in the prompt; the last one ends
+    // a cache breakpoint covering all of them
+    if (!opts.tools.empty()) {
+        Json tools = Json::array();
+        for (size_t i = 0; i < opts.tools.size(); ++i) {
+            Json tool = Json::object();
+            tool["name"] = opts.tools[i].name;
+            tool["description"] = opts.tools[i].description;
+            tool["input_schema"] = opts.tools[i].input_schema;
+            tools.push_back(tool);
+        }
+        if (opts.cache_prompt) {
+            mark_cacheable(tools[tools.size() - 1]);
+        }
+        request["tools"] = tools;
+        LOG_DEBUG("[Claude] Sending %zu native tool definitions", opts.tools.size());
     }
     
     Json msgs = Json::array();
@@ -115,8 +309,12 @@ CompletionResult ClaudeAI::chat(
         const ConversationMessage& msg = messages[i];
         
         if (msg.role == MessageRole::SYSTEM) {
-            if (opts.system_prompt.empty() && i == 0) {
-                request["system"] = msg.content;
+            if (system_prompt.empty() && i == 0) {
+                if (opts.cache_prompt) {
+                    request["system"] = Json::array({text_block(msg.content, true)});
+                } else {
+                    request["system"] = msg.content;
+                }
                 LOG_DEBUG("[Claude]   [%zu] SYSTEM (%zu chars): %.200s%s", 
                           i, msg.content.size(), msg.content.c_str(),
                           msg.content.size() > 200 ? "..." : "");
@@ -126,7 +324,13 @@ CompletionResult ClaudeAI::chat(
         
         Json m = Json::object();
         m["role"] = role_to_string(msg.role);
-        m["content"] = msg.content;
+        if (tool_blocks_paired(messages, i)) {
+            m["content"] = tool_blocks(msg);
+        } else if (!msg.tool_uses.empty()) {
+            m["content"] = tool_uses_as_text(msg);
+        } else {
+            m["content"] = msg.content;
+        }
         msgs.push_back(m);
         
         LOG_DEBUG("[Claude]   [%zu] %s (%zu chars): %.300s%s", 
@@ -134,6 +338,19 @@ CompletionResult ClaudeAI::chat(
                   msg.content.size(), msg.content.c_str(),
                   msg.content.size() > 300 ? "..." : "");
     }
+    
+    // Breakpoint on the newest message: the next agent iteration (or the
+    // next user turn) re-reads the whole history up to here from cache
+    if (opts.cache_prompt && !msgs.empty()) {
+        Json& last = msgs[msgs.size() - 1];
+        if (last["content"].is_array() && !last["content"].empty()) {
+            mark_cacheable(last["content"][last["content"].size() - 1]);
+        } else if (last["content"].is_string()) {
+            std::string content = last["content"].get<std::string>();
+            last["content"] = Json::array({text_block(content, true)});
+        }
+    }
+    
     request["messages"] = msgs;
     LOG_DEBUG("[Claude] === End of messages ===");
     
@@ -141,28 +358,174 @@ CompletionResult ClaudeAI::chat(
         request["stream"] = true;
     }
     
-    std::string request_body = request.dump();
-    LOG_DEBUG("[Claude] Sending request to API (%zu bytes)", request_body.size());
+    out = api_request("POST", api_url_, request.dump());
     
-    HttpClient http;
-    std::map<std::string, std::string> headers;
-    headers["x-api-key"] = api_key_;
-    headers["anthropic-version"] = api_version_;
-    headers["Content-Type"] = "application/json";
+    if (opts.stream && opts.on_chunk) {
+        // Long generations are fine while tokens keep flowing
+        out.timeout_ms = 600000;
+    }
+    
+    LOG_DEBUG("[Claude] Sending request to API (%zu bytes)", out.body.size());
+    return true;
+}
+
+HttpRequest ClaudeAI::api_request(const std::string& method, const std::string& url,
+                                  const std::string& body) const {
+    HttpRequest req(method, url, body);
+    req.headers["x-api-key"] = api_key_;
+    req.headers["anthropic-version"] = api_version_;
+    req.headers["Content-Type"] = "application/json";
+    return req;
+}
+
+// ============================================================================
+// Streaming
+// ============================================================================
+
+struct ClaudeAI::StreamState {
+    SseParser parser;
+    StreamCallback on_chunk;
+    CompletionResult result;
+    std::string text;
+    std::string error;
+    std::vector<ToolUse> tool_uses;
+    std::string tool_json;      // input_json_delta pieces of the open tool_use block
+    bool in_tool_use;
     
-    HttpResponse response = http.post_json(api_url_, request_body, headers);
+    // Fields of the event being read. Every event type has its own
+    // paths, so one reader serves them all; message_start and
+    // message_delta fields go straight into the result.
+    JsonReader reader;
+    std::string delta_type;
+    std::string delta_text;
+    std::string stop_reason;
+    ContentBlock block;
+    bool has_error;
+    std::string error_type;
+    std::string error_message;
+    
+    explicit StreamState(StreamCallback cb)
+        : parser([this](const std::string& event, const std::string& data) {
+              on_event(event, data);
+          })
+        , on_chunk(cb)
+        , in_tool_use(false)
+        , has_error(false) {
+        reader.bind("delta.type", delta_type);
+        reader.bind("delta.text", delta_text);
+        reader.bind("delta.partial_json", delta_text);
+        reader.bind("delta.stop_reason", stop_reason);
+        bind_block(reader, "content_block.", block);
+        reader.bind("message.model", result.model);
+        bind_usage(reader, "message.usage.", result.usage);
+        reader.bind("usage.output_tokens", result.usage.output_tokens);
+        reader.on("error", [this](JsonValue&) { has_error = true; });
+        reader.on_begin("error", [this] { has_error = true; });
+        reader.bind("error.type", error_type);
+        reader.bind("error.message", error_message);
+    }
     
+    void on_event(const std::string& event, const std::string& data) {
+        delta_type.clear();
+        delta_text.clear();
+        stop_reason.clear();
+        block.reset();
+        has_error = false;
+        error_type.clear();
+        error_message.clear();
+        if (!reader.parse(data)) {
+            LOG_DEBUG("[Claude] Ignoring unparseable stream event '%s'", event.c_str());
+            return;
+        }
+        
+        if (event == "content_block_delta") {
+            if (delta_type == "text_delta") {
+                if (!delta_text.empty()) {
+                    text += delta_text;
+                    if (on_chunk) on_chunk(delta_text);
+                }
+            } else if (delta_type == "input_json_delta" && in_tool_use) {
+                tool_json += delta_text;
+            }
+        } else if (event == "content_block_start") {
+            if (block.type == "tool_use") {
+                tool_uses.push_back(block.tool);
+                tool_json.clear();
+                in_tool_use = true;
+            }
+        } else if (event == "content_block_stop") {
+            if (in_tool_use) {
+                in_tool_use = false;
+                if (!tool_json.empty()) {
+                    try {
+                        tool_uses.back().input = Json::parse(tool_json);
+                    } catch (...) {
+                        LOG_WARN("[Claude] Unparseable input for tool '%s'", tool_uses.back().name.c_str());
+                    }
+                }
+            }
+        } else if (event == "message_delta") {
+            if (!stop_reason.empty()) result.stop_reason = stop_reason;
+        } else if (event == "error" && has_error) {
+            std::string msg = error_message.empty() ? std::string("stream error") : error_message;
+            error = error_type.empty() ? msg : (error_type + ": " + msg);
+        }
+        // message_start went straight into result; ping and message_stop
+        // carry nothing we need
+    }
+};
+
+ClaudeAI::StreamStatePtr ClaudeAI::attach_stream(HttpRequest& req,
+                                                 const CompletionOptions& opts) const {
+    if (!opts.stream || !opts.on_chunk) {
+        return StreamStatePtr();
+    }
+    StreamStatePtr state(new StreamState(opts.on_chunk));
+    req.on_data = [state](const char* data, size_t len) {
+        state->parser.feed(data, len);
+    };
+    return state;
+}
+
+CompletionResult ClaudeAI::finish_stream(StreamState& state, const HttpResponse& response) const {
+    // Errors before the stream started come back as a regular JSON body
+    if (!response.ok()) {
+        return parse_response(response);
+    }
+    
+    state.parser.finish();
+    if (!state.error.empty()) {
+        LOG_ERROR("[Claude] Stream error: %s", state.error.c_str());
+        return CompletionResult::fail(state.error);
+    }
+    
+    CompletionResult result = state.result;
+    result.success = true;
+    result.content = state.text;
+    result.tool_uses = state.tool_uses;
+    result.usage.total_tokens = result.usage.input_tokens + result.usage.cache_read_tokens +
+                                result.usage.cache_write_tokens + result.usage.output_tokens;
+    
+    LOG_DEBUG("[Claude] Stream complete: %zu events, %zu chars, stop reason: %s",
+              state.parser.events(), result.content.size(), result.stop_reason.c_str());
+    LOG_DEBUG("[Claude] Tokens - Input: %d, Cache read: %d, Cache write: %d, Output: %d, Total: %d",
+              result.usage.input_tokens, result.usage.cache_read_tokens,
+              result.usage.cache_write_tokens, result.usage.output_tokens,
+              result.usage.total_tokens);
+    return result;
+}
+
+CompletionResult ClaudeAI::parse_response(const HttpResponse& response) const {
     if (response.status_code == 0) {
-        LOG_ERROR("[Claude] HTTP request failed: %s", response.body.c_str());
-        return CompletionResult::fail("HTTP request failed: " + response.body);
+        LOG_ERROR("[Claude] HTTP request failed: %s", response.error.c_str());
+        return CompletionResult::fail("HTTP request failed: " + response.error);
     }
     
     LOG_DEBUG("[Claude] Received response [HTTP %d] (%zu bytes)", 
               response.status_code, response.body.size());
     
-    Json resp = response.json();
-    
     if (response.status_code != 200) {
+        Json resp = response.json();
         std::string error_msg = "API error";
         if (resp.is_object()) {
             if (resp.contains("error") && resp["error"].is_object()) {
@@ -179,35 +542,40 @@ CompletionResult ClaudeAI::chat(
                                      std::to_string(response.status_code) + ")");
     }
     
+    // Decoded straight from the body: the text of each block lands in
+    // the result without an intermediate tree
     CompletionResult result;
     result.success = true;
-    result.model = resp.value("model", std::string(""));
-    result.stop_reason = resp.value("stop_reason", std::string(""));
-    
-    Json content = resp["content"];
-    if (content.is_array()) {
-        std::ostringstream text;
-        for (auto it = content.begin(); it != content.end(); ++it) {
-            const Json& block = *it;
-            std::string block_type = block.value("type", std::string(""));
-            if (block_type == "text") {
-                text << block.value("text", std::string(""));
-            }
+    ContentBlock block;
+    JsonReader reader;
+    reader.bind("model", result.model);
+    reader.bind("stop_reason", result.stop_reason);
+    reader.on_begin("content.*", [&block] { block.reset(); });
+    bind_block(reader, "content.*.", block);
+    reader.on_end("content.*", [&block, &result] {
+        if (block.type == "text") {
+            result.content += block.text;
+        } else if (block.type == "tool_use") {
+            result.tool_uses.push_back(block.tool);
         }
-        result.content = text.str();
-    }
+    });
+    bind_usage(reader, "usage.", result.usage);
     
-    Json usage = resp["usage"];
-    if (usage.is_object()) {
-        result.usage.input_tokens = usage.value("input_tokens", 0);
-        result.usage.output_tokens = usage.value("output_tokens", 0);
-        result.usage.total_tokens = result.usage.input_tokens + result.usage.output_tokens;
+    std::string parse_error;
+    if (!reader.parse(response.body, &parse_error)) {
+        LOG_ERROR("[Claude] Invalid response body: %s", parse_error.c_str());
+        return CompletionResult::fail("Invalid response: " + parse_error);
     }
+    // input_tokens excludes the cached part of the prompt
+    result.usage.total_tokens = result.usage.input_tokens + result.usage.cache_read_tokens +
+                                result.usage.cache_write_tokens + result.usage.output_tokens;
     
     LOG_DEBUG("[Claude] === AI Response ===");
     LOG_DEBUG("[Claude] Model: %s, Stop reason: %s", result.model.c_str(), result.stop_reason.c_str());
-    LOG_DEBUG("[Claude] Tokens - Input: %d, Output: %d, Total: %d",
-              result.usage.input_tokens, result.usage.output_tokens, result.usage.total_tokens);
+    LOG_DEBUG("[Claude] Tokens - Input: %d, Cache read: %d, Cache write: %d, Output: %d, Total: %d",
+              result.usage.input_tokens, result.usage.cache_read_tokens,
+              result.usage.cache_write_tokens, result.usage.output_tokens,
+              result.usage.total_tokens);
     LOG_DEBUG("[Claude] Response content (%zu chars): %.500s%s", 
               result.content.size(), result.content.c_str(),
               result.content.size() > 500 ? "..." : "");
@@ -216,6 +584,240 @@ CompletionResult ClaudeAI::chat(
     return result;
 }
 
+CompletionResult ClaudeAI::chat(
+    const std::vector<ConversationMessage>& messages,
+    const CompletionOptions& opts
+) {
+    HttpRequest req;
+    std::string error;
+    if (!build_request(messages, opts, req, error)) {
+        return CompletionResult::fail(error);
+    }
+    
+    StreamStatePtr stream = attach_stream(req, opts);
+    
+    HttpClient http;
+    HttpResponse response = http.perform(req);
+    CompletionResult result = stream ? finish_stream(*stream, response) : parse_response(response);
+    result.http_status = response.status_code;
+    result.response_headers = response.headers;
+    return result;
+}
+
+void ClaudeAI::chat_async(
+    const std::vector<ConversationMessage>& messages,
+    const CompletionOptions& opts,
+    CompletionCallback on_done
+) {
+    if (opts.batch) {
+        queue_batched(messages, opts, on_done);
+        return;
+    }
+    
+    HttpRequest req;
+    std::string error;
+    if (!build_request(messages, opts, req, error)) {
+        if (on_done) on_done(CompletionResult::fail(error));
+        return;
+    }
+    
+    StreamStatePtr stream = attach_stream(req, opts);
+    
+    AsyncHttpEngine::instance().submit(req, [this, stream, on_done](const HttpResponse& response) {
+        CompletionResult result = stream ? finish_stream(*stream, response)
+                                         : parse_response(response);
+        result.http_status = response.status_code;
+        result.response_headers = response.headers;
+        if (on_done) on_done(result);
+    });
+}
+
+// ============================================================================
+// Message Batches
+// ============================================================================
+
+void ClaudeAI::queue_batched(const std::vector<ConversationMessage>& messages,
+                             const CompletionOptions& opts, CompletionCallback on_done) {
+    CompletionOptions batch_opts = opts;
+    batch_opts.stream = false;
+    batch_opts.on_chunk = StreamCallback();
+    
+    HttpRequest req;
+    std::string error;
+    if (!build_request(messages, batch_opts, req, error)) {
+        if (on_done) on_done(CompletionResult::fail(error));
+        return;
+    }
+    
+    BatchItem item;
+    item.params = Json::parse(req.body);
+    item.on_done = on_done;
+    
+    Snapshot<BatchSettings>::Ptr settings = batch_settings_.get();
+    std::vector<BatchItem> full;
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        item.custom_id = "req-" + std::to_string(++batch_seq_);
+        batch_pending_.push_back(item);
+        if (batch_pending_.size() >= settings->max_requests) {
+            full.swap(batch_pending_);
+            if (batch_timer_) TimerWheel::instance().cancel(batch_timer_);
+            batch_timer_ = 0;
+        } else if (!batch_timer_) {
+            CallbackGuardPtr guard = batch_guard_;
+            batch_timer_ = TimerWheel::instance().schedule_in(settings->window_ms, [this, guard] {
+                guard->run([this] { flush_batch(); });
+            }, this);
+        }
+    }
+    if (!full.empty()) submit_batch(full);
+}
+
+void ClaudeAI::flush_batch() {
+    std::vector<BatchItem> items;
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        batch_timer_ = 0;
+        items.swap(batch_pending_);
+    }
+    if (!items.empty()) submit_batch(items);
+}
+
+void ClaudeAI::submit_batch(std::vector<BatchItem> items) {
+    Json requests = Json::array();
+    BatchPtr batch = std::make_shared<Batch>();
+    for (size_t i = 0; i < items.size(); ++i) {
+        Json entry = Json::object();
+        entry["custom_id"] = items[i].custom_id;
+        entry["params"] = items[i].params;
+        requests.push_back(entry);
+        batch->waiting[items[i].custom_id] = items[i].on_done;
+    }
+    Json body = Json::object();
+    body["requests"] = requests;
+    
+    std::shared_ptr<std::vector<BatchItem> > kept = std::make_shared<std::vector<BatchItem> >();
+    kept->swap(items);
+    
+    HttpRequest req = api_request("POST", api_url_ + "/batches", body.dump());
+    CallbackGuardPtr guard = batch_guard_;
+    AsyncHttpEngine::instance().submit(req, [this, guard, batch, kept](const HttpResponse& response) {
+        guard->run([&] {
+            Json resp = response.json();
+            if (response.ok() && resp.is_object() && resp.contains("id")) {
+                batch->id = resp.value("id", std::string());
+                LOG_INFO("[Claude] Submitted batch %s with %zu requests", batch->id.c_str(), kept->size());
+                schedule_poll(batch);
+                return;
+            }
+            
+            // No batch endpoint (proxy, old API version): send them one by one
+            LOG_WARN("[Claude] Batch submission failed (HTTP %ld); sending %zu requests directly",
+                     response.status_code, kept->size());
+            for (size_t i = 0; i < kept->size(); ++i) {
+                CompletionCallback on_done = (*kept)[i].on_done;
+                HttpRequest single = api_request("POST", api_url_, (*kept)[i].params.dump());
+                AsyncHttpEngine::instance().submit(single, [this, guard, on_done](const HttpResponse& r) {
+                    guard->run([&] {
+                        CompletionResult result = parse_response(r);
+                        result.http_status = r.status_code;
+                        result.response_headers = r.headers;
+                        if (on_done) on_done(result);
+                    });
+                });
+            }
+        });
+    });
+}
+
+void ClaudeAI::schedule_poll(BatchPtr batch) {
+    CallbackGuardPtr guard = batch_guard_;
+    TimerWheel::instance().schedule_in(batch_settings_.get()->poll_ms, [this, guard, batch] {
+        guard->run([this, batch] { poll_batch(batch); });
+    }, this);
+}
+
+void ClaudeAI::poll_batch(BatchPtr batch) {
+    HttpRequest req = api_request("GET", api_url_ + "/batches/" + batch->id);
+    CallbackGuardPtr guard = batch_guard_;
+    AsyncHttpEngine::instance().submit(req, [this, guard, batch](const HttpResponse& response) {
+        guard->run([&] {
+            Json resp = response.json();
+            if (response.ok() && resp.is_object() && resp.value("processing_status", std::string()) == "ended") {
+                collect_batch(batch, resp.value("results_url", std::string()));
+                return;
+            }
+            if (!response.ok()) {
+                LOG_WARN("[Claude] Polling batch %s failed (HTTP %ld), retrying", batch->id.c_str(),
+                         response.status_code);
+            }
+            schedule_poll(batch);
+        });
+    });
+}
+
+void ClaudeAI::collect_batch(BatchPtr batch, const std::string& results_url) {
+    HttpRequest req = api_request("GET", results_url);
+    req.timeout_ms = 120000;
+    CallbackGuardPtr guard = batch_guard_;
+    AsyncHttpEngine::instance().submit(req, [this, guard, batch](const HttpResponse& response) {
+        guard->run([&] {
+            if (!response.ok()) {
+                LOG_WARN("[Claude] Fetching results of batch %s failed (HTTP %ld), retrying",
+                         batch->id.c_str(), response.status_code);
+                schedule_poll(batch);
+                return;
+            }
+        
+            // One JSON object per line: {"custom_id", "result": {"type", "message" | "error"}}
+            std::istringstream lines(response.body);
+            std::string line;
+            size_t succeeded = 0;
+            size_t failed = 0;
+            while (std::getline(lines, line)) {
+                if (line.empty()) continue;
+                Json entry = Json::parse(line, nullptr, false);
+                if (entry.is_discarded() || !entry.is_object()) continue;
+            
+                std::map<std::string, CompletionCallback>::iterator it =
+                    batch->waiting.find(entry.value("custom_id", std::string()));
+                if (it == batch->waiting.end()) continue;
+                CompletionCallback on_done = it->second;
+                batch->waiting.erase(it);
+            
+                Json result = entry.contains("result") ? entry["result"] : Json::object();
+                std::string type = result.value("type", std::string());
+                CompletionResult completion;
+                if (type == "succeeded" && result.contains("message")) {
+                    HttpResponse message;
+                    message.status_code = 200;
+                    message.body = result["message"].dump();
+                    completion = parse_response(message);
+                    completion.http_status = 200;
+                    succeeded++;
+                } else {
+                    std::string detail = type;
+                    if (result.contains("error") && result["error"].is_object()) {
+                        Json error = result["error"].contains("error") ? result["error"]["error"] : result["error"];
+                        detail += ": " + error.value("message", std::string());
+                    }
+                    completion = CompletionResult::fail("Batch request " + detail);
+                    failed++;
+                }
+                if (on_done) on_done(completion);
+            }
+        
+            LOG_INFO("[Claude] Batch %s done: %zu succeeded, %zu failed, %zu missing",
+                     batch->id.c_str(), succeeded, failed, batch->waiting.size());
+            for (std::map<std::string, CompletionCallback>::iterator it = batch->waiting.begin();
+                 it != batch->waiting.end(); ++it) {
+                if (it->second) it->second(CompletionResult::fail("Missing from batch results"));
+            }
+            batch->waiting.clear();
+        });
+    });
+}
+
 std::string ClaudeAI::ask(const std::string& question, const std::string& system) {
     CompletionOptions opts;
     if (!system.empty()) {
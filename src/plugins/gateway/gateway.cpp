@@ -13,6 +13,8 @@
 #include <openclaw/core/utils.hpp>
 #include <openclaw/core/registry.hpp>
 #include <openclaw/core/channel.hpp>
+#include <openclaw/core/metrics.hpp>
+#include <openclaw/core/webhook.hpp>
 
 // Crow header-only library (C++17 required)
 #include "deps/crow_all.h"
@@ -24,10 +26,121 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <deque>
+#include <functional>
 #include <unordered_map>
 
 namespace openclaw {
 
+// ============================================================================
+// Outbound Queues
+// ============================================================================
+
+// A client's frames not yet handed to its connection. Workers only append
+// here; the connection's I/O thread takes the frames and writes them, so a
+// slow or stalled browser never holds up the caller.
+struct GatewaySendQueue {
+    struct Frame {
+        std::shared_ptr<const std::string> data;
+        std::string coalesce_key;
+        bool droppable;
+        bool binary;
+    };
+    
+    crow::websocket::connection* conn;
+    size_t max_queued;
+    std::mutex mutex;
+    std::deque<Frame> frames;
+    bool drain_posted;      // A drain is on its way to the I/O thread
+    bool closed;            // Disconnected as a slow consumer
+    
+    GatewaySendQueue(crow::websocket::connection* c, size_t max)
+        : conn(c), max_queued(max > 0 ? max : 1), drain_posted(false), closed(false) {}
+};
+
+namespace {
+
+typedef crow::websocket::Connection<crow::SocketAdaptor, crow::SimpleApp> PlainConnection;
+
+// Run on the connection's I/O thread. Crow drops the task if the
+// connection is gone by then.
+void post_to_io(crow::websocket::connection* conn, const std::function<void()>& task) {
+    PlainConnection* plain = dynamic_cast<PlainConnection*>(conn);
+    if (plain) {
+        plain->post(task);
+    } else {
+        task();     // Unknown adaptor: send_text queues internally anyway
+    }
+}
+
+void drain_queue(const std::shared_ptr<GatewaySendQueue>& queue) {
+    std::deque<GatewaySendQueue::Frame> frames;
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        frames.swap(queue->frames);
+        queue->drain_posted = false;
+        if (queue->closed) return;
+    }
+    for (size_t i = 0; i < frames.size(); ++i) {
+        try {
+            if (frames[i].binary) {
+                queue->conn->send_binary(*frames[i].data);
+            } else {
+                queue->conn->send_text(*frames[i].data);
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to send WebSocket message: %s", e.what());
+            return;
+        }
+    }
+}
+
+std::shared_ptr<const std::string> encode_frame(const Json& message, GatewayClient::Encoding encoding) {
+    std::string bytes;
+    switch (encoding) {
+    case GatewayClient::MSGPACK:
+        Json::to_msgpack(message, bytes);
+        break;
+    case GatewayClient::CBOR:
+        Json::to_cbor(message, bytes);
+        break;
+    default:
+        bytes = message.dump();
+        break;
+    }
+    return std::make_shared<const std::string>(std::move(bytes));
+}
+
+// One message, serialized at most once per encoding its clients use
+class EncodedFrames {
+public:
+    explicit EncodedFrames(const Json& message) : message_(message) {}
+    
+    const std::shared_ptr<const std::string>& get(GatewayClient::Encoding encoding) {
+        if (!frames_[encoding]) frames_[encoding] = encode_frame(message_, encoding);
+        return frames_[encoding];
+    }
+    
+private:
+    Json message_;
+    std::shared_ptr<const std::string> frames_[GatewayClient::ENCODING_COUNT];
+};
+
+// Names a client may list in hello params.encodings
+const char* const encoding_names[GatewayClient::ENCODING_COUNT] = { "json", "msgpack", "cbor" };
+
+bool parse_encoding(const std::string& name, GatewayClient::Encoding& encoding) {
+    for (int i = 0; i < GatewayClient::ENCODING_COUNT; ++i) {
+        if (name == encoding_names[i]) {
+            encoding = static_cast<GatewayClient::Encoding>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
 // ============================================================================
 // WebSocket Server Implementation (using Crow)
 // ============================================================================
@@ -144,6 +257,37 @@ private:
             return res;
         });
         
+        // Prometheus scrape endpoint; needs the gateway token when one is set
+        if (plugin_->metrics_enabled()) {
+            CROW_ROUTE(app_, "/metrics")
+            ([this](const crow::request& req) {
+                crow::response res;
+                const std::string& token = plugin_->auth_token();
+                if (!token.empty() && req.get_header_value("Authorization") != "Bearer " + token) {
+                    res.code = 401;
+                    res.set_header("WWW-Authenticate", "Bearer");
+                    res.body = "401 Unauthorized";
+                    return res;
+                }
+                res.set_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+                res.body = Metrics::instance().render();
+                return res;
+            });
+        }
+        
+        // Channel webhooks (Telegram, ...); handlers only queue the body
+        CROW_ROUTE(app_, "/hooks/<string>").methods(crow::HTTPMethod::Post)
+        ([](const crow::request& req, const std::string& name) {
+            WebhookRequest hook;
+            hook.name = name;
+            for (const auto& header : req.headers) {
+                hook.headers[to_lower(header.first)] = header.second;
+            }
+            hook.body = req.body;
+            WebhookResponse result = WebhookRouter::instance().dispatch(hook);
+            return crow::response(result.status, result.body);
+        });
+        
         // WebSocket endpoint
         CROW_WEBSOCKET_ROUTE(app_, "/ws")
             .onopen([this](crow::websocket::connection& conn) {
@@ -164,7 +308,7 @@ private:
         std::string conn_id = oss.str();
         
         // Create client and track connection
-        GatewayClient* client = new GatewayClient(&conn, conn_id);
+        GatewayClient* client = new GatewayClient(&conn, conn_id, plugin_->send_queue_max());
         
         {
             std::lock_guard<std::mutex> lock(connections_mutex_);
@@ -195,7 +339,7 @@ private:
         }
     }
     
-    void on_ws_message(crow::websocket::connection& conn, const std::string& data, bool /* is_binary */) {
+    void on_ws_message(crow::websocket::connection& conn, const std::string& data, bool is_binary) {
         GatewayClient* client = nullptr;
         
         {
@@ -207,7 +351,7 @@ private:
         }
         
         if (client) {
-            plugin_->handle_client_message(client, data);
+            plugin_->handle_client_message(client, data, is_binary);
         }
     }
     
@@ -228,11 +372,15 @@ private:
 // GatewayClient Implementation
 // ============================================================================
 
-GatewayClient::GatewayClient(void* ws_connection, const std::string& conn_id)
+GatewayClient::GatewayClient(void* ws_connection, const std::string& conn_id, size_t max_queued)
     : ws_connection_(ws_connection)
     , conn_id_(conn_id)
     , authenticated_(false)
-    , protocol_version_(1) {
+    , protocol_version_(1)
+    , batch_events_(false)
+    , encoding_(JSON_TEXT)
+    , queue_(std::make_shared<GatewaySendQueue>(
+          static_cast<crow::websocket::connection*>(ws_connection), max_queued)) {
 }
 
 GatewayClient::~GatewayClient() {
@@ -240,19 +388,84 @@ GatewayClient::~GatewayClient() {
 
 bool GatewayClient::send(const std::string& message) {
     if (!ws_connection_) return false;
+    return enqueue(std::make_shared<const std::string>(message));
+}
+
+bool GatewayClient::enqueue(const std::shared_ptr<const std::string>& frame,
+                            const std::string& coalesce_key,
+                            bool droppable,
+                            bool binary) {
+    if (!ws_connection_) return false;
     
-    try {
-        auto* conn = static_cast<crow::websocket::connection*>(ws_connection_);
-        conn->send_text(message);
-        return true;
-    } catch (const std::exception& e) {
-        LOG_ERROR("Failed to send WebSocket message: %s", e.what());
+    bool post_drain = false;
+    bool disconnect = false;
+    {
+        std::lock_guard<std::mutex> lock(queue_->mutex);
+        if (queue_->closed) return false;
+        std::deque<GatewaySendQueue::Frame>& frames = queue_->frames;
+        
+        // Coalesce: the newer state replaces the queued one in place
+        if (!coalesce_key.empty()) {
+            for (size_t i = 0; i < frames.size(); ++i) {
+                if (frames[i].coalesce_key == coalesce_key) {
+                    frames[i].data = frame;
+                    frames[i].binary = binary;
+                    return true;
+                }
+            }
+        }
+        
+        if (frames.size() >= queue_->max_queued) {
+            // Shed the oldest droppable frame, else this one if it may go
+            size_t victim = frames.size();
+            for (size_t i = 0; i < frames.size() && victim == frames.size(); ++i) {
+                if (frames[i].droppable) victim = i;
+            }
+            if (victim < frames.size()) {
+                frames.erase(frames.begin() + victim);
+            } else if (droppable) {
+                return true;
+            } else {
+                queue_->closed = true;
+                frames.clear();
+                disconnect = true;
+            }
+        }
+        
+        if (!disconnect) {
+            GatewaySendQueue::Frame entry;
+            entry.data = frame;
+            entry.coalesce_key = coalesce_key;
+            entry.droppable = droppable;
+            entry.binary = binary;
+            frames.push_back(entry);
+            if (!queue_->drain_posted) {
+                queue_->drain_posted = true;
+                post_drain = true;
+            }
+        }
+    }
+    
+    if (disconnect) {
+        LOG_WARN("[Gateway] Client %s has %zu frames queued - disconnecting slow consumer",
+                 conn_id_.c_str(), queue_->max_queued);
+        // Closed from the I/O thread: Crow may run the close handler inline,
+        // and that takes clients_mutex_, which broadcast is holding
+        crow::websocket::connection* conn = queue_->conn;
+        post_to_io(conn, [conn]() { conn->close("slow consumer"); });
         return false;
     }
+    if (post_drain) {
+        std::shared_ptr<GatewaySendQueue> queue = queue_;
+        post_to_io(queue->conn, [queue]() { drain_queue(queue); });
+    }
+    return true;
 }
 
 bool GatewayClient::send_json(const Json& data) {
-    return send(data.dump());
+    if (!ws_connection_) return false;
+    Encoding enc = encoding();
+    return enqueue(encode_frame(data, enc), std::string(), false, enc != JSON_TEXT);
 }
 
 // ============================================================================
@@ -263,7 +476,12 @@ GatewayPlugin::GatewayPlugin()
     : running_(false)
     , port_(18789)
     , bind_host_("127.0.0.1")
-    , ws_server_(nullptr) {
+    , send_queue_max_(256)
+    , metrics_enabled_(true)
+    , ws_server_(nullptr)
+    , pending_since_ms_(0)
+    , coalesce_ms_(50)
+    , flush_timer_(0) {
     initialized_ = false;
 }
 
@@ -281,6 +499,11 @@ bool GatewayPlugin::init(const Config& cfg) {
     bind_host_ = cfg.get_string("gateway.bind", "127.0.0.1");
     auth_token_ = cfg.get_string("gateway.auth.token", "");
     index_filename_ = cfg.get_string("gateway.index_file", "ui/control_ui.html");
+    int64_t queue_max = cfg.get_int("gateway.send_queue_max", 256);
+    send_queue_max_ = queue_max > 0 ? static_cast<size_t>(queue_max) : 1;
+    int64_t coalesce_ms = cfg.get_int("gateway.coalesce_ms", 50);
+    coalesce_ms_ = coalesce_ms > 0 ? static_cast<int>(coalesce_ms) : 0;
+    metrics_enabled_ = cfg.get_bool("gateway.metrics", true);
     
     LOG_INFO("Gateway config: port=%d, bind=%s, auth=%s", 
              port_, bind_host_.c_str(), auth_token_.empty() ? "disabled" : "enabled");
@@ -288,8 +511,15 @@ bool GatewayPlugin::init(const Config& cfg) {
     // Create WebSocket server (but don't start yet)
     ws_server_ = new WebSocketServer(this, index_filename_);
     
+    // Channels starting after us receive webhooks through our server
+    WebhookRouter::instance().set_mounted(true);
+    
     initialized_ = true;
-    LOG_INFO("Gateway plugin initialized (will start on first poll)");
+    
+    // Start once the main loop runs, after every channel has registered
+    Reactor::instance().post([this] { poll(); });
+    
+    LOG_INFO("Gateway plugin initialized (will start with the main loop)");
     return true;
 }
 
@@ -299,6 +529,15 @@ void GatewayPlugin::shutdown() {
     LOG_INFO("Shutting down gateway plugin...");
     
     stop();
+    WebhookRouter::instance().set_mounted(false);
+    
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (flush_timer_) {
+            Reactor::instance().cancel_timer(flush_timer_);
+            flush_timer_ = 0;
+        }
+    }
     
     if (ws_server_) {
         delete ws_server_;
@@ -306,6 +545,7 @@ void GatewayPlugin::shutdown() {
     }
     
     // Clean up clients
+    std::lock_guard<std::mutex> lock(clients_mutex_);
     for (auto it = clients_.begin(); it != clients_.end(); ++it) {
         delete *it;
     }
@@ -353,7 +593,7 @@ void GatewayPlugin::stop() {
 }
 
 void GatewayPlugin::poll() {
-    // Auto-start on first poll if not running
+    // Auto-start if not running
     if (!running_ && initialized_ && ws_server_) {
         start(port_);
     }
@@ -362,22 +602,163 @@ void GatewayPlugin::poll() {
     if (running_ && ws_server_) {
         ws_server_->poll(10);  // No-op but kept for API compatibility
     }
+    
+    flush_events(false);
 }
 
 size_t GatewayPlugin::client_count() const {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
     return clients_.size();
 }
 
 void GatewayPlugin::broadcast(const std::string& event, const Json& payload) {
+    broadcast_frame(event, payload, std::string(), false);
+}
+
+void GatewayPlugin::broadcast_frame(const std::string& event, const Json& payload,
+                                    const std::string& coalesce_key, bool droppable) {
     Json message = Json::object();
     message["type"] = "event";
     message["event"] = event;
     message["payload"] = payload;
     
-    std::string data = message.dump();
+    // One immutable frame per encoding, shared by every client's queue
+    EncodedFrames frames(message);
+    
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (auto it = clients_.begin(); it != clients_.end(); ++it) {
+        GatewayClient::Encoding enc = (*it)->encoding();
+        (*it)->enqueue(frames.get(enc), coalesce_key, droppable, enc != GatewayClient::JSON_TEXT);
+    }
+}
+
+void GatewayPlugin::queue_event(const std::string& event, const Json& payload,
+                                const std::string& coalesce_key, bool droppable) {
+    if (coalesce_ms_ <= 0) {
+        broadcast_frame(event, payload, coalesce_key, droppable);
+        return;
+    }
+    if (client_count() == 0) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    if (!coalesce_key.empty()) {
+        std::map<std::string, size_t>::iterator it = pending_index_.find(coalesce_key);
+        if (it != pending_index_.end()) {
+            pending_events_[it->second].payload = payload;
+            return;
+        }
+        pending_index_[coalesce_key] = pending_events_.size();
+    }
+    if (pending_events_.empty()) {
+        pending_since_ms_ = current_timestamp_ms();
+        arm_flush_locked();
+    }
+    
+    PendingEvent pending;
+    pending.event = event;
+    pending.payload = payload;
+    pending.coalesce_key = coalesce_key;
+    pending.droppable = droppable;
+    pending_events_.push_back(pending);
+}
+
+void GatewayPlugin::queue_delta(const Json& payload) {
+    // Shed first for a slow client: chat.done carries the whole reply
+    if (coalesce_ms_ <= 0) {
+        broadcast_frame("chat.delta", payload, std::string(), true);
+        return;
+    }
+    if (client_count() == 0) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    if (!pending_events_.empty()) {
+        PendingEvent& last = pending_events_.back();
+        if (last.event == "chat.delta" && last.payload["requestId"] == payload["requestId"]) {
+            last.payload["delta"] = last.payload["delta"].get<std::string>() +
+                                    payload["delta"].get<std::string>();
+            return;
+        }
+    }
+    if (pending_events_.empty()) {
+        pending_since_ms_ = current_timestamp_ms();
+        arm_flush_locked();
+    }
+    
+    PendingEvent pending;
+    pending.event = "chat.delta";
+    pending.payload = payload;
+    pending.droppable = true;
+    pending_events_.push_back(pending);
+}
+
+void GatewayPlugin::arm_flush_locked() {
+    if (flush_timer_) return;
+    flush_timer_ = Reactor::instance().add_timer(coalesce_ms_, 0, [this] {
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            flush_timer_ = 0;
+        }
+        flush_events(true);
+    });
+}
+
+void GatewayPlugin::flush_events(bool force) {
+    std::vector<PendingEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (pending_events_.empty()) return;
+        if (!force && current_timestamp_ms() - pending_since_ms_ < coalesce_ms_) return;
+        events.swap(pending_events_);
+        pending_index_.clear();
+    }
     
+    // Each frame is serialized once per encoding, when the first client
+    // using that encoding needs it
+    std::vector<std::unique_ptr<EncodedFrames> > frames(events.size());
+    std::unique_ptr<EncodedFrames> batch;
+    bool batch_droppable = true;
+    for (size_t i = 0; i < events.size(); ++i) {
+        batch_droppable = batch_droppable && events[i].droppable;
+    }
+    
+    std::lock_guard<std::mutex> lock(clients_mutex_);
     for (auto it = clients_.begin(); it != clients_.end(); ++it) {
-        (*it)->send(data);
+        GatewayClient* client = *it;
+        GatewayClient::Encoding enc = client->encoding();
+        bool binary = enc != GatewayClient::JSON_TEXT;
+        if (client->batch_events() && events.size() > 1) {
+            if (!batch) {
+                Json list = Json::array();
+                for (size_t i = 0; i < events.size(); ++i) {
+                    Json item = Json::object();
+                    item["event"] = events[i].event;
+                    item["payload"] = events[i].payload;
+                    list.push_back(item);
+                }
+                Json message = Json::object();
+                message["type"] = "event";
+                message["event"] = "batch";
+                message["payload"] = Json::object();
+                message["payload"]["events"] = list;
+                batch.reset(new EncodedFrames(message));
+            }
+            client->enqueue(batch->get(enc), std::string(), batch_droppable, binary);
+            continue;
+        }
+        for (size_t i = 0; i < events.size(); ++i) {
+            if (!frames[i]) {
+                Json message = Json::object();
+                message["type"] = "event";
+                message["event"] = events[i].event;
+                message["payload"] = events[i].payload;
+                frames[i].reset(new EncodedFrames(message));
+            }
+            client->enqueue(frames[i]->get(enc), events[i].coalesce_key, events[i].droppable, binary);
+        }
     }
 }
 
@@ -389,10 +770,12 @@ void GatewayPlugin::send_typing_event(const std::string& channel_id,
     payload["chat_id"] = chat_id;
     payload["typing"] = typing;
     
-    broadcast("chat.typing", payload);
+    // Typing state is the first thing shed for a slow client, and only the
+    // latest state per chat needs to reach it
+    queue_event("chat.typing", payload, "typing:" + channel_id + ":" + chat_id, true);
     
-    LOG_DEBUG("[Gateway] Sent typing=%s event for %s:%s to %zu clients", 
-              typing ? "true" : "false", channel_id.c_str(), chat_id.c_str(), clients_.size());
+    LOG_DEBUG("[Gateway] Queued typing=%s event for %s:%s to %zu clients", 
+              typing ? "true" : "false", channel_id.c_str(), chat_id.c_str(), client_count());
 }
 
 // ============================================================================
@@ -400,23 +783,44 @@ void GatewayPlugin::send_typing_event(const std::string& channel_id,
 // ============================================================================
 
 void GatewayPlugin::handle_client_connect(GatewayClient* client) {
-    clients_.insert(client);
+    size_t total;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        clients_.insert(client);
+        total = clients_.size();
+    }
     
-    LOG_INFO("Gateway client connected (total: %zu)", clients_.size());
+    LOG_INFO("Gateway client connected (total: %zu)", total);
 }
 
 void GatewayPlugin::handle_client_disconnect(GatewayClient* client) {
-    clients_.erase(client);
+    size_t remaining;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        clients_.erase(client);
+        remaining = clients_.size();
+    }
     
-    LOG_INFO("Gateway client disconnected (remaining: %zu)", clients_.size());
+    LOG_INFO("Gateway client disconnected (remaining: %zu)", remaining);
 }
 
 void GatewayPlugin::handle_client_message(GatewayClient* client, 
-                                          const std::string& msg) {
-    // Parse JSON message
+                                          const std::string& msg,
+                                          bool is_binary) {
+    // Parse the message: JSON text, or binary in the negotiated encoding
     Json request;
     try {
-        request = Json::parse(msg);
+        if (!is_binary) {
+            request = Json::parse(msg);
+        } else if (client->encoding() == GatewayClient::MSGPACK) {
+            request = Json::from_msgpack(msg);
+        } else if (client->encoding() == GatewayClient::CBOR) {
+            request = Json::from_cbor(msg);
+        } else {
+            LOG_ERROR("Binary frame from client %s before an encoding was negotiated",
+                     client->conn_id().c_str());
+            return;
+        }
     } catch (const std::exception& e) {
         LOG_ERROR("Invalid JSON from client %s: %s", 
                  client->conn_id().c_str(), e.what());
@@ -488,6 +892,14 @@ void GatewayPlugin::handle_client_message(GatewayClient* client,
     // Send response
     if (response.is_object()) {
         client->send_json(response);
+        
+        // hello-ok itself goes out in the old encoding; everything after it
+        // uses the one it announced
+        GatewayClient::Encoding encoding;
+        if (response.value("type", std::string("")) == "hello-ok" &&
+            parse_encoding(response.value("encoding", std::string("json")), encoding)) {
+            client->set_encoding(encoding);
+        }
     }
 }
 
@@ -508,6 +920,21 @@ Json GatewayPlugin::handle_hello(GatewayClient* client, const Json& params) {
     
     client->set_protocol_version(protocol);
     
+    client->set_batch_events(params.value("batchEvents", false));
+    
+    // First encoding the client lists that we support; JSON text otherwise
+    std::string encoding = "json";
+    if (params.contains("encodings") && params["encodings"].is_array()) {
+        const Json& wanted = params["encodings"];
+        GatewayClient::Encoding parsed;
+        for (size_t i = 0; i < wanted.size(); ++i) {
+            if (wanted[i].is_string() && parse_encoding(wanted[i].get<std::string>(), parsed)) {
+                encoding = encoding_names[parsed];
+                break;
+            }
+        }
+    }
+    
     // Extract client info
     if (params.contains("client")) {
         Json client_info = params["client"];
@@ -534,6 +961,7 @@ Json GatewayPlugin::handle_hello(GatewayClient* client, const Json& params) {
     Json response = Json::object();
     response["type"] = "hello-ok";
     response["protocol"] = protocol;
+    response["encoding"] = encoding;
     
     Json server_info = Json::object();
     server_info["version"] = "openclaw-cpp-1.0.0";
@@ -551,9 +979,17 @@ Json GatewayPlugin::handle_hello(GatewayClient* client, const Json& params) {
     
     Json events = Json::array();
     events.push_back("chat.delta");
+    events.push_back("chat.tool");
     events.push_back("chat.done");
     events.push_back("heartbeat");
     features["events"] = events;
+    features["batchEvents"] = true;
+    
+    Json encodings = Json::array();
+    for (int i = 0; i < GatewayClient::ENCODING_COUNT; ++i) {
+        encodings.push_back(encoding_names[i]);
+    }
+    features["encodings"] = encodings;
     response["features"] = features;
     
     // Initial snapshot
@@ -681,7 +1117,7 @@ void GatewayPlugin::route_incoming_message(const Message& msg) {
     LOG_DEBUG("[Gateway] routing incoming message from %s: %s", 
               msg.from_name.c_str(), msg.text.c_str());
     
-    broadcast("chat.message", event_payload);
+    queue_event("chat.message", event_payload, std::string(), false);
 }
 
 void GatewayPlugin::on_incoming_message(const Message& msg) {
@@ -700,6 +1136,34 @@ void GatewayPlugin::on_typing_indicator(const std::string& channel_id,
     send_typing_event(channel_id, chat_id, typing);
 }
 
+void GatewayPlugin::on_turn_event(const TurnEvent& event) {
+    Json payload = Json::object();
+    payload["requestId"] = event.request_id;
+    payload["channel"] = event.channel;
+    payload["chat_id"] = event.chat_id;
+    
+    switch (event.kind) {
+    case TurnEvent::DELTA:
+        payload["delta"] = event.text;
+        queue_delta(payload);
+        break;
+    case TurnEvent::TOOL_START:
+    case TurnEvent::TOOL_FINISH:
+        payload["tool"] = event.text;
+        payload["phase"] = event.kind == TurnEvent::TOOL_START ? "start" : "finish";
+        if (event.kind == TurnEvent::TOOL_FINISH) {
+            payload["success"] = event.success;
+        }
+        queue_event("chat.tool", payload, std::string(), false);
+        break;
+    case TurnEvent::DONE:
+        payload["text"] = event.text;
+        payload["success"] = event.success;
+        queue_event("chat.done", payload, std::string(), false);
+        break;
+    }
+}
+
 } // namespace openclaw
 
 // Export plugin for dynamic loading
@@ -1,13 +1,111 @@
 #include <openclaw/plugins/llamacpp/llamacpp.hpp>
 #include <openclaw/core/loader.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/json_reader.hpp>
 #include <sstream>
 
 namespace openclaw {
 
+namespace {
+
+// OpenAI function arguments arrive as a JSON-encoded string
+Json parse_arguments(const std::string& arguments, const std::string& tool_name) {
+    if (arguments.empty()) {
+        return Json::object();
+    }
+    try {
+        Json input = Json::parse(arguments);
+        if (input.is_object()) return input;
+    } catch (...) {
+    }
+    LOG_WARN("[LlamaCpp] Unparseable arguments for tool '%s'", tool_name.c_str());
+    return Json::object();
+}
+
+// Servers that omit call ids still need stable ones for the results
+std::string tool_call_id(const std::string& id, size_t index) {
+    return id.empty() ? "call_" + std::to_string(index) : id;
+}
+
+// One choice of an OpenAI-compatible completion (its message) or stream
+// chunk (its delta), as it is read
+struct ChoiceFields {
+    struct Call {
+        int64_t index;          // Stream chunks say which call a delta is for
+        std::string id;
+        std::string name;
+        std::string arguments;
+        bool has_function;
+        
+        Call() : index(-1), has_function(false) {}
+    };
+    
+    std::string content;
+    std::string reasoning;
+    bool has_reasoning;
+    std::string finish_reason;
+    std::vector<Call> calls;
+    
+    ChoiceFields() : has_reasoning(false) {}
+    
+    void reset() { *this = ChoiceFields(); }
+};
+
+// Fields of the choice under prefix ("choices.*.message." or
+// "choices.*.delta.")
+void bind_choice(JsonReader& reader, const std::string& prefix, ChoiceFields& choice) {
+    reader.bind(prefix + "content", choice.content);
+    reader.on(prefix + "reasoning_content", [&choice](JsonValue& v) {
+        choice.has_reasoning = true;
+        if (v.is_string()) choice.reasoning = v.take_string();
+    });
+    reader.bind("choices.*.finish_reason", choice.finish_reason);
+    
+    std::string call = prefix + "tool_calls.*";
+    reader.on_begin(call, [&choice] { choice.calls.push_back(ChoiceFields::Call()); });
+    reader.on(call + ".index", [&choice](JsonValue& v) {
+        if (v.is_number()) choice.calls.back().index = v.as_int();
+    });
+    reader.on(call + ".id", [&choice](JsonValue& v) {
+        if (v.is_string()) choice.calls.back().id = v.take_string();
+    });
+    reader.on_begin(call + ".function", [&choice] { choice.calls.back().has_function = true; });
+    reader.on(call + ".function.name", [&choice](JsonValue& v) {
+        if (v.is_string()) choice.calls.back().name = v.take_string();
+    });
+    reader.on(call + ".function.arguments", [&choice](JsonValue& v) {
+        if (v.is_string()) choice.calls.back().arguments = v.take_string();
+    });
+}
+
+// Fields of a /completion response, or of its final stream event
+void bind_native(JsonReader& reader, CompletionResult& result, std::string& stop_type) {
+    reader.bind("model", result.model);
+    reader.bind("content", result.content);
+    reader.bind("stop_type", stop_type);
+    reader.bind("tokens_evaluated", result.usage.input_tokens);
+    reader.bind("tokens_predicted", result.usage.output_tokens);
+    reader.bind("tokens_cached", result.usage.cache_read_tokens);
+}
+
+// Keeps the first choice of a body: choices after it only pass through
+// the scratch fields
+void keep_first_choice(JsonReader& reader, ChoiceFields& scratch, ChoiceFields& first,
+                       size_t& choices) {
+    reader.on_begin("choices.*", [&scratch] { scratch.reset(); });
+    reader.on_end("choices.*", [&scratch, &first, &choices] {
+        if (choices++ == 0) first = scratch;
+    });
+}
+
+} // anonymous namespace
+
 LlamaCppAI::LlamaCppAI()
     : server_url_("http://localhost:8080")
     , api_key_()
     , default_model_("local-model")
+    , context_size_(0)
+    , native_completion_(false)
     , initialized_(false)
 {}
 
@@ -26,13 +124,38 @@ bool LlamaCppAI::init(const Config& cfg) {
         default_model_ = model;
     }
     
+    native_completion_ = (cfg.get_string("llamacpp.endpoint", "chat") == "completion");
+    
     // Remove trailing slash from URL
     while (!server_url_.empty() && server_url_[server_url_.length() - 1] == '/') {
         server_url_ = server_url_.substr(0, server_url_.length() - 1);
     }
     
-    LOG_INFO("Llama.cpp AI initialized with server: %s, model: %s", 
-             server_url_.c_str(), default_model_.c_str());
+    // Context window: config override, else ask the server
+    context_size_ = cfg.get_int("llamacpp.context_size", 0);
+    if (context_size_ <= 0) {
+        HttpClient http;
+        http.set_timeout(2000);
+        std::map<std::string, std::string> headers;
+        if (!api_key_.empty()) {
+            headers["Authorization"] = "Bearer " + api_key_;
+        }
+        HttpResponse props = http.get(server_url_ + "/props", headers);
+        Json j = props.json();
+        if (props.ok() && j.is_object() && j.contains("default_generation_settings") &&
+            j["default_generation_settings"].is_object()) {
+            context_size_ = j["default_generation_settings"].value("n_ctx", 0);
+        }
+        if (context_size_ > 0) {
+            LOG_DEBUG("[LlamaCpp] Server context window: %d tokens", context_size_);
+        } else {
+            LOG_DEBUG("[LlamaCpp] Context window unknown (set llamacpp.context_size)");
+        }
+    }
+    
+    LOG_INFO("Llama.cpp AI initialized with server: %s, model: %s, endpoint: %s", 
+             server_url_.c_str(), default_model_.c_str(),
+             native_completion_ ? "/completion" : "/v1/chat/completions");
     initialized_ = true;
     return true;
 }
@@ -55,6 +178,21 @@ std::string LlamaCppAI::default_model() const { return default_model_; }
 
 bool LlamaCppAI::is_configured() const { return initialized_; }
 
+int LlamaCppAI::context_window(const std::string& model) const {
+    (void)model;  // One model per server
+    return context_size_;
+}
+
+bool LlamaCppAI::supports_native_tools() const {
+    // Needs the chat template support of the OpenAI-compatible endpoint
+    return !native_completion_;
+}
+
+TokenEstimator LlamaCppAI::token_estimator() const {
+    // Local vocabularies vary; lean high so the server never overflows
+    return TokenEstimator(1.2);
+}
+
 CompletionResult LlamaCppAI::complete(
     const std::string& prompt,
     const CompletionOptions& opts
@@ -67,20 +205,57 @@ CompletionResult LlamaCppAI::complete(
     return chat(messages, opts);
 }
 
-CompletionResult LlamaCppAI::chat(
+bool LlamaCppAI::build_request(
     const std::vector<ConversationMessage>& messages,
-    const CompletionOptions& opts
-) {
+    const CompletionOptions& opts,
+    HttpRequest& out,
+    std::string& error
+) const {
     if (!initialized_) {
-        return CompletionResult::fail("Llama.cpp AI not initialized");
+        error = "Llama.cpp AI not initialized";
+        return false;
     }
     
     if (messages.empty()) {
-        return CompletionResult::fail("No messages provided");
+        error = "No messages provided";
+        return false;
     }
     
     LOG_DEBUG("[LlamaCpp] Starting chat request with %zu messages", messages.size());
     
+    bool streaming = opts.stream && opts.on_chunk;
+    std::string system_prompt = opts.full_system_prompt();
+    
+    if (native_completion_) {
+        // Native llama.cpp endpoint: raw prompt, server-side sampling params
+        Json request = Json::object();
+        request["prompt"] = render_chatml(messages, system_prompt);
+        request["stop"] = Json::array({"<|im_end|>"});
+        if (opts.temperature >= 0.0) {
+            request["temperature"] = opts.temperature;
+        }
+        if (opts.max_tokens > 0) {
+            request["n_predict"] = static_cast<int64_t>(opts.max_tokens);
+        }
+        request["stream"] = streaming;
+        
+        // Reuse the KV cache for the shared prompt prefix between calls
+        request["cache_prompt"] = opts.cache_prompt;
+        
+        std::string endpoint = server_url_ + "/completion";
+        out = HttpRequest("POST", endpoint, request.dump());
+        out.headers["Content-Type"] = "application/json";
+        if (!api_key_.empty()) {
+            out.headers["Authorization"] = "Bearer " + api_key_;
+        }
+        if (streaming) {
+            out.timeout_ms = 600000;
+        }
+        
+        LOG_DEBUG("[LlamaCpp] Sending request to %s (%zu bytes)", endpoint.c_str(), out.body.size());
+        return true;
+    }
+    
     // Build OpenAI-compatible request
     Json request = Json::object();
     
@@ -89,12 +264,12 @@ CompletionResult LlamaCppAI::chat(
     LOG_DEBUG("[LlamaCpp] Using model: %s", model.c_str());
     
     // Add system prompt if provided
-    if (!opts.system_prompt.empty()) {
+    if (!system_prompt.empty()) {
         LOG_DEBUG("[LlamaCpp] === System Prompt ===");
         LOG_DEBUG("[LlamaCpp] System prompt (%zu chars): %.500s%s", 
-                  opts.system_prompt.size(), 
-                  opts.system_prompt.c_str(),
-                  opts.system_prompt.size() > 500 ? "..." : "");
+                  system_prompt.size(), 
+                  system_prompt.c_str(),
+                  system_prompt.size() > 500 ? "..." : "");
         LOG_DEBUG("[LlamaCpp] === End System Prompt ===");
     }
     
@@ -102,20 +277,52 @@ CompletionResult LlamaCppAI::chat(
     Json msgs = Json::array();
     
     // Prepend system message if system prompt is provided
-    if (!opts.system_prompt.empty()) {
+    if (!system_prompt.empty()) {
         Json sys_msg = Json::object();
         sys_msg["role"] = "system";
-        sys_msg["content"] = opts.system_prompt;
+        sys_msg["content"] = system_prompt;
         msgs.push_back(sys_msg);
     }
     
     LOG_DEBUG("[LlamaCpp] === Messages being sent to AI ===");
     for (size_t i = 0; i < messages.size(); ++i) {
         const ConversationMessage& msg = messages[i];
+        bool paired = tool_blocks_paired(messages, i);
+        
+        // Native tool results are one "tool" message per call
+        if (paired && msg.role == MessageRole::USER) {
+            for (size_t r = 0; r < msg.tool_results.size(); ++r) {
+                Json m = Json::object();
+                m["role"] = "tool";
+                m["tool_call_id"] = msg.tool_results[r].tool_use_id;
+                m["content"] = msg.tool_results[r].content;
+                msgs.push_back(m);
+            }
+            LOG_DEBUG("[LlamaCpp]   [%zu] %zu tool result(s)", i, msg.tool_results.size());
+            continue;
+        }
         
         Json m = Json::object();
         m["role"] = role_to_string(msg.role);
-        m["content"] = msg.content;
+        if (paired) {
+            m["content"] = msg.content;
+            Json tool_calls = Json::array();
+            for (size_t t = 0; t < msg.tool_uses.size(); ++t) {
+                Json function = Json::object();
+                function["name"] = msg.tool_uses[t].name;
+                function["arguments"] = msg.tool_uses[t].input.dump();
+                Json call = Json::object();
+                call["id"] = msg.tool_uses[t].id;
+                call["type"] = "function";
+                call["function"] = function;
+                tool_calls.push_back(call);
+            }
+            m["tool_calls"] = tool_calls;
+        } else if (!msg.tool_uses.empty()) {
+            m["content"] = tool_uses_as_text(msg);
+        } else {
+            m["content"] = msg.content;
+        }
         msgs.push_back(m);
         
         LOG_DEBUG("[LlamaCpp]   [%zu] %s (%zu chars): %.300s%s", 
@@ -126,6 +333,22 @@ CompletionResult LlamaCppAI::chat(
     request["messages"] = msgs;
     LOG_DEBUG("[LlamaCpp] === End of messages ===");
     
+    if (!opts.tools.empty()) {
+        Json tools = Json::array();
+        for (size_t i = 0; i < opts.tools.size(); ++i) {
+            Json function = Json::object();
+            function["name"] = opts.tools[i].name;
+            function["description"] = opts.tools[i].description;
+            function["parameters"] = opts.tools[i].input_schema;
+            Json tool = Json::object();
+            tool["type"] = "function";
+            tool["function"] = function;
+            tools.push_back(tool);
+        }
+        request["tools"] = tools;
+        LOG_DEBUG("[LlamaCpp] Sending %zu native tool definitions", opts.tools.size());
+    }
+    
     // Set parameters
     if (opts.temperature >= 0.0) {
         request["temperature"] = opts.temperature;
@@ -135,26 +358,36 @@ CompletionResult LlamaCppAI::chat(
         request["max_tokens"] = static_cast<int64_t>(opts.max_tokens);
     }
     
-    if (opts.stream) {
-        request["stream"] = false;  // For now, disable streaming
+    // llama.cpp extension: reuse the KV cache for the shared prompt prefix
+    request["cache_prompt"] = opts.cache_prompt;
+    
+    if (streaming) {
+        request["stream"] = true;
+        
+        // Final chunk carries token counts
+        Json stream_options = Json::object();
+        stream_options["include_usage"] = true;
+        request["stream_options"] = stream_options;
     }
     
     std::string endpoint = server_url_ + "/v1/chat/completions";
-    std::string request_body = request.dump();
-    LOG_DEBUG("[LlamaCpp] Sending request to %s (%zu bytes)", endpoint.c_str(), request_body.size());
-    
-    // Prepare HTTP client
-    HttpClient http;
-    std::map<std::string, std::string> headers;
-    headers["Content-Type"] = "application/json";
+    out = HttpRequest("POST", endpoint, request.dump());
+    out.headers["Content-Type"] = "application/json";
     
     if (!api_key_.empty()) {
-        headers["Authorization"] = "Bearer " + api_key_;
+        out.headers["Authorization"] = "Bearer " + api_key_;
     }
     
-    // Make request to llama.cpp server
-    HttpResponse response = http.post_json(endpoint, request_body, headers);
+    if (streaming) {
+        // Local generations can be slow; the stall timeout still applies
+        out.timeout_ms = 600000;
+    }
     
+    LOG_DEBUG("[LlamaCpp] Sending request to %s (%zu bytes)", endpoint.c_str(), out.body.size());
+    return true;
+}
+
+CompletionResult LlamaCppAI::parse_response(const HttpResponse& response) const {
     if (response.status_code == 0) {
         LOG_ERROR("[LlamaCpp] HTTP request failed: %s", response.error.c_str());
         return CompletionResult::fail("HTTP request failed: " + response.error);
@@ -163,9 +396,8 @@ CompletionResult LlamaCppAI::chat(
     LOG_DEBUG("[LlamaCpp] Received response [HTTP %d] (%zu bytes)", 
               response.status_code, response.body.size());
     
-    Json resp = response.json();
-    
     if (response.status_code != 200) {
+        Json resp = response.json();
         std::string error_msg = "API error";
         if (resp.is_object()) {
             if (resp.contains("error") && resp["error"].is_object()) {
@@ -180,102 +412,112 @@ CompletionResult LlamaCppAI::chat(
                                      std::to_string(response.status_code) + ")");
     }
     
-    // Parse OpenAI-compatible response
+    // Parse OpenAI-compatible response straight into the result
     CompletionResult result;
     result.success = true;
-    result.model = resp.value("model", std::string(""));
+    ChoiceFields scratch;
+    ChoiceFields first;
+    size_t choices = 0;
+    JsonReader reader;
+    reader.bind("model", result.model);
+    keep_first_choice(reader, scratch, first, choices);
+    bind_choice(reader, "choices.*.message.", scratch);
+    reader.bind("usage.prompt_tokens", result.usage.input_tokens);
+    reader.bind("usage.completion_tokens", result.usage.output_tokens);
+    reader.bind("usage.total_tokens", result.usage.total_tokens);
+    reader.bind("usage.prompt_tokens_details.cached_tokens", result.usage.cache_read_tokens);
+    
+    std::string parse_error;
+    if (!reader.parse(response.body, &parse_error)) {
+        LOG_ERROR("[LlamaCpp] Invalid response body: %s", parse_error.c_str());
+        return CompletionResult::fail("Invalid response: " + parse_error);
+    }
+    
+    result.content = first.content;
+    result.stop_reason = first.finish_reason;
+    for (size_t i = 0; i < first.calls.size(); ++i) {
+        const ChoiceFields::Call& call = first.calls[i];
+        if (!call.has_function) continue;
+        ToolUse use;
+        use.id = tool_call_id(call.id, i);
+        use.name = call.name;
+        use.input = parse_arguments(call.arguments, use.name);
+        result.tool_uses.push_back(use);
+    }
     
-    if (resp.contains("choices") && resp["choices"].is_array() && !resp["choices"].empty()) {
-        const Json& first_choice = resp["choices"][0];
+    // Check if content is empty but we have reasoning_content (model using structured output)
+    if (result.content.empty() && result.tool_uses.empty() && first.has_reasoning) {
+        const std::string& reasoning = first.reasoning;
+        LOG_DEBUG("[LlamaCpp] Content empty but found reasoning_content (%zu chars)", reasoning.size());
+        
+        // The model may be using its native structured format
+        // We need to reconstruct a tool call format from the original response
+        // Check the raw response body for tool call indicators
+        const std::string& raw_body = response.body;
         
-        if (first_choice.contains("message") && first_choice["message"].is_object()) {
-            const Json& message = first_choice["message"];
-            result.content = message.value("content", std::string(""));
+        // Look for "to=" pattern which indicates a tool call
+        size_t to_pos = raw_body.find(" to=");
+        if (to_pos != std::string::npos) {
+            LOG_DEBUG("[LlamaCpp] Found 'to=' pattern, attempting to reconstruct tool call");
             
-            // Check if content is empty but we have reasoning_content (model using structured output)
-            if (result.content.empty() && message.contains("reasoning_content")) {
-                std::string reasoning = message.value("reasoning_content", std::string(""));
-                LOG_DEBUG("[LlamaCpp] Content empty but found reasoning_content (%zu chars)", reasoning.size());
-                
-                // The model may be using its native structured format
-                // We need to reconstruct a tool call format from the original response
-                // Check the raw response body for tool call indicators
-                std::string raw_body = response.body;
+            // Extract tool name
+            size_t tool_start = to_pos + 4;
+            size_t tool_end = raw_body.find_first_of(" <\n\r\"", tool_start);
+            if (tool_end != std::string::npos) {
+                std::string tool_name = raw_body.substr(tool_start, tool_end - tool_start);
                 
-                // Look for "to=" pattern which indicates a tool call
-                size_t to_pos = raw_body.find(" to=");
-                if (to_pos != std::string::npos) {
-                    LOG_DEBUG("[LlamaCpp] Found 'to=' pattern, attempting to reconstruct tool call");
+                // Look for JSON params
+                size_t json_start = raw_body.find('{', tool_end);
+                if (json_start != std::string::npos && json_start < tool_end + 100) {
+                    int brace_count = 1;
+                    size_t json_end = json_start + 1;
+                    while (json_end < raw_body.size() && brace_count > 0) {
+                        if (raw_body[json_end] == '{') brace_count++;
+                        else if (raw_body[json_end] == '}') brace_count--;
+                        json_end++;
+                    }
                     
-                    // Extract tool name
-                    size_t tool_start = to_pos + 4;
-                    size_t tool_end = raw_body.find_first_of(" <\n\r\"", tool_start);
-                    if (tool_end != std::string::npos) {
-                        std::string tool_name = raw_body.substr(tool_start, tool_end - tool_start);
+                    if (brace_count == 0) {
+                        std::string json_params = raw_body.substr(json_start, json_end - json_start);
                         
-                        // Look for JSON params
-                        size_t json_start = raw_body.find('{', tool_end);
-                        if (json_start != std::string::npos && json_start < tool_end + 100) {
-                            int brace_count = 1;
-                            size_t json_end = json_start + 1;
-                            while (json_end < raw_body.size() && brace_count > 0) {
-                                if (raw_body[json_end] == '{') brace_count++;
-                                else if (raw_body[json_end] == '}') brace_count--;
-                                json_end++;
-                            }
-                            
-                            if (brace_count == 0) {
-                                std::string json_params = raw_body.substr(json_start, json_end - json_start);
-                                
-                                // Unescape the JSON (it's inside a JSON string in the response)
-                                // Replace \" with "
-                                std::string unescaped;
-                                unescaped.reserve(json_params.size());
-                                for (size_t i = 0; i < json_params.size(); ++i) {
-                                    if (json_params[i] == '\\' && i + 1 < json_params.size()) {
-                                        char next = json_params[i + 1];
-                                        if (next == '"' || next == '\\' || next == 'n' || next == 't' || next == 'r') {
-                                            // Skip the backslash for quotes, keep for newlines/tabs
-                                            if (next == '"') {
-                                                unescaped += '"';
-                                                i++;
-                                                continue;
-                                            }
-                                        }
+                        // Unescape the JSON (it's inside a JSON string in the response)
+                        // Replace \" with "
+                        std::string unescaped;
+                        unescaped.reserve(json_params.size());
+                        for (size_t i = 0; i < json_params.size(); ++i) {
+                            if (json_params[i] == '\\' && i + 1 < json_params.size()) {
+                                char next = json_params[i + 1];
+                                if (next == '"' || next == '\\' || next == 'n' || next == 't' || next == 'r') {
+                                    // Skip the backslash for quotes, keep for newlines/tabs
+                                    if (next == '"') {
+                                        unescaped += '"';
+                                        i++;
+                                        continue;
                                     }
-                                    unescaped += json_params[i];
                                 }
-                                
-                                // Reconstruct as standard tool_call format
-                                std::ostringstream reconstructed;
-                                reconstructed << reasoning << "\n\n";
-                                reconstructed << "<tool_call name=\"" << tool_name << "\">\n";
-                                reconstructed << unescaped << "\n";
-                                reconstructed << "</tool_call>";
-                                
-                                result.content = reconstructed.str();
-                                LOG_INFO("[LlamaCpp] Reconstructed tool call: %s with params", tool_name.c_str());
-                                LOG_DEBUG("[LlamaCpp] Reconstructed content: %.300s", result.content.c_str());
                             }
+                            unescaped += json_params[i];
                         }
+                        
+                        // Reconstruct as standard tool_call format
+                        std::ostringstream reconstructed;
+                        reconstructed << reasoning << "\n\n";
+                        reconstructed << "<tool_call name=\"" << tool_name << "\">\n";
+                        reconstructed << unescaped << "\n";
+                        reconstructed << "</tool_call>";
+                        
+                        result.content = reconstructed.str();
+                        LOG_INFO("[LlamaCpp] Reconstructed tool call: %s with params", tool_name.c_str());
+                        LOG_DEBUG("[LlamaCpp] Reconstructed content: %.300s", result.content.c_str());
                     }
                 }
-                
-                // If we couldn't reconstruct, at least return the reasoning
-                if (result.content.empty()) {
-                    result.content = reasoning;
-                }
             }
         }
         
-        result.stop_reason = first_choice.value("finish_reason", std::string(""));
-    }
-    
-    if (resp.contains("usage") && resp["usage"].is_object()) {
-        const Json& usage = resp["usage"];
-        result.usage.input_tokens = usage.value("prompt_tokens", 0);
-        result.usage.output_tokens = usage.value("completion_tokens", 0);
-        result.usage.total_tokens = usage.value("total_tokens", 0);
+        // If we couldn't reconstruct, at least return the reasoning
+        if (result.content.empty()) {
+            result.content = reasoning;
+        }
     }
     
     LOG_DEBUG("[LlamaCpp] === AI Response ===");
@@ -290,6 +532,312 @@ CompletionResult LlamaCppAI::chat(
     return result;
 }
 
+CompletionResult LlamaCppAI::parse_native_response(const HttpResponse& response) const {
+    // Transport and HTTP errors look the same on both endpoints
+    if (response.status_code != 200) {
+        return parse_response(response);
+    }
+    
+    CompletionResult result;
+    result.success = true;
+    std::string stop_type;
+    JsonReader reader;
+    bind_native(reader, result, stop_type);
+    if (!reader.parse(response.body)) {
+        return CompletionResult::fail("Invalid response from /completion");
+    }
+    result.stop_reason = (stop_type == "limit") ? "length" : "stop";
+    result.usage.total_tokens = result.usage.input_tokens + result.usage.output_tokens;
+    
+    LOG_DEBUG("[LlamaCpp] Native response: %zu chars, %d tokens, stop: %s",
+              result.content.size(), result.usage.output_tokens, result.stop_reason.c_str());
+    return result;
+}
+
+std::string LlamaCppAI::render_chatml(const std::vector<ConversationMessage>& messages,
+                                      const std::string& system_prompt) {
+    // ChatML is also what llama.cpp falls back to for models without a template
+    std::ostringstream prompt;
+    if (!system_prompt.empty()) {
+        prompt << "<|im_start|>system\n" << system_prompt << "<|im_end|>\n";
+    }
+    for (size_t i = 0; i < messages.size(); ++i) {
+        prompt << "<|im_start|>" << role_to_string(messages[i].role) << "\n"
+               << messages[i].content << "<|im_end|>\n";
+    }
+    prompt << "<|im_start|>assistant\n";
+    return prompt.str();
+}
+
+// ============================================================================
+// Streaming
+// ============================================================================
+
+struct LlamaCppAI::StreamState {
+    SseParser parser;
+    StreamCallback on_chunk;
+    bool native;
+    CompletionResult result;
+    std::string text;
+    std::string reasoning;
+    std::string error;
+    std::vector<ToolUse> tool_uses;     // Native tool calls, by delta index
+    std::vector<std::string> tool_args; // Their argument strings so far
+    int tokens;                 // llama.cpp sends one token per event
+    int64_t start_ms;
+    int64_t first_token_ms;
+    int64_t last_token_ms;
+    int64_t last_report_ms;     // Last progress log line
+    double server_tps;          // From the server's own timings, if sent
+    
+    // Fields of the event being read; one reader serves both endpoints
+    JsonReader reader;
+    CompletionResult event;     // Native fields, and the model
+    std::string stop_type;
+    bool stop;
+    bool has_error;
+    std::string error_message;
+    double event_tps;
+    ChoiceFields scratch;
+    ChoiceFields choice;        // First choice of the chunk
+    size_t choices;
+    bool has_usage;
+    UsageStats usage;
+    
+    StreamState(StreamCallback cb, bool is_native)
+        : parser([this](const std::string& event, const std::string& data) {
+              on_event(event, data);
+          })
+        , on_chunk(cb)
+        , native(is_native)
+        , tokens(0)
+        , start_ms(current_timestamp_ms())
+        , first_token_ms(0)
+        , last_token_ms(0)
+        , last_report_ms(0)
+        , server_tps(0.0)
+        , stop(false)
+        , has_error(false)
+        , event_tps(0.0)
+        , choices(0)
+        , has_usage(false) {
+        bind_native(reader, event, stop_type);
+        reader.bind("stop", stop);
+        reader.on_begin("error", [this] { has_error = true; });
+        reader.bind("error.message", error_message);
+        reader.bind("timings.predicted_per_second", event_tps);
+        keep_first_choice(reader, scratch, choice, choices);
+        bind_choice(reader, "choices.*.delta.", scratch);
+        reader.on_begin("usage", [this] { has_usage = true; });
+        reader.bind("usage.prompt_tokens", usage.input_tokens);
+        reader.bind("usage.completion_tokens", usage.output_tokens);
+        reader.bind("usage.prompt_tokens_details.cached_tokens", usage.cache_read_tokens);
+    }
+    
+    double tokens_per_second() const {
+        if (server_tps > 0.0) return server_tps;
+        int64_t elapsed = last_token_ms - first_token_ms;
+        return (tokens > 1 && elapsed > 0) ? (tokens - 1) * 1000.0 / elapsed : 0.0;
+    }
+    
+    void on_token(const std::string& chunk) {
+        int64_t now = current_timestamp_ms();
+        if (tokens == 0) {
+            first_token_ms = now;
+            last_report_ms = now;
+            LOG_DEBUG("[LlamaCpp] First token after %lld ms",
+                      static_cast<long long>(now - start_ms));
+        }
+        tokens++;
+        last_token_ms = now;
+        text += chunk;
+        if (on_chunk) on_chunk(chunk);
+        
+        if (now - last_report_ms >= 2000) {
+            last_report_ms = now;
+            LOG_DEBUG("[LlamaCpp] Streaming: %d tokens, %.1f tokens/sec", tokens, tokens_per_second());
+        }
+    }
+    
+    // Each call streams as an id and name, then argument fragments
+    void on_tool_call_deltas(const std::vector<ChoiceFields::Call>& calls) {
+        for (size_t i = 0; i < calls.size(); ++i) {
+            const ChoiceFields::Call& call = calls[i];
+            size_t index = call.index >= 0 ? static_cast<size_t>(call.index) : i;
+            if (index >= tool_uses.size()) {
+                tool_uses.resize(index + 1);
+                tool_args.resize(index + 1);
+            }
+            if (!call.id.empty()) {
+                tool_uses[index].id = call.id;
+            }
+            tool_uses[index].name += call.name;
+            tool_args[index] += call.arguments;
+        }
+    }
+    
+    void on_event(const std::string& name, const std::string& data) {
+        (void)name;
+        if (data == "[DONE]") {
+            return;
+        }
+        event = CompletionResult();
+        stop_type.clear();
+        stop = false;
+        has_error = false;
+        error_message.clear();
+        event_tps = 0.0;
+        choice.reset();
+        choices = 0;
+        has_usage = false;
+        usage = UsageStats();
+        if (!reader.parse(data)) {
+            LOG_DEBUG("[LlamaCpp] Ignoring unparseable stream event (%zu bytes)", data.size());
+            return;
+        }
+        
+        if (has_error) {
+            error = error_message.empty() ? std::string("stream error") : error_message;
+            return;
+        }
+        
+        if (event_tps > 0.0) server_tps = event_tps;
+        
+        if (native) {
+            if (!event.content.empty()) on_token(event.content);
+            if (stop) {
+                result.model = event.model;
+                result.stop_reason = (stop_type == "limit") ? "length" : "stop";
+                result.usage = event.usage;
+            }
+            return;
+        }
+        
+        // OpenAI-compatible chunk
+        if (result.model.empty()) {
+            result.model = event.model;
+        }
+        if (choices > 0) {
+            if (!choice.content.empty()) on_token(choice.content);
+            reasoning += choice.reasoning;
+            on_tool_call_deltas(choice.calls);
+            if (!choice.finish_reason.empty()) {
+                result.stop_reason = choice.finish_reason;
+            }
+        }
+        if (has_usage) {
+            result.usage.input_tokens = usage.input_tokens;
+            result.usage.output_tokens = usage.output_tokens;
+            result.usage.cache_read_tokens = usage.cache_read_tokens;
+        }
+    }
+};
+
+LlamaCppAI::StreamStatePtr LlamaCppAI::attach_stream(HttpRequest& req,
+                                                     const CompletionOptions& opts) const {
+    if (!opts.stream || !opts.on_chunk) {
+        return StreamStatePtr();
+    }
+    StreamStatePtr state(new StreamState(opts.on_chunk, native_completion_));
+    req.on_data = [state](const char* data, size_t len) {
+        state->parser.feed(data, len);
+    };
+    return state;
+}
+
+CompletionResult LlamaCppAI::finish_stream(StreamState& state, const HttpResponse& response) const {
+    // Errors before the stream started come back as a regular JSON body
+    if (!response.ok()) {
+        return parse_response(response);
+    }
+    
+    state.parser.finish();
+    if (!state.error.empty()) {
+        LOG_ERROR("[LlamaCpp] Stream error: %s", state.error.c_str());
+        return CompletionResult::fail(state.error);
+    }
+    
+    CompletionResult result = state.result;
+    result.success = true;
+    result.content = state.text;
+    for (size_t i = 0; i < state.tool_uses.size(); ++i) {
+        ToolUse use = state.tool_uses[i];
+        if (use.name.empty()) continue;
+        use.id = tool_call_id(use.id, i);
+        use.input = parse_arguments(state.tool_args[i], use.name);
+        result.tool_uses.push_back(use);
+    }
+    if (result.content.empty() && result.tool_uses.empty() && !state.reasoning.empty()) {
+        LOG_DEBUG("[LlamaCpp] Stream had only reasoning_content (%zu chars)", state.reasoning.size());
+        result.content = state.reasoning;
+    }
+    if (result.usage.output_tokens == 0) {
+        result.usage.output_tokens = state.tokens;
+    }
+    result.usage.total_tokens = result.usage.input_tokens + result.usage.output_tokens;
+    
+    LOG_INFO("[LlamaCpp] Generated %d tokens in %lld ms (%.1f tokens/sec)",
+             result.usage.output_tokens,
+             static_cast<long long>(current_timestamp_ms() - state.start_ms),
+             state.tokens_per_second());
+    return result;
+}
+
+CompletionResult LlamaCppAI::chat(
+    const std::vector<ConversationMessage>& messages,
+    const CompletionOptions& opts
+) {
+    HttpRequest req;
+    std::string error;
+    if (!build_request(messages, opts, req, error)) {
+        return CompletionResult::fail(error);
+    }
+    
+    StreamStatePtr stream = attach_stream(req, opts);
+    
+    // Make request to llama.cpp server
+    HttpClient http;
+    HttpResponse response = http.perform(req);
+    CompletionResult result;
+    if (stream) {
+        result = finish_stream(*stream, response);
+    } else {
+        result = native_completion_ ? parse_native_response(response) : parse_response(response);
+    }
+    result.http_status = response.status_code;
+    result.response_headers = response.headers;
+    return result;
+}
+
+void LlamaCppAI::chat_async(
+    const std::vector<ConversationMessage>& messages,
+    const CompletionOptions& opts,
+    CompletionCallback on_done
+) {
+    HttpRequest req;
+    std::string error;
+    if (!build_request(messages, opts, req, error)) {
+        if (on_done) on_done(CompletionResult::fail(error));
+        return;
+    }
+    
+    StreamStatePtr stream = attach_stream(req, opts);
+    
+    AsyncHttpEngine::instance().submit(req, [this, stream, on_done](const HttpResponse& response) {
+        CompletionResult result;
+        if (stream) {
+            result = finish_stream(*stream, response);
+        } else if (native_completion_) {
+            result = parse_native_response(response);
+        } else {
+            result = parse_response(response);
+        }
+        result.http_status = response.status_code;
+        result.response_headers = response.headers;
+        if (on_done) on_done(result);
+    });
+}
+
 std::string LlamaCppAI::ask(const std::string& question, const std::string& system) {
     CompletionOptions opts;
     if (!system.empty()) {
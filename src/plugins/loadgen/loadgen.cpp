@@ -0,0 +1,414 @@
+/*
+ * OpenClaw C++11 - Load Generator Channel Plugin Implementation
+ */
+#include <openclaw/plugins/loadgen/loadgen.hpp>
+#include <openclaw/core/loader.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/core/metrics.hpp>
+#include <openclaw/core/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <csignal>
+#include <unistd.h>
+
+namespace openclaw {
+
+namespace {
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string chat_id(int chat) {
+    return "loadgen-" + std::to_string(chat);
+}
+
+void replace_all(std::string& text, const std::string& from, const std::string& to) {
+    for (size_t pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size())) {
+        text.replace(pos, from.size(), to);
+    }
+}
+
+double to_ms(double us) {
+    return us / 1000.0;
+}
+
+std::string mode_label(double rate) {
+    if (rate <= 0) return "closed loop";
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%g msg/s open loop", rate);
+    return buf;
+}
+
+} // anonymous namespace
+
+LoadGenChannel::LoadGenChannel()
+    : chats_(10)
+    , chat_type_("group")
+    , users_per_chat_(1)
+    , rate_(0)
+    , think_us_(0)
+    , duration_us_(30 * 1000000)
+    , warmup_us_(0)
+    , timeout_us_(60 * 1000000)
+    , total_weight_(0)
+    , exit_when_done_(true)
+    , status_(ChannelStatus::STOPPED)
+    , stopping_(false)
+    , reported_(false)
+    , started_us_(0)
+    , measure_from_us_(0)
+    , last_reply_us_(0)
+    , seq_(0)
+    , sent_(0)
+    , replied_(0)
+    , timed_out_(0)
+    , unmatched_(0)
+    , rng_(std::random_device()()) {}
+
+const char* LoadGenChannel::name() const { return "loadgen"; }
+const char* LoadGenChannel::version() const { return "1.0.0"; }
+const char* LoadGenChannel::description() const { return "Synthetic load generator channel"; }
+const char* LoadGenChannel::channel_id() const { return "loadgen"; }
+
+ChannelCapabilities LoadGenChannel::capabilities() const {
+    return ChannelCapabilities();
+}
+
+bool LoadGenChannel::init(const Config& cfg) {
+    const Json& section = cfg.get_section("loadgen");
+
+    chats_ = static_cast<int>(std::max<int64_t>(cfg.get_int("loadgen.chats", 10), 1));
+    chat_type_ = cfg.get_string("loadgen.chat_type", "group");
+    users_per_chat_ = static_cast<int>(std::max<int64_t>(cfg.get_int("loadgen.users_per_chat", 1), 1));
+    rate_ = section.is_object() ? std::max(section.value("rate", 0.0), 0.0) : 0.0;
+    think_us_ = cfg.get_int("loadgen.think_ms", 0) * 1000;
+    duration_us_ = cfg.get_int("loadgen.duration_seconds", 30) * 1000000;
+    warmup_us_ = std::min<int64_t>(cfg.get_int("loadgen.warmup_seconds", 0) * 1000000, duration_us_);
+    timeout_us_ = std::max<int64_t>(cfg.get_int("loadgen.timeout_seconds", 60), 1) * 1000000;
+    report_file_ = cfg.get_string("loadgen.report_file", "");
+    exit_when_done_ = cfg.get_bool("loadgen.exit_when_done", true);
+
+    mix_.clear();
+    total_weight_ = 0;
+    if (section.is_object() && section.contains("mix") && section["mix"].is_array()) {
+        for (const auto& entry : section["mix"]) {
+            if (!entry.is_object()) continue;
+            MixEntry mix;
+            mix.text = entry.value("text", std::string(""));
+            mix.weight = entry.value("weight", 1);
+            if (mix.text.empty() || mix.weight <= 0) continue;
+            mix_.push_back(mix);
+            total_weight_ += mix.weight;
+        }
+    }
+    if (mix_.empty()) {
+        MixEntry chat;
+        chat.text = "Hello from chat {chat}, message {n}. Anything new?";
+        chat.weight = 9;
+        MixEntry command;
+        command.text = "/status";
+        command.weight = 1;
+        mix_.push_back(chat);
+        mix_.push_back(command);
+        total_weight_ = chat.weight + command.weight;
+    }
+
+    // Turns record their stage times from now on
+    StageLatency::instance().enable();
+
+    LOG_INFO("[LoadGen] %d chats, %s, %llds (%llds warm-up), %zu message kinds",
+             chats_,
+             mode_label(rate_).c_str(),
+             static_cast<long long>(duration_us_ / 1000000),
+             static_cast<long long>(warmup_us_ / 1000000), mix_.size());
+    initialized_ = true;
+    return true;
+}
+
+void LoadGenChannel::shutdown() {
+    stop();
+    StageLatency::instance().disable();
+    initialized_ = false;
+}
+
+bool LoadGenChannel::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (status_ == ChannelStatus::RUNNING) return true;
+
+    stopping_ = false;
+    reported_ = false;
+    started_us_ = now_us();
+    measure_from_us_ = started_us_ + warmup_us_;
+    last_reply_us_ = 0;
+    seq_ = 0;
+    sent_ = replied_ = timed_out_ = unmatched_ = 0;
+    pending_.clear();
+    next_send_us_.assign(chats_, started_us_);
+    StageLatency::instance().reset();
+
+    status_ = ChannelStatus::RUNNING;
+    thread_ = std::thread(&LoadGenChannel::run, this);
+    return true;
+}
+
+bool LoadGenChannel::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (status_ != ChannelStatus::RUNNING) return true;
+        status_ = ChannelStatus::STOPPING;
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) {
+        thread_.join();
+    }
+    // Interrupted runs still report what they measured
+    report();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = ChannelStatus::STOPPED;
+    return true;
+}
+
+ChannelStatus LoadGenChannel::status() const {
+    return status_;
+}
+
+SendResult LoadGenChannel::send_message(const std::string& to, const std::string& text) {
+    return send_message(to, text, std::string());
+}
+
+SendResult LoadGenChannel::send_message(const std::string& to, const std::string& text,
+                                        const std::string& reply_to) {
+    (void)to;
+    (void)text;
+    int64_t now = now_us();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Only the first chunk of a reply carries reply_to; the rest are
+    // not separate answers
+    std::map<std::string, Pending>::iterator it = pending_.find(reply_to);
+    if (it == pending_.end()) {
+        if (!reply_to.empty()) unmatched_++;
+        return SendResult::ok("loadgen-reply");
+    }
+
+    if (it->second.sent_us >= measure_from_us_) {
+        replied_++;
+        last_reply_us_ = now;
+        StageLatency::instance().record("e2e", now - it->second.sent_us);
+    }
+    if (rate_ <= 0) {
+        next_send_us_[it->second.chat] = now + think_us_;
+        cv_.notify_all();
+    }
+    pending_.erase(it);
+    return SendResult::ok("loadgen-reply");
+}
+
+void LoadGenChannel::poll() {}
+
+std::string LoadGenChannel::pick_text_locked(int chat) {
+    std::uniform_int_distribution<int> pick(0, total_weight_ - 1);
+    int roll = pick(rng_);
+    size_t index = 0;
+    while (index + 1 < mix_.size() && roll >= mix_[index].weight) {
+        roll -= mix_[index].weight;
+        ++index;
+    }
+    std::string text = mix_[index].text;
+    replace_all(text, "{chat}", std::to_string(chat));
+    replace_all(text, "{n}", std::to_string(seq_));
+    return text;
+}
+
+void LoadGenChannel::send_one(int chat, int64_t now, std::unique_lock<std::mutex>& lock) {
+    ++seq_;
+    Message msg;
+    msg.id = "lg-" + std::to_string(chat) + "-" + std::to_string(seq_);
+    msg.channel = "loadgen";
+    std::string user = std::to_string(chat) + "-" + std::to_string(seq_ % users_per_chat_);
+    msg.from = "loadgen-user-" + user;
+    msg.from_name = "Load " + user;
+    msg.to = chat_id(chat);
+    msg.text = pick_text_locked(chat);
+    msg.chat_type = chat_type_;
+    msg.timestamp = std::time(nullptr);
+
+    Pending pending;
+    pending.chat = chat;
+    pending.sent_us = now;
+    pending_[msg.id] = pending;
+    if (now >= measure_from_us_) sent_++;
+
+    // The handler only queues the turn, but it may answer inline (a
+    // dropped or busy message); the reply path takes the lock
+    lock.unlock();
+    emit_message(msg);
+    lock.lock();
+}
+
+void LoadGenChannel::expire_locked(int64_t now) {
+    for (std::map<std::string, Pending>::iterator it = pending_.begin(); it != pending_.end();) {
+        if (now - it->second.sent_us < timeout_us_) {
+            ++it;
+            continue;
+        }
+        if (it->second.sent_us >= measure_from_us_) timed_out_++;
+        // A stuck closed-loop chat moves on
+        if (rate_ <= 0) next_send_us_[it->second.chat] = now;
+        pending_.erase(it++);
+    }
+}
+
+void LoadGenChannel::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    int64_t end_us = started_us_ + duration_us_;
+    int64_t next_arrival_us = started_us_;
+    int64_t next_expiry_check_us = started_us_;
+    bool warm = warmup_us_ == 0;
+    std::exponential_distribution<double> gap(rate_ > 0 ? rate_ : 1.0);
+    std::uniform_int_distribution<int> any_chat(0, chats_ - 1);
+
+    while (!stopping_) {
+        int64_t now = now_us();
+
+        if (!warm && now >= measure_from_us_) {
+            warm = true;
+            StageLatency::instance().reset();
+            LOG_INFO("[LoadGen] Warm-up done, measuring");
+        }
+        if (now >= next_expiry_check_us) {
+            expire_locked(now);
+            next_expiry_check_us = now + 100000;
+        }
+
+        // Past the sending window, wait for the replies still due
+        if (now >= end_us) {
+            if (pending_.empty() || now >= end_us + timeout_us_) break;
+            cv_.wait_for(lock, std::chrono::milliseconds(100));
+            continue;
+        }
+
+        int64_t wake_us = std::min(end_us, next_expiry_check_us);
+        if (rate_ > 0) {
+            while (next_arrival_us <= now && !stopping_) {
+                send_one(any_chat(rng_), now, lock);
+                next_arrival_us += static_cast<int64_t>(gap(rng_) * 1e6);
+            }
+            wake_us = std::min(wake_us, next_arrival_us);
+        } else {
+            for (int chat = 0; chat < chats_ && !stopping_; ++chat) {
+                if (next_send_us_[chat] < 0) continue;
+                if (next_send_us_[chat] <= now) {
+                    next_send_us_[chat] = -1;
+                    send_one(chat, now, lock);
+                } else {
+                    wake_us = std::min(wake_us, next_send_us_[chat]);
+                }
+            }
+        }
+
+        int64_t wait_us = wake_us - now_us();
+        if (wait_us > 0) cv_.wait_for(lock, std::chrono::microseconds(wait_us));
+    }
+
+    bool interrupted = stopping_;
+    lock.unlock();
+    if (interrupted) return;
+
+    report();
+    if (exit_when_done_) {
+        LOG_INFO("[LoadGen] Run complete, shutting down");
+        kill(getpid(), SIGTERM);
+    }
+}
+
+void LoadGenChannel::report() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (reported_ || started_us_ == 0) return;
+    reported_ = true;
+
+    int64_t end_us = std::max(std::min(now_us(), started_us_ + duration_us_), last_reply_us_);
+    double seconds = std::max(end_us - measure_from_us_, static_cast<int64_t>(1)) / 1e6;
+    uint64_t sent = sent_;
+    uint64_t replied = replied_;
+    uint64_t timed_out = timed_out_;
+    uint64_t unmatched = unmatched_;
+    uint64_t outstanding = 0;
+    for (std::map<std::string, Pending>::const_iterator it = pending_.begin(); it != pending_.end(); ++it) {
+        if (it->second.sent_us >= measure_from_us_) outstanding++;
+    }
+    lock.unlock();
+
+    std::vector<StageLatency::Summary> stages = StageLatency::instance().summarize();
+    double throughput = replied / seconds;
+
+    std::fprintf(stderr, "\nLoad run: %d chats, %s, %.1fs measured\n", chats_,
+                 mode_label(rate_).c_str(), seconds);
+    std::fprintf(stderr, "  sent %llu, replied %llu, timed out %llu, outstanding %llu, %.2f replies/s\n",
+                 static_cast<unsigned long long>(sent), static_cast<unsigned long long>(replied),
+                 static_cast<unsigned long long>(timed_out), static_cast<unsigned long long>(outstanding),
+                 throughput);
+    if (unmatched > 0) {
+        std::fprintf(stderr, "  %llu replies answered no pending message (late or repeated)\n",
+                     static_cast<unsigned long long>(unmatched));
+    }
+    std::fprintf(stderr, "  %-8s %9s %10s %10s %10s %10s %10s\n",
+                 "stage", "count", "mean ms", "p50 ms", "p99 ms", "p999 ms", "max ms");
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const StageLatency::Summary& s = stages[i];
+        std::fprintf(stderr, "  %-8s %9llu %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                     s.stage.c_str(), static_cast<unsigned long long>(s.count), to_ms(s.mean_us),
+                     to_ms(static_cast<double>(s.p50_us)), to_ms(static_cast<double>(s.p99_us)),
+                     to_ms(static_cast<double>(s.p999_us)), to_ms(static_cast<double>(s.max_us)));
+    }
+    std::fprintf(stderr, "\n");
+
+    if (report_file_.empty()) return;
+
+    Json out = Json::object();
+    out["chats"] = chats_;
+    out["mode"] = rate_ > 0 ? "open" : "closed";
+    out["rate"] = rate_;
+    out["measured_seconds"] = seconds;
+    out["sent"] = sent;
+    out["replied"] = replied;
+    out["timed_out"] = timed_out;
+    out["outstanding"] = outstanding;
+    out["unmatched"] = unmatched;
+    out["throughput_per_second"] = throughput;
+    Json list = Json::array();
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const StageLatency::Summary& s = stages[i];
+        Json stage = Json::object();
+        stage["stage"] = s.stage;
+        stage["count"] = s.count;
+        stage["mean_ms"] = to_ms(s.mean_us);
+        stage["p50_ms"] = to_ms(static_cast<double>(s.p50_us));
+        stage["p99_ms"] = to_ms(static_cast<double>(s.p99_us));
+        stage["p999_ms"] = to_ms(static_cast<double>(s.p999_us));
+        stage["max_ms"] = to_ms(static_cast<double>(s.max_us));
+        list.push_back(stage);
+    }
+    out["stages"] = list;
+
+    std::ofstream file(report_file_.c_str(), std::ios::out | std::ios::trunc);
+    if (!file) {
+        LOG_WARN("[LoadGen] Cannot write report to %s", report_file_.c_str());
+        return;
+    }
+    file << out.dump(2) << "\n";
+    LOG_INFO("[LoadGen] Report written to %s", report_file_.c_str());
+}
+
+} // namespace openclaw
+
+// Export plugin for dynamic loading
+OPENCLAW_DECLARE_PLUGIN(openclaw::LoadGenChannel, "loadgen", "1.0.0",
+                        "Synthetic load generator channel", "channel")
@@ -0,0 +1,294 @@
+/*
+ * OpenClaw C++11 - Mock AI Plugin Implementation
+ */
+#include <openclaw/plugins/mock/mock.hpp>
+#include <openclaw/core/loader.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/core/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+namespace openclaw {
+
+namespace {
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool is_tool_result(const ConversationMessage& msg) {
+    return msg.role == MessageRole::USER && msg.content.str().compare(0, 12, "<tool_result") == 0;
+}
+
+} // anonymous namespace
+
+MockAI::MockAI()
+    : distribution_(LOGNORMAL)
+    , mean_ms_(500)
+    , jitter_ms_(250)
+    , sigma_(0.5)
+    , error_rate_(0)
+    , tool_probability_(0)
+    , reply_chars_(0)
+    , stream_chunks_(4)
+    , rng_(std::random_device()())
+    , timer_seq_(0)
+    , stopping_(false) {}
+
+MockAI::~MockAI() {
+    stop_timer();
+}
+
+const char* MockAI::name() const { return "mock"; }
+const char* MockAI::version() const { return "1.0.0"; }
+const char* MockAI::description() const { return "Mock AI provider for load tests"; }
+
+bool MockAI::init(const Config& cfg) {
+    const Json& section = cfg.get_section("mock");
+    const Json& latency = cfg.get_section("mock.latency");
+
+    std::string distribution = cfg.get_string("mock.latency.distribution", "lognormal");
+    if (distribution == "fixed") distribution_ = FIXED;
+    else if (distribution == "uniform") distribution_ = UNIFORM;
+    else if (distribution == "exponential") distribution_ = EXPONENTIAL;
+    else distribution_ = LOGNORMAL;
+
+    if (latency.is_object()) {
+        mean_ms_ = std::max(latency.value("mean_ms", mean_ms_), 0.0);
+        jitter_ms_ = std::max(latency.value("jitter_ms", mean_ms_ / 2), 0.0);
+        sigma_ = std::max(latency.value("sigma", sigma_), 0.0);
+    } else {
+        jitter_ms_ = mean_ms_ / 2;
+    }
+
+    script_.clear();
+    if (section.is_object()) {
+        error_rate_ = section.value("error_rate", 0.0);
+        if (section.contains("tool_script") && section["tool_script"].is_array()) {
+            for (const auto& entry : section["tool_script"]) {
+                if (!entry.is_object() || !entry.contains("name")) continue;
+                ScriptedCall call;
+                call.name = entry.value("name", std::string(""));
+                call.params = entry.contains("params") ? entry["params"].dump() : "{}";
+                if (!call.name.empty()) script_.push_back(call);
+            }
+        }
+        tool_probability_ = section.value("tool_probability", script_.empty() ? 0.0 : 1.0);
+    }
+    reply_chars_ = static_cast<size_t>(std::max<int64_t>(cfg.get_int("mock.reply_chars", 0), 0));
+    stream_chunks_ = static_cast<int>(std::max<int64_t>(cfg.get_int("mock.stream_chunks", 4), 1));
+
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        stopping_ = false;
+    }
+    if (!timer_thread_.joinable()) {
+        timer_thread_ = std::thread(&MockAI::timer_loop, this);
+    }
+
+    LOG_INFO("[Mock] %s latency, mean %.0fms; %zu scripted tool calls (p=%.2f), error rate %.2f",
+             distribution.c_str(), mean_ms_, script_.size(), tool_probability_, error_rate_);
+    initialized_ = true;
+    return true;
+}
+
+void MockAI::shutdown() {
+    stop_timer();
+    initialized_ = false;
+}
+
+std::string MockAI::provider_id() const { return "mock"; }
+
+std::vector<std::string> MockAI::available_models() const {
+    return std::vector<std::string>(1, "mock");
+}
+
+std::string MockAI::default_model() const { return "mock"; }
+
+bool MockAI::is_configured() const { return initialized_; }
+
+int MockAI::context_window(const std::string& model) const {
+    (void)model;
+    return 200000;
+}
+
+int64_t MockAI::draw_latency_us() {
+    std::lock_guard<std::mutex> lock(rng_mutex_);
+    double ms = mean_ms_;
+    switch (distribution_) {
+        case FIXED:
+            break;
+        case UNIFORM: {
+            std::uniform_real_distribution<double> d(std::max(mean_ms_ - jitter_ms_, 0.0),
+                                                     mean_ms_ + jitter_ms_);
+            ms = d(rng_);
+            break;
+        }
+        case EXPONENTIAL: {
+            if (mean_ms_ <= 0) break;
+            std::exponential_distribution<double> d(1.0 / mean_ms_);
+            ms = d(rng_);
+            break;
+        }
+        case LOGNORMAL: {
+            if (mean_ms_ <= 0) break;
+            // mu chosen so the distribution's mean is mean_ms_
+            std::lognormal_distribution<double> d(std::log(mean_ms_) - sigma_ * sigma_ / 2, sigma_);
+            ms = d(rng_);
+            break;
+        }
+    }
+    return static_cast<int64_t>(ms * 1000);
+}
+
+bool MockAI::roll(double probability) {
+    if (probability <= 0) return false;
+    if (probability >= 1) return true;
+    std::lock_guard<std::mutex> lock(rng_mutex_);
+    std::uniform_real_distribution<double> d(0.0, 1.0);
+    return d(rng_) < probability;
+}
+
+CompletionResult MockAI::respond(const std::vector<ConversationMessage>& messages) {
+    if (roll(error_rate_)) {
+        CompletionResult failed = CompletionResult::fail("Mock provider error");
+        failed.http_status = 500;
+        return failed;
+    }
+
+    // Scripted calls answered so far: the tool result messages at the end
+    // of the conversation, each after the assistant message that asked
+    size_t step = 0;
+    size_t i = messages.size();
+    while (i >= 2 && is_tool_result(messages[i - 1]) &&
+           messages[i - 2].role == MessageRole::ASSISTANT) {
+        ++step;
+        i -= 2;
+    }
+    const ConversationMessage* prompt = i > 0 ? &messages[i - 1] : nullptr;
+
+    CompletionResult result;
+    if (step < script_.size() && (step > 0 || roll(tool_probability_))) {
+        const ScriptedCall& call = script_[step];
+        result = CompletionResult::ok("<tool_call name=\"" + call.name + "\">\n" + call.params +
+                                      "\n</tool_call>");
+    } else {
+        std::string text = "Mock reply to a " +
+            std::to_string(prompt ? prompt->content.size() : 0) + "-character message.";
+        static const std::string filler = " Lorem ipsum dolor sit amet.";
+        while (text.size() < reply_chars_) {
+            text += filler;
+        }
+        if (reply_chars_ > 0 && text.size() > reply_chars_) text.resize(reply_chars_);
+        result = CompletionResult::ok(text);
+        result.stop_reason = "end_turn";
+    }
+
+    result.model = "mock";
+    int input = 0;
+    for (size_t m = 0; m < messages.size(); ++m) {
+        input += TokenEstimator::count_text(messages[m].content.str());
+    }
+    result.usage.input_tokens = input;
+    result.usage.output_tokens = TokenEstimator::count_text(result.content);
+    result.usage.total_tokens = result.usage.input_tokens + result.usage.output_tokens;
+    result.http_status = 200;
+    return result;
+}
+
+CompletionResult MockAI::complete(const std::string& prompt, const CompletionOptions& opts) {
+    std::vector<ConversationMessage> messages;
+    messages.push_back(ConversationMessage::user(prompt));
+    return chat(messages, opts);
+}
+
+CompletionResult MockAI::chat(const std::vector<ConversationMessage>& messages,
+                              const CompletionOptions& opts) {
+    int64_t latency_us = draw_latency_us();
+    CompletionResult result = respond(messages);
+
+    bool streamed = opts.stream && opts.on_chunk && result.success;
+    int chunks = streamed ? stream_chunks_ : 1;
+    size_t step = (result.content.size() + chunks - 1) / chunks;
+    for (int c = 0; c < chunks; ++c) {
+        std::this_thread::sleep_for(std::chrono::microseconds(latency_us / chunks));
+        if (streamed && static_cast<size_t>(c) * step < result.content.size()) {
+            opts.on_chunk(result.content.substr(c * step, step));
+        }
+    }
+    return result;
+}
+
+void MockAI::chat_async(const std::vector<ConversationMessage>& messages,
+                        const CompletionOptions& opts, CompletionCallback on_done) {
+    int64_t start_us = now_us();
+    int64_t latency_us = draw_latency_us();
+    std::shared_ptr<CompletionResult> result = std::make_shared<CompletionResult>(respond(messages));
+
+    // Deltas spread evenly over the latency, the result with the last one
+    int chunks = opts.stream && opts.on_chunk && result->success ? stream_chunks_ : 0;
+    if (chunks > 0) {
+        size_t step = (result->content.size() + chunks - 1) / chunks;
+        StreamCallback on_chunk = opts.on_chunk;
+        for (int c = 0; c < chunks; ++c) {
+            if (static_cast<size_t>(c) * step >= result->content.size()) break;
+            std::string delta = result->content.substr(c * step, step);
+            schedule(start_us + latency_us * (c + 1) / chunks, [on_chunk, delta] { on_chunk(delta); });
+        }
+    }
+    schedule(start_us + latency_us, [result, on_done] {
+        if (on_done) on_done(*result);
+    });
+}
+
+void MockAI::schedule(int64_t due_us, std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        Timer timer;
+        timer.due_us = due_us;
+        timer.seq = timer_seq_++;
+        timer.fn = fn;
+        timers_.push(timer);
+    }
+    timer_cv_.notify_one();
+}
+
+void MockAI::timer_loop() {
+    std::unique_lock<std::mutex> lock(timer_mutex_);
+    while (true) {
+        if (timers_.empty()) {
+            if (stopping_) break;
+            timer_cv_.wait(lock);
+            continue;
+        }
+        // Pending completions still run at shutdown, just without the wait
+        int64_t wait_us = timers_.top().due_us - now_us();
+        if (wait_us > 0 && !stopping_) {
+            timer_cv_.wait_for(lock, std::chrono::microseconds(wait_us));
+            continue;
+        }
+        std::function<void()> fn = timers_.top().fn;
+        timers_.pop();
+        lock.unlock();
+        fn();
+        lock.lock();
+    }
+}
+
+void MockAI::stop_timer() {
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        stopping_ = true;
+    }
+    timer_cv_.notify_all();
+    if (timer_thread_.joinable()) timer_thread_.join();
+}
+
+} // namespace openclaw
+
+// Export plugin for dynamic loading
+OPENCLAW_DECLARE_PLUGIN(openclaw::MockAI, "mock", "1.0.0",
+                        "Mock AI provider for load tests", "ai")
@@ -1,10 +1,17 @@
 #include <openclaw/plugins/polls/polls.hpp>
 #include <openclaw/core/loader.hpp>
 #include <openclaw/core/utils.hpp>
+#include <openclaw/core/logger.hpp>
+#include <openclaw/core/json.hpp>
 #include <algorithm>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 #include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace openclaw {
 
@@ -150,164 +157,375 @@ std::string validate_vote(const Poll& poll, const std::vector<int>& selected_opt
 
 // ============ PollManager ============
 
+namespace {
+
+Json poll_record(const Poll& poll) {
+    Json j;
+    j["op"] = "create";
+    j["id"] = poll.id;
+    j["question"] = poll.question;
+    j["options"] = poll.options;
+    j["max"] = poll.max_selections;
+    j["hours"] = poll.duration_hours;
+    j["created"] = poll.created_at;
+    j["expires"] = poll.expires_at;
+    return j;
+}
+
+Json vote_record(const std::string& poll_id, const std::string& voter_id,
+                 const std::vector<int>& selection, int64_t at) {
+    Json j;
+    j["op"] = "vote";
+    j["id"] = poll_id;
+    j["voter"] = voter_id;
+    j["sel"] = selection;
+    if (at) j["at"] = at;
+    return j;
+}
+
+Json id_record(const char* op, const std::string& poll_id) {
+    Json j;
+    j["op"] = op;
+    j["id"] = poll_id;
+    return j;
+}
+
+std::string to_line(const Json& j) {
+    return j.dump(-1, ' ', false, Json::error_handler_t::replace) + "\n";
+}
+
+bool write_all(int fd, const std::string& data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = ::write(fd, data.data() + off, data.size() - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
 PollManager& PollManager::instance() {
     static PollManager manager;
     return manager;
 }
 
-Poll& PollManager::create_poll(const PollInput& input, const PollNormalizeOptions& options) {
-    Poll poll = normalize_poll(input, options);
-    polls_[poll.id] = poll;
-    votes_[poll.id] = std::vector<PollVote>();
-    return polls_[poll.id];
+PollManager::PollManager()
+    : poll_count_(0)
+    , log_fd_(-1)
+    , log_fsync_(false) {}
+
+PollManager::~PollManager() {
+    close_log();
 }
 
-Poll* PollManager::get_poll(const std::string& poll_id) {
-    std::map<std::string, Poll>::iterator it = polls_.find(poll_id);
-    return it != polls_.end() ? &it->second : NULL;
+PollManager::Shard& PollManager::shard_for(const std::string& poll_id) const {
+    return shards_[std::hash<std::string>()(poll_id) % SHARD_COUNT];
 }
 
-const Poll* PollManager::get_poll(const std::string& poll_id) const {
-    std::map<std::string, Poll>::const_iterator it = polls_.find(poll_id);
-    return it != polls_.end() ? &it->second : NULL;
+bool PollManager::open_log(const std::string& path, bool fsync) {
+    close_log();
+    
+    size_t slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        mkdir_p(path.substr(0, slash));
+    }
+    
+    // Replay what an earlier run recorded
+    size_t records = 0;
+    std::ifstream in(path.c_str());
+    if (in) {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            replay(line);
+            records++;
+        }
+    }
+    
+    // Each live poll is at most one record plus one per vote and a close
+    size_t live = 0;
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        std::lock_guard<std::mutex> shard_lock(shards_[i].mutex);
+        for (const auto& entry : shards_[i].polls) {
+            live += 2 + entry.second.voters.size();
+        }
+    }
+    if (records > 1024 && records > 2 * live) {
+        size_t kept = 0;
+        if (rewrite_log(path, kept)) {
+            LOG_INFO("[Polls] Compacted %s from %zu to %zu records", path.c_str(), records, kept);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    log_fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (log_fd_ < 0) {
+        LOG_ERROR("[Polls] Cannot open %s: %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    log_path_ = path;
+    log_fsync_ = fsync;
+    
+    LOG_INFO("[Polls] %zu polls restored from %s", poll_count(), path.c_str());
+    return true;
+}
+
+void PollManager::close_log() {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    if (log_fd_ >= 0) {
+        ::close(log_fd_);
+        log_fd_ = -1;
+    }
+}
+
+void PollManager::replay(const std::string& line) {
+    Json j = Json::parse(line, nullptr, false);
+    if (!j.is_object()) {
+        LOG_WARN("[Polls] Skipping unreadable log record");
+        return;
+    }
+    std::string op = j.value("op", "");
+    std::string id = j.value("id", "");
+    if (id.empty()) return;
+    
+    Shard& shard = shard_for(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.polls.find(id);
+    
+    if (op == "create") {
+        if (it != shard.polls.end()) return;
+        PollState& state = shard.polls[id];
+        state.poll.id = id;
+        state.poll.question = j.value("question", "");
+        state.poll.options = j.value("options", std::vector<std::string>());
+        state.poll.max_selections = j.value("max", 1);
+        state.poll.duration_hours = j.value("hours", 0);
+        state.poll.created_at = j.value("created", static_cast<int64_t>(0));
+        state.poll.expires_at = j.value("expires", static_cast<int64_t>(0));
+        state.counts.assign(state.poll.options.size(), 0);
+        poll_count_++;
+        return;
+    }
+    if (it == shard.polls.end()) return;
+    PollState& state = it->second;
+    
+    if (op == "vote") {
+        std::string voter = j.value("voter", "");
+        if (state.voters.count(voter)) return;
+        std::vector<int> selection = j.value("sel", std::vector<int>());
+        for (size_t k = 0; k < selection.size(); ++k) {
+            int opt = selection[k];
+            if (opt >= 0 && opt < static_cast<int>(state.counts.size())) state.counts[opt]++;
+        }
+        state.voters[voter] = selection;
+    } else if (op == "close") {
+        state.poll.is_closed = true;
+    } else if (op == "delete") {
+        shard.polls.erase(it);
+        poll_count_--;
+    }
+}
+
+void PollManager::append(const std::string& record) {
+    std::lock_guard<std::mutex> lock(log_mutex_);
+    if (log_fd_ < 0) return;
+    if (!write_all(log_fd_, record)) {
+        LOG_ERROR("[Polls] Write to %s failed: %s", log_path_.c_str(), strerror(errno));
+        return;
+    }
+    if (log_fsync_) fdatasync(log_fd_);
+}
+
+bool PollManager::rewrite_log(const std::string& path, size_t& records) {
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    
+    records = 0;
+    bool ok = true;
+    for (size_t i = 0; i < SHARD_COUNT && ok; ++i) {
+        std::lock_guard<std::mutex> shard_lock(shards_[i].mutex);
+        for (const auto& entry : shards_[i].polls) {
+            const PollState& state = entry.second;
+            std::string out = to_line(poll_record(state.poll));
+            for (const auto& voter : state.voters) {
+                out += to_line(vote_record(state.poll.id, voter.first, voter.second, 0));
+            }
+            if (state.poll.is_closed) out += to_line(id_record("close", state.poll.id));
+            records += 1 + state.voters.size() + (state.poll.is_closed ? 1 : 0);
+            if (!write_all(fd, out)) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    if (ok && fdatasync(fd) != 0) ok = false;
+    ::close(fd);
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+Poll PollManager::create_poll(const PollInput& input, const PollNormalizeOptions& options) {
+    Poll poll = normalize_poll(input, options);
+    
+    Shard& shard = shard_for(poll.id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    PollState& state = shard.polls[poll.id];
+    state.poll = poll;
+    state.counts.assign(poll.options.size(), 0);
+    poll_count_++;
+    append(to_line(poll_record(poll)));
+    return poll;
+}
+
+bool PollManager::get_poll(const std::string& poll_id, Poll& out) const {
+    Shard& shard = shard_for(poll_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.polls.find(poll_id);
+    if (it == shard.polls.end()) return false;
+    out = it->second.poll;
+    return true;
 }
 
 bool PollManager::has_poll(const std::string& poll_id) const {
-    return polls_.find(poll_id) != polls_.end();
+    Shard& shard = shard_for(poll_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.polls.find(poll_id) != shard.polls.end();
 }
 
 bool PollManager::close_poll(const std::string& poll_id) {
-    Poll* poll = get_poll(poll_id);
-    if (!poll) return false;
-    poll->is_closed = true;
+    Shard& shard = shard_for(poll_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.polls.find(poll_id);
+    if (it == shard.polls.end()) return false;
+    if (!it->second.poll.is_closed) {
+        it->second.poll.is_closed = true;
+        append(to_line(id_record("close", poll_id)));
+    }
     return true;
 }
 
 bool PollManager::delete_poll(const std::string& poll_id) {
-    if (!has_poll(poll_id)) return false;
-    polls_.erase(poll_id);
-    votes_.erase(poll_id);
+    Shard& shard = shard_for(poll_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.polls.find(poll_id);
+    if (it == shard.polls.end()) return false;
+    shard.polls.erase(it);
+    poll_count_--;
+    append(to_line(id_record("delete", poll_id)));
     return true;
 }
 
 std::string PollManager::vote(const std::string& poll_id,
                               const std::string& voter_id,
                               const std::vector<int>& selected_options) {
-    Poll* poll = get_poll(poll_id);
-    if (!poll) {
+    Shard& shard = shard_for(poll_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.polls.find(poll_id);
+    if (it == shard.polls.end()) {
         return "Poll not found";
     }
+    PollState& state = it->second;
     
     // Validate the vote
-    std::string error = validate_vote(*poll, selected_options);
+    std::string error = validate_vote(state.poll, selected_options);
     if (!error.empty()) {
         return error;
     }
     
     // Check if already voted
-    if (has_voted(poll_id, voter_id)) {
+    if (state.voters.count(voter_id)) {
         return "You have already voted in this poll";
     }
     
-    // Record the vote
-    PollVote vote_record;
-    vote_record.poll_id = poll_id;
-    vote_record.voter_id = voter_id;
-    vote_record.selected_options = selected_options;
-    vote_record.voted_at = current_timestamp();
-    
-    votes_[poll_id].push_back(vote_record);
+    // Record the vote and tally it
+    state.voters[voter_id] = selected_options;
+    for (size_t i = 0; i < selected_options.size(); ++i) {
+        state.counts[selected_options[i]]++;
+    }
+    append(to_line(vote_record(poll_id, voter_id, selected_options, current_timestamp())));
     
     return "";  // Success
 }
 
-PollResults PollManager::get_results(const std::string& poll_id) const {
+PollResults PollManager::get_results(const std::string& poll_id, bool include_voters) const {
     PollResults results;
     results.poll_id = poll_id;
     
-    const Poll* poll = get_poll(poll_id);
-    if (!poll) {
-        return results;
-    }
-    
-    // Initialize vote counts
-    results.vote_counts.resize(poll->options.size(), 0);
-    results.total_votes = 0;
-    
-    // Count votes
-    std::map<std::string, std::vector<PollVote> >::const_iterator votes_it = votes_.find(poll_id);
-    if (votes_it == votes_.end()) {
+    Shard& shard = shard_for(poll_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.polls.find(poll_id);
+    if (it == shard.polls.end()) {
         return results;
     }
     
-    const std::vector<PollVote>& poll_votes = votes_it->second;
-    for (size_t i = 0; i < poll_votes.size(); ++i) {
-        const PollVote& v = poll_votes[i];
-        results.votes_by_voter[v.voter_id] = v.selected_options;
-        results.total_votes++;
-        
-        for (size_t j = 0; j < v.selected_options.size(); ++j) {
-            int opt = v.selected_options[j];
-            if (opt >= 0 && opt < static_cast<int>(results.vote_counts.size())) {
-                results.vote_counts[opt]++;
-            }
-        }
+    const PollState& state = it->second;
+    results.vote_counts = state.counts;
+    results.total_votes = static_cast<int>(state.voters.size());
+    if (include_voters) {
+        results.votes_by_voter.insert(state.voters.begin(), state.voters.end());
     }
-    
     return results;
 }
 
 bool PollManager::has_voted(const std::string& poll_id, const std::string& voter_id) const {
-    std::map<std::string, std::vector<PollVote> >::const_iterator it = votes_.find(poll_id);
-    if (it == votes_.end()) return false;
-    
-    const std::vector<PollVote>& poll_votes = it->second;
-    for (size_t i = 0; i < poll_votes.size(); ++i) {
-        if (poll_votes[i].voter_id == voter_id) {
-            return true;
-        }
-    }
-    return false;
+    Shard& shard = shard_for(poll_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.polls.find(poll_id);
+    return it != shard.polls.end() && it->second.voters.count(voter_id) > 0;
 }
 
 std::vector<int> PollManager::get_voter_selection(const std::string& poll_id, const std::string& voter_id) const {
-    std::map<std::string, std::vector<PollVote> >::const_iterator it = votes_.find(poll_id);
-    if (it == votes_.end()) return std::vector<int>();
+    Shard& shard = shard_for(poll_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.polls.find(poll_id);
+    if (it == shard.polls.end()) return std::vector<int>();
     
-    const std::vector<PollVote>& poll_votes = it->second;
-    for (size_t i = 0; i < poll_votes.size(); ++i) {
-        if (poll_votes[i].voter_id == voter_id) {
-            return poll_votes[i].selected_options;
-        }
-    }
-    return std::vector<int>();
+    auto voter = it->second.voters.find(voter_id);
+    return voter != it->second.voters.end() ? voter->second : std::vector<int>();
 }
 
 size_t PollManager::cleanup_expired() {
     size_t removed = 0;
-    std::vector<std::string> to_remove;
     
-    for (std::map<std::string, Poll>::iterator it = polls_.begin(); it != polls_.end(); ++it) {
-        if (it->second.is_expired()) {
-            to_remove.push_back(it->first);
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.polls.begin(); it != shard.polls.end(); ) {
+            if (it->second.poll.is_expired()) {
+                append(to_line(id_record("delete", it->first)));
+                it = shard.polls.erase(it);
+                poll_count_--;
+                ++removed;
+            } else {
+                ++it;
+            }
         }
     }
     
-    for (size_t i = 0; i < to_remove.size(); ++i) {
-        delete_poll(to_remove[i]);
-        ++removed;
-    }
-    
     return removed;
 }
 
 std::vector<std::string> PollManager::active_poll_ids() const {
     std::vector<std::string> ids;
-    for (std::map<std::string, Poll>::const_iterator it = polls_.begin(); it != polls_.end(); ++it) {
-        if (it->second.is_active()) {
-            ids.push_back(it->first);
+    for (size_t i = 0; i < SHARD_COUNT; ++i) {
+        const Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& entry : shard.polls) {
+            if (entry.second.poll.is_active()) {
+                ids.push_back(entry.first);
+            }
         }
     }
+    std::sort(ids.begin(), ids.end());
     return ids;
 }
 
@@ -390,12 +608,21 @@ const char* PollsPlugin::name() const { return "polls"; }
 const char* PollsPlugin::version() const { return "1.0.0"; }
 const char* PollsPlugin::description() const { return "Poll management service"; }
 
-bool PollsPlugin::init(const Config& /*cfg*/) {
+bool PollsPlugin::init(const Config& cfg) {
+    // Polls and votes survive restarts in an append-only log
+    if (cfg.get_bool("polls.persist", true)) {
+        std::string path = cfg.get_string("polls.file", "");
+        if (path.empty()) {
+            path = cfg.get_string("workspace_dir", ".") + "/.openclaw/polls.jsonl";
+        }
+        PollManager::instance().open_log(path, cfg.get_bool("polls.fsync", false));
+    }
     initialized_ = true;
     return true;
 }
 
 void PollsPlugin::shutdown() {
+    PollManager::instance().close_log();
     initialized_ = false;
 }
 
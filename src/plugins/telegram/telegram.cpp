@@ -1,6 +1,9 @@
 #include <openclaw/plugins/telegram/telegram.hpp>
 #include <openclaw/core/loader.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/json_reader.hpp>
 #include <sstream>
+#include <algorithm>
 
 namespace openclaw {
 
@@ -18,13 +21,139 @@ std::string escape_html(const std::string& text) {
     }
     return escaped;
 }
+
+// Compare without exiting at the first mismatch
+bool secret_matches(const std::string& expected, const std::string& given) {
+    if (expected.size() != given.size()) return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        diff |= static_cast<unsigned char>(expected[i] ^ given[i]);
+    }
+    return diff == 0;
+}
+
+// Pause after a failed getUpdates before the next one
+const int64_t poll_retry_ms = 1000;
+
+// Webhook updates accepted but not yet dispatched; past this we answer
+// 503 and Telegram redelivers later
+const size_t max_pending_updates = 10000;
+
+// An update as it is read, message fields in whatever order they come
+struct UpdateFields {
+    int64_t update_id;
+    int64_t message_id;
+    int64_t chat_id;
+    std::string chat_type;
+    bool has_from;
+    int64_t from_id;
+    std::string first_name;
+    std::string last_name;
+    std::string username;
+    std::string text;
+    std::string caption;
+    bool has_reply;
+    int64_t reply_id;
+    int64_t date;
+    
+    UpdateFields() { reset(); }
+    
+    void reset() {
+        update_id = message_id = chat_id = from_id = reply_id = date = 0;
+        has_from = has_reply = false;
+        chat_type.clear();
+        first_name.clear();
+        last_name.clear();
+        username.clear();
+        text.clear();
+        caption.clear();
+    }
+    
+    Message to_message() const {
+        Message m;
+        m.channel = "telegram";
+        m.id = std::to_string(message_id);
+        m.to = std::to_string(chat_id);
+        
+        if (chat_type == "private") {
+            m.chat_type = "direct";
+        } else if (chat_type == "group" || chat_type == "supergroup") {
+            m.chat_type = "group";
+        } else if (chat_type == "channel") {
+            m.chat_type = "channel";
+        }
+        
+        if (has_from) {
+            m.from = std::to_string(from_id);
+            m.from_name = first_name;
+            if (!last_name.empty()) {
+                m.from_name += " " + last_name;
+            }
+            if (!username.empty()) {
+                m.from_name += " (@" + username + ")";
+            }
+        }
+        
+        m.text = text.empty() ? caption : text;
+        if (has_reply) {
+            m.reply_to_id = std::to_string(reply_id);
+        }
+        m.timestamp = date;
+        return m;
+    }
+};
+
+// Fields of the update at prefix ("" for a webhook body, "result.*."
+// in a getUpdates batch); an edited message reads like a new one
+void bind_update(JsonReader& reader, const std::string& prefix, UpdateFields& u) {
+    reader.bind(prefix + "update_id", u.update_id);
+    const char* kinds[] = { "message.", "edited_message." };
+    for (size_t i = 0; i < 2; ++i) {
+        std::string msg = prefix + kinds[i];
+        reader.bind(msg + "message_id", u.message_id);
+        reader.bind(msg + "chat.id", u.chat_id);
+        reader.bind(msg + "chat.type", u.chat_type);
+        reader.on_begin(msg + "from", [&u] { u.has_from = true; });
+        reader.bind(msg + "from.id", u.from_id);
+        reader.bind(msg + "from.first_name", u.first_name);
+        reader.bind(msg + "from.last_name", u.last_name);
+        reader.bind(msg + "from.username", u.username);
+        reader.bind(msg + "text", u.text);
+        reader.bind(msg + "caption", u.caption);
+        reader.on_begin(msg + "reply_to_message", [&u] { u.has_reply = true; });
+        reader.bind(msg + "reply_to_message.message_id", u.reply_id);
+        reader.bind(msg + "date", u.date);
+    }
+}
+
+// Telegram's published bot limits: about 30 messages per second overall,
+// one per second in a chat (short bursts tolerated) and 20 per minute in
+// a group. Group and channel chat IDs are negative.
+const int global_messages_per_second = 30;
+const int chat_burst = 3;
+const int group_burst = 3;
+const int64_t group_interval_us = 3 * 1000000LL;
+
+RateLimitPolicy chat_policy(const std::string& to) {
+    if (!to.empty() && to[0] == '-') {
+        return RateLimitPolicy::token_bucket_interval(group_burst, group_interval_us);
+    }
+    return RateLimitPolicy::token_bucket(chat_burst, 1);
+}
 } // namespace
 
 TelegramChannel::TelegramChannel() 
-    : status_(ChannelStatus::STOPPED)
+    : send_queue_("telegram", [this](const OutboundMessage& msg, SendQueue::SendDone done) {
+          send_queued(msg, done);
+      })
+    , status_(ChannelStatus::STOPPED)
     , last_update_id_(0)
     , poll_timeout_(30)
-    , should_stop_polling_(false) {}
+    , should_stop_polling_(false)
+    , polling_(false)
+    , poll_retry_timer_(0)
+    , use_webhook_(false)
+    , webhook_port_(8443) {}
 
 const char* TelegramChannel::name() const { return "telegram"; }
 const char* TelegramChannel::version() const { return "1.0.0"; }
@@ -55,7 +184,27 @@ bool TelegramChannel::init(const Config& cfg) {
     poll_timeout_ = static_cast<int>(cfg.get_channel_string("telegram", "poll_timeout", "30")[0] - '0') * 10;
     if (poll_timeout_ <= 0 || poll_timeout_ > 60) poll_timeout_ = 30;
     
-    LOG_INFO("Telegram: initialized with poll_timeout=%d", poll_timeout_);
+    use_webhook_ = cfg.get_channel_string("telegram", "mode", "polling") == "webhook";
+    if (use_webhook_) {
+        webhook_url_ = cfg.get_channel_string("telegram", "webhook_url");
+        if (webhook_url_.empty()) {
+            LOG_WARN("Telegram: mode=webhook needs webhook_url");
+            return false;
+        }
+        // Telegram echoes this back on every call; without one configured
+        // a fresh token per run keeps the endpoint from accepting forgeries
+        webhook_secret_ = cfg.get_channel_string("telegram", "webhook_secret");
+        if (webhook_secret_.empty()) webhook_secret_ = generate_uuid();
+        webhook_bind_ = cfg.get_channel_string("telegram", "webhook_bind", "0.0.0.0");
+        webhook_port_ = static_cast<int>(cfg.get_int("telegram.webhook_port", 8443));
+    }
+    
+    send_queue_.set_global_limit(RateLimitPolicy::token_bucket(global_messages_per_second,
+                                                               global_messages_per_second));
+    send_queue_.set_chat_limit(chat_policy);
+    
+    LOG_INFO("Telegram: initialized in %s mode with poll_timeout=%d",
+             use_webhook_ ? "webhook" : "polling", poll_timeout_);
     initialized_ = true;
     return true;
 }
@@ -95,27 +244,153 @@ bool TelegramChannel::start() {
     LOG_INFO("Telegram: connected as @%s (id=%lld)", 
              bot_username_.c_str(), (long long)bot_id_);
     
-    // Start polling thread
     should_stop_polling_ = false;
-    poll_thread_ = std::thread(&TelegramChannel::polling_loop, this);
-    
     status_ = ChannelStatus::RUNNING;
-    LOG_INFO("Telegram: polling thread started");
+    send_queue_.start();
+    
+    if (use_webhook_) {
+        if (!start_webhook()) {
+            status_ = ChannelStatus::ERROR;
+            return false;
+        }
+        return true;
+    }
+    
+    // getUpdates is refused while a webhook is set (e.g. by a previous run)
+    http_.post_json(api_base_ + "/deleteWebhook", Json::object());
+    
+    {
+        std::lock_guard<std::mutex> lock(poll_mutex_);
+        polling_ = true;
+    }
+    request_updates();
+    
+    LOG_INFO("Telegram: long polling started");
+    return true;
+}
+
+bool TelegramChannel::start_webhook() {
+    dispatch_thread_ = std::thread(&TelegramChannel::dispatch_loop, this);
+    
+    WebhookRouter::instance().add("telegram",
+        [this](const WebhookRequest& request) { return on_webhook(request); });
+    
+    if (WebhookRouter::instance().mounted()) {
+        LOG_INFO("Telegram: receiving updates through the gateway on %stelegram",
+                 WebhookRouter::path_prefix());
+    } else if (!webhook_server_.start(webhook_bind_, webhook_port_)) {
+        stop_webhook();
+        return false;
+    }
+    
+    Json params = Json::object();
+    params["url"] = webhook_url_;
+    params["secret_token"] = webhook_secret_;
+    params["allowed_updates"] = Json::array({"message", "edited_message"});
+    
+    HttpResponse resp = http_.post_json(api_base_ + "/setWebhook", params);
+    Json result = resp.json();
+    if (!resp.ok() || !result.value("ok", false)) {
+        LOG_ERROR("Telegram: setWebhook failed - %s",
+                  resp.error.empty() ? result.value("description", std::string("unknown")).c_str()
+                                     : resp.error.c_str());
+        stop_webhook();
+        return false;
+    }
+    
+    LOG_INFO("Telegram: webhook set to %s", webhook_url_.c_str());
     return true;
 }
 
+void TelegramChannel::stop_webhook() {
+    // The webhook stays registered with Telegram, which holds updates
+    // until we are back
+    WebhookRouter::instance().remove("telegram");
+    webhook_server_.stop();
+    
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        should_stop_polling_ = true;
+    }
+    pending_cv_.notify_all();
+    if (dispatch_thread_.joinable()) {
+        dispatch_thread_.join();
+    }
+}
+
+WebhookResponse TelegramChannel::on_webhook(const WebhookRequest& request) {
+    if (!secret_matches(webhook_secret_, request.header("x-telegram-bot-api-secret-token"))) {
+        LOG_WARN("Telegram: rejected webhook call with a bad secret token");
+        return WebhookResponse(401, "Unauthorized");
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (pending_updates_.size() >= max_pending_updates) {
+            return WebhookResponse(503, "Busy");
+        }
+        pending_updates_.push_back(request.body);
+    }
+    pending_cv_.notify_one();
+    return WebhookResponse(200);
+}
+
+void TelegramChannel::dispatch_loop() {
+    LOG_INFO("Telegram: webhook dispatch loop started");
+    
+    UpdateFields fields;
+    JsonReader reader;
+    bind_update(reader, "", fields);
+    
+    std::deque<std::string> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex_);
+            pending_cv_.wait(lock, [this] {
+                return should_stop_polling_ || !pending_updates_.empty();
+            });
+            if (pending_updates_.empty()) break;
+            batch.swap(pending_updates_);
+        }
+        
+        for (size_t i = 0; i < batch.size(); ++i) {
+            fields.reset();
+            std::string error;
+            if (!reader.parse(batch[i], &error)) {
+                LOG_WARN("Telegram: dropping malformed webhook update - %s", error.c_str());
+                continue;
+            }
+            process_update(fields.update_id, fields.to_message());
+        }
+        batch.clear();
+    }
+    
+    LOG_INFO("Telegram: webhook dispatch loop exited");
+}
+
 bool TelegramChannel::stop() {
     if (status_ == ChannelStatus::STOPPED) return true;
     
     status_ = ChannelStatus::STOPPING;
     
-    // Stop polling thread
+    if (use_webhook_) {
+        stop_webhook();
+    }
+    
+    // A long poll in flight finishes (at most poll_timeout later) and
+    // ends the chain; a pending retry is simply cancelled
     should_stop_polling_ = true;
-    if (poll_thread_.joinable()) {
-        poll_thread_.join();
-        LOG_INFO("Telegram: polling thread stopped");
+    {
+        std::unique_lock<std::mutex> lock(poll_mutex_);
+        if (poll_retry_timer_ && Reactor::instance().cancel_timer(poll_retry_timer_)) {
+            poll_retry_timer_ = 0;
+            polling_ = false;
+        }
+        poll_cv_.wait(lock, [this] { return !polling_; });
     }
     
+    send_queue_.stop();
+    
     status_ = ChannelStatus::STOPPED;
     LOG_INFO("Telegram: stopped");
     return true;
@@ -124,16 +399,22 @@ bool TelegramChannel::stop() {
 ChannelStatus TelegramChannel::status() const { return status_; }
 
 SendResult TelegramChannel::send_message(const std::string& to, const std::string& text) {
-    return send_message_impl(to, text, 0);
+    return send_queue_.send(to, text, "");
 }
 
 SendResult TelegramChannel::send_message(const std::string& to, const std::string& text,
                                          const std::string& reply_to) {
-    int64_t reply_id = 0;
-    if (!reply_to.empty()) {
-        reply_id = std::strtoll(reply_to.c_str(), NULL, 10);
-    }
-    return send_message_impl(to, text, reply_id);
+    return send_queue_.send(to, text, reply_to);
+}
+
+void TelegramChannel::send_message_async(const std::string& to, const std::string& text,
+                                         const std::string& reply_to, SendCallback on_done) {
+    send_queue_.enqueue(to, text, reply_to, on_done);
+}
+
+void TelegramChannel::edit_message_async(const std::string& to, const std::string& message_id,
+                                         const std::string& text, SendCallback on_done) {
+    send_queue_.enqueue_edit(to, message_id, text, on_done);
 }
 
 SendResult TelegramChannel::send_typing_action(const std::string& to) {
@@ -166,147 +447,164 @@ SendResult TelegramChannel::send_typing_action(const std::string& to) {
 }
 
 void TelegramChannel::poll() {
-    // No-op: polling now happens in dedicated thread
+    // No-op: updates arrive on the HTTP engine or webhook dispatch thread
     // This method kept for API compatibility
 }
 
-void TelegramChannel::polling_loop() {
-    LOG_INFO("Telegram: polling loop started");
+void TelegramChannel::request_updates() {
+    if (should_stop_polling_ || status_ != ChannelStatus::RUNNING) {
+        end_polling();
+        return;
+    }
     
-    while (!should_stop_polling_ && status_ == ChannelStatus::RUNNING) {
-        std::ostringstream url;
-        url << api_base_ << "/getUpdates?timeout=" << poll_timeout_;
-        if (last_update_id_ > 0) {
-            url << "&offset=" << (last_update_id_ + 1);
-        }
-        url << "&allowed_updates=" << "[\"message\",\"edited_message\"]";
-        
-        http_.set_timeout((poll_timeout_ + 5) * 1000);
-        
-        HttpResponse resp = http_.get(url.str());
-        
-        if (!resp.ok()) {
-            if (!should_stop_polling_) {
-                LOG_WARN("Telegram: poll failed - %s", resp.error.c_str());
-            }
-            continue;
-        }
-        
-        Json result = resp.json();
-        if (!result.value("ok", false)) {
-            LOG_WARN("Telegram: poll API error - %s", result.value("description", std::string("unknown")).c_str());
-            continue;
-        }
-        
-        if (result.contains("result") && result["result"].is_array()) {
-            for (const auto& update : result["result"]) {
-                process_update(update);
-            }
-        }
+    std::ostringstream url;
+    url << api_base_ << "/getUpdates?timeout=" << poll_timeout_;
+    if (last_update_id_ > 0) {
+        url << "&offset=" << (last_update_id_ + 1);
     }
+    url << "&allowed_updates=" << "[\"message\",\"edited_message\"]";
     
-    LOG_INFO("Telegram: polling loop exited");
+    HttpRequest req("GET", url.str());
+    req.timeout_ms = (poll_timeout_ + 5) * 1000L;
+    AsyncHttpEngine::instance().submit(req, [this](const HttpResponse& resp) {
+        on_updates(resp);
+    });
 }
 
-SendResult TelegramChannel::send_message_impl(const std::string& to, const std::string& text, int64_t reply_to) {
-    Json params = Json::object();
-    params["chat_id"] = to;
-    params["text"] = escape_html(text);
-    params["parse_mode"] = "HTML";
-    
-    if (reply_to > 0) {
-        params["reply_to_message_id"] = reply_to;
+void TelegramChannel::on_updates(const HttpResponse& resp) {
+    if (should_stop_polling_) {
+        end_polling();
+        return;
     }
     
-    // Use separate http_send_ instance with 10s timeout
-    http_send_.set_timeout(10000);
-    HttpResponse resp = http_send_.post_json(api_base_ + "/sendMessage", params);
-    
-    if (!resp.ok()) {
-        return SendResult::fail("HTTP error: " + resp.error);
+    std::vector<std::pair<int64_t, Message> > updates;
+
+    // Updates are decoded straight into messages; they are only handled
+    // once the batch as a whole turned out to be ok
+    bool ok = false;
+    if (resp.ok()) {
+        std::string description;
+        UpdateFields fields;
+        JsonReader reader;
+        reader.bind("ok", ok);
+        reader.bind("description", description);
+        reader.on_begin("result.*", [&fields] { fields.reset(); });
+        bind_update(reader, "result.*.", fields);
+        reader.on_end("result.*", [&fields, &updates] {
+            updates.push_back(std::make_pair(fields.update_id, fields.to_message()));
+        });
+        if (!reader.parse(resp.body)) {
+            ok = false;
+        }
+        if (!ok) {
+            LOG_WARN("Telegram: poll API error - %s", description.empty() ? "unknown" : description.c_str());
+        }
+    } else {
+        LOG_WARN("Telegram: poll failed - %s", resp.error.c_str());
     }
     
-    Json result = resp.json();
-    if (!result.value("ok", false)) {
-        return SendResult::fail("API error: " + result.value("description", std::string("unknown")));
+    if (!ok) {
+        bool scheduled;
+        {
+            std::lock_guard<std::mutex> lock(poll_mutex_);
+            poll_retry_timer_ = Reactor::instance().add_timer(poll_retry_ms, 0, [this] {
+                {
+                    std::lock_guard<std::mutex> lock(poll_mutex_);
+                    poll_retry_timer_ = 0;
+                }
+                request_updates();
+            });
+            scheduled = poll_retry_timer_ != 0;
+        }
+        if (!scheduled) end_polling();
+        return;
     }
     
-    std::ostringstream msg_id;
-    msg_id << result["result"].value("message_id", int64_t(0));
-    
-    LOG_DEBUG("Telegram: sent message to %s (id=%s)", to.c_str(), msg_id.str().c_str());
-    return SendResult::ok(msg_id.str());
+    // Updates only queue work, so handling them here keeps the engine free
+    for (size_t i = 0; i < updates.size(); ++i) {
+        process_update(updates[i].first, updates[i].second);
+    }
+    request_updates();
 }
 
-void TelegramChannel::process_update(const Json& update) {
-    int64_t update_id = update.value("update_id", int64_t(0));
-    if (update_id > last_update_id_) {
-        last_update_id_ = update_id;
+void TelegramChannel::end_polling() {
+    {
+        std::lock_guard<std::mutex> lock(poll_mutex_);
+        if (!polling_) return;
+        polling_ = false;
     }
+    poll_cv_.notify_all();
+    LOG_INFO("Telegram: long polling stopped");
+}
+
+void TelegramChannel::send_queued(const OutboundMessage& msg, SendQueue::SendDone done) {
+    Json params = Json::object();
+    params["chat_id"] = msg.to;
+    params["text"] = escape_html(msg.text);
+    params["parse_mode"] = "HTML";
     
-    const Json* msg_ptr = nullptr;
-    if (update.contains("message")) {
-        msg_ptr = &update["message"];
-    } else if (update.contains("edited_message")) {
-        msg_ptr = &update["edited_message"];
+    bool edit = !msg.edit_id.empty();
+    if (edit) {
+        params["message_id"] = std::strtoll(msg.edit_id.c_str(), NULL, 10);
+    } else {
+        int64_t reply_id = msg.reply_to.empty() ? 0 : std::strtoll(msg.reply_to.c_str(), NULL, 10);
+        if (reply_id > 0) {
+            params["reply_to_message_id"] = reply_id;
+        }
     }
     
-    if (!msg_ptr || msg_ptr->is_null()) return;
-    const Json& msg = *msg_ptr;
+    HttpRequest req("POST", api_base_ + (edit ? "/editMessageText" : "/sendMessage"), params.dump());
+    req.headers["Content-Type"] = "application/json";
+    req.timeout_ms = 10000;
     
-    Message m;
-    m.channel = "telegram";
-    
-    std::ostringstream id_ss;
-    id_ss << msg.value("message_id", int64_t(0));
-    m.id = id_ss.str();
-    
-    const Json& chat = msg["chat"];
-    std::ostringstream chat_id;
-    chat_id << chat.value("id", int64_t(0));
-    m.to = chat_id.str();
-    
-    std::string chat_type = chat.value("type", std::string(""));
-    if (chat_type == "private") {
-        m.chat_type = "direct";
-    } else if (chat_type == "group" || chat_type == "supergroup") {
-        m.chat_type = "group";
-    } else if (chat_type == "channel") {
-        m.chat_type = "channel";
-    }
-    
-    if (msg.contains("from") && !msg["from"].is_null()) {
-        const Json& from = msg["from"];
-        std::ostringstream from_id;
-        from_id << from.value("id", int64_t(0));
-        m.from = from_id.str();
+    std::string to = msg.to;
+    std::string edit_id = msg.edit_id;
+    AsyncHttpEngine::instance().submit(req, [to, edit_id, done](const HttpResponse& resp) {
+        // Telegram answers 429 with a JSON body naming the wait
+        Json result = resp.json();
+        if (resp.status_code == 429 || result.value("error_code", 0) == 429) {
+            int64_t retry_after = 1;
+            if (result.contains("parameters") && result["parameters"].is_object()) {
+                retry_after = result["parameters"].value("retry_after", int64_t(1));
+            }
+            done(SendResult::fail("API error: " + result.value("description", std::string("Too Many Requests"))),
+                 std::max<int64_t>(retry_after, 1) * 1000);
+            return;
+        }
         
-        std::string first = from.value("first_name", std::string(""));
-        std::string last = from.value("last_name", std::string(""));
-        m.from_name = first;
-        if (!last.empty()) {
-            m.from_name += " " + last;
+        // Editing to the text a message already has is refused with a 400
+        std::string description = result.value("description", std::string(""));
+        if (!edit_id.empty() && description.find("message is not modified") != std::string::npos) {
+            done(SendResult::ok(edit_id), 0);
+            return;
         }
-        std::string username = from.value("username", std::string(""));
-        if (!username.empty()) {
-            m.from_name += " (@" + username + ")";
+        
+        if (!resp.ok()) {
+            done(SendResult::fail("HTTP error: " + (resp.error.empty() ? std::to_string(resp.status_code) : resp.error)), 0);
+            return;
         }
+        if (!result.value("ok", false)) {
+            done(SendResult::fail("API error: " + result.value("description", std::string("unknown"))), 0);
+            return;
+        }
+        
+        if (!edit_id.empty()) {
+            done(SendResult::ok(edit_id), 0);
+            return;
+        }
+        
+        std::ostringstream msg_id;
+        msg_id << result["result"].value("message_id", int64_t(0));
+        
+        LOG_DEBUG("Telegram: sent message to %s (id=%s)", to.c_str(), msg_id.str().c_str());
+        done(SendResult::ok(msg_id.str()), 0);
+    });
+}
+
+void TelegramChannel::process_update(int64_t update_id, const Message& m) {
+    if (update_id > last_update_id_) {
+        last_update_id_ = update_id;
     }
-    
-    m.text = msg.value("text", std::string(""));
-    if (m.text.empty()) {
-        m.text = msg.value("caption", std::string(""));
-    }
-    
-    if (msg.contains("reply_to_message") && !msg["reply_to_message"].is_null()) {
-        const Json& reply = msg["reply_to_message"];
-        std::ostringstream reply_id;
-        reply_id << reply.value("message_id", int64_t(0));
-        m.reply_to_id = reply_id.str();
-    }
-    
-    m.timestamp = msg.value("date", int64_t(0));
-    
     if (!m.text.empty()) {
         emit_message(m);
     }
@@ -1,15 +1,58 @@
 #include <openclaw/plugins/whatsapp/whatsapp.hpp>
 #include <openclaw/core/loader.hpp>
+#include <openclaw/core/utils.hpp>
+#include <openclaw/core/json_reader.hpp>
 #include <sstream>
+#include <algorithm>
 #include <ctime>
 
 namespace openclaw {
 
+namespace {
+
+// A bridge message as it is read
+struct BridgeFields {
+    Message m;
+    bool is_group;
+    
+    BridgeFields() { reset(); }
+    
+    void reset() {
+        m = Message();
+        m.channel = "whatsapp";
+        is_group = false;
+    }
+    
+    Message to_message() const {
+        Message out = m;
+        if (out.from_name.empty()) out.from_name = out.from;
+        out.chat_type = is_group ? "group" : "direct";
+        return out;
+    }
+};
+
+void bind_bridge_message(JsonReader& reader, const std::string& prefix, BridgeFields& f) {
+    reader.bind(prefix + "id", f.m.id);
+    reader.bind(prefix + "from", f.m.from);
+    reader.bind(prefix + "from_name", f.m.from_name);
+    reader.bind(prefix + "to", f.m.to);
+    reader.bind(prefix + "text", f.m.text);
+    reader.bind(prefix + "timestamp", f.m.timestamp);
+    reader.bind(prefix + "is_group", f.is_group);
+    reader.bind(prefix + "reply_to", f.m.reply_to_id);
+}
+
+} // anonymous namespace
+
 WhatsAppChannel::WhatsAppChannel() 
     : status_(ChannelStatus::STOPPED)
     , mode_(MODE_NONE)
     , poll_interval_(5)
-    , last_poll_time_(0) {}
+    , poll_in_flight_(false)
+    , push_(false)
+    , webhook_port_(8444)
+    , poll_fallback_interval_(60)
+    , last_push_time_(0) {}
 
 const char* WhatsAppChannel::name() const { return "whatsapp"; }
 const char* WhatsAppChannel::version() const { return "1.0.0"; }
@@ -49,6 +92,15 @@ bool WhatsAppChannel::init(const Config& cfg) {
     
     poll_interval_ = static_cast<int>(cfg.get_int("whatsapp.poll_interval", 5));
     
+    push_ = mode_ == MODE_BRIDGE && cfg.get_channel_string("whatsapp", "push") == "webhook";
+    if (push_) {
+        webhook_url_ = cfg.get_channel_string("whatsapp", "webhook_url");
+        webhook_secret_ = cfg.get_channel_string("whatsapp", "webhook_secret");
+        webhook_bind_ = cfg.get_channel_string("whatsapp", "webhook_bind", "127.0.0.1");
+        webhook_port_ = static_cast<int>(cfg.get_int("whatsapp.webhook_port", 8444));
+        poll_fallback_interval_ = static_cast<int>(cfg.get_int("whatsapp.poll_fallback_interval", 60));
+    }
+    
     initialized_ = true;
     return true;
 }
@@ -77,6 +129,10 @@ bool WhatsAppChannel::start() {
             status_ = ChannelStatus::ERROR;
             return false;
         }
+        if (push_ && !start_push()) {
+            status_ = ChannelStatus::ERROR;
+            return false;
+        }
     }
     
     status_ = ChannelStatus::RUNNING;
@@ -89,6 +145,13 @@ bool WhatsAppChannel::stop() {
     if (status_ == ChannelStatus::STOPPED) return true;
     
     status_ = ChannelStatus::STOPPING;
+    if (push_) {
+        stop_push();
+    }
+    {
+        std::unique_lock<std::mutex> lock(poll_mutex_);
+        poll_cv_.wait(lock, [this] { return !poll_in_flight_; });
+    }
     status_ = ChannelStatus::STOPPED;
     
     LOG_INFO("WhatsApp: stopped");
@@ -150,6 +213,11 @@ void WhatsAppChannel::poll() {
     }
 }
 
+int WhatsAppChannel::poll_interval_ms() const {
+    if (mode_ != MODE_BRIDGE) return 0;
+    return std::max(push_ ? poll_fallback_interval_ : poll_interval_, 1) * 1000;
+}
+
 WhatsAppChannel::Mode WhatsAppChannel::mode() const { return mode_; }
 
 std::string WhatsAppChannel::normalize_phone(const std::string& phone) {
@@ -274,50 +342,129 @@ SendResult WhatsAppChannel::send_bridge(const std::string& to, const std::string
 }
 
 void WhatsAppChannel::poll_bridge() {
-    time_t now = time(NULL);
-    if (now - last_poll_time_ < poll_interval_) return;
-    last_poll_time_ = now;
+    // Called every poll_interval_ms(). While the bridge pushes, polling
+    // only picks up what a lost push left behind (the debouncer drops
+    // anything seen twice).
+    if (push_ && current_timestamp_ms() - last_push_time_.load() < poll_interval_ms()) return;
     
-    HttpResponse resp = http_.get(api_base_ + "/messages");
+    {
+        std::lock_guard<std::mutex> lock(poll_mutex_);
+        if (poll_in_flight_) return;
+        poll_in_flight_ = true;
+    }
+    http_.get_async(api_base_ + "/messages", std::map<std::string, std::string>(),
+                    [this](const HttpResponse& resp) {
+        on_bridge_messages(resp);
+        {
+            std::lock_guard<std::mutex> lock(poll_mutex_);
+            poll_in_flight_ = false;
+        }
+        poll_cv_.notify_all();
+    });
+}
+
+void WhatsAppChannel::on_bridge_messages(const HttpResponse& resp) {
     if (!resp.ok()) {
         LOG_WARN("WhatsApp: poll failed - %s", resp.error.c_str());
         return;
     }
     
-    Json result = resp.json();
-    if (result.contains("messages") && result["messages"].is_array()) {
-        for (const auto& msg : result["messages"]) {
-            process_bridge_message(msg);
-        }
+    std::vector<Message> messages;
+    read_bridge_messages(resp.body, false, messages);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        process_bridge_message(messages[i]);
     }
 }
 
-void WhatsAppChannel::process_bridge_message(const Json& msg) {
-    Message m;
-    m.channel = "whatsapp";
-    m.id = msg.value("id", std::string(""));
-    m.from = msg.value("from", std::string(""));
-    m.from_name = msg.value("from_name", m.from);
-    m.to = msg.value("to", std::string(""));
-    m.text = msg.value("text", std::string(""));
-    m.timestamp = msg.value("timestamp", int64_t(0));
-    
-    if (msg.value("is_group", false)) {
-        m.chat_type = "group";
-    } else {
-        m.chat_type = "direct";
-    }
+bool WhatsAppChannel::read_bridge_messages(const std::string& body, bool single,
+                                           std::vector<Message>& out) {
+    // Decoded straight into messages, handed out once the body parsed
+    std::vector<Message> messages;
+    BridgeFields fields;
+    bool has_list = false;
+    bool is_object = false;
+    JsonReader reader;
+    reader.on_begin("messages", [&has_list] { has_list = true; });
+    reader.on_begin("messages.*", [&fields] { fields.reset(); });
+    bind_bridge_message(reader, "messages.*.", fields);
+    reader.on_end("messages.*", [&fields, &messages] { messages.push_back(fields.to_message()); });
     
-    if (msg.contains("reply_to")) {
-        m.reply_to_id = msg.value("reply_to", std::string(""));
+    BridgeFields root;
+    if (single) {
+        reader.on_begin("", [&is_object] { is_object = true; });
+        bind_bridge_message(reader, "", root);
     }
     
+    if (!reader.parse(body)) return false;
+    if (single && !has_list && is_object) {
+        messages.push_back(root.to_message());
+    }
+    out.swap(messages);
+    return true;
+}
+
+void WhatsAppChannel::process_bridge_message(const Message& m) {
     LOG_DEBUG("WhatsApp: received message from %s: %s", 
               m.from_name.c_str(), m.text.c_str());
     
     emit_message(m);
 }
 
+bool WhatsAppChannel::start_push() {
+    WebhookRouter::instance().add("whatsapp",
+        [this](const WebhookRequest& request) { return on_webhook(request); });
+    
+    if (WebhookRouter::instance().mounted()) {
+        LOG_INFO("WhatsApp: receiving bridge pushes through the gateway on %swhatsapp",
+                 WebhookRouter::path_prefix());
+    } else if (!webhook_server_.start(webhook_bind_, webhook_port_)) {
+        WebhookRouter::instance().remove("whatsapp");
+        return false;
+    }
+    
+    // Without a URL the bridge is expected to be configured to push to us
+    if (!webhook_url_.empty()) {
+        Json params = Json::object();
+        params["url"] = webhook_url_;
+        if (!webhook_secret_.empty()) params["secret"] = webhook_secret_;
+        HttpResponse resp = http_.post_json(api_base_ + "/webhook", params);
+        if (!resp.ok()) {
+            LOG_WARN("WhatsApp Bridge: webhook registration failed (%s), falling back to polling",
+                     resp.error.empty() ? std::to_string(resp.status_code).c_str() : resp.error.c_str());
+        } else {
+            LOG_INFO("WhatsApp Bridge: pushing messages to %s", webhook_url_.c_str());
+        }
+    }
+    return true;
+}
+
+void WhatsAppChannel::stop_push() {
+    WebhookRouter::instance().remove("whatsapp");
+    webhook_server_.stop();
+}
+
+WebhookResponse WhatsAppChannel::on_webhook(const WebhookRequest& request) {
+    if (!webhook_secret_.empty() && request.header("x-webhook-secret") != webhook_secret_) {
+        LOG_WARN("WhatsApp: rejected bridge push with a bad secret");
+        return WebhookResponse(401, "Unauthorized");
+    }
+    if (status_ != ChannelStatus::RUNNING) {
+        return WebhookResponse(503, "Not running");
+    }
+    
+    // One message, or {"messages": [...]} like GET /messages
+    std::vector<Message> messages;
+    if (!read_bridge_messages(request.body, true, messages)) {
+        return WebhookResponse(400, "Invalid JSON");
+    }
+    last_push_time_ = current_timestamp_ms();
+    
+    for (size_t i = 0; i < messages.size(); ++i) {
+        process_bridge_message(messages[i]);
+    }
+    return WebhookResponse(200);
+}
+
 } // namespace openclaw
 
 // Export plugin for dynamic loading
@@ -64,16 +64,17 @@ Skill SkillLoader::load_skill(const std::string& skill_dir, const std::string& s
         return skill;
     }
     
-    std::string content = read_file(skill_file);
-    if (content.empty()) {
+    std::string header;
+    size_t body_offset = 0;
+    if (!read_header(skill_file, header, body_offset)) {
         LOG_WARN("[SkillLoader] SKILL.md is empty or unreadable: %s", skill_file.c_str());
         return skill;
     }
     
-    LOG_DEBUG("[SkillLoader] Read %zu bytes from %s", content.size(), skill_file.c_str());
+    LOG_DEBUG("[SkillLoader] Read %zu header bytes from %s", header.size(), skill_file.c_str());
     
     // Parse frontmatter to get name and description
-    SkillFrontmatter fm = parse_frontmatter(content);
+    SkillFrontmatter fm = parse_frontmatter(header);
     LOG_DEBUG("[SkillLoader] Parsed frontmatter with %zu keys", fm.size());
     
     // Get skill name from frontmatter or directory name
@@ -90,7 +91,8 @@ Skill SkillLoader::load_skill(const std::string& skill_dir, const std::string& s
     skill.file_path = skill_file;
     skill.base_dir = skill_dir;
     skill.source = source;
-    skill.content = content;
+    skill.header = header;
+    skill.body_offset = body_offset;
     
     LOG_DEBUG("[SkillLoader] Loaded skill: name='%s', description='%s', path='%s'",
               skill.name.c_str(), skill.description.c_str(), skill.file_path.c_str());
@@ -225,15 +227,11 @@ SkillEntry SkillLoader::build_entry(const Skill& skill) {
     
     LOG_DEBUG("[SkillLoader] Building entry for skill: %s", skill.name.c_str());
     
-    if (!skill.content.empty()) {
-        LOG_DEBUG("[SkillLoader] Processing skill content for: %s", skill.name.c_str());
-        entry.frontmatter = parse_frontmatter(skill.content);
-        entry.metadata = resolve_metadata(entry.frontmatter);
-        entry.invocation = resolve_invocation_policy(entry.frontmatter);
-        LOG_DEBUG("[SkillLoader] Built complete entry for skill: %s", skill.name.c_str());
-    } else {
-        LOG_WARN("[SkillLoader] Skill content is empty for: %s", skill.name.c_str());
-    }
+    // No header just means no frontmatter: defaults for everything
+    entry.frontmatter = parse_frontmatter(skill.header);
+    entry.metadata = resolve_metadata(entry.frontmatter);
+    entry.invocation = resolve_invocation_policy(entry.frontmatter);
+    LOG_DEBUG("[SkillLoader] Built complete entry for skill: %s", skill.name.c_str());
     
     return entry;
 }
@@ -480,20 +478,55 @@ bool SkillLoader::parse_install_spec(const std::string& json_str, SkillInstallSp
     return !spec.kind.empty();
 }
 
-std::string SkillLoader::read_file(const std::string& path) {
-    LOG_DEBUG("[SkillLoader] Reading file: %s", path.c_str());
-    std::ifstream file(path.c_str());
+bool SkillLoader::read_header(const std::string& path, std::string& header, size_t& body_offset) {
+    LOG_DEBUG("[SkillLoader] Reading header of: %s", path.c_str());
+    header.clear();
+    body_offset = 0;
+    std::ifstream file(path.c_str(), std::ios::binary);
     if (!file.is_open()) {
         LOG_ERROR("[SkillLoader] Failed to open file: %s", path.c_str());
         set_error("Failed to open file: " + path);
-        return "";
+        return false;
     }
     
+    // Grow the prefix until the closing "---" line is in it
+    std::string prefix;
+    char buf[4096];
+    size_t scanned = 3;
+    while (prefix.size() < MAX_HEADER_BYTES) {
+        file.read(buf, sizeof(buf));
+        std::streamsize n = file.gcount();
+        if (n <= 0) break;
+        prefix.append(buf, static_cast<size_t>(n));
+        if (prefix.size() < 3) continue;
+        if (prefix.compare(0, 3, "---") != 0) return true;     // No frontmatter
+        
+        size_t end_pos = prefix.find("\n---", scanned);
+        if (end_pos != std::string::npos) {
+            size_t body_start = prefix.find('\n', end_pos + 4);
+            if (body_start == std::string::npos && n == static_cast<std::streamsize>(sizeof(buf))) {
+                continue;   // Closing line runs past this block
+            }
+            body_offset = body_start == std::string::npos ? prefix.size() : body_start + 1;
+            header = prefix.substr(0, body_offset);
+            return true;
+        }
+        scanned = prefix.size() > 4 ? prefix.size() - 4 : 3;
+    }
+    // Unterminated (or oversized) frontmatter parses as none, as before
+    return !prefix.empty();
+}
+
+std::string SkillLoader::read_body(const Skill& skill) {
+    std::ifstream file(skill.file_path.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        set_error("Failed to open file: " + skill.file_path);
+        return "";
+    }
+    file.seekg(static_cast<std::streamoff>(skill.body_offset));
     std::stringstream buffer;
     buffer << file.rdbuf();
-    std::string content = buffer.str();
-    LOG_DEBUG("[SkillLoader] Successfully read %zu bytes from: %s", content.size(), path.c_str());
-    return content;
+    return buffer.str();
 }
 
 bool SkillLoader::dir_exists(const std::string& path) {
@@ -8,6 +8,8 @@
 #include <sstream>
 #include <algorithm>
 #include <cstdlib>
+#include <unordered_map>
+#include <dirent.h>
 #include <sys/stat.h>
 
 #ifdef _WIN32
@@ -23,6 +25,149 @@ namespace openclaw {
 static const int SKILL_COMMAND_MAX_LENGTH = 32;
 static const int SKILL_COMMAND_DESCRIPTION_MAX_LENGTH = 100;
 
+namespace {
+
+#ifdef _WIN32
+const char PATH_DELIM = ';';
+const char* const EXE_SUFFIX = ".exe";
+#else
+const char PATH_DELIM = ':';
+const char* const EXE_SUFFIX = "";
+#endif
+
+// File names in each $PATH directory, so a binary lookup is a hash probe
+// plus one stat for a name that is actually there
+struct PathIndex {
+    std::string path_env;                   // $PATH the index was built for
+    std::vector<std::string> dirs;
+    std::vector<int64_t> dir_mtimes;        // -1 for a missing directory
+    std::unordered_map<std::string, std::vector<size_t> > dirs_of;  // Name -> dirs, PATH order
+    std::unordered_map<std::string, bool> found;    // has_binary answers since the last change
+    bool built;
+    std::mutex mutex;
+    
+    PathIndex() : built(false) {}
+};
+
+PathIndex& path_index() {
+    static PathIndex index;
+    return index;
+}
+
+int64_t dir_mtime(const std::string& dir) {
+    struct stat st;
+    if (stat(dir.c_str(), &st) != 0) return -1;
+#if defined(__APPLE__)
+    return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    return static_cast<int64_t>(st.st_mtime) * 1000000000;
+#else
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+void rebuild_path_index(PathIndex& index, const std::string& path_env) {
+    index.path_env = path_env;
+    index.dirs.clear();
+    index.dir_mtimes.clear();
+    index.dirs_of.clear();
+    index.found.clear();
+    index.built = true;
+    
+    std::istringstream iss(path_env);
+    std::string dir;
+    while (std::getline(iss, dir, PATH_DELIM)) {
+        size_t d = index.dirs.size();
+        index.dirs.push_back(dir);
+        index.dir_mtimes.push_back(dir_mtime(dir));
+        
+        DIR* handle = opendir(dir.c_str());
+        if (!handle) continue;
+        struct dirent* entry;
+        while ((entry = readdir(handle)) != NULL) {
+            if (entry->d_name[0] == '.') continue;
+            std::vector<size_t>& dirs = index.dirs_of[entry->d_name];
+            if (dirs.empty() || dirs.back() != d) dirs.push_back(d);
+        }
+        closedir(handle);
+    }
+}
+
+// Splits "/name args" or "/skill name args" into the lowercased name and the
+// trimmed arguments; false if the input is not a slash command
+bool parse_skill_invocation(const std::string& user_input,
+                            std::string& normalized_cmd,
+                            std::string& args) {
+    // Trim input
+    std::string input = user_input;
+    size_t start = input.find_first_not_of(" \t\n\r");
+    if (start == std::string::npos) {
+        return false;
+    }
+    input = input.substr(start);
+    
+    // Must start with /
+    if (input.empty() || input[0] != '/') {
+        return false;
+    }
+    
+    // Remove leading /
+    input = input.substr(1);
+    
+    // Check for /skill prefix (e.g., "/skill coding-agent args")
+    if (input.size() >= 5) {
+        std::string prefix = input.substr(0, 5);
+        for (size_t i = 0; i < prefix.size(); ++i) {
+            prefix[i] = tolower(prefix[i]);
+        }
+        if (prefix == "skill" && (input.size() == 5 || input[5] == ' ' || input[5] == '\t')) {
+            input = input.substr(5);
+            // Trim leading whitespace
+            start = input.find_first_not_of(" \t");
+            if (start != std::string::npos) {
+                input = input.substr(start);
+            } else {
+                input.clear();
+            }
+        }
+    }
+    
+    if (input.empty()) {
+        return false;
+    }
+    
+    // Split into command name and arguments
+    std::string cmd_name;
+    args.clear();
+    size_t space_pos = input.find_first_of(" \t");
+    if (space_pos != std::string::npos) {
+        cmd_name = input.substr(0, space_pos);
+        args = input.substr(space_pos + 1);
+        // Trim args
+        start = args.find_first_not_of(" \t");
+        if (start != std::string::npos) {
+            args = args.substr(start);
+            size_t end = args.find_last_not_of(" \t\n\r");
+            if (end != std::string::npos) {
+                args = args.substr(0, end + 1);
+            }
+        } else {
+            args.clear();
+        }
+    } else {
+        cmd_name = input;
+    }
+    
+    // Normalize command name for comparison
+    normalized_cmd = cmd_name;
+    for (size_t i = 0; i < normalized_cmd.size(); ++i) {
+        normalized_cmd[i] = tolower(normalized_cmd[i]);
+    }
+    return true;
+}
+
+}
+
 SkillManager::SkillManager() {}
 
 SkillManager::SkillManager(const SkillsConfig& config) : config_(config) {}
@@ -30,88 +175,117 @@ SkillManager::SkillManager(const SkillsConfig& config) : config_(config) {}
 SkillManager::~SkillManager() {}
 
 void SkillManager::set_config(const SkillsConfig& config) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
     config_ = config;
+    dir_cache_.clear();
+    skill_cache_.clear();
 }
 
 std::vector<SkillEntry> SkillManager::load_workspace_skill_entries() {
-    LOG_INFO("[SkillManager] Loading workspace skill entries...");
     LOG_DEBUG("[SkillManager] Loading workspace skill entries");
-    std::map<std::string, SkillEntry> merged;
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    std::map<std::string, const SkillEntry*> merged;
     
     // Precedence: extra < bundled < managed < workspace
     
     // 1. Load from extra directories
     LOG_DEBUG("[SkillManager] Loading from %zu extra directories", config_.extra_dirs.size());
     for (size_t i = 0; i < config_.extra_dirs.size(); ++i) {
-        std::vector<SkillEntry> entries = load_entries_from_dir(
-            config_.extra_dirs[i], "openclaw-extra");
-        for (size_t j = 0; j < entries.size(); ++j) {
-            merged[entries[j].skill.name] = entries[j];
-        }
+        load_entries_from_dir(config_.extra_dirs[i], "openclaw-extra", merged);
     }
     
     // 2. Load bundled skills
     if (!config_.bundled_skills_dir.empty()) {
         LOG_DEBUG("[SkillManager] Loading bundled skills from: %s", config_.bundled_skills_dir.c_str());
-        std::vector<SkillEntry> entries = load_entries_from_dir(
-            config_.bundled_skills_dir, "openclaw-bundled");
-        LOG_DEBUG("[SkillManager] Loaded %zu bundled skills", entries.size());
-        for (size_t j = 0; j < entries.size(); ++j) {
-            merged[entries[j].skill.name] = entries[j];
-        }
+        load_entries_from_dir(config_.bundled_skills_dir, "openclaw-bundled", merged);
     }
     
     // 3. Load managed skills
     if (!config_.managed_skills_dir.empty()) {
         LOG_DEBUG("[SkillManager] Loading managed skills from: %s", config_.managed_skills_dir.c_str());
-        std::vector<SkillEntry> entries = load_entries_from_dir(
-            config_.managed_skills_dir, "openclaw-managed");
-        LOG_DEBUG("[SkillManager] Loaded %zu managed skills", entries.size());
-        for (size_t j = 0; j < entries.size(); ++j) {
-            merged[entries[j].skill.name] = entries[j];
-        }
+        load_entries_from_dir(config_.managed_skills_dir, "openclaw-managed", merged);
     }
     
     // 4. Load workspace skills (highest priority)
     if (!config_.workspace_dir.empty()) {
         std::string workspace_skills_dir = config_.workspace_dir + "/skills";
         LOG_DEBUG("[SkillManager] Loading workspace skills from: %s", workspace_skills_dir.c_str());
-        std::vector<SkillEntry> entries = load_entries_from_dir(
-            workspace_skills_dir, "openclaw-workspace");
-        LOG_DEBUG("[SkillManager] Loaded %zu workspace skills", entries.size());
-        for (size_t j = 0; j < entries.size(); ++j) {
-            merged[entries[j].skill.name] = entries[j];
-        }
+        load_entries_from_dir(workspace_skills_dir, "openclaw-workspace", merged);
     }
     
-    // Convert map to vector
+    // Convert map to vector (the only copy of each entry)
     std::vector<SkillEntry> result;
-    for (std::map<std::string, SkillEntry>::iterator it = merged.begin();
+    result.reserve(merged.size());
+    for (std::map<std::string, const SkillEntry*>::iterator it = merged.begin();
          it != merged.end(); ++it) {
-        result.push_back(it->second);
+        result.push_back(*it->second);
     }
     
     LOG_DEBUG("[SkillManager] Total skills after merge: %zu", result.size());
     return result;
 }
 
-std::vector<SkillEntry> SkillManager::load_entries_from_dir(
+SkillManager::FileStamp SkillManager::stamp_of(const std::string& path) {
+    FileStamp stamp;
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return stamp;
+    // Nanoseconds where available: a skill added in the same second as the
+    // last listing must still change the directory's stamp
+#if defined(__APPLE__)
+    stamp.mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    stamp.mtime = static_cast<int64_t>(st.st_mtime) * 1000000000;
+#else
+    stamp.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    stamp.size = static_cast<int64_t>(st.st_size);
+    stamp.inode = static_cast<uint64_t>(st.st_ino);
+    stamp.exists = true;
+    return stamp;
+}
+
+void SkillManager::load_entries_from_dir(
     const std::string& dir,
-    const std::string& source) {
-    
-    LOG_INFO("[SkillManager] load_entries_from_dir called: dir='%s', source='%s'", dir.c_str(), source.c_str());
-    std::vector<SkillEntry> entries;
-    std::vector<Skill> skills = loader_.load_from_dir(dir, source);
-    LOG_INFO("[SkillManager] load_from_dir returned %zu skills", skills.size());
+    const std::string& source,
+    std::map<std::string, const SkillEntry*>& merged) {
+    
+    // A directory's mtime changes when skills are added, removed or renamed
+    FileStamp dir_stamp = stamp_of(dir);
+    CachedDir& cached_dir = dir_cache_[dir];
+    if (!(cached_dir.stamp == dir_stamp)) {
+        std::vector<std::string> subdirs = dir_stamp.exists ? loader_.list_subdirs(dir) : std::vector<std::string>();
+        std::set<std::string> kept(subdirs.begin(), subdirs.end());
+        for (size_t i = 0; i < cached_dir.subdirs.size(); ++i) {
+            if (!kept.count(cached_dir.subdirs[i])) skill_cache_.erase(dir + "/" + cached_dir.subdirs[i]);
+        }
+        cached_dir.stamp = dir_stamp;
+        cached_dir.subdirs.swap(subdirs);
+        LOG_DEBUG("[SkillManager] Listed %zu skill directories in %s", cached_dir.subdirs.size(), dir.c_str());
+    }
     
-    for (size_t i = 0; i < skills.size(); ++i) {
-        SkillEntry entry = loader_.build_entry(skills[i]);
-        if (!entry.empty()) {
-            entries.push_back(entry);
+    size_t reparsed = 0;
+    for (size_t i = 0; i < cached_dir.subdirs.size(); ++i) {
+        std::string skill_dir = dir + "/" + cached_dir.subdirs[i];
+        FileStamp stamp = stamp_of(skill_dir + "/SKILL.md");
+        CachedSkill& cached = skill_cache_[skill_dir];
+        if (!(cached.stamp == stamp) || cached.source != source) {
+            cached.stamp = stamp;
+            cached.source = source;
+            cached.entry = SkillEntry();
+            if (stamp.exists) {
+                Skill skill = loader_.load_skill(skill_dir, source);
+                if (!skill.empty()) cached.entry = loader_.build_entry(skill);
+            }
+            ++reparsed;
+        }
+        if (!cached.entry.empty()) {
+            merged[cached.entry.skill.name] = &cached.entry;
         }
     }
     
-    return entries;
+    if (reparsed > 0) {
+        LOG_DEBUG("[SkillManager] Parsed %zu changed skills in %s", reparsed, dir.c_str());
+    }
 }
 
 std::vector<SkillEntry> SkillManager::filter_skill_entries(
@@ -121,6 +295,9 @@ std::vector<SkillEntry> SkillManager::filter_skill_entries(
     LOG_DEBUG("[SkillManager] Filtering %zu skill entries", entries.size());
     std::vector<SkillEntry> filtered;
     
+    // Binaries installed or removed since the last pass
+    refresh_binary_index();
+    
     for (size_t i = 0; i < entries.size(); ++i) {
         if (should_include_skill(entries[i], eligibility)) {
             LOG_DEBUG("[SkillManager] Including skill: %s", entries[i].skill.name.c_str());
@@ -614,27 +791,47 @@ bool SkillManager::has_binary(const std::string& bin) {
         return false;
     }
     
-    std::string path_str = path_env;
+    PathIndex& index = path_index();
+    std::lock_guard<std::mutex> lock(index.mutex);
+    if (!index.built || index.path_env != path_env) {
+        rebuild_path_index(index, path_env);
+    }
     
-#ifdef _WIN32
-    char delim = ';';
-    std::string exe_suffix = ".exe";
-#else
-    char delim = ':';
-    std::string exe_suffix = "";
-#endif
+    std::unordered_map<std::string, bool>::iterator memo = index.found.find(bin);
+    if (memo != index.found.end()) {
+        return memo->second;
+    }
     
-    std::istringstream iss(path_str);
-    std::string dir;
-    while (std::getline(iss, dir, delim)) {
-        std::string full_path = dir + PATH_SEP + bin + exe_suffix;
-        struct stat st;
-        if (stat(full_path.c_str(), &st) == 0 && (st.st_mode & S_IXUSR)) {
-            return true;
+    // Only directories that have the name are checked for the execute bit
+    bool found = false;
+    std::string name = bin + EXE_SUFFIX;
+    std::unordered_map<std::string, std::vector<size_t> >::const_iterator it = index.dirs_of.find(name);
+    if (it != index.dirs_of.end()) {
+        for (size_t i = 0; i < it->second.size() && !found; ++i) {
+            std::string full_path = index.dirs[it->second[i]] + PATH_SEP + name;
+            struct stat st;
+            found = stat(full_path.c_str(), &st) == 0 && (st.st_mode & S_IXUSR);
         }
     }
+    index.found[bin] = found;
+    return found;
+}
+
+void SkillManager::refresh_binary_index() {
+    const char* path_env = getenv("PATH");
+    if (!path_env) {
+        return;
+    }
     
-    return false;
+    PathIndex& index = path_index();
+    std::lock_guard<std::mutex> lock(index.mutex);
+    bool stale = !index.built || index.path_env != path_env;
+    for (size_t i = 0; i < index.dirs.size() && !stale; ++i) {
+        stale = dir_mtime(index.dirs[i]) != index.dir_mtimes[i];
+    }
+    if (stale) {
+        rebuild_path_index(index, path_env);
+    }
 }
 
 bool SkillManager::has_env(const std::string& var) {
@@ -668,70 +865,10 @@ std::pair<const SkillCommandSpec*, std::string> SkillManager::resolve_skill_comm
 
     LOG_DEBUG("[SkillManager] Resolving skill command invocation for input: %s", user_input.c_str());
     
-    // Trim input
-    std::string input = user_input;
-    size_t start = input.find_first_not_of(" \t\n\r");
-    if (start == std::string::npos) {
-        return result;
-    }
-    input = input.substr(start);
-    
-    // Must start with /
-    if (input.empty() || input[0] != '/') {
-        return result;
-    }
-    
-    // Remove leading /
-    input = input.substr(1);
-    
-    // Check for /skill prefix (e.g., "/skill coding-agent args")
-    if (input.size() >= 5) {
-        std::string prefix = input.substr(0, 5);
-        for (size_t i = 0; i < prefix.size(); ++i) {
-            prefix[i] = tolower(prefix[i]);
-        }
-        if (prefix == "skill" && (input.size() == 5 || input[5] == ' ' || input[5] == '\t')) {
-            input = input.substr(5);
-            // Trim leading whitespace
-            start = input.find_first_not_of(" \t");
-            if (start != std::string::npos) {
-                input = input.substr(start);
-            } else {
-                input.clear();
-            }
-        }
-    }
-    
-    if (input.empty()) {
-        return result;
-    }
-    
-    // Split into command name and arguments
-    std::string cmd_name;
+    std::string normalized_cmd;
     std::string args;
-    size_t space_pos = input.find_first_of(" \t");
-    if (space_pos != std::string::npos) {
-        cmd_name = input.substr(0, space_pos);
-        args = input.substr(space_pos + 1);
-        // Trim args
-        start = args.find_first_not_of(" \t");
-        if (start != std::string::npos) {
-            args = args.substr(start);
-            size_t end = args.find_last_not_of(" \t\n\r");
-            if (end != std::string::npos) {
-                args = args.substr(0, end + 1);
-            }
-        } else {
-            args.clear();
-        }
-    } else {
-        cmd_name = input;
-    }
-    
-    // Normalize command name for comparison
-    std::string normalized_cmd = cmd_name;
-    for (size_t i = 0; i < normalized_cmd.size(); ++i) {
-        normalized_cmd[i] = tolower(normalized_cmd[i]);
+    if (!parse_skill_invocation(user_input, normalized_cmd, args)) {
+        return result;
     }
     
     // Find matching command
@@ -765,6 +902,58 @@ std::pair<const SkillCommandSpec*, std::string> SkillManager::resolve_skill_comm
     return result;
 }
 
+std::pair<const SkillCommandSpec*, std::string> SkillManager::resolve_skill_command_invocation(
+    const std::string& user_input,
+    const SkillCommandTable& commands) {
+    
+    std::pair<const SkillCommandSpec*, std::string> result(NULL, "");
+    
+    if (commands.empty()) {
+        return result;
+    }
+    
+    std::string normalized_cmd;
+    std::string args;
+    if (!parse_skill_invocation(user_input, normalized_cmd, args)) {
+        return result;
+    }
+    
+    result.first = commands.find(normalized_cmd);
+    if (result.first) {
+        result.second = args;
+    }
+    return result;
+}
+
+SkillCommandTable::SkillCommandTable(const std::vector<SkillCommandSpec>& specs)
+    : specs_(specs) {
+    
+    index_.reserve(specs_.size() * 2);
+    
+    // Command names first, then skill names as aliases, so the same input
+    // resolves as it would scanning names before skill names; the first
+    // spec to claim a name keeps it
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        std::string name = specs_[i].name;
+        for (size_t j = 0; j < name.size(); ++j) {
+            name[j] = tolower(name[j]);
+        }
+        index_.insert(std::make_pair(name, i));
+    }
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        std::string alias = specs_[i].skill_name;
+        for (size_t j = 0; j < alias.size(); ++j) {
+            alias[j] = tolower(alias[j]);
+        }
+        index_.insert(std::make_pair(alias, i));
+    }
+}
+
+const SkillCommandSpec* SkillCommandTable::find(const std::string& lower_name) const {
+    std::unordered_map<std::string, size_t>::const_iterator it = index_.find(lower_name);
+    return it != index_.end() ? &specs_[it->second] : NULL;
+}
+
 const SkillEntry* SkillManager::find_skill_by_name(
     const std::string& name,
     const std::vector<SkillEntry>& entries) {